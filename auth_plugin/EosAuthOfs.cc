@@ -21,9 +21,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
  ************************************************************************/
 
+#include <algorithm>
 #include <cstdio>
+#include <memory>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 #include <fcntl.h>
+#include <unistd.h>
 #include <syscall.h>
 #include <sys/time.h>
 #include <zlib.h>
@@ -32,6 +37,7 @@
 #include "EosAuthOfsDirectory.hh"
 #include "EosAuthOfsFile.hh"
 #include "common/SymKeys.hh"
+#include "XrdOuc/XrdOucErrInfo.hh"
 #include "XrdOuc/XrdOucTrace.hh"
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdOss/XrdOssApi.hh"
@@ -85,13 +91,12 @@ EOSAUTHNAMESPACE_BEGIN
 // Constructor
 //------------------------------------------------------------------------------
 EosAuthOfs::EosAuthOfs():
-  XrdOfs(), eos::common::LogId(),  proxy_tid(0), mFrontend(0), mMaster(0),
-  mSizePoolSocket(5), mPort(0), mLogLevel(LOG_INFO)
+  XrdOfs(), eos::common::LogId(),  proxy_tid(0), mMaster(0),
+  mWakeUpPipe{-1, -1}, mNumSockets(1), mNextSocket(0), mPort(0),
+  mLogLevel(LOG_INFO)
 {
   // Initialise the ZMQ client
   mZmqContext = new zmq::context_t(1);
-  mBackend1 = std::make_pair(std::string(""), (zmq::socket_t*)0);
-  mBackend2 = std::make_pair(std::string(""), (zmq::socket_t*)0);
   // Set Logging parameters
   XrdOucString unit = "auth@localhost";
   // setup the circular in-memory log buffer
@@ -107,22 +112,25 @@ EosAuthOfs::EosAuthOfs():
 //------------------------------------------------------------------------------
 EosAuthOfs::~EosAuthOfs()
 {
-  zmq::socket_t* socket;
-
   // Kill the auth proxy thread
   if (proxy_tid) {
     XrdSysThread::Cancel(proxy_tid);
     XrdSysThread::Join(proxy_tid, 0);
   }
 
+  for (int i = 0; i < 2; ++i) {
+    if (mWakeUpPipe[i] >= 0) {
+      (void) close(mWakeUpPipe[i]);
+    }
+  }
+
   // Release memory
-  while (mPoolSocket.try_pop(socket)) {
-    delete socket;
+  for (auto* backend : {&mBackend1, &mBackend2}) {
+    for (auto* socket : backend->mSockets) {
+      delete socket;
+    }
   }
 
-  delete mFrontend;
-  delete mBackend1.second;
-  delete mBackend2.second;
   delete mZmqContext;
 }
 
@@ -217,7 +225,7 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
             mgm_instance = val;
 
             if (mgm_instance.find(":") != string::npos) {
-              mBackend1 = std::make_pair(mgm_instance, (zmq::socket_t*)0);
+              mBackend1.mEndpoint = mgm_instance;
             }
           } else {
             // This parameter is critical
@@ -234,19 +242,33 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
             mgm_instance = val;
 
             if (mgm_instance.find(":") != string::npos) {
-              mBackend2 = std::make_pair(mgm_instance, (zmq::socket_t*)0);
+              mBackend2.mEndpoint = mgm_instance;
             }
           }
         }
 
-        // Get number of sockets in the pool by default 10
+        // Get number of sockets connected to each MGM, by default 1
         option_tag = "numsockets";
 
         if (!strncmp(var, option_tag.c_str(), option_tag.length())) {
           if (!(val = Config.GetWord())) {
             error.Emsg("Configure ", "No number of sockets specified");
           } else {
-            mSizePoolSocket = atoi(val);
+            mNumSockets = std::max(1, atoi(val));
+            error.Say("=====> eosauth.numsockets: ",
+                      std::to_string(mNumSockets).c_str(), "");
+          }
+        }
+
+        // Get the time to live of the cached stat/exists replies, by default 0
+        option_tag = "cachettl";
+
+        if (!strncmp(var, option_tag.c_str(), option_tag.length())) {
+          if (!(val = Config.GetWord())) {
+            error.Emsg("Configure ", "No cache ttl specified");
+          } else {
+            mCache.SetTtl(std::chrono::milliseconds(atoi(val)));
+            error.Say("=====> eosauth.cachettl(ms): ", val, "");
           }
         }
 
@@ -279,40 +301,20 @@ EosAuthOfs::Configure(XrdSysError& error, XrdOucEnv* envP)
     }
 
     // Check and connect at least to an MGM master
-    if (!mBackend1.first.empty()) {
-      if ((XrdSysThread::Run(&proxy_tid, EosAuthOfs::StartAuthProxyThread,
-                             static_cast<void*>(this), 0, "Auth Proxy Thread"))) {
+    if (!mBackend1.mEndpoint.empty()) {
+      // The XRootD threads wake up the proxy thread through this pipe when
+      // there are requests to send
+      if (pipe(mWakeUpPipe) ||
+          (fcntl(mWakeUpPipe[0], F_SETFL, O_NONBLOCK) == -1) ||
+          (fcntl(mWakeUpPipe[1], F_SETFL, O_NONBLOCK) == -1)) {
+        eos_err("cannot create the wake up pipe errno=%i", errno);
+        NoGo = 1;
+      } else if ((XrdSysThread::Run(&proxy_tid, EosAuthOfs::StartAuthProxyThread,
+                                    static_cast<void*>(this), 0,
+                                    "Auth Proxy Thread"))) {
         eos_err("cannot start the authentication proxy thread");
         NoGo = 1;
       }
-
-      // Create a pool of sockets connected to the master proxy service
-      for (int i = 0; i < mSizePoolSocket; i++) {
-        // Set socket receive timeout to 5 seconds
-        zmq::socket_t* socket = new zmq::socket_t(*mZmqContext, ZMQ_REQ);
-#if ZMQ_VERSION >= 20200
-        int timeout_mili = 5000;
-        socket->setsockopt(ZMQ_RCVTIMEO, &timeout_mili, sizeof timeout_mili);
-        int socket_linger = 0;
-        socket->setsockopt(ZMQ_LINGER, &socket_linger, sizeof(socket_linger));
-#endif
-        std::string endpoint = "inproc://proxyfrontend";
-
-        // Try in a loop to connect to the proxyfrontend as it can take a while for
-        // the proxy thread to do the binding, therefore connect can fail
-        while (1) {
-          try {
-            socket->connect(endpoint.c_str());
-          } catch (zmq::error_t& err) {
-            eos_warning("dealing with connect exception, retrying ...");
-            continue;
-          }
-
-          break;
-        }
-
-        mPoolSocket.push(socket);
-      }
     } else {
       eos_err("No master MGM specified e.g. eos.master.cern.ch:15555");
       NoGo = 1;
@@ -390,52 +392,45 @@ EosAuthOfs::StartAuthProxyThread(void* pp)
 void
 EosAuthOfs::AuthProxyThread()
 {
-  // Bind the client facing socket
-  mFrontend = new zmq::socket_t(*mZmqContext, ZMQ_ROUTER);
-  mFrontend->bind("inproc://proxyfrontend");
   // Connect sockets facing the MGM nodes - master and slave
-  std::ostringstream sstr;
-  mBackend1 = std::make_pair(mBackend1.first,
-                             new zmq::socket_t(*mZmqContext, ZMQ_DEALER));
-  sstr << "tcp://" << mBackend1.first;
-  mBackend1.second->connect(sstr.str().c_str());
-  OfsEroute.Say("=====> connected to master MGM: ", mBackend1.first.c_str());
-
-  // Connect to the slave if present
-  if (!mBackend2.first.empty()) {
-    sstr.str("");
-    mBackend2 = std::make_pair(mBackend2.first,
-                               new zmq::socket_t(*mZmqContext, ZMQ_DEALER));
-    sstr << "tcp://" << mBackend2.first;
-    mBackend2.second->connect(sstr.str().c_str());
-    OfsEroute.Say("=====> connected to slave MGM: ", mBackend2.first.c_str());
+  std::vector<zmq::pollitem_t> items;
+  items.push_back({ 0, mWakeUpPipe[0], ZMQ_POLLIN, 0});
+
+  for (auto* backend : {&mBackend1, &mBackend2}) {
+    if (backend->mEndpoint.empty()) {
+      continue;
+    }
+
+    std::string endpoint = "tcp://" + backend->mEndpoint;
+
+    for (int i = 0; i < mNumSockets; ++i) {
+      zmq::socket_t* socket = new zmq::socket_t(*mZmqContext, ZMQ_DEALER);
+      socket->connect(endpoint.c_str());
+      backend->mSockets.push_back(socket);
+      items.push_back({(void*)* socket, 0, ZMQ_POLLIN, 0});
+    }
+
+    OfsEroute.Say("=====> connected to ", (backend == &mBackend1 ?
+                  "master MGM: " : "slave MGM: "), backend->mEndpoint.c_str());
   }
 
-  // Set the master to point to the master MGM - no need for lock
-  mMaster = mBackend1.second;
-  int rc = -1;
-  zmq::message_t msg;
-  // Start the proxy using the first entry
-  int more;
-  size_t moresz;
-  int poll_size = 2;
-  zmq::pollitem_t items[3] = {
-    { (void*)* mFrontend, 0, ZMQ_POLLIN, 0},
-    { (void*)* mBackend1.second, 0, ZMQ_POLLIN, 0}
-  };
-
-  if (!mBackend2.first.empty()) {
-    poll_size = 3;
-    items[2] = { (void*)* mBackend2.second, 0, ZMQ_POLLIN, 0};
+  // Set the master to point to the master MGM
+  {
+    XrdSysMutexHelper scop_lock(mMutexMaster);
+    mMaster = &mBackend1;
   }
 
-  // Main loop in which the proxy thread accepts request from the clients and
-  // then he forwards them to the current master MGM. The master MGM can change
-  // at any point.
+  int rc = -1;
+  auto last_expire = std::chrono::steady_clock::now();
+
+  // Main loop in which the proxy thread sends the requests queued by the
+  // XRootD threads to the current master MGM and hands the replies back to
+  // them. The master MGM can change at any point.
   while (true) {
-    // Wait while there are either requests or replies to process
+    // Wait while there are either requests or replies to process, wake up
+    // every second to expire the requests without reply
     try {
-      rc = zmq::poll(&items[0], poll_size, -1);
+      rc = zmq::poll(items.data(), items.size(), 1000);
     } catch (zmq::error_t& e) {
       eos_err("Exception thrown: %s", e.what());
     }
@@ -445,99 +440,151 @@ EosAuthOfs::AuthProxyThread()
       return;
     }
 
-    // Process a request
+    // Send the queued requests
     if (items[0].revents & ZMQ_POLLIN) {
-      eos_debug("got frontend event");
+      eos_debug("got request event");
 
-      while (true) {
-        if (!mFrontend->recv(&msg)) {
-          eos_err("error while recv on frontend");
-          return;
-        }
+      if (!SendQueuedRequests()) {
+        return;
+      }
+    }
 
-        try {
-          moresz = sizeof more;
-          mFrontend->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
+    // Process the replies from the MGMs
+    size_t index = 1;
 
-        // Send request to the current master MGM
-        {
-          XrdSysMutexHelper scop_lock(mMutexMaster);
+    for (auto* backend : {&mBackend1, &mBackend2}) {
+      for (auto* socket : backend->mSockets) {
+        if (items[index++].revents & ZMQ_POLLIN) {
+          eos_debug("got %s event", backend->mEndpoint.c_str());
 
-          if (!mMaster->send(msg, more ? ZMQ_SNDMORE : 0)) {
-            eos_err("error while sending to master");
+          if (!DispatchReply(socket)) {
             return;
           }
         }
-
-        if (more == 0) {
-          break;
-        }
       }
     }
 
-    // Process a reply from the first MGM
-    if (items[1].revents & ZMQ_POLLIN) {
-      eos_debug("got mBackend1 event");
+    auto now = std::chrono::steady_clock::now();
 
-      while (true) {
-        if (!mBackend1.second->recv(&msg)) {
-          eos_err("error while recv on mBackend1");
-          return;
-        }
+    if (now - last_expire >= std::chrono::seconds(1)) {
+      last_expire = now;
+      ExpireRequests();
+    }
+  }
+}
 
-        moresz = sizeof more;
 
-        try {
-          mBackend1.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
+//------------------------------------------------------------------------------
+// Send the queued requests to the master MGM
+//------------------------------------------------------------------------------
+bool
+EosAuthOfs::SendQueuedRequests()
+{
+  // Drain the wake up pipe before taking the requests so that no wake up for
+  // a request queued in the meantime gets lost
+  char buff[256];
 
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0)) {
-          eos_err("error while send to frontend(1)");
-          return;
-        }
+  while (read(mWakeUpPipe[0], buff, sizeof(buff)) > 0) {}
 
-        if (more == 0) {
-          break;
-        }
+  std::deque<std::pair<uint64_t, std::string>> requests;
+  {
+    std::lock_guard<std::mutex> lock(mMutexRequests);
+    requests.swap(mOutQueue);
+  }
+  XrdSysMutexHelper scop_lock(mMutexMaster);
+
+  // Remember where the requests go so that they can be failed if the master
+  // changes before the reply arrives
+  for (const auto& req : requests) {
+    mPending.SetBackend(req.first, mMaster);
+  }
+
+  // Each request is sent as [request id][empty delimiter][payload], the MGM
+  // returns the envelope untouched together with the reply
+  for (auto& req : requests) {
+    zmq::socket_t* socket =
+      mMaster->mSockets[mNextSocket++ % mMaster->mSockets.size()];
+    zmq::message_t id_msg(sizeof(req.first));
+    memcpy(id_msg.data(), &req.first, sizeof(req.first));
+    zmq::message_t delim_msg(0);
+    zmq::message_t payload_msg(req.second.size());
+    memcpy(payload_msg.data(), req.second.data(), req.second.size());
+
+    try {
+      if (!socket->send(id_msg, ZMQ_SNDMORE) ||
+          !socket->send(delim_msg, ZMQ_SNDMORE) ||
+          !socket->send(payload_msg, 0)) {
+        eos_err("error while sending to master req_id=%llu", req.first);
       }
+    } catch (zmq::error_t& e) {
+      eos_err("error while sending to master: %s", e.what());
+      return false;
     }
+  }
 
-    // Process a reply from the second MGM
-    if ((poll_size == 3) && (items[2].revents & ZMQ_POLLIN)) {
-      eos_debug("got mBackend2 event");
+  return true;
+}
 
-      while (true) {
-        if (!mBackend2.second->recv(&msg)) {
-          eos_err("error while recv on mBackend2");
-          return;
-        }
 
-        moresz = sizeof more;
+//------------------------------------------------------------------------------
+// Receive a reply from an MGM and hand it to the waiting request
+//------------------------------------------------------------------------------
+bool
+EosAuthOfs::DispatchReply(zmq::socket_t* socket)
+{
+  int more;
+  size_t moresz;
+  std::vector<zmq::message_t> frames;
 
-        try {
-          mBackend2.second->getsockopt(ZMQ_RCVMORE, &more, &moresz);
-        } catch (zmq::error_t& err) {
-          eos_err("exception in getsockopt");
-          return;
-        }
+  do {
+    frames.emplace_back();
 
-        if (!mFrontend->send(msg, more ? ZMQ_SNDMORE : 0)) {
-          eos_err("error while send to frontend(2)");
-          return;
-        }
+    if (!socket->recv(&frames.back())) {
+      eos_err("error while recv on backend");
+      return false;
+    }
 
-        if (more == 0) {
-          break;
-        }
-      }
+    try {
+      moresz = sizeof more;
+      socket->getsockopt(ZMQ_RCVMORE, &more, &moresz);
+    } catch (zmq::error_t& err) {
+      eos_err("exception in getsockopt");
+      return false;
     }
+  } while (more);
+
+  if ((frames.size() != 3) || (frames[0].size() != sizeof(uint64_t))) {
+    eos_err("dropping malformed reply num_frames=%lu", frames.size());
+    return true;
+  }
+
+  uint64_t req_id;
+  memcpy(&req_id, frames[0].data(), sizeof(req_id));
+  ReplyCallback callback;
+
+  if (!mPending.Take(req_id, callback)) {
+    // The request already timed out or was failed by a master switch
+    eos_warning("dropping reply for unknown req_id=%llu", req_id);
+    return true;
+  }
+
+  std::string reply(static_cast<char*>(frames[2].data()), frames[2].size());
+  callback(&reply);
+  return true;
+}
+
+
+//------------------------------------------------------------------------------
+// Fail the pending requests whose reply deadline has passed
+//------------------------------------------------------------------------------
+void
+EosAuthOfs::ExpireRequests()
+{
+  auto expired = mPending.TakeExpired(std::chrono::steady_clock::now());
+
+  for (auto& req : expired) {
+    eos_err("timeout while waiting for the reply req_id=%llu", req.first);
+    req.second(nullptr);
   }
 }
 
@@ -585,34 +632,28 @@ EosAuthOfs::stat(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_stat = ForwardRequest(req_proto,
+                                            GetCacheKey("stat", path, client, opaque));
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_stat) {
-      retc = resp_stat->response();
-
-      if (resp_stat->has_error()) {
-        error.setErrInfo(resp_stat->error().code(),
-                         resp_stat->error().message().c_str());
-      }
+  if (resp_stat) {
+    retc = resp_stat->response();
 
-      // We retrieve the struct stat if response is ok
-      if ((retc == SFS_OK) && resp_stat->has_message()) {
-        buf = static_cast<struct stat*>(memcpy((void*)buf,
-                                               resp_stat->message().c_str(),
-                                               sizeof(struct stat)));
-      }
+    if (resp_stat->has_error()) {
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
+    }
 
-      delete resp_stat;
+    // We retrieve the struct stat if response is ok
+    if ((retc == SFS_OK) && resp_stat->has_message()) {
+      buf = static_cast<struct stat*>(memcpy((void*)buf,
+                                             resp_stat->message().c_str(),
+                                             sizeof(struct stat)));
     }
+
+    delete resp_stat;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -641,32 +682,26 @@ EosAuthOfs::stat(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_stat = static_cast<ResponseProto*>(GetResponse(socket));
+  ResponseProto* resp_stat = ForwardRequest(req_proto,
+                                            GetCacheKey("statm", path, client, opaque));
 
-    if (resp_stat) {
-      retc = resp_stat->response();
+  if (resp_stat) {
+    retc = resp_stat->response();
 
-      if (resp_stat->has_error()) {
-        error.setErrInfo(resp_stat->error().code(),
-                         resp_stat->error().message().c_str());
-      }
-
-      // We retrieve the open mode if response if ok
-      if ((retc == SFS_OK) && resp_stat->has_message()) {
-        memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
-      }
+    if (resp_stat->has_error()) {
+      error.setErrInfo(resp_stat->error().code(),
+                       resp_stat->error().message().c_str());
+    }
 
-      delete resp_stat;
+    // We retrieve the open mode if response if ok
+    if ((retc == SFS_OK) && resp_stat->has_message()) {
+      memcpy((void*)&mode, resp_stat->message().c_str(), sizeof(mode_t));
     }
+
+    delete resp_stat;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -709,27 +744,22 @@ EosAuthOfs::fsctl(const int cmd,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fsctl1 = static_cast<ResponseProto*>(GetResponse(socket));
+  ResponseProto* resp_fsctl1 = ForwardRequest(req_proto);
+  // The request might modify the namespace
+  mCache.Clear();
 
-    if (resp_fsctl1) {
-      retc = resp_fsctl1->response();
-
-      if (resp_fsctl1->has_error()) {
-        error.setErrInfo(resp_fsctl1->error().code(),
-                         resp_fsctl1->error().message().c_str());
-      }
+  if (resp_fsctl1) {
+    retc = resp_fsctl1->response();
 
-      delete resp_fsctl1;
+    if (resp_fsctl1->has_error()) {
+      error.setErrInfo(resp_fsctl1->error().code(),
+                       resp_fsctl1->error().message().c_str());
     }
+
+    delete resp_fsctl1;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -755,27 +785,22 @@ EosAuthOfs::FSctl(const int cmd,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fsctl2 = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_fsctl2) {
-      retc = resp_fsctl2->response();
+  ResponseProto* resp_fsctl2 = ForwardRequest(req_proto);
+  // The request might modify the namespace
+  mCache.Clear();
 
-      if (resp_fsctl2->has_error()) {
-        error.setErrInfo(resp_fsctl2->error().code(),
-                         resp_fsctl2->error().message().c_str());
-      }
+  if (resp_fsctl2) {
+    retc = resp_fsctl2->response();
 
-      delete resp_fsctl2;
+    if (resp_fsctl2->has_error()) {
+      error.setErrInfo(resp_fsctl2->error().code(),
+                       resp_fsctl2->error().message().c_str());
     }
+
+    delete resp_fsctl2;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -803,27 +828,8 @@ EosAuthOfs::chmod(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_chmod = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_chmod) {
-      retc = resp_chmod->response();
-
-      if (resp_chmod->has_error()) {
-        error.setErrInfo(resp_chmod->error().code(),
-                         resp_chmod->error().message().c_str());
-      }
-
-      delete resp_chmod;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -852,28 +858,21 @@ EosAuthOfs::chksum(csFunc func,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_chksum = ForwardRequest(req_proto);
 
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_chksum = static_cast<ResponseProto*>(GetResponse(socket));
+  if (resp_chksum) {
+    retc = resp_chksum->response();
+    eos_debug("chksum retc=%i", retc);
 
-    if (resp_chksum) {
-      retc = resp_chksum->response();
-      eos_debug("chksum retc=%i", retc);
-
-      if (resp_chksum->has_error()) {
-        error.setErrInfo(resp_chksum->error().code(),
-                         resp_chksum->error().message().c_str());
-      }
-
-      delete resp_chksum;
+    if (resp_chksum->has_error()) {
+      error.setErrInfo(resp_chksum->error().code(),
+                       resp_chksum->error().message().c_str());
     }
+
+    delete resp_chksum;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -900,32 +899,26 @@ EosAuthOfs::exists(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_exists = static_cast<ResponseProto*>(GetResponse(socket));
+  ResponseProto* resp_exists = ForwardRequest(req_proto,
+                                              GetCacheKey("exists", path, client, opaque));
 
-    if (resp_exists) {
-      retc = resp_exists->response();
-      eos_debug("exists retc=%i", retc);
+  if (resp_exists) {
+    retc = resp_exists->response();
+    eos_debug("exists retc=%i", retc);
 
-      if (resp_exists->has_error()) {
-        error.setErrInfo(resp_exists->error().code(),
-                         resp_exists->error().message().c_str());
-      }
-
-      if (resp_exists->has_message()) {
-        exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
-      }
+    if (resp_exists->has_error()) {
+      error.setErrInfo(resp_exists->error().code(),
+                       resp_exists->error().message().c_str());
+    }
 
-      delete resp_exists;
+    if (resp_exists->has_message()) {
+      exists_flag = (XrdSfsFileExistence)atoi(resp_exists->message().c_str());
     }
+
+    delete resp_exists;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -957,28 +950,8 @@ EosAuthOfs::mkdir(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_mkdir = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_mkdir) {
-      retc = resp_mkdir->response();
-      eos_debug("mkdir retc=%i", retc);
-
-      if (resp_mkdir->has_error()) {
-        error.setErrInfo(resp_mkdir->error().code(),
-                         resp_mkdir->error().message().c_str());
-      }
-
-      delete resp_mkdir;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1004,28 +977,8 @@ EosAuthOfs::remdir(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_remdir = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_remdir) {
-      retc = resp_remdir->response();
-      eos_debug("remdir retc=%i", retc);
-
-      if (resp_remdir->has_error()) {
-        error.setErrInfo(resp_remdir->error().code(),
-                         resp_remdir->error().message().c_str());
-      }
-
-      delete resp_remdir;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1051,28 +1004,8 @@ EosAuthOfs::rem(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_rem = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_rem) {
-      retc = resp_rem->response();
-      eos_debug("rem retc=%i", retc);
-
-      if (resp_rem->has_error()) {
-        error.setErrInfo(resp_rem->error().code(),
-                         resp_rem->error().message().c_str());
-      }
-
-      delete resp_rem;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1101,28 +1034,8 @@ EosAuthOfs::rename(const char* oldName,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_rename = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_rename) {
-      retc = resp_rename->response();
-      eos_debug("rename retc=%i", retc);
-
-      if (resp_rename->has_error()) {
-        error.setErrInfo(resp_rename->error().code(),
-                         resp_rename->error().message().c_str());
-      }
-
-      delete resp_rename;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1147,28 +1060,21 @@ EosAuthOfs::prepare(XrdSfsPrep& pargs,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_prepare = static_cast<ResponseProto*>(GetResponse(socket));
+  ResponseProto* resp_prepare = ForwardRequest(req_proto);
 
-    if (resp_prepare) {
-      retc = resp_prepare->response();
-      eos_debug("prepare retc=%i", retc);
+  if (resp_prepare) {
+    retc = resp_prepare->response();
+    eos_debug("prepare retc=%i", retc);
 
-      if (resp_prepare->has_error()) {
-        error.setErrInfo(resp_prepare->error().code(),
-                         resp_prepare->error().message().c_str());
-      }
-
-      delete resp_prepare;
+    if (resp_prepare->has_error()) {
+      error.setErrInfo(resp_prepare->error().code(),
+                       resp_prepare->error().message().c_str());
     }
+
+    delete resp_prepare;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1196,28 +1102,8 @@ EosAuthOfs::truncate(const char* path,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  mPoolSocket.wait_pop(socket);
-
-  if (SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_truncate = static_cast<ResponseProto*>(GetResponse(socket));
-
-    if (resp_truncate) {
-      retc = resp_truncate->response();
-      eos_debug("truncate retc=%i", retc);
-
-      if (resp_truncate->has_error()) {
-        error.setErrInfo(resp_truncate->error().code(),
-                         resp_truncate->error().message().c_str());
-      }
-
-      delete resp_truncate;
-    }
-  }
-
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  retc = ForwardRequestAsync(req_proto, error);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -1237,123 +1123,194 @@ EosAuthOfs::getStats(char* buff, int blen)
 
 
 //------------------------------------------------------------------------------
-// Send ProtocolBuffer object using ZMQ
+// Forward ProtocolBuffer request to the master MGM and wait for the reply
 //------------------------------------------------------------------------------
-bool
-EosAuthOfs::SendProtoBufRequest(zmq::socket_t* socket,
-                                google::protobuf::Message* message)
+ResponseProto*
+EosAuthOfs::ForwardRequest(google::protobuf::Message* message,
+                           const std::string& cache_key)
 {
-  // Send the request
-  bool sent = false;
-  int msg_size = message->ByteSize();
-  zmq::message_t request(msg_size);
-  google::protobuf::io::ArrayOutputStream aos(request.data(), msg_size);
-
-  // Use google::protobuf::io::ArrayOutputStream which is way faster than
-  // StringOutputStream as it avoids copying data
-  if (!message->SerializeToZeroCopyStream(&aos)) {
-    eos_err("failed to serialize message");
-    return sent;
+  std::string reply;
+
+  if (!cache_key.empty() && mCache.Get(cache_key, reply)) {
+    eos_debug("msg=\"reply served from cache\"");
+    return ParseResponse(reply);
   }
 
-  sent = socket->send(request, ZMQ_NOBLOCK);
+  auto promise = std::make_shared<std::promise<std::string>>();
+  std::future<std::string> fut = promise->get_future();
+  const uint64_t req_id = QueueRequest(message,
+  [promise](const std::string * reply) {
+    if (reply) {
+      promise->set_value(*reply);
+    } else {
+      promise->set_exception(std::make_exception_ptr(
+                               std::runtime_error("no reply from the MGM")));
+    }
+  });
+
+  if (req_id == 0) {
+    return nullptr;
+  }
 
-  if (!sent) {
-    eos_err("unable to send request using zmq");
+  if (fut.wait_for(sReplyTimeout) != std::future_status::ready) {
+    eos_err("timeout while waiting for the reply req_id=%llu", req_id);
+    mPending.Remove(req_id);
+    return nullptr;
   }
 
-  return sent;
+  try {
+    reply = fut.get();
+  } catch (const std::exception& e) {
+    eos_err("msg=\"%s\" req_id=%llu", e.what(), req_id);
+    return nullptr;
+  }
+
+  ResponseProto* resp = ParseResponse(reply);
+
+  if (!cache_key.empty() && (resp->response() == SFS_OK)) {
+    mCache.Put(cache_key, reply);
+  }
+
+  return resp;
 }
 
 
 //------------------------------------------------------------------------------
-// Get ProtocolBuffer response object using ZMQ
+// Forward ProtocolBuffer request which only returns a status to the master
+// MGM without blocking the calling thread
 //------------------------------------------------------------------------------
-google::protobuf::Message*
-EosAuthOfs::GetResponse(zmq::socket_t*& socket)
+int
+EosAuthOfs::ForwardRequestAsync(google::protobuf::Message* message,
+                                XrdOucErrInfo& error)
 {
-  // It makes no sense to wait more than 1 min since the XRootD client will
-  // timeout by default after 60 seconds.
-  int num_retries = 12; // 1 min = 12 * 5 sec
-  bool done = false;
-  bool reset_socket = false;
-  zmq::message_t reply;
-  ResponseProto* resp = static_cast<ResponseProto*>(0);
+  unsigned long long cb_arg = 0;
+  XrdOucEICB* cb = error.getErrCB(cb_arg);
 
-  try {
-    do {
-      done = socket->recv(&reply);
-      --num_retries;
+  if (!cb) {
+    // The client can not be called back, wait for the reply
+    int retc = SFS_ERROR;
+    ResponseProto* resp = ForwardRequest(message);
+    // The request might modify the namespace
+    mCache.Clear();
+
+    if (resp) {
+      retc = resp->response();
 
-      if (!done) {
-        eos_err("ptr_socket=%p, num_retries=%i failed receive", socket,
-                num_retries);
+      if (resp->has_error()) {
+        error.setErrInfo(resp->error().code(), resp->error().message().c_str());
       }
-    } while (!done && (num_retries > 0));
-  } catch (zmq::error_t& e) {
-    eos_err("socket error: %s", e.what());
-    reset_socket = true;
+
+      delete resp;
+    }
+
+    return retc;
   }
 
-  // We time out while waiting for a response or a fatal error occurent -
-  // then we throw away the socket and create a new one
-  if ((num_retries <= 0) || reset_socket) {
-    eos_err("discard current socket and create a new one");
-    delete socket;
-    socket = new zmq::socket_t(*mZmqContext, ZMQ_REQ);
-#if ZMQ_VERSION >= 20200
-    int timeout_mili = 5000;
-    socket->setsockopt(ZMQ_RCVTIMEO, &timeout_mili, sizeof timeout_mili);
-    int socket_linger = 0;
-    socket->setsockopt(ZMQ_LINGER, &socket_linger, sizeof(socket_linger));
-#endif
-    std::string endpoint = "inproc://proxyfrontend";
-
-    // Try in a loop to connect to the proxyfrontend as it can take a while for
-    // the proxy thread to do the binding, therefore connect can fail
-    while (1) {
-      try {
-        socket->connect(endpoint.c_str());
-      } catch (zmq::error_t& err) {
-        eos_warning("dealing with connect exception, retrying ...");
-        continue;
+  const char* user = error.getErrUser();
+  const uint64_t req_id = QueueRequest(message,
+  [this, cb, cb_arg, user](const std::string * reply) {
+    // The request might modify the namespace
+    mCache.Clear();
+    int retc = SFS_ERROR;
+    // The error object is deleted by XRootD once the client got the reply
+    XrdOucErrInfo* eInfo = new XrdOucErrInfo(user, (XrdOucEICB*)0, cb_arg);
+
+    if (reply) {
+      std::unique_ptr<ResponseProto> resp(ParseResponse(*reply));
+      retc = resp->response();
+
+      if (resp->has_error()) {
+        eInfo->setErrInfo(resp->error().code(),
+                          resp->error().message().c_str());
       }
+    } else {
+      eInfo->setErrInfo(ETIMEDOUT, "no reply from the MGM");
+    }
+
+    eos_debug("msg=\"reply through callback\" retc=%i", retc);
+    cb->Done(retc, eInfo);
+  });
+
+  if (req_id == 0) {
+    return SFS_ERROR;
+  }
 
-      break;
+  // Tell the client how long to wait for the callback
+  error.setErrInfo(sReplyTimeout.count(), "waiting for the MGM reply");
+  return SFS_STARTED;
+}
+
+
+//------------------------------------------------------------------------------
+// Queue request to be sent by the proxy thread
+//------------------------------------------------------------------------------
+uint64_t
+EosAuthOfs::QueueRequest(google::protobuf::Message* message,
+                         ReplyCallback&& callback)
+{
+  std::string request;
+
+  if (!message->SerializeToString(&request)) {
+    eos_err("failed to serialize message");
+    return 0;
+  }
+
+  const uint64_t req_id = ++mReqId;
+  bool wake_up = false;
+  // Registered before queueing so that the reply always finds the request
+  mPending.Add(req_id, std::move(callback),
+               std::chrono::steady_clock::now() + sReplyTimeout);
+  {
+    std::lock_guard<std::mutex> lock(mMutexRequests);
+    mOutQueue.emplace_back(req_id, std::move(request));
+    // The proxy thread was already woken up if there were queued requests
+    wake_up = (mOutQueue.size() == 1);
+  }
+
+  if (wake_up) {
+    char c = 0;
+
+    // If the pipe is full the proxy thread has a wake up pending anyway
+    if ((write(mWakeUpPipe[1], &c, 1) != 1) && (errno != EAGAIN)) {
+      eos_err("failed to wake up the proxy thread errno=%i", errno);
     }
   }
 
-  if (done) {
-    std::string resp_str = std::string(static_cast<char*>(reply.data()),
-                                       reply.size());
-    resp = new ResponseProto();
-    resp->ParseFromString(resp_str);
+  return req_id;
+}
+
 
-    // If response is redirect and the error information matches one of the MGM
-    // nodes specified in the configuration, this means there was a master/slave
-    // switch and we need to update the socket to which requests are sent.
-    if (resp->response() == SFS_REDIRECT) {
-      if (resp->has_error()) {
-        std::ostringstream sstr;
-        sstr << resp->error().message();
-        std::string redirect_host = sstr.str();
-
-        // Update the master MGM instance
-        if (UpdateMaster(redirect_host)) {
-          eos_debug("successfully update the master MGM to: %s", redirect_host.c_str());
-          resp->set_response(SFS_STALL);
-        } else {
-          eos_warning("redirect host:%s is not among our known MGM nodes -  "
-                      "failed update master MGM; it migth well be an FST node",
-                      redirect_host.c_str());
-        }
+//------------------------------------------------------------------------------
+// Parse ProtocolBuffer reply and handle the master MGM switch
+//------------------------------------------------------------------------------
+ResponseProto*
+EosAuthOfs::ParseResponse(const std::string& reply)
+{
+  ResponseProto* resp = new ResponseProto();
+  resp->ParseFromString(reply);
+
+  // If response is redirect and the error information matches one of the MGM
+  // nodes specified in the configuration, this means there was a master/slave
+  // switch and we need to update the socket to which requests are sent.
+  if (resp->response() == SFS_REDIRECT) {
+    if (resp->has_error()) {
+      std::ostringstream sstr;
+      sstr << resp->error().message();
+      std::string redirect_host = sstr.str();
+
+      // Update the master MGM instance
+      if (UpdateMaster(redirect_host)) {
+        eos_debug("successfully update the master MGM to: %s", redirect_host.c_str());
+        resp->set_response(SFS_STALL);
       } else {
-        eos_err("redirect message without error information - change to error");
-        resp->set_response(SFS_ERROR);
+        eos_warning("redirect host:%s is not among our known MGM nodes -  "
+                    "failed update master MGM; it migth well be an FST node",
+                    redirect_host.c_str());
       }
+    } else {
+      eos_err("redirect message without error information - change to error");
+      resp->set_response(SFS_ERROR);
     }
-  } else {
-    eos_err("socket error/timeout during receive");
   }
 
   return resp;
@@ -1361,33 +1318,82 @@ EosAuthOfs::GetResponse(zmq::socket_t*& socket)
 
 
 //------------------------------------------------------------------------------
-// Update the socket pointing to the master MGM instance
+// Build the cache key of a stat or exists request
+//------------------------------------------------------------------------------
+std::string
+EosAuthOfs::GetCacheKey(const char* op, const char* path,
+                        const XrdSecEntity* client, const char* opaque) const
+{
+  if (!mCache.IsEnabled()) {
+    return "";
+  }
+
+  // The reply depends on the identity the MGM maps the client to
+  std::ostringstream sstr;
+  sstr << op << '\n' << path << '\n' << (opaque ? opaque : "");
+
+  if (client) {
+    sstr << '\n' << client->prot << '\n' << (client->name ? client->name : "")
+         << '\n' << (client->host ? client->host : "") << '\n'
+         << (client->vorg ? client->vorg : "") << '\n'
+         << (client->role ? client->role : "") << '\n'
+         << (client->grps ? client->grps : "") << '\n'
+         << (client->tident ? client->tident : "");
+  }
+
+  return sstr.str();
+}
+
+
+//------------------------------------------------------------------------------
+// Update the master MGM instance
 //------------------------------------------------------------------------------
 bool
 EosAuthOfs::UpdateMaster(std::string& redirect_host)
 {
-  bool found = false;
-  zmq::socket_t* upd_socket;
+  Backend* upd_backend = nullptr;
   eos_debug("redirect_host:%s", redirect_host.c_str());
 
   // Chech if the new master was also specified in the configuration
-  if (mBackend1.first.find(redirect_host) != string::npos) {
-    upd_socket = mBackend1.second;
-    found = true;
-  } else if (mBackend2.first.find(redirect_host) != string::npos) {
-    upd_socket = mBackend2.second;
-    found = true;
+  if (mBackend1.mEndpoint.find(redirect_host) != string::npos) {
+    upd_backend = &mBackend1;
+  } else if (mBackend2.mEndpoint.find(redirect_host) != string::npos) {
+    upd_backend = &mBackend2;
+  }
+
+  if (!upd_backend) {
+    return false;
   }
 
-  if (found) {
+  {
     XrdSysMutexHelper scop_lock(mMutexMaster);
 
-    if (mMaster != upd_socket) {
-      mMaster = upd_socket;
+    if (mMaster == upd_backend) {
+      return true;
     }
+
+    mMaster = upd_backend;
+  }
+
+  // The requests sent to the previous master get at best a redirect back, so
+  // stall their clients which then retry against the new master
+  ResponseProto stall;
+  stall.set_response(SFS_STALL);
+  stall.mutable_error()->set_user("");
+  stall.mutable_error()->set_code(SFS_STALL);
+  stall.mutable_error()->set_message("master MGM changed, retry");
+  std::string reply;
+  stall.SerializeToString(&reply);
+  std::vector<ReplyCallback> stalled = mPending.TakeSentToOthers(upd_backend);
+
+  eos_info("msg=\"master MGM switched\" master=%s stalled_requests=%lu",
+           upd_backend->mEndpoint.c_str(), stalled.size());
+
+  for (auto& callback : stalled) {
+    callback(&reply);
   }
 
-  return found;
+  return true;
 }
 
 EOSAUTHNAMESPACE_END
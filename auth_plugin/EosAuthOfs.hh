@@ -26,9 +26,18 @@
 
 #include "XrdOfs/XrdOfs.hh"
 #include "Namespace.hh"
-#include "common/ConcurrentQueue.hh"
+#include "PendingRequests.hh"
+#include "ResponseCache.hh"
 #include <zmq.hpp>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
 //! Forward declaration
 class EosAuthOfsDirectory;
@@ -44,6 +53,8 @@ class Message;
 
 EOSAUTHNAMESPACE_BEGIN
 
+class ResponseProto;
+
 //------------------------------------------------------------------------------
 //! Class EosAuthOfs built on top of XrdOfs
 /*! Decription: The libEosAuthOfs.so is inteded to be used as an OFS library
@@ -66,11 +77,17 @@ EOSAUTHNAMESPACE_BEGIN
         ports to which ZMQ can connect to the MGM nodes so that it can forward
         requests and receive responses. Only the mastermgm parameter is mandatory
         the other one is optional and can be left out.
-    - eosauth.numsockets - once a clients wants to send a request the thread
-        allocated to him in XRootD will require a socket to send the request
-        to the MGM node. Therefore, we set up a pool of sockets from the
-        begining which can be used to send/receiver requests/responses.
-        The default size is 10 sockets.
+    - eosauth.numsockets - number of connections opened to each MGM node,
+        by default 1. The requests are tagged with a request id and sent by
+        the proxy thread round-robin over these connections without waiting
+        for the previous replies. Requests which only return a status (chmod,
+        mkdir, rem, remdir, rename, truncate) are completed through the XRootD
+        callback so the XRootD thread is released immediately, all the other
+        requests wait for the reply with the same id.
+    - eosauth.cachettl - time in milliseconds for which the replies to stat
+        and exists requests are cached. The cache is emptied by any request
+        modifying the namespace that goes through this plugin. The default is
+        0 i.e. no caching.
 
     MGM - configuration
     ===================
@@ -243,18 +260,39 @@ public:
   int getStats(char* buff, int blen);
 
 private:
+  //! Max time to wait for a reply, the XRootD client times out after 60s
+  static constexpr std::chrono::seconds sReplyTimeout {60};
+
+  //----------------------------------------------------------------------------
+  //! MGM endpoint and the sockets connected to it
+  //----------------------------------------------------------------------------
+  struct Backend {
+    std::string mEndpoint; ///< "host:port" of the MGM
+    std::vector<zmq::socket_t*> mSockets; ///< sockets connected to the MGM
+  };
+
+  //! Callback consuming the serialized reply of a forwarded request, the
+  //! reply is null if none was received in time
+  using ReplyCallback = PendingRequests<Backend>::Callback;
 
   pthread_t proxy_tid; ///< id of the proxy thread
   zmq::context_t* mZmqContext; ///< ZMQ context
-  zmq::socket_t* mFrontend; ///< proxy socket facing the clients
-  zmq::socket_t* mMaster; ///< socket pointing to the MGM master
+  Backend* mMaster; ///< MGM master to which requests are sent
   XrdSysMutex mMutexMaster; ///< mutex for switching the MGM master
-  int mSizePoolSocket; ///< maximum size of the client socket pool
-  eos::common::ConcurrentQueue<zmq::socket_t*>
-  mPoolSocket; ///< ZMQ client socket pool
+  std::atomic<uint64_t> mReqId {0}; ///< Id of the last request
+  //! Mutex protecting the queue of outgoing requests
+  std::mutex mMutexRequests;
+  //! Requests to be sent by the proxy thread
+  std::deque<std::pair<uint64_t, std::string>> mOutQueue;
+  //! Requests waiting for a reply
+  PendingRequests<Backend> mPending;
+  int mWakeUpPipe[2]; ///< pipe used to wake up the proxy thread
+  ResponseCache mCache; ///< Cache of stat and exists replies
   ///! MGM endpoints to which requests can be dispatched and the corresponding sockets
-  std::pair<std::string, zmq::socket_t*> mBackend1;
-  std::pair<std::string, zmq::socket_t*> mBackend2;
+  Backend mBackend1;
+  Backend mBackend2;
+  int mNumSockets; ///< number of sockets connected to each MGM
+  size_t mNextSocket; ///< next socket used for sending, only for proxy thread
   std::string mManagerIp; ///< auth ip address
   int mPort;   ///< port on which the current auth server runs
   int mLogLevel; ///< log level value 0 -7 (LOG_EMERG - LOG_DEBUG)
@@ -271,30 +309,93 @@ private:
   static void* StartAuthProxyThread(void* pp);
 
   //--------------------------------------------------------------------------
-  //! Send ProtocolBuffer object using ZMQ
+  //! Forward ProtocolBuffer request to the master MGM and wait for the reply
+  //!
+  //! @param message request to be sent over the wire
+  //! @param cache_key if not empty the reply is looked up in and stored in
+  //!        the reply cache using this key
+  //!
+  //! @return pointer to received object or null if there was an error or a
+  //!         timeout, the user has the responsibility to delete the obtained
+  //!         object
+  //--------------------------------------------------------------------------
+  ResponseProto* ForwardRequest(google::protobuf::Message* message,
+                                const std::string& cache_key = "");
+
+  //--------------------------------------------------------------------------
+  //! Forward ProtocolBuffer request which only returns a status to the master
+  //! MGM without blocking the calling thread. If the client accepts a
+  //! callback, the reply is delivered through the callback of the error
+  //! object and SFS_STARTED is returned, otherwise this waits for the reply.
+  //! The reply cache is emptied once the reply arrives.
   //!
-  //! @param socket ZMQ socket object
-  //! @param object to be sent over the wire
+  //! @param message request to be sent over the wire
+  //! @param error error object of the client
   //!
-  //! @return true if object sent successfully, otherwise false
+  //! @return SFS_STARTED or the MGM return code
+  //--------------------------------------------------------------------------
+  int ForwardRequestAsync(google::protobuf::Message* message,
+                          XrdOucErrInfo& error);
+
+  //--------------------------------------------------------------------------
+  //! Queue request to be sent by the proxy thread
   //!
+  //! @param message request to be sent over the wire
+  //! @param callback called once with the reply or with null on timeout
+  //!
+  //! @return request id or 0 if the request could not be serialized
   //--------------------------------------------------------------------------
-  bool SendProtoBufRequest(zmq::socket_t* socket,
-                           google::protobuf::Message* message);
+  uint64_t QueueRequest(google::protobuf::Message* message,
+                        ReplyCallback&& callback);
 
   //--------------------------------------------------------------------------
-  //! Get ProtocolBuffer reply object using ZMQ
+  //! Parse ProtocolBuffer reply and handle the master MGM switch
   //!
-  //! @param socket ZMQ socket object
+  //! @param reply serialized reply
   //!
-  //! @return pointer to received object, the user has the responsibility to
+  //! @return pointer to reply object, the user has the responsibility to
   //!         delete the obtained object
+  //--------------------------------------------------------------------------
+  ResponseProto* ParseResponse(const std::string& reply);
+
+  //--------------------------------------------------------------------------
+  //! Send the queued requests to the master MGM
+  //!
+  //! @return true if successful, otherwise false
+  //--------------------------------------------------------------------------
+  bool SendQueuedRequests();
+
+  //--------------------------------------------------------------------------
+  //! Receive a reply from an MGM and hand it to the waiting request
+  //!
+  //! @param socket socket connected to the MGM
+  //!
+  //! @return true if successful, otherwise false
+  //--------------------------------------------------------------------------
+  bool DispatchReply(zmq::socket_t* socket);
+
+  //--------------------------------------------------------------------------
+  //! Fail the pending requests whose reply deadline has passed
+  //--------------------------------------------------------------------------
+  void ExpireRequests();
+
+  //--------------------------------------------------------------------------
+  //! Build the cache key of a stat or exists request
+  //!
+  //! @param op operation name
+  //! @param path request path
+  //! @param client client identity
+  //! @param opaque request opaque information
   //!
+  //! @return cache key or empty string if the reply cache is disabled
   //--------------------------------------------------------------------------
-  google::protobuf::Message* GetResponse(zmq::socket_t*& socket);
+  std::string GetCacheKey(const char* op, const char* path,
+                          const XrdSecEntity* client, const char* opaque) const;
 
   //--------------------------------------------------------------------------
-  //! Update the socket pointing to the master MGM instance
+  //! Update the master MGM instance. The requests already sent to the
+  //! previous master are completed with a stall so that the clients retry
+  //! them against the new master.
   //!
   //! @param new_master new host and port values for the master MGM
   //!                   the format is: "host:port"
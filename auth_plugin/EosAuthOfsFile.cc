@@ -37,7 +37,8 @@ EOSAUTHNAMESPACE_BEGIN
 EosAuthOfsFile::EosAuthOfsFile(char* user, int MonID):
   XrdSfsFile(user, MonID),
   eos::common::LogId(),
-  mName("")
+  mName(""),
+  mIsRW(false)
 {
   // emtpy
 }
@@ -81,29 +82,27 @@ EosAuthOfsFile::open(const char* fileName,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_open = gOFS->ForwardRequest(req_proto);
+  mIsRW = (openMode & (SFS_O_WRONLY | SFS_O_RDWR | SFS_O_CREAT | SFS_O_TRUNC));
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_open = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                 socket));
-
-    if (resp_open) {
-      retc = resp_open->response();
-      eos_debug("got response for file open request: %i", retc);
+  if (mIsRW) {
+    // The file might be created or truncated
+    gOFS->mCache.Clear();
+  }
 
-      if (resp_open->has_error()) {
-        error.setErrInfo(resp_open->error().code(),
-                         resp_open->error().message().c_str());
-      }
+  if (resp_open) {
+    retc = resp_open->response();
+    eos_debug("got response for file open request: %i", retc);
 
-      delete resp_open;
+    if (resp_open->has_error()) {
+      error.setErrInfo(resp_open->error().code(),
+                       resp_open->error().message().c_str());
     }
+
+    delete resp_open;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -131,29 +130,21 @@ EosAuthOfsFile::read(XrdSfsFileOffset offset,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
-
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fread = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
-
-    if (resp_fread) {
-      retc = resp_fread->response();
+  ResponseProto* resp_fread = gOFS->ForwardRequest(req_proto);
 
-      if (retc && resp_fread->has_message()) {
-        buffer = static_cast<char*>(memcpy((void*)buffer,
-                                           resp_fread->message().c_str(),
-                                           resp_fread->message().length()));
-      }
+  if (resp_fread) {
+    retc = resp_fread->response();
 
-      delete resp_fread;
+    if (retc && resp_fread->has_message()) {
+      buffer = static_cast<char*>(memcpy((void*)buffer,
+                                         resp_fread->message().c_str(),
+                                         resp_fread->message().length()));
     }
+
+    delete resp_fread;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -182,23 +173,15 @@ EosAuthOfsFile::write(XrdSfsFileOffset offset,
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
-
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fwrite = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                   socket));
+  ResponseProto* resp_fwrite = gOFS->ForwardRequest(req_proto);
 
-    if (resp_fwrite) {
-      retc = resp_fwrite->response();
-      eos_debug("got response for file write request");
-      delete resp_fwrite;
-    }
+  if (resp_fwrite) {
+    retc = resp_fwrite->response();
+    eos_debug("got response for file write request");
+    delete resp_fwrite;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -224,31 +207,23 @@ EosAuthOfsFile::FName()
     return "";
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
-
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fname = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+  ResponseProto* resp_fname = gOFS->ForwardRequest(req_proto);
 
-    if (resp_fname) {
-      retc = resp_fname->response();
-      eos_debug("got response for filefname request");
+  if (resp_fname) {
+    retc = resp_fname->response();
+    eos_debug("got response for filefname request");
 
-      if (retc == SFS_OK) {
-        eos_debug("file fname is: %s", resp_fname->message().c_str());
-        mName = resp_fname->message();
-      } else {
-        eos_debug("file fname not found or error on server side");
-      }
-
-      delete resp_fname;
+    if (retc == SFS_OK) {
+      eos_debug("file fname is: %s", resp_fname->message().c_str());
+      mName = resp_fname->message();
+    } else {
+      eos_debug("file fname not found or error on server side");
     }
+
+    delete resp_fname;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return (retc ? static_cast<const char*>(0) :
           (mName.empty() ? "" : mName.c_str()));
@@ -275,29 +250,21 @@ EosAuthOfsFile::stat(struct stat* buf)
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
-
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_fstat = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
-
-    if (resp_fstat) {
-      retc = resp_fstat->response();
-      buf = static_cast<struct stat*>(memcpy((void*)buf,
-                                             resp_fstat->message().c_str(),
-                                             sizeof(struct stat)));
-      eos_debug("got response for fstat request: %i", retc);
-      delete resp_fstat;
-    }
-  } else {
-    eos_err("file stat - unable to send request");
-    memset(buf, 0, sizeof(struct stat));
+  ResponseProto* resp_fstat = gOFS->ForwardRequest(req_proto);
+
+  if (resp_fstat) {
+    retc = resp_fstat->response();
+    buf = static_cast<struct stat*>(memcpy((void*)buf,
+                                           resp_fstat->message().c_str(),
+                                           sizeof(struct stat)));
+    eos_debug("got response for fstat request: %i", retc);
+    delete resp_fstat;
   }
+  } else {
+  eos_err("file stat - unable to send request");
+  memset(buf, 0, sizeof(struct stat));
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
@@ -323,23 +290,20 @@ EosAuthOfsFile::close()
     return retc;
   }
 
-  // Get a socket object from the pool
-  zmq::socket_t* socket;
-  gOFS->mPoolSocket.wait_pop(socket);
+  ResponseProto* resp_close = gOFS->ForwardRequest(req_proto);
 
-  if (gOFS->SendProtoBufRequest(socket, req_proto)) {
-    ResponseProto* resp_close = static_cast<ResponseProto*>(gOFS->GetResponse(
-                                  socket));
+  if (mIsRW) {
+    // The size and modification time of the file changed
+    gOFS->mCache.Clear();
+  }
 
-    if (resp_close) {
-      retc = resp_close->response();
-      eos_debug("got response for file close request: %i", retc);
-      delete resp_close;
-    }
+  if (resp_close) {
+    retc = resp_close->response();
+    eos_debug("got response for file close request: %i", retc);
+    delete resp_close;
   }
 
-  // Release socket and free memory
-  gOFS->mPoolSocket.push(socket);
+  // Free memory
   delete req_proto;
   return retc;
 }
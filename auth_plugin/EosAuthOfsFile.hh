@@ -160,6 +160,7 @@ class EosAuthOfsFile: public XrdSfsFile, public eos::common::LogId
   private:
 
     std::string mName; ///< file name
+    bool mIsRW; ///< file opened for writing
 
     //--------------------------------------------------------------------------
     //! Create an error message for a file object
@@ -0,0 +1,188 @@
+// -----------------------------------------------------------------------------
+// File: PendingRequests.hh
+// -----------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "Namespace.hh"
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+EOSAUTHNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class PendingRequests - requests forwarded to an MGM which wait for their
+//! reply. Every request is identified by the id sent in the envelope of the
+//! message, which the MGM returns untouched together with the reply.
+//!
+//! @tparam Backend type identifying the MGM a request was sent to
+//------------------------------------------------------------------------------
+template <typename Backend>
+class PendingRequests
+{
+public:
+  //! Callback consuming the serialized reply of a request, the reply is null
+  //! if none was received in time
+  using Callback = std::function<void(const std::string* reply)>;
+  using Clock = std::chrono::steady_clock;
+
+  //--------------------------------------------------------------------------
+  //! Add request
+  //!
+  //! @param id request id
+  //! @param callback called once with the reply
+  //! @param deadline time by which the reply has to arrive
+  //--------------------------------------------------------------------------
+  void Add(uint64_t id, Callback&& callback, Clock::time_point deadline)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    Request& req = mRequests[id];
+    req.mCallback = std::move(callback);
+    req.mDeadline = deadline;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Record the MGM to which the request was sent
+  //!
+  //! @param id request id
+  //! @param backend MGM the request was sent to
+  //--------------------------------------------------------------------------
+  void SetBackend(uint64_t id, const Backend* backend)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mRequests.find(id);
+
+    if (it != mRequests.end()) {
+      it->second.mBackend = backend;
+    }
+  }
+
+  //--------------------------------------------------------------------------
+  //! Take the callback of the request matching a reply
+  //!
+  //! @param id request id found in the reply
+  //! @param callback callback of the request
+  //!
+  //! @return true if the request was pending, false if it already timed out
+  //!         or was failed
+  //--------------------------------------------------------------------------
+  bool Take(uint64_t id, Callback& callback)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mRequests.find(id);
+
+    if (it == mRequests.end()) {
+      return false;
+    }
+
+    callback = std::move(it->second.mCallback);
+    mRequests.erase(it);
+    return true;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Drop request without calling its callback
+  //!
+  //! @param id request id
+  //--------------------------------------------------------------------------
+  void Remove(uint64_t id)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRequests.erase(id);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Take the requests whose reply deadline has passed
+  //!
+  //! @param now current time
+  //!
+  //! @return ids and callbacks of the expired requests
+  //--------------------------------------------------------------------------
+  std::vector<std::pair<uint64_t, Callback>> TakeExpired(Clock::time_point now)
+  {
+    std::vector<std::pair<uint64_t, Callback>> expired;
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto it = mRequests.begin(); it != mRequests.end(); /* empty */) {
+      if (it->second.mDeadline <= now) {
+        expired.emplace_back(it->first, std::move(it->second.mCallback));
+        it = mRequests.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    return expired;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Take the requests sent to an MGM other than the given one, the ones not
+  //! sent yet are kept
+  //!
+  //! @param backend current master MGM
+  //!
+  //! @return callbacks of the requests sent to other MGMs
+  //--------------------------------------------------------------------------
+  std::vector<Callback> TakeSentToOthers(const Backend* backend)
+  {
+    std::vector<Callback> taken;
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    for (auto it = mRequests.begin(); it != mRequests.end(); /* empty */) {
+      if (it->second.mBackend && (it->second.mBackend != backend)) {
+        taken.push_back(std::move(it->second.mCallback));
+        it = mRequests.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    return taken;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Get number of pending requests
+  //--------------------------------------------------------------------------
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mRequests.size();
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Request waiting for a reply
+  //----------------------------------------------------------------------------
+  struct Request {
+    Callback mCallback; ///< called once with the reply
+    const Backend* mBackend {nullptr}; ///< MGM the request was sent to if any
+    Clock::time_point mDeadline; ///< reply deadline
+  };
+
+  mutable std::mutex mMutex;
+  std::map<uint64_t, Request> mRequests;
+};
+
+EOSAUTHNAMESPACE_END
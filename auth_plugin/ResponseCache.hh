@@ -0,0 +1,155 @@
+// -----------------------------------------------------------------------------
+// File: ResponseCache.hh
+// -----------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "Namespace.hh"
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+EOSAUTHNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ResponseCache - keeps the serialized MGM replies of idempotent
+//! requests for a short time. The key has to identify both the request and
+//! the client since the reply depends on the identity of the client.
+//------------------------------------------------------------------------------
+class ResponseCache
+{
+public:
+  //--------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_entries max number of cached replies
+  //--------------------------------------------------------------------------
+  ResponseCache(size_t max_entries = 100000):
+    mMaxEntries(max_entries)
+  {}
+
+  //--------------------------------------------------------------------------
+  //! Set the time to live of the entries, 0 disables the cache
+  //--------------------------------------------------------------------------
+  void SetTtl(std::chrono::milliseconds ttl)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTtl = ttl;
+    mEntries.clear();
+  }
+
+  //--------------------------------------------------------------------------
+  //! Check if the cache is enabled
+  //--------------------------------------------------------------------------
+  bool IsEnabled() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return (mTtl.count() != 0);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Get cached reply
+  //!
+  //! @param key request key
+  //! @param value cached reply
+  //!
+  //! @return true if found and not expired, otherwise false
+  //--------------------------------------------------------------------------
+  bool Get(const std::string& key, std::string& value)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mEntries.find(key);
+
+    if (it == mEntries.end()) {
+      return false;
+    }
+
+    if (it->second.second <= std::chrono::steady_clock::now()) {
+      mEntries.erase(it);
+      return false;
+    }
+
+    value = it->second.first;
+    return true;
+  }
+
+  //--------------------------------------------------------------------------
+  //! Cache reply
+  //!
+  //! @param key request key
+  //! @param value reply
+  //--------------------------------------------------------------------------
+  void Put(const std::string& key, const std::string& value)
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (mTtl.count() == 0) {
+      return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    if (mEntries.size() >= mMaxEntries) {
+      // Drop the expired entries and if that's not enough everything
+      for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (it->second.second <= now) {
+          it = mEntries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+
+      if (mEntries.size() >= mMaxEntries) {
+        mEntries.clear();
+      }
+    }
+
+    mEntries[key] = std::make_pair(value, now + mTtl);
+  }
+
+  //--------------------------------------------------------------------------
+  //! Drop all the cached replies
+  //--------------------------------------------------------------------------
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.clear();
+  }
+
+  //--------------------------------------------------------------------------
+  //! Get number of cached replies
+  //--------------------------------------------------------------------------
+  size_t Size() const
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mEntries.size();
+  }
+
+private:
+  mutable std::mutex mMutex;
+  const size_t mMaxEntries;
+  std::chrono::milliseconds mTtl {0};
+  //! Map of request keys to replies and their expiration time
+  std::unordered_map<std::string, std::pair<std::string,
+      std::chrono::steady_clock::time_point>> mEntries;
+};
+
+EOSAUTHNAMESPACE_END
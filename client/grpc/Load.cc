@@ -0,0 +1,232 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! Load test for the MGM gRPC interface - runs the given RPC from several
+//! threads for a fixed duration and reports the achieved RPC/s and latency
+//------------------------------------------------------------------------------
+
+#include <sstream>
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <getopt.h>
+#include <unistd.h>
+#include "client/grpc/GrpcClient.hh"
+#include "common/Logging.hh"
+
+int usage(const char* name)
+{
+  std::ostringstream oss;
+  oss << "usage: " << name
+      << " [--key <ssl-key-file> --cert <ssl-cert-file> --ca <ca-cert-file>]"
+      << " [--token <auth-token>]"
+      << std::endl << std::setw(strlen(name) + 8) << ""
+      << "[--endpoint <host:port>] [--rpc ping|nsstat|fileinsert]"
+      << " [--threads <n>] [--duration <sec>]"
+      << std::endl << std::setw(strlen(name) + 8) << ""
+      << "[--batch <n>] [--prefix <existing-directory>] [-h|--help]"
+      << std::endl
+      << "       fileinsert creates <prefix>/load.<pid>.<thread>.<n> entries"
+      << std::endl;
+  std::cerr << oss.str();
+  return -1;
+}
+
+int main(int argc, char* argv[])
+{
+  using eos::client::GrpcClient;
+  std::string endpoint{"localhost:50051"};
+  std::string keyfile;
+  std::string certfile;
+  std::string cafile;
+  std::string token;
+  std::string rpc{"ping"};
+  std::string prefix;
+  int nthreads = 8;
+  int duration = 10;
+  int batch = 1;
+
+  while (true) {
+    static struct option long_options[] {
+      {"key",      required_argument, 0, 'k'},
+      {"cert",     required_argument, 0, 'c'},
+      {"ca",       required_argument, 0, 'a'},
+      {"endpoint", required_argument, 0, 'e'},
+      {"token",    required_argument, 0, 't'},
+      {"rpc",      required_argument, 0, 'r'},
+      {"threads",  required_argument, 0, 'n'},
+      {"duration", required_argument, 0, 's'},
+      {"batch",    required_argument, 0, 'b'},
+      {"prefix",   required_argument, 0, 'p'},
+      {"help",     no_argument,       0, 'h'},
+      {0, 0,                          0, 0}
+    };
+    int option_index = 0;
+    int c = getopt_long(argc, argv, "k:c:a:e:t:r:n:s:b:p:h", long_options,
+                        &option_index);
+
+    // Detect end of the options
+    if (c == -1) {
+      break;
+    }
+
+    switch (c) {
+    case 'k':
+      keyfile = optarg;
+      break;
+
+    case 'c':
+      certfile = optarg;
+      break;
+
+    case 'a':
+      cafile = optarg;
+      break;
+
+    case 'e':
+      endpoint = optarg;
+      break;
+
+    case 't':
+      token = optarg;
+      break;
+
+    case 'r':
+      rpc = optarg;
+      break;
+
+    case 'n':
+      nthreads = atoi(optarg);
+      break;
+
+    case 's':
+      duration = atoi(optarg);
+      break;
+
+    case 'b':
+      batch = atoi(optarg);
+      break;
+
+    case 'p':
+      prefix = optarg;
+      break;
+
+    default:
+      return usage(argv[0]);
+    }
+  }
+
+  // Make sure all elements are present if certificate authentication is used
+  if (keyfile.length() || certfile.length() || cafile.length()) {
+    if (!keyfile.length() || !certfile.length() || !cafile.length()) {
+      return usage(argv[0]);
+    }
+  }
+
+  if ((rpc != "ping") && (rpc != "nsstat") && (rpc != "fileinsert")) {
+    return usage(argv[0]);
+  }
+
+  if ((rpc == "fileinsert") && prefix.empty()) {
+    return usage(argv[0]);
+  }
+
+  if ((nthreads <= 0) || (duration <= 0) || (batch <= 0)) {
+    return usage(argv[0]);
+  }
+
+  // Every thread uses its own channel
+  std::vector<std::unique_ptr<GrpcClient>> clients;
+
+  for (int i = 0; i < nthreads; ++i) {
+    clients.emplace_back(GrpcClient::Create(endpoint, token, keyfile, certfile,
+                                            cafile));
+
+    if (!clients.back()) {
+      std::cerr << "Failed to create grpc client object!" << std::endl;
+      return -1;
+    }
+  }
+
+  std::atomic<uint64_t> n_ok {0};
+  std::atomic<uint64_t> n_failed {0};
+  std::atomic<uint64_t> latency_us {0};
+  const auto start_time = std::chrono::steady_clock::now();
+  const auto end_time = start_time + std::chrono::seconds(duration);
+  std::vector<std::thread> workers;
+
+  for (int i = 0; i < nthreads; ++i) {
+    workers.emplace_back([&, i]() {
+      GrpcClient* client = clients[i].get();
+      uint64_t counter = 0;
+
+      while (std::chrono::steady_clock::now() < end_time) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = false;
+
+        if (rpc == "ping") {
+          ok = (client->Ping("ping") == "ping");
+        } else if (rpc == "nsstat") {
+          eos::rpc::NsStatRequest request;
+          eos::rpc::NsStatResponse reply;
+          request.set_authkey(token);
+          ok = (client->NsStat(request, reply) == 0);
+        } else {
+          std::vector<std::string> paths;
+
+          for (int j = 0; j < batch; ++j) {
+            paths.push_back(SSTR(prefix << "/load." << getpid() << "." << i << "."
+                                 << counter++));
+          }
+
+          ok = (client->FileInsert(paths) == 0);
+        }
+
+        latency_us += std::chrono::duration_cast<std::chrono::microseconds>
+                      (std::chrono::steady_clock::now() - t0).count();
+        ++(ok ? n_ok : n_failed);
+      }
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const double elapsed = std::chrono::duration_cast<std::chrono::microseconds>
+                         (std::chrono::steady_clock::now() - start_time).count() / 1e6;
+  const uint64_t total = n_ok + n_failed;
+  std::cout << "rpc=" << rpc << " threads=" << nthreads << " batch=" << batch
+            << " duration=" << std::fixed << std::setprecision(2) << elapsed << "s"
+            << std::endl
+            << "requests=" << total << " ok=" << n_ok << " failed=" << n_failed
+            << std::endl
+            << "rate=" << (total / elapsed) << " rpc/s";
+
+  if (rpc == "fileinsert") {
+    std::cout << " (" << (total * batch / elapsed) << " entries/s)";
+  }
+
+  std::cout << " avg-latency=" << (total ? (latency_us / total) : 0) << "us"
+            << std::endl;
+  return n_failed ? -1 : 0;
+}
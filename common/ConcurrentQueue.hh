@@ -28,6 +28,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 #include <common/Logging.hh>
 
 EOSCOMMONNAMESPACE_BEGIN
@@ -54,6 +55,7 @@ public:
   bool empty() const;
   bool try_pop(Data& popped_value);
   void wait_pop(Data& popped_value);
+  bool wait_pop_for(Data& popped_value, std::chrono::milliseconds timeout);
   void clear();
 
 private:
@@ -169,6 +171,30 @@ ConcurrentQueue<Data>::wait_pop(Data& popped_value)
   queue.pop();
 }
 
+//------------------------------------------------------------------------------
+//! Get data from queue, if empty queue then block until at least one element
+//! is added or the timeout expires
+//!
+//! @return true if an element was popped, otherwise false
+//------------------------------------------------------------------------------
+template <typename Data>
+bool
+ConcurrentQueue<Data>::wait_pop_for(Data& popped_value,
+                                    std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  if (!mCondVar.wait_for(lock, timeout, [&]() {
+  return !queue.empty();
+  })) {
+    return false;
+  }
+
+  popped_value = queue.front();
+  queue.pop();
+  return true;
+}
+
 //------------------------------------------------------------------------------
 //! Remove all elements from the queue
 //------------------------------------------------------------------------------
@@ -24,6 +24,9 @@
 /*----------------------------------------------------------------------------*/
 #include "common/Namespace.hh"
 #include "common/Report.hh"
+#include "common/SymKeys.hh"
+#include <iomanip>
+#include <sstream>
 
 /*----------------------------------------------------------------------------*/
 
@@ -44,6 +47,7 @@ Report::Report(XrdOucEnv& report)
   ctms = report.Get("ctms") ? strtoull(report.Get("ctms"), 0, 10) : 0;
   logid = report.Get("log") ? report.Get("log") : "";
   path = report.Get("path") ? report.Get("path") : "";
+  fstpath = report.Get("fstpath") ? report.Get("fstpath") : "";
   uid = (uid_t) atoi(report.Get("ruid") ? report.Get("ruid") : "0");
   gid = (gid_t) atoi(report.Get("rgid") ? report.Get("rgid") : "0");
   td = report.Get("td") ? report.Get("td") : "none";
@@ -63,25 +67,21 @@ Report::Report(XrdOucEnv& report)
   rb = strtoull(report.Get("rb") ? report.Get("rb") : "0", 0, 10);
   rb_min = strtoull(report.Get("rb_min") ? report.Get("rb_min") : "0", 0, 10);
   rb_max = strtoull(report.Get("rb_max") ? report.Get("rb_max") : "0", 0, 10);
-  rb_sigma = strtoull(report.Get("rb_sigma") ? report.Get("rb_sigma") : "0", 0,
-                      10);
+  rb_sigma = strtod(report.Get("rb_sigma") ? report.Get("rb_sigma") : "0", 0);
   rv_op = strtoull(report.Get("rv_op") ? report.Get("rv_op") : "0", 0, 10);
   rvb_min = strtoull(report.Get("rvb_min") ? report.Get("rvb_min") : "0", 0, 10);
   rvb_max = strtoull(report.Get("rvb_max") ? report.Get("rvb_max") : "0", 0, 10);
   rvb_sum = strtoull(report.Get("rvb_sum") ? report.Get("rvb_sum") : "0", 0, 10);
-  rvb_sigma = strtoull(report.Get("rvb_sigma") ? report.Get("rvb_sigma") : "0", 0,
-                       10);
+  rvb_sigma = strtod(report.Get("rvb_sigma") ? report.Get("rvb_sigma") : "0", 0);
   rs_op = strtoull(report.Get("rs_op") ? report.Get("rs_op") : "0", 0, 10);
   rsb_min = strtoull(report.Get("rsb_min") ? report.Get("rsb_min") : "0", 0, 10);
   rsb_max = strtoull(report.Get("rsb_max") ? report.Get("rsb_max") : "0", 0, 10);
   rsb_sum = strtoull(report.Get("rsb_sum") ? report.Get("rsb_sum") : "0", 0, 10);
-  rsb_sigma = strtoull(report.Get("rsb_sigma") ? report.Get("rsb_sigma") : "0", 0,
-                       10);
+  rsb_sigma = strtod(report.Get("rsb_sigma") ? report.Get("rsb_sigma") : "0", 0);
   rc_min = strtoul(report.Get("rc_min") ? report.Get("rc_min") : "0", 0, 10);
   rc_max = strtoul(report.Get("rc_max") ? report.Get("rc_max") : "0", 0, 10);
   rc_sum = strtoul(report.Get("rc_sum") ? report.Get("rc_sum") : "0", 0, 10);
-  rc_sigma = strtoul(report.Get("rc_sigma") ? report.Get("rc_sigma") : "0", 0,
-                     10);
+  rc_sigma = strtod(report.Get("rc_sigma") ? report.Get("rc_sigma") : "0", 0);
   wb = strtoull(report.Get("wb") ? report.Get("wb") : "0", 0, 10);
   wb_min = strtoull(report.Get("wb_min") ? report.Get("wb_min") : "0", 0, 10);
   wb_max = strtoull(report.Get("wb_max") ? report.Get("wb_max") : "0", 0, 10);
@@ -101,6 +101,14 @@ Report::Report(XrdOucEnv& report)
   wt = atof(report.Get("wt") ? report.Get("wt") : "0.0");
   osize = strtoull(report.Get("osize") ? report.Get("osize") : "0", 0, 10);
   csize = strtoull(report.Get("csize") ? report.Get("csize") : "0", 0, 10);
+  delete_on_close = atoi(report.Get("delete_on_close") ?
+                         report.Get("delete_on_close") : "0");
+  prio_c = atoi(report.Get("prio_c") ? report.Get("prio_c") : "0");
+  prio_l = atoi(report.Get("prio_l") ? report.Get("prio_l") : "0");
+  prio_d = atoi(report.Get("prio_d") ? report.Get("prio_d") : "0");
+  forced_bw = atoi(report.Get("forced_bw") ? report.Get("forced_bw") : "0");
+  ms_sleep = strtoull(report.Get("ms_sleep") ? report.Get("ms_sleep") : "0", 0,
+                      10);
   // sec extensions
   sec_prot = report.Get("sec.prot") ? report.Get("sec.prot") : "";
   sec_name = report.Get("sec.name") ? report.Get("sec.name") : "";
@@ -114,6 +122,7 @@ Report::Report(XrdOucEnv& report)
   }
 
   sec_vorg = report.Get("sec.vorg") ? report.Get("sec.vorg") : "";
+  sec_grps = report.Get("sec.grps") ? report.Get("sec.grps") : "";
   sec_role = report.Get("sec.role") ? report.Get("sec.role") : "";
   sec_info = report.Get("sec.info") ? report.Get("sec.info") : "";
   sec_app = report.Get("sec.app") ? report.Get("sec.app") : "";
@@ -134,7 +143,7 @@ Report::Report(XrdOucEnv& report)
   da_tns = report.Get("da_tns") ? strtoull(report.Get("da_tns"), 0, 10) : 0;
   dc_ts = report.Get("dc_t") ? strtoull(report.Get("dc_t"), 0, 10) : 0;
   dm_ts = report.Get("dm_t") ? strtoull(report.Get("dm_t"), 0, 10) : 0;
-  da_ts = report.Get("da_t") ? strtoull(report.Get("da_tns"), 0, 10) : 0;
+  da_ts = report.Get("da_t") ? strtoull(report.Get("da_t"), 0, 10) : 0;
 }
 
 
@@ -191,6 +200,329 @@ Report::Dump(XrdOucString& out, bool dumpsec, bool dumptpc)
 
   out += "\n";
 }
+namespace
+{
+//------------------------------------------------------------------------------
+// Append unsigned varint
+//------------------------------------------------------------------------------
+void PutVarint(std::string& out, unsigned long long val)
+{
+  while (val >= 0x80) {
+    out += static_cast<char>((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+
+  out += static_cast<char>(val);
+}
+
+//------------------------------------------------------------------------------
+// Append double as 8 raw bytes
+//------------------------------------------------------------------------------
+void PutDouble(std::string& out, double val)
+{
+  char buf[sizeof(double)];
+  memcpy(buf, &val, sizeof(buf));
+  out.append(buf, sizeof(buf));
+}
+
+//------------------------------------------------------------------------------
+// Append length prefixed string
+//------------------------------------------------------------------------------
+void PutString(std::string& out, const std::string& val)
+{
+  PutVarint(out, val.length());
+  out += val;
+}
+
+//------------------------------------------------------------------------------
+// Cursor over the binary report
+//------------------------------------------------------------------------------
+struct BinaryReader {
+  const std::string& mData;
+  size_t mPos = 0;
+  bool mOk = true;
+
+  explicit BinaryReader(const std::string& data): mData(data) {}
+
+  unsigned long long Varint()
+  {
+    unsigned long long val = 0;
+
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (mPos >= mData.length()) {
+        mOk = false;
+        return 0;
+      }
+
+      unsigned char byte = mData[mPos++];
+      val |= (static_cast<unsigned long long>(byte & 0x7f) << shift);
+
+      if ((byte & 0x80) == 0) {
+        return val;
+      }
+    }
+
+    mOk = false;
+    return 0;
+  }
+
+  double Double()
+  {
+    double val = 0;
+
+    if (mPos + sizeof(double) > mData.length()) {
+      mOk = false;
+      return val;
+    }
+
+    memcpy(&val, mData.data() + mPos, sizeof(double));
+    mPos += sizeof(double);
+    return val;
+  }
+
+  std::string String()
+  {
+    unsigned long long len = Varint();
+
+    if (!mOk || (mPos + len > mData.length())) {
+      mOk = false;
+      return "";
+    }
+
+    std::string val = mData.substr(mPos, len);
+    mPos += len;
+    return val;
+  }
+};
+
+//------------------------------------------------------------------------------
+// Rebuild the full host name from the name and domain parts
+//------------------------------------------------------------------------------
+std::string JoinHost(const std::string& name, const std::string& domain)
+{
+  if (name == domain) {
+    return name;
+  }
+
+  return name + "." + domain;
+}
+
+//------------------------------------------------------------------------------
+// Split the full host name into the name and domain parts
+//------------------------------------------------------------------------------
+void SplitHost(const std::string& full, std::string& name, std::string& domain)
+{
+  name = domain = full;
+  auto dpos = full.find('.');
+
+  if (dpos != std::string::npos) {
+    name.erase(dpos);
+    domain.erase(0, dpos + 1);
+  }
+}
+}
+
+//------------------------------------------------------------------------------
+// Serialize the report in the env format understood by the constructor
+//------------------------------------------------------------------------------
+std::string
+Report::ToEnvString() const
+{
+  std::ostringstream oss;
+  // Enough digits for the floating point values to parse back unchanged
+  oss << std::setprecision(17);
+  oss << "log=" << logid << "&path=" << path << "&fstpath=" << fstpath
+      << "&ruid=" << uid
+      << "&rgid=" << gid << "&td=" << td << "&host=" << host
+      << "&lid=" << lid << "&fid=" << std::hex << fid << std::dec
+      << "&fsid=" << fsid << "&ots=" << ots << "&otms=" << otms
+      << "&cts=" << cts << "&ctms=" << ctms
+      << "&nrc=" << nrc << "&nwc=" << nwc
+      << "&rb=" << rb << "&rb_min=" << rb_min << "&rb_max=" << rb_max
+      << "&rb_sigma=" << rb_sigma
+      << "&rv_op=" << rv_op << "&rvb_min=" << rvb_min << "&rvb_max=" << rvb_max
+      << "&rvb_sum=" << rvb_sum << "&rvb_sigma=" << rvb_sigma
+      << "&rs_op=" << rs_op << "&rsb_min=" << rsb_min << "&rsb_max=" << rsb_max
+      << "&rsb_sum=" << rsb_sum << "&rsb_sigma=" << rsb_sigma
+      << "&rc_min=" << rc_min << "&rc_max=" << rc_max << "&rc_sum=" << rc_sum
+      << "&rc_sigma=" << rc_sigma
+      << "&wb=" << wb << "&wb_min=" << wb_min << "&wb_max=" << wb_max
+      << "&wb_sigma=" << wb_sigma
+      << "&sfwdb=" << sfwdb << "&sbwdb=" << sbwdb << "&sxlfwd=" << sxlfwdb
+      << "&sxlbwd=" << sxlbwdb << "&nfwds=" << nfwds << "&nbwds=" << nbwds
+      << "&nxlfwds=" << nxlfwds << "&nxlbwds=" << nxlbwds
+      << "&rt=" << rt << "&rvt=" << rvt << "&wt=" << wt
+      << "&osize=" << osize << "&csize=" << csize
+      << "&delete_on_close=" << delete_on_close << "&prio_c=" << prio_c
+      << "&prio_l=" << prio_l << "&prio_d=" << prio_d
+      << "&forced_bw=" << forced_bw << "&ms_sleep=" << ms_sleep
+      << "&sec.prot=" << sec_prot << "&sec.name=" << sec_name
+      << "&sec.host=" << JoinHost(sec_host, sec_domain)
+      << "&sec.vorg=" << sec_vorg << "&sec.grps=" << sec_grps
+      << "&sec.role=" << sec_role << "&sec.info=" << sec_info
+      << "&sec.app=" << sec_app;
+
+  if (tpc_src.length() || tpc_dst.length() || tpc_src_lfn.length()) {
+    oss << "&tpc.src=" << tpc_src << "&tpc.dst=" << tpc_dst
+        << "&tpc.src_lfn=" << tpc_src_lfn;
+  }
+
+  if (dsize || dc_ts || dm_ts || da_ts) {
+    oss << "&dsize=" << dsize << "&dc_t=" << dc_ts << "&dc_tns=" << dc_tns
+        << "&dm_t=" << dm_ts << "&dm_tns=" << dm_tns
+        << "&da_t=" << da_ts << "&da_tns=" << da_tns;
+  }
+
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Serialize the report in the compact binary format
+//------------------------------------------------------------------------------
+std::string
+Report::ToBinary() const
+{
+  std::string bin;
+  bin.reserve(256 + path.length() + logid.length() + td.length());
+
+  for (unsigned long long val : {
+         ots, cts, otms, ctms, (unsigned long long) uid,
+         (unsigned long long) gid, (unsigned long long) lid, fid,
+         (unsigned long long) fsid, rb, rb_min, rb_max, rv_op, rvb_min,
+         rvb_max, rvb_sum, rs_op, rsb_min, rsb_max, rsb_sum,
+         (unsigned long long) rc_min, (unsigned long long) rc_max,
+         (unsigned long long) rc_sum, wb, wb_min, wb_max, sfwdb, sbwdb,
+         sxlfwdb, sxlbwdb, nrc, nwc, nfwds, nbwds, nxlfwds, nxlbwds, osize,
+         csize, dsize, dc_ts, dc_tns, dm_ts, dm_tns, da_ts, da_tns
+       }) {
+    PutVarint(bin, val);
+  }
+
+  for (double val : {
+         rb_sigma, rvb_sigma, rsb_sigma, rc_sigma, wb_sigma, (double) rt,
+         (double) rvt, (double) wt
+       }) {
+    PutDouble(bin, val);
+  }
+
+  for (const std::string& val : {
+         logid, path, td, host, sec_prot, sec_name,
+         JoinHost(sec_host, sec_domain), sec_vorg, sec_grps, sec_role,
+         sec_info, sec_app, tpc_src, tpc_dst, tpc_src_lfn, fstpath
+       }) {
+    PutString(bin, val);
+  }
+
+  for (unsigned long long val : {
+         (unsigned long long) delete_on_close, (unsigned long long) prio_c,
+         (unsigned long long) prio_l, (unsigned long long) prio_d,
+         (unsigned long long) forced_bw, ms_sleep
+       }) {
+    PutVarint(bin, val);
+  }
+
+  std::string out;
+
+  if (!SymKey::Base64Encode(bin.data(), bin.length(), out)) {
+    return "";
+  }
+
+  return std::string(sBinaryPrefix) + out;
+}
+
+//------------------------------------------------------------------------------
+// Build a report from its compact binary representation
+//------------------------------------------------------------------------------
+std::unique_ptr<Report>
+Report::FromBinary(const std::string& body)
+{
+  if (!IsBinary(body)) {
+    return nullptr;
+  }
+
+  std::string bin;
+
+  if (!SymKey::Base64Decode(body.c_str() + strlen(sBinaryPrefix), bin)) {
+    return nullptr;
+  }
+
+  XrdOucEnv empty("");
+  std::unique_ptr<Report> report(new Report(empty));
+  BinaryReader rd(bin);
+
+  for (unsigned long long* val : {
+         &report->ots, &report->cts, &report->otms, &report->ctms
+       }) {
+    *val = rd.Varint();
+  }
+
+  report->uid = rd.Varint();
+  report->gid = rd.Varint();
+  report->lid = rd.Varint();
+  report->fid = rd.Varint();
+  report->fsid = rd.Varint();
+
+  for (unsigned long long* val : {
+         &report->rb, &report->rb_min, &report->rb_max, &report->rv_op,
+         &report->rvb_min, &report->rvb_max, &report->rvb_sum, &report->rs_op,
+         &report->rsb_min, &report->rsb_max, &report->rsb_sum
+       }) {
+    *val = rd.Varint();
+  }
+
+  report->rc_min = rd.Varint();
+  report->rc_max = rd.Varint();
+  report->rc_sum = rd.Varint();
+
+  for (unsigned long long* val : {
+         &report->wb, &report->wb_min, &report->wb_max, &report->sfwdb,
+         &report->sbwdb, &report->sxlfwdb, &report->sxlbwdb, &report->nrc,
+         &report->nwc, &report->nfwds, &report->nbwds, &report->nxlfwds,
+         &report->nxlbwds, &report->osize, &report->csize, &report->dsize,
+         &report->dc_ts, &report->dc_tns, &report->dm_ts, &report->dm_tns,
+         &report->da_ts, &report->da_tns
+       }) {
+    *val = rd.Varint();
+  }
+
+  for (double* val : {
+         &report->rb_sigma, &report->rvb_sigma, &report->rsb_sigma,
+         &report->rc_sigma, &report->wb_sigma
+       }) {
+    *val = rd.Double();
+  }
+
+  report->rt = rd.Double();
+  report->rvt = rd.Double();
+  report->wt = rd.Double();
+
+  for (std::string* val : {
+         &report->logid, &report->path, &report->td, &report->host,
+         &report->sec_prot, &report->sec_name, &report->sec_host,
+         &report->sec_vorg, &report->sec_grps, &report->sec_role,
+         &report->sec_info, &report->sec_app, &report->tpc_src,
+         &report->tpc_dst, &report->tpc_src_lfn, &report->fstpath
+       }) {
+    *val = rd.String();
+  }
+
+  report->delete_on_close = rd.Varint();
+  report->prio_c = rd.Varint();
+  report->prio_l = rd.Varint();
+  report->prio_d = rd.Varint();
+  report->forced_bw = rd.Varint();
+  report->ms_sleep = rd.Varint();
+
+  if (!rd.mOk) {
+    return nullptr;
+  }
+
+  SplitHost(report->host, report->server_name, report->server_domain);
+  std::string sec_host_full = report->sec_host;
+  SplitHost(sec_host_full, report->sec_host, report->sec_domain);
+  return report;
+}
+
 /*----------------------------------------------------------------------------*/
 
 EOSCOMMONNAMESPACE_END
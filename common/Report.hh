@@ -38,6 +38,8 @@
 #include "XrdOuc/XrdOucEnv.hh"
 #include "XrdOuc/XrdOucString.hh"
 /*----------------------------------------------------------------------------*/
+#include <cstring>
+#include <memory>
 #include <vector>
 #include <string>
 /*----------------------------------------------------------------------------*/
@@ -64,6 +66,7 @@ public:
   unsigned long long ctms; //< ms of close
   std::string logid;       //< logid
   std::string path;        //< logical path or replicate:<fid>
+  std::string fstpath;     //< physical path on the FST
   uid_t uid;               //< user id
   gid_t gid;               //< group id
   std::string td;          //< trace identifier
@@ -110,6 +113,12 @@ public:
   float wt;                ///< disk time spent for write
   unsigned long long osize;//< size when file was opened
   unsigned long long csize;//< size when file was closed
+  int delete_on_close;     //< file was deleted on close
+  int prio_c;              //< io priority class
+  int prio_l;              //< io priority level
+  int prio_d;              //< io priority is the default one
+  int forced_bw;           //< forced bandwidth
+  unsigned long long ms_sleep; //< time slept for bandwidth limitation
 
   // deletion specific entries
   unsigned long long dsize; //< size of a delete file
@@ -150,6 +159,39 @@ public:
   //! Dump the report contents into a string
   // ---------------------------------------------------------------------------
   void Dump(XrdOucString& out, bool dumpsec = false, bool dumptpc = false);
+
+  // ---------------------------------------------------------------------------
+  //! Serialize the report in the env format understood by the constructor
+  // ---------------------------------------------------------------------------
+  std::string ToEnvString() const;
+
+  // ---------------------------------------------------------------------------
+  //! Serialize the report in the compact binary format. The fields are
+  //! written in a fixed order without keys, integers as varints. The result
+  //! is base64 encoded and carries the sBinaryPrefix so that it can travel
+  //! as a message body and be told apart from an env report.
+  // ---------------------------------------------------------------------------
+  std::string ToBinary() const;
+
+  // ---------------------------------------------------------------------------
+  //! Check if the given report body is in the compact binary format
+  // ---------------------------------------------------------------------------
+  static bool IsBinary(const std::string& body)
+  {
+    return (body.compare(0, strlen(sBinaryPrefix), sBinaryPrefix) == 0);
+  }
+
+  // ---------------------------------------------------------------------------
+  //! Build a report from its compact binary representation
+  //!
+  //! @param body binary representation including the prefix
+  //!
+  //! @return report object or nullptr if decoding failed
+  // ---------------------------------------------------------------------------
+  static std::unique_ptr<Report> FromBinary(const std::string& body);
+
+  //! Prefix of reports in compact binary format
+  static constexpr const char* sBinaryPrefix = "eosrb1:";
 };
 
 /*----------------------------------------------------------------------------*/
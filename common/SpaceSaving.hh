@@ -0,0 +1,276 @@
+// ----------------------------------------------------------------------
+//! @file SpaceSaving.hh
+//! @brief Bounded-memory heavy-hitters (top-K) sketch
+// ----------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "common/Namespace.hh"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+EOSCOMMONNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Space-Saving heavy-hitters sketch (Metwally et al.) keeping at most
+//! "capacity" counters. The counters are organized as a min-heap indexed by
+//! a hash map so that an update costs one hash lookup plus a sift over a heap
+//! of constant (small) size. When a new key arrives and the sketch is full,
+//! the key with the minimum count is evicted and the newcomer inherits its
+//! count as over-estimation error.
+//!
+//! Any key whose real weight is larger than total_weight / capacity is
+//! guaranteed to be present in the sketch.
+//!
+//! Decay() divides all the counters by 2^shift which keeps the heap order
+//! intact and can be used to implement exponentially decaying windows.
+//!
+//! Not thread-safe, the caller is expected to provide the locking.
+//------------------------------------------------------------------------------
+template <typename Key, typename Hash = std::hash<Key>>
+class SpaceSaving
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Entry reported by the sketch
+  //----------------------------------------------------------------------------
+  struct Entry {
+    Key key;
+    uint64_t count; ///< Estimated weight (upper bound)
+    uint64_t error; ///< Maximum over-estimation included in count
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity maximum number of tracked keys
+  //----------------------------------------------------------------------------
+  explicit SpaceSaving(size_t capacity = 64):
+    mCapacity(capacity ? capacity : 1), mTotal(0)
+  {
+    mHeap.reserve(mCapacity);
+    mIndex.reserve(mCapacity);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Account weight for the given key
+  //----------------------------------------------------------------------------
+  void Add(const Key& key, uint64_t weight = 1)
+  {
+    if (weight == 0) {
+      return;
+    }
+
+    mTotal += weight;
+    auto it = mIndex.find(key);
+
+    if (it != mIndex.end()) {
+      size_t pos = it->second;
+      mHeap[pos].count += weight;
+      SiftDown(pos);
+      return;
+    }
+
+    if (mHeap.size() < mCapacity) {
+      mHeap.push_back(Entry{key, weight, 0});
+      mIndex[key] = mHeap.size() - 1;
+      SiftUp(mHeap.size() - 1);
+      return;
+    }
+
+    // Replace the minimum which sits at the root of the heap
+    Entry& min = mHeap[0];
+    mIndex.erase(min.key);
+    min.error = min.count;
+    min.count += weight;
+    min.key = key;
+    mIndex[key] = 0;
+    SiftDown(0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Decay all counters by dividing them with 2^shift. Counters reaching
+  //! zero are dropped from the sketch.
+  //----------------------------------------------------------------------------
+  void Decay(unsigned int shift = 1)
+  {
+    if (shift == 0) {
+      return;
+    }
+
+    if (shift >= 64) {
+      Clear();
+      return;
+    }
+
+    mTotal >>= shift;
+    std::vector<Entry> kept;
+    kept.reserve(mHeap.size());
+
+    for (auto& entry : mHeap) {
+      entry.count >>= shift;
+      entry.error >>= shift;
+
+      if (entry.count) {
+        kept.push_back(std::move(entry));
+      }
+    }
+
+    if (kept.size() != mHeap.size()) {
+      // Dropping entries breaks the positions, rebuild the heap and the index
+      mHeap.swap(kept);
+      std::make_heap(mHeap.begin(), mHeap.end(), [](const Entry & a,
+      const Entry & b) {
+        return a.count > b.count;
+      });
+      mIndex.clear();
+
+      for (size_t i = 0; i < mHeap.size(); ++i) {
+        mIndex[mHeap[i].key] = i;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the top "max_entries" keys sorted by decreasing count. Only the
+  //! tracked counters are sorted i.e. at most "capacity" entries.
+  //----------------------------------------------------------------------------
+  std::vector<Entry> GetTop(size_t max_entries) const
+  {
+    std::vector<Entry> result(mHeap.begin(), mHeap.end());
+    size_t n = std::min(max_entries, result.size());
+    std::partial_sort(result.begin(), result.begin() + n, result.end(),
+    [](const Entry & a, const Entry & b) {
+      return a.count > b.count;
+    });
+    result.resize(n);
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get estimated count for the given key, 0 if not tracked
+  //----------------------------------------------------------------------------
+  uint64_t GetCount(const Key& key) const
+  {
+    auto it = mIndex.find(key);
+    return (it == mIndex.end()) ? 0 : mHeap[it->second].count;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of tracked keys
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mHeap.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get maximum number of tracked keys
+  //----------------------------------------------------------------------------
+  inline size_t Capacity() const
+  {
+    return mCapacity;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the (decayed) total weight accounted so far
+  //----------------------------------------------------------------------------
+  inline uint64_t Total() const
+  {
+    return mTotal;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all counters
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    mHeap.clear();
+    mIndex.clear();
+    mTotal = 0;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Move element at pos towards the root while smaller than its parent
+  //----------------------------------------------------------------------------
+  void SiftUp(size_t pos)
+  {
+    while (pos > 0) {
+      size_t parent = (pos - 1) / 2;
+
+      if (mHeap[parent].count <= mHeap[pos].count) {
+        break;
+      }
+
+      Swap(pos, parent);
+      pos = parent;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move element at pos towards the leaves while bigger than its children
+  //----------------------------------------------------------------------------
+  void SiftDown(size_t pos)
+  {
+    const size_t sz = mHeap.size();
+
+    while (true) {
+      size_t left = 2 * pos + 1;
+      size_t right = left + 1;
+      size_t smallest = pos;
+
+      if ((left < sz) && (mHeap[left].count < mHeap[smallest].count)) {
+        smallest = left;
+      }
+
+      if ((right < sz) && (mHeap[right].count < mHeap[smallest].count)) {
+        smallest = right;
+      }
+
+      if (smallest == pos) {
+        break;
+      }
+
+      Swap(pos, smallest);
+      pos = smallest;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Swap two heap elements and update the index
+  //----------------------------------------------------------------------------
+  void Swap(size_t a, size_t b)
+  {
+    std::swap(mHeap[a], mHeap[b]);
+    mIndex[mHeap[a].key] = a;
+    mIndex[mHeap[b].key] = b;
+  }
+
+  size_t mCapacity; ///< Max number of counters
+  uint64_t mTotal; ///< Total weight seen
+  std::vector<Entry> mHeap; ///< Min-heap of counters
+  std::unordered_map<Key, size_t, Hash> mIndex; ///< Key to heap position
+};
+
+EOSCOMMONNAMESPACE_END
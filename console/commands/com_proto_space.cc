@@ -427,6 +427,9 @@ void com_space_help()
       << "space config <space-name> space.drainer.node.nfs=<#>                  : configure the number of max draining filesystems per node (Valid only for central drain)  [ default=5 ]\n"
       << "space config <space-name> space.drainer.retries=<#>                   : configure the number of retry for the draining process (Valid only for central drain)     [ default=1 ]\n"
       << "space config <space-name> space.drainer.fs.ntx=<#>                    : configure the number of parallel draining transfers per fs (Valid only for central drain) [ default=5 ]\n"
+      << "space config <space-name> space.drainer.node.maxbw=<MB/s>            : configure the max drain bandwidth out of a node, 0 is unlimited (Valid only for central drain) [ default=0 ]\n"
+      << "space config <space-name> space.drainer.group.maxbw=<MB/s>           : configure the max drain bandwidth into a group, 0 is unlimited (Valid only for central drain) [ default=0 ]\n"
+      << "space config <space-name> space.drainer.link.maxbw=<MB/s>            : configure the max drain bandwidth out of a geotag, 0 is unlimited (Valid only for central drain) [ default=0 ]\n"
       << "space config <space-name> space.groupbalancer=on|off                  : enable/disable the group balancer [ default=off ]\n"
       << "space config <space-name> space.groupbalancer.ntx=<ntx>               : configure the number of parallel group balancer jobs [ default=0 ]\n"
       << "space config <space-name> space.groupbalancer.engine=<std|minmax>     : configure the groupbalancer engine [ default=std ]\n"
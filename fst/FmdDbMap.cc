@@ -61,6 +61,7 @@ FmdDbMapHandler::FmdDbMapHandler()
   mFsMtxMap.set_deleted_key(std::numeric_limits<FileSystem::fsid_t>::max() - 2);
   mFsMtxMap.set_empty_key(std::numeric_limits<FileSystem::fsid_t>::max() - 1);
   mSyncMapMutex.SetBlocking(true);
+  mUseIndex = (getenv("EOS_FST_FMD_INDEX") != nullptr);
 }
 
 //------------------------------------------------------------------------------
@@ -342,6 +343,10 @@ FmdDbMapHandler::SetDBFile(const char* meta_dir, int fsid)
     }
   }
 
+  if (mUseIndex) {
+    LoadIndex(fsid);
+  }
+
   return true;
 }
 
@@ -360,6 +365,18 @@ FmdDbMapHandler::ShutdownDB(eos::common::FileSystem::fsid_t fsid, bool do_lock)
   }
 
   if (mDbMap.count(fsid)) {
+    auto it_batch = mBatches.find(fsid);
+
+    if (it_batch != mBatches.end()) {
+      if (mDbMap[fsid]->endSetSequence() != it_batch->second.mPending) {
+        eos_err("msg=\"failed to commit pending batch\" fsid=%lu", fsid);
+      }
+
+      mBatches.erase(it_batch);
+    }
+
+    mIndexes.erase(fsid);
+
     if (mDbMap[fsid]->detachDb()) {
       delete mDbMap[fsid];
       mDbMap.erase(fsid);
@@ -370,6 +387,76 @@ FmdDbMapHandler::ShutdownDB(eos::common::FileSystem::fsid_t fsid, bool do_lock)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Start grouping the updates of the given file system
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::BeginBatch(eos::common::FileSystem::fsid_t fsid)
+{
+  eos::common::RWMutexWriteLock wr_lock(mMapMutex);
+  auto it_db = mDbMap.find(fsid);
+
+  if ((it_db == mDbMap.end()) || mBatches.count(fsid)) {
+    return false;
+  }
+
+  FsWriteLock fs_wr_lock(fsid);
+  it_db->second->beginSetSequence();
+  mBatches[fsid] = FsBatch();
+  std::call_once(mBatchFlusherStarted, [this]() {
+    mBatchFlusher.reset(&FmdDbMapHandler::FlushOldBatches, this);
+  });
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the number of updates of the given file system waiting to be committed
+//------------------------------------------------------------------------------
+uint64_t
+FmdDbMapHandler::GetPendingBatchSize(eos::common::FileSystem::fsid_t fsid)
+const
+{
+  eos::common::RWMutexReadLock rd_lock(mMapMutex);
+  auto it_batch = mBatches.find(fsid);
+
+  if (it_batch == mBatches.end()) {
+    return 0;
+  }
+
+  FsReadLock fs_rd_lock(fsid);
+  return it_batch->second.mPending;
+}
+
+//------------------------------------------------------------------------------
+// Commit the pending updates of the given file system and stop batching
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::EndBatch(eos::common::FileSystem::fsid_t fsid)
+{
+  eos::common::RWMutexWriteLock wr_lock(mMapMutex);
+  auto it_batch = mBatches.find(fsid);
+
+  if (it_batch == mBatches.end()) {
+    return false;
+  }
+
+  bool done = true;
+  auto it_db = mDbMap.find(fsid);
+
+  if (it_db != mDbMap.end()) {
+    FsWriteLock fs_wr_lock(fsid);
+
+    if (it_db->second->endSetSequence() != it_batch->second.mPending) {
+      eos_err("msg=\"failed to commit batch\" fsid=%lu pending=%llu", fsid,
+              it_batch->second.mPending);
+      done = false;
+    }
+  }
+
+  mBatches.erase(it_batch);
+  return done;
+}
+
 //------------------------------------------------------------------------------
 // Return/create an Fmd struct for the given file/filesystem id for user
 // uid/gid and layout layoutid
@@ -392,8 +479,20 @@ FmdDbMapHandler::LocalGetFmd(eos::common::FileId::fileid_t fid,
     eos::common::FmdHelper valfmd;
     {
       FsReadLock fs_rd_lock(fsid);
+      FmdIndex* index = GetIndex(fsid);
+      FmdIndex::Entry entry;
+      // The index tells whether the record exists without going to the DB
+      bool exists = (!index || index->Get(fid, entry));
+
+      if (exists && index && !force_retrieve && !do_create &&
+          entry.IsInconsistent()) {
+        eos_crit("msg=\"fmd flagged as inconsistent\" fxid=%08llx fsid=%lu "
+                 "size=%llu xs=%08x flags=%x", fid, fsid, entry.mSize,
+                 entry.mXs, entry.mFlags);
+        return nullptr;
+      }
 
-      if (LocalRetrieveFmd(fid, fsid, valfmd)) {
+      if (exists && LocalRetrieveFmd(fid, fsid, valfmd)) {
         std::unique_ptr<eos::common::FmdHelper> fmd {
           new eos::common::FmdHelper()};
 
@@ -519,7 +618,21 @@ FmdDbMapHandler::LocalDeleteFmd(eos::common::FileId::fileid_t fid,
   auto it = mDbMap.find(fsid);
 
   if (it != mDbMap.end()) {
-    (void) mDbMap[fsid]->remove(eos::common::Slice((const char*)&fid, sizeof(fid)));
+    (void) it->second->remove(eos::common::Slice((const char*)&fid, sizeof(fid)));
+    auto it_batch = mBatches.find(fsid);
+
+    // Removals are not visible to lookups before they are committed therefore
+    // commit the pending batch together with the removal
+    if (it_batch != mBatches.end()) {
+      ++it_batch->second.mPending;
+      (void) FlushBatch(fsid, true);
+    }
+
+    FmdIndex* index = GetIndex(fsid);
+
+    if (index) {
+      index->Remove(fid);
+    }
   }
 }
 
@@ -571,6 +684,48 @@ FmdDbMapHandler::Commit(eos::common::FmdHelper* fmd, bool lockit)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Store Fmd structure in the local database
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::LocalPutFmd(eos::common::FileId::fileid_t fid,
+                             eos::common::FileSystem::fsid_t fsid,
+                             const eos::common::FmdHelper& fmd)
+{
+  auto it_db = mDbMap.find(fsid);
+
+  if (it_db == mDbMap.end()) {
+    return false;
+  }
+
+  std::string sval;
+  fmd.mProtoFmd.SerializePartialToString(&sval);
+
+  // While batching this returns the number of buffered updates
+  if (it_db->second->set(eos::common::Slice((const char*)&fid, sizeof(fid)),
+                         sval, "") == (unsigned long) -1) {
+    return false;
+  }
+
+  FmdIndex* index = GetIndex(fsid);
+
+  if (index) {
+    index->Put(fid, GetIndexEntry(fmd));
+  }
+
+  auto it_batch = mBatches.find(fsid);
+
+  if (it_batch != mBatches.end()) {
+    if (it_batch->second.mPending++ == 0) {
+      it_batch->second.mStart = std::chrono::steady_clock::now();
+    }
+
+    return FlushBatch(fsid, false);
+  }
+
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // Update fmd with disk info i.e. physical file extended attributes
 //------------------------------------------------------------------------------
@@ -726,6 +881,7 @@ FmdDbMapHandler::ResetDiskInformation(eos::common::FileSystem::fsid_t fsid)
   FsWriteLock wlock(fsid);
 
   if (mDbMap.count(fsid)) {
+    FmdIndex* index = GetIndex(fsid);
     const eos::common::DbMapTypes::Tkey* k;
     const eos::common::DbMapTypes::Tval* v;
     eos::common::DbMapTypes::Tval val;
@@ -744,6 +900,10 @@ FmdDbMapHandler::ResetDiskInformation(eos::common::FileSystem::fsid_t fsid)
       f.mProtoFmd.SerializeToString(&val.value);
       mDbMap[fsid]->set(*k, val);
       cpt++;
+
+      if (index) {
+        index->Put(f.mProtoFmd.fid(), GetIndexEntry(f));
+      }
     }
 
     // The endSetSequence makes it impossible to know which key is faulty
@@ -770,6 +930,7 @@ FmdDbMapHandler::ResetMgmInformation(eos::common::FileSystem::fsid_t fsid)
   FsWriteLock vlock(fsid);
 
   if (mDbMap.count(fsid)) {
+    FmdIndex* index = GetIndex(fsid);
     const eos::common::DbMapTypes::Tkey* k;
     const eos::common::DbMapTypes::Tval* v;
     eos::common::DbMapTypes::Tval val;
@@ -786,6 +947,10 @@ FmdDbMapHandler::ResetMgmInformation(eos::common::FileSystem::fsid_t fsid)
       f.mProtoFmd.SerializeToString(&val.value);
       mDbMap[fsid]->set(*k, val);
       cpt++;
+
+      if (index) {
+        index->Put(f.mProtoFmd.fid(), GetIndexEntry(f));
+      }
     }
 
     // The endSetSequence makes it impossible to know which key is faulty
@@ -926,6 +1091,8 @@ FmdDbMapHandler::ResyncAllDisk(const char* path,
     return false;
   }
 
+  auto start = std::chrono::steady_clock::now();
+  (void) BeginBatch(fsid);
   FTSENT* node;
   unsigned long long cnt = 0;
 
@@ -950,6 +1117,9 @@ FmdDbMapHandler::ResyncAllDisk(const char* path,
     }
   }
 
+  bool done = EndBatch(fsid);
+  LogResyncRate("disk", fsid, cnt, start);
+
   if (fts_close(tree)) {
     eos_err("fts_close failed");
     free(paths);
@@ -957,7 +1127,7 @@ FmdDbMapHandler::ResyncAllDisk(const char* path,
   }
 
   free(paths);
-  return true;
+  return done;
 }
 
 //------------------------------------------------------------------------------
@@ -1082,6 +1252,8 @@ FmdDbMapHandler::ResyncAllMgm(eos::common::FileSystem::fsid_t fsid,
   std::string dumpentry;
   unlink(tmpfile.c_str());
   unsigned long long cnt = 0;
+  auto start = std::chrono::steady_clock::now();
+  (void) BeginBatch(fsid);
 
   while (std::getline(inFile, dumpentry)) {
     cnt++;
@@ -1132,8 +1304,10 @@ FmdDbMapHandler::ResyncAllMgm(eos::common::FileSystem::fsid_t fsid,
     }
   }
 
+  bool done = EndBatch(fsid);
+  LogResyncRate("mgm", fsid, cnt, start);
   SetSyncStatus(fsid, false);
-  return true;
+  return done;
 }
 
 
@@ -1275,6 +1449,8 @@ FmdDbMapHandler::ResyncAllFromQdb(const QdbContactDetails& contact_details,
   std::list<std::pair<eos::common::FileId::fileid_t,
       folly::Future<eos::ns::FileMdProto>>> files;
 
+  (void) BeginBatch(fsid);
+
   // Pre-fetch the first 1000 files
   while ((it != file_ids.end()) && (num_files < 1000)) {
     ++num_files;
@@ -1349,6 +1525,7 @@ FmdDbMapHandler::ResyncAllFromQdb(const QdbContactDetails& contact_details,
     }
   }
 
+  bool done = EndBatch(fsid);
   double rate = 0;
   auto duration = steady_clock::now() - start;
   auto ms = duration_cast<milliseconds>(duration);
@@ -1360,7 +1537,7 @@ FmdDbMapHandler::ResyncAllFromQdb(const QdbContactDetails& contact_details,
   SetSyncStatus(fsid, false);
   eos_info("msg=\"fsid=%u resynced %llu/%llu files at a rate of %.2f Hz\"",
            fsid, num_files, total, rate);
-  return true;
+  return done;
 }
 
 //------------------------------------------------------------------------------
@@ -1577,6 +1754,12 @@ FmdDbMapHandler::ResetDB(eos::common::FileSystem::fsid_t fsid)
   // Erase the hash entry
   if (mDbMap.count(fsid)) {
     FsWriteLock fs_wr_lock(fsid);
+    (void) FlushBatch(fsid, true);
+    FmdIndex* index = GetIndex(fsid);
+
+    if (index) {
+      index->Clear();
+    }
 
     // Delete in the in-memory hash
     if (!mDbMap[fsid]->clear()) {
@@ -1623,6 +1806,13 @@ FmdDbMapHandler::GetNumFiles(eos::common::FileSystem::fsid_t fsid)
   FsReadLock fs_rd_lock(fsid);
 
   if (mDbMap.count(fsid)) {
+    FmdIndex* index = GetIndex(fsid);
+
+    // The index also accounts for the pending batch
+    if (index) {
+      return index->Size();
+    }
+
     return mDbMap[fsid]->size();
   } else {
     return 0ll;
@@ -1780,6 +1970,153 @@ FmdDbMapHandler::ExcludeUnlinkedLoc(const std::string& slocations)
   return oss.str();
 }
 
+//------------------------------------------------------------------------------
+// Log the throughput of a resync
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::LogResyncRate(const char* source,
+                               eos::common::FileSystem::fsid_t fsid,
+                               uint64_t num_files,
+                               std::chrono::steady_clock::time_point start)
+{
+  using namespace std::chrono;
+  double rate = 0;
+  auto ms = duration_cast<milliseconds>(steady_clock::now() - start);
+
+  if (ms.count()) {
+    rate = (num_files * 1000.0) / (double)ms.count();
+  }
+
+  eos_info("msg=\"fsid=%u resynced %llu files from %s at a rate of %.2f Hz\"",
+           fsid, num_files, source, rate);
+}
+
+//------------------------------------------------------------------------------
+// Build the index entry of the given record
+//------------------------------------------------------------------------------
+FmdIndex::Entry
+FmdDbMapHandler::GetIndexEntry(const eos::common::FmdHelper& fmd)
+{
+  using eos::common::FmdHelper;
+  const auto& proto_fmd = fmd.mProtoFmd;
+  FmdIndex::Entry entry;
+  entry.mSize = proto_fmd.size();
+  entry.mXs = FmdIndex::CompactXs(proto_fmd.checksum());
+
+  // Same conditions under which LocalGetFmd refuses a record
+  if (LayoutId::IsRain(proto_fmd.lid())) {
+    entry.mFlags |= FmdIndex::kRain;
+  }
+
+  if ((proto_fmd.disksize() && (proto_fmd.disksize() != FmdHelper::UNDEF) &&
+       (proto_fmd.disksize() != proto_fmd.size())) ||
+      (proto_fmd.mgmsize() && (proto_fmd.mgmsize() != FmdHelper::UNDEF) &&
+       (proto_fmd.mgmsize() != proto_fmd.size()))) {
+    entry.mFlags |= FmdIndex::kSizeError;
+  }
+
+  if ((proto_fmd.filecxerror() == 1) ||
+      (proto_fmd.mgmchecksum().length() &&
+       (proto_fmd.mgmchecksum() != proto_fmd.checksum()))) {
+    entry.mFlags |= FmdIndex::kXsError;
+  }
+
+  if (proto_fmd.blockcxerror() == 1) {
+    entry.mFlags |= FmdIndex::kBlockXsError;
+  }
+
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// Load the index of the given file system from the DB
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::LoadIndex(eos::common::FileSystem::fsid_t fsid)
+{
+  using namespace std::chrono;
+  auto it_db = mDbMap.find(fsid);
+
+  if (it_db == mDbMap.end()) {
+    return;
+  }
+
+  auto start = steady_clock::now();
+  std::unique_ptr<FmdIndex> index {new FmdIndex()};
+  const eos::common::DbMapTypes::Tkey* k;
+  const eos::common::DbMapTypes::Tval* v;
+  eos::common::DbMap* db_map = it_db->second;
+  index->Reserve(db_map->size());
+
+  for (db_map->beginIter(false); db_map->iterate(&k, &v, false);) {
+    eos::common::FmdHelper f;
+    eos::common::FileId::fileid_t fid {0ul};
+    f.mProtoFmd.ParseFromString(v->value);
+    (void)memcpy(&fid, (void*)k->data(), std::min(k->size(), sizeof(fid)));
+    index->Put(fid, GetIndexEntry(f));
+  }
+
+  eos_info("msg=\"loaded fmd index\" fsid=%lu entries=%llu duration_ms=%llu",
+           fsid, index->Size(), duration_cast<milliseconds>
+           (steady_clock::now() - start).count());
+  mIndexes[fsid] = std::move(index);
+}
+
+//------------------------------------------------------------------------------
+// Commit the pending batch of the given file system if it is full or too old
+//------------------------------------------------------------------------------
+bool
+FmdDbMapHandler::FlushBatch(eos::common::FileSystem::fsid_t fsid, bool force)
+{
+  auto it_batch = mBatches.find(fsid);
+  auto it_db = mDbMap.find(fsid);
+
+  if ((it_batch == mBatches.end()) || (it_db == mDbMap.end())) {
+    return true;
+  }
+
+  FsBatch& batch = it_batch->second;
+
+  if ((batch.mPending == 0) ||
+      (!force && (batch.mPending < sBatchSize) &&
+       (std::chrono::steady_clock::now() - batch.mStart < sBatchMaxAge))) {
+    return true;
+  }
+
+  // All the updates of the batch are written with one atomic write
+  bool done = (it_db->second->endSetSequence() == batch.mPending);
+
+  if (!done) {
+    eos_err("msg=\"failed to commit batch\" fsid=%lu pending=%llu", fsid,
+            batch.mPending);
+  }
+
+  batch.mPending = 0;
+  it_db->second->beginSetSequence();
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Loop committing the pending batches older than sBatchMaxAge
+//------------------------------------------------------------------------------
+void
+FmdDbMapHandler::FlushOldBatches(ThreadAssistant& assistant)
+{
+  eos_info("%s", "msg=\"starting fmd batch flusher\"");
+
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(sBatchCheckInterval);
+    eos::common::RWMutexReadLock rd_lock(mMapMutex);
+
+    for (const auto& elem : mBatches) {
+      FsWriteLock fs_wr_lock(elem.first);
+      (void) FlushBatch(elem.first, false);
+    }
+  }
+
+  eos_info("%s", "msg=\"stopped fmd batch flusher\"");
+}
+
 //------------------------------------------------------------------------------
 // Check if given file system is currently syncing
 //------------------------------------------------------------------------------
@@ -23,13 +23,17 @@
 
 #pragma once
 #include "fst/Namespace.hh"
+#include "fst/FmdIndex.hh"
 #include "common/Fmd.hh"
 #include "common/DbMap.hh"
 #include "common/FileId.hh"
 #include "common/LayoutId.hh"
+#include "common/AssistedThread.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "namespace/interface/IFileMD.hh"
 #include "namespace/ns_quarkdb/FileMD.hh"
+#include <chrono>
+#include <mutex>
 
 #ifdef __APPLE__
 #define ECOMM 70
@@ -121,6 +125,7 @@ public:
   //----------------------------------------------------------------------------
   virtual ~FmdDbMapHandler()
   {
+    mBatchFlusher.join();
     Shutdown();
 
     for (auto it = mFsMtxMap.begin(); it != mFsMtxMap.end(); ++it) {
@@ -150,6 +155,41 @@ public:
   //----------------------------------------------------------------------------
   bool ShutdownDB(eos::common::FileSystem::fsid_t fsid, bool do_lock = false);
 
+  //----------------------------------------------------------------------------
+  //! Start grouping the updates of the given file system. The updates are
+  //! buffered and committed to the DB as one atomic write batch once
+  //! sBatchSize updates are pending or the oldest one is sBatchMaxAge old.
+  //! The age is checked on every update and by a background thread, so that
+  //! the batch is also committed when the updates stop. Lookups see the
+  //! pending updates. A crash loses at most the pending batch, never part
+  //! of it.
+  //!
+  //! @param fsid file system id
+  //!
+  //! @return true if successful, false if the DB is not open or already
+  //!         batching
+  //----------------------------------------------------------------------------
+  bool BeginBatch(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Commit the pending updates of the given file system and stop batching
+  //!
+  //! @param fsid file system id
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool EndBatch(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the number of updates of the given file system waiting to be
+  //! committed
+  //!
+  //! @param fsid file system id
+  //!
+  //! @return number of pending updates, 0 if not batching
+  //----------------------------------------------------------------------------
+  uint64_t GetPendingBatchSize(eos::common::FileSystem::fsid_t fsid) const;
+
   // Meta data handling functions
 
   //----------------------------------------------------------------------------
@@ -456,6 +496,21 @@ public:
   bool IsSyncing(eos::common::FileSystem::fsid_t fsid) const;
 
 private:
+  //! Max number of updates committed in one batch
+  static constexpr uint64_t sBatchSize = 10000;
+  //! Max time an update stays in the pending batch
+  static constexpr std::chrono::milliseconds sBatchMaxAge {1000};
+  //! Interval at which the background thread checks the age of the batches
+  static constexpr std::chrono::milliseconds sBatchCheckInterval {250};
+
+  //----------------------------------------------------------------------------
+  //! Pending batch of a file system
+  //----------------------------------------------------------------------------
+  struct FsBatch {
+    uint64_t mPending {0}; ///< Number of buffered updates
+    std::chrono::steady_clock::time_point mStart; ///< Time of first update
+  };
+
   std::map<eos::common::FileSystem::fsid_t, eos::common::DbMap*> mDbMap;
   mutable eos::common::RWMutex mMapMutex; ///< Mutex protecting the Fmd handler
   eos::common::LvDbDbMapInterface::Option lvdboption;
@@ -466,6 +521,82 @@ private:
   google::dense_hash_map<eos::common::FileSystem::fsid_t, eos::common::RWMutex*>
   mFsMtxMap;
   eos::common::RWMutex mFsMtxMapMutex; ///< Mutex protecting the previous map
+  //! Batches of the file systems currently batching, the map is protected by
+  //! the mMapMutex and each batch by the mutex of its file system
+  std::map<eos::common::FileSystem::fsid_t, FsBatch> mBatches;
+  //! Thread committing the batches which got too old, started by the first
+  //! batch
+  AssistedThread mBatchFlusher;
+  std::once_flag mBatchFlusherStarted;
+  //! If true keep an in-memory index of the records of each file system
+  bool mUseIndex {false};
+  //! Indexes of the file systems, protected like the batches
+  std::map<eos::common::FileSystem::fsid_t, std::unique_ptr<FmdIndex>> mIndexes;
+
+  //----------------------------------------------------------------------------
+  //! Log the throughput of a resync
+  //!
+  //! @param source source of the resync i.e. disk, mgm
+  //! @param fsid file system id
+  //! @param num_files number of files resynced
+  //! @param start start time of the resync
+  //----------------------------------------------------------------------------
+  void LogResyncRate(const char* source, eos::common::FileSystem::fsid_t fsid,
+                     uint64_t num_files,
+                     std::chrono::steady_clock::time_point start);
+
+  //----------------------------------------------------------------------------
+  //! Build the index entry of the given record
+  //!
+  //! @param fmd Fmd record
+  //!
+  //! @return index entry
+  //----------------------------------------------------------------------------
+  static FmdIndex::Entry GetIndexEntry(const eos::common::FmdHelper& fmd);
+
+  //----------------------------------------------------------------------------
+  //! Load the index of the given file system from the DB
+  //!
+  //! @param fsid file system id
+  //! @note this function must be called with the mMapMutex write locked and
+  //! also the mutex corresponding to the filesystem locked
+  //----------------------------------------------------------------------------
+  void LoadIndex(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get the index of the given file system
+  //!
+  //! @param fsid file system id
+  //!
+  //! @return index or nullptr if indexing is disabled
+  //! @note this function must be called with the mMapMutex locked
+  //----------------------------------------------------------------------------
+  FmdIndex* GetIndex(eos::common::FileSystem::fsid_t fsid) const
+  {
+    auto it = mIndexes.find(fsid);
+    return ((it == mIndexes.end()) ? nullptr : it->second.get());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Commit the pending batch of the given file system if it is full or too
+  //! old and start a new one
+  //!
+  //! @param fsid file system id
+  //! @param force if true commit even if the batch is neither full nor old
+  //!
+  //! @return true if successful, otherwise false
+  //! @note this function must be called with the mMapMutex locked and also the
+  //! mutex corresponding to the filesystem write locked
+  //----------------------------------------------------------------------------
+  bool FlushBatch(eos::common::FileSystem::fsid_t fsid, bool force);
+
+  //----------------------------------------------------------------------------
+  //! Loop committing the pending batches older than sBatchMaxAge even if no
+  //! more updates arrive
+  //!
+  //! @param assistant thread executing the loop
+  //----------------------------------------------------------------------------
+  void FlushOldBatches(ThreadAssistant& assistant);
 
   //----------------------------------------------------------------------------
   //! Set syncing status of the given file system
@@ -505,15 +636,18 @@ private:
   _FsLock(const eos::common::FileSystem::fsid_t& fsid, bool write)
   {
     mFsMtxMapMutex.LockRead();
+    auto it_mtx = mFsMtxMap.find(fsid);
+
+    if (it_mtx != mFsMtxMap.end()) {
+      eos::common::RWMutex* mtx = it_mtx->second;
+      mFsMtxMapMutex.UnLockRead();
 
-    if (mFsMtxMap.count(fsid)) {
+      // The mutexes are never removed from the map before the destructor
       if (write) {
-        mFsMtxMap[fsid]->LockWrite();
+        mtx->LockWrite();
       } else {
-        mFsMtxMap[fsid]->LockRead();
+        mtx->LockRead();
       }
-
-      mFsMtxMapMutex.UnLockRead();
     } else {
       mFsMtxMapMutex.UnLockRead();
       eos::common::RWMutexWriteLock wr_lock(mFsMtxMapMutex);
@@ -602,23 +736,11 @@ private:
   //!
   //! @return true if successful, otherwise false
   //! @note this function must be called with the mMapMutex locked and also the
-  //! mutex corresponding to the filesystem locked
+  //! mutex corresponding to the filesystem write locked
   //----------------------------------------------------------------------------
   bool LocalPutFmd(eos::common::FileId::fileid_t fid,
                    eos::common::FileSystem::fsid_t fsid,
-                   const eos::common::FmdHelper& fmd)
-  {
-    std::string sval;
-    fmd.mProtoFmd.SerializePartialToString(&sval);
-    auto it_db = mDbMap.find(fsid);
-
-    if (it_db != mDbMap.end()) {
-      return it_db->second->set(eos::common::Slice((const char*)&fid, sizeof(fid)),
-                                sval, "") == 0;
-    } else {
-      return false;
-    }
-  }
+                   const eos::common::FmdHelper& fmd);
 };
 
 extern FmdDbMapHandler gFmdDbMapHandler;
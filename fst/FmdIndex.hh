@@ -0,0 +1,176 @@
+//------------------------------------------------------------------------------
+//! @file FmdIndex.hh
+//! @brief Compact in-memory index of the file metadata of a file system
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class FmdIndex - keeps for every file id of a file system the reference
+//! size, the leading bytes of the reference checksum and the consistency
+//! flags of its local Fmd record. The index mirrors the local DB so that
+//! lookups for records which don't exist or which are flagged as
+//! inconsistent don't need to go to the DB. An entry takes about 48 bytes
+//! including the hash table overhead.
+//!
+//! @note the index is not thread-safe, the caller serializes the access with
+//! the mutex of the file system
+//------------------------------------------------------------------------------
+class FmdIndex
+{
+public:
+  //! Consistency flags of a record
+  enum Flags : uint32_t {
+    kSizeError = 0x1, ///< Disk or MGM size differs from the reference size
+    kXsError = 0x2, ///< File checksum error or MGM checksum mismatch
+    kBlockXsError = 0x4, ///< Block checksum error
+    kRain = 0x8 ///< Stripe of a RAIN layout
+  };
+
+  //----------------------------------------------------------------------------
+  //! Index entry
+  //----------------------------------------------------------------------------
+  struct Entry {
+    uint64_t mSize {0}; ///< Reference size
+    uint32_t mXs {0}; ///< First 4 bytes of the reference checksum
+    uint32_t mFlags {0}; ///< Consistency flags
+
+    //--------------------------------------------------------------------------
+    //! Check if the record is to be refused to a regular lookup i.e. a
+    //! lookup which neither forces the retrieval nor creates the record
+    //--------------------------------------------------------------------------
+    bool IsInconsistent() const
+    {
+      if (mFlags & kRain) {
+        return (mFlags & kBlockXsError);
+      }
+
+      return (mFlags & (kSizeError | kXsError));
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  //! Convert the leading digits of a hex checksum to the compact form
+  //!
+  //! @param xs_hex checksum in hex format
+  //!
+  //! @return value of the first 8 hex digits, 0 if not a hex string
+  //----------------------------------------------------------------------------
+  static uint32_t CompactXs(const std::string& xs_hex)
+  {
+    uint32_t xs = 0;
+
+    for (size_t i = 0; (i < 8) && (i < xs_hex.length()); ++i) {
+      const char c = xs_hex[i];
+      uint32_t digit;
+
+      if ((c >= '0') && (c <= '9')) {
+        digit = c - '0';
+      } else if ((c >= 'a') && (c <= 'f')) {
+        digit = c - 'a' + 10;
+      } else if ((c >= 'A') && (c <= 'F')) {
+        digit = c - 'A' + 10;
+      } else {
+        return 0;
+      }
+
+      xs = (xs << 4) | digit;
+    }
+
+    return xs;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Reserve space for the given number of entries
+  //----------------------------------------------------------------------------
+  void Reserve(uint64_t num_entries)
+  {
+    mEntries.reserve(num_entries);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add or update entry
+  //!
+  //! @param fid file id
+  //! @param entry index entry
+  //----------------------------------------------------------------------------
+  void Put(uint64_t fid, const Entry& entry)
+  {
+    mEntries[fid] = entry;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get entry
+  //!
+  //! @param fid file id
+  //! @param entry index entry populated if found
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  bool Get(uint64_t fid, Entry& entry) const
+  {
+    auto it = mEntries.find(fid);
+
+    if (it == mEntries.end()) {
+      return false;
+    }
+
+    entry = it->second;
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove entry
+  //!
+  //! @param fid file id
+  //----------------------------------------------------------------------------
+  void Remove(uint64_t fid)
+  {
+    mEntries.erase(fid);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove all entries
+  //----------------------------------------------------------------------------
+  void Clear()
+  {
+    mEntries.clear();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of entries
+  //----------------------------------------------------------------------------
+  uint64_t Size() const
+  {
+    return mEntries.size();
+  }
+
+private:
+  std::unordered_map<uint64_t, Entry> mEntries;
+};
+
+EOSFSTNAMESPACE_END
@@ -50,7 +50,7 @@ Messaging::Listen(ThreadAssistant& assistant) noexcept
 
     if (new_msg) {
       Process(new_msg.get());
-    } else {
+    } else if (!XrdMqMessaging::gMessageClient.HasLongPolled()) {
       assistant.wait_for(std::chrono::seconds(2));
     }
   }
@@ -33,6 +33,7 @@
 #include "fst/storage/FileSystem.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
 #include "fst/io/FileIoPluginCommon.hh"
+#include "fst/io/CopyPipeline.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
 #include "qclient/structures/QSet.hh"
 #include <sys/stat.h>
@@ -805,48 +806,71 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
 
   int64_t nread = 0;
   off_t offset = 0;
-  uint64_t open_ts_sec = std::chrono::duration_cast<std::chrono::seconds>
-                         (mClock.getTime().time_since_epoch()).count();
+  uint64_t open_ts_ms = std::chrono::duration_cast<std::chrono::milliseconds>
+                        (mClock.getTime().time_since_epoch()).count();
+  bool drop_cache = true;
+#ifndef _NOOFS
 
-  do {
-    nread = io->fileRead(offset, mBuffer, mBufferSize);
+  if (mBgThread) {
+    // Don't evict the pages of a file that is being read by a client
+    auto fid = eos::common::FileId::PathToFid(file_path.c_str());
+    drop_cache = !gOFS.openedForReading.isOpen(mFsId, fid);
+  }
 
-    if (nread < 0) {
-      if (blockXS) {
-        blockXS->CloseMap();
+#endif
+  auto consume = [&](uint64_t off, const char* buff, uint32_t len) {
+    if (blockXS && (blockxs_err == false)) {
+      if (!blockXS->CheckBlockSum(off, buff, len)) {
+        blockxs_err = true;
       }
+    }
 
-      eos_err("msg=\"failed read\" offset=%llu path=%s", offset,
-              file_path.c_str());
-      return false;
+    if (comp_file_xs) {
+      comp_file_xs->Add(buff, len, off);
     }
 
-    if (nread) {
-      if (nread > mBufferSize) {
-        eos_err("msg=\"read returned more than the buffer size\" buff_sz=%llu "
-                "nread=%lli\"", mBufferSize, nread);
+    // Scanned data is not read again soon, keep the page cache for the
+    // client traffic
+    if (drop_cache) {
+      io->fileDropCache(off, len);
+    }
 
-        if (blockXS) {
-          blockXS->CloseMap();
-        }
+    offset = off + len;
+    EnforceAndAdjustScanRate(offset, open_ts_ms, scan_rate);
+    return true;
+  };
 
-        return false;
-      }
+  if (info.st_size < (off_t) mBufferSize) {
+    // Small files need a read or two, not worth a reader thread
+    do {
+      nread = io->fileRead(offset, mBuffer, mBufferSize);
 
-      if (blockXS && (blockxs_err == false)) {
-        if (!blockXS->CheckBlockSum(offset, mBuffer, nread)) {
-          blockxs_err = true;
-        }
-      }
-
-      if (comp_file_xs) {
-        comp_file_xs->Add(mBuffer, nread, offset);
+      if (nread > 0) {
+        consume(offset, mBuffer, nread);
       }
+    } while (nread == mBufferSize);
+  } else {
+    // Read the next block while the current one is checksummed
+    CopyPipeline pipeline(mBufferSize, sReadAheadBlocks);
+    auto read = [&io](uint64_t off, char* buff, uint32_t len) -> int64_t {
+      return io->fileRead(off, buff, len);
+    };
+
+    if (pipeline.Run(0, -1, read, consume)) {
+      nread = -1;
+      offset = pipeline.GetFailedOffset();
+    }
+  }
 
-      offset += nread;
-      EnforceAndAdjustScanRate(offset, open_ts_sec, scan_rate);
+  if (nread < 0) {
+    if (blockXS) {
+      blockXS->CloseMap();
     }
-  } while (nread == mBufferSize);
+
+    eos_err("msg=\"failed read\" offset=%llu path=%s", offset,
+            file_path.c_str());
+    return false;
+  }
 
   scan_size = (unsigned long long) offset;
 
@@ -895,23 +919,26 @@ ScanDir::ScanFileLoadAware(const std::unique_ptr<eos::fst::FileIo>& io,
 //------------------------------------------------------------------------------
 void
 ScanDir::EnforceAndAdjustScanRate(const off_t offset,
-                                  const uint64_t open_ts_sec,
+                                  const uint64_t open_ts_ms,
                                   int& scan_rate)
 {
   using namespace std::chrono;
 
   if (scan_rate && mFstLoad) {
-    uint64_t now_ts_sec = duration_cast<seconds>
-                          (mClock.getTime().time_since_epoch()).count();
-    uint64_t scan_duration = now_ts_sec - open_ts_sec;
-    uint64_t expect_duration = (uint64_t)((1.0 * offset) /
-                                          (scan_rate * 1024 * 1024));
+    uint64_t now_ts_ms = duration_cast<milliseconds>
+                         (mClock.getTime().time_since_epoch()).count();
+    uint64_t scan_duration_ms = now_ts_ms - open_ts_ms;
+    uint64_t expect_duration_ms = (uint64_t)((1000.0 * offset) /
+                                  (scan_rate * 1024 * 1024));
 
-    if (expect_duration > scan_duration) {
-      std::this_thread::sleep_for(milliseconds(expect_duration - scan_duration));
+    if (expect_duration_ms > scan_duration_ms) {
+      std::this_thread::sleep_for(milliseconds(expect_duration_ms -
+                                  scan_duration_ms));
     }
 
-    // Adjust the rate according to the load information
+    // Adjust the rate according to the measured device utilization: back off
+    // quickly when the disk is busy and recover gradually, so that the rate
+    // does not oscillate between the minimum and the configured maximum
     double load = mFstLoad->GetDiskRate(mDirPath.c_str(), "millisIO") / 1000.0;
 
     if (load > 0.7) {
@@ -919,7 +946,11 @@ ScanDir::EnforceAndAdjustScanRate(const off_t offset,
       if (scan_rate > 5) {
         scan_rate = 0.9 * scan_rate;
       }
-    } else {
+    } else if (load < 0.5) {
+      scan_rate = scan_rate + std::max(1, scan_rate / 10);
+    }
+
+    if (scan_rate > mRateBandwidth) {
       scan_rate = mRateBandwidth;
     }
   }
@@ -121,7 +121,10 @@ public:
   GetBlockXS(const std::string& file_path);
 
   //----------------------------------------------------------------------------
-  //! Scan the given file for checksum errors taking the load into consideration
+  //! Scan the given file for checksum errors taking the load into consideration.
+  //! Files larger than the read buffer are read ahead by a separate thread
+  //! while the checksums are computed, and the scanned pages are dropped from
+  //! the page cache unless a client has the file open for reading.
   //!
   //! @param io io object attached to the file
   //! @param scan_size final scan size
@@ -160,14 +163,16 @@ public:
 
   //----------------------------------------------------------------------------
   //! Enforce the scan rate by throttling the current thread and also adjust it
-  //! depending on the IO load on the mountpoint
+  //! depending on the IO load on the mountpoint - the rate drops by 10% while
+  //! the device is more than 70% busy and recovers by 10% while it is less
+  //! than 50% busy
   //!
   //! @param offset current offset in file
-  //! @param open_ts_sec open timestamp in seconds from epoch
+  //! @param open_ts_ms open timestamp in milliseconds from epoch
   //! @param scan_rate current scan rate, if 0 then then rate limiting is
   //!        disabled
   //----------------------------------------------------------------------------
-  void EnforceAndAdjustScanRate(const off_t offset, const uint64_t open_ts_sec,
+  void EnforceAndAdjustScanRate(const off_t offset, const uint64_t open_ts_ms,
                                 int& scan_rate);
 
 #ifndef _NOOFS
@@ -196,6 +201,9 @@ public:
   //! Default ns scan rate is bound by the number of IO ops a disk can handle
   //! and we set it to half the average max IOOPS for HDD which is 100.
   static constexpr unsigned long long sDefaultNsScanRate {50};
+  //! Number of read buffers used when scanning a file, one being read while
+  //! the other one is checksummed
+  static constexpr uint32_t sReadAheadBlocks {2};
 
   //----------------------------------------------------------------------------
   //! Check if file is unlinked from the namespace and in the process of being
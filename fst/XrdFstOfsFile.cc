@@ -44,6 +44,7 @@ EOSFSTNAMESPACE_BEGIN
 
 constexpr uint64_t XrdFstOfsFile::msMinSizeAsyncClose;
 constexpr uint16_t XrdFstOfsFile::msDefaultTimeout;
+constexpr uint64_t XrdFstOfsFile::msHotBytesChunk;
 
 //------------------------------------------------------------------------------
 // Constructor
@@ -749,6 +750,7 @@ XrdFstOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
 
     rOffset = fileOffset + rc;
     totalBytes += rc;
+    AccountHotBytes(mHotReadBytes, gOFS.openedForReading, rc);
   }
 
   gettimeofday(&lrTime, &tz);
@@ -808,8 +810,13 @@ XrdFstOfsFile::readv(XrdOucIOVec* readV, int readCount)
                                          (void*)readV[i].data));
   }
 
-  uint64_t rv = mLayout->ReadV(chunkList, total_read);
-  totalBytes += rv;
+  int64_t rv = mLayout->ReadV(chunkList, total_read);
+
+  if (rv > 0) {
+    totalBytes += rv;
+    AccountHotBytes(mHotReadBytes, gOFS.openedForReading, rv);
+  }
+
   return rv;
 }
 
@@ -913,6 +920,7 @@ XrdFstOfsFile::write(XrdSfsFileOffset fileOffset, const char* buffer,
     }
 
     totalBytes += rc;
+    AccountHotBytes(mHotWriteBytes, gOFS.openedForWriting, rc);
 
     if (static_cast<unsigned long long>(fileOffset + buffer_size) >
         static_cast<unsigned long long>(mMaxOffsetWritten)) {
@@ -1701,6 +1709,9 @@ XrdFstOfsFile::_close()
         gOFS.openedForReading.down(mFmd->mProtoFmd.fsid(), mFmd->mProtoFmd.fid());
       }
 
+      AccountHotBytes(mHotReadBytes, gOFS.openedForReading, 0, true);
+      AccountHotBytes(mHotWriteBytes, gOFS.openedForWriting, 0, true);
+
       if (!gOFS.openedForWriting.isOpen(mFmd->mProtoFmd.fsid(),
                                         mFmd->mProtoFmd.fid())) {
         // When the last writer is gone we can remove the prohibiting entry
@@ -2929,6 +2940,26 @@ XrdFstOfsFile::ProcessTpcOpaque(std::string& opaque, const XrdSecEntity* client)
   return SFS_OK;
 }
 
+//------------------------------------------------------------------------------
+// Account bytes transferred in the hot files by bytes sketch
+//------------------------------------------------------------------------------
+void
+XrdFstOfsFile::AccountHotBytes(std::atomic<uint64_t>& pending,
+                               OpenFileTracker& tracker, uint64_t bytes,
+                               bool flush)
+{
+  if ((pending.fetch_add(bytes) + bytes < msHotBytesChunk) && !flush) {
+    return;
+  }
+
+  // Only one of the concurrent callers gets the collected bytes
+  uint64_t collected = pending.exchange(0);
+
+  if (collected) {
+    tracker.addBytes(mFsId, mFileId, collected);
+  }
+}
+
 //------------------------------------------------------------------------------
 // Account for total read time
 //------------------------------------------------------------------------------
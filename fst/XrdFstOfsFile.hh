@@ -27,6 +27,7 @@
 #include "fst/storage/Storage.hh"
 #include "fst/checksum/CheckSum.hh"
 #include "fst/utils/TpcInfo.hh"
+#include "fst/utils/OpenFileTracker.hh"
 #include "common/Fmd.hh"
 #include "common/FileId.hh"
 #include "common/SymKeys.hh"
@@ -34,6 +35,7 @@
 #include "XrdOfs/XrdOfs.hh"
 #include "XrdOfs/XrdOfsTPCInfo.hh"
 #include "XrdOuc/XrdOucString.hh"
+#include <atomic>
 #include <numeric>
 
 namespace eos
@@ -88,6 +90,8 @@ public:
   //! Minimum file size for which async close is triggered
   static constexpr uint64_t msMinSizeAsyncClose {2u * 1024 * 1024 * 1024}; // 2GB
   static constexpr uint16_t msDefaultTimeout {300};
+  //! Bytes transferred after which they are accounted in the hot files sketch
+  static constexpr uint64_t msHotBytesChunk {4u * 1024 * 1024}; // 4MB
   static int LayoutReadCB(eos::fst::CheckSum::ReadCallBack::callback_data_t* cbd);
   static int FileIoReadCB(eos::fst::CheckSum::ReadCallBack::callback_data_t* cbd);
 
@@ -322,6 +326,9 @@ public:
   std::vector<unsigned long long> wvec;
   unsigned long long rBytes; //! sum bytes read
   unsigned long long wBytes; //! sum bytes written
+  //! Bytes read/written not yet accounted in the hot files by bytes sketch
+  std::atomic<uint64_t> mHotReadBytes {0};
+  std::atomic<uint64_t> mHotWriteBytes {0};
   unsigned long long sFwdBytes; //! sum bytes seeked forward
   unsigned long long sBwdBytes; //! sum bytes seeked backward
   //! sum bytes with large forward seeks (> EOS_FSTOFS_LARGE_SEEKS)
@@ -569,6 +576,19 @@ public:
   //----------------------------------------------------------------------------
   int ProcessMixedOpaque();
 
+  //----------------------------------------------------------------------------
+  //! Account bytes transferred in the hot files by bytes sketch of the given
+  //! tracker. The bytes are forwarded once a chunk of msHotBytesChunk is
+  //! collected so that long lived opens show up before they are closed.
+  //!
+  //! @param pending bytes not yet forwarded to the tracker
+  //! @param tracker open file tracker holding the sketch
+  //! @param bytes number of bytes just transferred
+  //! @param flush if true forward all the pending bytes
+  //----------------------------------------------------------------------------
+  void AccountHotBytes(std::atomic<uint64_t>& pending, OpenFileTracker& tracker,
+                       uint64_t bytes, bool flush = false);
+
   //----------------------------------------------------------------------------
   //! Compute total time to serve read requests
   //----------------------------------------------------------------------------
@@ -0,0 +1,279 @@
+//------------------------------------------------------------------------------
+// File: CopyPipeline.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fst/io/CopyPipeline.hh"
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <thread>
+
+EOSFSTNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Milliseconds elapsed since the given time point
+//------------------------------------------------------------------------------
+inline double
+ElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>
+         (std::chrono::steady_clock::now() - start).count();
+}
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+CopyPipeline::CopyPipeline(uint32_t block_size, uint32_t depth,
+                           uint32_t streams):
+  mBlockSize(block_size),
+  // Every stream needs at least one buffer to make progress
+  mDepth(std::max({depth, streams, 1u})),
+  mStreams(std::max(streams, 1u))
+{}
+
+//------------------------------------------------------------------------------
+// Run the copy
+//------------------------------------------------------------------------------
+int
+CopyPipeline::Run(uint64_t offset, int64_t length, ReadCallback read,
+                  WriteCallback write)
+{
+  const auto start = std::chrono::steady_clock::now();
+  mSlots.resize(mDepth);
+
+  for (auto& slot : mSlots) {
+    slot.mBuffer.resize(mBlockSize);
+    slot.mSeq = UINT64_MAX;
+    slot.mLength = 0;
+    slot.mLast = false;
+  }
+
+  mWritten = 0;
+  // Without digest only the writer holds on to the buffers
+  mDigested = mDigest ? 0 : UINT64_MAX;
+  mLastSeq = UINT64_MAX;
+  mAborted = false;
+  mError = 0;
+  mFailedOffset = 0;
+  mStats = Stats();
+  std::vector<std::thread> readers;
+
+  for (uint32_t i = 0; i < mStreams; ++i) {
+    readers.emplace_back(&CopyPipeline::ReadLoop, this, i, offset, length,
+                         std::cref(read));
+  }
+
+  std::thread digester;
+
+  if (mDigest) {
+    digester = std::thread([this]() {
+      ConsumeLoop(false, [this](uint64_t off, const char* buff, uint32_t len) {
+        mDigest(off, buff, len);
+        return true;
+      }, mDigested);
+    });
+  }
+
+  ConsumeLoop(true, write, mWritten);
+
+  if (digester.joinable()) {
+    digester.join();
+  }
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  mStats.mRealTime = ElapsedMs(start);
+  return mError;
+}
+
+//------------------------------------------------------------------------------
+// Reader loop of the given stream
+//------------------------------------------------------------------------------
+void
+CopyPipeline::ReadLoop(uint32_t stream, uint64_t offset, int64_t length,
+                       const ReadCallback& read)
+{
+  // In sequential mode the next offset depends on the previous read
+  uint64_t pos = offset;
+
+  for (uint64_t seq = stream; ; seq += mStreams) {
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCvFree.wait(lock, [&]() {
+        return mAborted || (seq > mLastSeq) || HasFreeSlot(seq);
+      });
+
+      if (mAborted || (seq > mLastSeq)) {
+        return;
+      }
+    }
+
+    uint64_t done = (mStreams == 1) ? (pos - offset) :
+                    (seq * (uint64_t) mBlockSize);
+
+    if (mStreams != 1) {
+      pos = offset + done;
+    }
+
+    uint32_t len = mBlockSize;
+
+    if (length >= 0) {
+      len = (done >= (uint64_t) length) ? 0 :
+            (uint32_t) std::min<uint64_t>(mBlockSize, length - done);
+    }
+
+    Slot& slot = mSlots[seq % mDepth];
+    int64_t nread = 0;
+    double read_time = 0;
+
+    if (len) {
+      const auto t0 = std::chrono::steady_clock::now();
+      nread = read(pos, slot.mBuffer.data(), len);
+      read_time = ElapsedMs(t0);
+    }
+
+    // A sequential reader goes on after short reads, in parallel mode the
+    // blocks have fixed offsets so a short read is the end of the data
+    const bool last = (nread <= 0) ||
+                      ((mStreams != 1) && (nread < (int64_t) mBlockSize));
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStats.mReadTime += read_time;
+      mStats.mMaxReadLatency = std::max(mStats.mMaxReadLatency, read_time);
+      slot.mSeq = seq;
+      slot.mOffset = pos;
+      slot.mLength = nread;
+      slot.mLast = last;
+
+      if (last && (seq < mLastSeq)) {
+        mLastSeq = seq;
+        mCvFree.notify_all();
+      }
+
+      mCvReady.notify_all();
+    }
+
+    if (last) {
+      return;
+    }
+
+    pos += nread;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Consumer loop
+//------------------------------------------------------------------------------
+void
+CopyPipeline::ConsumeLoop(bool write, const WriteCallback& callback,
+                          uint64_t& consumed)
+{
+  for (uint64_t seq = 0; ; ++seq) {
+    Slot& slot = mSlots[seq % mDepth];
+    int64_t len;
+    bool last;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCvReady.wait(lock, [&]() {
+        return mAborted || (slot.mSeq == seq);
+      });
+
+      if (mAborted) {
+        return;
+      }
+
+      if (slot.mLength < 0) {
+        mFailedOffset = slot.mOffset;
+        Abort(-EIO);
+        return;
+      }
+
+      len = slot.mLength;
+      last = slot.mLast;
+    }
+    double time = 0;
+
+    if (len > 0) {
+      const auto t0 = std::chrono::steady_clock::now();
+
+      if (!callback(slot.mOffset, slot.mBuffer.data(), (uint32_t) len)) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        Abort(-ECANCELED);
+        return;
+      }
+
+      time = ElapsedMs(t0);
+    }
+
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (write) {
+      mStats.mWriteTime += time;
+      mStats.mMaxWriteLatency = std::max(mStats.mMaxWriteLatency, time);
+      mStats.mBytes += len;
+
+      if (len > 0) {
+        ++mStats.mBlocks;
+      }
+    } else {
+      mStats.mDigestTime += time;
+    }
+
+    // Release the buffer
+    ++consumed;
+    mCvFree.notify_all();
+
+    if (last) {
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check if the given block can be stored
+//------------------------------------------------------------------------------
+bool
+CopyPipeline::HasFreeSlot(uint64_t seq) const
+{
+  return seq < std::min(mWritten, mDigested) + mDepth;
+}
+
+//------------------------------------------------------------------------------
+// Abort the copy
+//------------------------------------------------------------------------------
+void
+CopyPipeline::Abort(int error)
+{
+  if (!mAborted) {
+    mAborted = true;
+    mError = error;
+  }
+
+  mCvFree.notify_all();
+  mCvReady.notify_all();
+}
+
+EOSFSTNAMESPACE_END
@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+//! @file CopyPipeline.hh
+//! @brief Pipelined copy engine overlapping reads, writes and checksumming
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "fst/Namespace.hh"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+EOSFSTNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class CopyPipeline - copies a byte stream through a ring of buffers.
+//!
+//! Reader threads fill the ring ahead of the consumers, the write callback is
+//! run by the calling thread and the optional digest callback (checksum) by a
+//! separate thread, both see the blocks in order. A buffer is reused once
+//! both consumers are done with it, so at most depth blocks are in memory.
+//!
+//! With a single stream the source is read sequentially, short reads are
+//! allowed and only a read of 0 bytes marks the end. With several streams
+//! the blocks are read in parallel at fixed offsets, therefore the read
+//! callback must support concurrent positional reads and a short read marks
+//! the end of the data.
+//------------------------------------------------------------------------------
+class CopyPipeline
+{
+public:
+  //! Default number of buffers in the ring
+  static constexpr uint32_t sDefaultDepth = 4;
+
+  //! Read up to len bytes at offset, returns bytes read, 0 at the end of the
+  //! data and -1 on error
+  using ReadCallback = std::function<int64_t(uint64_t offset, char* buff,
+                       uint32_t len)>;
+  //! Consume a block, returns false on error which aborts the copy
+  using WriteCallback = std::function<bool(uint64_t offset, const char* buff,
+                        uint32_t len)>;
+  //! Digest a block, run concurrently with the write callback
+  using DigestCallback = std::function<void(uint64_t offset, const char* buff,
+                         uint32_t len)>;
+
+  //----------------------------------------------------------------------------
+  //! Statistics of a copy, times are in milliseconds
+  //----------------------------------------------------------------------------
+  struct Stats {
+    uint64_t mBytes {0}; ///< Bytes written
+    uint64_t mBlocks {0}; ///< Blocks written
+    double mReadTime {0}; ///< Time spent reading, summed over all streams
+    double mWriteTime {0}; ///< Time spent in the write callback
+    double mDigestTime {0}; ///< Time spent in the digest callback
+    double mMaxReadLatency {0}; ///< Slowest block read
+    double mMaxWriteLatency {0}; ///< Slowest block write
+    double mRealTime {0}; ///< Wall clock time of the copy
+
+    //--------------------------------------------------------------------------
+    //! Time a strict read-then-write loop would have needed for the same
+    //! reads, checksumming and writes
+    //--------------------------------------------------------------------------
+    double GetSerialTime() const
+    {
+      return mReadTime + mDigestTime + mWriteTime;
+    }
+
+    //--------------------------------------------------------------------------
+    //! Speedup of the pipeline compared to the serial loop
+    //--------------------------------------------------------------------------
+    double GetSpeedup() const
+    {
+      return (mRealTime > 0) ? (GetSerialTime() / mRealTime) : 1.0;
+    }
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param block_size size of a block
+  //! @param depth number of buffers in the ring
+  //! @param streams number of parallel reader threads
+  //----------------------------------------------------------------------------
+  CopyPipeline(uint32_t block_size, uint32_t depth = sDefaultDepth,
+               uint32_t streams = 1);
+
+  //----------------------------------------------------------------------------
+  //! Set the digest callback
+  //----------------------------------------------------------------------------
+  void SetDigest(DigestCallback digest)
+  {
+    mDigest = std::move(digest);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Run the copy
+  //!
+  //! @param offset source offset to start from
+  //! @param length number of bytes to copy, -1 to copy until the end
+  //! @param read read callback
+  //! @param write write callback
+  //!
+  //! @return 0 if successful, -EIO if a read failed and -ECANCELED if the
+  //!         write callback failed
+  //----------------------------------------------------------------------------
+  int Run(uint64_t offset, int64_t length, ReadCallback read,
+          WriteCallback write);
+
+  //----------------------------------------------------------------------------
+  //! Get the source offset of the failed read
+  //----------------------------------------------------------------------------
+  uint64_t GetFailedOffset() const
+  {
+    return mFailedOffset;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get statistics of the last copy
+  //----------------------------------------------------------------------------
+  const Stats& GetStats() const
+  {
+    return mStats;
+  }
+
+  uint32_t GetDepth() const
+  {
+    return mDepth;
+  }
+
+  uint32_t GetStreams() const
+  {
+    return mStreams;
+  }
+
+private:
+  //! Buffer of the ring
+  struct Slot {
+    std::vector<char> mBuffer;
+    uint64_t mSeq; ///< Sequence number of the stored block
+    uint64_t mOffset; ///< Source offset of the stored block
+    int64_t mLength; ///< Bytes stored, -1 if the read failed
+    bool mLast; ///< No more blocks after this one
+  };
+
+  //----------------------------------------------------------------------------
+  //! Reader loop of the given stream
+  //----------------------------------------------------------------------------
+  void ReadLoop(uint32_t stream, uint64_t offset, int64_t length,
+                const ReadCallback& read);
+
+  //----------------------------------------------------------------------------
+  //! Consumer loop, used both for writing and digesting
+  //!
+  //! @param write true if writing, false if digesting
+  //! @param callback function consuming the block
+  //! @param consumed counter of consumed blocks to update
+  //----------------------------------------------------------------------------
+  void ConsumeLoop(bool write, const WriteCallback& callback,
+                   uint64_t& consumed);
+
+  //----------------------------------------------------------------------------
+  //! Check if the given block can be stored, must hold mMutex
+  //----------------------------------------------------------------------------
+  bool HasFreeSlot(uint64_t seq) const;
+
+  //----------------------------------------------------------------------------
+  //! Abort the copy with the given error, must hold mMutex
+  //----------------------------------------------------------------------------
+  void Abort(int error);
+
+  const uint32_t mBlockSize;
+  const uint32_t mDepth;
+  const uint32_t mStreams;
+  DigestCallback mDigest;
+  std::vector<Slot> mSlots;
+  mutable std::mutex mMutex;
+  std::condition_variable mCvFree; ///< Notified when a slot is released
+  std::condition_variable mCvReady; ///< Notified when a block is stored
+  uint64_t mWritten {0}; ///< Number of blocks written
+  uint64_t mDigested {0}; ///< Number of blocks digested
+  uint64_t mLastSeq {UINT64_MAX}; ///< Sequence number of the last block
+  bool mAborted {false};
+  int mError {0};
+  uint64_t mFailedOffset {0};
+  Stats mStats;
+};
+
+EOSFSTNAMESPACE_END
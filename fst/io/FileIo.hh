@@ -220,6 +220,20 @@ public:
     return;
   }
 
+  //--------------------------------------------------------------------------
+  //! Drop the given range from the page cache, used by readers which don't
+  //! want to evict the data of other clients
+  //!
+  //! @param offset start of the range
+  //! @param length length of the range
+  //!
+  //! @return 0 if successful, -1 otherwise and error code is set
+  //--------------------------------------------------------------------------
+  virtual int fileDropCache(XrdSfsFileOffset offset, XrdSfsFileOffset length)
+  {
+    return 0;
+  }
+
   //--------------------------------------------------------------------------
   //! Wait for all async IO
   //!
@@ -254,6 +254,26 @@ FsIo::fileFdeallocate(XrdSfsFileOffset fromOffset,
 #endif
 }
 
+//------------------------------------------------------------------------------
+// Drop range from the page cache
+//------------------------------------------------------------------------------
+int
+FsIo::fileDropCache(XrdSfsFileOffset offset, XrdSfsFileOffset length)
+{
+#ifdef __APPLE__
+  return 0;
+#else
+  int rc = posix_fadvise(mFd, offset, length, POSIX_FADV_DONTNEED);
+
+  if (rc) {
+    errno = rc;
+    return SFS_ERROR;
+  }
+
+  return 0;
+#endif
+}
+
 //------------------------------------------------------------------------------
 // Sync file to disk
 //------------------------------------------------------------------------------
@@ -238,6 +238,16 @@ public:
   virtual int fileFdeallocate(XrdSfsFileOffset fromOffset,
                               XrdSfsFileOffset toOffset);
 
+  //----------------------------------------------------------------------------
+  //! Drop the given range from the page cache
+  //!
+  //! @param offset start of the range
+  //! @param length length of the range
+  //!
+  //! @return 0 on success, -1 otherwise and error code is set
+  //----------------------------------------------------------------------------
+  virtual int fileDropCache(XrdSfsFileOffset offset, XrdSfsFileOffset length);
+
   //----------------------------------------------------------------------------
   //! Remove file
   //!
@@ -371,10 +371,16 @@ Storage::GetFsStatistics(FileSystem* fs)
   output["stat.disk.iops"] = std::to_string(fs->getIOPS());
   output["stat.disk.bw"] = std::to_string(fs->getSeqBandwidth()); // in MB
   output["stat.http.port"] = std::to_string(gOFS.mHttpdPort);
+  // Hot files are served from the per-filesystem heavy-hitters sketches which
+  // are bounded in size, therefore no sorting of all the open files is needed
   output["stat.ropen.hotfiles"] = HotFilesToString(
-                                    gOFS.openedForReading.getHotFiles(fsid, 10));
+                                    gOFS.openedForReading.getHotFilesByOpens(fsid, 10));
   output["stat.wopen.hotfiles"] = HotFilesToString(
-                                    gOFS.openedForWriting.getHotFiles(fsid, 10));
+                                    gOFS.openedForWriting.getHotFilesByOpens(fsid, 10));
+  output["stat.ropen.hotbytes"] = HotFilesToString(
+                                    gOFS.openedForReading.getHotFilesByBytes(fsid, 10));
+  output["stat.wopen.hotbytes"] = HotFilesToString(
+                                    gOFS.openedForWriting.getHotFilesByBytes(fsid, 10));
   return output;
 }
 
@@ -24,6 +24,7 @@
 #include "fst/storage/Storage.hh"
 #include "fst/XrdFstOfs.hh"
 #include "fst/Config.hh"
+#include "common/Report.hh"
 
 EOSFSTNAMESPACE_BEGIN
 
@@ -35,6 +36,8 @@ Storage::Report()
   bool failure;
   XrdOucString monitorReceiver = gConfig.FstDefaultReceiverQueue;
   monitorReceiver.replace("*/mgm", "*/report");
+  // Ship reports in the compact binary encoding instead of env strings
+  const bool binary_reports = (getenv("EOS_FST_REPORT_BINARY") != nullptr);
 
   while (1) {
     failure = false;
@@ -47,9 +50,21 @@ Storage::Report()
       XrdOucString report = gOFS.ReportQueue.front();
       gOFS.ReportQueueMutex.UnLock();
       eos_static_info("%s", report.c_str());
+      std::string body = report.c_str();
+
+      if (binary_reports) {
+        XrdOucEnv env(report.c_str());
+        eos::common::Report obj(env);
+        body = obj.ToBinary();
+
+        if (body.empty()) {
+          body = report.c_str();
+        }
+      }
+
       // this type of messages can have no receiver
       mq::MessagingRealm::Response response =
-        gOFS.mMessagingRealm->sendMessage("report", report.c_str(),
+        gOFS.mMessagingRealm->sendMessage("report", body.c_str(),
                                           monitorReceiver.c_str(), true);
 
       if (!response.ok()) {
@@ -48,6 +48,7 @@
 #include "fst/io/xrd/XrdIo.hh"
 #include "fst/io/FileIo.hh"
 #include "fst/io/FileIoPluginCommon.hh"
+#include "fst/io/CopyPipeline.hh"
 #include "fst/checksum/ChecksumPlugins.hh"
 
 #define PROGRAM "eoscp"
@@ -116,7 +117,9 @@ uint32_t buffersize = DEFAULTBUFFERSIZE;
 
 double read_wait = 0; ///< statistics about total read time
 double write_wait = 0; ///< statistics about total write time
-char* buffer = NULL; ///< used for doing the reading
+uint32_t pipelinedepth = eos::fst::CopyPipeline::sDefaultDepth; ///< buffers
+uint32_t nstreams = 1; ///< number of parallel read streams
+eos::fst::CopyPipeline::Stats copyStats; ///< statistics of the copy pipeline
 bool first_time = true; ///< first time prefetch two blocks
 bool nooverwrite = false; ///< buy default we overwrite the target files
 
@@ -168,7 +171,7 @@ void
 usage()
 {
   fprintf(stderr,
-          "Usage: %s [-5] [-0] [-X <type>] [-t <mb/s>] [-h] [-x] [-v] [-V] [-d] [-l] [-b <size>] [-T <size>] [-Y] [-n] [-s] [-u <id>] [-g <id>] [-S <#>] [-D <#>] [-O <filename>] [-N <name>]<src1> [src2...] <dst1> [dst2...]\n",
+          "Usage: %s [-5] [-0] [-X <type>] [-t <mb/s>] [-h] [-x] [-v] [-V] [-d] [-l] [-b <size>] [-B <#>] [-M <#>] [-T <size>] [-Y] [-n] [-s] [-u <id>] [-g <id>] [-S <#>] [-D <#>] [-O <filename>] [-N <name>]<src1> [src2...] <dst1> [dst2...]\n",
           PROGRAM);
   fprintf(stderr, "       -h           : help\n");
   fprintf(stderr, "       -d           : debug mode\n");
@@ -181,6 +184,11 @@ usage()
   fprintf(stderr, "       -A <offset>  : append/overwrite at offset\n");
   fprintf(stderr,
           "       -b <size>    : use <size> as buffer size for copy operations\n");
+  fprintf(stderr,
+          "       -B <#>       : use <#> buffers to read ahead of the writes (default %u)\n",
+          eos::fst::CopyPipeline::sDefaultDepth);
+  fprintf(stderr,
+          "       -M <#>       : read an xroot source with <#> parallel streams\n");
   fprintf(stderr,
           "       -T <size>    : use <size> as target size for copies from STDIN\n");
   fprintf(stderr,
@@ -383,6 +391,20 @@ print_summary(VectLocationType& src,
       COUT(("[eoscp] # Bandwidth[MB/s]          : %d\n", (int) bandwidth));
     }
 
+    if (copyStats.mBlocks) {
+      COUT(("[eoscp] # Copy Pipeline            : buffers=%u streams=%u\n",
+            pipelinedepth, nstreams));
+      COUT(("[eoscp] # Read/Xs/Write Time [s]   : %.03f/%.03f/%.03f\n",
+            copyStats.mReadTime / 1000.0, copyStats.mDigestTime / 1000.0,
+            copyStats.mWriteTime / 1000.0));
+      COUT(("[eoscp] # Read Latency [ms]        : avg=%.03f max=%.03f\n",
+            copyStats.mReadTime / copyStats.mBlocks, copyStats.mMaxReadLatency));
+      COUT(("[eoscp] # Write Latency [ms]       : avg=%.03f max=%.03f\n",
+            copyStats.mWriteTime / copyStats.mBlocks, copyStats.mMaxWriteLatency));
+      COUT(("[eoscp] # Speedup vs. serial loop  : %.02f\n",
+            copyStats.GetSpeedup()));
+    }
+
     if (computeXS) {
       COUT(("[eoscp] # Checksum Type %s        : ", xsString.c_str()));
       COUT(("%s", xsObj->GetHexChecksum()));
@@ -413,6 +435,17 @@ print_summary(VectLocationType& src,
       COUT(("bandwidth=%d ", (int) bandwidth));
     }
 
+    if (copyStats.mBlocks) {
+      COUT(("pipeline_buffers=%u pipeline_streams=%u ", pipelinedepth, nstreams));
+      COUT(("read_time=%.03f xs_time=%.03f write_time=%.03f ",
+            copyStats.mReadTime / 1000.0, copyStats.mDigestTime / 1000.0,
+            copyStats.mWriteTime / 1000.0));
+      COUT(("read_latency=%.03f write_latency=%.03f ",
+            copyStats.mReadTime / copyStats.mBlocks,
+            copyStats.mWriteTime / copyStats.mBlocks));
+      COUT(("pipeline_speedup=%.02f ", copyStats.GetSpeedup()));
+    }
+
     if (computeXS) {
       COUT(("checksum_type=%s ", xsString.c_str()));
       COUT(("checksum=%s ", xsObj->GetHexChecksum()));
@@ -529,7 +562,7 @@ main(int argc, char* argv[])
   XrdCl::DefaultEnv::GetEnv()->PutInt("MetalinkProcessing", 0);
 
   while ((c = getopt(argc, argv,
-                     "nshxdvlipfce:P:X:b:m:u:g:t:S:D:5aA:r:N:L:RT:O:V0")) != -1) {
+                     "nshxdvlipfce:P:X:b:B:M:m:u:g:t:S:D:5aA:r:N:L:RT:O:V0")) != -1) {
     switch (c) {
     case 'v':
       verbose = 1;
@@ -736,6 +769,26 @@ main(int argc, char* argv[])
 
       break;
 
+    case 'B':
+      pipelinedepth = atoi(optarg);
+
+      if ((pipelinedepth < 1) || (pipelinedepth > 64)) {
+        fprintf(stderr, "error: number of buffers can only be 1 <= # <= 64\n");
+        exit(-1);
+      }
+
+      break;
+
+    case 'M':
+      nstreams = atoi(optarg);
+
+      if ((nstreams < 1) || (nstreams > 16)) {
+        fprintf(stderr, "error: number of streams can only be 1 <= # <= 16\n");
+        exit(-1);
+      }
+
+      break;
+
     case 'T':
       targetsize = strtoull(optarg, 0, 10);
       break;
@@ -798,21 +851,6 @@ main(int argc, char* argv[])
     usage();
   }
 
-  //............................................................................
-  // Allocate the buffer used for copy
-  //............................................................................
-  buffer = new char[2 * buffersize];
-
-  if ((!buffer)) {
-    fprintf(stderr, "error: cannot allocate buffer of size %u\n", 2 * buffersize);
-    exit(-ENOMEM);
-  }
-
-  if (debug) {
-    fprintf(stderr, "[eoscp]: allocate copy buffer with %u bytes\n",
-            2 * buffersize);
-  }
-
   //.............................................................................
   // Get the address and the file path from the input
   //.............................................................................
@@ -2041,143 +2079,101 @@ main(int argc, char* argv[])
   }
 
   //............................................................................
-  // Do the actual copy operation
+  // Do the actual copy operation - the source is read ahead into a ring of
+  // buffers while the previous blocks are checksummed and written
   //............................................................................
-  char* ptr_buffer = buffer;
   long long totalbytes = 0;
   double wait_time = 0;
   struct timespec start, end;
   stopwritebyte = startwritebyte;
 
-  while (1) {
-    if (progressFile.length()) {
-      write_progress(totalbytes, st[0].st_size);
+  if ((nstreams > 1) && (src_type[0] != XRD_ACCESS)) {
+    if (debug) {
+      fprintf(stderr, "[eoscp]: parallel streams only supported for xroot "
+              "sources, using a single stream\n");
     }
 
-    if (progbar) {
-      gettimeofday(&abs_stop_time, &tz);
-
-      for (int i = 0; i < nsrc; i++) {
-        if ((src_type[i] == XRD_ACCESS) && (targetsize)) {
-          st[i].st_size = targetsize;
-        }
-      }
-
-      print_progbar(totalbytes, st[0].st_size);
-    }
+    nstreams = 1;
+  }
 
-    if (bandwidth) {
-      gettimeofday(&abs_stop_time, &tz);
-      float abs_time = static_cast<float>((abs_stop_time.tv_sec -
-                                           abs_start_time.tv_sec) * 1000 +
-                                          (abs_stop_time.tv_usec - abs_start_time.tv_usec) / 1000);
-      //........................................................................
-      // Regulate the io - sleep as desired
-      //........................................................................
-      float exp_time = totalbytes / bandwidth / 1000.0;
+  eos::fst::CopyPipeline pipeline(buffersize, pipelinedepth, nstreams);
+  pipelinedepth = pipeline.GetDepth();
 
-      if (abs_time < exp_time) {
-        usleep((int)(1000 * (exp_time - abs_time)));
-      }
-    }
+  if (debug) {
+    fprintf(stderr, "[eoscp]: copy pipeline with %u buffers of %u bytes and "
+            "%u read stream(s)\n", pipeline.GetDepth(), buffersize,
+            pipeline.GetStreams());
+  }
 
-    //..........................................................................
-    // For ranges we have to adjust the last buffersize
-    //..........................................................................
-    if ((stopbyte >= 0) &&
-        (((stopbyte - startbyte) - totalbytes) < buffersize)) {
-      buffersize = (stopbyte - startbyte) - totalbytes;
-    }
+  if (computeXS && xsObj) {
+    pipeline.SetDigest([](uint64_t offset, const char* ptr_buffer,
+    uint32_t nread) {
+      xsObj->Add(ptr_buffer, nread, offsetXS);
+      offsetXS += nread;
+    });
+  }
 
-    int nread = -1;
+  auto read_block = [](uint64_t offset, char* ptr_buffer,
+  uint32_t length) -> int64_t {
+    int64_t nread = -1;
 
     switch (src_type[0]) {
     case LOCAL_ACCESS:
     case CONSOLE_ACCESS:
       nread = read(src_handler[0].first,
                    static_cast<void*>(ptr_buffer),
-                   buffersize);
+                   length);
       break;
 
-    case RAID_ACCESS: {
-      nread = redundancyObj->Read(offsetXrd, ptr_buffer, buffersize);
-      offsetXrd += nread;
-    }
-    break;
+    case RAID_ACCESS:
+      nread = redundancyObj->Read(offset, ptr_buffer, length);
+      break;
 
     case XRD_ACCESS: {
-      eos::common::Timing::GetTimeSpec(start);
       uint32_t xnread = 0;
-      status = static_cast<XrdCl::File*>(src_handler[0].second)->Read(offsetXrd,
-               buffersize, ptr_buffer, xnread);
-      nread = xnread;
+      XrdCl::XRootDStatus st = static_cast<XrdCl::File*>
+                               (src_handler[0].second)->Read(offset, length,
+                                   ptr_buffer, xnread);
 
-      if (!status.IsOK()) {
+      if (!st.IsOK()) {
         fprintf(stderr, "Error while doing reading. \n");
-        exit(-1);
+        return -1;
       }
 
-      eos::common::Timing::GetTimeSpec(end);
-      wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                      (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-      read_wait += wait_time;
-      offsetXrd += nread;
+      nread = xnread;
 
       if (debug) {
-        fprintf(stderr, "[eoscp] read=%d\n", nread);
+        fprintf(stderr, "[eoscp] read=%li\n", nread);
       }
     }
     break;
 
     case RIO_ACCESS: {
-      eos::common::Timing::GetTimeSpec(start);
-      int64_t nread64;
-      nread64 = static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileRead(
-                  offsetXrd, ptr_buffer, buffersize);
+      nread = static_cast<eos::fst::FileIo*>(src_handler[0].second)->fileRead(
+                offset, ptr_buffer, length);
 
-      if (nread64 < 0) {
+      if (nread < 0) {
         nread = -1;
-      } else {
-        nread = (int) nread64;
       }
 
-      eos::common::Timing::GetTimeSpec(end);
-      wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                      (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-      read_wait += wait_time;
-      offsetXrd += nread;
-
       if (debug) {
-        fprintf(stderr, "[eoscp] read=%d\n", nread);
+        fprintf(stderr, "[eoscp] read=%li\n", nread);
       }
     }
     break;
     }
 
-    if (nread < 0) {
-      fprintf(stderr, "error: read failed on file %s - destination file "
-              "is incomplete!\n", src_location[0].second.c_str());
-      exit(-EIO);
-    }
-
-    if (nread == 0) {
-      // end of file
-      break;
-    }
-
-    if (computeXS && xsObj) {
-      xsObj->Add(static_cast<const char*>(ptr_buffer), nread, offsetXS);
-      offsetXS += nread;
-    }
-
+    return nread;
+  };
+  auto write_block = [&](uint64_t offset, const char* ptr_buffer,
+  uint32_t nread) -> bool {
     int64_t nwrite = 0;
 
     for (int i = 0; i < ndst; i++) {
       switch (dst_type[i]) {
       case LOCAL_ACCESS:
       case CONSOLE_ACCESS:
-        write(dst_handler[i].first, ptr_buffer, nread);
-        nwrite = nread;
+        nwrite = write(dst_handler[i].first, ptr_buffer, nread);
         break;
 
       case RAID_ACCESS: {
@@ -2190,13 +2186,8 @@ main(int argc, char* argv[])
 
       case XRD_ACCESS: {
         // Do writes in async mode
-        eos::common::Timing::GetTimeSpec(start);
         nwrite = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWriteAsync(
                    stopwritebyte, ptr_buffer, nread);
-        eos::common::Timing::GetTimeSpec(end);
-        wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                        (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-        write_wait += wait_time;
 
         if (debug) {
           fprintf(stderr, "[eoscp] write=%li\n", nwrite);
@@ -2205,7 +2196,6 @@ main(int argc, char* argv[])
       break;
 
       case RIO_ACCESS: {
-        eos::common::Timing::GetTimeSpec(start);
         int64_t nwrite64;
         nwrite64 = static_cast<eos::fst::FileIo*>(dst_handler[i].second)->fileWrite(
                      stopwritebyte, ptr_buffer, nread);
@@ -2216,11 +2206,6 @@ main(int argc, char* argv[])
           nwrite = (int) nwrite64;
         }
 
-        eos::common::Timing::GetTimeSpec(end);
-        wait_time = static_cast<double>((end.tv_sec * 1000 + end.tv_nsec / 1000000) -
-                                        (start.tv_sec * 1000 + start.tv_nsec / 1000000));
-        write_wait += wait_time;
-
         if (debug) {
           fprintf(stderr, "[eoscp] write=%li\n", nwrite);
         }
@@ -2231,14 +2216,71 @@ main(int argc, char* argv[])
       if (nwrite != nread) {
         fprintf(stderr, "error: write failed on destination file %s - "
                 "wrote %lld/%lld bytes - destination file is incomplete!\n",
-                dst_location[i].second.c_str(), (long long) nwrite, (long long) nread);
-        exit(-EIO);
+                dst_location[(i < ndst) ? i : 0].second.c_str(), (long long) nwrite,
+                (long long) nread);
+        return false;
       }
     }
 
     totalbytes += nwrite;
     stopwritebyte += nwrite;
-  } // end while(1)
+
+    if (progressFile.length()) {
+      write_progress(totalbytes, st[0].st_size);
+    }
+
+    if (progbar) {
+      gettimeofday(&abs_stop_time, &tz);
+
+      for (int i = 0; i < nsrc; i++) {
+        if ((src_type[i] == XRD_ACCESS) && (targetsize)) {
+          st[i].st_size = targetsize;
+        }
+      }
+
+      print_progbar(totalbytes, st[0].st_size);
+    }
+
+    if (bandwidth) {
+      gettimeofday(&abs_stop_time, &tz);
+      float abs_time = static_cast<float>((abs_stop_time.tv_sec -
+                                           abs_start_time.tv_sec) * 1000 +
+                                          (abs_stop_time.tv_usec - abs_start_time.tv_usec) / 1000);
+      //......................................................................
+      // Regulate the io - sleep as desired, the readers are throttled by the
+      // pipeline depth
+      //......................................................................
+      float exp_time = totalbytes / bandwidth / 1000.0;
+
+      if (abs_time < exp_time) {
+        usleep((int)(1000 * (exp_time - abs_time)));
+      }
+    }
+
+    return true;
+  };
+  long long copy_length = -1;
+
+  if (stopbyte >= 0) {
+    copy_length = stopbyte - startbyte;
+  }
+
+  int pipeline_rc = pipeline.Run(offsetXrd, copy_length, read_block,
+                                 write_block);
+
+  if (pipeline_rc == -EIO) {
+    fprintf(stderr, "error: read failed on file %s - destination file "
+            "is incomplete!\n", src_location[0].second.c_str());
+    exit(-EIO);
+  }
+
+  if (pipeline_rc) {
+    exit(-EIO);
+  }
+
+  copyStats = pipeline.GetStats();
+  read_wait = copyStats.mReadTime;
+  write_wait = copyStats.mWriteTime;
 
   // Wait for all async write requests before moving on
   eos::common::Timing::GetTimeSpec(start);
@@ -2436,9 +2478,6 @@ main(int argc, char* argv[])
             write_wait);
   }
 
-  // Free memory
-  delete[] buffer;
-
   if (write_error) {
     return -EIO;
   }
@@ -27,10 +27,14 @@
 
 EOSFSTNAMESPACE_BEGIN
 
+constexpr size_t OpenFileTracker::sHotCapacity;
+constexpr std::chrono::seconds OpenFileTracker::sHotDecayWindow;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-OpenFileTracker::OpenFileTracker()
+OpenFileTracker::OpenFileTracker(eos::common::SteadyClock* clock):
+  mClock(clock)
 {
   mMutex.SetBlocking(true);
 }
@@ -40,8 +44,12 @@ OpenFileTracker::OpenFileTracker()
 //------------------------------------------------------------------------------
 void OpenFileTracker::up(eos::common::FileSystem::fsid_t fsid, uint64_t fid)
 {
-  eos::common::RWMutexWriteLock wr_lock(mMutex);
-  mContents[fsid][fid]++;
+  {
+    eos::common::RWMutexWriteLock wr_lock(mMutex);
+    mContents[fsid][fid]++;
+  }
+  std::unique_lock<std::mutex> lock(mHotMutex);
+  getHotSketch(fsid).opens.Add(fid);
 }
 
 //------------------------------------------------------------------------------
@@ -228,4 +236,123 @@ done:
   return results;
 }
 
+//------------------------------------------------------------------------------
+// Account the number of bytes transferred for the given file ID
+//------------------------------------------------------------------------------
+void OpenFileTracker::addBytes(eos::common::FileSystem::fsid_t fsid,
+                               uint64_t fid, uint64_t bytes)
+{
+  if (bytes == 0) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mHotMutex);
+  getHotSketch(fsid).bytes.Add(fid, bytes);
+}
+
+//------------------------------------------------------------------------------
+// Get the hottest files by number of opens over the decaying window
+//------------------------------------------------------------------------------
+std::vector<OpenFileTracker::HotEntry>
+OpenFileTracker::getHotFilesByOpens(eos::common::FileSystem::fsid_t fsid,
+                                    size_t maxEntries) const
+{
+  std::unique_lock<std::mutex> lock(mHotMutex);
+  const HotSketch* sketch = findHotSketch(fsid);
+
+  if (sketch == nullptr) {
+    return {};
+  }
+
+  return toHotEntries(fsid, sketch->opens.GetTop(maxEntries));
+}
+
+//------------------------------------------------------------------------------
+// Get the hottest files by number of bytes over the decaying window
+//------------------------------------------------------------------------------
+std::vector<OpenFileTracker::HotEntry>
+OpenFileTracker::getHotFilesByBytes(eos::common::FileSystem::fsid_t fsid,
+                                    size_t maxEntries) const
+{
+  std::unique_lock<std::mutex> lock(mHotMutex);
+  const HotSketch* sketch = findHotSketch(fsid);
+
+  if (sketch == nullptr) {
+    return {};
+  }
+
+  return toHotEntries(fsid, sketch->bytes.GetTop(maxEntries));
+}
+
+//------------------------------------------------------------------------------
+// Get the sketch of the given filesystem after applying any pending decay,
+// the sketch is created if it does not exist
+//------------------------------------------------------------------------------
+OpenFileTracker::HotSketch&
+OpenFileTracker::getHotSketch(eos::common::FileSystem::fsid_t fsid)
+{
+  auto now = eos::common::SteadyClock::now(mClock);
+  auto it = mHotSketches.find(fsid);
+
+  if (it == mHotSketches.end()) {
+    it = mHotSketches.emplace(fsid, HotSketch()).first;
+    it->second.lastDecay = now;
+    return it->second;
+  }
+
+  decayHotSketch(it->second, now);
+  return it->second;
+}
+
+//------------------------------------------------------------------------------
+// Find the sketch of the given filesystem after applying any pending decay
+//------------------------------------------------------------------------------
+const OpenFileTracker::HotSketch*
+OpenFileTracker::findHotSketch(eos::common::FileSystem::fsid_t fsid) const
+{
+  auto it = mHotSketches.find(fsid);
+
+  if (it == mHotSketches.end()) {
+    return nullptr;
+  }
+
+  decayHotSketch(it->second, eos::common::SteadyClock::now(mClock));
+  return &it->second;
+}
+
+//------------------------------------------------------------------------------
+// Halve the counters of the sketch once for every window that passed
+//------------------------------------------------------------------------------
+void
+OpenFileTracker::decayHotSketch(HotSketch& sketch,
+                                std::chrono::steady_clock::time_point now)
+{
+  auto elapsed = now - sketch.lastDecay;
+
+  if (elapsed >= sHotDecayWindow) {
+    auto windows = elapsed / sHotDecayWindow;
+    unsigned int shift = (windows >= 64) ? 64 : windows;
+    sketch.opens.Decay(shift);
+    sketch.bytes.Decay(shift);
+    sketch.lastDecay += windows * sHotDecayWindow;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Convert sketch entries to HotEntry objects
+//------------------------------------------------------------------------------
+std::vector<OpenFileTracker::HotEntry>
+OpenFileTracker::toHotEntries(eos::common::FileSystem::fsid_t fsid,
+                              const std::vector<eos::common::SpaceSaving<uint64_t>::Entry>& top)
+{
+  std::vector<HotEntry> results;
+  results.reserve(top.size());
+
+  for (const auto& entry : top) {
+    results.emplace_back(fsid, entry.key, entry.count);
+  }
+
+  return results;
+}
+
 EOSFSTNAMESPACE_END
@@ -27,6 +27,8 @@
 #include "fst/Namespace.hh"
 #include "common/FileSystem.hh"
 #include "common/RWMutex.hh"
+#include "common/SpaceSaving.hh"
+#include "common/SteadyClock.hh"
 #include <mutex>
 
 EOSFSTNAMESPACE_BEGIN
@@ -41,10 +43,18 @@ EOSFSTNAMESPACE_BEGIN
 class OpenFileTracker
 {
 public:
+  //! Number of heavy-hitter counters kept per filesystem
+  static constexpr size_t sHotCapacity = 64;
+  //! Interval after which the heavy-hitter counters are halved
+  static constexpr std::chrono::seconds sHotDecayWindow {60};
+
   //----------------------------------------------------------------------------
   //! Constructor
+  //!
+  //! @param clock clock used for decaying the hot file counters, can be
+  //!        faked for testing
   //----------------------------------------------------------------------------
-  OpenFileTracker();
+  OpenFileTracker(eos::common::SteadyClock* clock = nullptr);
 
   //----------------------------------------------------------------------------
   //! Mark that the given file ID, on the given filesystem ID, was just opened
@@ -123,6 +133,28 @@ public:
   std::vector<HotEntry> getHotFiles(eos::common::FileSystem::fsid_t fsid,
                                     size_t maxEntries) const;
 
+  //----------------------------------------------------------------------------
+  //! Account the number of bytes transferred for the given file ID, on the
+  //! given filesystem ID - feeds the hot files by bytes sketch
+  //----------------------------------------------------------------------------
+  void addBytes(eos::common::FileSystem::fsid_t fsid, uint64_t fid,
+                uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Get the hottest files by number of opens over the decaying window. This
+  //! is served from a bounded heavy-hitters sketch, so the cost does not
+  //! depend on the number of currently open files.
+  //----------------------------------------------------------------------------
+  std::vector<HotEntry> getHotFilesByOpens(eos::common::FileSystem::fsid_t fsid,
+      size_t maxEntries) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the hottest files by number of bytes transferred over the decaying
+  //! window. Same properties as getHotFilesByOpens.
+  //----------------------------------------------------------------------------
+  std::vector<HotEntry> getHotFilesByBytes(eos::common::FileSystem::fsid_t fsid,
+      size_t maxEntries) const;
+
   //----------------------------------------------------------------------------
   //! Class acting as a barrier to avoid concurrent file creation interference
   //----------------------------------------------------------------------------
@@ -157,6 +189,48 @@ public:
   };
 
 private:
+  //----------------------------------------------------------------------------
+  //! Heavy-hitters sketches of a filesystem
+  //----------------------------------------------------------------------------
+  struct HotSketch {
+    HotSketch(): opens(sHotCapacity), bytes(sHotCapacity) {}
+
+    eos::common::SpaceSaving<uint64_t> opens;
+    eos::common::SpaceSaving<uint64_t> bytes;
+    std::chrono::steady_clock::time_point lastDecay;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the sketch of the given filesystem after applying any pending decay,
+  //! the sketch is created if it does not exist. Must be called with
+  //! mHotMutex locked.
+  //----------------------------------------------------------------------------
+  HotSketch& getHotSketch(eos::common::FileSystem::fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Find the sketch of the given filesystem after applying any pending decay.
+  //! Must be called with mHotMutex locked.
+  //!
+  //! @return sketch or nullptr if nothing was accounted for the filesystem
+  //----------------------------------------------------------------------------
+  const HotSketch* findHotSketch(eos::common::FileSystem::fsid_t fsid) const;
+
+  //----------------------------------------------------------------------------
+  //! Halve the counters of the sketch once for every decay window that passed
+  //----------------------------------------------------------------------------
+  static void decayHotSketch(HotSketch& sketch,
+                             std::chrono::steady_clock::time_point now);
+
+  //----------------------------------------------------------------------------
+  //! Convert sketch entries to HotEntry objects
+  //----------------------------------------------------------------------------
+  static std::vector<HotEntry>
+  toHotEntries(eos::common::FileSystem::fsid_t fsid,
+               const std::vector<eos::common::SpaceSaving<uint64_t>::Entry>& top);
+
+  eos::common::SteadyClock* mClock;
+  mutable std::mutex mHotMutex;
+  mutable std::map<eos::common::FileSystem::fsid_t, HotSketch> mHotSketches;
   mutable eos::common::RWMutex mMutex;
   std::map<eos::common::FileSystem::fsid_t, std::map<uint64_t, int32_t>>
       mContents;
@@ -10,6 +10,8 @@
 #include <vector>
 #include <string>
 #include <set>
+#include <thread>
+#include <atomic>
 
 #include "common/Timing.hh"
 #include "common/ShellCmd.hh"
@@ -32,6 +34,7 @@
 #define LOOP_18 100
 #define LOOP_19 100
 #define LOOP_20 10
+#define LOOP_21 1000
 
 int main(int argc, char* argv[])
 {
@@ -886,6 +889,87 @@ int main(int argc, char* argv[])
     COMMONTIMING("version-rename-loop", &tm);
   }
 
+  // ------------------------------------------------------------------------ //
+  testno = 21;
+
+  if ((testno >= test_start) && (testno <= test_stop)) {
+    fprintf(stderr, ">>> test %04d\n", testno);
+    // parallel stat/lookup storm on a directory with many entries
+    if (mkdir("storm", S_IRWXU)) {
+      fprintf(stderr, "[test=%3d] mkdir failed errno=%d\n", testno, errno);
+      exit(testno);
+    }
+
+    for (size_t i = 0; i < LOOP_21; i++) {
+      snprintf(name, sizeof(name), "storm/%lu", i);
+      int fd = creat(name, S_IRWXU);
+
+      if (fd < 0) {
+        fprintf(stderr, "[test=%3d] creat failed errno=%d\n", testno, errno);
+        exit(testno);
+      }
+
+      close(fd);
+    }
+
+    COMMONTIMING("storm-create-loop", &tm);
+    size_t nthreads = std::thread::hardware_concurrency();
+
+    if (!nthreads) {
+      nthreads = 8;
+    }
+
+    std::atomic<size_t> nops {0};
+    std::atomic<size_t> nerrors {0};
+    std::vector<std::thread> workers;
+    struct timespec ts_start, ts_stop;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
+
+    for (size_t t = 0; t < nthreads; t++) {
+      workers.emplace_back([t, &nops, &nerrors]() {
+        unsigned int seed = t;
+        char path[1024];
+        struct stat sbuf;
+
+        for (size_t i = 0; i < 10 * LOOP_21; i++) {
+          snprintf(path, sizeof(path), "storm/%u", rand_r(&seed) % LOOP_21);
+
+          if (stat(path, &sbuf)) {
+            nerrors++;
+          }
+
+          nops++;
+        }
+      });
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts_stop);
+    double elapsed = (ts_stop.tv_sec - ts_start.tv_sec) +
+                     (ts_stop.tv_nsec - ts_start.tv_nsec) / 1000000000.0;
+
+    if (nerrors) {
+      fprintf(stderr, "[test=%3d] %lu stat calls failed\n", testno,
+              nerrors.load());
+      exit(testno);
+    }
+
+    fprintf(stderr, "[test=%3d] threads=%lu stats=%lu rate=%.02f stat/s\n",
+            testno, nthreads, nops.load(), elapsed ? nops / elapsed : 0);
+    COMMONTIMING("parallel-stat-storm", &tm);
+
+    for (size_t i = 0; i < LOOP_21; i++) {
+      snprintf(name, sizeof(name), "storm/%lu", i);
+      unlink(name);
+    }
+
+    rmdir("storm");
+    COMMONTIMING("storm-delete-loop", &tm);
+  }
+
   tm.Print();
   fprintf(stdout, "realtime = %.02f\n", tm.RealTime());
 }
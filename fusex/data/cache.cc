@@ -54,6 +54,10 @@ cachehandler::init(cacheconfig& _config)
     }
   }
 
+  if (config.type == cache_t::MEMORY) {
+    memorycache::init(config);
+  }
+
   if (config.journal.length()) {
     if (journalcache::init(config)) {
       fprintf(stderr,
@@ -107,6 +111,18 @@ cachehandler::logconfig()
                      (config.type == cache_t::MEMORY) ? "memory" :
                      "disk");
 
+  if (config.type == cache_t::MEMORY) {
+    std::string s;
+
+    if (config.total_file_cache_size == 0) {
+      eos_static_warning("data-cache-size      := unlimited");
+    } else {
+      eos_static_warning("data-cache-size      := %s",
+                         eos::common::StringConversion::GetReadableSizeString(s,
+                             config.total_file_cache_size, "B"));
+    }
+  }
+
   if (config.type == cache_t::DISK) {
     eos_static_warning("data-cache-location  := %s",
                        config.location.c_str());
@@ -27,6 +27,9 @@
 #include <fts.h>
 #define __USE_FILE_OFFSET64
 #include <sys/statvfs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <fstream>
 
 /* -------------------------------------------------------------------------- */
 dircleaner::dircleaner(const std::string _path,
@@ -38,6 +41,11 @@ dircleaner::dircleaner(const std::string _path,
   max_files(_maxfiles),
   max_size(_maxsize),
   clean_threshold(_clean_threshold),
+  use_index(false),
+  index_bytes(0),
+  index_fd(-1),
+  index_records(0),
+  index_file(_path + "/.eviction-index"),
   name(_name)
 {
   if (max_files | max_size) {
@@ -49,6 +57,11 @@ dircleaner::dircleaner(const std::string _path,
 dircleaner::~dircleaner()
 /* -------------------------------------------------------------------------- */
 {
+  tLeveler.join();
+
+  if (index_fd >= 0) {
+    close(index_fd);
+  }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -86,6 +99,14 @@ dircleaner::cleanall(std::string matchsuffix)
     }
   }
 
+  if (use_index) {
+    std::lock_guard<std::mutex> iLock(indexMutex);
+    index.clear();
+    lru.clear();
+    index_bytes = 0;
+    index_compact();
+  }
+
   return 0;
 }
 
@@ -201,6 +222,11 @@ int
 /* -------------------------------------------------------------------------- */
 dircleaner::trim(bool force)
 {
+  if (use_index) {
+    // the index is exact, no need to look at the tree
+    return trim_index();
+  }
+
   if (!force) {
     // avoid full scans
     tree_info_t& externaltree = get_external_tree();
@@ -309,7 +335,375 @@ dircleaner::leveler(ThreadAssistant& assistant)
     }
 
     std::lock_guard<std::recursive_mutex> mLock(cleaningMutex);
+
+    if (use_index) {
+      // reconcile the index with the tree once a day
+      bool reconcile = n && !(n % (24 * 60 * 4));
+
+      if (reconcile) {
+        index_seed();
+      }
+
+      std::lock_guard<std::mutex> iLock(indexMutex);
+
+      if (reconcile || (index_records > (2 * index.size() + 65536))) {
+        index_compact();
+      }
+    }
+
     trim(!(n % (1 * 60 * 4)));  // forced trim every hour
     n++;
   }
 }
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+dircleaner::enable_index()
+/* -------------------------------------------------------------------------- */
+{
+  if (!(max_files | max_size)) {
+    // nothing is ever trimmed
+    return 0;
+  }
+
+  std::lock_guard<std::recursive_mutex> mLock(cleaningMutex);
+  int rc = 0;
+  {
+    std::lock_guard<std::mutex> iLock(indexMutex);
+    rc = index_load();
+  }
+
+  if (rc) {
+    eos_static_notice("[ %s ] no eviction index in %s - scanning the tree",
+                      name.c_str(), path.c_str());
+    index_seed();
+  }
+
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  rc = index_compact();
+
+  if (!rc) {
+    use_index = true;
+    eos_static_notice("[ %s ] eviction index files=%lu size=%ld", name.c_str(),
+                      index.size(), index_bytes);
+  }
+
+  return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+dircleaner::touch(const std::string& filepath, int64_t size)
+/* -------------------------------------------------------------------------- */
+{
+  if (!use_index) {
+    return;
+  }
+
+  std::string key = index_key(filepath);
+  time_t now = time(NULL);
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  index_update(key, now, size);
+  index_log(key, now, size);
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+dircleaner::forget(const std::string& filepath)
+/* -------------------------------------------------------------------------- */
+{
+  if (!use_index) {
+    return;
+  }
+
+  std::string key = index_key(filepath);
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  index_update(key, 0, -1);
+  index_log(key, 0, -1);
+}
+
+/* -------------------------------------------------------------------------- */
+int64_t
+/* -------------------------------------------------------------------------- */
+dircleaner::get_index_size()
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  return index_bytes;
+}
+
+/* -------------------------------------------------------------------------- */
+int64_t
+/* -------------------------------------------------------------------------- */
+dircleaner::get_index_files()
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  return index.size();
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+dircleaner::index_key(const std::string& filepath) const
+/* -------------------------------------------------------------------------- */
+{
+  // store paths relative to the cache directory
+  if (!filepath.compare(0, path.length(), path)) {
+    size_t pos = filepath.find_first_not_of('/', path.length());
+
+    if (pos != std::string::npos) {
+      return filepath.substr(pos);
+    }
+  }
+
+  return filepath;
+}
+
+/* -------------------------------------------------------------------------- */
+std::string
+/* -------------------------------------------------------------------------- */
+dircleaner::index_path(const std::string& key) const
+/* -------------------------------------------------------------------------- */
+{
+  if (key[0] == '/') {
+    return key;
+  }
+
+  return path + "/" + key;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+dircleaner::index_update(const std::string& key, time_t atime, int64_t size)
+/* -------------------------------------------------------------------------- */
+{
+  auto it = index.find(key);
+
+  if (it != index.end()) {
+    lru.erase(std::make_pair(it->second.atime, &it->first));
+    index_bytes -= it->second.size;
+
+    if (size < 0) {
+      index.erase(it);
+      return;
+    }
+  } else {
+    if (size < 0) {
+      return;
+    }
+
+    it = index.emplace(key, index_entry_t()).first;
+  }
+
+  it->second.atime = atime;
+  it->second.size = size;
+  index_bytes += size;
+  lru.insert(std::make_pair(atime, &it->first));
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+dircleaner::index_log(const std::string& key, time_t atime, int64_t size)
+/* -------------------------------------------------------------------------- */
+{
+  if (index_fd < 0) {
+    return;
+  }
+
+  char line[64];
+  int len = snprintf(line, sizeof(line), "%ld %ld ", (long) atime, (long) size);
+  std::string record(line, len);
+  record += key;
+  record += "\n";
+
+  // a single write per record, a torn record at the tail only leaves a
+  // stale entry which is dropped when it gets evicted
+  if (::write(index_fd, record.c_str(), record.length()) !=
+      (ssize_t) record.length()) {
+    eos_static_err("[ %s ] failed to append to %s errno=%d", name.c_str(),
+                   index_file.c_str(), errno);
+  }
+
+  index_records++;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+dircleaner::index_load()
+/* -------------------------------------------------------------------------- */
+{
+  std::ifstream in(index_file);
+
+  if (!in.is_open()) {
+    return -1;
+  }
+
+  std::string line;
+  index.clear();
+  lru.clear();
+  index_bytes = 0;
+
+  while (std::getline(in, line)) {
+    char* end = 0;
+    long atime = strtol(line.c_str(), &end, 10);
+
+    if (*end != ' ') {
+      continue;
+    }
+
+    long size = strtol(end + 1, &end, 10);
+
+    if ((*end != ' ') || !end[1]) {
+      continue;
+    }
+
+    index_update(end + 1, atime, size);
+  }
+
+  if (!in.eof()) {
+    return -1;
+  }
+
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+dircleaner::index_compact()
+/* -------------------------------------------------------------------------- */
+{
+  std::string tmpfile = index_file + ".tmp";
+  int fd = ::open(tmpfile.c_str(), O_CREAT | O_TRUNC | O_WRONLY, S_IRWXU);
+
+  if (fd < 0) {
+    eos_static_err("[ %s ] failed to create %s errno=%d", name.c_str(),
+                   tmpfile.c_str(), errno);
+    return -1;
+  }
+
+  std::string out;
+  bool ok = true;
+
+  // oldest first, so that loading builds the LRU list in order
+  for (auto it = lru.begin(); it != lru.end(); ++it) {
+    char line[64];
+    snprintf(line, sizeof(line), "%ld %ld ", (long) it->first,
+             (long) index[*it->second].size);
+    out += line;
+    out += *it->second;
+    out += "\n";
+
+    if (out.length() > (1024 * 1024)) {
+      ok &= (::write(fd, out.c_str(), out.length()) == (ssize_t) out.length());
+      out.clear();
+    }
+  }
+
+  ok &= (::write(fd, out.c_str(), out.length()) == (ssize_t) out.length());
+
+  if (!ok || ::fsync(fd) || ::close(fd) ||
+      ::rename(tmpfile.c_str(), index_file.c_str())) {
+    eos_static_err("[ %s ] failed to write %s errno=%d", name.c_str(),
+                   index_file.c_str(), errno);
+    ::unlink(tmpfile.c_str());
+    return -1;
+  }
+
+  if (index_fd >= 0) {
+    close(index_fd);
+  }
+
+  index_fd = ::open(index_file.c_str(), O_WRONLY | O_APPEND);
+  index_records = index.size();
+  return (index_fd < 0) ? -1 : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+dircleaner::index_seed()
+/* -------------------------------------------------------------------------- */
+{
+  // take the tree as the truth, keep what the index knows about the access
+  // times and about files used while scanning
+  time_t start = time(NULL);
+  scanall(trim_suffix);
+  std::lock_guard<std::mutex> iLock(indexMutex);
+  index_map_t known;
+  known.swap(index);
+  lru.clear();
+  index_bytes = 0;
+
+  for (auto it = treeinfo.treemap.begin(); it != treeinfo.treemap.end(); ++it) {
+    std::string key = index_key(it->second.path);
+    auto kit = known.find(key);
+
+    if (kit == known.end()) {
+      index_update(key, it->second.mtime, it->second.size);
+    } else if (kit->second.atime >= start) {
+      index_update(key, kit->second.atime, kit->second.size);
+    } else {
+      index_update(key, kit->second.atime, it->second.size);
+    }
+  }
+
+  for (auto it = known.begin(); it != known.end(); ++it) {
+    if ((it->second.atime >= start) && !index.count(it->first)) {
+      index_update(it->first, it->second.atime, it->second.size);
+    }
+  }
+
+  treeinfo.treemap.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+dircleaner::trim_index()
+/* -------------------------------------------------------------------------- */
+{
+  size_t n_victims = 0;
+
+  while (1) {
+    std::string victim;
+    int64_t size = 0;
+    {
+      std::lock_guard<std::mutex> iLock(indexMutex);
+      bool size_ok = !max_size || (index_bytes <= max_size);
+      bool files_ok = !max_files || ((int64_t) index.size() <= max_files);
+
+      if ((size_ok && files_ok) || lru.empty()) {
+        break;
+      }
+
+      victim = *lru.begin()->second;
+      size = index[victim].size;
+      index_update(victim, 0, -1);
+      index_log(victim, 0, -1);
+    }
+    std::string victimpath = index_path(victim);
+    eos_static_info("[ %s ] erasing %s %ld", name.c_str(), victimpath.c_str(),
+                    size);
+
+    if (::unlink(victimpath.c_str()) && (errno != ENOENT)) {
+      eos_static_err("[ %s ] failed to unlink file %s errno=%d", name.c_str(),
+                     victimpath.c_str(), errno);
+    }
+
+    n_victims++;
+  }
+
+  if (n_victims) {
+    eos_static_notice("[ %s ] trimmed %lu files", name.c_str(), n_victims);
+  }
+
+  return 0;
+}
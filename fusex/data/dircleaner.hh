@@ -32,6 +32,7 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <atomic>
 #include <exception>
 #include <stdexcept>
@@ -130,7 +131,65 @@ public:
   int trim(bool force);
   void leveler(ThreadAssistant& assistant);
 
+  //----------------------------------------------------------------------------
+  // eviction index - the cache reports every use of a file with touch/forget
+  // and trimming removes the least recently used files without scanning the
+  // tree. The index is persisted as an append-only log in the cache
+  // directory and compacted from time to time, so that a restart does not
+  // need a full scan either.
+  //----------------------------------------------------------------------------
+
+  // enable the index, loading the persisted one or seeding it with a scan
+  int enable_index();
+
+  bool indexed() const
+  {
+    return use_index;
+  }
+
+  // a file was used and has now the given size
+  void touch(const std::string& filepath, int64_t size);
+
+  // a file was removed
+  void forget(const std::string& filepath);
+
+  int64_t get_index_size();
+  int64_t get_index_files();
+
 private:
+  typedef struct index_entry {
+    time_t atime;
+    int64_t size;
+  } index_entry_t;
+
+  typedef std::unordered_map<std::string, index_entry_t> index_map_t;
+
+  // orders by access time, ties by the (stable) address of the map key
+  struct lru_less {
+    bool operator()(const std::pair<time_t, const std::string*>& a,
+                    const std::pair<time_t, const std::string*>& b) const
+    {
+      if (a.first != b.first) {
+        return a.first < b.first;
+      }
+
+      return std::less<const std::string*>()(a.second, b.second);
+    }
+  };
+
+  typedef std::set<std::pair<time_t, const std::string*>, lru_less> lru_set_t;
+
+  std::string index_key(const std::string& filepath) const;
+  std::string index_path(const std::string& key) const;
+  // the following require indexMutex
+  void index_update(const std::string& key, time_t atime, int64_t size);
+  void index_log(const std::string& key, time_t atime, int64_t size);
+  int index_load();
+  int index_compact();
+  // rebuild the index from a scan, requires cleaningMutex
+  void index_seed();
+  int trim_index();
+
   std::recursive_mutex cleaningMutex;
   std::string path;
 
@@ -138,6 +197,15 @@ private:
   int64_t max_size;
   float clean_threshold;
 
+  std::atomic<bool> use_index;
+  std::mutex indexMutex;
+  index_map_t index;
+  lru_set_t lru;
+  int64_t index_bytes;
+  int index_fd;
+  size_t index_records; // records in the log, compacted at some point
+  std::string index_file;
+
   tree_info_t treeinfo;
   tree_info_t externaltreeinfo;
 
@@ -90,6 +90,10 @@ diskcache::init_daemonized(const cacheconfig& config)
     }
   }
 
+  if (sDirCleaner->enable_index()) {
+    eos_static_err("cache eviction index failed - trimming by tree scans");
+  }
+
   // start the disk cache leveling thread;
   return 0;
 }
@@ -151,8 +155,11 @@ diskcache::attach(fuse_req_t req, std::string& acookie, int flag)
     if (stat(path.c_str(), &attachstat)) {
       // a new file
       sDirCleaner->get_external_tree().change(0, 1);
+      attachstat.st_size = 0;
     }
 
+    sDirCleaner->touch(path, attachstat.st_size);
+
     // need to open the file
     size_t tries=0;
     do {
@@ -224,6 +231,15 @@ diskcache::detach(std::string& cookie)
 
     sDirCleaner->get_external_tree().change(detachstat.st_size - attachstat.st_size,
 					    0);
+
+    if (sDirCleaner->indexed()) {
+      std::string path;
+
+      if (!location(path, false)) {
+        sDirCleaner->touch(path, detachstat.st_size);
+      }
+    }
+
     int rc = close(fd);
     fd = -1;
 
@@ -254,6 +270,7 @@ diskcache::unlink()
       if (!rc) {
 	// a deleted file
 	sDirCleaner->get_external_tree().change(-buf.st_size, -1);
+	sDirCleaner->forget(path);
       }
     }
   }
@@ -323,6 +340,14 @@ diskcache::truncate(off_t offset)
     sDirCleaner->get_external_tree().change(detachstat.st_size - attachstat.st_size,
 					    0);
     attachstat.st_size = offset;
+
+    if (sDirCleaner->indexed()) {
+      std::string path;
+
+      if (!location(path, false)) {
+        sDirCleaner->touch(path, offset);
+      }
+    }
   }
 
   return rc;
@@ -29,9 +29,183 @@
 #include <sys/types.h>
 #include <errno.h>
 #include "common/XattrCompat.hh"
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
 
+memorypagepool memorycache::sPool;
+
+/* -------------------------------------------------------------------------- */
+memorypagepool::~memorypagepool()
+/* -------------------------------------------------------------------------- */
+{
+  for (auto& f : frames) {
+    free(f.data);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+memorypagepool::set_max_pages(size_t n)
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  max_pages = n;
+}
+
+/* -------------------------------------------------------------------------- */
+memorypagepool::frame*
+/* -------------------------------------------------------------------------- */
+memorypagepool::get(memorycache* owner, uint64_t page)
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (free_frames.empty() && max_pages && (allocated >= max_pages)) {
+    // clock sweep over all frames, a referenced frame gets a second chance.
+    // Frames of the requesting owner are skipped since it is in the middle
+    // of an operation, frames of a busy owner are skipped to avoid a lock
+    // order inversion with the owner mutex.
+    for (size_t steps = 0; steps < 2 * frames.size(); ++steps) {
+      frame* f = &frames[hand];
+      hand = (hand + 1) % frames.size();
+
+      if (!f->owner || (f->owner == owner)) {
+        continue;
+      }
+
+      if (f->referenced.exchange(false, std::memory_order_relaxed)) {
+        continue;
+      }
+
+      memorycache* victim = f->owner;
+
+      if (!victim->mtx.try_lock()) {
+        continue;
+      }
+
+      std::vector<frame*> dropped = victim->invalidate(f->page);
+      victim->mtx.unlock();
+
+      for (auto df : dropped) {
+        release(df);
+      }
+
+      evictions += dropped.size();
+      break;
+    }
+  }
+
+  frame* f = 0;
+
+  if (!free_frames.empty()) {
+    f = free_frames.back();
+    free_frames.pop_back();
+  } else if (!max_pages || (allocated < max_pages)) {
+    if (!spare_frames.empty()) {
+      f = spare_frames.back();
+      spare_frames.pop_back();
+    } else {
+      frames.emplace_back();
+      f = &frames.back();
+    }
+
+    f->data = (char*) malloc(sPageSize);
+
+    if (!f->data) {
+      spare_frames.push_back(f);
+      return 0;
+    }
+
+    allocated++;
+  } else {
+    return 0;
+  }
+
+  f->owner = owner;
+  f->page = page;
+  f->referenced.store(true, std::memory_order_relaxed);
+  used++;
+  return f;
+}
+
+/* -------------------------------------------------------------------------- */
+void
 /* -------------------------------------------------------------------------- */
-memorycache::memorycache(fuse_ino_t _ino) : ino(_ino)
+memorypagepool::put(const std::vector<frame*>& frames)
+/* -------------------------------------------------------------------------- */
+{
+  if (frames.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx);
+
+  for (auto f : frames) {
+    release(f);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+void
+/* -------------------------------------------------------------------------- */
+memorypagepool::release(frame* f)
+/* -------------------------------------------------------------------------- */
+{
+  f->owner = 0;
+  f->referenced.store(false, std::memory_order_relaxed);
+  used--;
+
+  if (!max_pages) {
+    // without a budget memory is given back like the old buffers did
+    free(f->data);
+    f->data = 0;
+    allocated--;
+    spare_frames.push_back(f);
+  } else {
+    free_frames.push_back(f);
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+memorypagepool::allocated_pages()
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return allocated;
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+memorypagepool::used_pages()
+/* -------------------------------------------------------------------------- */
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return used;
+}
+
+/* -------------------------------------------------------------------------- */
+int
+/* -------------------------------------------------------------------------- */
+memorycache::init(const cacheconfig& config)
+/* -------------------------------------------------------------------------- */
+{
+  size_t max_pages = config.total_file_cache_size / memorypagepool::sPageSize;
+
+  if (config.total_file_cache_size && !max_pages) {
+    max_pages = 1;
+  }
+
+  sPool.set_max_pages(max_pages);
+  return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+memorycache::memorycache(fuse_ino_t _ino) : cachesize(0), ino(_ino)
   /* -------------------------------------------------------------------------- */
 {
   (void) ino;
@@ -42,7 +216,10 @@ memorycache::memorycache(fuse_ino_t _ino) : ino(_ino)
 memorycache::~memorycache()
 /* -------------------------------------------------------------------------- */
 {
-  return;
+  // keep the mutex while returning the frames, the pool might try to evict
+  // one of them concurrently
+  std::lock_guard<std::mutex> lock(mtx);
+  sPool.put(invalidate(0));
 }
 
 /* -------------------------------------------------------------------------- */
@@ -77,7 +254,36 @@ ssize_t
 /* -------------------------------------------------------------------------- */
 memorycache::pread(void* buf, size_t count, off_t offset)
 {
-  return (ssize_t) buffer.readData(buf, offset, count);
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (offset >= cachesize) {
+    return 0;
+  }
+
+  count = std::min(count, (size_t)(cachesize - offset));
+  const size_t ps = memorypagepool::sPageSize;
+  auto it = pagemap.lower_bound(offset / ps);
+  size_t done = 0;
+
+  // copy page by page straight into the caller buffer, holes read as zeros
+  while (done < count) {
+    off_t pos = offset + done;
+    uint64_t page = pos / ps;
+    size_t poff = pos % ps;
+    size_t len = std::min(ps - poff, count - done);
+
+    if ((it != pagemap.end()) && (it->first == page)) {
+      memorypagepool::touch(it->second);
+      memcpy((char*) buf + done, it->second->data + poff, len);
+      ++it;
+    } else {
+      memset((char*) buf + done, 0, len);
+    }
+
+    done += len;
+  }
+
+  return count;
 }
 
 ssize_t
@@ -85,7 +291,46 @@ ssize_t
 memorycache::pwrite(const void* buf, size_t count, off_t offset)
 /* -------------------------------------------------------------------------- */
 {
-  return (ssize_t) buffer.writeData(buf, offset, count);
+  std::lock_guard<std::mutex> lock(mtx);
+  const size_t ps = memorypagepool::sPageSize;
+  size_t done = 0;
+
+  while (done < count) {
+    off_t pos = offset + done;
+    uint64_t page = pos / ps;
+    size_t poff = pos % ps;
+    size_t len = std::min(ps - poff, count - done);
+    memorypagepool::frame* f = 0;
+    auto it = pagemap.find(page);
+
+    if (it != pagemap.end()) {
+      f = it->second;
+      memorypagepool::touch(f);
+    } else {
+      f = sPool.get(this, page);
+
+      if (!f) {
+        // the budget is used up by this file - cache only what fits and
+        // forget the rest, it is served by the remote file
+        eos_static_debug("memorycache::pwrite ino=%#lx page pool exhausted at "
+                         "offset=%ld", ino, pos);
+        cachesize = std::max(cachesize, (off_t)(offset + count));
+        sPool.put(invalidate(page));
+        return count;
+      }
+
+      // parts of a new page not covered by the write are holes
+      memset(f->data, 0, poff);
+      memset(f->data + poff + len, 0, ps - poff - len);
+      pagemap[page] = f;
+    }
+
+    memcpy(f->data + poff, (const char*) buf + done, len);
+    done += len;
+  }
+
+  cachesize = std::max(cachesize, (off_t)(offset + count));
+  return count;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -94,7 +339,20 @@ int
 memorycache::truncate(off_t offset)
 /* -------------------------------------------------------------------------- */
 {
-  buffer.truncateData(offset);
+  std::lock_guard<std::mutex> lock(mtx);
+  const size_t ps = memorypagepool::sPageSize;
+
+  if (offset < cachesize) {
+    sPool.put(invalidate((offset + ps - 1) / ps));
+    // bytes behind the end of the last page have to read as zeros on growth
+    auto it = pagemap.find(offset / ps);
+
+    if ((it != pagemap.end()) && (offset % ps)) {
+      memset(it->second->data + (offset % ps), 0, ps - (offset % ps));
+    }
+  }
+
+  cachesize = offset;
   return 0;
 }
 
@@ -111,7 +369,36 @@ size_t
 /* -------------------------------------------------------------------------- */
 memorycache::size()
 {
-  return buffer.getSize();
+  std::lock_guard<std::mutex> lock(mtx);
+  return cachesize;
+}
+
+/* -------------------------------------------------------------------------- */
+size_t
+/* -------------------------------------------------------------------------- */
+memorycache::pages()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return pagemap.size();
+}
+
+/* -------------------------------------------------------------------------- */
+std::vector<memorypagepool::frame*>
+/* -------------------------------------------------------------------------- */
+memorycache::invalidate(uint64_t page)
+/* -------------------------------------------------------------------------- */
+{
+  std::vector<memorypagepool::frame*> dropped;
+  auto it = pagemap.lower_bound(page);
+
+  for (auto drop = it; drop != pagemap.end(); ++drop) {
+    dropped.push_back(drop->second);
+  }
+
+  pagemap.erase(it, pagemap.end());
+  cachesize = std::min(cachesize,
+                       (off_t)(page * memorypagepool::sPageSize));
+  return dropped;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -28,15 +28,97 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "llfusexx.hh"
-#include "bufferll.hh"
 #include "cache.hh"
+#include "cacheconfig.hh"
 #include "XrdSys/XrdSysPthread.hh"
+#include <atomic>
+#include <deque>
 #include <map>
+#include <mutex>
 #include <string>
+#include <vector>
 
+class memorycache;
+
+//------------------------------------------------------------------------------
+//! Pool of fixed-size pages shared by all in-memory file caches. The pool
+//! grows on demand up to its budget, afterwards pages are recycled with a
+//! global clock sweep. Cached data is always clean (the remote file or the
+//! journal holds the authoritative copy), so a page can be evicted at any
+//! time - its owner just forgets everything cached from that page on.
+//------------------------------------------------------------------------------
+class memorypagepool
+{
+public:
+  static constexpr size_t sPageSize = 64 * 1024;
+
+  struct frame {
+    frame() : data(0), owner(0), page(0), referenced(false) { }
+    char* data;
+    memorycache* owner;
+    uint64_t page;
+    std::atomic<bool> referenced;
+  };
+
+  memorypagepool() : max_pages(0), hand(0), allocated(0), used(0) { }
+
+  ~memorypagepool();
+
+  //! set the budget in pages, 0 means unlimited
+  void set_max_pages(size_t n);
+
+  //! get a page frame for page number page of owner, evicting pages of other
+  //! owners if the budget is exhausted - returns 0 if nothing can be evicted
+  frame* get(memorycache* owner, uint64_t page);
+
+  //! return frames to the pool
+  void put(const std::vector<frame*>& frames);
+
+  static void touch(frame* f)
+  {
+    f->referenced.store(true, std::memory_order_relaxed);
+  }
+
+  size_t allocated_pages();
+  size_t used_pages();
+
+  uint64_t evicted_pages()
+  {
+    return evictions.load();
+  }
+
+private:
+  //! release a frame, requires mtx
+  void release(frame* f);
+
+  std::mutex mtx;
+  std::deque<frame> frames; // deque keeps frame addresses stable on growth
+  std::vector<frame*> free_frames; // frames with a page ready for reuse
+  std::vector<frame*> spare_frames; // frames without a page
+  size_t max_pages;
+  size_t hand;
+  size_t allocated;
+  size_t used;
+  std::atomic<uint64_t> evictions {0};
+};
+
+//------------------------------------------------------------------------------
+//! In-memory data cache of a single file. Data is stored in pages of the
+//! global page pool, pages never written inside the cached size are holes
+//! and read as zeros.
+//------------------------------------------------------------------------------
 class memorycache : public cache
 {
+  friend class memorypagepool;
+
 public:
+  static int init(const cacheconfig& config);
+
+  static memorypagepool& pool()
+  {
+    return sPool;
+  }
+
   memorycache(fuse_ino_t _ino);
   virtual ~memorycache();
 
@@ -56,8 +138,19 @@ public:
   virtual int set_attr(const std::string& key, const std::string& value) override;
   virtual int attr(const std::string& key, std::string& value) override;
 
+  //! number of pages held by this file
+  size_t pages();
+
 private:
-  bufferll buffer;
+  static memorypagepool sPool;
+
+  //! drop all pages starting from page number page and shrink the cached
+  //! size accordingly, requires mtx - returns the frames to give back
+  std::vector<memorypagepool::frame*> invalidate(uint64_t page);
+
+  std::mutex mtx; // protects pagemap and cachesize
+  std::map<uint64_t, memorypagepool::frame*> pagemap; // page number => frame
+  off_t cachesize;
   XrdSysMutex xattrmtx;
   std::map<std::string, std::string> xattr;
   fuse_ino_t ino;
@@ -80,8 +80,9 @@ metad::init(backend* _mdbackend)
   std::string mdstream;
   // load the root node
   fuse_req_t req = 0;
-  XrdSysMutexHelper mLock(mdmap);
-  update(req, mdmap[1], "", true);
+  shared_md root_md;
+  mdmap.retrieveTS(1, root_md);
+  update(req, root_md, "", true);
   mdmap.init(EosFuse::Instance().getKV());
   dentrymessaging = false;
   writesizeflush = false;
@@ -1840,8 +1841,7 @@ metad::apply(fuse_req_t req, eos::fusex::container& cont, bool listing)
     md->Locker().UnLock();
 
     if (is_new) {
-      XrdSysMutexHelper mLock(mdmap);
-      mdmap[ino] = md;
+      mdmap.setTS(ino, md);
       stat.inodes_inc();
       stat.inodes_ever_inc();
     }
@@ -2356,36 +2356,41 @@ metad::mdstackfree(ThreadAssistant& assistant)
 
     // do this ~every 128 seconds
     if (!(cnt % 256)) {
-      XrdSysMutexHelper mLock(mdmap);
+      std::vector<std::pair<fuse_ino_t, shared_md>> candidates;
 
-      for (auto it = mdmap.begin(); it != mdmap.end();) {
-        if (!it->second) {
-          it++;
-          continue;
-        }
+      for (size_t i = 0; i < pmap::kShards; ++i) {
+        pmap::shard& s = mdmap.shard_at(i);
+        candidates.clear();
+        {
+          XrdSysMutexHelper mLock(s);
 
-        // if the parent is gone, we can remove the child
-        if ((!mdmap.count(it->second->pid())) &&
-            (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
-          eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
-                           it->first, it->second->fullpath().c_str());
-          mdmap.lru_remove(it->first);
-          it = mdmap.erase(it);
-          stat.inodes_dec();
-        } else {
-          if (it->second->deleted()) {
-            if ((!has_flush(it->first)) &&
-                (!EosFuse::Instance().datas.has(it->first))) {
-              eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
-                               it->first, it->second->fullpath().c_str());
-              mdmap.lru_remove(it->first);
-              it = mdmap.erase(it);
-              stat.inodes_dec();
-            } else {
-              it++;
+          for (auto it = s.begin(); it != s.end(); ++it) {
+            if (it->second &&
+                (!S_ISDIR(it->second->mode()) || it->second->deleted())) {
+              candidates.emplace_back(it->first, it->second);
             }
-          } else {
-            it++;
+          }
+        }
+
+        // the parent can live in another shard, check without holding ours
+        for (const auto& cand : candidates) {
+          const shared_md& md = cand.second;
+          bool remove = false;
+
+          // if the parent is gone, we can remove the child
+          if (!mdmap.countTS(md->pid())) {
+            eos_static_debug("removing orphaned inode from mdmap ino=%#lx path=%s",
+                             cand.first, md->fullpath().c_str());
+            remove = true;
+          } else if (md->deleted() && (!has_flush(cand.first)) &&
+                     (!EosFuse::Instance().datas.has(cand.first))) {
+            eos_static_debug("removing deleted inode from mdmap ino=%#lx path=%s",
+                             cand.first, md->fullpath().c_str());
+            remove = true;
+          }
+
+          if (remove && mdmap.eraseUnchangedTS(cand.first, md)) {
+            stat.inodes_dec();
           }
         }
       }
@@ -2394,19 +2399,6 @@ metad::mdstackfree(ThreadAssistant& assistant)
     if (!EosFuse::Instance().Config().mdcachedir.empty()) {
       // level the inodes stored in memory and eventually swap out into kv store
       int swap_out_inodes = 0 ;
-      size_t filled = 0;
-      size_t empty = 0;
-      {
-        XrdSysMutexHelper mLock(mdmap);
-
-        for (auto it = mdmap.begin(); it != mdmap.end(); ++it) {
-          if (it->second) {
-            filled++;
-          } else {
-            empty++;
-          }
-        }
-      }
 
       do {
         swap_out_inodes = mdmap.sizeTS() - max_inodes -
@@ -2414,51 +2406,12 @@ metad::mdstackfree(ThreadAssistant& assistant)
 
         if (swap_out_inodes > 0) {
           eos_static_info("swap-out %d inodes", swap_out_inodes);
-          // grab the last lru inode and swap out
-          mdmap.Lock();
-          mdmap.lru_dump();
-          uint64_t inode_to_swap = mdmap.lru_oldest();
-
-          if (!inode_to_swap) {
-            // nothing in the lru list anymore
-            mdmap.UnLock();
-            break;
-          }
-
-          if (mdmap.count(inode_to_swap)) {
-            shared_md md = mdmap[inode_to_swap];
-
-            if ((md.use_count() > 2) ||
-                (md && md->LockTable().size())) {
-              eos_static_info("swap-out skipping referenced ino=%#llx ref-count=%lu\n",
-                              inode_to_swap,
-                              md.use_count());
-
-              if (md) {
-                mdmap.lru_update(inode_to_swap, md);
-              }
 
-              mdmap.UnLock();
-              continue;
-            }
-
-            mdmap.lru_remove(inode_to_swap);
-
-            if (md) {
-              eos_static_info("swap-out lru-removed ino=%#llx oldest=%#llx", inode_to_swap,
-                              mdmap.lru_oldest());
-              mdmap.lru_remove(inode_to_swap);
-              mdmap[inode_to_swap] = 0;
-
-              if (mdmap.swap_out(md)) {
-                eos_static_err("swap-out failed for ino=%#llx", inode_to_swap);
-              }
-            }
-          } else {
-            mdmap.lru_remove(inode_to_swap);
+          // grab the oldest lru inode of the next shard and swap out
+          if (mdmap.swap_out_oldestTS() == pmap::SWAP_EMPTY) {
+            // nothing in the lru lists anymore
+            break;
           }
-
-          mdmap.UnLock();
         }
       } while ((swap_out_inodes > 0) &&
                (!assistant.terminationRequested()));
@@ -3168,7 +3121,7 @@ metad::vmap::insert(fuse_ino_t a, fuse_ino_t b)
   }
 
   eos_static_info("inserting %llx <=> %llx", a, b);
-  XrdSysMutexHelper mLock(mMutex);
+  eos::common::RWMutexWriteLock wLock(mMutex);
 
   if (fwd_map.count(a) && fwd_map[a] == b) {
     return;
@@ -3214,7 +3167,7 @@ metad::vmap::dump()
 void
 metad::vmap::erase_fwd(fuse_ino_t lookup)
 {
-  XrdSysMutexHelper mLock(mMutex);
+  eos::common::RWMutexWriteLock wLock(mMutex);
 
   if (fwd_map.count(lookup)) {
     bwd_map.erase(fwd_map[lookup]);
@@ -3227,7 +3180,7 @@ metad::vmap::erase_fwd(fuse_ino_t lookup)
 void
 metad::vmap::erase_bwd(fuse_ino_t lookup)
 {
-  XrdSysMutexHelper mLock(mMutex);
+  eos::common::RWMutexWriteLock wLock(mMutex);
 
   if (bwd_map.count(lookup)) {
     fwd_map.erase(bwd_map[lookup]);
@@ -3240,7 +3193,7 @@ metad::vmap::erase_bwd(fuse_ino_t lookup)
 fuse_ino_t
 metad::vmap::forward(fuse_ino_t lookup)
 {
-  XrdSysMutexHelper mLock(mMutex);
+  eos::common::RWMutexReadLock rLock(mMutex);
   auto it = fwd_map.find(lookup);
   fuse_ino_t ino = (it == fwd_map.end()) ? 0 : it->second;
 
@@ -3255,7 +3208,7 @@ metad::vmap::forward(fuse_ino_t lookup)
 fuse_ino_t
 metad::vmap::backward(fuse_ino_t lookup)
 {
-  XrdSysMutexHelper mLock(mMutex);
+  eos::common::RWMutexReadLock rLock(mMutex);
   auto it = bwd_map.find(lookup);
   return (it == bwd_map.end()) ? lookup : it->second;
 }
@@ -3265,24 +3218,31 @@ metad::vmap::backward(fuse_ino_t lookup)
 size_t
 metad::pmap::sizeTS()
 {
-  XrdSysMutexHelper mLock(this);
-  return size();
+  size_t n = 0;
+
+  for (auto& s : shards) {
+    XrdSysMutexHelper mLock(s);
+    n += s.size();
+  }
+
+  return n;
 }
 
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
 
-  if (this->retrieve(ino, ret)) {
+  if (s.retrieve(ino, ret)) {
     return false;
   }
 
   ret = std::make_shared<mdx>();
 
   if (ino) {
-    (*this)[ino] = ret;
+    s[ino] = ret;
   }
 
   return true;
@@ -3292,13 +3252,23 @@ metad::pmap::retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret)
 bool
 metad::pmap::retrieveTS(fuse_ino_t ino, shared_md& ret)
 {
-  XrdSysMutexHelper mLock(this);
-  return this->retrieve(ino, ret);
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
+  return s.retrieve(ino, ret);
+}
+
+/* -------------------------------------------------------------------------- */
+bool
+metad::pmap::countTS(fuse_ino_t ino)
+{
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
+  return s.count(ino);
 }
 
 /* -------------------------------------------------------------------------- */
 bool
-metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
+metad::pmap::shard::retrieve(fuse_ino_t ino, shared_md& ret)
 {
   auto it = this->find(ino);
 
@@ -3336,14 +3306,14 @@ metad::pmap::retrieve(fuse_ino_t ino, shared_md& ret)
 
 /* -------------------------------------------------------------------------- */
 uint64_t
-metad::pmap::lru_oldest() const
+metad::pmap::shard::lru_oldest() const
 {
   return lru_last;
 }
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_add(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::lru_add(fuse_ino_t ino, shared_md md)
 {
   if (ino == 1) {
     return;
@@ -3375,7 +3345,7 @@ metad::pmap::lru_add(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_remove(fuse_ino_t ino)
+metad::pmap::shard::lru_remove(fuse_ino_t ino)
 {
   if (ino == 1) {
     return;
@@ -3423,7 +3393,7 @@ metad::pmap::lru_remove(fuse_ino_t ino)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_update(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::lru_update(fuse_ino_t ino, shared_md md)
 {
   if (ino == 1) {
     return;
@@ -3469,7 +3439,7 @@ metad::pmap::lru_update(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 void
-metad::pmap::lru_dump()
+metad::pmap::shard::lru_dump()
 {
   if (!EOS_LOGS_DEBUG) {
     return;
@@ -3500,6 +3470,14 @@ metad::pmap::lru_dump()
                    lru_first, lru_last);
 }
 
+/* -------------------------------------------------------------------------- */
+void
+metad::pmap::shard::lru_reset()
+{
+  lru_first = 0;
+  lru_last = 0;
+}
+
 /* -------------------------------------------------------------------------- */
 int
 metad::mdx::state_serialize(std::string& mdsstream)
@@ -3570,7 +3548,7 @@ metad::mdx::state_deserialize(std::string& mdsstream)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_out(shared_md md)
+metad::pmap::shard::swap_out(shared_md md)
 {
   // serialize an in-memory md object into the kv store
   std::string mdstream;
@@ -3606,7 +3584,7 @@ metad::pmap::swap_out(shared_md md)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_in(fuse_ino_t ino, shared_md md)
+metad::pmap::shard::swap_in(fuse_ino_t ino, shared_md md)
 {
   // deserialize an in-memory md object from the kv store
   std::string mdstream;
@@ -3642,7 +3620,7 @@ metad::pmap::swap_in(fuse_ino_t ino, shared_md md)
 
 /* -------------------------------------------------------------------------- */
 int
-metad::pmap::swap_rm(fuse_ino_t ino)
+metad::pmap::shard::swap_rm(fuse_ino_t ino)
 {
   // delete from the external KV store
   if (store) {
@@ -3669,29 +3647,41 @@ metad::pmap::swap_rm(fuse_ino_t ino)
 void
 metad::pmap::insertTS(fuse_ino_t ino, shared_md& md)
 {
-  XrdSysMutexHelper mLock(this);
-  bool exists = this->count(ino);
-  (*this)[ino] = md;
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
+  bool exists = s.count(ino);
+  s[ino] = md;
   // lru list handling
 
   if (!exists) {
-    lru_add(ino, md);
+    s.lru_add(ino, md);
   }
 
-  lru_dump();
+  s.lru_dump();
+}
+
+/* -------------------------------------------------------------------------- */
+void
+metad::pmap::setTS(fuse_ino_t ino, shared_md md)
+{
+  // store without lru list handling
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
+  s[ino] = md;
 }
 
 /* -------------------------------------------------------------------------- */
 bool
 metad::pmap::eraseTS(fuse_ino_t ino)
 {
-  XrdSysMutexHelper mLock(this);
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
   // lru list handling
-  lru_remove(ino);
+  s.lru_remove(ino);
   bool exists = false;
-  auto it = this->find(ino);
+  auto it = s.find(ino);
 
-  if ((it != this->end()) && it->first) {
+  if ((it != s.end()) && it->first) {
     exists = true;
   }
 
@@ -3701,40 +3691,127 @@ metad::pmap::eraseTS(fuse_ino_t ino)
   }
 
   if (exists) {
-    this->erase(it);
+    s.erase(it);
   }
 
-  swap_rm(ino); // ignore return code
+  s.swap_rm(ino); // ignore return code
   return exists;
 }
 
+/* -------------------------------------------------------------------------- */
+bool
+metad::pmap::eraseUnchangedTS(fuse_ino_t ino, const shared_md& md)
+{
+  // erase the in-memory entry only if it still points to the given object
+  shard& s = get_shard(ino);
+  XrdSysMutexHelper mLock(s);
+  auto it = s.find(ino);
+
+  if ((it == s.end()) || (it->second != md)) {
+    return false;
+  }
+
+  s.lru_remove(ino);
+  s.erase(it);
+  return true;
+}
+
 /* -------------------------------------------------------------------------- */
 void
 metad::pmap::retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd)
 {
   // Atomically retrieve md objects for an inode, and its parent.
   while (true) {
-    // In this particular case, we need to first lock mdmap, and then
-    // md.. The following algorithm is meant to avoid deadlocks with code
-    // which locks md first, and then mdmap.
+    // In this particular case, we need to first lock the shard of the inode,
+    // and then md.. The following algorithm is meant to avoid deadlocks with
+    // code which locks md first, and then the shard.
     md.reset();
     pmd.reset();
-    XrdSysMutexHelper mLock(this);
+    shard& s = get_shard(ino);
+    XrdSysMutexHelper mLock(s);
 
-    if (!retrieve(ino, md)) {
+    if (!s.retrieve(ino, md)) {
       return; // ino not there, nothing to do
     }
 
     // md has been found. Can we lock it?
     if (md->Locker().CondLock()) {
-      // Success!
-      retrieve(md->pid(), pmd);
+      // Success! The parent can live in another shard, release ours before
+      // taking that one - the md lock keeps the parent id stable
+      mLock.UnLock();
+      retrieveTS(md->pid(), pmd);
       md->Locker().UnLock();
       return;
     }
 
-    // Nope, unlock mdmap and try again.
+    // Nope, unlock the shard and try again.
     mLock.UnLock();
     std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 }
+
+/* -------------------------------------------------------------------------- */
+void
+metad::pmap::clearTS()
+{
+  for (auto& s : shards) {
+    XrdSysMutexHelper mLock(s);
+    s.clear();
+    s.lru_reset();
+  }
+}
+
+/* -------------------------------------------------------------------------- */
+metad::pmap::swap_result
+metad::pmap::swap_out_oldestTS()
+{
+  // swap out the oldest entry of the next shard with a non-empty lru list
+  for (size_t n = 0; n < kShards; ++n) {
+    shard& s = shards[swap_cursor++ % kShards];
+    XrdSysMutexHelper mLock(s);
+    s.lru_dump();
+    uint64_t inode_to_swap = s.lru_oldest();
+
+    if (!inode_to_swap) {
+      continue;
+    }
+
+    auto it = s.find(inode_to_swap);
+
+    if (it == s.end()) {
+      s.lru_remove(inode_to_swap);
+      return SWAP_SKIPPED;
+    }
+
+    shared_md md = it->second;
+
+    if ((md.use_count() > 2) ||
+        (md && md->LockTable().size())) {
+      eos_static_info("swap-out skipping referenced ino=%#llx ref-count=%lu\n",
+                      inode_to_swap,
+                      md.use_count());
+
+      if (md) {
+        s.lru_update(inode_to_swap, md);
+      }
+
+      return SWAP_SKIPPED;
+    }
+
+    s.lru_remove(inode_to_swap);
+
+    if (md) {
+      eos_static_info("swap-out lru-removed ino=%#llx oldest=%#llx", inode_to_swap,
+                      s.lru_oldest());
+      it->second = 0;
+
+      if (s.swap_out(md)) {
+        eos_static_err("swap-out failed for ino=%#llx", inode_to_swap);
+      }
+    }
+
+    return SWAP_DONE;
+  }
+
+  return SWAP_EMPTY;
+}
@@ -40,6 +40,7 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include <memory>
 #include <map>
+#include <unordered_map>
 #include <set>
 #include <deque>
 #include <vector>
@@ -438,14 +439,14 @@ public:
 
     void clear() 
     {
-      XrdSysMutexHelper mLock(mMutex);
+      eos::common::RWMutexWriteLock wLock(mMutex);
       fwd_map.clear();
       bwd_map.clear();
     }
 
     size_t size()
     {
-      XrdSysMutexHelper mLock(mMutex);
+      eos::common::RWMutexReadLock rLock(mMutex);
       return fwd_map.size();
     }
 
@@ -455,53 +456,108 @@ public:
     std::map<fuse_ino_t, fuse_ino_t>
     bwd_map; // backward map points from local remote inode
 
-    XrdSysMutex mMutex;
+    // translations are looked up on every request but rarely change
+    eos::common::RWMutex mMutex;
   };
 
-  class pmap : public std::map<fuse_ino_t, shared_md>, public XrdSysMutex
   //----------------------------------------------------------------------------
+  //! Inode table split into shards selected by the inode number. Every shard
+  //! has its own mutex and LRU list, so that lookups of different inodes
+  //! don't serialize on a single lock. The LRU order is exact within a shard
+  //! and approximate across shards: swap-out takes the oldest entry of the
+  //! shards in round robin order.
+  //----------------------------------------------------------------------------
+  class pmap
   {
   public:
+    //! Number of shards, must be a power of two
+    static constexpr size_t kShards = 256;
+
+    //--------------------------------------------------------------------------
+    //! Single shard of the inode table - the map and LRU list are protected
+    //! by the shard mutex
+    //--------------------------------------------------------------------------
+    class shard : public std::unordered_map<fuse_ino_t, shared_md>,
+      public XrdSysMutex
+    {
+    public:
+
+      shard()
+      {
+        lru_first = 0;
+        lru_last = 0;
+        store = 0 ;
+      }
 
-    pmap()
-    {
-      lru_first = 0;
-      lru_last = 0;
-      store = 0 ;
-    }
+      void init(kv* _kv)
+      {
+        store = _kv;
+      }
+
+      bool retrieve(fuse_ino_t ino, shared_md& ret);
+
+      uint64_t lru_oldest() const;
+      void lru_add(fuse_ino_t ino, shared_md md);
+      void lru_remove(fuse_ino_t ino);
+      void lru_update(fuse_ino_t ino, shared_md md);
+      void lru_dump();
+      void lru_reset();
+
+      int swap_out(shared_md md);
+      int swap_in(fuse_ino_t ino, shared_md md);
+      int swap_rm(fuse_ino_t ino);
+
+    private:
+      uint64_t lru_first;
+      uint64_t lru_last;
+      kv* store;
+    };
+
+    //! Result of a swap-out attempt
+    enum swap_result {
+      SWAP_DONE, SWAP_SKIPPED, SWAP_EMPTY
+    };
+
+    pmap() : swap_cursor(0) { }
 
     void init(kv* _kv)
     {
-      store = _kv;
+      for (auto& s : shards) {
+        s.init(_kv);
+      }
     }
 
     virtual ~pmap() { }
 
+    shard& get_shard(fuse_ino_t ino)
+    {
+      return shards[(ino ^ (ino >> 16)) & (kShards - 1)];
+    }
+
+    shard& shard_at(size_t i)
+    {
+      return shards[i];
+    }
+
     // TS stands for "thread-safe"
 
     size_t sizeTS();
 
     bool retrieveOrCreateTS(fuse_ino_t ino, shared_md& ret);
     bool retrieveTS(fuse_ino_t ino, shared_md& ret);
-    bool retrieve(fuse_ino_t ino, shared_md& ret);
+    bool countTS(fuse_ino_t ino);
     void insertTS(fuse_ino_t ino, shared_md& md);
+    void setTS(fuse_ino_t ino, shared_md md);
     bool eraseTS(fuse_ino_t ino);
+    bool eraseUnchangedTS(fuse_ino_t ino, const shared_md& md);
     void retrieveWithParentTS(fuse_ino_t ino, shared_md& md, shared_md& pmd);
+    void clearTS();
 
-    uint64_t lru_oldest() const;
-    void lru_add(fuse_ino_t ino, shared_md md);
-    void lru_remove(fuse_ino_t ino);
-    void lru_update(fuse_ino_t ino, shared_md md);
-    void lru_dump();
-
-    int swap_out(shared_md md);
-    int swap_in(fuse_ino_t ino, shared_md md);
-    int swap_rm(fuse_ino_t ino);
+    swap_result swap_out_oldestTS();
 
   private:
-    uint64_t lru_first;
-    uint64_t lru_last;
-    kv* store;
+    shard shards[kShards];
+    std::atomic<size_t> swap_cursor; ///< Next shard to swap out from
   };
 
   //----------------------------------------------------------------------------
@@ -719,12 +775,12 @@ public:
   }
 
   void mdreset() {
-    XrdSysMutexHelper lock(mdmap);
-    shared_md md1 = mdmap[1];
+    shared_md md1;
+    mdmap.retrieveTS(1, md1);
     md1->set_type(md1->MD);
     md1->force_refresh();
-    mdmap.clear();
-    mdmap[1] = md1;
+    mdmap.clearTS();
+    mdmap.setTS(1, md1);
     uint64_t i_root = inomap.backward(1);
     inomap.clear();
     inomap.insert(i_root,1);
@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+//! @file dir-cleaner.cc
+//! @brief tests of the eviction index of the cache directory cleaner
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/dircleaner.hh"
+#include "gtest/gtest.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static std::string make_file(const std::string& dir, int i, size_t size)
+{
+  char name[64];
+  snprintf(name, sizeof(name), "%03X", i % 4);
+  std::string subdir = dir + "/" + name;
+  mkdir(subdir.c_str(), S_IRWXU);
+  snprintf(name, sizeof(name), "/%08X.dc", i);
+  std::string path = subdir + name;
+  int fd = open(path.c_str(), O_CREAT | O_RDWR, S_IRWXU);
+  EXPECT_EQ(0, ftruncate(fd, size));
+  close(fd);
+  // older files first
+  struct timeval tv[2];
+  tv[0].tv_sec = tv[1].tv_sec = 1000000 + i;
+  tv[0].tv_usec = tv[1].tv_usec = 0;
+  utimes(path.c_str(), tv);
+  return path;
+}
+
+TEST(DirCleaner, EvictionIndex)
+{
+  char tmpl[] = "/tmp/eosxd-dircleaner-XXXXXX";
+  std::string dir = mkdtemp(tmpl);
+  std::vector<std::string> paths;
+
+  for (int i = 0; i < 10; ++i) {
+    paths.push_back(make_file(dir, i, 1000));
+  }
+
+  {
+    dircleaner cleaner(dir, "test", 5500, 0);
+    // no index yet, seeded with a scan
+    ASSERT_EQ(0, cleaner.enable_index());
+    ASSERT_TRUE(cleaner.indexed());
+    ASSERT_EQ(10, cleaner.get_index_files());
+    ASSERT_EQ(10000, cleaner.get_index_size());
+    // using the oldest file protects it from eviction
+    cleaner.touch(paths[0], 1000);
+    cleaner.forget(paths[9]);
+    ASSERT_EQ(0, unlink(paths[9].c_str()));
+    ASSERT_EQ(0, cleaner.trim(false));
+    ASSERT_EQ(5, cleaner.get_index_files());
+    ASSERT_EQ(0, access(paths[0].c_str(), F_OK));
+
+    for (int i = 1; i < 5; ++i) {
+      ASSERT_NE(0, access(paths[i].c_str(), F_OK));
+    }
+
+    for (int i = 5; i < 9; ++i) {
+      ASSERT_EQ(0, access(paths[i].c_str(), F_OK));
+    }
+
+    cleaner.touch(paths[5], 3000);
+  }
+
+  // a restart loads the index without a scan - a file appearing behind its
+  // back is not known until the tree gets reconciled
+  make_file(dir, 20, 1000);
+  {
+    dircleaner cleaner(dir, "test", 5500, 0);
+    ASSERT_EQ(0, cleaner.enable_index());
+    ASSERT_EQ(5, cleaner.get_index_files());
+    ASSERT_EQ(7000, cleaner.get_index_size());
+    ASSERT_EQ(0, cleaner.trim(true));
+    // the oldest entries go first, files 6 and 7
+    ASSERT_EQ(3, cleaner.get_index_files());
+    ASSERT_NE(0, access(paths[6].c_str(), F_OK));
+    ASSERT_NE(0, access(paths[7].c_str(), F_OK));
+    ASSERT_EQ(0, access(paths[5].c_str(), F_OK));
+    ASSERT_EQ(0, cleaner.cleanall(".dc"));
+    ASSERT_EQ(0, cleaner.get_index_files());
+  }
+
+  std::string cmd = "rm -rf " + dir;
+  ASSERT_EQ(0, system(cmd.c_str()));
+}
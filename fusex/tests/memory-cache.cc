@@ -0,0 +1,156 @@
+//------------------------------------------------------------------------------
+//! @file memory-cache.cc
+//! @brief tests of the page based in-memory data cache
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "fusex/data/memorycache.hh"
+#include "fusex/data/cacheconfig.hh"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+static const size_t ps = memorypagepool::sPageSize;
+
+static void set_budget(size_t bytes)
+{
+  cacheconfig config;
+  config.type = cache_t::MEMORY;
+  config.total_file_cache_size = bytes;
+  memorycache::init(config);
+}
+
+TEST(MemoryCache, RandomWrites)
+{
+  set_budget(0);
+  memorycache mc(1);
+  std::vector<char> ref(5 * ps + 123, 0);
+  std::mt19937 rng(42);
+
+  for (int i = 0; i < 200; ++i) {
+    size_t offset = rng() % ref.size();
+    size_t count = std::min((size_t)(rng() % (2 * ps)), ref.size() - offset);
+    std::vector<char> data(count);
+
+    for (auto& c : data) {
+      c = (char) rng();
+    }
+
+    ASSERT_EQ((ssize_t) count, mc.pwrite(data.data(), count, offset));
+    std::copy(data.begin(), data.end(), ref.begin() + offset);
+  }
+
+  // make sure the last byte is written
+  ASSERT_EQ(1, mc.pwrite(&ref.back(), 1, ref.size() - 1));
+  ASSERT_EQ(ref.size(), mc.size());
+  std::vector<char> out(ref.size() + 100);
+  ASSERT_EQ((ssize_t) ref.size(), mc.pread(out.data(), out.size(), 0));
+  ASSERT_TRUE(std::equal(ref.begin(), ref.end(), out.begin()));
+  ASSERT_EQ(0, mc.pread(out.data(), 10, ref.size()));
+}
+
+TEST(MemoryCache, SparseAndTruncate)
+{
+  set_budget(0);
+  memorycache mc(2);
+  const off_t far = 1024ll * 1024 * 1024;
+  ASSERT_EQ(5, mc.pwrite("hello", 5, far));
+  // a sparse write allocates only the written page
+  ASSERT_EQ(1u, mc.pages());
+  ASSERT_EQ((size_t) far + 5, mc.size());
+  char buf[16];
+  ASSERT_EQ(16, mc.pread(buf, 16, 4096));
+  ASSERT_EQ(std::string(16, '\0'), std::string(buf, 16));
+  ASSERT_EQ(5, mc.pread(buf, 16, far));
+  ASSERT_EQ("hello", std::string(buf, 5));
+  // shrink inside the page and grow again, the tail reads as zeros
+  ASSERT_EQ(0, mc.truncate(far + 2));
+  ASSERT_EQ(0, mc.truncate(far + 5));
+  ASSERT_EQ(5, mc.pread(buf, 16, far));
+  ASSERT_EQ(std::string("he\0\0\0", 5), std::string(buf, 5));
+  ASSERT_EQ(0, mc.truncate(0));
+  ASSERT_EQ(0u, mc.pages());
+  ASSERT_EQ(0u, mc.size());
+}
+
+TEST(MemoryCache, GlobalBudget)
+{
+  set_budget(4 * ps);
+  const size_t used = memorycache::pool().used_pages();
+  const uint64_t evicted = memorycache::pool().evicted_pages();
+  std::vector<char> data(4 * ps, 'a');
+  {
+    memorycache first(3);
+    memorycache second(4);
+    ASSERT_EQ((ssize_t) data.size(), first.pwrite(data.data(), data.size(), 0));
+    ASSERT_EQ(4u, first.pages());
+    // evicting a page of the other file drops its cached range from there on
+    char c = 'b';
+    ASSERT_EQ(1, second.pwrite(&c, 1, 0));
+    ASSERT_EQ(1u, second.pages());
+    ASSERT_LT(first.pages(), 4u);
+    ASSERT_EQ(4u, first.pages() + memorycache::pool().evicted_pages() -
+              evicted);
+    ASSERT_EQ(first.pages() * ps, first.size());
+    // a file larger than the budget keeps only what fits
+    ASSERT_EQ((ssize_t) data.size(), second.pwrite(data.data(), data.size(),
+              ps));
+    ASSERT_EQ(4u, second.pages());
+    ASSERT_EQ(0u, first.pages());
+    ASSERT_EQ(4 * ps, second.size());
+    std::vector<char> out(8 * ps);
+    ASSERT_EQ((ssize_t)(4 * ps), second.pread(out.data(), out.size(), 0));
+    ASSERT_EQ('b', out[0]);
+    ASSERT_EQ('a', out[4 * ps - 1]);
+  }
+  ASSERT_EQ(used, memorycache::pool().used_pages());
+  set_budget(0);
+}
+
+TEST(MemoryCache, Footprint)
+{
+  // memory per cached GB and random write throughput into a large file
+  const size_t file_size = 256 * 1024 * 1024;
+  const size_t io_size = 4096;
+  set_budget(file_size);
+  std::vector<char> data(io_size, 'x');
+  std::mt19937_64 rng(7);
+  memorycache mc(5);
+  auto start = std::chrono::steady_clock::now();
+  const size_t n = 100000;
+
+  for (size_t i = 0; i < n; ++i) {
+    off_t offset = (rng() % (file_size / io_size)) * io_size;
+    ASSERT_EQ((ssize_t) io_size, mc.pwrite(data.data(), io_size, offset));
+  }
+
+  double elapsed = std::chrono::duration<double>
+                   (std::chrono::steady_clock::now() - start).count();
+  double cached = mc.pages() * ps;
+  double overhead = mc.pages() * (sizeof(memorypagepool::frame) + 48);
+  std::cerr << "[ memorycache ] random 4k writes: " << n / elapsed
+            << " ops/s (" << n* io_size / elapsed / 1e6 << " MB/s)" << std::endl
+            << "[ memorycache ] pages: " << mc.pages() << " memory per cached GB: "
+            << (cached + overhead) / cached << " GB" << std::endl;
+  ASSERT_LE(mc.pages() * ps, file_size);
+  set_budget(0);
+}
@@ -1012,6 +1012,11 @@ FsSpace::FsSpace(const char* name)
       SetConfigMember("wfe.ntx", "1");
     }
 
+    // Keep the wfe jobs in the namespace by default
+    if (GetConfigMember("wfe.queue").empty()) {
+      SetConfigMember("wfe.queue", "ns");
+    }
+
     // Disable the 'file archived' garbage collector by default
     if (GetConfigMember("filearchivedgc").empty()) {
       SetConfigMember("filearchivedgc", "off");
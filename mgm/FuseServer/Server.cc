@@ -32,6 +32,7 @@
 
 #include "mgm/Acl.hh"
 #include "mgm/Policy.hh"
+#include "mgm/PolicyIndex.hh"
 #include "mgm/Quota.hh"
 #include "mgm/Recycle.hh"
 #include "mgm/XrdMgmOfs.hh"
@@ -1612,6 +1613,7 @@ Server::OpSetDirectory(const std::string& id,
     }
 
     size_t numAttr = cmd->numAttributes();
+    bool policy_removed = false;
 
     if (op != CREATE &&
         numAttr != md.attr().size()) { /* an attribute got removed */
@@ -1622,6 +1624,7 @@ Server::OpSetDirectory(const std::string& id,
           eos_debug("attr %s=%s has been removed", it->first.c_str(),
                     it->second.c_str());
           cmd->removeAttribute(it->first);
+          policy_removed |= PolicyIndex::IsIndexed(it->first);
           /* if ((--numAttr) == md.attr().size()) break;   would be possible - under a lock! */
         }
       }
@@ -1645,6 +1648,14 @@ Server::OpSetDirectory(const std::string& id,
     }
 
     gOFS->eosDirectoryService->updateStore(cmd.get());
+
+    if (op == CREATE) {
+      // Attributes inherited from the parent might need to be indexed
+      PolicyIndex::Add(cmd.get());
+    } else if (policy_removed) {
+      PolicyIndex::Update(cmd.get());
+    }
+
     // release the namespace lock before seralization/broadcasting
     lock.Release();
     eos::fusex::response resp;
@@ -533,7 +533,9 @@ uint64_t GeoTreeEngine::placementSpace(const std::string& space, const std::stri
     std::string index;
     eos::common::StringConversion::SplitKeyValue(it->second->group->mName, ispace, index, ".");
     if ( (ispace == space) && ( (schedgroup=="") || (schedgroup == it->second->group->mName)) ) {
-      totalSpace += it->second->foregroundFastStruct->placementTree->getTotalSpace();
+      FastStructSched* ft = it->second->pinForegroundFastStruct();
+      totalSpace += ft->placementTree->getTotalSpace();
+      it->second->unpinForegroundFastStruct(ft);
     }
   }
   return totalSpace;
@@ -802,9 +804,11 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 
     if (dispSnaps && (schedgroup.empty() || schedgroup == "*" ||
                       (schedgroup == it->second->group->mName))) {
+      FastStructSched* ft = it->second->pinForegroundFastStruct();
+
       if (optype.empty() || (optype == "plct")) {
         unsigned geo_depth_max_temp = 0;
-        it->second->foregroundFastStruct->placementTree->recursiveDisplay(
+        ft->placementTree->recursiveDisplay(
           data_snapshot, geo_depth_max_temp, "Placement", "plct", useColors);
         geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                         geo_depth_max_temp : geo_depth_max;
@@ -812,7 +816,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 
       if (optype.empty() || (optype == "accsro")) {
         unsigned geo_depth_max_temp = 0;
-        it->second->foregroundFastStruct->rOAccessTree->recursiveDisplay(
+        ft->rOAccessTree->recursiveDisplay(
           data_snapshot, geo_depth_max, "Access RO", "accsro", useColors);
         geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                         geo_depth_max_temp : geo_depth_max;
@@ -820,7 +824,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 
       if (optype.empty() || (optype == "accsrw")) {
         unsigned geo_depth_max_temp = 0;
-        it->second->foregroundFastStruct->rWAccessTree->recursiveDisplay(
+        ft->rWAccessTree->recursiveDisplay(
           data_snapshot, geo_depth_max, "Access RW", "accsrw", useColors);
         geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                         geo_depth_max_temp : geo_depth_max;
@@ -828,7 +832,7 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 
       if (optype.empty() || (optype == "accsdrain")) {
         unsigned geo_depth_max_temp = 0;
-        it->second->foregroundFastStruct->drnAccessTree->recursiveDisplay(
+        ft->drnAccessTree->recursiveDisplay(
           data_snapshot, geo_depth_max, "Draining Access", "accsdrain", useColors);
         geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                         geo_depth_max_temp : geo_depth_max;
@@ -836,11 +840,13 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 
       if (optype.empty() || (optype == "plctdrain")) {
         unsigned geo_depth_max_temp = 0;
-        it->second->foregroundFastStruct->drnPlacementTree->recursiveDisplay(
+        ft->drnPlacementTree->recursiveDisplay(
           data_snapshot, geo_depth_max, "Draining Placement", "plctdrain", useColors);
         geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                         geo_depth_max_temp : geo_depth_max;
       }
+
+      it->second->unpinForegroundFastStruct(ft);
     }
   }
 
@@ -855,8 +861,10 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
     if (dispSnaps &&
         (schedgroup.empty() || schedgroup == "*" || (schedgroup == it->first))) {
       unsigned geo_depth_max_temp = 0;
-      it->second->foregroundFastStruct->proxyAccessTree->recursiveDisplay(
+      FastStructProxy* ft = it->second->pinForegroundFastStruct();
+      ft->proxyAccessTree->recursiveDisplay(
         data_snapshot, geo_depth_max, "Proxy group", "proxy", useColors);
+      it->second->unpinForegroundFastStruct(ft);
       geo_depth_max = (geo_depth_max_temp > geo_depth_max) ?
                       geo_depth_max_temp : geo_depth_max;
     }
@@ -1170,57 +1178,29 @@ void GeoTreeEngine::printInfo(std::string& info, bool dispTree, bool dispSnaps,
 }
 
 
-bool
-GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
-                                        const size_t& nNewReplicas,
-                                        vector<FileSystem::fsid_t>* newReplicas,
-                                        ino64_t inode, std::vector<std::string>* dataProxys,
-                                        std::vector<std::string>* firewallEntryPoint,
-                                        SchedType type,
-                                        vector<FileSystem::fsid_t>* existingReplicas,
-                                        std::vector<std::string>* fsidsgeotags,
-                                        unsigned long long bookingSize,
-                                        const std::string& startFromGeoTag,
-                                        const std::string& clientGeoTag,
-                                        const size_t& nCollocatedReplicas,
-                                        vector<FileSystem::fsid_t>* excludeFs,
-                                        vector<string>* excludeGeoTags)
+//------------------------------------------------------------------------------
+// Convert the constraints of a placement to fast tree indexes
+//------------------------------------------------------------------------------
+void
+GeoTreeEngine::getPlacementConstraintsIdx(const FastStructSched* ft,
+    const vector<FileSystem::fsid_t>* existingReplicas,
+    const std::vector<std::string>* fsidsgeotags,
+    const vector<FileSystem::fsid_t>* excludeFs,
+    const vector<string>* excludeGeoTags,
+    vector<SchedTreeBase::tFastTreeIdx>& existingReplicasIdx,
+    vector<SchedTreeBase::tFastTreeIdx>& excludeFsIdx)
 {
-  assert(nNewReplicas);
-  assert(newReplicas);
-  std::vector<SchedTME*> entries;
-  // find the entry in the map
-  SchedTME* entry;
-  {
-    RWMutexReadLock lock(this->pTreeMapMutex);
-
-    if (!pGroup2SchedTME.count(group)) {
-      eos_err("could not find the requested placement group in the map");
-      return false;
-    }
-
-    entry = pGroup2SchedTME[group];
-    AtomicInc(entry->fastStructLockWaitersCount);
-  }
-  // readlock the original fast structure
-  entry->doubleBufferMutex.LockRead();
-  // locate the existing replicas and the excluded fs in the tree
-  vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx(nNewReplicas),
-         *existingReplicasIdx = NULL, *excludeFsIdx = NULL;
-  newReplicasIdx.resize(0);
-
   if (existingReplicas) {
-    existingReplicasIdx = new vector<SchedTreeBase::tFastTreeIdx>
-    (existingReplicas->size());
-    existingReplicasIdx->resize(0);
-    int count = 0;
+    existingReplicasIdx.reserve(existingReplicas->size());
+    size_t count = 0;
 
     for (auto it = existingReplicas->begin(); it != existingReplicas->end();
          ++it , ++count) {
       const SchedTreeBase::tFastTreeIdx* idx =
         static_cast<const SchedTreeBase::tFastTreeIdx*>(0);
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx) &&
+      if (!ft->fs2TreeIdx->get(*it, idx) &&
+          fsidsgeotags && (count < fsidsgeotags->size()) &&
           !(*fsidsgeotags)[count].empty()) {
         // the fs is not in that group.
         // this could happen because the former file scheduler
@@ -1228,15 +1208,15 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
         // with the new geoscheduler, it should not happen
         // in that case, we try to match a filesystem having the same geotag
         SchedTreeBase::tFastTreeIdx idx =
-          entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode((
+          ft->tag2NodeIdx->getClosestFastTreeNode((
                 *fsidsgeotags)[count].c_str());
 
         if (idx &&
-            (*entry->foregroundFastStruct->treeInfo)[idx].nodeType ==
+            (*ft->treeInfo)[idx].nodeType ==
             SchedTreeBase::TreeNodeInfo::fs) {
-          if ((std::find(existingReplicasIdx->begin(), existingReplicasIdx->end(),
-                         idx) == existingReplicasIdx->end())) {
-            existingReplicasIdx->push_back(idx);
+          if ((std::find(existingReplicasIdx.begin(), existingReplicasIdx.end(),
+                         idx) == existingReplicasIdx.end())) {
+            existingReplicasIdx.push_back(idx);
           }
         }
         // if we can't find any such filesystem, the information is not taken into account
@@ -1249,53 +1229,83 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       }
 
       if (idx) {
-        existingReplicasIdx->push_back(*idx);
+        existingReplicasIdx.push_back(*idx);
       }
     }
   }
 
   if (excludeFs) {
-    excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeFs->size());
-    excludeFsIdx->resize(0);
-
     for (auto it = excludeFs->begin(); it != excludeFs->end(); ++it) {
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+      if (!ft->fs2TreeIdx->get(*it, idx)) {
         // the excluded fs might belong to another group
         // so it's not an error condition
         // eos_warning("could not place excluded fs on the fast tree");
         continue;
       }
 
-      excludeFsIdx->push_back(*idx);
+      excludeFsIdx.push_back(*idx);
     }
   }
 
   if (excludeGeoTags) {
-    if (!excludeFsIdx) {
-      excludeFsIdx = new vector<SchedTreeBase::tFastTreeIdx>(excludeGeoTags->size());
-      excludeFsIdx->resize(0);
-    }
-
     for (auto it = excludeGeoTags->begin(); it != excludeGeoTags->end(); ++it) {
       SchedTreeBase::tFastTreeIdx idx;
-      idx = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
-              it->c_str());
-      excludeFsIdx->push_back(idx);
+      idx = ft->tag2NodeIdx->getClosestFastTreeNode(it->c_str());
+      excludeFsIdx.push_back(idx);
     }
   }
+}
 
+bool
+GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
+                                        const size_t& nNewReplicas,
+                                        vector<FileSystem::fsid_t>* newReplicas,
+                                        ino64_t inode, std::vector<std::string>* dataProxys,
+                                        std::vector<std::string>* firewallEntryPoint,
+                                        SchedType type,
+                                        vector<FileSystem::fsid_t>* existingReplicas,
+                                        std::vector<std::string>* fsidsgeotags,
+                                        unsigned long long bookingSize,
+                                        const std::string& startFromGeoTag,
+                                        const std::string& clientGeoTag,
+                                        const size_t& nCollocatedReplicas,
+                                        vector<FileSystem::fsid_t>* excludeFs,
+                                        vector<string>* excludeGeoTags)
+{
+  assert(nNewReplicas);
+  assert(newReplicas);
+  std::vector<FastStructSched*> fsFastStructs;
+  // find the entry in the map
+  SchedTME* entry;
+  {
+    RWMutexReadLock lock(this->pTreeMapMutex);
+
+    if (!pGroup2SchedTME.count(group)) {
+      eos_err("could not find the requested placement group in the map");
+      return false;
+    }
+
+    entry = pGroup2SchedTME[group];
+    AtomicInc(entry->fastStructLockWaitersCount);
+  }
+  // pin the original fast structure
+  FastStructSched* ft = entry->pinForegroundFastStruct();
+  // locate the existing replicas and the excluded fs in the tree
+  vector<SchedTreeBase::tFastTreeIdx> newReplicasIdx(nNewReplicas),
+         existingReplicasIdx, excludeFsIdx;
+  newReplicasIdx.resize(0);
+  getPlacementConstraintsIdx(ft, existingReplicas, fsidsgeotags, excludeFs,
+                             excludeGeoTags, existingReplicasIdx, excludeFsIdx);
   SchedTreeBase::tFastTreeIdx startFromNode = 0;
 
   if (!startFromGeoTag.empty()) {
-    startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
-        startFromGeoTag.c_str());
+    startFromNode = ft->tag2NodeIdx->getClosestFastTreeNode(
+                      startFromGeoTag.c_str());
   } else if (!clientGeoTag.empty()) {
-    startFromNode =
-      entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
-        clientGeoTag.c_str());
+    startFromNode = ft->tag2NodeIdx->getClosestFastTreeNode(
+                      clientGeoTag.c_str());
   }
 
   // actually do the job
@@ -1305,16 +1315,18 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
   case regularRO:
   case regularRW:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->placementTree,
-                               existingReplicasIdx, bookingSize, startFromNode,
-                               nCollocatedReplicas, excludeFsIdx);
+                               ft->placementTree,
+                               existingReplicas ? &existingReplicasIdx : NULL,
+                               bookingSize, startFromNode, nCollocatedReplicas,
+                               (excludeFs || excludeGeoTags) ? &excludeFsIdx : NULL);
     break;
 
   case draining:
     success = placeNewReplicas(entry, nNewReplicas, &newReplicasIdx,
-                               entry->foregroundFastStruct->drnPlacementTree,
-                               existingReplicasIdx, bookingSize, startFromNode,
-                               nCollocatedReplicas, excludeFsIdx);
+                               ft->drnPlacementTree,
+                               existingReplicas ? &existingReplicasIdx : NULL,
+                               bookingSize, startFromNode, nCollocatedReplicas,
+                               (excludeFs || excludeGeoTags) ? &excludeFsIdx : NULL);
     break;
 
   default:
@@ -1331,40 +1343,37 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
 
   for (auto it = newReplicasIdx.begin(); it != newReplicasIdx.end(); ++it) {
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
-    const unsigned int fsid = (*entry->foregroundFastStruct->treeInfo)[*it].fsId;
+    const unsigned int fsid = (*ft->treeInfo)[*it].fsId;
 
-    if (!entry->foregroundFastStruct->fs2TreeIdx->get(fsid, idx)) {
+    if (!ft->fs2TreeIdx->get(fsid, idx)) {
       eos_crit("inconsistency : cannot retrieve index of selected fs though "
                "it should be in the tree");
       success = false;
       goto cleanup;
     }
 
-    const char netSpeedClass =
-      (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+    const char netSpeedClass = (*ft->treeInfo)[*idx].netSpeedClass;
     newReplicas->push_back(fsid);
 
     // Apply the penalties
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >
-        0) {
-      applyDlScorePenalty(entry, *idx,
+    if (ft->placementTree->pNodes[*idx].fsData.dlScore > 0) {
+      applyDlScorePenalty(ft, *idx,
                           pPenaltySched.pPlctDlScorePenalty[netSpeedClass]);
     }
 
-    if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >
-        0) {
-      applyUlScorePenalty(entry, *idx,
+    if (ft->placementTree->pNodes[*idx].fsData.ulScore > 0) {
+      applyUlScorePenalty(ft, *idx,
                           pPenaltySched.pPlctUlScorePenalty[netSpeedClass]);
     }
   }
 
   if (dataProxys || firewallEntryPoint) {
-    entries.assign(newReplicasIdx.size(), entry);
+    fsFastStructs.assign(newReplicasIdx.size(), ft);
   }
 
   // find proxy for filesticky scheduling
   if (dataProxys) {
-    if (!findProxy(newReplicasIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(newReplicasIdx, fsFastStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : clientGeoTag, filesticky)) {
       success = false;
       goto cleanup;
@@ -1379,11 +1388,10 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
     if (pAccessGeotagMapping.inuse && pAccessProxygroup.inuse)
       for (size_t i = 0; i < newReplicasIdx.size(); i++) {
         if (clientGeoTag.empty() ||
-            accessReqFwEP((
-                            *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag ,
+            accessReqFwEP((*ft->treeInfo)[newReplicasIdx[i]].fullGeotag ,
                           clientGeoTag)) {
-          firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[newReplicasIdx[i]].fullGeotag);
+          firewallProxyGroups[i] = accessGetProxygroup(
+                                     (*ft->treeInfo)[newReplicasIdx[i]].fullGeotag);
         }
       }
 
@@ -1392,7 +1400,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       *firewallEntryPoint = *dataProxys;
     }
 
-    if (!findProxy(newReplicasIdx, entries, inode, firewallEntryPoint,
+    if (!findProxy(newReplicasIdx, fsFastStructs, inode, firewallEntryPoint,
                    &firewallProxyGroups, pProxyCloseToFs ? "" : clientGeoTag, any)) {
       success = false;
       goto cleanup;
@@ -1408,7 +1416,7 @@ GeoTreeEngine::placeNewReplicasOneGroup(FsGroup* group,
       *dataProxys = *firewallEntryPoint;
     }
 
-    if (!findProxy(newReplicasIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(newReplicasIdx, fsFastStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : clientGeoTag, regular)) {
       success = false;
       goto cleanup;
@@ -1422,18 +1430,59 @@ cleanup:
     newReplicas->clear();
   }
 
-  entry->doubleBufferMutex.UnLockRead();
+  entry->unpinForegroundFastStruct(ft);
   AtomicDec(entry->fastStructLockWaitersCount);
+  return success;
+}
 
-  if (existingReplicasIdx) {
-    delete existingReplicasIdx;
+//------------------------------------------------------------------------------
+// Place the replicas of many files in one scheduling group at once
+//------------------------------------------------------------------------------
+size_t
+GeoTreeEngine::placeNewReplicasOneGroupBulk(FsGroup* group, SchedType type,
+    const std::vector<BulkPlacementRequest>& requests,
+    std::vector<BulkPlacementResult>& results)
+{
+  // the fast structures are pinned for one chunk at a time so that the
+  // updater does not wait for large batches when swapping the buffers
+  static const size_t sBulkChunkSize = 1024;
+  results.assign(requests.size(), BulkPlacementResult());
+
+  if ((type != regularRO) && (type != regularRW) && (type != draining)) {
+    return 0;
   }
 
-  if (excludeFsIdx) {
-    delete excludeFsIdx;
+  for (size_t begin = 0; begin < requests.size(); begin += sBulkChunkSize) {
+    size_t end = std::min(begin + sBulkChunkSize, requests.size());
+    SchedTME* entry;
+    {
+      RWMutexReadLock lock(this->pTreeMapMutex);
+
+      if (!pGroup2SchedTME.count(group)) {
+        eos_err("could not find the requested placement group in the map");
+        break;
+      }
+
+      entry = pGroup2SchedTME[group];
+      AtomicInc(entry->fastStructLockWaitersCount);
+    }
+    FastStructSched* ft = entry->pinForegroundFastStruct();
+
+    if (type == draining) {
+      placeNewReplicasBulk(ft, ft->drnPlacementTree, requests, begin, end,
+                           results);
+    } else {
+      placeNewReplicasBulk(ft, ft->placementTree, requests, begin, end, results);
+    }
+
+    entry->unpinForegroundFastStruct(ft);
+    AtomicDec(entry->fastStructLockWaitersCount);
   }
 
-  return success;
+  return std::count_if(results.begin(), results.end(),
+  [](const BulkPlacementResult & res) {
+    return res.success;
+  });
 }
 
 // Would be better as defined locally in find Proxy
@@ -1453,7 +1502,7 @@ struct TreeInfoFsIdComparator {
 
 bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
                               fsIdxs,
-                              std::vector<SchedTME*> entries,
+                              const std::vector<FastStructSched*>& fsFastStructs,
                               ino64_t inode,
                               std::vector<std::string>* dataProxys,
                               std::vector<std::string>* proxyGroups,
@@ -1470,7 +1519,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
   for (size_t i = 0; i < fsIdxs.size(); i++) {
     const std::string* geotag = NULL;
     // get the proxygroup
-    // WARNING: entries[i]->doubleBufferMutex should be locked by the caller of findProxy
+    // WARNING: fsFastStructs[i] should be pinned by the caller of findProxy
 
     if (!(*dataProxys)[i].empty() && (*dataProxys)[i] != "<none>") {
       if (pPxyHost2DpTMEs.count((*dataProxys)[i])) {
@@ -1494,22 +1543,14 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
         {
           auto entry = (*TMEs.begin());
-
-          // we don't want to lock the pxyentry which is already locked
-          if (entry != pxyentry) {
-            AtomicInc(entry->fastStructLockWaitersCount);
-            entry->doubleBufferMutex.LockRead();
-          }
-
+          // prevent the deletion of the entry, only its slow tree node is
+          // used so the fast structures don't need to be pinned
+          AtomicInc(entry->fastStructLockWaitersCount);
           // if they don't, take their geotag as a staring point
           sgeotag =
             (*TMEs.begin())->host2SlowTreeNode[(*dataProxys)[i]]->pNodeInfo.fullGeotag;
           geotag = &sgeotag;
-
-          if (entry != pxyentry) {
-            entry->doubleBufferMutex.UnLockRead();
-            AtomicDec(entry->fastStructLockWaitersCount);
-          }
+          AtomicDec(entry->fastStructLockWaitersCount);
         }
       }
     }
@@ -1517,8 +1558,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
     if (proxyGroups) {
       fsproxygroup = &((*proxyGroups)[i]);
     } else {
-      fsproxygroup = &
-                     (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].proxygroup;
+      fsproxygroup = &(*fsFastStructs[i]->treeInfo)[fsIdxs[i]].proxygroup;
     }
 
     if (fsproxygroup->empty() ||
@@ -1534,7 +1574,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     if (!geotag) {
       geotag = (clientgeotag.empty() ? &
-                ((*(entries[i]->foregroundFastStruct->treeInfo))[fsIdxs[i]].fullGeotag) :
+                ((*(fsFastStructs[i]->treeInfo))[fsIdxs[i]].fullGeotag) :
                 &clientgeotag);
     }
 
@@ -1552,15 +1592,15 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
     pxyentry = pPxyGrp2DpTME[*fsproxygroup];
     AtomicInc(pxyentry->fastStructLockWaitersCount);
-    // readlock the original fast structure
-    pxyentry->doubleBufferMutex.LockRead();
+    // pin the original fast structure
+    FastStructProxy* pxyft = pxyentry->pinForegroundFastStruct();
 
     // copy the fasttree
-    if (pxyentry->foregroundFastStruct->proxyAccessTree->copyToBuffer((
+    if (pxyft->proxyAccessTree->copyToBuffer((
           char*)tlGeoBuffer, gGeoBufferSize)) {
       eos_crit("could not make a working copy of the fast tree for proxygroup %s",
                fsproxygroup->c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
+      pxyentry->unpinForegroundFastStruct(pxyft);
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
@@ -1568,7 +1608,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
     tree = (FastGatewayAccessTree*)tlGeoBuffer;
     // get the closest node from the filesystem
     SchedTreeBase::tFastTreeIdx idx;
-    idx = pxyentry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
+    idx = pxyft->tag2NodeIdx->getClosestFastTreeNode(
             trimlastlevel ? std::string(*geotag, 0,
                                         geotag->rfind("::")).c_str() : geotag->c_str());
     bool schedsuccess = false;
@@ -1578,7 +1618,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       // scheduling should consistently go through the same (firewallentrypoint,proxy)
       // this is to do the caching of the file only on one proxy
       // serving a same file from two proxies is not optimal but it is not mendatory neither
-      if ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+      if ((*fsFastStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
           < 0) {
         schedsuccess = true;
       }
@@ -1586,9 +1626,9 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       else {
         // then consider all the possible proxy in the same proxygroup
         // within the subtree starting at the best proxy and going uproot by
-        // (*pxyentry->foregroundFastStruct->treeInfo)[idx].fileStickyProxyDepth
+        // (*pxyft->treeInfo)[idx].fileStickyProxyDepth
         // allocate a vectors to get the proxies
-        auto s = pxyentry->foregroundFastStruct->treeInfo->size();
+        auto s = pxyft->treeInfo->size();
         std::vector<SchedTreeBase::tFastTreeIdx> proxiesIdxs(s), upRootLevels(s),
             upRootLevelsIdxs(s);
         SchedTreeBase::tFastTreeIdx upRootLevelsCount = 0;
@@ -1606,8 +1646,8 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               ss << " all proxys are:";
 
               for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                ss << (*pxyft->treeInfo)[*it].hostport;
+                ss << "(" << (*pxyft->treeInfo)[*it].fullGeotag << ")";
 
                 if (it != proxiesIdxs.end() - 1) {
                   ss << ",";
@@ -1644,7 +1684,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
             while (
               uprlev < upRootLevelsCount &&
               upRootLevels[uprlev] <=
-              (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+              (*fsFastStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
             ) {
               uprlev++;
             }
@@ -1662,24 +1702,24 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
               }
 
               // sort the proxies by fsid
-              TreeInfoFsIdComparator cmp(pxyentry->foregroundFastStruct->treeInfo);
+              TreeInfoFsIdComparator cmp(pxyft->treeInfo);
               std::sort(proxiesIdxs.begin(), proxiesIdxs.end(), cmp);
               // take the proxy
               idx = proxiesIdxs[inode % proxiesIdxs.size()];
               // if it succeeds, feel the corresponding element of the return vector
-              (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+              (*dataProxys)[i] = (*pxyft->treeInfo)[idx].hostport;
 
               if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
                 stringstream ss;
                 ss << "file sticky proxy scheduling fs:" <<
-                   (*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fsId;
+                   (*fsFastStructs[i]->treeInfo)[fsIdxs[i]].fsId;
                 ss << " | fileStickyProxyDepth:" << (int)(
-                     *entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
+                     *fsFastStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth;
                 ss << " | possible proxys are:";
 
                 for (auto it = proxiesIdxs.begin(); it != proxiesIdxs.end(); it++) {
-                  ss << (*pxyentry->foregroundFastStruct->treeInfo)[*it].hostport;
-                  ss << "(" << (*pxyentry->foregroundFastStruct->treeInfo)[*it].fullGeotag << ")";
+                  ss << (*pxyft->treeInfo)[*it].hostport;
+                  ss << "(" << (*pxyft->treeInfo)[*it].fullGeotag << ")";
 
                   if (it != proxiesIdxs.end() - 1) {
                     ss << ",";
@@ -1688,7 +1728,7 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
 
                 ss << " | inode:" << inode;
                 ss << " | selected host is:" <<
-                   (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+                   (*pxyft->treeInfo)[idx].hostport;
                 eos_debug("%s", ss.str().c_str());
               }
             }
@@ -1697,18 +1737,18 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       }
     } else {
       if (proxyschedtype == any
-          || ((*entries[i]->foregroundFastStruct->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
+          || ((*fsFastStructs[i]->treeInfo)[fsIdxs[i]].fileStickyProxyDepth
               < 0 && proxyschedtype == regular)) {
         // get the proxy
         if (!(schedsuccess = tree->findFreeSlot(idx, idx,
                                                 true /*allow uproot if necessary*/, false, true /*skipSaturated*/))) {
-          (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+          (*dataProxys)[i] = (*pxyft->treeInfo)[idx].hostport;
         } else {
           if ((schedsuccess = tree->findFreeSlot(idx, idx,
                                                  true /*allow uproot if necessary*/, false, false /*skipSaturated*/)))
             // if it succeeds, feel the corresponding element of the return vector
           {
-            (*dataProxys)[i] = (*pxyentry->foregroundFastStruct->treeInfo)[idx].hostport;
+            (*dataProxys)[i] = (*pxyft->treeInfo)[idx].hostport;
           }
         }
       } else {
@@ -1722,13 +1762,13 @@ bool GeoTreeEngine::findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>&
       std::stringstream ss;
       ss << "tree is as follow\n" << (*tree);
       eos_err(ss.str().c_str());
-      pxyentry->doubleBufferMutex.UnLockRead();
+      pxyentry->unpinForegroundFastStruct(pxyft);
       AtomicDec(pxyentry->fastStructLockWaitersCount);
       return false;
     }
 
     // unlock it for each new fs
-    pxyentry->doubleBufferMutex.UnLockRead();
+    pxyentry->unpinForegroundFastStruct(pxyft);
     AtomicDec(pxyentry->fastStructLockWaitersCount);
   }
 
@@ -1772,12 +1812,14 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   std::vector<eos::common::FileSystem::fsid_t>::iterator it;
   std::vector<SchedTreeBase::tFastTreeIdx> ERIdx;
   ERIdx.reserve(existingReplicas->size());
-  std::vector<SchedTME*> entries;
-  entries.reserve(existingReplicas->size());
+  std::vector<FastStructSched*> fsFastStructs;
+  fsFastStructs.reserve(existingReplicas->size());
   // Maps tree maps entries (i.e. scheduling groups) to fs ids containing an
   // available replica and the corresponding fastTreeIndex
   map<SchedTME*, vector< pair<FileSystem::fsid_t, SchedTreeBase::tFastTreeIdx> > >
   entry2FsId;
+  // Maps tree maps entries to their pinned fast structures
+  map<SchedTME*, FastStructSched*> entry2Ft;
   SchedTME* entry = NULL;
   {
     // Lock the scheduling group -> trees map so that the a map entry cannot
@@ -1796,32 +1838,28 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       }
 
       entry = mentry->second;
+      auto ftIt = entry2Ft.find(entry);
 
-      // lock the double buffering to make sure all the fast trees are not modified
-      if (!entry2FsId.count(entry)) {
-        // if the entry is already there, it was locked already
-        entry->doubleBufferMutex.LockRead();
+      // pin the fast structures to make sure all the fast trees are not
+      // modified, if the entry is already there, it was pinned already
+      if (ftIt == entry2Ft.end()) {
         // to prevent the destruction of the entry
         AtomicInc(entry->fastStructLockWaitersCount);
+        ftIt = entry2Ft.emplace(entry, entry->pinForegroundFastStruct()).first;
       }
 
+      FastStructSched* ft = ftIt->second;
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (!entry->foregroundFastStruct->fs2TreeIdx->get(*exrepIt, idx)) {
+      if (!ft->fs2TreeIdx->get(*exrepIt, idx)) {
         eos_warning("msg=\"cannot find fs in the scheduling group in the 2nd "
                     "pass\" fsid=%lu", *exrepIt);
-
-        if (!entry2FsId.count(entry)) {
-          entry->doubleBufferMutex.UnLockRead();
-          AtomicDec(entry->fastStructLockWaitersCount);
-        }
-
         continue;
       }
 
       // take the fastindex of each existing replica
       ERIdx.push_back(*idx);
-      entries.push_back(entry);
+      fsFastStructs.push_back(ft);
       // check if the fs is available
       bool isValid = false;
       std::string msg;
@@ -1830,8 +1868,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
                     *exrepIt) == unavailableFs->end()) {
         switch (type) {
         case regularRO:
-          isValid = entry->foregroundFastStruct->rOAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->rOAccessTree->pBranchComp.isValidSlot(
+                      &ft->rOAccessTree->pNodes[*idx].fsData, &freeSlot);
 
           if (!isValid) {
             msg = "file system not readable";
@@ -1840,8 +1878,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
           break;
 
         case regularRW:
-          isValid = entry->foregroundFastStruct->rWAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->rWAccessTree->pBranchComp.isValidSlot(
+                      &ft->rWAccessTree->pNodes[*idx].fsData, &freeSlot);
 
           if (!isValid) {
             msg = "file system not writable";
@@ -1850,8 +1888,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
           break;
 
         case draining:
-          isValid = entry->foregroundFastStruct->drnAccessTree->pBranchComp.isValidSlot(
-                      &entry->foregroundFastStruct->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
+          isValid = ft->drnAccessTree->pBranchComp.isValidSlot(
+                      &ft->drnAccessTree->pNodes[*idx].fsData, &freeSlot);
 
           if (!isValid) {
             msg = "file system not readable for drain";
@@ -1910,6 +1948,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
       for (auto entryIt = entry2FsId.begin(); entryIt != entry2FsId.end();
            entryIt ++) {
+        FastStructSched* ft = entry2Ft[entryIt->first];
+
         if (g_logging.gLogMask & LOG_MASK(LOG_DEBUG)) {
           char buffer[1024];
           buffer[0] = 0;
@@ -1925,7 +1965,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
           for (auto it = entryIt->second.begin(); it != entryIt->second.end(); ++it) {
             buf += sprintf(buf, "%s  ",
-                           (*entryIt->first->foregroundFastStruct->treeInfo)[it->second].fullGeotag.c_str());
+                           (*ft->treeInfo)[it->second].fullGeotag.c_str());
           }
 
           eos_debug("existing replicas geotags in geotree -> %s", buffer);
@@ -1939,8 +1979,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
 
         entry = entryIt->first;
         // find the closest tree node to the accesser
-        accesserNode = entry->foregroundFastStruct->tag2NodeIdx->getClosestFastTreeNode(
-                         accesserGeotag.c_str());;
+        accesserNode = ft->tag2NodeIdx->getClosestFastTreeNode(
+                         accesserGeotag.c_str());
         // fill a vector with the indices of the replicas
         vector<SchedTreeBase::tFastTreeIdx> existingReplicasIdx(entryIt->second.size());
 
@@ -1956,21 +1996,21 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         case regularRO:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rOAccessTree,
+                                   ft->rOAccessTree,
                                    pSkipSaturatedAccess);
           break;
 
         case regularRW:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->rWAccessTree,
+                                   ft->rWAccessTree,
                                    pSkipSaturatedAccess);
           break;
 
         case draining:
           retCode = accessReplicas(entryIt->first, 1, &accessedReplicasIdx,
                                    accesserNode, &existingReplicasIdx,
-                                   entry->foregroundFastStruct->drnAccessTree,
+                                   ft->drnAccessTree,
                                    pSkipSaturatedDrnAccess);
           break;
 
@@ -1983,7 +2023,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         const string& fsGeotag =
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
+          (*ft->treeInfo)[*accessedReplicasIdx.begin()].fullGeotag;
         unsigned geoScore = 0;
         size_t kmax = min(accesserGeotag.length(), fsGeotag.length());
 
@@ -2004,7 +2044,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
         }
 
         geoScore2Fs[geoScore].push_back(
-          (*entryIt->first->foregroundFastStruct->treeInfo)[*accessedReplicasIdx.begin()].fsId);
+          (*ft->treeInfo)[*accessedReplicasIdx.begin()].fsId);
       }
 
       // randomly choose a fs among the highest scored ones
@@ -2041,7 +2081,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       if (entry) {
         eos_debug("accesser closest node to %s index -> %d / %s",
                   accesserGeotag.c_str(), (int)accesserNode,
-                  (*entry->foregroundFastStruct->treeInfo)[accesserNode].fullGeotag.c_str());
+                  (*entry2Ft[entry]->treeInfo)[accesserNode].fullGeotag.c_str());
       }
 
       eos_debug("selected FsId -> %d / idx %d", (int)selectedFsId, (int)fsIndex);
@@ -2067,24 +2107,30 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       }
 
       entry = pFs2SchedTME[fs];
+
+      // the fast structures of the available fs were pinned in the first pass
+      if (!entry2Ft.count(entry)) {
+        continue;
+      }
+
+      FastStructSched* ft = entry2Ft[entry];
       const SchedTreeBase::tFastTreeIdx* idx;
 
-      if (entry->foregroundFastStruct->fs2TreeIdx->get(fs, idx)) {
-        const char netSpeedClass =
-          (*entry->foregroundFastStruct->treeInfo)[*idx].netSpeedClass;
+      if (ft->fs2TreeIdx->get(fs, idx)) {
+        const char netSpeedClass = (*ft->treeInfo)[*idx].netSpeedClass;
 
         // every available box will push data
-        if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.ulScore >=
+        if (ft->placementTree->pNodes[*idx].fsData.ulScore >=
             pPenaltySched.pAccessUlScorePenalty[netSpeedClass]) {
-          applyUlScorePenalty(entry, *idx,
+          applyUlScorePenalty(ft, *idx,
                               pPenaltySched.pAccessUlScorePenalty[netSpeedClass]);
         }
 
         // every available box will have to pull data if it's a RW access (or if it's a gateway)
         if ((type == regularRW) || (j == fsIndex && nAccessReplicas > 1)) {
-          if (entry->foregroundFastStruct->placementTree->pNodes[*idx].fsData.dlScore >=
+          if (ft->placementTree->pNodes[*idx].fsData.dlScore >=
               pPenaltySched.pAccessDlScorePenalty[netSpeedClass]) {
-            applyDlScorePenalty(entry, *idx,
+            applyDlScorePenalty(ft, *idx,
                                 pPenaltySched.pAccessDlScorePenalty[netSpeedClass]);
           }
         }
@@ -2100,7 +2146,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   }
 
   if (dataProxys) {
-    if (!findProxy(ERIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(ERIdx, fsFastStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : accesserGeotag, filesticky)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2114,10 +2160,10 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
     if (pAccessGeotagMapping.inuse && pAccessProxygroup.inuse)
       for (size_t i = 0; i < ERIdx.size(); i++) {
         if (accesserGeotag.empty() ||
-            accessReqFwEP((*entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag
+            accessReqFwEP((*fsFastStructs[i]->treeInfo)[ERIdx[i]].fullGeotag
                           , accesserGeotag)) {
-          firewallProxyGroups[i] = accessGetProxygroup((
-                                     *entries[i]->foregroundFastStruct->treeInfo)[ERIdx[i]].fullGeotag);
+          firewallProxyGroups[i] = accessGetProxygroup(
+                                     (*fsFastStructs[i]->treeInfo)[ERIdx[i]].fullGeotag);
         }
       }
 
@@ -2125,7 +2171,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       *firewallEntryPoint = *dataProxys;
     }
 
-    if (!findProxy(ERIdx, entries, inode, firewallEntryPoint, &firewallProxyGroups,
+    if (!findProxy(ERIdx, fsFastStructs, inode, firewallEntryPoint, &firewallProxyGroups,
                    pProxyCloseToFs ? "" : accesserGeotag, any)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2137,7 +2183,7 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
       *dataProxys = *firewallEntryPoint;
     }
 
-    if (!findProxy(ERIdx, entries, inode, dataProxys, NULL,
+    if (!findProxy(ERIdx, fsFastStructs, inode, dataProxys, NULL,
                    pProxyCloseToFs ? "" : accesserGeotag, regular)) {
       returnCode = ENETUNREACH;
       goto cleanup;
@@ -2149,8 +2195,8 @@ int GeoTreeEngine::accessHeadReplicaMultipleGroup(const size_t& nAccessReplicas,
   // cleanup and exit
 cleanup:
 
-  for (auto cit = entry2FsId.begin(); cit != entry2FsId.end(); cit++) {
-    cit->first->doubleBufferMutex.UnLockRead();
+  for (auto cit = entry2Ft.begin(); cit != entry2Ft.end(); cit++) {
+    cit->first->unpinForegroundFastStruct(cit->second);
     AtomicDec(cit->first->fastStructLockWaitersCount);
   }
 
@@ -2671,14 +2717,17 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
   // copy the foreground FastStructures to the BackGround FastStructures
   // so that the penalties applied after the placement/access are kept by defaut
   // (and overwritten if a new state is received from the fs)
+  // the buffers are only swapped under pAddRmFsMutex which is held here, so
+  // the foreground can be used without being pinned
   // => SCHEDULING
   pTreeMapMutex.LockRead();
 
   for (auto it = pGroup2SchedTME.begin(); it != pGroup2SchedTME.end(); it++) {
     SchedTME* entry = it->second;
     RWMutexReadLock lock(entry->slowTreeMutex);
+    FastStructSched* foreground = entry->foregroundFastStruct;
 
-    if (!entry->foregroundFastStruct->DeepCopyTo(entry->backgroundFastStruct)) {
+    if (!foreground->DeepCopyTo(entry->backgroundFastStruct)) {
       eos_crit("error deep copying in double buffering");
       pTreeMapMutex.UnLockRead();
       return false;
@@ -2688,14 +2737,14 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     // penalties counter in the fast trees.
     auto& pVec = pPenaltySched.pCircFrCnt2FsPenalties[pFrameCount % pCircSize];
 
-    for (auto it2 = entry->foregroundFastStruct->fs2TreeIdx->begin();
-         it2 != entry->foregroundFastStruct->fs2TreeIdx->end(); it2++) {
+    for (auto it2 = foreground->fs2TreeIdx->begin();
+         it2 != foreground->fs2TreeIdx->end(); it2++) {
       auto cur = *it2;
-      pVec[cur.first] = (*entry->foregroundFastStruct->penalties)[cur.second];
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty, (char)0);
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty, (char)0);
+      pVec[cur.first] = (*foreground->penalties)[cur.second];
+      AtomicCAS((*foreground->penalties)[cur.second].dlScorePenalty,
+                (*foreground->penalties)[cur.second].dlScorePenalty, (char)0);
+      AtomicCAS((*foreground->penalties)[cur.second].ulScorePenalty,
+                (*foreground->penalties)[cur.second].ulScorePenalty, (char)0);
     }
   }
 
@@ -2706,8 +2755,9 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
   for (auto it = pPxyGrp2DpTME.begin(); it != pPxyGrp2DpTME.end(); it++) {
     DataProxyTME* entry = it->second;
     RWMutexReadLock lock(entry->slowTreeMutex);
+    FastStructProxy* foreground = entry->foregroundFastStruct;
 
-    if (!entry->foregroundFastStruct->DeepCopyTo(entry->backgroundFastStruct)) {
+    if (!foreground->DeepCopyTo(entry->backgroundFastStruct)) {
       eos_crit("error deep copying in double buffering");
       pPxyTreeMapMutex.UnLockRead();
       return false;
@@ -2717,14 +2767,14 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     // penalties counter in the fast trees.
     auto& pMap = pPenaltySched.pCircFrCnt2HostPenalties[pFrameCount % pCircSize];
 
-    for (auto it2 = entry->foregroundFastStruct->host2TreeIdx->begin();
-         it2 != entry->foregroundFastStruct->host2TreeIdx->end(); it2++) {
+    for (auto it2 = foreground->host2TreeIdx->begin();
+         it2 != foreground->host2TreeIdx->end(); it2++) {
       auto cur = *it2;
-      pMap[cur.first] = (*entry->foregroundFastStruct->penalties)[cur.second];
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].dlScorePenalty, (char)0);
-      AtomicCAS((*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty,
-                (*entry->foregroundFastStruct->penalties)[cur.second].ulScorePenalty, (char)0);
+      pMap[cur.first] = (*foreground->penalties)[cur.second];
+      AtomicCAS((*foreground->penalties)[cur.second].dlScorePenalty,
+                (*foreground->penalties)[cur.second].dlScorePenalty, (char)0);
+      AtomicCAS((*foreground->penalties)[cur.second].ulScorePenalty,
+                (*foreground->penalties)[cur.second].ulScorePenalty, (char)0);
     }
   }
 
@@ -2768,7 +2818,6 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     // Update only the fast structures because even if a fast structure rebuild
     // is needed from the slow tree. Its information and state is updated from
     // the fast structures.
-    entry->doubleBufferMutex.LockRead();
     const SchedTreeBase::tFastTreeIdx* idx = NULL;
     SlowTreeNode* node = NULL;
 
@@ -2778,7 +2827,6 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
       if (nodeit == entry->fs2SlowTreeNode.end()) {
         eos_crit("Inconsistency : cannot locate an fs %lu supposed to be in "
                  "the fast structures", (unsigned long)fsid);
-        entry->doubleBufferMutex.UnLockRead();
         AtomicDec(entry->fastStructLockWaitersCount);
         return false;
       }
@@ -2801,7 +2849,6 @@ bool GeoTreeEngine::updateTreeInfo(const map<string, int>& updatesFs,
     }
 
     // if we update the slowtree, then a fast tree generation is already pending
-    entry->doubleBufferMutex.UnLockRead();
     AtomicDec(entry->fastStructLockWaitersCount);
   }
 
@@ -2857,14 +2904,16 @@ bool GeoTreeEngine::getInfosFromFsIds(const std::vector<FileSystem::fsid_t>&
 
         if (fsgeotags || hosts) {
           const SchedTreeBase::tFastTreeIdx* idx = NULL;
+          SchedTME* entry = pFs2SchedTME[*it];
+          FastStructSched* ft = entry->pinForegroundFastStruct();
 
-          if (pFs2SchedTME[*it]->foregroundFastStruct->fs2TreeIdx->get(*it, idx)) {
+          if (ft->fs2TreeIdx->get(*it, idx)) {
             if (fsgeotags) fsgeotags->push_back(
-                (*pFs2SchedTME[*it]->foregroundFastStruct->treeInfo)[*idx].fullGeotag
+                (*ft->treeInfo)[*idx].fullGeotag
               );
 
             if (hosts) hosts->push_back(
-                (*pFs2SchedTME[*it]->foregroundFastStruct->treeInfo)[*idx].host
+                (*ft->treeInfo)[*idx].host
               );
           } else {
             if (fsgeotags) {
@@ -2875,6 +2924,8 @@ bool GeoTreeEngine::getInfosFromFsIds(const std::vector<FileSystem::fsid_t>&
               hosts->push_back("");
             }
           }
+
+          entry->unpinForegroundFastStruct(ft);
         }
 
         if (sortedgroups) {
@@ -3412,9 +3463,8 @@ void GeoTreeEngine::setConfigValue(const char* prefix,
 bool GeoTreeEngine::markPendingBranchDisablings(const std::string& group,
     const std::string& optype, const std::string& geotag)
 {
+  // the modification flags are only changed under pAddRmFsMutex
   for (auto git = pGroup2SchedTME.begin(); git != pGroup2SchedTME.end(); git++) {
-    RWMutexReadLock lock(git->second->doubleBufferMutex);
-
     if (group == "*" || git->first->mName == group) {
       git->second->slowTreeModified = true;
     }
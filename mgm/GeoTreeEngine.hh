@@ -40,7 +40,9 @@
 #include "XrdOuc/XrdOucString.hh"
 #include "XrdSys/XrdSysAtomics.hh"
 /*----------------------------------------------------------------------------*/
+#include <atomic>
 #include <list>
+#include <thread>
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -625,13 +627,19 @@ class GeoTreeEngine : public eos::common::LogId
     // ===== Fast Structures Management and Double Buffering ====== //
     FastStruct fastStructures[2];
     // the pointed object is read only accessed by several thread
-    FastStruct* foregroundFastStruct;
+    // it is published atomically and a reader has to pin it for the duration
+    // of its operation using pinForegroundFastStruct/unpinForegroundFastStruct
+    // a reader should only use the pinned pointer and never read
+    // foregroundFastStruct again as it might be swapped in the meantime
+    std::atomic<FastStruct*> foregroundFastStruct;
     // the pointed object is accessed in read /write only by the thread update
     FastStruct* backgroundFastStruct;
-    // the two previous pointers are swapped once an update is done. To do so, we need a mutex and a counter (for deletion)
-    // every access to *mForegroundFastStruct for reading should be protected by a LockRead to mDoubleBufferMutex
-    // when swapping mForegroundFastStruct and mBackgroundFastStruct is needed a LockWrite is taken to mDoubleBufferMutex
-    eos::common::RWMutex doubleBufferMutex;
+    // the two previous pointers are swapped once an update is done. After the
+    // swap, the updater waits for the readers still pinning the former
+    // foreground before it is reused as the background (grace period).
+    // the readers never wait for the updater
+    std::atomic<size_t> fastStructReaders[2];
+    // counter of the threads using the entry (for deletion)
     size_t fastStructLockWaitersCount;
     bool fastStructModified;
 
@@ -644,7 +652,8 @@ class GeoTreeEngine : public eos::common::LogId
     {
       slowTree = new SlowTree(groupName);
       slowTreeMutex.SetBlocking(true);
-      doubleBufferMutex.SetBlocking(true);
+      fastStructReaders[0] = 0;
+      fastStructReaders[1] = 0;
     }
 
     ~TreeMapEntry()
@@ -654,10 +663,45 @@ class GeoTreeEngine : public eos::common::LogId
       }
     }
 
+    //--------------------------------------------------------------------------
+    //! Pin the foreground fast structures for reading. This never blocks: if
+    //! the buffers are swapped while pinning, the new foreground is pinned.
+    //!
+    //! @return pinned fast structures to be released with
+    //!         unpinForegroundFastStruct
+    //--------------------------------------------------------------------------
+    inline FastStruct* pinForegroundFastStruct()
+    {
+      while (true) {
+        FastStruct* ft = foregroundFastStruct.load();
+        std::atomic<size_t>& readers = fastStructReaders[ft - fastStructures];
+        ++readers;
+
+        // the buffer is safe to use only if it was still published after
+        // being pinned, otherwise the updater might not wait for this reader
+        if (ft == foregroundFastStruct.load()) {
+          return ft;
+        }
+
+        --readers;
+      }
+    }
+
+    inline void unpinForegroundFastStruct(const FastStruct* ft)
+    {
+      --fastStructReaders[ft - fastStructures];
+    }
+
     void swapFastStructBuffers()
     {
-      eos::common::RWMutexWriteLock lock(doubleBufferMutex);
-      std::swap(foregroundFastStruct, backgroundFastStruct);
+      FastStruct* retired = foregroundFastStruct.exchange(backgroundFastStruct);
+      backgroundFastStruct = retired;
+
+      // wait for the readers of the former foreground before handing it over
+      // to the updater, they only hold it for one placement/access operation
+      while (fastStructReaders[retired - fastStructures].load()) {
+        std::this_thread::yield();
+      }
     }
 
     void updateBGFastStructuresConfigParam(
@@ -908,6 +952,33 @@ public:
   enum SchedType
   { regularRO, regularRW, draining};
 
+  //! placement request of one file for the bulk placement
+  struct BulkPlacementRequest {
+    //! number of replicas to be placed
+    size_t nNewReplicas = 1;
+    //! the space to be booked on the fs
+    unsigned long long bookingSize = 0;
+    //! fsids of preexisting replicas for the file
+    std::vector<eos::common::FileSystem::fsid_t> existingReplicas;
+    //! geotags of the preexisting replicas (optional, same order as above)
+    std::vector<std::string> existingGeoTags;
+    //! fsids of file systems to exclude from the placement
+    std::vector<eos::common::FileSystem::fsid_t> excludeFs;
+    //! geotags of branches to exclude from the placement
+    std::vector<std::string> excludeGeoTags;
+    //! try to place the replicas under this geotag
+    std::string startFromGeoTag;
+    //! number of replicas to be placed close to startFromGeoTag
+    size_t nCollocatedReplicas = 0;
+  };
+
+  //! placement decision for one file of the bulk placement
+  struct BulkPlacementResult {
+    bool success = false;
+    //! fsids of the new replicas in decreasing priority order
+    std::vector<eos::common::FileSystem::fsid_t> newReplicas;
+  };
+
 protected:
 //**********************************************************
 // BEGIN DATA MEMBERS
@@ -1208,27 +1279,27 @@ protected:
   static void tlFree(void* arg);
   static char* tlAlloc(size_t size);
 
-  inline void applyDlScorePenalty(SchedTME* entry,
+  // ft is either the background fast structures of the updater or the
+  // foreground fast structures pinned by the caller
+  inline void applyDlScorePenalty(FastStructSched* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructSched* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyDlScorePenalty(idx, penalty, background);
   }
 
-  inline void applyUlScorePenalty(SchedTME* entry,
+  inline void applyUlScorePenalty(FastStructSched* ft,
                                   const SchedTreeBase::tFastTreeIdx& idx, const char& penalty,
                                   bool background = false)
   {
-    FastStructSched* ft = background ? entry->backgroundFastStruct :
-                          entry->foregroundFastStruct;
     ft->applyUlScorePenalty(idx, penalty, background);
   }
 
   inline void recallScorePenalty(SchedTME* entry,
                                  const SchedTreeBase::tFastTreeIdx& idx)
   {
+    // only called by the updater which is the only one swapping the buffers
+    const FastStructSched* foreground = entry->foregroundFastStruct.load();
     auto fsid = (*entry->backgroundFastStruct->treeInfo)[idx].fsId;
     tLatencyStats& lstat = pLatencySched.pFsId2LatencyStats[fsid];
     //auto mydata = entry->backgroundFastStruct->placementTree->pNodes[idx].fsData;
@@ -1239,14 +1310,14 @@ protected:
          (pLatencySched.pCircFrCnt2Timestamp[circIdx] > lstat.lastupdate -
           pPublishToPenaltyDelayMs);
          circIdx = ((pCircSize + circIdx - 1) % pCircSize)) {
-      if (entry->foregroundFastStruct->placementTree->pNodes[idx].fsData.dlScore > 0)
-        applyDlScorePenalty(entry, idx,
+      if (foreground->placementTree->pNodes[idx].fsData.dlScore > 0)
+        applyDlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2FsPenalties[circIdx][fsid].dlScorePenalty,
                             true
                            );
 
-      if (entry->foregroundFastStruct->placementTree->pNodes[idx].fsData.ulScore > 0)
-        applyUlScorePenalty(entry, idx,
+      if (foreground->placementTree->pNodes[idx].fsData.ulScore > 0)
+        applyUlScorePenalty(entry->backgroundFastStruct, idx,
                             pPenaltySched.pCircFrCnt2FsPenalties[circIdx][fsid].ulScorePenalty,
                             true
                            );
@@ -1420,6 +1491,132 @@ protected:
     return true;
   }
 
+  // ---------------------------------------------------------------------------
+  //! Convert the constraints of a placement from fsids and geotags to fast
+  //! tree indexes.
+  //!
+  //! @param ft fast structures pinned by the caller
+  // ---------------------------------------------------------------------------
+  void getPlacementConstraintsIdx(const FastStructSched* ft,
+                                  const std::vector<eos::common::FileSystem::fsid_t>* existingReplicas,
+                                  const std::vector<std::string>* fsidsgeotags,
+                                  const std::vector<eos::common::FileSystem::fsid_t>* excludeFs,
+                                  const std::vector<std::string>* excludeGeoTags,
+                                  std::vector<SchedTreeBase::tFastTreeIdx>& existingReplicasIdx,
+                                  std::vector<SchedTreeBase::tFastTreeIdx>& excludeFsIdx);
+
+  // ---------------------------------------------------------------------------
+  //! Place the replicas of a range of requests using a single working copy of
+  //! the fast tree. The constraints of a request only alter the working copy
+  //! for this request while the booked space and the penalties of the
+  //! selected fs are kept for the next ones so that the placements are spread
+  //! as if they had been done one after the other.
+  //! The fast structures ft are supposed to be pinned by the caller.
+  // ---------------------------------------------------------------------------
+  template<class T> void placeNewReplicasBulk(FastStructSched* ft,
+      T* placementTree,
+      const std::vector<BulkPlacementRequest>& requests,
+      size_t begin, size_t end,
+      std::vector<BulkPlacementResult>& results)
+  {
+    // make a working copy of the required fast tree
+    // allocate the buffer only once for the lifetime of the thread
+    if (!tlGeoBuffer) {
+      tlGeoBuffer = tlAlloc(gGeoBufferSize);
+    }
+
+    if (placementTree->copyToBuffer((char*)tlGeoBuffer, gGeoBufferSize)) {
+      eos_crit("could not make a working copy of the fast tree");
+      return;
+    }
+
+    T* tree = (T*)tlGeoBuffer;
+    std::vector<SchedTreeBase::tFastTreeIdx> existingIdx, excludeIdx, newIdx;
+
+    for (size_t i = begin; i < end; i++) {
+      const BulkPlacementRequest& req = requests[i];
+      BulkPlacementResult& res = results[i];
+      existingIdx.clear();
+      excludeIdx.clear();
+      getPlacementConstraintsIdx(ft, &req.existingReplicas,
+                                 &req.existingGeoTags, &req.excludeFs,
+                                 &req.excludeGeoTags, existingIdx, excludeIdx);
+      SchedTreeBase::tFastTreeIdx startFromNode = 0;
+
+      if (!req.startFromGeoTag.empty()) {
+        startFromNode = ft->tag2NodeIdx->getClosestFastTreeNode(
+                          req.startFromGeoTag.c_str());
+      }
+
+      // the existing replicas under the same first level of the tree as the
+      // start node count as collocated replicas
+      size_t nAdjustCollocatedReplicas = startFromNode ? req.nCollocatedReplicas :
+                                         0;
+
+      if (startFromNode) {
+        const std::string& startTag = (*tree->pTreeInfo)[startFromNode].fullGeotag;
+        size_t ncomp = startTag.find("::");
+
+        if (ncomp == std::string::npos) {
+          ncomp = startTag.size();
+        }
+
+        for (auto it = existingIdx.begin(); it != existingIdx.end(); ++it) {
+          const std::string& tag = (*tree->pTreeInfo)[*it].fullGeotag;
+
+          if (nAdjustCollocatedReplicas && startTag.compare(0, ncomp, tag) == 0 &&
+              (tag.size() == ncomp || tag[ncomp] == ':')) {
+            nAdjustCollocatedReplicas--;
+          }
+        }
+
+        if (nAdjustCollocatedReplicas > req.nNewReplicas) {
+          nAdjustCollocatedReplicas = req.nNewReplicas;
+        }
+      }
+
+      // the fs without enough space are not available for this request
+      for (auto it = tree->pFs2Idx->begin(); it != tree->pFs2Idx->end(); ++it) {
+        const SchedTreeBase::tFastTreeIdx& idx = (*it).second;
+
+        if ((tree->pNodes[idx].fsData.mStatus & SchedTreeBase::Available) &&
+            tree->pNodes[idx].fsData.totalSpace <= req.bookingSize) {
+          excludeIdx.push_back(idx);
+        }
+      }
+
+      res.newReplicas.clear();
+      res.success = tree->findFreeSlotsInPlace(newIdx, req.nNewReplicas,
+                    startFromNode, nAdjustCollocatedReplicas, &existingIdx,
+                    &excludeIdx);
+
+      if (!res.success) {
+        eos_debug("could not place the replicas of bulk request %lu", i);
+        continue;
+      }
+
+      for (auto it = newIdx.begin(); it != newIdx.end(); ++it) {
+        const SchedTreeBase::tFastTreeIdx& idx = *it;
+        const char netSpeedClass = (*ft->treeInfo)[idx].netSpeedClass;
+        const char dlPenalty = pPenaltySched.pPlctDlScorePenalty[netSpeedClass];
+        const char ulPenalty = pPenaltySched.pPlctUlScorePenalty[netSpeedClass];
+        res.newReplicas.push_back((*ft->treeInfo)[idx].fsId);
+        // book the space and apply the penalties in the working copy for the
+        // next requests of the batch
+        tree->bookFreeSlot(idx, req.bookingSize, dlPenalty, ulPenalty);
+
+        // and in the shared fast structures for the other placements
+        if (ft->placementTree->pNodes[idx].fsData.dlScore > 0) {
+          applyDlScorePenalty(ft, idx, dlPenalty);
+        }
+
+        if (ft->placementTree->pNodes[idx].fsData.ulScore > 0) {
+          applyUlScorePenalty(ft, idx, ulPenalty);
+        }
+      }
+    }
+  }
+
   template<class T> unsigned char accessReplicas(SchedTME* entry,
       const size_t& nNewReplicas,
       std::vector<SchedTreeBase::tFastTreeIdx>* accessedReplicas,
@@ -1609,8 +1806,10 @@ protected:
     regular,    // give priority to the closer and more idle proxy in a proxygroup
     any         // do the regular scheduling for all the filesystems
   } tProxySchedType;
+  // the fast structures of the file systems are supposed to be pinned by the
+  // caller of findProxy
   bool findProxy(const std::vector<SchedTreeBase::tFastTreeIdx>& fsidxs,
-                 std::vector<SchedTME*> entries,
+                 const std::vector<FastStructSched*>& fsFastStructs,
                  ino64_t inode,
                  std::vector<std::string>* proxies,
                  std::vector<std::string>* proxyGroups = NULL,
@@ -1797,6 +1996,30 @@ public:
                                 std::vector<eos::common::FileSystem::fsid_t>* excludeFs = NULL,
                                 std::vector<std::string>* excludeGeoTags = NULL);
 
+  // ---------------------------------------------------------------------------
+  //! Place the replicas of many files in one scheduling group at once.
+  //! This is meant for the batch operations (conversions, draining,
+  //! balancing): the lookup of the group, the locking of the fast structures
+  //! and the copy of the fast tree are done once per chunk of requests
+  //! instead of once per file. The placements of a batch see the space booked
+  //! and the penalties applied by the previous ones, so they stay spread.
+  //! No proxy nor firewall entry point is scheduled.
+  // @param group
+  //   the group to place the replicas in
+  // @param type
+  //   type of placement to be performed. It can be:
+  //     regularRO, regularRW or draining
+  // @param requests
+  //   the placement requests, see BulkPlacementRequest
+  // @param results
+  //   the placement decisions, in the same order as the requests
+  // @return
+  //   the number of requests successfully placed
+  // ---------------------------------------------------------------------------
+  size_t placeNewReplicasOneGroupBulk(FsGroup* group, SchedType type,
+                                      const std::vector<BulkPlacementRequest>& requests,
+                                      std::vector<BulkPlacementResult>& results);
+
   // this function to access replica spread across multiple scheduling group is a BACKCOMPATIBILITY artifact
   // the new scheduler doesn't try to place files across multiple scheduling groups.
   //  bool accessReplicasMultipleGroup(const size_t &nAccessReplicas,
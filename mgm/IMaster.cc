@@ -48,8 +48,18 @@ void IMaster::fillNamespaceCacheConfig(IConfigEngine *configEngine,
     }
   }
 
+  std::string npathsStr;
+  uint64_t npaths = 1'000'000;
+
+  if(configEngine->get("ns", "cache-size-npaths", npathsStr)) {
+    if(!common::ParseUInt64(npathsStr, npaths)) {
+      eos_static_crit("Could not parse 'cache-size-npaths' configuration value");
+    }
+  }
+
   namespaceConfig[constants::sMaxNumCacheFiles] = std::to_string(nfiles);
   namespaceConfig[constants::sMaxNumCacheDirs] = std::to_string(ndirs);
+  namespaceConfig[constants::sMaxNumCachePaths] = std::to_string(npaths);
 }
 
 EOSMGMNAMESPACE_END
@@ -195,6 +195,19 @@ IostatPeriods::GetSumForPeriod(Period period) const
   return sum;
 }
 
+//------------------------------------------------------------------------------
+// Add the bins of another object to the current one
+//------------------------------------------------------------------------------
+void
+IostatPeriods::Merge(const IostatPeriods& other)
+{
+  for (size_t pidx = 0; pidx < sNumberOfPeriods; ++pidx) {
+    for (size_t bin = 0; bin < sBinsPerPeriod; ++bin) {
+      mPeriodBins[pidx][bin] += other.mPeriodBins[pidx][bin];
+    }
+  }
+}
+
 //------------------------------------------------------------------------------
 // Iostat implementation
 //------------------------------------------------------------------------------
@@ -215,11 +228,6 @@ Iostat::Iostat():
   IoNodes.insert("cms-cdr"); // CMS DAQ
   IoNodes.insert("pc-tdq"); // ATLAS DAQ
 
-  for (size_t i = 0; i < IOSTAT_POPULARITY_HISTORY_DAYS; i++) {
-    IostatPopularity[i].set_deleted_key("");
-    IostatPopularity[i].resize(100000);
-  }
-
   mLastPopularityBin = 9999999;
 }
 
@@ -424,6 +432,30 @@ Iostat::StartCollection()
 
   if (!mRunning) {
     mRunning = true;
+    size_t num_workers = sDefaultIngestThreads;
+
+    if (getenv("EOS_MGM_IOSTAT_INGEST_THREADS")) {
+      num_workers = strtoul(getenv("EOS_MGM_IOSTAT_INGEST_THREADS"), nullptr, 10);
+
+      if (num_workers == 0) {
+        num_workers = 1;
+      }
+    }
+
+    mIngestQueues.clear();
+    mIngestThreads.clear();
+    mNumIngestThreads = num_workers;
+
+    for (size_t i = 0; i < num_workers; ++i) {
+      mIngestQueues.emplace_back
+      (std::make_unique<eos::common::ConcurrentQueue<std::string>>());
+    }
+
+    for (size_t i = 0; i < num_workers; ++i) {
+      mIngestThreads.emplace_back(std::make_unique<AssistedThread>());
+      mIngestThreads.back()->reset(&Iostat::Ingest, this, i);
+    }
+
     mReceivingThread.reset(&Iostat::Receive, this);
     StoreIostatConfig(&FsView::gFsView);
     return true;
@@ -442,6 +474,14 @@ Iostat::StopCollection()
 
   if (mRunning) {
     mReceivingThread.join();
+
+    for (auto& thread : mIngestThreads) {
+      thread->join();
+    }
+
+    mIngestThreads.clear();
+    mIngestQueues.clear();
+    mNumIngestThreads = 0;
     mRunning = false;
     StoreIostatConfig(&FsView::gFsView);
     return true;
@@ -658,6 +698,7 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
   }
 
   mq::ReportListener listener(gOFS->MgmOfsBroker.c_str(), gOFS->HostName);
+  size_t idx = 0;
 
   while (!assistant.terminationRequested()) {
     std::string newmessage;
@@ -667,219 +708,402 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
         break;
       }
 
-      XrdOucString body = newmessage.c_str();
+      ++mReportsReceived;
+      // Only hand over the raw message, parsing and accounting is done by
+      // the ingestion workers
+      auto& queue = mIngestQueues[idx++ % mIngestQueues.size()];
 
-      while (body.replace("&&", "&")) {
+      if (!queue->push_size(newmessage, sMaxQueuedReports)) {
+        ++mReportsDropped;
       }
+    }
 
-      XrdOucEnv ioreport(body.c_str());
-      time_t now = time(0);
-      std::unique_ptr<eos::common::Report> report(new eos::common::Report(ioreport));
-      Add("bytes_read", report->uid, report->gid, report->rb, report->ots,
-          report->cts, now);
-      Add("bytes_read", report->uid, report->gid, report->rvb_sum, report->ots,
-          report->cts, now);
-      Add("bytes_written", report->uid, report->gid, report->wb, report->ots,
-          report->cts, now);
-      Add("read_calls", report->uid, report->gid, report->nrc, report->ots,
-          report->cts, now);
-      Add("readv_calls", report->uid, report->gid, report->rv_op, report->ots,
-          report->cts, now);
-      Add("write_calls", report->uid, report->gid, report->nwc, report->ots,
-          report->cts, now);
-      Add("fwd_seeks", report->uid, report->gid, report->nfwds, report->ots,
-          report->cts, now);
-      Add("bwd_seeks", report->uid, report->gid, report->nbwds, report->ots,
-          report->cts, now);
-      Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds, report->ots,
-          report->cts, now);
-      Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds, report->ots,
-          report->cts, now);
-      Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb, report->ots,
-          report->cts, now);
-      Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb, report->ots,
-          report->cts, now);
-      Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb, report->ots,
-          report->cts, now);
-      Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb,
-          report->ots, report->cts, now);
-      Add("disk_time_read", report->uid, report->gid, report->rt,
-          report->ots, report->cts, now);
-      Add("disk_time_write", report->uid, report->gid,
-          report->wt, report->ots, report->cts, now);
-
-      if (report->dsize) {
-        Add("bytes_deleted", 0, 0, report->dsize, now - 30, now, now);
-        Add("files_deleted", 0, 0, 1, now - 30, now, now);
-      }
+    assistant.wait_for(std::chrono::seconds(1));
+  }
 
-      // Do the UDP broadcasting
-      UdpBroadCast(report.get());
+  eos_static_info("%s", "msg=\"stopping iostat receiver thread\"");
+}
 
-      // Do the domain accounting
-      if (report->path.substr(0, 11) == "/replicate:") {
-        // check if this is a replication path
-        // push into the 'eos' domain
-        std::unique_lock<std::mutex> scope_lock(mDataMutex);
+//------------------------------------------------------------------------------
+// Method executed by the threads parsing and accounting reports
+//------------------------------------------------------------------------------
+void
+Iostat::Ingest(ThreadAssistant& assistant, size_t idx) noexcept
+{
+  IostatPartial partial;
+  auto& queue = mIngestQueues[idx];
+  auto last_merge = std::chrono::steady_clock::now();
+  std::string msg;
 
-        if (report->rb) {
-          IostatPeriodsDomainIOrb["eos"].Add(report->rb, report->ots, report->cts, now);
-        }
+  while (!assistant.terminationRequested()) {
+    if (queue->wait_pop_for(msg, std::chrono::milliseconds(100))) {
+      ProcessReport(msg, partial);
+      ++mReportsProcessed;
+    }
 
-        if (report->wb) {
-          IostatPeriodsDomainIOwb["eos"].Add(report->wb, report->ots, report->cts, now);
-        }
-      } else {
-        bool dfound = false;
+    auto now = std::chrono::steady_clock::now();
 
-        if (mReportPopularity) {
-          // do the popularity accounting here for everything which is not replication!
-          AddToPopularity(report->path, report->rb, report->ots, report->cts);
-        }
+    if (now - last_merge >= sMergeInterval) {
+      MergePartial(partial);
+      last_merge = now;
+    }
+  }
 
-        size_t pos = 0;
+  // The receiver is already stopped, account the reports still queued
+  size_t drained = 0;
 
-        if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
-          // we can sort in by domain
-          std::string sdomain = report->sec_domain.substr(pos);
+  while (queue->try_pop(msg)) {
+    ProcessReport(msg, partial);
+    ++mReportsProcessed;
+    ++drained;
+  }
 
-          if (IoDomains.find(sdomain) != IoDomains.end()) {
-            std::unique_lock<std::mutex> scope_lock(mDataMutex);
+  MergePartial(partial);
+  eos_static_info("msg=\"stopping iostat ingestion thread\" idx=%lu "
+                  "drained_reports=%lu", idx, drained);
+}
 
-            if (report->rb) {
-              IostatPeriodsDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts, now);
-            }
+//------------------------------------------------------------------------------
+// Parse one report and account it into the given partial aggregate
+//------------------------------------------------------------------------------
+void
+Iostat::ProcessReport(const std::string& msg, IostatPartial& partial)
+{
+  if (gOFS == nullptr) {
+    return;
+  }
 
-            if (report->wb) {
-              IostatPeriodsDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts, now);
-            }
+  XrdOucString body;
+  std::unique_ptr<eos::common::Report> report;
 
-            dfound = true;
-          }
-        }
+  if (eos::common::Report::IsBinary(msg)) {
+    report = eos::common::Report::FromBinary(msg);
 
-        // do the node accounting here - keep the node list small !!!
-        std::set<std::string>::const_iterator nit;
+    if (report == nullptr) {
+      ++mReportsInvalid;
+      eos_static_err("%s", "msg=\"failed to decode binary report\"");
+      return;
+    }
 
-        for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
-          if (*nit == report->sec_host.substr(0, nit->length())) {
-            std::unique_lock<std::mutex> scope_lock(mDataMutex);
+    ++mReportsBinary;
+    // The report store always keeps the env representation
+    body = report->ToEnvString().c_str();
+  } else {
+    body = msg.c_str();
 
-            if (report->rb) {
-              IostatPeriodsDomainIOrb[*nit].Add(report->rb, report->ots, report->cts, now);
-            }
+    while (body.replace("&&", "&")) {
+    }
 
-            if (report->wb) {
-              IostatPeriodsDomainIOwb[*nit].Add(report->wb, report->ots, report->cts, now);
-            }
+    XrdOucEnv ioreport(body.c_str());
+    report.reset(new eos::common::Report(ioreport));
+  }
 
-            dfound = true;
-          }
-        }
+  time_t now = time(0);
+  {
+    // Lag between the close of the file on the FST and the accounting
+    long long lag_ms = std::chrono::duration_cast<std::chrono::milliseconds>
+                       (std::chrono::system_clock::now().time_since_epoch()).count() -
+                       (long long)(report->cts * 1000 + report->ctms);
+    mIngestLagMs = lag_ms;
+    long long max_lag = mMaxIngestLagMs;
+
+    while ((lag_ms > max_lag) &&
+           !mMaxIngestLagMs.compare_exchange_weak(max_lag, lag_ms)) {}
+  }
+
+  partial.Add("bytes_read", report->uid, report->gid, report->rb,
+              report->ots, report->cts, now);
+  partial.Add("bytes_read", report->uid, report->gid, report->rvb_sum,
+              report->ots, report->cts, now);
+  partial.Add("bytes_written", report->uid, report->gid, report->wb,
+              report->ots, report->cts, now);
+  partial.Add("read_calls", report->uid, report->gid, report->nrc,
+              report->ots, report->cts, now);
+  partial.Add("readv_calls", report->uid, report->gid, report->rv_op,
+              report->ots, report->cts, now);
+  partial.Add("write_calls", report->uid, report->gid, report->nwc,
+              report->ots, report->cts, now);
+  partial.Add("fwd_seeks", report->uid, report->gid, report->nfwds,
+              report->ots, report->cts, now);
+  partial.Add("bwd_seeks", report->uid, report->gid, report->nbwds,
+              report->ots, report->cts, now);
+  partial.Add("xl_fwd_seeks", report->uid, report->gid, report->nxlfwds,
+              report->ots, report->cts, now);
+  partial.Add("xl_bwd_seeks", report->uid, report->gid, report->nxlbwds,
+              report->ots, report->cts, now);
+  partial.Add("bytes_fwd_seek", report->uid, report->gid, report->sfwdb,
+              report->ots, report->cts, now);
+  partial.Add("bytes_bwd_wseek", report->uid, report->gid, report->sbwdb,
+              report->ots, report->cts, now);
+  partial.Add("bytes_xl_fwd_seek", report->uid, report->gid, report->sxlfwdb,
+              report->ots, report->cts, now);
+  partial.Add("bytes_xl_bwd_wseek", report->uid, report->gid, report->sxlbwdb,
+              report->ots, report->cts, now);
+  partial.Add("disk_time_read", report->uid, report->gid, report->rt,
+              report->ots, report->cts, now);
+  partial.Add("disk_time_write", report->uid, report->gid, report->wt,
+              report->ots, report->cts, now);
+
+  if (report->dsize) {
+    partial.Add("bytes_deleted", 0, 0, report->dsize, now - 30, now, now);
+    partial.Add("files_deleted", 0, 0, 1, now - 30, now, now);
+  }
+
+  // Do the UDP broadcasting
+  UdpBroadCast(report.get());
+
+  // Do the domain accounting
+  if (report->path.substr(0, 11) == "/replicate:") {
+    // check if this is a replication path
+    // push into the 'eos' domain
+    if (report->rb) {
+      partial.mDomainIOrb["eos"].Add(report->rb, report->ots, report->cts, now);
+    }
 
-        if (!dfound) {
-          // push into the 'other' domain
-          std::unique_lock<std::mutex> scope_lock(mDataMutex);
+    if (report->wb) {
+      partial.mDomainIOwb["eos"].Add(report->wb, report->ots, report->cts, now);
+    }
+  } else {
+    bool dfound = false;
 
-          if (report->rb) {
-            IostatPeriodsDomainIOrb["other"].Add(report->rb, report->ots, report->cts, now);
-          }
+    if (mReportPopularity) {
+      // do the popularity accounting here for everything which is not replication!
+      AddToPopularity(report->path, report->rb, report->ots, report->cts);
+    }
 
-          if (report->wb) {
-            IostatPeriodsDomainIOwb["other"].Add(report->wb, report->ots, report->cts, now);
-          }
+    size_t pos = 0;
+
+    if ((pos = report->sec_domain.rfind(".")) != std::string::npos) {
+      // we can sort in by domain
+      std::string sdomain = report->sec_domain.substr(pos);
+
+      if (IoDomains.find(sdomain) != IoDomains.end()) {
+        if (report->rb) {
+          partial.mDomainIOrb[sdomain].Add(report->rb, report->ots, report->cts, now);
         }
-      }
 
-      // do the application accounting here
-      std::string apptag = "other";
+        if (report->wb) {
+          partial.mDomainIOwb[sdomain].Add(report->wb, report->ots, report->cts, now);
+        }
 
-      if (report->sec_app.length()) {
-        apptag = report->sec_app;
+        dfound = true;
       }
+    }
 
-      // Push into app accounting
-      {
-        std::unique_lock<std::mutex> scope_lock(mDataMutex);
+    // do the node accounting here - keep the node list small !!!
+    std::set<std::string>::const_iterator nit;
 
+    for (nit = IoNodes.begin(); nit != IoNodes.end(); nit++) {
+      if (*nit == report->sec_host.substr(0, nit->length())) {
         if (report->rb) {
-          IostatPeriodsAppIOrb[apptag].Add(report->rb, report->ots, report->cts, now);
+          partial.mDomainIOrb[*nit].Add(report->rb, report->ots, report->cts, now);
         }
 
         if (report->wb) {
-          IostatPeriodsAppIOwb[apptag].Add(report->wb, report->ots, report->cts, now);
+          partial.mDomainIOwb[*nit].Add(report->wb, report->ots, report->cts, now);
         }
+
+        dfound = true;
       }
+    }
 
-      if (mReport && gOFS->mMaster->IsMaster()) {
-        // add the record to a daily report log file
-        static XrdOucString openreportfile = "";
-        time_t now = time(NULL);
-        struct tm nowtm;
-        XrdOucString reportfile = "";
-
-        if (localtime_r(&now, &nowtm)) {
-          static char logfile[4096];
-          snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
-                   gOFS->IoReportStorePath.c_str(),
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   1900 + nowtm.tm_year,
-                   nowtm.tm_mon + 1,
-                   nowtm.tm_mday);
-          reportfile = logfile;
-
-          if (reportfile == openreportfile) {
-            // just add it here;
-            if (gOpenReportFD) {
-              fprintf(gOpenReportFD, "%s\n", body.c_str());
-              fflush(gOpenReportFD);
-            }
-          } else {
-            std::unique_lock<std::mutex> scope_lock(mDataMutex);
-
-            if (gOpenReportFD) {
-              fclose(gOpenReportFD);
-            }
-
-            eos::common::Path cPath(reportfile.c_str());
-
-            if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
-              gOpenReportFD = fopen(reportfile.c_str(), "a+");
-
-              if (gOpenReportFD) {
-                fprintf(gOpenReportFD, "%s\n", body.c_str());
-                fflush(gOpenReportFD);
-              }
-
-              openreportfile = reportfile;
-            }
-          }
-        }
+    if (!dfound) {
+      // push into the 'other' domain
+      if (report->rb) {
+        partial.mDomainIOrb["other"].Add(report->rb, report->ots, report->cts, now);
+      }
+
+      if (report->wb) {
+        partial.mDomainIOwb["other"].Add(report->wb, report->ots, report->cts, now);
       }
+    }
+  }
+
+  // do the application accounting here
+  std::string apptag = "other";
+
+  if (report->sec_app.length()) {
+    apptag = report->sec_app;
+  }
+
+  // Push into app accounting
+  if (report->rb) {
+    partial.mAppIOrb[apptag].Add(report->rb, report->ots, report->cts, now);
+  }
 
-      if (mReportNamespace) {
-        // add the record into the report namespace file
-        char path[4096];
-        snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
-                 report->path.c_str());
-        eos::common::Path cPath(path);
+  if (report->wb) {
+    partial.mAppIOwb[apptag].Add(report->wb, report->ots, report->cts, now);
+  }
+
+  if (mReport && gOFS->mMaster->IsMaster()) {
+    // add the record to a daily report log file
+    std::unique_lock<std::mutex> file_lock(mReportFileMutex);
+    static XrdOucString openreportfile = "";
+    time_t now = time(NULL);
+    struct tm nowtm;
+    XrdOucString reportfile = "";
+
+    if (localtime_r(&now, &nowtm)) {
+      static char logfile[4096];
+      snprintf(logfile, sizeof(logfile) - 1, "%s/%04u/%02u/%04u%02u%02u.eosreport",
+               gOFS->IoReportStorePath.c_str(),
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               1900 + nowtm.tm_year,
+               nowtm.tm_mon + 1,
+               nowtm.tm_mday);
+      reportfile = logfile;
+
+      if (reportfile == openreportfile) {
+        // just add it here;
+        if (gOpenReportFD) {
+          fprintf(gOpenReportFD, "%s\n", body.c_str());
+          fflush(gOpenReportFD);
+        }
+      } else {
+        if (gOpenReportFD) {
+          fclose(gOpenReportFD);
+        }
+
+        eos::common::Path cPath(reportfile.c_str());
 
         if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
-          FILE* freport = fopen(path, "a+");
+          gOpenReportFD = fopen(reportfile.c_str(), "a+");
 
-          if (freport) {
-            fprintf(freport, "%s\n", body.c_str());
-            fclose(freport);
+          if (gOpenReportFD) {
+            fprintf(gOpenReportFD, "%s\n", body.c_str());
+            fflush(gOpenReportFD);
           }
+
+          openreportfile = reportfile;
         }
       }
     }
+  }
 
-    assistant.wait_for(std::chrono::seconds(1));
+  if (mReportNamespace) {
+    // add the record into the report namespace file
+    char path[4096];
+    snprintf(path, sizeof(path) - 1, "%s/%s", gOFS->IoReportStorePath.c_str(),
+             report->path.c_str());
+    eos::common::Path cPath(path);
+
+    if (cPath.MakeParentPath(S_IRWXU | S_IRGRP | S_IXGRP)) {
+      FILE* freport = fopen(path, "a+");
+
+      if (freport) {
+        fprintf(freport, "%s\n", body.c_str());
+        fclose(freport);
+      }
+    }
   }
+}
 
-  eos_static_info("%s", "msg=\"stopping iostat receiver thread\"");
+//------------------------------------------------------------------------------
+// Merge the partial aggregate of a worker into the global maps
+//------------------------------------------------------------------------------
+void
+Iostat::MergePartial(IostatPartial& partial)
+{
+  if (partial.mEmpty) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> scope_lock(mDataMutex);
+
+  for (const auto& tag : partial.mUid) {
+    auto& global = IostatUid[tag.first];
+
+    for (const auto& elem : tag.second) {
+      global[elem.first] += elem.second;
+    }
+  }
+
+  for (const auto& tag : partial.mGid) {
+    auto& global = IostatGid[tag.first];
+
+    for (const auto& elem : tag.second) {
+      global[elem.first] += elem.second;
+    }
+  }
+
+  for (const auto& tag : partial.mPeriodsUid) {
+    auto& global = IostatPeriodsUid[tag.first];
+
+    for (const auto& elem : tag.second) {
+      global[elem.first].Merge(elem.second);
+    }
+  }
+
+  for (const auto& tag : partial.mPeriodsGid) {
+    auto& global = IostatPeriodsGid[tag.first];
+
+    for (const auto& elem : tag.second) {
+      global[elem.first].Merge(elem.second);
+    }
+  }
+
+  for (const auto& elem : partial.mDomainIOrb) {
+    IostatPeriodsDomainIOrb[elem.first].Merge(elem.second);
+  }
+
+  for (const auto& elem : partial.mDomainIOwb) {
+    IostatPeriodsDomainIOwb[elem.first].Merge(elem.second);
+  }
+
+  for (const auto& elem : partial.mAppIOrb) {
+    IostatPeriodsAppIOrb[elem.first].Merge(elem.second);
+  }
+
+  for (const auto& elem : partial.mAppIOwb) {
+    IostatPeriodsAppIOwb[elem.first].Merge(elem.second);
+  }
+
+  // Flush to QDB if not in testing mode, one update per (tag, uid, gid)
+  // instead of one per report
+  if (gOFS && !mLegacyMode) {
+    for (const auto& elem : partial.mQdb) {
+      AddToQdb(std::get<0>(elem.first), std::get<1>(elem.first),
+               std::get<2>(elem.first), elem.second);
+    }
+  }
+
+  scope_lock.unlock();
+  partial.Clear();
+}
+
+//------------------------------------------------------------------------------
+// Record measurement in the partial aggregate
+//------------------------------------------------------------------------------
+void
+Iostat::IostatPartial::Add(const std::string& tag, uid_t uid, gid_t gid,
+                           unsigned long long val, time_t start, time_t stop,
+                           time_t now)
+{
+  mEmpty = false;
+  mQdb[std::make_tuple(tag, uid, gid)] += val;
+  mUid[tag][uid] += val;
+  mGid[tag][gid] += val;
+  mPeriodsUid[tag][uid].Add(val, start, stop, now);
+  mPeriodsGid[tag][gid].Add(val, start, stop, now);
+}
+
+//------------------------------------------------------------------------------
+// Drop all collected information
+//------------------------------------------------------------------------------
+void
+Iostat::IostatPartial::Clear()
+{
+  mUid.clear();
+  mGid.clear();
+  mPeriodsUid.clear();
+  mPeriodsGid.clear();
+  mDomainIOrb.clear();
+  mDomainIOwb.clear();
+  mAppIOrb.clear();
+  mAppIOwb.clear();
+  mQdb.clear();
+  mEmpty = true;
 }
 
 
@@ -889,8 +1113,7 @@ Iostat::Receive(ThreadAssistant& assistant) noexcept
 void
 Iostat::WriteRecord(const std::string& record)
 {
-  static std::mutex mutex;
-  std::unique_lock<std::mutex> scope_lock(mutex);
+  std::unique_lock<std::mutex> scope_lock(mReportFileMutex);
 
   if (gOpenReportFD) {
     fprintf(gOpenReportFD, "%s\n", record.c_str());
@@ -990,7 +1213,62 @@ Iostat::PrintOut(XrdOucString& out, bool summary, bool details,
 
         table_udp.AddRows(table_data);
         out += table_udp.GenerateTable(HEADER).c_str();
+        table_data.clear();
+      }
+    }
+    //! Report ingestion pipeline
+    {
+      unsigned long long received = mReportsReceived;
+      unsigned long long dropped = mReportsDropped;
+      unsigned long long processed = mReportsProcessed;
+      unsigned long long queued = ((received > dropped + processed) ?
+                                   (received - dropped - processed) : 0ull);
+
+      TableFormatterBase table_ingest;
+
+      if (!monitoring) {
+        table_ingest.SetHeader({
+          std::make_tuple("ingestion", 9, format_ss),
+          std::make_tuple("workers", 7, format_l),
+          std::make_tuple("received", 8, format_l),
+          std::make_tuple("processed", 8, format_l),
+          std::make_tuple("queued", 8, format_l),
+          std::make_tuple("dropped", 8, format_l),
+          std::make_tuple("binary", 8, format_l),
+          std::make_tuple("invalid", 8, format_l),
+          std::make_tuple("lag(ms)", 8, format_l),
+          std::make_tuple("max lag(ms)", 8, format_l)
+        });
+      } else {
+        table_ingest.SetHeader({
+          std::make_tuple("measurement", 0, format_ss),
+          std::make_tuple("workers", 0, format_l),
+          std::make_tuple("received", 0, format_l),
+          std::make_tuple("processed", 0, format_l),
+          std::make_tuple("queued", 0, format_l),
+          std::make_tuple("dropped", 0, format_l),
+          std::make_tuple("binary", 0, format_l),
+          std::make_tuple("invalid", 0, format_l),
+          std::make_tuple("lag_ms", 0, format_l),
+          std::make_tuple("max_lag_ms", 0, format_l)
+        });
       }
+
+      table_data.emplace_back();
+      TableRow& row = table_data.back();
+      row.emplace_back("reports", format_ss);
+      row.emplace_back(mNumIngestThreads.load(), format_ll);
+      row.emplace_back(received, format_ll);
+      row.emplace_back(processed, format_ll);
+      row.emplace_back(queued, format_ll);
+      row.emplace_back(dropped, format_ll);
+      row.emplace_back(mReportsBinary.load(), format_ll);
+      row.emplace_back(mReportsInvalid.load(), format_ll);
+      row.emplace_back(mIngestLagMs.load(), format_ll);
+      row.emplace_back(mMaxIngestLagMs.load(), format_ll);
+      table_ingest.AddRows(table_data);
+      out += table_ingest.GenerateTable(HEADER).c_str();
+      table_data.clear();
     }
   }
 
@@ -1417,7 +1695,8 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
   std::string format_lll = !monitoring ? "+l" : "ol";
   std::string unit = !monitoring ? "B" : "";
 
-  // The 'hotfiles' are the files with highest number of present file opens
+  // The 'hotfiles' are the files with highest (decayed) number of opens as
+  // reported by the FST heavy-hitters sketches
   if (hotfiles) {
     eos::common::RWMutexReadLock rLock(FsView::gFsView.ViewMutex);
     // print the hotfiles report
@@ -1595,15 +1874,13 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
     std::unique_lock<std::mutex> scope_lock(mPopularityMutex);
     size_t sbin = (IOSTAT_POPULARITY_HISTORY_DAYS + popularitybin - pbin) %
                   IOSTAT_POPULARITY_HISTORY_DAYS;
-    google::sparse_hash_map<std::string, struct Popularity>::const_iterator it;
-    std::vector<popularity_t> popularity_nread(IostatPopularity[sbin].begin(),
-        IostatPopularity[sbin].end());
-    std::vector<popularity_t> popularity_rb(IostatPopularity[sbin].begin(),
-                                            IostatPopularity[sbin].end());
-    // sort them (backwards) by rb or nread
-    std::sort(popularity_nread.begin(), popularity_nread.end(),
-              PopularityCmp_nread());
-    std::sort(popularity_rb.begin(), popularity_rb.end(), PopularityCmp_rb());
+    // Already sorted (backwards) by nread or rb and bounded by the sketch size
+    std::vector<PathPopularity::Entry> popularity_nread =
+      (bycount ? IostatPopularity[sbin].GetTopByCount(limit) :
+       std::vector<PathPopularity::Entry>());
+    std::vector<PathPopularity::Entry> popularity_rb =
+      (bybytes ? IostatPopularity[sbin].GetTopByBytes(limit) :
+       std::vector<PathPopularity::Entry>());
     XrdOucString marker = "\n┏━> Today\n";
 
     switch (pbin) {
@@ -1655,7 +1932,7 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
 
       size_t cnt = 0;
 
-      for (auto it : popularity_nread) {
+      for (const auto& it : popularity_nread) {
         cnt++;
 
         if (cnt > limit) {
@@ -1671,9 +1948,9 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
         }
 
         row.emplace_back((int) cnt, format_ll);
-        row.emplace_back(it.second.nread, format_lll);
-        row.emplace_back(it.second.rb, format_lll, unit);
-        row.emplace_back(it.first.c_str(), format_s);
+        row.emplace_back(it.nread, format_lll);
+        row.emplace_back(it.rb, format_lll, unit);
+        row.emplace_back(it.path.c_str(), format_s);
       }
 
       if (cnt > 0) {
@@ -1707,7 +1984,7 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
 
       size_t cnt = 0;
 
-      for (auto it : popularity_rb) {
+      for (const auto& it : popularity_rb) {
         cnt++;
 
         if (cnt > limit) {
@@ -1725,14 +2002,14 @@ Iostat::PrintNsPopularity(XrdOucString& out, XrdOucString option) const
         row.emplace_back((int) cnt, format_ll);
 
         if (!monitoring) {
-          row.emplace_back(it.second.rb, format_lll, unit);
-          row.emplace_back(it.second.nread, format_lll);
+          row.emplace_back(it.rb, format_lll, unit);
+          row.emplace_back(it.nread, format_lll);
         } else {
-          row.emplace_back(it.second.nread, format_lll);
-          row.emplace_back(it.second.rb, format_lll, unit);
+          row.emplace_back(it.nread, format_lll);
+          row.emplace_back(it.rb, format_lll, unit);
         }
 
-        row.emplace_back(it.first.c_str(), format_s);
+        row.emplace_back(it.path.c_str(), format_s);
       }
 
       table.AddRows(table_data);
@@ -1875,8 +2152,7 @@ Iostat::Circulate(ThreadAssistant& assistant) noexcept
     if (mLastPopularityBin != popularitybin) {
       // only if we enter a new bin we erase it
       std::unique_lock<std::mutex> scope_lock(mPopularityMutex);
-      IostatPopularity[popularitybin].clear();
-      IostatPopularity[popularitybin].resize(10000);
+      IostatPopularity[popularitybin].Clear();
       mLastPopularityBin = popularitybin;
     }
   }
@@ -2275,14 +2551,8 @@ Iostat::AddToPopularity(const std::string& path, unsigned long long rb,
 {
   size_t popularitybin = (((start + stop) / 2) % (IOSTAT_POPULARITY_DAY *
                           IOSTAT_POPULARITY_HISTORY_DAYS)) / IOSTAT_POPULARITY_DAY;
-  eos::common::Path cPath(path.c_str());
   std::unique_lock<std::mutex> scope_lock(mPopularityMutex);
-
-  for (size_t k = 0; k < cPath.GetSubPathSize(); ++k) {
-    std::string sp = cPath.GetSubPath(k);
-    IostatPopularity[popularitybin][sp].rb += rb;
-    IostatPopularity[popularitybin][sp].nread++;
-  }
+  IostatPopularity[popularitybin].Add(path, rb);
 }
 
 //------------------------------------------------------------------------------
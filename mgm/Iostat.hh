@@ -23,13 +23,19 @@
 
 #pragma once
 #include "common/AssistedThread.hh"
+#include "common/ConcurrentQueue.hh"
 #include "common/StringConversion.hh"
 #include "mgm/FsView.hh"
 #include "mgm/Namespace.hh"
+#include "mgm/PathPopularity.hh"
 #include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
 #include "namespace/ns_quarkdb/qclient/include/qclient/structures/QHash.hh"
 #include <arpa/inet.h>
 #include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <tuple>
 #include <google/sparse_hash_map>
 #include <netinet/in.h>
 #include <set>
@@ -102,6 +108,13 @@ public:
   //----------------------------------------------------------------------------
   unsigned long long GetSumForPeriod(Period period) const;
 
+  //----------------------------------------------------------------------------
+  //! Add the bins of another object to the current one
+  //!
+  //! @param other object to merge
+  //----------------------------------------------------------------------------
+  void Merge(const IostatPeriods& other);
+
 private:
 #ifdef IN_TEST_HARNESS
 public:
@@ -186,6 +199,16 @@ public:
   //----------------------------------------------------------------------------
   void Receive(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Method executed by the threads parsing and accounting reports. Each
+  //! worker aggregates into a private IostatPartial which is periodically
+  //! merged into the global maps.
+  //!
+  //! @param assistant reference to thread object
+  //! @param idx index of the worker and of its queue
+  //----------------------------------------------------------------------------
+  void Ingest(ThreadAssistant& assistant, size_t idx) noexcept;
+
   //----------------------------------------------------------------------------
   //! Method executed by the thread ciruclating the entires
   //!
@@ -339,6 +362,42 @@ public:
 #endif
   inline static const std::string USER_ID_TYPE = "u";
   inline static const std::string GROUP_ID_TYPE = "g";
+  //! Default number of report ingestion workers
+  static constexpr size_t sDefaultIngestThreads = 4;
+  //! Max number of reports queued per ingestion worker before dropping
+  static constexpr size_t sMaxQueuedReports = 100000;
+  //! Interval after which a worker merges its partial aggregate
+  static constexpr std::chrono::milliseconds sMergeInterval {250};
+
+  //----------------------------------------------------------------------------
+  //! Partial aggregate collected by one ingestion worker between two merges
+  //! into the global maps so that workers don't contend on the mDataMutex
+  //----------------------------------------------------------------------------
+  struct IostatPartial {
+    std::map<std::string, std::map<uid_t, unsigned long long>> mUid;
+    std::map<std::string, std::map<gid_t, unsigned long long>> mGid;
+    std::map<std::string, std::map<uid_t, IostatPeriods>> mPeriodsUid;
+    std::map<std::string, std::map<gid_t, IostatPeriods>> mPeriodsGid;
+    std::map<std::string, IostatPeriods> mDomainIOrb;
+    std::map<std::string, IostatPeriods> mDomainIOwb;
+    std::map<std::string, IostatPeriods> mAppIOrb;
+    std::map<std::string, IostatPeriods> mAppIOwb;
+    //! Deltas to be sent to QDB per (tag, uid, gid)
+    std::map<std::tuple<std::string, uid_t, gid_t>, unsigned long long> mQdb;
+    bool mEmpty = true;
+
+    //--------------------------------------------------------------------------
+    //! Record measurement, same semantics as Iostat::Add
+    //--------------------------------------------------------------------------
+    void Add(const std::string& tag, uid_t uid, gid_t gid,
+             unsigned long long val, time_t start, time_t stop, time_t now);
+
+    //--------------------------------------------------------------------------
+    //! Drop all collected information
+    //--------------------------------------------------------------------------
+    void Clear();
+  };
+
   google::sparse_hash_map<std::string,
          google::sparse_hash_map<uid_t, unsigned long long>> IostatUid;
   google::sparse_hash_map<std::string,
@@ -375,6 +434,22 @@ public:
   std::string mHashKeyBase;
   std::mutex mThreadSyncMutex; ///< Mutex serializing thread(s) start/stop
   AssistedThread mReceivingThread; ///< Looping thread receiving reports
+  //! Threads parsing and accounting the received reports
+  std::vector<std::unique_ptr<AssistedThread>> mIngestThreads;
+  //! Queues of raw reports, one per ingestion thread
+  std::vector<std::unique_ptr<eos::common::ConcurrentQueue<std::string>>>
+  mIngestQueues;
+  std::atomic<unsigned long long> mNumIngestThreads {0}; ///< Running workers
+  std::atomic<unsigned long long> mReportsReceived {0}; ///< Fetched reports
+  std::atomic<unsigned long long> mReportsDropped {0}; ///< Dropped, queue full
+  std::atomic<unsigned long long> mReportsProcessed {0}; ///< Accounted reports
+  std::atomic<unsigned long long> mReportsBinary {0}; ///< Binary encoded reports
+  std::atomic<unsigned long long> mReportsInvalid {0}; ///< Undecodable reports
+  //! Lag between report close time and accounting in the last/max report (ms)
+  std::atomic<long long> mIngestLagMs {0};
+  std::atomic<long long> mMaxIngestLagMs {0};
+  //! Mutex protecting the daily report file
+  std::mutex mReportFileMutex;
   AssistedThread mCirculateThread; ///< Looping thread circulating report
   //! Mutex protecting the UDP broadcast data structures that follow
   mutable std::mutex mBcastMutex;
@@ -386,45 +461,10 @@ public:
   std::map<std::string, struct sockaddr_in> mUdpSockAddr;
   //! Mutex protecting the popularity data structures
   mutable std::mutex mPopularityMutex;
-  //! Popularity data structure
-  struct Popularity {
-    unsigned int nread;
-    unsigned long long rb;
-  };
-
   //! Points to the bin which was last used in IostatPopularity
   std::atomic<size_t> mLastPopularityBin;
-  google::sparse_hash_map<std::string, struct Popularity>
-    IostatPopularity[IOSTAT_POPULARITY_HISTORY_DAYS];
-  typedef std::pair<std::string, struct Popularity> popularity_t;
-
-  //----------------------------------------------------------------------------
-  //! Value comparator for number of reads
-  //----------------------------------------------------------------------------
-  struct PopularityCmp_nread {
-    bool operator()(popularity_t const& l, popularity_t const& r)
-    {
-      if (l.second.nread == r.second.nread) {
-        return (l.first < r.first);
-      }
-
-      return l.second.nread > r.second.nread;
-    }
-  };
-
-  //---------------------------------------------------------------------------
-  //! Value comparator for read bytes
-  //----------------------------------------------------------------------------
-  struct PopularityCmp_rb {
-    bool operator()(popularity_t const& l, popularity_t const& r)
-    {
-      if (l.second.rb == r.second.rb) {
-        return (l.first < r.first);
-      }
-
-      return l.second.rb > r.second.rb;
-    }
-  };
+  //! Bounded popularity ranking per day bin
+  PathPopularity IostatPopularity[IOSTAT_POPULARITY_HISTORY_DAYS];
 
   //----------------------------------------------------------------------------
   //! Record measurements directly in QDB
@@ -464,6 +504,23 @@ public:
   void AddToPopularity(const std::string& path, unsigned long long rb,
                        time_t start, time_t stop);
 
+  //----------------------------------------------------------------------------
+  //! Parse one report and account it into the given partial aggregate. The
+  //! popularity, UDP broadcast and report store are updated directly.
+  //!
+  //! @param body report message body either env or binary encoded
+  //! @param partial worker partial aggregate
+  //----------------------------------------------------------------------------
+  void ProcessReport(const std::string& body, IostatPartial& partial);
+
+  //----------------------------------------------------------------------------
+  //! Merge the partial aggregate of a worker into the global maps and send
+  //! the accumulated deltas to QDB. The partial is cleared afterwards.
+  //!
+  //! @param partial worker partial aggregate
+  //----------------------------------------------------------------------------
+  void MergePartial(IostatPartial& partial);
+
   //----------------------------------------------------------------------------
   //! One off migration from file based to QDB of IoStat information
   //!
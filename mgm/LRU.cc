@@ -31,6 +31,7 @@
 #include "mgm/LRU.hh"
 #include "mgm/Stat.hh"
 #include "mgm/Master.hh"
+#include "mgm/PolicyIndex.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/interface/ContainerIterators.hh"
@@ -217,29 +218,114 @@ void LRU::performCycleInMem(ThreadAssistant& assistant) noexcept
 //------------------------------------------------------------------------------
 void LRU::performCycleQDB(ThreadAssistant& assistant) noexcept
 {
-  eos_static_info("%s", "msg=\"start LRU scan on QDB\"");
-  // Build exploration options..
-  ExplorationOptions opts;
-  opts.populateLinkedAttributes = true;
-  opts.view = gOFS->eosView;
-  opts.ignoreFiles = true;
-
   // Initialize qclient..
   if (!mQcl) {
     mQcl.reset(new qclient::QClient(gOFS->mQdbContactDetails.members,
                                     gOFS->mQdbContactDetails.constructOptions()));
   }
 
+  if (!PolicyIndex::IsBuilt(*(mQcl.get()))) {
+    performScanQDB(assistant);
+    return;
+  }
+
+  eos_static_info("%s", "msg=\"start LRU cycle using the policy index\"");
+  std::set<eos::IContainerMD::id_t> ids;
+
+  // Directories with linked attributes might get their policy from the
+  // linked directory so they are also taken into account
+  for (const auto& prefix : PolicyIndex::sPrefixes) {
+    if (!PolicyIndex::GetIds(*(mQcl.get()), prefix, ids)) {
+      return;
+    }
+  }
+
+  std::map<std::string, eos::IContainerMD::id_t> lrudirs;
+
+  for (const auto& id : ids) {
+    eos::Prefetcher::prefetchContainerMDWithParentsAndWait(gOFS->eosView, id);
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex, __FUNCTION__,
+                                            __LINE__, __FILE__);
+    std::shared_ptr<eos::IContainerMD> cmd;
+    std::string uri;
+
+    try {
+      cmd = gOFS->eosDirectoryService->getContainerMD(id);
+      uri = gOFS->eosView->getUri(cmd.get());
+    } catch (const eos::MDException& e) {
+      // Container removed without going through _remdir
+      cmd.reset();
+    }
+
+    // Also drops the entries of containers which lost their policy attributes
+    if (PolicyIndex::CheckEntry(id, cmd.get())) {
+      lrudirs[uri] = id;
+    } else {
+      eos_static_info("msg=\"drop stale policy index entry\" cid=%llu", id);
+    }
+  }
+
+  eos_static_info("msg=\"LRU policy index loaded\" LRU-dirs=%llu",
+                  lrudirs.size());
+  int64_t processed = 0;
+
+  // Scan backwards ... in this way we get rid of empty directories in one go
+  for (auto it = lrudirs.rbegin(); it != lrudirs.rend(); ++it) {
+    eos_static_debug("lru-dir-qdb=\"%s\"", it->first.c_str());
+    eos::IContainerMD::XAttrMap map;
+
+    if (!gOFS->_attr_ls(it->first.c_str(), mError, mRootVid,
+                        (const char*) 0, map, true, true)) {
+      processDirectory(it->first, 0, map);
+    }
+
+    if (++processed % 1000 == 0) {
+      eos_static_info("msg=\"LRU cycle in progress\" num_processed_dirs=%lli",
+                      processed);
+
+      if (assistant.terminationRequested()) {
+        eos_static_info("%s", "msg=\"termination requested, quit LRU\"");
+        break;
+      }
+    }
+  }
+
+  eos_static_info("msg=\"LRU cycle done\" num_processed_dirs=%lli", processed);
+}
+
+//------------------------------------------------------------------------------
+// Perform a single LRU cycle by exploring the QDB namespace and build the
+// policy index on the way
+//------------------------------------------------------------------------------
+void LRU::performScanQDB(ThreadAssistant& assistant) noexcept
+{
+  eos_static_info("%s", "msg=\"start LRU scan on QDB\"");
+  // Build exploration options..
+  ExplorationOptions opts;
+  opts.populateLinkedAttributes = true;
+  opts.view = gOFS->eosView;
+  opts.ignoreFiles = true;
+  opts.parallelism = ExplorationOptions::sDefaultParallelism;
+  opts.ordered = false;
   // Start exploring
   NamespaceExplorer
   explorer("/", opts, *(mQcl.get()),
            static_cast<QuarkNamespaceGroup*>(gOFS->namespaceGroup.get())->getExecutor());
   NamespaceItem item;
   int64_t processed = 0;
+  bool complete = true;
 
   while (explorer.fetch(item)) {
     eos_static_debug("lru-dir-qdb=\"%s\" attrs=%d", item.fullPath.c_str(),
                      item.attrs.size());
+    // Index the own attributes, the linked ones are only used for processing
+    eos::IContainerMD::XAttrMap own_attrs;
+
+    for (const auto& elem : item.containerMd.xattrs()) {
+      own_attrs[elem.first] = elem.second;
+    }
+
+    PolicyIndex::Add(item.containerMd.id(), own_attrs);
     processDirectory(item.fullPath, 0, item.attrs);
     processed++;
 
@@ -249,11 +335,16 @@ void LRU::performCycleQDB(ThreadAssistant& assistant) noexcept
 
       if (assistant.terminationRequested()) {
         eos_static_info("%s", "msg=\"termination requested, quit LRU\"");
+        complete = false;
         break;
       }
     }
   }
 
+  if (complete) {
+    PolicyIndex::MarkBuilt();
+  }
+
   eos_static_info("msg=\"LRU scan done\" num_scanned_dirs=%lli", processed);
 }
 
@@ -178,6 +178,12 @@ private:
   //----------------------------------------------------------------------------
   void performCycleQDB(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  // Perform a single LRU cycle by exploring the QDB namespace, used until the
+  // policy index is built
+  //----------------------------------------------------------------------------
+  void performScanQDB(ThreadAssistant& assistant) noexcept;
+
   std::unique_ptr<qclient::QClient> mQcl; ///< Internal QCl object
   AssistedThread mThread; ///< thread id of the LRU thread
   eos::common::VirtualIdentity mRootVid; ///< Uses the root vid
@@ -77,7 +77,9 @@ Messaging::Listen(ThreadAssistant& assistant) noexcept
     int64_t t2  =  std::chrono::duration_cast<std::chrono::milliseconds>
                    (std::chrono::steady_clock::now().time_since_epoch()).count();
 
-    if ((t2 - t1) > 2000) {
+    // A long-poll receive is expected to last
+    if (((t2 - t1) > 2000) &&
+        !XrdMqMessaging::gMessageClient.HasLongPolled()) {
       eos_warning("MQ heartbeat recv lasted %ld milliseconds",
                   t2 - t1);
     }
@@ -91,7 +93,7 @@ Messaging::Listen(ThreadAssistant& assistant) noexcept
         eos_warning("MQ heartbeat processing lasted %ld milliseconds",
                     t3 - t2);
       }
-    } else {
+    } else if (!XrdMqMessaging::gMessageClient.HasLongPolled()) {
       assistant.wait_for(std::chrono::seconds(1));
     }
   }
@@ -0,0 +1,414 @@
+//------------------------------------------------------------------------------
+// File: NsCacheWarmUp.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/NsCacheWarmUp.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/Prefetcher.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/ResponseParsing.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/structures/QHash.hh"
+#include <algorithm>
+#include <sstream>
+
+EOSMGMNAMESPACE_BEGIN
+
+const std::string NsCacheWarmUp::sHotIdsKey {"eos-md-cache-hot-ids"};
+constexpr std::chrono::seconds NsCacheWarmUp::sPersistInterval;
+constexpr std::chrono::seconds NsCacheWarmUp::sSampleInterval;
+constexpr std::chrono::seconds NsCacheWarmUp::sMaxRecovery;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+NsCacheWarmUp::NsCacheWarmUp(qclient::QClient& qcl):
+  mQcl(qcl), mLastPersist(std::chrono::steady_clock::now())
+{
+  if (getenv("EOS_MGM_NS_CACHE_WARMUP_RATE")) {
+    mRate = strtoull(getenv("EOS_MGM_NS_CACHE_WARMUP_RATE"), nullptr, 10);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+NsCacheWarmUp::~NsCacheWarmUp()
+{
+  Stop();
+}
+
+//------------------------------------------------------------------------------
+// Store the ids of the most recently used cache entries in QDB
+//------------------------------------------------------------------------------
+bool
+NsCacheWarmUp::Persist(eos::IFileMDSvc* file_svc,
+                       eos::IContainerMDSvc* cont_svc)
+{
+  mLastPersist = std::chrono::steady_clock::now();
+  std::vector<uint64_t> file_ids;
+  std::vector<uint64_t> cont_ids;
+
+  for (const auto& id : file_svc->getRecentlyUsedIds(sMaxFileIds)) {
+    file_ids.push_back(id.getUnderlyingUInt64());
+  }
+
+  for (const auto& id : cont_svc->getRecentlyUsedIds(sMaxContainerIds)) {
+    cont_ids.push_back(id.getUnderlyingUInt64());
+  }
+
+  if (file_ids.empty() && cont_ids.empty()) {
+    return true;
+  }
+
+  // Hit rate since the last persist, not representative while warming up
+  const eos::CacheStatistics stats = file_svc->getCacheStatistics();
+  const uint64_t hits = stats.hits - mPersistHits;
+  const uint64_t lookups = hits + stats.misses - mPersistMisses;
+  mPersistHits = stats.hits;
+  mPersistMisses = stats.misses;
+  double hit_rate = -1.0;
+
+  if (lookups && (mState != State::kRunning)) {
+    hit_rate = (double) hits / lookups;
+  }
+
+  std::vector<std::string> entries {
+    "files", EncodeIds(file_ids),
+    "containers", EncodeIds(cont_ids),
+    "file_hit_rate", std::to_string(hit_rate),
+    "timestamp", std::to_string(time(nullptr))
+  };
+  qclient::QHash qhash(mQcl, sHotIdsKey);
+
+  try {
+    if (!qhash.hmset(entries)) {
+      eos_err("%s", "msg=\"failed to persist namespace cache hot ids\"");
+      return false;
+    }
+  } catch (const std::exception& e) {
+    eos_err("msg=\"failed to persist namespace cache hot ids\" emsg=\"%s\"",
+            e.what());
+    return false;
+  }
+
+  eos_info("msg=\"persisted namespace cache hot ids\" files=%llu "
+           "containers=%llu bytes=%llu file_hit_rate=%.3f", file_ids.size(),
+           cont_ids.size(), entries[1].size() + entries[3].size(), hit_rate);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Persist if at least the persist interval passed since the last time
+//------------------------------------------------------------------------------
+void
+NsCacheWarmUp::PersistIfDue(eos::IFileMDSvc* file_svc,
+                            eos::IContainerMDSvc* cont_svc)
+{
+  if (std::chrono::steady_clock::now() - mLastPersist >= sPersistInterval) {
+    (void) Persist(file_svc, cont_svc);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Start warming up the cache in a separate thread
+//------------------------------------------------------------------------------
+void
+NsCacheWarmUp::Start(eos::IView* view, eos::IFileMDSvc* file_svc,
+                     eos::IContainerMDSvc* cont_svc)
+{
+  Stop();
+
+  if (mRate == 0) {
+    eos_info("%s", "msg=\"namespace cache warm up disabled\"");
+    return;
+  }
+
+  mView = view;
+  mFileSvc = file_svc;
+  mContSvc = cont_svc;
+  mThread.reset(&NsCacheWarmUp::WarmUp, this);
+}
+
+//------------------------------------------------------------------------------
+// Stop warming up the cache
+//------------------------------------------------------------------------------
+void
+NsCacheWarmUp::Stop()
+{
+  mThread.join();
+}
+
+//------------------------------------------------------------------------------
+// Get status of the warm up
+//------------------------------------------------------------------------------
+std::string
+NsCacheWarmUp::GetStatus() const
+{
+  static const char* sStates[] = {"idle", "running", "done", "failed"};
+  std::ostringstream oss;
+  const uint64_t total = mTotal;
+  oss << "ns_cache_warmup=" << sStates[(int) mState.load()]
+      << " ns_cache_warmup_progress="
+      << (total ? (100 * mDone / total) : 100) << "%"
+      << " ns_cache_warmup_ms=" << mWarmUpMs
+      << " ns_cache_hit_rate_recovery_sec=" << mRecoverySec;
+  return oss.str();
+}
+
+//------------------------------------------------------------------------------
+// Encode list of ids
+//------------------------------------------------------------------------------
+std::string
+NsCacheWarmUp::EncodeIds(const std::vector<uint64_t>& ids)
+{
+  std::string data;
+  data.reserve(ids.size() * 4);
+  uint64_t prev = 0;
+
+  for (const auto id : ids) {
+    const int64_t delta = (int64_t)(id - prev);
+    uint64_t zz = ((uint64_t) delta << 1) ^ (uint64_t)(delta >> 63);
+    prev = id;
+
+    while (zz >= 0x80) {
+      data += (char)((zz & 0x7f) | 0x80);
+      zz >>= 7;
+    }
+
+    data += (char) zz;
+  }
+
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Decode list of ids
+//------------------------------------------------------------------------------
+bool
+NsCacheWarmUp::DecodeIds(const std::string& data, std::vector<uint64_t>& ids)
+{
+  ids.clear();
+  uint64_t prev = 0;
+  size_t pos = 0;
+
+  while (pos < data.size()) {
+    uint64_t zz = 0;
+    int shift = 0;
+
+    while (true) {
+      if ((pos >= data.size()) || (shift > 63)) {
+        return false;
+      }
+
+      const uint8_t byte = data[pos++];
+      zz |= (uint64_t)(byte & 0x7f) << shift;
+      shift += 7;
+
+      if ((byte & 0x80) == 0) {
+        break;
+      }
+    }
+
+    prev += (uint64_t)((int64_t)(zz >> 1) ^ -(int64_t)(zz & 1));
+    ids.push_back(prev);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Read the hot ids from QDB
+//------------------------------------------------------------------------------
+bool
+NsCacheWarmUp::Load(std::vector<uint64_t>& file_ids,
+                    std::vector<uint64_t>& cont_ids, double& hit_rate)
+{
+  qclient::redisReplyPtr reply;
+
+  try {
+    reply = mQcl.exec("HGETALL", sHotIdsKey).get();
+  } catch (const std::exception& e) {
+    eos_err("msg=\"failed to read namespace cache hot ids\" emsg=\"%s\"",
+            e.what());
+    return false;
+  }
+
+  qclient::HgetallParser parser(reply);
+
+  if (!parser.ok() || parser.value().empty()) {
+    return false;
+  }
+
+  std::map<std::string, std::string> fields = parser.value();
+
+  if (!DecodeIds(fields["files"], file_ids) ||
+      !DecodeIds(fields["containers"], cont_ids)) {
+    eos_err("%s", "msg=\"failed to decode namespace cache hot ids\"");
+    return false;
+  }
+
+  try {
+    hit_rate = std::stod(fields["file_hit_rate"]);
+  } catch (...) {
+    hit_rate = -1.0;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Sample the live file cache hit rate and check if it recovered
+//------------------------------------------------------------------------------
+bool
+NsCacheWarmUp::SampleHitRate(double target)
+{
+  // The prefetching goes through the same cache lookups as the live traffic,
+  // count every id prefetched since the last sample as a miss of our own
+  const eos::CacheStatistics stats = mFileSvc->getCacheStatistics();
+  const uint64_t done = mDone;
+  const uint64_t hits = stats.hits - mSampleHits;
+  const uint64_t own = done - mSampleDone;
+  uint64_t misses = stats.misses - mSampleMisses;
+  misses = (misses > own) ? (misses - own) : 0;
+  mSampleHits = stats.hits;
+  mSampleMisses = stats.misses;
+  mSampleDone = done;
+
+  if (hits + misses == 0) {
+    return false;
+  }
+
+  mHitRate = (double) hits / (hits + misses);
+
+  if ((target < 0) || (mHitRate < target)) {
+    return false;
+  }
+
+  mRecoverySec = std::chrono::duration_cast<std::chrono::seconds>
+                 (std::chrono::steady_clock::now() - mStart).count();
+  eos_notice("msg=\"namespace cache hit rate recovered\" hit_rate=%.3f "
+             "target=%.3f recovery_sec=%lld", mHitRate.load(), target,
+             (long long) mRecoverySec);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Method doing the warm up
+//------------------------------------------------------------------------------
+void
+NsCacheWarmUp::WarmUp(ThreadAssistant& assistant) noexcept
+{
+  using namespace std::chrono;
+  mStart = steady_clock::now();
+  mDone = 0;
+  mTotal = 0;
+  mWarmUpMs = 0;
+  mRecoverySec = -1;
+  mHitRate = -1.0;
+  std::vector<uint64_t> file_ids;
+  std::vector<uint64_t> cont_ids;
+  double prev_hit_rate = -1.0;
+
+  if (!Load(file_ids, cont_ids, prev_hit_rate)) {
+    eos_info("%s", "msg=\"no namespace cache hot ids to warm up from\"");
+    mState = State::kFailed;
+    return;
+  }
+
+  const eos::CacheStatistics stats = mFileSvc->getCacheStatistics();
+  mSampleHits = stats.hits;
+  mSampleMisses = stats.misses;
+  mSampleDone = 0;
+  mTotal = file_ids.size() + cont_ids.size();
+  mState = State::kRunning;
+  const double target = (prev_hit_rate < 0) ? -1.0 :
+                        prev_hit_rate * sRecoveredRatio;
+  bool recovered = false;
+  uint64_t next_report = mTotal / 10;
+  auto last_sample = steady_clock::now();
+  eos_notice("msg=\"start namespace cache warm up\" files=%llu containers=%llu "
+             "rate=%llu target_hit_rate=%.3f", file_ids.size(), cont_ids.size(),
+             mRate, target);
+
+  // Containers first as they are needed by every path lookup
+  for (const bool is_file : {
+         false, true
+       }) {
+    const std::vector<uint64_t>& ids = is_file ? file_ids : cont_ids;
+
+    for (size_t pos = 0; (pos < ids.size()) &&
+         !assistant.terminationRequested(); pos += sBatchSize) {
+      const size_t end = std::min(pos + sBatchSize, ids.size());
+      eos::Prefetcher prefetcher(mView);
+
+      for (size_t i = pos; i < end; ++i) {
+        if (is_file) {
+          prefetcher.stageFileMD(ids[i]);
+        } else {
+          prefetcher.stageContainerMD(ids[i]);
+        }
+      }
+
+      prefetcher.wait();
+      mDone += end - pos;
+
+      if (mDone >= next_report) {
+        eos_info("msg=\"namespace cache warm up progress\" done=%llu total=%llu "
+                 "percent=%llu", mDone.load(), mTotal.load(),
+                 100 * mDone / mTotal);
+        next_report += std::max(mTotal / 10, (uint64_t) 1);
+      }
+
+      if (!recovered && (steady_clock::now() - last_sample >= sSampleInterval)) {
+        recovered = SampleHitRate(target);
+        last_sample = steady_clock::now();
+      }
+
+      // Rate limit so that the live traffic is not starved
+      const auto due = mStart + microseconds(mDone * 1000000 / mRate);
+
+      if (due > steady_clock::now()) {
+        assistant.wait_for(due - steady_clock::now());
+      }
+    }
+  }
+
+  mWarmUpMs = duration_cast<milliseconds>(steady_clock::now() - mStart).count();
+  mState = State::kDone;
+  eos_notice("msg=\"finished namespace cache warm up\" done=%llu total=%llu "
+             "duration_ms=%llu", mDone.load(), mTotal.load(), mWarmUpMs.load());
+
+  // Keep watching the hit rate until it recovers
+  while (!recovered && (target >= 0) && !assistant.terminationRequested() &&
+         (steady_clock::now() - mStart < sMaxRecovery)) {
+    assistant.wait_for(sSampleInterval);
+    recovered = SampleHitRate(target);
+  }
+
+  if (!recovered && (target >= 0)) {
+    eos_warning("msg=\"namespace cache hit rate did not recover\" "
+                "hit_rate=%.3f target=%.3f", mHitRate.load(), target);
+  }
+}
+
+EOSMGMNAMESPACE_END
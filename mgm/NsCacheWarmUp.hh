@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------------
+//! @file NsCacheWarmUp.hh
+//! @brief Persist the hot namespace cache entries and warm up the cache of a
+//!        new master
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/AssistedThread.hh"
+#include "common/Logging.hh"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//! Forward declarations
+namespace qclient
+{
+class QClient;
+}
+
+namespace eos
+{
+class IView;
+class IFileMDSvc;
+class IContainerMDSvc;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class NsCacheWarmUp
+//!
+//! The master periodically stores in QDB the ids of the most recently used
+//! files and containers of its metadata cache together with the cache hit
+//! rate observed at that time. After a failover the new master reads the list
+//! back and prefetches the entries in batches, rate limited so that the live
+//! traffic still gets its share of the QDB connections. Containers are
+//! loaded first since every path lookup goes through them. The time it takes
+//! for the file cache hit rate to get back to the level of the previous
+//! master is reported as the hit rate recovery time.
+//------------------------------------------------------------------------------
+class NsCacheWarmUp: public eos::common::LogId
+{
+public:
+  //! QDB hash holding the hot ids
+  static const std::string sHotIdsKey;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qcl qclient object used to talk to QDB
+  //----------------------------------------------------------------------------
+  NsCacheWarmUp(qclient::QClient& qcl);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~NsCacheWarmUp();
+
+  //----------------------------------------------------------------------------
+  //! Store the ids of the most recently used cache entries in QDB. Does
+  //! nothing if the cache is empty.
+  //!
+  //! @param file_svc file metadata service
+  //! @param cont_svc container metadata service
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Persist(eos::IFileMDSvc* file_svc, eos::IContainerMDSvc* cont_svc);
+
+  //----------------------------------------------------------------------------
+  //! Persist if at least the persist interval passed since the last time
+  //----------------------------------------------------------------------------
+  void PersistIfDue(eos::IFileMDSvc* file_svc, eos::IContainerMDSvc* cont_svc);
+
+  //----------------------------------------------------------------------------
+  //! Start warming up the cache in a separate thread
+  //!
+  //! @param view hierarchical view used for prefetching
+  //! @param file_svc file metadata service
+  //! @param cont_svc container metadata service
+  //----------------------------------------------------------------------------
+  void Start(eos::IView* view, eos::IFileMDSvc* file_svc,
+             eos::IContainerMDSvc* cont_svc);
+
+  //----------------------------------------------------------------------------
+  //! Stop warming up the cache
+  //----------------------------------------------------------------------------
+  void Stop();
+
+  //----------------------------------------------------------------------------
+  //! Get status of the warm up as space separated key=value pairs
+  //----------------------------------------------------------------------------
+  std::string GetStatus() const;
+
+  //----------------------------------------------------------------------------
+  //! Encode list of ids as zigzag varints of the difference to the previous
+  //! id
+  //!
+  //! @param ids list of ids
+  //!
+  //! @return encoded ids
+  //----------------------------------------------------------------------------
+  static std::string EncodeIds(const std::vector<uint64_t>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Decode list of ids
+  //!
+  //! @param data encoded ids
+  //! @param ids decoded ids
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool DecodeIds(const std::string& data, std::vector<uint64_t>& ids);
+
+private:
+  //! Max number of file ids persisted
+  static constexpr uint64_t sMaxFileIds = 1000000;
+  //! Max number of container ids persisted
+  static constexpr uint64_t sMaxContainerIds = 200000;
+  //! Number of ids prefetched in parallel
+  static constexpr uint64_t sBatchSize = 1000;
+  //! Default max number of ids prefetched per second
+  static constexpr uint64_t sDefaultRate = 20000;
+  //! Interval between persisting the hot ids
+  static constexpr std::chrono::seconds sPersistInterval {300};
+  //! Interval at which the hit rate is sampled during the recovery
+  static constexpr std::chrono::seconds sSampleInterval {10};
+  //! Give up waiting for the hit rate to recover after this long
+  static constexpr std::chrono::seconds sMaxRecovery {3600};
+  //! Fraction of the previous hit rate considered as recovered
+  static constexpr double sRecoveredRatio = 0.95;
+
+  enum class State {
+    kIdle, kRunning, kDone, kFailed
+  };
+
+  //----------------------------------------------------------------------------
+  //! Method doing the warm up
+  //!
+  //! @param assistant thread executing the method
+  //----------------------------------------------------------------------------
+  void WarmUp(ThreadAssistant& assistant) noexcept;
+
+  //----------------------------------------------------------------------------
+  //! Read the hot ids from QDB
+  //!
+  //! @param file_ids file ids
+  //! @param cont_ids container ids
+  //! @param hit_rate file cache hit rate of the previous master, negative if
+  //!        not known
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Load(std::vector<uint64_t>& file_ids, std::vector<uint64_t>& cont_ids,
+            double& hit_rate);
+
+  //----------------------------------------------------------------------------
+  //! Sample the live file cache hit rate and check if it recovered
+  //!
+  //! @param target hit rate considered as recovered
+  //!
+  //! @return true if recovered, otherwise false
+  //----------------------------------------------------------------------------
+  bool SampleHitRate(double target);
+
+  qclient::QClient& mQcl; ///< Client talking to QDB
+  eos::IView* mView {nullptr};
+  eos::IFileMDSvc* mFileSvc {nullptr};
+  eos::IContainerMDSvc* mContSvc {nullptr};
+  AssistedThread mThread; ///< Thread doing the warm up
+  std::atomic<State> mState {State::kIdle};
+  std::atomic<uint64_t> mTotal {0}; ///< Number of ids to prefetch
+  std::atomic<uint64_t> mDone {0}; ///< Number of ids prefetched
+  std::atomic<uint64_t> mWarmUpMs {0}; ///< Duration of the prefetching
+  std::atomic<int64_t> mRecoverySec {-1}; ///< Hit rate recovery time
+  std::atomic<double> mHitRate {-1.0}; ///< Last live hit rate sampled
+  //! Rate limit of ids per second, 0 disables the warm up
+  uint64_t mRate {sDefaultRate};
+  //! File cache hits and misses at the last persist
+  uint64_t mPersistHits {0};
+  uint64_t mPersistMisses {0};
+  std::chrono::steady_clock::time_point mLastPersist;
+  //! File cache hits, misses and ids prefetched at the last hit rate sample
+  uint64_t mSampleHits {0};
+  uint64_t mSampleMisses {0};
+  uint64_t mSampleDone {0};
+  std::chrono::steady_clock::time_point mStart; ///< Start of the warm up
+};
+
+EOSMGMNAMESPACE_END
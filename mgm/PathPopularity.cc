@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+//! @file PathPopularity.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/PathPopularity.hh"
+#include <algorithm>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+constexpr uint64_t sFnvOffset = 14695981039346656037ull;
+constexpr uint64_t sFnvPrime = 1099511628211ull;
+}
+
+constexpr size_t PathPopularity::sMaxDepth;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+PathPopularity::PathPopularity(size_t capacity):
+  mCapacity(capacity)
+{
+  mLevels.reserve(sMaxDepth);
+
+  for (size_t i = 0; i < sMaxDepth; ++i) {
+    mLevels.emplace_back(mCapacity);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Account one read for all the parent directories of the given path
+//------------------------------------------------------------------------------
+void
+PathPopularity::Add(std::string_view path, unsigned long long rb)
+{
+  uint64_t hash = sFnvOffset;
+  size_t depth = 0;
+
+  for (size_t pos = 0; pos < path.size(); ++pos) {
+    // Collapse duplicate slashes so that "//a/" and "/a/" are the same prefix
+    if ((path[pos] == '/') && pos && (path[pos - 1] == '/')) {
+      continue;
+    }
+
+    hash ^= static_cast<unsigned char>(path[pos]);
+    hash *= sFnvPrime;
+
+    if (path[pos] != '/') {
+      continue;
+    }
+
+    Level& level = mLevels[std::min(depth, sMaxDepth - 1)];
+    level.mNread.Add(hash, 1);
+    level.mRb.Add(hash, rb);
+    ++depth;
+
+    if (mNames.find(hash) == mNames.end()) {
+      std::string name;
+      name.reserve(pos + 1);
+
+      for (size_t i = 0; i <= pos; ++i) {
+        if ((path[i] == '/') && i && (path[i - 1] == '/')) {
+          continue;
+        }
+
+        name += path[i];
+      }
+
+      mNames.emplace(hash, std::move(name));
+    }
+  }
+
+  if (mNames.size() > 4 * 2 * sMaxDepth * mCapacity) {
+    PruneNames();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get the most popular prefixes ordered by number of reads
+//------------------------------------------------------------------------------
+std::vector<PathPopularity::Entry>
+PathPopularity::GetTopByCount(size_t limit) const
+{
+  return GetTop(limit, true);
+}
+
+//------------------------------------------------------------------------------
+// Get the most popular prefixes ordered by read bytes
+//------------------------------------------------------------------------------
+std::vector<PathPopularity::Entry>
+PathPopularity::GetTopByBytes(size_t limit) const
+{
+  return GetTop(limit, false);
+}
+
+//------------------------------------------------------------------------------
+// Collect the entries of all levels ordered by reads or by read bytes
+//------------------------------------------------------------------------------
+std::vector<PathPopularity::Entry>
+PathPopularity::GetTop(size_t limit, bool by_count) const
+{
+  std::vector<Entry> result;
+
+  for (const auto& level : mLevels) {
+    const auto& primary = (by_count ? level.mNread : level.mRb);
+    const auto& secondary = (by_count ? level.mRb : level.mNread);
+
+    for (const auto& elem : primary.GetTop(limit)) {
+      auto it = mNames.find(elem.key);
+
+      if (it == mNames.end()) {
+        continue;
+      }
+
+      // The secondary metric is only known if also tracked by the other
+      // sketch, otherwise it's below the reporting threshold
+      unsigned long long other = secondary.GetCount(elem.key);
+
+      if (by_count) {
+        result.push_back(Entry{it->second, elem.count, other});
+      } else {
+        result.push_back(Entry{it->second, other, elem.count});
+      }
+    }
+  }
+
+  std::sort(result.begin(), result.end(),
+  [by_count](const Entry & l, const Entry & r) {
+    unsigned long long lval = (by_count ? l.nread : l.rb);
+    unsigned long long rval = (by_count ? r.nread : r.rb);
+
+    if (lval == rval) {
+      return (l.path < r.path);
+    }
+
+    return lval > rval;
+  });
+
+  if (result.size() > limit) {
+    result.resize(limit);
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+// Drop all the collected information
+//------------------------------------------------------------------------------
+void
+PathPopularity::Clear()
+{
+  for (auto& level : mLevels) {
+    level.mNread.Clear();
+    level.mRb.Clear();
+  }
+
+  mNames.clear();
+}
+
+//------------------------------------------------------------------------------
+// Drop the names of the prefixes which are no longer tracked
+//------------------------------------------------------------------------------
+void
+PathPopularity::PruneNames()
+{
+  for (auto it = mNames.begin(); it != mNames.end();) {
+    bool tracked = false;
+
+    for (const auto& level : mLevels) {
+      if (level.mNread.GetCount(it->first) || level.mRb.GetCount(it->first)) {
+        tracked = true;
+        break;
+      }
+    }
+
+    if (tracked) {
+      ++it;
+    } else {
+      it = mNames.erase(it);
+    }
+  }
+}
+
+EOSMGMNAMESPACE_END
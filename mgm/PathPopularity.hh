@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+//! @file PathPopularity.hh
+//! @brief Bounded-memory namespace popularity ranking
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/SpaceSaving.hh"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class PathPopularity keeps the top-K most accessed directory prefixes
+//! by number of reads and by read bytes.
+//!
+//! Every path prefix ending in '/' is hashed incrementally while scanning the
+//! path once, therefore accounting a report does not allocate for prefixes
+//! which are already tracked. There is one heavy-hitters sketch per
+//! directory depth so that the few shallow prefixes, which are ancestors of
+//! everything, don't crowd out the deeper ones. Memory usage is bounded by
+//! the sketch capacity and independent of the report rate or the size of
+//! the namespace.
+//!
+//! Not thread-safe, the caller is expected to provide the locking.
+//------------------------------------------------------------------------------
+class PathPopularity
+{
+public:
+  //! Maximum tracked depth, deeper prefixes share the last sketch
+  static constexpr size_t sMaxDepth = 16;
+
+  //----------------------------------------------------------------------------
+  //! Popularity entry
+  //----------------------------------------------------------------------------
+  struct Entry {
+    std::string path;
+    unsigned long long nread;
+    unsigned long long rb;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity number of tracked prefixes per depth
+  //----------------------------------------------------------------------------
+  PathPopularity(size_t capacity = 1024);
+
+  //----------------------------------------------------------------------------
+  //! Account one read of the given number of bytes for all the parent
+  //! directories of the given path
+  //!
+  //! @param path file path
+  //! @param rb read bytes
+  //----------------------------------------------------------------------------
+  void Add(std::string_view path, unsigned long long rb);
+
+  //----------------------------------------------------------------------------
+  //! Get the most popular prefixes ordered by number of reads
+  //!
+  //! @param limit maximum number of entries to return
+  //----------------------------------------------------------------------------
+  std::vector<Entry> GetTopByCount(size_t limit) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the most popular prefixes ordered by read bytes
+  //!
+  //! @param limit maximum number of entries to return
+  //----------------------------------------------------------------------------
+  std::vector<Entry> GetTopByBytes(size_t limit) const;
+
+  //----------------------------------------------------------------------------
+  //! Drop all the collected information
+  //----------------------------------------------------------------------------
+  void Clear();
+
+  //----------------------------------------------------------------------------
+  //! Get number of prefixes whose name is currently stored
+  //----------------------------------------------------------------------------
+  inline size_t GetNumNames() const
+  {
+    return mNames.size();
+  }
+
+private:
+  //! Sketches for one directory depth
+  struct Level {
+    Level(size_t capacity): mNread(capacity), mRb(capacity) {}
+
+    eos::common::SpaceSaving<uint64_t> mNread;
+    eos::common::SpaceSaving<uint64_t> mRb;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Collect the entries of all levels ordered by number of reads or by read
+  //! bytes
+  //----------------------------------------------------------------------------
+  std::vector<Entry> GetTop(size_t limit, bool by_count) const;
+
+  //----------------------------------------------------------------------------
+  //! Drop the names of the prefixes which are no longer tracked
+  //----------------------------------------------------------------------------
+  void PruneNames();
+
+  size_t mCapacity; ///< Number of counters per depth and metric
+  std::vector<Level> mLevels; ///< Sketches indexed by depth
+  //! Prefix hash to prefix name, only for tracked prefixes (modulo pruning)
+  std::unordered_map<uint64_t, std::string> mNames;
+};
+
+EOSMGMNAMESPACE_END
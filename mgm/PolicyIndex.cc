@@ -0,0 +1,237 @@
+//------------------------------------------------------------------------------
+// File: PolicyIndex.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/PolicyIndex.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "common/Logging.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
+#include "namespace/utils/Attributes.hh"
+#include <qclient/QClient.hh>
+#include <qclient/structures/QHash.hh>
+#include <qclient/structures/QSet.hh>
+
+EOSMGMNAMESPACE_BEGIN
+
+const std::vector<std::string> PolicyIndex::sPrefixes {
+  "sys.lru.", eos::kAttrLinkKey
+};
+const std::string PolicyIndex::sKeyPrefix {"eos-policy-index:"};
+const std::string PolicyIndex::sMetaKey {"eos-policy-index-meta"};
+
+//------------------------------------------------------------------------------
+// Get the QDB key of the set for the given attribute prefix
+//------------------------------------------------------------------------------
+std::string
+PolicyIndex::GetKey(const std::string& prefix)
+{
+  return sKeyPrefix + prefix;
+}
+
+//------------------------------------------------------------------------------
+// Check if the given attribute is covered by the index
+//------------------------------------------------------------------------------
+bool
+PolicyIndex::IsIndexed(const std::string& key)
+{
+  for (const auto& prefix : sPrefixes) {
+    if (key.compare(0, prefix.length(), prefix) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Check if there is any attribute starting with the given prefix
+//------------------------------------------------------------------------------
+bool
+PolicyIndex::HasPrefix(const eos::IContainerMD::XAttrMap& attrs,
+                       const std::string& prefix)
+{
+  // The map is ordered so the first key not less than the prefix is the
+  // only candidate
+  auto it = attrs.lower_bound(prefix);
+  return ((it != attrs.end()) &&
+          (it->first.compare(0, prefix.length(), prefix) == 0));
+}
+
+//------------------------------------------------------------------------------
+// Update the index entries of a container after one of its attributes changed
+//------------------------------------------------------------------------------
+void
+PolicyIndex::Update(eos::IContainerMD* cmd, const std::string& key)
+{
+  if (!key.empty() && !IsIndexed(key)) {
+    return;
+  }
+
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher) {
+    ApplyUpdate(*flusher, cmd->getId(), cmd->getAttributes(), key);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add the index entries of a newly created container
+//------------------------------------------------------------------------------
+void
+PolicyIndex::Add(eos::IContainerMD* cmd)
+{
+  Add(cmd->getId(), cmd->getAttributes());
+}
+
+//------------------------------------------------------------------------------
+// Add the index entries of a container given its own attributes
+//------------------------------------------------------------------------------
+void
+PolicyIndex::Add(eos::IContainerMD::id_t id,
+                 const eos::IContainerMD::XAttrMap& attrs)
+{
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher) {
+    ApplyAdd(*flusher, id, attrs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove the index entries of a container which is about to be deleted
+//------------------------------------------------------------------------------
+void
+PolicyIndex::Remove(eos::IContainerMD* cmd)
+{
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher) {
+    const eos::IContainerMD::XAttrMap attrs = cmd->getAttributes();
+    ApplyRemove(*flusher, cmd->getId(), &attrs);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove container id from all the sets of the index
+//------------------------------------------------------------------------------
+void
+PolicyIndex::Remove(eos::IContainerMD::id_t id)
+{
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher) {
+    ApplyRemove(*flusher, id);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Check an index entry against its container and drop it if stale
+//------------------------------------------------------------------------------
+bool
+PolicyIndex::CheckEntry(eos::IContainerMD::id_t id, eos::IContainerMD* cmd)
+{
+  const eos::IContainerMD::XAttrMap attrs = (cmd ? cmd->getAttributes() :
+      eos::IContainerMD::XAttrMap());
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher == nullptr) {
+    return (cmd != nullptr);
+  }
+
+  return ApplyCheckEntry(*flusher, id, cmd ? &attrs : nullptr);
+}
+
+//------------------------------------------------------------------------------
+// Check if the index was built
+//------------------------------------------------------------------------------
+bool
+PolicyIndex::IsBuilt(qclient::QClient& qcl)
+{
+  try {
+    qclient::QHash meta(qcl, sMetaKey);
+    return (meta.hget("built") == "1");
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to read policy index meta info\" "
+                   "emsg=\"%s\"", e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Mark the index as built
+//------------------------------------------------------------------------------
+void
+PolicyIndex::MarkBuilt()
+{
+  eos::MetadataFlusher* flusher = GetFlusher();
+
+  if (flusher) {
+    flusher->hset(sMetaKey, "built", "1");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect the container ids indexed for the given prefix
+//------------------------------------------------------------------------------
+bool
+PolicyIndex::GetIds(qclient::QClient& qcl, const std::string& prefix,
+                    std::set<eos::IContainerMD::id_t>& ids)
+{
+  try {
+    qclient::QSet qset(qcl, GetKey(prefix));
+
+    for (auto it = qset.getIterator(); it.valid(); it.next()) {
+      try {
+        ids.insert(std::stoull(it.getElement()));
+      } catch (...) {
+        eos_static_err("msg=\"skip malformed policy index entry\" key=%s "
+                       "entry=\"%s\"", GetKey(prefix).c_str(),
+                       it.getElement().c_str());
+      }
+    }
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"failed to read policy index\" key=%s emsg=\"%s\"",
+                   GetKey(prefix).c_str(), e.what());
+    return false;
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get the metadata flusher of the namespace
+//------------------------------------------------------------------------------
+eos::MetadataFlusher*
+PolicyIndex::GetFlusher()
+{
+  auto* qdb_ns_grp = dynamic_cast<eos::QuarkNamespaceGroup*>
+                     (gOFS->namespaceGroup.get());
+
+  if (qdb_ns_grp == nullptr) {
+    return nullptr;
+  }
+
+  return qdb_ns_grp->getMetadataFlusher();
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,254 @@
+//------------------------------------------------------------------------------
+//! @file PolicyIndex.hh
+//! @brief Index of the directories carrying policy attributes kept in QDB
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "namespace/interface/IContainerMD.hh"
+#include <set>
+#include <string>
+#include <vector>
+
+//! Forward declarations
+namespace qclient
+{
+class QClient;
+}
+
+namespace eos
+{
+class MetadataFlusher;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class PolicyIndex
+//!
+//! For every indexed attribute prefix QDB holds the set of ids of the
+//! containers which have at least one attribute starting with that prefix.
+//! The sets are updated through the namespace metadata flusher right after
+//! the container itself is stored, while still holding the namespace lock,
+//! so that the index changes reach QDB in the same order as the metadata
+//! changes. The background engines iterate the sets instead of exploring the
+//! whole namespace. Entries of containers removed by other means than
+//! _remdir are dropped lazily by the consumers.
+//!
+//! The index is only available for the QDB namespace. The first consumer
+//! running against a namespace without index builds it from a full scan and
+//! marks it as built.
+//------------------------------------------------------------------------------
+class PolicyIndex
+{
+public:
+  //! Indexed attribute prefixes
+  static const std::vector<std::string> sPrefixes;
+  //! Prefix of the QDB sets holding the container ids
+  static const std::string sKeyPrefix;
+  //! QDB hash holding the meta info of the index
+  static const std::string sMetaKey;
+
+  //----------------------------------------------------------------------------
+  //! Get the QDB key of the set for the given attribute prefix
+  //----------------------------------------------------------------------------
+  static std::string GetKey(const std::string& prefix);
+
+  //----------------------------------------------------------------------------
+  //! Check if the given attribute is covered by the index
+  //!
+  //! @param key attribute name
+  //!
+  //! @return true if the attribute starts with an indexed prefix
+  //----------------------------------------------------------------------------
+  static bool IsIndexed(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Check if there is any attribute starting with the given prefix
+  //!
+  //! @param attrs attribute map
+  //! @param prefix attribute prefix
+  //!
+  //! @return true if found, otherwise false
+  //----------------------------------------------------------------------------
+  static bool HasPrefix(const eos::IContainerMD::XAttrMap& attrs,
+                        const std::string& prefix);
+
+  //----------------------------------------------------------------------------
+  //! Update the index entries of a container after one of its attributes
+  //! changed. Needs to be called after the container was stored and with the
+  //! namespace write lock held.
+  //!
+  //! @param cmd container metadata
+  //! @param key attribute that changed, if empty all the indexed prefixes
+  //!        are refreshed
+  //----------------------------------------------------------------------------
+  static void Update(eos::IContainerMD* cmd, const std::string& key = "");
+
+  //----------------------------------------------------------------------------
+  //! Add the index entries of a newly created container e.g. after the
+  //! attributes of the parent were inherited. Only adds and never removes
+  //! entries so that a plain mkdir does not cost any extra QDB request.
+  //!
+  //! @param cmd container metadata
+  //----------------------------------------------------------------------------
+  static void Add(eos::IContainerMD* cmd);
+
+  //----------------------------------------------------------------------------
+  //! Add the index entries of a container given its own attributes, used
+  //! while building the index
+  //!
+  //! @param id container id
+  //! @param attrs attributes of the container without the linked ones
+  //----------------------------------------------------------------------------
+  static void Add(eos::IContainerMD::id_t id,
+                  const eos::IContainerMD::XAttrMap& attrs);
+
+  //----------------------------------------------------------------------------
+  //! Remove the index entries of a container which is about to be deleted
+  //!
+  //! @param cmd container metadata
+  //----------------------------------------------------------------------------
+  static void Remove(eos::IContainerMD* cmd);
+
+  //----------------------------------------------------------------------------
+  //! Remove container id from all the sets of the index, used for entries
+  //! whose container no longer exists
+  //!
+  //! @param id container id
+  //----------------------------------------------------------------------------
+  static void Remove(eos::IContainerMD::id_t id);
+
+  //----------------------------------------------------------------------------
+  //! Check if the index was built
+  //!
+  //! @param qcl qclient object used to talk to QDB
+  //!
+  //! @return true if built, otherwise false
+  //----------------------------------------------------------------------------
+  static bool IsBuilt(qclient::QClient& qcl);
+
+  //----------------------------------------------------------------------------
+  //! Mark the index as built
+  //----------------------------------------------------------------------------
+  static void MarkBuilt();
+
+  //----------------------------------------------------------------------------
+  //! Collect the container ids indexed for the given prefix
+  //!
+  //! @param qcl qclient object used to talk to QDB
+  //! @param prefix attribute prefix
+  //! @param ids set of ids to which the indexed ids are added
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool GetIds(qclient::QClient& qcl, const std::string& prefix,
+                     std::set<eos::IContainerMD::id_t>& ids);
+
+  //----------------------------------------------------------------------------
+  //! Check an index entry against its container and drop it if stale i.e.
+  //! the container no longer exists or no longer has any indexed attribute.
+  //! Needs to be called with the namespace lock held.
+  //!
+  //! @param id indexed container id
+  //! @param cmd container metadata, nullptr if the container does not exist
+  //!
+  //! @return true if the entry is valid, otherwise false
+  //----------------------------------------------------------------------------
+  static bool CheckEntry(eos::IContainerMD::id_t id, eos::IContainerMD* cmd);
+
+  //----------------------------------------------------------------------------
+  //! Implementation of the index changes on top of any sink providing sadd
+  //! and srem like the MetadataFlusher, the public methods above forward to
+  //! these using the namespace flusher
+  //----------------------------------------------------------------------------
+  template <typename Sink>
+  static void ApplyUpdate(Sink& sink, eos::IContainerMD::id_t id,
+                          const eos::IContainerMD::XAttrMap& attrs,
+                          const std::string& key = "")
+  {
+    if (!key.empty() && !IsIndexed(key)) {
+      return;
+    }
+
+    const std::string sid = std::to_string(id);
+
+    for (const auto& prefix : sPrefixes) {
+      if (!key.empty() && (key.compare(0, prefix.length(), prefix) != 0)) {
+        continue;
+      }
+
+      if (HasPrefix(attrs, prefix)) {
+        sink.sadd(GetKey(prefix), sid);
+      } else {
+        sink.srem(GetKey(prefix), sid);
+      }
+    }
+  }
+
+  template <typename Sink>
+  static void ApplyAdd(Sink& sink, eos::IContainerMD::id_t id,
+                       const eos::IContainerMD::XAttrMap& attrs)
+  {
+    for (const auto& prefix : sPrefixes) {
+      if (HasPrefix(attrs, prefix)) {
+        sink.sadd(GetKey(prefix), std::to_string(id));
+      }
+    }
+  }
+
+  template <typename Sink>
+  static void ApplyRemove(Sink& sink, eos::IContainerMD::id_t id,
+                          const eos::IContainerMD::XAttrMap* attrs = nullptr)
+  {
+    for (const auto& prefix : sPrefixes) {
+      if (!attrs || HasPrefix(*attrs, prefix)) {
+        sink.srem(GetKey(prefix), std::to_string(id));
+      }
+    }
+  }
+
+  template <typename Sink>
+  static bool ApplyCheckEntry(Sink& sink, eos::IContainerMD::id_t id,
+                              const eos::IContainerMD::XAttrMap* attrs)
+  {
+    if (attrs) {
+      for (const auto& prefix : sPrefixes) {
+        if (HasPrefix(*attrs, prefix)) {
+          return true;
+        }
+      }
+    }
+
+    ApplyRemove(sink, id);
+    return false;
+  }
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get the metadata flusher of the namespace
+  //!
+  //! @return flusher object or nullptr if not a QDB namespace
+  //----------------------------------------------------------------------------
+  static eos::MetadataFlusher* GetFlusher();
+};
+
+EOSMGMNAMESPACE_END
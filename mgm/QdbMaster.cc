@@ -17,6 +17,7 @@
  ************************************************************************/
 
 #include "mgm/QdbMaster.hh"
+#include "mgm/NsCacheWarmUp.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/Quota.hh"
 #include "mgm/Access.hh"
@@ -52,6 +53,7 @@ QdbMaster::QdbMaster(const eos::QdbContactDetails& qdb_info,
 {
   mQcl = std::make_unique<qclient::QClient>(qdb_info.members,
          qdb_info.constructOptions());
+  mCacheWarmUp = std::make_unique<NsCacheWarmUp>(*mQcl);
 }
 
 //------------------------------------------------------------------------------
@@ -311,6 +313,13 @@ QdbMaster::Supervisor(ThreadAssistant& assistant) noexcept
       }
     }
 
+    // The master keeps the list of hot cache entries up to date for the
+    // cache warm up of the next master
+    if (mIsMaster) {
+      mCacheWarmUp->PersistIfDue(gOFS->eosFileService,
+                                 gOFS->eosDirectoryService);
+    }
+
     // If there is a master then wait a bit
     if (!GetMasterId().empty()) {
       std::chrono::milliseconds wait_ms(mLeaseValidity.count() / 2);
@@ -349,6 +358,8 @@ QdbMaster::SlaveToMaster()
 
   Quota::LoadNodes();
   EnableNsCaching();
+  mCacheWarmUp->Start(gOFS->eosView, gOFS->eosFileService,
+                      gOFS->eosDirectoryService);
   WFE::MoveFromRBackToQ();
   // Notify all the nodes about the new master identity
   FsView::gFsView.BroadcastMasterId(GetMasterId());
@@ -392,6 +403,7 @@ QdbMaster::MasterToSlave()
 {
   eos_info("%s", "msg=\"master to slave transition\"");
   RemoveStatusFile(EOSMGMMASTER_SUBSYS_RW_LOCKFILE);
+  const bool was_master = mIsMaster;
   mIsMaster = false;
   UpdateMasterId("");
   gOFS->Recycler->Stop();
@@ -411,6 +423,14 @@ QdbMaster::MasterToSlave()
       std::chrono::milliseconds(100));
   // We are the slave, we just listen and don't broadcast anything
   gOFS->ObjectManager.EnableBroadCast(false);
+  mCacheWarmUp->Stop();
+
+  // Hand over the hot cache entries to the next master before dropping them
+  if (was_master) {
+    (void) mCacheWarmUp->Persist(gOFS->eosFileService,
+                                 gOFS->eosDirectoryService);
+  }
+
   DisableNsCaching();
 
   // When we boot the first time also load the config
@@ -647,7 +667,7 @@ QdbMaster::PrintOut()
 {
   std::ostringstream oss;
   oss << "is_master=" << (mIsMaster ? "true" : "false")
-      << " master_id=" << GetMasterId();
+      << " master_id=" << GetMasterId() << " " << mCacheWarmUp->GetStatus();
   return oss.str();
 }
 
@@ -32,6 +32,8 @@ class QClient;
 
 EOSMGMNAMESPACE_BEGIN
 
+class NsCacheWarmUp;
+
 //------------------------------------------------------------------------------
 //! Class IMaster
 //------------------------------------------------------------------------------
@@ -242,6 +244,8 @@ private:
   AssistedThread mThread; ///< Supervisor thread updating master/slave state
   std::unique_ptr<qclient::QClient>
   mQcl; ///< qclient for talking to the QDB cluster
+  //! Persistence of the hot cache entries and cache warm up after failover
+  std::unique_ptr<NsCacheWarmUp> mCacheWarmUp;
   //! Time for which a lease is aquired
   std::chrono::milliseconds mLeaseValidity {10000};
 };
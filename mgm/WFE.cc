@@ -78,6 +78,14 @@ WFE::WFE()
 bool
 WFE::Start()
 {
+  if (!mJobQueue && !gOFS->mQdbCluster.empty()) {
+    mJobQueue.reset(new WFEJobQueue(std::unique_ptr<IWFEJobStore>
+                                    (new QdbWFEJobStore(gOFS->mQdbContactDetails)),
+    [this](const WFEJobRecord & rec) {
+      RunQueuedJob(rec);
+    }));
+  }
+
   try {
     mThread.reset(&WFE::WFEr, this);
   } catch (const std::system_error& e) {
@@ -96,6 +104,90 @@ void
 WFE::Stop()
 {
   mThread.join();
+
+  if (mJobQueue) {
+    mJobQueue->Deactivate();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Run a job of the job queue
+//------------------------------------------------------------------------------
+void
+WFE::RunQueuedJob(const WFEJobRecord& rec)
+{
+  Job job;
+  job.SetRecord(rec);
+  IncActiveJobs();
+  eos_static_info("msg=\"run queued workflow\" job=\"%s\"",
+                  job.mDescription.c_str());
+  std::string errorMsg;
+  job.DoIt(false, errorMsg);
+}
+
+//------------------------------------------------------------------------------
+// Move the queued and retried jobs of the proc queues to the job queue
+//------------------------------------------------------------------------------
+void
+WFE::MigrateToJobQueue()
+{
+  XrdMgmOfsDirectory dir;
+
+  if (dir.open(gOFS->MgmProcWorkflowPath.c_str(), mRootVid, "") != SFS_OK) {
+    eos_static_err("msg=\"failed to open proc workflow directory\"");
+    return;
+  }
+
+  std::map<std::string, std::set<std::string> > wfedirs;
+  XrdOucString stdErr;
+  const char* entry;
+
+  while ((entry = dir.nextEntry())) {
+    std::string day = entry;
+
+    if ((day == ".") || (day == "..")) {
+      continue;
+    }
+
+    for (const char* queue : {"/q/", "/e/"}) {
+      std::string query = gOFS->MgmProcWorkflowPath.c_str();
+      query += "/";
+      query += day;
+      query += queue;
+      gOFS->_find(query.c_str(), mError, stdErr, mRootVid, wfedirs, 0,
+                  0, false, 0, false, 0);
+    }
+  }
+
+  dir.close();
+  size_t count = 0;
+
+  for (const auto& wfedir : wfedirs) {
+    for (const auto& wfentry : wfedir.second) {
+      std::string path = wfedir.first + wfentry;
+      Job job;
+
+      if (job.Load(path) || (job.mActions.size() != 1)) {
+        eos_static_err("msg=\"cannot load workflow entry for migration\" "
+                       "value=\"%s\"", path.c_str());
+        continue;
+      }
+
+      const std::string queue = job.mActions[0].mQueue;
+      const std::string day = job.mActions[0].mSavedOnDay;
+      time_t when = job.mActions[0].mTime;
+
+      if (job.Save("q", when, 0, job.mRetry) == SFS_OK) {
+        job.Delete(queue, day);
+        ++count;
+      }
+    }
+  }
+
+  if (count) {
+    eos_static_info("msg=\"migrated workflow jobs to the job queue\" "
+                    "count=%zu", count);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -111,6 +203,7 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
   time_t snoozetime = 10;
   size_t lWFEntx = 0;
   time_t cleanuptime = 0;
+  bool lWarnedJobQueue = false;
   gOFS->WaitUntilNamespaceIsBooted(assistant);
 
   if (assistant.terminationRequested()) {
@@ -126,6 +219,8 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
     time_t lStartTime = time(NULL);
     time_t lStopTime;
     time_t lKeepTime = 7 * 86400;
+    bool lUseJobQueue = false;
+    std::map<std::string, unsigned int> lWorkflowLimits;
     std::map<std::string, std::set<std::string> > wfedirs;
     XrdOucString stdErr;
     {
@@ -150,14 +245,56 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
         if (!lKeepTime) {
           lKeepTime = 7 * 86400;
         }
+
+        lUseJobQueue =
+          (FsView::gFsView.mSpaceView["default"]->GetConfigMember("wfe.queue") == "qdb");
+        std::vector<std::string> keys;
+        FsView::gFsView.mSpaceView["default"]->GetConfigKeys(keys);
+
+        for (const auto& key : keys) {
+          if (key.compare(0, 8, "wfe.ntx.") == 0) {
+            lWorkflowLimits[key.substr(8)] = atoi(
+                FsView::gFsView.mSpaceView["default"]->GetConfigMember(key).c_str());
+          }
+        }
       } else {
         lWFEInterval = 0;
         lWFEntx = 0;
       }
     }
 
-    // Only a master needs to run WFE
-    if (gOFS->mMaster->IsMaster() && IsEnabledWFE) {
+    if (lUseJobQueue && !mJobQueue) {
+      if (!lWarnedJobQueue) {
+        eos_static_err("%s", "msg=\"WFE job queue requires a QuarkDB namespace, "
+                       "using the proc queues\"");
+        lWarnedJobQueue = true;
+      }
+
+      lUseJobQueue = false;
+    }
+
+    mUseJobQueue = lUseJobQueue;
+
+    if (mJobQueue) {
+      // The job queue only dispatches on the master and while the WFE is on
+      if (lUseJobQueue && gOFS->mMaster->IsMaster() && IsEnabledWFE) {
+        mJobQueue->SetMaxRunning(lWFEntx);
+
+        for (const auto& elem : lWorkflowLimits) {
+          mJobQueue->SetWorkflowLimit(elem.first, elem.second);
+        }
+
+        if (!mJobQueue->IsActive()) {
+          MigrateToJobQueue();
+          mJobQueue->Activate();
+        }
+      } else if (mJobQueue->IsActive()) {
+        mJobQueue->Deactivate();
+      }
+    }
+
+    // Only a master needs to run WFE, the job queue does not need any scan
+    if (gOFS->mMaster->IsMaster() && IsEnabledWFE && !lUseJobQueue) {
       eos_static_debug("msg=\"start WFE scan\"");
       // Find all directories defining an WFE policy
       gOFS->MgmStats.Add("WFEFind", 0, 0, 1);
@@ -347,6 +484,15 @@ WFE::WFEr(ThreadAssistant& assistant) noexcept
         }
       }
 
+      if (lUseJobQueue) {
+        size_t purged = mJobQueue->PurgeFailed(now - lKeepTime);
+
+        if (purged) {
+          eos_static_info("msg=\"purged failed workflow jobs\" count=%zu",
+                          purged);
+        }
+      }
+
       cleanuptime = now + 3600;
     }
   }
@@ -365,6 +511,28 @@ WFE::Job::Save(std::string queue, time_t& when, int action, int retry)
     return -1;
   }
 
+  if (!mInQueue && (queue == "q") && gOFS->WFEd.UseJobQueue()) {
+    // New job goes to the job queue instead of the proc queue
+    if (!when) {
+      when = time(nullptr);
+    }
+
+    WFEJobRecord rec = GetRecord();
+    rec.mCtime = when;
+    rec.mTime = when;
+    rec.mRetry = retry;
+
+    if (!gOFS->WFEd.GetJobQueue()->Push(rec)) {
+      eos_static_err("msg=\"failed to queue workflow job\" job=\"%s\"",
+                     mDescription.c_str());
+      return -1;
+    }
+
+    mCtime = when;
+    mInQueue = true;
+    return SFS_OK;
+  }
+
   std::string workflowdir = gOFS->MgmProcWorkflowPath.c_str();
   workflowdir += "/";
   workflowdir += mActions[action].mDay;
@@ -547,6 +715,10 @@ WFE::Job::Move(std::string from_queue, std::string to_queue, time_t& when,
  */
 /*----------------------------------------------------------------------------*/
 {
+  if (mInQueue) {
+    return MoveInQueue(to_queue, when, retry);
+  }
+
   auto fromDay = mActions[0].mSavedOnDay;
 
   if (Save(to_queue, when, 0, retry) == SFS_OK) {
@@ -571,6 +743,19 @@ int
 WFE::Job::Results(std::string queue, int retc, XrdOucString log, time_t when)
 /*----------------------------------------------------------------------------*/
 {
+  if (mInQueue) {
+    // Only the failed jobs of the job queue keep their results
+    if ((queue != "f") && (queue != "g")) {
+      return SFS_OK;
+    }
+
+    WFEJobRecord rec = GetRecord();
+    rec.mTime = (when ? when : time(nullptr));
+    rec.mRetc = retc;
+    rec.mLog = log.c_str();
+    return (gOFS->WFEd.GetJobQueue()->Fail(rec) ? SFS_OK : -1);
+  }
+
   std::string workflowdir = gOFS->MgmProcWorkflowPath.c_str();
   workflowdir += "/";
   workflowdir += mActions[0].mDay;
@@ -639,6 +824,94 @@ WFE::Job::Results(std::string queue, int retc, XrdOucString log, time_t when)
 
 
 
+/*----------------------------------------------------------------------------*/
+int
+WFE::Job::MoveInQueue(const std::string& to_queue, time_t& when, int retry)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief move a job of the job queue between states, the queue names have
+ * the same meaning as for the proc queues
+ * @return SFS_OK if success
+ */
+/*----------------------------------------------------------------------------*/
+{
+  WFEJobQueue* job_queue = gOFS->WFEd.GetJobQueue();
+  bool ok = true;
+
+  if (!when) {
+    when = time(nullptr);
+  }
+
+  WFEJobRecord rec = GetRecord();
+
+  if ((to_queue == "q") || (to_queue == "e")) {
+    rec.mTime = when;
+    rec.mRetry = retry;
+    ok = job_queue->Retry(rec);
+  } else if (to_queue == "d") {
+    ok = job_queue->Done(rec.GetKey());
+  } else if ((to_queue == "f") || (to_queue == "g")) {
+    rec.mTime = when;
+    ok = job_queue->Fail(rec);
+  }
+
+  if (!ok) {
+    eos_static_err("msg=\"failed to move queued job\" queue=\"%s\" job=\"%s\"",
+                   to_queue.c_str(), mDescription.c_str());
+    return SFS_ERROR;
+  }
+
+  mActions[0].mQueue = to_queue;
+  return SFS_OK;
+}
+
+/*----------------------------------------------------------------------------*/
+WFEJobRecord
+WFE::Job::GetRecord() const
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief get the record of the job for the job queue
+ */
+/*----------------------------------------------------------------------------*/
+{
+  eos::common::VirtualIdentity vid = mVid;
+  WFEJobRecord rec;
+  rec.mFid = mFid;
+  rec.mEvent = mActions[0].mEvent;
+  rec.mWorkflow = mActions[0].mWorkflow;
+  rec.mAction = mActions[0].mAction;
+  rec.mVid = eos::common::Mapping::VidToString(vid);
+  rec.mErrorMessage = mErrorMesssage;
+  rec.mCtime = mCtime;
+  rec.mTime = mActions[0].mTime;
+  rec.mRetry = mRetry;
+  return rec;
+}
+
+/*----------------------------------------------------------------------------*/
+void
+WFE::Job::SetRecord(const WFEJobRecord& rec)
+/*----------------------------------------------------------------------------*/
+/**
+ * @brief set up the job from a record of the job queue, the job is running
+ */
+/*----------------------------------------------------------------------------*/
+{
+  mFid = rec.mFid;
+  mRetry = rec.mRetry;
+  mCtime = rec.mCtime;
+  mErrorMesssage = rec.mErrorMessage;
+  mInQueue = true;
+  mActions.clear();
+  mDescription.clear();
+  AddAction(rec.mAction, rec.mEvent, rec.mTime, rec.mWorkflow, "r");
+
+  if (!eos::common::Mapping::VidFromString(mVid, rec.mVid.c_str())) {
+    eos_static_crit("parsing of %s failed - setting nobody\n", rec.mVid.c_str());
+    mVid = eos::common::VirtualIdentity::Nobody();
+  }
+}
+
 /*----------------------------------------------------------------------------*/
 int
 WFE::Job::Delete(std::string queue, std::string fromDay)
@@ -1477,8 +1750,10 @@ WFE::Job::DoIt(bool issync, std::string& errorMsg, const char* const ininfo)
               xstart = 0;
               cnt = 0;
 
-              while ((xstart = outerr.find("<eos::wfe::vpath::fxattr:",
-                                           xstart)) != STR_NPOS) {
+              // jobs of the job queue have no proc entry to store results on
+              while (!mInQueue &&
+                     ((xstart = outerr.find("<eos::wfe::vpath::fxattr:",
+                                            xstart)) != STR_NPOS)) {
                 if (++cnt > 256) {
                   break;
                 }
@@ -25,6 +25,7 @@
 #define __EOSMGM_WFE__HH__
 
 #include "mgm/Namespace.hh"
+#include "mgm/wfe/WFEJobQueue.hh"
 #include "common/Mapping.hh"
 #include "common/Timing.hh"
 #include "common/FileId.hh"
@@ -67,6 +68,23 @@ private:
   /// condition variable to get signalled for a done job
   XrdSysCondVar mDoneSignal;
 
+  //! Durable job queue used instead of the proc queues if configured
+  std::unique_ptr<WFEJobQueue> mJobQueue;
+  //! Mark if new asynchronous jobs go to the job queue
+  std::atomic<bool> mUseJobQueue {false};
+
+  //----------------------------------------------------------------------------
+  //! Run a job of the job queue
+  //!
+  //! @param rec job record
+  //----------------------------------------------------------------------------
+  void RunQueuedJob(const WFEJobRecord& rec);
+
+  //----------------------------------------------------------------------------
+  //! Move the queued and retried jobs of the proc queues to the job queue
+  //----------------------------------------------------------------------------
+  void MigrateToJobQueue();
+
 public:
 
   /* Default Constructor - use it to run the WFE thread by calling Start
@@ -103,6 +121,22 @@ public:
    */
   void WFEr(ThreadAssistant& assistant) noexcept;
 
+  //----------------------------------------------------------------------------
+  //! Check if new asynchronous jobs go to the job queue
+  //----------------------------------------------------------------------------
+  inline bool UseJobQueue() const
+  {
+    return mUseJobQueue;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the job queue, nullptr if not available
+  //----------------------------------------------------------------------------
+  inline WFEJobQueue* GetJobQueue() const
+  {
+    return mJobQueue.get();
+  }
+
   /**
    * @brief Destructor
    *
@@ -155,6 +189,8 @@ public:
     {
       mFid = 0;
       mRetry = 0;
+      mCtime = 0;
+      mInQueue = false;
     }
 
     Job(eos::common::FileId::fileid_t fid,
@@ -163,6 +199,8 @@ public:
     {
       mFid = fid;
       mRetry = 0;
+      mCtime = 0;
+      mInQueue = false;
       mVid = vid;
       mErrorMesssage = errorMessage;
     }
@@ -176,6 +214,8 @@ public:
       mDescription = other.mDescription;
       mRetry = other.mRetry;
       mErrorMesssage = other.mErrorMesssage;
+      mCtime = other.mCtime;
+      mInQueue = other.mInQueue;
     }
     // ---------------------------------------------------------------------------
     // Job execution function
@@ -298,6 +338,13 @@ public:
 
     int Delete(std::string queue, std::string fromDay);
 
+    //! @brief get the record of the job for the job queue
+    WFEJobRecord GetRecord() const;
+
+    //! @brief set up the job from a record of the job queue
+    //! @param rec job record
+    void SetRecord(const WFEJobRecord& rec);
+
     // -------------------------------------------------------------------------
 
     void AddAction(const std::string& action,
@@ -349,8 +396,16 @@ public:
     std::string mWorkflowPath;
     std::string mErrorMesssage;
     int mRetry;///! number of retries
+    time_t mCtime;///! creation time of a job of the job queue
+    bool mInQueue;///! job belongs to the job queue
 
   private:
+    //! @brief move job of the job queue between states
+    //! @param to_queue queue name corresponding to the new state
+    //! @param when time when the job is due
+    //! @param retry number of retries
+    int MoveInQueue(const std::string& to_queue, time_t& when, int retry);
+
     //! @brief moving proto wf event jobs to retry queue
     //! @param filePath the path of the file concerned
     void MoveToRetry(const std::string& filePath);
@@ -56,6 +56,7 @@
 #include "mgm/XrdMgmOfsSecurity.hh"
 #include "mgm/CommandMap.hh"
 #include "mgm/Policy.hh"
+#include "mgm/PolicyIndex.hh"
 #include "mgm/Quota.hh"
 #include "mgm/Acl.hh"
 #include "mgm/Workflow.hh"
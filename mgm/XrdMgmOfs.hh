@@ -652,6 +652,46 @@ public:
             std::string* uri = 0,
             std::string* cks = 0);
   // ---------------------------------------------------------------------------
+  // fill stat information from file or container metadata
+  // ---------------------------------------------------------------------------
+  void _stat_file_md(const std::shared_ptr<eos::IFileMD>& fmd,
+                     struct stat* buf);
+
+  void _stat_container_md(const std::shared_ptr<eos::IContainerMD>& cmd,
+                          struct stat* buf);
+
+  //----------------------------------------------------------------------------
+  //! Stat information of one directory entry returned by _stat_list
+  //----------------------------------------------------------------------------
+  struct StatListEntry {
+    std::string name; ///< Name of the entry inside the directory
+    struct stat buf; ///< Same as returned by _stat
+    std::string etag; ///< ETag, "hardlink" for hard link entries
+    std::string checksum; ///< Hex checksum, empty for directories
+    eos::IContainerMD::XAttrMap attrs; ///< Requested extended attributes
+  };
+
+  // ---------------------------------------------------------------------------
+  // stat all the entries of a directory by vid in a single namespace pass
+  // ---------------------------------------------------------------------------
+  int _stat_list(const char* path,
+                 XrdOucErrInfo& out_error,
+                 eos::common::VirtualIdentity& vid,
+                 std::vector<StatListEntry>& entries,
+                 const std::vector<std::string>& attr_keys = {});
+
+  // ---------------------------------------------------------------------------
+  // stat all the entries of a directory by vid applying path mapping, bounce,
+  // stall and redirect rules
+  // ---------------------------------------------------------------------------
+  int stat_list(const char* Name,
+                XrdOucErrInfo& out_error,
+                eos::common::VirtualIdentity& vid,
+                std::vector<StatListEntry>& entries,
+                const std::vector<std::string>& attr_keys = {},
+                const char* opaque = 0);
+
+  // ---------------------------------------------------------------------------
   // set XRDSFS_OFFLINE and XRDSFS_HASBKUP flags
   // ---------------------------------------------------------------------------
   void _stat_set_flags(struct stat* buf);
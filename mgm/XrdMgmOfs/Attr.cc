@@ -202,6 +202,7 @@ XrdMgmOfs::_attr_set(const char* path, XrdOucErrInfo& error,
       }
 
       eosView->updateContainerStore(dh.get());
+      PolicyIndex::Update(dh.get(), Key.c_str());
       eos::ContainerIdentifier d_id = dh->getIdentifier();
       eos::ContainerIdentifier d_pid = dh->getParentIdentifier();
 
@@ -531,6 +532,7 @@ XrdMgmOfs::_attr_rem(const char* path, XrdOucErrInfo& error,
         if (dh->hasAttribute(key)) {
           dh->removeAttribute(key);
           eosView->updateContainerStore(dh.get());
+          PolicyIndex::Update(dh.get(), key);
           eos::ContainerIdentifier d_id = dh->getIdentifier();
           eos::ContainerIdentifier d_pid = dh->getParentIdentifier();
           lock.Release();
@@ -367,6 +367,7 @@ XrdMgmOfs::_mkdir(const char* path,
           // commit
           eosView->updateContainerStore(newdir.get());
           eosView->updateContainerStore(dir.get());
+          PolicyIndex::Add(newdir.get());
           dir->notifyMTimeChange(gOFS->eosDirectoryService);
           newdir->notifyMTimeChange(gOFS->eosDirectoryService);
           eos::ContainerIdentifier nd_id = newdir->getIdentifier();
@@ -439,6 +440,7 @@ XrdMgmOfs::_mkdir(const char* path,
     // Commit to backend
     eosView->updateContainerStore(newdir.get());
     eosView->updateContainerStore(dir.get());
+    PolicyIndex::Add(newdir.get());
     // Notify after attribute inheritance
     newdir->notifyMTimeChange(gOFS->eosDirectoryService);
     dir->notifyMTimeChange(gOFS->eosDirectoryService);
@@ -217,6 +217,7 @@ XrdMgmOfs::_remdir(const char* path,
         dh_name = dh->getName();
       }
 
+      PolicyIndex::Remove(dh.get());
       eosView->removeContainer(path);
       viewLock.Release();
 
@@ -230,61 +230,7 @@ XrdMgmOfs::_stat(const char* path,
   }
 
   if (fmd) {
-    memset(buf, 0, sizeof(struct stat));
-    buf->st_dev = 0xcaff;
-    buf->st_ino = eos::common::FileId::FidToInode(fmd->getId());
-    buf->st_mode = eos::modeFromMetadataEntry(fmd);
-
-    if (fmd->isLink()) {
-      buf->st_nlink = 1;
-    } else {
-      // we have to pass only disk locations to GetRedundancy and correct
-
-      unsigned long disk_locations = fmd->getNumLocation();
-      if (buf->st_mode & EOS_TAPE_MODE_T) {
-	if (disk_locations>0) {
-	  disk_locations--;
-	}
-      }
-
-      buf->st_nlink = eos::common::LayoutId::GetRedundancy(fmd->getLayoutId(), disk_locations);
-      if ((buf->st_mode & EOS_TAPE_MODE_T)) {
-	// file is unavailable on disk, but available on tape e.g. redundancy from disk layout = 0
-	buf->st_nlink++;
-      }
-    }
-
-    buf->st_size = fmd->getSize();
-    buf->st_uid = fmd->getCUid();
-    buf->st_gid = fmd->getCGid();
-    buf->st_rdev = 0; /* device type (if inode device) */
-    buf->st_blksize = 512;
-    buf->st_blocks = (Quota::MapSizeCB(fmd.get())+512) / 512; // including layout factor
-    eos::IFileMD::ctime_t atime;
-    // adding also nanosecond to stat struct
-    fmd->getCTime(atime);
-#ifdef __APPLE__
-    buf->st_ctimespec.tv_sec = atime.tv_sec;
-    buf->st_ctimespec.tv_nsec = atime.tv_nsec;
-#else
-    buf->st_ctime = atime.tv_sec;
-    buf->st_ctim.tv_sec = atime.tv_sec;
-    buf->st_ctim.tv_nsec = atime.tv_nsec;
-#endif
-    fmd->getMTime(atime);
-#ifdef __APPLE__
-    buf->st_mtimespec.tv_sec = atime.tv_sec;
-    buf->st_mtimespec.tv_nsec = atime.tv_nsec;
-    buf->st_atimespec.tv_sec = atime.tv_sec;
-    buf->st_atimespec.tv_nsec = atime.tv_nsec;
-#else
-    buf->st_mtime = atime.tv_sec;
-    buf->st_mtim.tv_sec = atime.tv_sec;
-    buf->st_mtim.tv_nsec = atime.tv_nsec;
-    buf->st_atime = atime.tv_sec;
-    buf->st_atim.tv_sec = atime.tv_sec;
-    buf->st_atim.tv_nsec = atime.tv_nsec;
-#endif
+    _stat_file_md(fmd, buf);
 
     if (etag) {
       eos::calculateEtag(fmd.get(), *etag);
@@ -309,49 +255,7 @@ XrdMgmOfs::_stat(const char* path,
       *uri = gOFS->eosView->getUri(cmd.get());
     }
 
-    memset(buf, 0, sizeof(struct stat));
-    buf->st_dev = 0xcaff;
-    buf->st_ino = cmd->getId();
-    buf->st_mode = eos::modeFromMetadataEntry(cmd);
-    buf->st_nlink = 1;
-    buf->st_uid = cmd->getCUid();
-    buf->st_gid = cmd->getCGid();
-    buf->st_rdev = 0; /* device type (if inode device) */
-    buf->st_size = cmd->getTreeSize();
-    buf->st_blksize = cmd->getNumContainers() + cmd->getNumFiles();
-    buf->st_blocks = 0;
-    eos::IContainerMD::ctime_t ctime;
-    eos::IContainerMD::ctime_t mtime;
-    eos::IContainerMD::ctime_t tmtime;
-    cmd->getCTime(ctime);
-    cmd->getMTime(mtime);
-
-    if (gOFS->eosSyncTimeAccounting) {
-      cmd->getTMTime(tmtime);
-    } else
-      // if there is no sync time accounting we just use the normal modification time
-    {
-      tmtime = mtime;
-    }
-
-#ifdef __APPLE__
-    buf->st_atimespec.tv_sec = tmtime.tv_sec;
-    buf->st_mtimespec.tv_sec = mtime.tv_sec;
-    buf->st_ctimespec.tv_sec = ctime.tv_sec;
-    buf->st_atimespec.tv_nsec = tmtime.tv_nsec;
-    buf->st_mtimespec.tv_nsec = mtime.tv_nsec;
-    buf->st_ctimespec.tv_nsec = ctime.tv_nsec;
-#else
-    buf->st_atime = tmtime.tv_sec;
-    buf->st_mtime = mtime.tv_sec;
-    buf->st_ctime = ctime.tv_sec;
-    buf->st_atim.tv_sec = tmtime.tv_sec;
-    buf->st_mtim.tv_sec = mtime.tv_sec;
-    buf->st_ctim.tv_sec = ctime.tv_sec;
-    buf->st_atim.tv_nsec = tmtime.tv_nsec;
-    buf->st_mtim.tv_nsec = mtime.tv_nsec;
-    buf->st_ctim.tv_nsec = ctime.tv_nsec;
-#endif
+    _stat_container_md(cmd, buf);
 
     if (etag) {
       eos::calculateEtag(cmd.get(), *etag);
@@ -369,6 +273,343 @@ XrdMgmOfs::_stat(const char* path,
   }
 }
 
+/*----------------------------------------------------------------------------*/
+void
+XrdMgmOfs::_stat_file_md(const std::shared_ptr<eos::IFileMD>& fmd,
+                         struct stat* buf)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief fill stat information from file metadata
+ *
+ * @param fmd file metadata
+ * @param buf stat buffer where to store the stat information
+ *
+ * Must be called with the namespace read lock held.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_dev = 0xcaff;
+  buf->st_ino = eos::common::FileId::FidToInode(fmd->getId());
+  buf->st_mode = eos::modeFromMetadataEntry(fmd);
+
+  if (fmd->isLink()) {
+    buf->st_nlink = 1;
+  } else {
+    // we have to pass only disk locations to GetRedundancy and correct
+
+    unsigned long disk_locations = fmd->getNumLocation();
+    if (buf->st_mode & EOS_TAPE_MODE_T) {
+	if (disk_locations>0) {
+	  disk_locations--;
+	}
+    }
+
+    buf->st_nlink = eos::common::LayoutId::GetRedundancy(fmd->getLayoutId(), disk_locations);
+    if ((buf->st_mode & EOS_TAPE_MODE_T)) {
+	// file is unavailable on disk, but available on tape e.g. redundancy from disk layout = 0
+	buf->st_nlink++;
+    }
+  }
+
+  buf->st_size = fmd->getSize();
+  buf->st_uid = fmd->getCUid();
+  buf->st_gid = fmd->getCGid();
+  buf->st_rdev = 0; /* device type (if inode device) */
+  buf->st_blksize = 512;
+  buf->st_blocks = (Quota::MapSizeCB(fmd.get())+512) / 512; // including layout factor
+  eos::IFileMD::ctime_t atime;
+  // adding also nanosecond to stat struct
+  fmd->getCTime(atime);
+#ifdef __APPLE__
+  buf->st_ctimespec.tv_sec = atime.tv_sec;
+  buf->st_ctimespec.tv_nsec = atime.tv_nsec;
+#else
+  buf->st_ctime = atime.tv_sec;
+  buf->st_ctim.tv_sec = atime.tv_sec;
+  buf->st_ctim.tv_nsec = atime.tv_nsec;
+#endif
+  fmd->getMTime(atime);
+#ifdef __APPLE__
+  buf->st_mtimespec.tv_sec = atime.tv_sec;
+  buf->st_mtimespec.tv_nsec = atime.tv_nsec;
+  buf->st_atimespec.tv_sec = atime.tv_sec;
+  buf->st_atimespec.tv_nsec = atime.tv_nsec;
+#else
+  buf->st_mtime = atime.tv_sec;
+  buf->st_mtim.tv_sec = atime.tv_sec;
+  buf->st_mtim.tv_nsec = atime.tv_nsec;
+  buf->st_atime = atime.tv_sec;
+  buf->st_atim.tv_sec = atime.tv_sec;
+  buf->st_atim.tv_nsec = atime.tv_nsec;
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+void
+XrdMgmOfs::_stat_container_md(const std::shared_ptr<eos::IContainerMD>& cmd,
+                              struct stat* buf)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief fill stat information from container metadata
+ *
+ * @param cmd container metadata
+ * @param buf stat buffer where to store the stat information
+ *
+ * Must be called with the namespace read lock held.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  memset(buf, 0, sizeof(struct stat));
+  buf->st_dev = 0xcaff;
+  buf->st_ino = cmd->getId();
+  buf->st_mode = eos::modeFromMetadataEntry(cmd);
+  buf->st_nlink = 1;
+  buf->st_uid = cmd->getCUid();
+  buf->st_gid = cmd->getCGid();
+  buf->st_rdev = 0; /* device type (if inode device) */
+  buf->st_size = cmd->getTreeSize();
+  buf->st_blksize = cmd->getNumContainers() + cmd->getNumFiles();
+  buf->st_blocks = 0;
+  eos::IContainerMD::ctime_t ctime;
+  eos::IContainerMD::ctime_t mtime;
+  eos::IContainerMD::ctime_t tmtime;
+  cmd->getCTime(ctime);
+  cmd->getMTime(mtime);
+
+  if (gOFS->eosSyncTimeAccounting) {
+    cmd->getTMTime(tmtime);
+  } else
+    // if there is no sync time accounting we just use the normal modification time
+  {
+    tmtime = mtime;
+  }
+
+#ifdef __APPLE__
+  buf->st_atimespec.tv_sec = tmtime.tv_sec;
+  buf->st_mtimespec.tv_sec = mtime.tv_sec;
+  buf->st_ctimespec.tv_sec = ctime.tv_sec;
+  buf->st_atimespec.tv_nsec = tmtime.tv_nsec;
+  buf->st_mtimespec.tv_nsec = mtime.tv_nsec;
+  buf->st_ctimespec.tv_nsec = ctime.tv_nsec;
+#else
+  buf->st_atime = tmtime.tv_sec;
+  buf->st_mtime = mtime.tv_sec;
+  buf->st_ctime = ctime.tv_sec;
+  buf->st_atim.tv_sec = tmtime.tv_sec;
+  buf->st_mtim.tv_sec = mtime.tv_sec;
+  buf->st_ctim.tv_sec = ctime.tv_sec;
+  buf->st_atim.tv_nsec = tmtime.tv_nsec;
+  buf->st_mtim.tv_nsec = mtime.tv_nsec;
+  buf->st_ctim.tv_nsec = ctime.tv_nsec;
+#endif
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdMgmOfs::stat_list(const char* inpath,
+                     XrdOucErrInfo& error,
+                     eos::common::VirtualIdentity& vid,
+                     std::vector<StatListEntry>& entries,
+                     const std::vector<std::string>& attr_keys,
+                     const char* ininfo)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief return stat information for all the entries of a directory
+ *
+ * @param inpath directory path
+ * @param error error object
+ * @param vid virtual identity of the client
+ * @param entries vector filled with the entries sorted by name
+ * @param attr_keys extended attributes to return for each entry
+ * @param ininfo CGI
+ * @return SFS_OK on success otherwise SFS_ERROR
+ *
+ * Applies the same path mapping, bounce, stall and redirect rules as opening
+ * the directory by vid, the permission check is done by _stat_list.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  static const char* epname = "stat_list";
+  NAMESPACEMAP;
+  BOUNCE_ILLEGAL_NAMES;
+  XrdOucEnv Open_Env(ininfo);
+  BOUNCE_NOT_ALLOWED;
+  ACCESSMODE_R;
+  MAYSTALL;
+  MAYREDIRECT;
+  return _stat_list(path, error, vid, entries, attr_keys);
+}
+
+/*----------------------------------------------------------------------------*/
+int
+XrdMgmOfs::_stat_list(const char* path,
+                      XrdOucErrInfo& error,
+                      eos::common::VirtualIdentity& vid,
+                      std::vector<StatListEntry>& entries,
+                      const std::vector<std::string>& attr_keys)
+/*----------------------------------------------------------------------------*/
+/*
+ * @brief return stat information for all the entries of a directory
+ *
+ * @param path directory path
+ * @param error error object
+ * @param vid virtual identity of the client
+ * @param entries vector filled with the entries sorted by name
+ * @param attr_keys extended attributes to return for each entry
+ * @return SFS_OK on success otherwise SFS_ERROR
+ *
+ * The client needs the same permissions as for opening the directory. The
+ * children are prefetched and then resolved by id in one pass under the
+ * namespace lock instead of resolving the full path of every entry. Symbolic
+ * links are followed like in _stat, entries which can not be resolved are
+ * skipped.
+ */
+/*----------------------------------------------------------------------------*/
+{
+  static const char* epname = "_stat_list";
+  EXEC_TIMING_BEGIN("StatList");
+  gOFS->MgmStats.Add("StatList", vid.uid, vid.gid, 1);
+  entries.clear();
+  errno = 0;
+  eos::common::Path cPath(path);
+
+  if (!gOFS->allow_public_access(cPath.GetPath(), vid)) {
+    errno = EACCES;
+    return Emsg(epname, error, EACCES,
+                "access - public access level restriction", cPath.GetPath());
+  }
+
+  eos::Prefetcher::prefetchContainerMDWithChildrenAndWait(gOFS->eosView,
+      cPath.GetPath());
+  std::shared_ptr<eos::IContainerMD> dh;
+
+  try {
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex, __FUNCTION__,
+                                      __LINE__, __FILE__);
+    dh = gOFS->eosView->getContainer(cPath.GetPath());
+  } catch (eos::MDException& e) {
+    errno = e.getErrno();
+    eos_debug("msg=\"exception\" ec=%d emsg=\"%s\"", e.getErrno(),
+              e.getMessage().str().c_str());
+    return Emsg(epname, error, errno, "list directory", cPath.GetPath());
+  }
+
+  // Same permission check as for opening the directory, the ACL evaluation
+  // takes the namespace lock on its own
+  bool permok = dh->access(vid.uid, vid.gid, R_OK | X_OK);
+  eos::IContainerMD::XAttrMap attrmap;
+  Acl acl(cPath.GetPath(), error, vid, attrmap, false);
+
+  if (acl.HasAcl()) {
+    if (acl.CanBrowse()) {
+      permok = true;
+    } else if (acl.CanNotBrowse()) {
+      permok = false;
+    }
+  }
+
+  if (!permok) {
+    errno = EPERM;
+    return Emsg(epname, error, errno, "list directory", cPath.GetPath());
+  }
+
+  std::string dir_path = cPath.GetPath();
+
+  if (dir_path.back() != '/') {
+    dir_path += '/';
+  }
+
+  std::vector<std::string> links;
+  {
+    eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex, __FUNCTION__,
+                                      __LINE__, __FILE__);
+    entries.reserve(dh->getNumFiles() + dh->getNumContainers());
+
+    for (auto it = eos::FileMapIterator(dh); it.valid(); it.next()) {
+      if (!gOFS->allow_public_access((dir_path + it.key()).c_str(), vid)) {
+        continue;
+      }
+
+      try {
+        std::shared_ptr<eos::IFileMD> fmd =
+          gOFS->eosFileService->getFileMD(it.value());
+
+        if (fmd->isLink()) {
+          // Resolved later on as the target can be anywhere
+          links.push_back(it.key());
+          continue;
+        }
+
+        entries.emplace_back();
+        StatListEntry& entry = entries.back();
+        entry.name = it.key();
+        _stat_file_md(fmd, &entry.buf);
+        eos::calculateEtag(fmd.get(), entry.etag);
+
+        if (fmd->hasAttribute("sys.eos.mdino")) {
+          entry.etag = "hardlink";
+        }
+
+        eos::appendChecksumOnStringAsHex(fmd.get(), entry.checksum);
+
+        for (const auto& key : attr_keys) {
+          if (fmd->hasAttribute(key)) {
+            entry.attrs[key] = fmd->getAttribute(key);
+          }
+        }
+      } catch (eos::MDException& e) {
+        eos_debug("msg=\"skip entry\" name=%s ec=%d emsg=\"%s\"",
+                  it.key().c_str(), e.getErrno(), e.getMessage().str().c_str());
+      }
+    }
+
+    for (auto it = eos::ContainerMapIterator(dh); it.valid(); it.next()) {
+      if (!gOFS->allow_public_access((dir_path + it.key()).c_str(), vid)) {
+        continue;
+      }
+
+      try {
+        std::shared_ptr<eos::IContainerMD> cmd =
+          gOFS->eosDirectoryService->getContainerMD(it.value());
+        entries.emplace_back();
+        StatListEntry& entry = entries.back();
+        entry.name = it.key();
+        _stat_container_md(cmd, &entry.buf);
+        eos::calculateEtag(cmd.get(), entry.etag);
+
+        for (const auto& key : attr_keys) {
+          if (cmd->hasAttribute(key)) {
+            entry.attrs[key] = cmd->getAttribute(key);
+          }
+        }
+      } catch (eos::MDException& e) {
+        eos_debug("msg=\"skip entry\" name=%s ec=%d emsg=\"%s\"",
+                  it.key().c_str(), e.getErrno(), e.getMessage().str().c_str());
+      }
+    }
+  }
+
+  for (const auto& name : links) {
+    StatListEntry entry;
+    entry.name = name;
+    XrdOucErrInfo link_error;
+
+    if (_stat((dir_path + name).c_str(), &entry.buf, link_error, vid, nullptr,
+              &entry.etag, true, nullptr, &entry.checksum) == SFS_OK) {
+      entries.push_back(std::move(entry));
+    }
+  }
+
+  std::sort(entries.begin(), entries.end(),
+  [](const StatListEntry & a, const StatListEntry & b) {
+    return a.name < b.name;
+  });
+  gOFS->MgmStats.Add("StatList-Entry", vid.uid, vid.gid, entries.size());
+  EXEC_TIMING_END("StatList");
+  return SFS_OK;
+}
+
 // ---------------------------------------------------------------------------
 //  get the checksum info of a file
 // ---------------------------------------------------------------------------
@@ -27,7 +27,10 @@
 #include "mgm/FsView.hh"
 #include "common/table_formatter/TableFormatterBase.hh"
 #include "common/ThreadPool.hh"
+#include "common/LayoutId.hh"
 #include "namespace/interface/IView.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/Prefetcher.hh"
 #include <sstream>
 
 EOSMGMNAMESPACE_BEGIN
@@ -35,16 +38,42 @@ EOSMGMNAMESPACE_BEGIN
 using namespace std::chrono;
 constexpr std::chrono::seconds DrainFs::sRefreshTimeout;
 constexpr std::chrono::seconds DrainFs::sStallTimeout;
+constexpr std::chrono::seconds DrainFs::sUpdateInterval;
+constexpr size_t DrainFs::sQueueWindow;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Number of replicas/stripes a file is missing
+//------------------------------------------------------------------------------
+uint32_t
+GetMissingReplicas(const eos::IFileMD& fmd)
+{
+  const uint32_t expected =
+    eos::common::LayoutId::GetStripeNumber(fmd.getLayoutId()) + 1;
+  uint32_t present = 0;
+
+  for (const auto loc : fmd.getLocations()) {
+    if (loc != EOS_TAPE_FSID) {
+      ++present;
+    }
+  }
+
+  return ((expected > present) ? (expected - present) : 0);
+}
+}
 
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
-DrainFs::DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
+DrainFs::DrainFs(eos::common::ThreadPool& thread_pool,
+                 DrainScheduler& scheduler, eos::IFsView* fs_view,
                  eos::common::FileSystem::fsid_t src_fsid,
                  eos::common::FileSystem::fsid_t dst_fsid):
   mNsFsView(fs_view), mFsId(src_fsid), mTargetFsId(dst_fsid),
   mStatus(eos::common::DrainStatus::kNoDrain), mDidRerun(false),
   mDrainStop(false), mMaxJobs(10), mDrainPeriod(0), mThreadPool(thread_pool),
+  mScheduler(scheduler), mScheduling(false),
   mTotalFiles(0ull), mPending(0ull), mLastPending(0ull),
   mLastProgressTime(steady_clock::now()),
   mLastUpdateTime(steady_clock::now())
@@ -109,36 +138,39 @@ DrainFs::DoIt()
   }
 
   State state = State::Running;
+  // Jobs are handed out by the central scheduler, the launcher only holds a
+  // weak reference since the scheduler can outlive this object
+  std::weak_ptr<DrainFs> weak_self = shared_from_this();
+  mSchedInfo.mMaxSlots = mMaxJobs;
+  mScheduler.Register(mFsId, mSchedInfo,
+  [weak_self](DrainScheduler::Batch && batch) {
+    if (auto self = weak_self.lock()) {
+      self->LaunchJobs(std::move(batch));
+    }
+  });
+  mScheduling = true;
+  uint64_t events = 0ull;
 
   // Loop to drain the files
   while (!mDrainStop && (state != State::Done) && (state != State::Failed)) {
     mTotalFiles = mNsFsView->getNumFilesOnFs(mFsId);
     mPending = mTotalFiles;
+    auto it_fid = mNsFsView->getStreamingFileList(mFsId);
 
-    for (auto it_fid = mNsFsView->getStreamingFileList(mFsId);
-         it_fid && it_fid->valid(); /* no progress */) {
-      if (NumRunningJobs() <= mMaxJobs) {
-        std::shared_ptr<DrainTransferJob> job {
-          new DrainTransferJob(it_fid->getElement(), mFsId, mTargetFsId)};
+    while (true) {
+      // Keep a window of files queued in the scheduler
+      if (it_fid && it_fid->valid()) {
+        size_t queued = mScheduler.GetQueued(mFsId);
 
-        if (!gOFS->mFidTracker.AddEntry(it_fid->getElement(), TrackerType::Drain)) {
-          job->ReportError(SSTR("msg=\"skip currently scheduled drain\" "
-                                "fxid=" << std::hex << it_fid->getElement()));
-          eos::common::RWMutexWriteLock wr_lock(mJobsMutex);
-          mJobsFailed.insert(job);
-        } else {
-          mThreadPool.PushTask<void>([job] {return job->DoIt();});
-          eos::common::RWMutexWriteLock wr_lock(mJobsMutex);
-          mJobsRunning.push_back(job);
+        if (queued < sQueueWindow) {
+          SubmitCandidates(*it_fid, sQueueWindow - queued);
         }
-
-        // Advance to the next file id to be drained
-        it_fid->next();
-        --mPending;
-      } else {
-        std::this_thread::sleep_for(seconds(1));
       }
 
+      // Jobs are dispatched on completion of other jobs, the periodic
+      // dispatch resumes the ones held back by the bandwidth budgets
+      mScheduler.Dispatch();
+      events = mScheduler.WaitForEvent(mFsId, events, seconds(1));
       HandleRunningJobs();
       state = UpdateProgress();
 
@@ -146,17 +178,11 @@ DrainFs::DoIt()
         break;
       }
     }
-
-    if (mDrainStop) {
-      break;
-    }
-
-    while (!mDrainStop && (state == State::Running)) {
-      HandleRunningJobs();
-      state = UpdateProgress();
-    }
   }
 
+  mScheduling = false;
+  mScheduler.Unregister(mFsId);
+
   if (mDrainStop) {
     StopJobs();
     ResetCounters();
@@ -172,6 +198,102 @@ DrainFs::DoIt()
   return state;
 }
 
+//------------------------------------------------------------------------------
+// Submit the next files of the file list to the scheduler
+//------------------------------------------------------------------------------
+void
+DrainFs::SubmitCandidates(eos::ICollectionIterator<eos::IFileMD::id_t>& it_fid,
+                          size_t max)
+{
+  std::vector<eos::IFileMD::id_t> fids;
+
+  for (; it_fid.valid() && (fids.size() < max); it_fid.next()) {
+    fids.push_back(it_fid.getElement());
+  }
+
+  if (fids.empty()) {
+    return;
+  }
+
+  eos::Prefetcher prefetcher(gOFS->eosView);
+
+  for (const auto fid : fids) {
+    prefetcher.stageFileMD(fid);
+  }
+
+  prefetcher.wait();
+  std::vector<DrainScheduler::Candidate> candidates;
+  candidates.reserve(fids.size());
+  {
+    eos::common::RWMutexReadLock ns_rd_lock(gOFS->eosViewRWMutex, __FUNCTION__,
+                                            __LINE__, __FILE__);
+
+    for (const auto fid : fids) {
+      candidates.emplace_back();
+      candidates.back().mFid = fid;
+
+      try {
+        auto fmd = gOFS->eosFileService->getFileMD(fid);
+        candidates.back().mSize = fmd->getSize();
+        candidates.back().mRisk = GetMissingReplicas(*fmd);
+      } catch (const eos::MDException& e) {
+        // Ghost entries are dropped by the drain job
+      }
+    }
+  }
+  mScheduler.Submit(mFsId, std::move(candidates));
+}
+
+//------------------------------------------------------------------------------
+// Start the drain jobs of a batch handed out by the scheduler
+//------------------------------------------------------------------------------
+void
+DrainFs::LaunchJobs(DrainScheduler::Batch&& batch)
+{
+  std::vector<std::pair<std::shared_ptr<DrainTransferJob>, uint64_t>> jobs;
+
+  if (mScheduling) {
+    eos::common::RWMutexWriteLock wr_lock(mJobsMutex);
+
+    for (const auto& candidate : batch) {
+      std::shared_ptr<DrainTransferJob> job {
+        new DrainTransferJob(candidate.mFid, mFsId, mTargetFsId)};
+
+      if (!gOFS->mFidTracker.AddEntry(candidate.mFid, TrackerType::Drain)) {
+        job->ReportError(SSTR("msg=\"skip currently scheduled drain\" "
+                              "fxid=" << std::hex << candidate.mFid));
+        mJobsFailed.insert(job);
+      } else {
+        mJobsRunning.push_back(job);
+        jobs.emplace_back(job, candidate.mSize);
+      }
+
+      // New files could have been added since the drain started
+      if (mPending) {
+        --mPending;
+      }
+    }
+  }
+
+  // The completion is always reported from the thread pool so that the
+  // scheduler does not recurse into the launcher
+  DrainScheduler& scheduler = mScheduler;
+  const eos::common::FileSystem::fsid_t fsid = mFsId;
+  mThreadPool.PushTask<void>([jobs, &scheduler, fsid] {
+    uint64_t bytes = 0ull;
+
+    for (const auto& job : jobs) {
+      job.first->DoIt();
+
+      if (job.first->GetStatus() == DrainTransferJob::Status::OK) {
+        bytes += job.second;
+      }
+    }
+
+    scheduler.Done(fsid, bytes);
+  });
+}
+
 //----------------------------------------------------------------------------
 // Handle running jobs
 //----------------------------------------------------------------------------
@@ -260,9 +382,11 @@ DrainFs::StopJobs()
   {
     eos::common::RWMutexReadLock rd_lock(mJobsMutex);
 
-    // Signal all drain jobs to stop/cancel
+    // Signal all drain jobs to stop/cancel, including the ones still
+    // waiting for their batch to reach them
     for (auto& job : mJobsRunning) {
-      if (job->GetStatus() == DrainTransferJob::Status::Running) {
+      if ((job->GetStatus() == DrainTransferJob::Status::Running) ||
+          (job->GetStatus() == DrainTransferJob::Status::Ready)) {
         job->Cancel();
       }
     }
@@ -310,6 +434,10 @@ DrainFs::PrepareFs()
     eos::common::FileSystem::fs_snapshot_t drain_snapshot;
     fs->SnapShotFileSystem(drain_snapshot, false);
     space_name = drain_snapshot.mSpace;
+    mSchedInfo.mSpace = drain_snapshot.mSpace;
+    mSchedInfo.mNode = drain_snapshot.mHostPort;
+    mSchedInfo.mGroup = drain_snapshot.mGroup;
+    mSchedInfo.mLink = drain_snapshot.mGeoTag;
   }
   mDrainStart = steady_clock::now();
   mDrainEnd = mDrainStart + mDrainPeriod;
@@ -373,8 +501,6 @@ DrainFs::UpdateProgress()
   if (mLastPending != mPending) {
     mLastPending = mPending;
     mLastProgressTime = now;
-  } else {
-    std::this_thread::sleep_for(seconds(1));
   }
 
   auto duration = now - mLastProgressTime;
@@ -385,7 +511,8 @@ DrainFs::UpdateProgress()
                    "failed=%llu\"", mFsId,
                    duration_cast<milliseconds>(now.time_since_epoch()).count(),
                    duration_cast<milliseconds>(mLastProgressTime.time_since_epoch()).count(),
-                   is_stalled, mTotalFiles, mLastPending, mPending, NumRunningJobs(),
+                   is_stalled, mTotalFiles, mLastPending, mPending.load(),
+                   NumRunningJobs(),
                    NumFailedJobs());
 
   // Check if drain expired
@@ -395,7 +522,8 @@ DrainFs::UpdateProgress()
   }
 
   // Update drain display variables
-  if (is_stalled || is_expired || (mLastProgressTime == now)) {
+  if (is_expired || (now - mLastUpdateTime >= sUpdateInterval)) {
+    mLastUpdateTime = now;
     eos::common::RWMutexReadLock fs_rd_lock(FsView::gFsView.ViewMutex);
     FileSystem* fs = FsView::gFsView.mIdView.lookupByID(mFsId);
 
@@ -435,8 +563,14 @@ DrainFs::UpdateProgress()
     }
 
     uint64_t time_left = 99999999999ull;
-
-    if (mDrainEnd > now) {
+    const uint64_t bytes_left = fs->GetLongLong("stat.statfs.usedbytes");
+    // Estimate from the observed drain rate, until it is known display the
+    // time left until the drain period expires
+    const int64_t eta = mScheduler.GetEta(mFsId, bytes_left);
+
+    if (eta >= 0) {
+      time_left = eta;
+    } else if (mDrainEnd > now) {
       time_left = duration_cast<seconds>(mDrainEnd - now).count();
     }
 
@@ -444,8 +578,7 @@ DrainFs::UpdateProgress()
     batch.setLongLongLocal("local.drain.files", mPending);
     batch.setLongLongLocal("local.drain.progress", progress);
     batch.setLongLongLocal("local.drain.timeleft", time_left);
-    batch.setLongLongLocal("local.drain.bytesleft",
-                           fs->GetLongLong("stat.statfs.usedbytes"));
+    batch.setLongLongLocal("local.drain.bytesleft", bytes_left);
     fs->applyBatch(batch);
     eos_static_debug("msg=\"fsid=%d, update progress", mFsId);
   }
@@ -457,7 +590,8 @@ DrainFs::UpdateProgress()
 
   // If we have only failed jobs check if the files still exist. It could also
   // be that there were new files written while draining was started.
-  if ((mPending == 0) && (NumRunningJobs() == 0)) {
+  if ((mPending == 0) && (mScheduler.GetQueued(mFsId) == 0) &&
+      (NumRunningJobs() == 0)) {
     uint64_t total_files = mNsFsView->getNumFilesOnFs(mFsId);
 
     if (total_files == 0) {
@@ -23,6 +23,7 @@
 #pragma once
 #include "mgm/Namespace.hh"
 #include "mgm/FileSystem.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include "namespace/interface/IFsView.hh"
 #include "common/Logging.hh"
 #include <thread>
@@ -46,7 +47,8 @@ class TableFormatterBase;
 //------------------------------------------------------------------------------
 //! @brief Class implementing the draining of a filesystem
 //------------------------------------------------------------------------------
-class DrainFs: public eos::common::LogId
+class DrainFs: public eos::common::LogId,
+  public std::enable_shared_from_this<DrainFs>
 {
 public:
   //----------------------------------------------------------------------------
@@ -58,11 +60,13 @@ public:
   //! Constructor
   //!
   //! @param thread_pool drain thread pool to use for jobs
+  //! @param scheduler central scheduler of the drain jobs
   //! @param fs_view file system view
   //! @param src_fsid filesystem id to drain
   //! @param dst_fsid file system where to drain
   //----------------------------------------------------------------------------
-  DrainFs(eos::common::ThreadPool& thread_pool, eos::IFsView* fs_view,
+  DrainFs(eos::common::ThreadPool& thread_pool, DrainScheduler& scheduler,
+          eos::IFsView* fs_view,
           eos::common::FileSystem::fsid_t src_fsid,
           eos::common::FileSystem::fsid_t dst_fsid = 0);
 
@@ -166,11 +170,22 @@ private:
   bool MarkFsDraining();
 
   //---------------------------------------------------------------------------
-  //! Collect and prepare all the drain jobs
+  //! Submit the next files of the file list to the scheduler, together with
+  //! their size and number of missing replicas
   //!
-  //! @returns number of drain jobs prepared
+  //! @param it_fid iterator over the files of the file system
+  //! @param max max number of files to submit
   //---------------------------------------------------------------------------
-  uint64_t CollectDrainJobs();
+  void SubmitCandidates(eos::ICollectionIterator<eos::IFileMD::id_t>& it_fid,
+                        size_t max);
+
+  //---------------------------------------------------------------------------
+  //! Start the drain jobs of a batch handed out by the scheduler, run in the
+  //! thread pool one after the other
+  //!
+  //! @param batch files to drain
+  //---------------------------------------------------------------------------
+  void LaunchJobs(DrainScheduler::Batch&& batch);
 
   //---------------------------------------------------------------------------
   //! Update progress of the drain
@@ -225,6 +240,10 @@ private:
 
   constexpr static std::chrono::seconds sRefreshTimeout {60};
   constexpr static std::chrono::seconds sStallTimeout {600};
+  //! Interval between two updates of the drain status of the file system
+  constexpr static std::chrono::seconds sUpdateInterval {1};
+  //! Max number of files queued in the scheduler for one file system
+  constexpr static size_t sQueueWindow {1024};
   eos::IFsView* mNsFsView; ///< File system view
   eos::common::FileSystem::fsid_t mFsId; ///< Drain source fsid
   eos::common::FileSystem::fsid_t mTargetFsId; /// Drain target fsid
@@ -241,9 +260,13 @@ private:
   std::list<std::shared_ptr<DrainTransferJob>> mJobsRunning;
   mutable eos::common::RWMutex mJobsMutex; ///< RW mutex protecting job lists
   eos::common::ThreadPool& mThreadPool;
+  DrainScheduler& mScheduler; ///< Scheduler shared by all drains
+  DrainScheduler::FsInfo mSchedInfo; ///< Placement used for scheduling
+  std::atomic<bool> mScheduling; ///< Flag if registered with the scheduler
   std::future<State> mFuture;
   uint64_t mTotalFiles; ///< Total number of files to drain
-  uint64_t mPending; ///< Current num. of pending files to drain
+  //! Current num. of pending files to drain i.e. not yet handed out
+  std::atomic<uint64_t> mPending;
   uint64_t mLastPending; ///< Previous num. of pending files to drain
   //! Last timestamp when drain progress was recorded
   std::chrono::time_point<std::chrono::steady_clock> mLastProgressTime;
@@ -0,0 +1,398 @@
+//------------------------------------------------------------------------------
+// File: DrainScheduler.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/drain/DrainScheduler.hh"
+#include <algorithm>
+#include <cmath>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr uint64_t DrainScheduler::sSmallFileSize;
+constexpr size_t DrainScheduler::sMaxBatchFiles;
+constexpr std::chrono::seconds DrainScheduler::sBurstInterval;
+constexpr std::chrono::seconds DrainScheduler::sRateInterval;
+constexpr std::chrono::seconds DrainScheduler::sRateWindow;
+
+//------------------------------------------------------------------------------
+// Register a draining file system
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Register(fsid_t fsid, const FsInfo& info, Launcher launcher)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  FsState& state = mFs[fsid];
+  // Keep the events of a re-registered file system for a waiting caller
+  auto cv_event = state.mCvEvent;
+  const uint64_t events = state.mEvents;
+  state = FsState();
+  state.mEvents = events;
+  state.mCvEvent = (cv_event ? cv_event :
+                    std::make_shared<std::condition_variable>());
+  state.mInfo = info;
+  state.mInfo.mMaxSlots = std::max(info.mMaxSlots, 1u);
+  state.mLauncher = std::move(launcher);
+  state.mLastSample = eos::common::SteadyClock::now(&mClock);
+}
+
+//------------------------------------------------------------------------------
+// Unregister file system
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Unregister(fsid_t fsid)
+{
+  std::shared_ptr<std::condition_variable> cv_event;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto it = mFs.find(fsid);
+
+    if (it == mFs.end()) {
+      return;
+    }
+
+    cv_event = it->second.mCvEvent;
+    mFs.erase(it);
+  }
+  cv_event->notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Set the bandwidth budgets of the given space
+//------------------------------------------------------------------------------
+void
+DrainScheduler::SetBudget(const std::string& space, const Budget& budget)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mBudgets[space] = budget;
+}
+
+//------------------------------------------------------------------------------
+// Queue candidates of the given file system and dispatch
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Submit(fsid_t fsid, std::vector<Candidate>&& candidates)
+{
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto it = mFs.find(fsid);
+
+    if (it == mFs.end()) {
+      return;
+    }
+
+    it->second.mQueue.insert(candidates.begin(), candidates.end());
+  }
+  Dispatch();
+}
+
+//------------------------------------------------------------------------------
+// Report that a batch finished and dispatch
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Done(fsid_t fsid, uint64_t bytes)
+{
+  std::shared_ptr<std::condition_variable> cv_event;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    auto it = mFs.find(fsid);
+
+    if (it != mFs.end()) {
+      if (it->second.mRunning) {
+        --it->second.mRunning;
+      }
+
+      it->second.mBytesDone += bytes;
+      ++it->second.mEvents;
+      cv_event = it->second.mCvEvent;
+    }
+  }
+
+  // Only the file system of the finished batch needs to react
+  if (cv_event) {
+    cv_event->notify_all();
+  }
+
+  Dispatch();
+}
+
+//------------------------------------------------------------------------------
+// Dispatch as many transfers as the slots and budgets allow
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Dispatch()
+{
+  std::vector<std::pair<Launcher, Batch>> launches;
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    if (mFs.empty()) {
+      return;
+    }
+
+    const auto now = eos::common::SteadyClock::now(&mClock);
+    // Start from a different file system every time so that none of them is
+    // favoured when the budgets are tight
+    std::vector<FsState*> order;
+    order.reserve(mFs.size());
+
+    for (auto& elem : mFs) {
+      order.push_back(&elem.second);
+    }
+
+    std::rotate(order.begin(), order.begin() + (mRound++ % order.size()),
+                order.end());
+    bool dispatched = true;
+
+    // Hand out one batch per file system and round
+    while (dispatched) {
+      dispatched = false;
+
+      for (auto* state : order) {
+        if (state->mQueue.empty() ||
+            (state->mRunning >= state->mInfo.mMaxSlots)) {
+          continue;
+        }
+
+        Budget budget;
+        auto it_budget = mBudgets.find(state->mInfo.mSpace);
+
+        if (it_budget != mBudgets.end()) {
+          budget = it_budget->second;
+        }
+
+        // File systems without geotag do not share any link
+        if (state->mInfo.mLink.empty()) {
+          budget.mLinkRate = 0;
+        }
+
+        const std::string node_key = "node:" + state->mInfo.mNode;
+        const std::string group_key = "group:" + state->mInfo.mGroup;
+        const std::string link_key = "link:" + state->mInfo.mLink;
+
+        if (!HasBudget(node_key, budget.mNodeRate, now) ||
+            !HasBudget(group_key, budget.mGroupRate, now) ||
+            !HasBudget(link_key, budget.mLinkRate, now)) {
+          continue;
+        }
+
+        Batch batch = TakeBatch(*state);
+        uint64_t bytes = 0;
+
+        for (const auto& candidate : batch) {
+          bytes += candidate.mSize;
+        }
+
+        Charge(node_key, budget.mNodeRate, bytes);
+        Charge(group_key, budget.mGroupRate, bytes);
+        Charge(link_key, budget.mLinkRate, bytes);
+        ++state->mRunning;
+        launches.emplace_back(state->mLauncher, std::move(batch));
+        dispatched = true;
+      }
+    }
+  }
+
+  // Launch without holding the lock, the launcher may call Done directly
+  for (auto& launch : launches) {
+    launch.first(std::move(launch.second));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Wait until a batch completes or the timeout expires
+//------------------------------------------------------------------------------
+uint64_t
+DrainScheduler::WaitForEvent(fsid_t fsid, uint64_t seen,
+                             std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mFs.find(fsid);
+
+  if (it == mFs.end()) {
+    return seen;
+  }
+
+  // The condition variable outlives the state if the file system is
+  // unregistered while waiting
+  std::shared_ptr<std::condition_variable> cv_event = it->second.mCvEvent;
+  uint64_t events = seen;
+  cv_event->wait_for(lock, timeout, [&]() {
+    auto it_fs = mFs.find(fsid);
+
+    if (it_fs == mFs.end()) {
+      return true;
+    }
+
+    events = it_fs->second.mEvents;
+    return (events != seen);
+  });
+  return events;
+}
+
+//------------------------------------------------------------------------------
+// Get number of candidates queued for the given file system
+//------------------------------------------------------------------------------
+size_t
+DrainScheduler::GetQueued(fsid_t fsid) const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mFs.find(fsid);
+  return ((it == mFs.end()) ? 0 : it->second.mQueue.size());
+}
+
+//------------------------------------------------------------------------------
+// Get number of batches running for the given file system
+//------------------------------------------------------------------------------
+uint32_t
+DrainScheduler::GetRunning(fsid_t fsid) const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mFs.find(fsid);
+  return ((it == mFs.end()) ? 0 : it->second.mRunning);
+}
+
+//------------------------------------------------------------------------------
+// Get observed drain rate of the given file system
+//------------------------------------------------------------------------------
+double
+DrainScheduler::GetRate(fsid_t fsid)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto it = mFs.find(fsid);
+
+  if (it == mFs.end()) {
+    return 0;
+  }
+
+  SampleRate(it->second, eos::common::SteadyClock::now(&mClock));
+  return it->second.mRate;
+}
+
+//------------------------------------------------------------------------------
+// Get estimated time to drain the given number of bytes
+//------------------------------------------------------------------------------
+int64_t
+DrainScheduler::GetEta(fsid_t fsid, uint64_t bytes_left)
+{
+  const double rate = GetRate(fsid);
+
+  if (rate <= 0) {
+    return -1;
+  }
+
+  return (int64_t) std::ceil(bytes_left / rate);
+}
+
+//------------------------------------------------------------------------------
+// Check if the bucket of the given key has budget left
+//------------------------------------------------------------------------------
+bool
+DrainScheduler::HasBudget(const std::string& key, uint64_t rate,
+                          TimePoint now)
+{
+  if (rate == 0) {
+    return true;
+  }
+
+  Bucket& bucket = mBuckets[key];
+  const double max_tokens = (double) rate * sBurstInterval.count();
+
+  if (!bucket.mInit) {
+    bucket.mTokens = max_tokens;
+    bucket.mInit = true;
+  } else {
+    const double elapsed = std::chrono::duration<double>
+                           (now - bucket.mLast).count();
+    bucket.mTokens = std::min(max_tokens, bucket.mTokens + rate * elapsed);
+  }
+
+  bucket.mLast = now;
+  return (bucket.mTokens > 0);
+}
+
+//------------------------------------------------------------------------------
+// Charge the bucket of the given key
+//------------------------------------------------------------------------------
+void
+DrainScheduler::Charge(const std::string& key, uint64_t rate, uint64_t bytes)
+{
+  if (rate) {
+    mBuckets[key].mTokens -= bytes;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take the next batch from the queue of the file system
+//------------------------------------------------------------------------------
+DrainScheduler::Batch
+DrainScheduler::TakeBatch(FsState& state)
+{
+  Batch batch;
+  auto it = state.mQueue.begin();
+  const bool is_small = (it->mSize < sSmallFileSize);
+  batch.push_back(*it);
+  it = state.mQueue.erase(it);
+
+  // The following files with the same risk are smaller, files with a lower
+  // risk can be larger and are left for later
+  if (is_small) {
+    while ((it != state.mQueue.end()) && (batch.size() < sMaxBatchFiles)) {
+      if (it->mSize < sSmallFileSize) {
+        batch.push_back(*it);
+        it = state.mQueue.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  return batch;
+}
+
+//------------------------------------------------------------------------------
+// Update the observed rate of the file system
+//------------------------------------------------------------------------------
+void
+DrainScheduler::SampleRate(FsState& state, TimePoint now)
+{
+  const double elapsed = std::chrono::duration<double>
+                         (now - state.mLastSample).count();
+
+  if (elapsed < sRateInterval.count()) {
+    return;
+  }
+
+  const double rate = state.mBytesDone / elapsed;
+
+  if (!state.mHasRate) {
+    state.mRate = rate;
+    state.mHasRate = true;
+  } else {
+    // Exponential average weighted by the length of the sample interval
+    const double alpha = 1.0 - std::exp(-elapsed / sRateWindow.count());
+    state.mRate += alpha * (rate - state.mRate);
+  }
+
+  state.mBytesDone = 0;
+  state.mLastSample = now;
+}
+
+EOSMGMNAMESPACE_END
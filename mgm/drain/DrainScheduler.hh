@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+//! @file DrainScheduler.hh
+//! @brief Central scheduler of drain transfers across all draining file systems
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "common/FileId.hh"
+#include "common/FileSystem.hh"
+#include "common/SteadyClock.hh"
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class DrainScheduler - decides which drain transfers run next, shared by
+//! all the DrainFs objects.
+//!
+//! Every draining file system registers itself together with its source node,
+//! scheduling group (the destination of the drain) and network link (the
+//! geotag of the source) and keeps a window of candidate files queued in the
+//! scheduler. A new transfer is dispatched whenever one completes or new
+//! candidates are submitted: the file systems are visited round-robin and one
+//! gets a transfer if it still has a free slot and none of its source node,
+//! group and link exceeded its bytes/s budget. Budgets are token buckets
+//! charged with the size of the dispatched files, so a single large file can
+//! overdraw a bucket which then blocks the key until it refilled.
+//!
+//! Within a file system the files with most missing replicas/stripes go
+//! first, then the largest ones. Small files are handed out in batches which
+//! occupy a single slot.
+//------------------------------------------------------------------------------
+class DrainScheduler
+{
+public:
+  using fsid_t = eos::common::FileSystem::fsid_t;
+  //! Files smaller than this are batched together
+  static constexpr uint64_t sSmallFileSize = 1024 * 1024;
+  //! Max number of small files in a batch
+  static constexpr size_t sMaxBatchFiles = 32;
+  //! Max time a budget can be accumulated while a key is idle
+  static constexpr std::chrono::seconds sBurstInterval {2};
+  //! Min interval between two rate samples
+  static constexpr std::chrono::seconds sRateInterval {5};
+  //! Time constant of the observed rate average
+  static constexpr std::chrono::seconds sRateWindow {60};
+
+  //----------------------------------------------------------------------------
+  //! File to be drained
+  //----------------------------------------------------------------------------
+  struct Candidate {
+    eos::common::FileId::fileid_t mFid {0};
+    uint64_t mSize {0}; ///< File size in bytes
+    uint32_t mRisk {0}; ///< Number of missing replicas/stripes
+
+    //--------------------------------------------------------------------------
+    //! Scheduling order - most at risk first, then the largest files
+    //--------------------------------------------------------------------------
+    bool operator<(const Candidate& other) const
+    {
+      if (mRisk != other.mRisk) {
+        return mRisk > other.mRisk;
+      }
+
+      if (mSize != other.mSize) {
+        return mSize > other.mSize;
+      }
+
+      return mFid < other.mFid;
+    }
+  };
+
+  using Batch = std::vector<Candidate>;
+  //! Start the transfers of a batch, must call Done once they are finished
+  using Launcher = std::function<void(Batch&& batch)>;
+
+  //----------------------------------------------------------------------------
+  //! Bandwidth budgets in bytes/s, 0 means unlimited
+  //----------------------------------------------------------------------------
+  struct Budget {
+    uint64_t mNodeRate {0}; ///< Per source node
+    uint64_t mGroupRate {0}; ///< Per destination group
+    uint64_t mLinkRate {0}; ///< Per network link
+  };
+
+  //----------------------------------------------------------------------------
+  //! Placement of a draining file system
+  //----------------------------------------------------------------------------
+  struct FsInfo {
+    std::string mSpace;
+    std::string mNode; ///< Source node host:port
+    std::string mGroup; ///< Scheduling group i.e. destination of the drain
+    std::string mLink; ///< Network link of the source i.e. its geotag
+    uint32_t mMaxSlots {1}; ///< Max number of concurrent transfers/batches
+  };
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param fake_clock if true use a fake clock, for testing
+  //----------------------------------------------------------------------------
+  DrainScheduler(bool fake_clock = false):
+    mClock(fake_clock)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Register a draining file system
+  //!
+  //! @param fsid file system id
+  //! @param info placement of the file system
+  //! @param launcher function starting the transfers of the file system
+  //----------------------------------------------------------------------------
+  void Register(fsid_t fsid, const FsInfo& info, Launcher launcher);
+
+  //----------------------------------------------------------------------------
+  //! Unregister file system, drops the queued candidates. Completions of
+  //! transfers still running are ignored.
+  //----------------------------------------------------------------------------
+  void Unregister(fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Set the bandwidth budgets of the given space
+  //----------------------------------------------------------------------------
+  void SetBudget(const std::string& space, const Budget& budget);
+
+  //----------------------------------------------------------------------------
+  //! Queue candidates of the given file system and dispatch
+  //----------------------------------------------------------------------------
+  void Submit(fsid_t fsid, std::vector<Candidate>&& candidates);
+
+  //----------------------------------------------------------------------------
+  //! Report that a batch previously launched finished and dispatch
+  //!
+  //! @param fsid file system id
+  //! @param bytes number of bytes drained successfully
+  //----------------------------------------------------------------------------
+  void Done(fsid_t fsid, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Dispatch as many transfers as the slots and budgets allow. Called
+  //! automatically on submit and completion, needs to be called periodically
+  //! as well so that transfers blocked by budgets resume once they refilled.
+  //----------------------------------------------------------------------------
+  void Dispatch();
+
+  //----------------------------------------------------------------------------
+  //! Wait until a batch of the given file system completes, the file system
+  //! is unregistered or the timeout expires. Only the waiter of the file
+  //! system is woken up.
+  //!
+  //! @param fsid file system id
+  //! @param seen event counter returned by the previous call, 0 initially
+  //! @param timeout max time to wait
+  //!
+  //! @return current event counter of the file system
+  //----------------------------------------------------------------------------
+  uint64_t WaitForEvent(fsid_t fsid, uint64_t seen,
+                        std::chrono::milliseconds timeout);
+
+  //----------------------------------------------------------------------------
+  //! Get number of candidates queued for the given file system
+  //----------------------------------------------------------------------------
+  size_t GetQueued(fsid_t fsid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of batches running for the given file system
+  //----------------------------------------------------------------------------
+  uint32_t GetRunning(fsid_t fsid) const;
+
+  //----------------------------------------------------------------------------
+  //! Get observed drain rate of the given file system in bytes/s, 0 if not
+  //! yet known
+  //----------------------------------------------------------------------------
+  double GetRate(fsid_t fsid);
+
+  //----------------------------------------------------------------------------
+  //! Get estimated time to drain the given number of bytes at the observed
+  //! rate of the file system
+  //!
+  //! @return seconds left or -1 if the rate is not yet known
+  //----------------------------------------------------------------------------
+  int64_t GetEta(fsid_t fsid, uint64_t bytes_left);
+
+  //----------------------------------------------------------------------------
+  //! Get clock used for the budgets and rates, for testing
+  //----------------------------------------------------------------------------
+  inline eos::common::SteadyClock& GetClock()
+  {
+    return mClock;
+  }
+
+private:
+  using TimePoint = std::chrono::steady_clock::time_point;
+
+  //! Token bucket of a budget key
+  struct Bucket {
+    double mTokens {0};
+    TimePoint mLast;
+    bool mInit {false};
+  };
+
+  //! Scheduling state of a file system
+  struct FsState {
+    FsInfo mInfo;
+    Launcher mLauncher;
+    std::multiset<Candidate> mQueue;
+    uint32_t mRunning {0};
+    uint64_t mBytesDone {0}; ///< Bytes drained since the last rate sample
+    TimePoint mLastSample;
+    double mRate {0}; ///< Observed rate in bytes/s
+    bool mHasRate {false};
+    uint64_t mEvents {0}; ///< Number of completions so far
+    //! Signalled on completion, shared with the waiter since the state can
+    //! be dropped while it waits
+    std::shared_ptr<std::condition_variable> mCvEvent;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Check if the bucket of the given key has budget left, refilling it
+  //! first. Must hold mMutex.
+  //----------------------------------------------------------------------------
+  bool HasBudget(const std::string& key, uint64_t rate, TimePoint now);
+
+  //----------------------------------------------------------------------------
+  //! Charge the bucket of the given key. Must hold mMutex.
+  //----------------------------------------------------------------------------
+  void Charge(const std::string& key, uint64_t rate, uint64_t bytes);
+
+  //----------------------------------------------------------------------------
+  //! Take the next batch from the queue of the file system. Must hold mMutex.
+  //----------------------------------------------------------------------------
+  static Batch TakeBatch(FsState& state);
+
+  //----------------------------------------------------------------------------
+  //! Update the observed rate of the file system. Must hold mMutex.
+  //----------------------------------------------------------------------------
+  void SampleRate(FsState& state, TimePoint now);
+
+  eos::common::SteadyClock mClock;
+  mutable std::mutex mMutex;
+  uint64_t mRound {0}; ///< Round-robin start position
+  std::map<fsid_t, FsState> mFs;
+  std::map<std::string, Budget> mBudgets; ///< Budgets per space
+  std::map<std::string, Bucket> mBuckets; ///< Token buckets per key
+};
+
+EOSMGMNAMESPACE_END
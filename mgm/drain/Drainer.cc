@@ -139,8 +139,8 @@ Drainer::StartFsDrain(eos::mgm::FileSystem* fs,
   }
 
   // Start the drain
-  std::shared_ptr<DrainFs> dfs(new DrainFs(mThreadPool, gOFS->eosFsView,
-                               src_fsid, dst_fsid));
+  std::shared_ptr<DrainFs> dfs(new DrainFs(mThreadPool, mScheduler,
+                               gOFS->eosFsView, src_fsid, dst_fsid));
   auto future = std::async(std::launch::async, &DrainFs::DoIt, dfs);
   dfs->SetFuture(std::move(future));
   mDrainFs[src_snapshot.mHostPort].emplace(dfs);
@@ -368,6 +368,15 @@ Drainer::UpdateFromSpaceConfig()
         space.second->SetConfigMember("drainer.node.nfs", "5");
       }
 
+      // Bandwidth budgets of the drain scheduler given in MB/s
+      DrainScheduler::Budget budget;
+      budget.mNodeRate = strtoull(space.second->GetConfigMember
+                                  ("drainer.node.maxbw").c_str(), 0, 10) * 1000000ull;
+      budget.mGroupRate = strtoull(space.second->GetConfigMember
+                                   ("drainer.group.maxbw").c_str(), 0, 10) * 1000000ull;
+      budget.mLinkRate = strtoull(space.second->GetConfigMember
+                                  ("drainer.link.maxbw").c_str(), 0, 10) * 1000000ull;
+      mScheduler.SetBudget(space.first, budget);
       // Set the space configuration
       XrdSysMutexHelper scope_lock(mCfgMutex);
       mCfgMap[space.first] = max_drain_fs;
@@ -26,6 +26,7 @@
 #include "common/ThreadPool.hh"
 #include "common/AssistedThread.hh"
 #include "common/FileSystem.hh"
+#include "mgm/drain/DrainScheduler.hh"
 #include <list>
 
 EOSMGMNAMESPACE_BEGIN
@@ -175,6 +176,9 @@ private:
   DrainMap mDrainFs; ///< Map of nodes to file systems draining
   mutable eos::common::RWMutex mDrainMutex; ///< Mutex protecting the drain map
   mutable XrdSysMutex mCfgMutex; ///< Mutex for drain config updates
+  //! Scheduler of the drain jobs of all file systems, must outlive the
+  //! thread pool as the jobs report their completion to it
+  DrainScheduler mScheduler;
   eos::common::ThreadPool mThreadPool; ///< Thread pool for drain jobs
   ListPendingT mPending; ///< Queue of pending file systems to be drained
 };
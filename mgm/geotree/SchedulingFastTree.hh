@@ -2087,6 +2087,27 @@ public:
     }
   }
 
+  void
+  incrementFreeSlot(tFastTreeIdx node)
+  {
+    // exact opposite of decrementFreeSlot, used to release a slot taken in a
+    // working copy which is reused for several placements
+    pNodes[node].fileData.freeSlotsCount++;
+    pNodes[node].fileData.takenSlotsCount--;
+
+    if (node) {
+      tFastTreeIdx father = pNodes[node].treeData.fatherIdx;
+      tFastTreeIdx matchBranchIdx = pNodes[father].treeData.firstBranchIdx;
+
+      while (pBranches[matchBranchIdx].sonIdx != node) {
+        matchBranchIdx++;
+      }
+
+      fixBranchSorting(father, matchBranchIdx);
+      incrementFreeSlot(father);
+    }
+  }
+
   bool
   findFreeSlotFirstHit(tFastTreeIdx& newReplica, tFastTreeIdx startFrom = 0,
                        bool allowUpRoot = false, bool decrFreeSlot = true)
@@ -2287,6 +2308,171 @@ go_back:
     }
   }
 
+  //----------------------------------------------------------------------------
+  //! Find free slots in a working copy which is reused for several placements.
+  //! The unavailable nodes and the taken nodes are marked as such for this
+  //! placement only and all the modifications are undone in the reverse
+  //! order afterwards. Only the branches above the modified nodes are fixed
+  //! unless there are so many unavailable nodes that updating the full tree
+  //! is cheaper.
+  //!
+  //! @param newReplicas indexes of the new replicas
+  //! @param nReplicas number of replicas to place
+  //! @param startFrom node to start from for the last nFromStart replicas
+  //! @param nFromStart number of replicas to place starting from startFrom
+  //! @param takenNodes nodes holding already a replica
+  //! @param unavailableNodes nodes (or branches) to exclude
+  //!
+  //! @return true if all the replicas could be placed, otherwise false
+  //----------------------------------------------------------------------------
+  bool
+  findFreeSlotsInPlace(std::vector<tFastTreeIdx>& newReplicas,
+                       size_t nReplicas, tFastTreeIdx startFrom = 0,
+                       size_t nFromStart = 0,
+                       const std::vector<tFastTreeIdx>* takenNodes = NULL,
+                       const std::vector<tFastTreeIdx>* unavailableNodes = NULL)
+  {
+    // the valid taken nodes are taken like a placed replica, the other ones
+    // just get their file data overwritten
+    struct TakenNode {
+      tFastTreeIdx idx;
+      bool decremented;
+      FileData fileData;
+    };
+    std::vector<std::pair<tFastTreeIdx, FastTreeNode>> savedUnavailable;
+    std::vector<TakenNode> savedTaken;
+    const bool fullUpdate = unavailableNodes &&
+                            (unavailableNodes->size() > (size_t)(pNodeCount >> 3));
+    bool success = true;
+    newReplicas.clear();
+
+    // the unavailable nodes have to be marked first as their branches are
+    // aggregated again, which does not account for the taken slots
+    if (unavailableNodes) {
+      for (auto it = unavailableNodes->begin(); it != unavailableNodes->end();
+           ++it) {
+        savedUnavailable.push_back(std::make_pair(*it, pNodes[*it]));
+        pNodes[*it].fsData.mStatus = pNodes[*it].fsData.mStatus & ~Available;
+
+        if (!fullUpdate) {
+          fixBranch(*it);
+        }
+      }
+
+      if (fullUpdate) {
+        updateTree();
+      }
+    }
+
+    if (takenNodes) {
+      for (auto it = takenNodes->begin(); it != takenNodes->end(); ++it) {
+        savedTaken.push_back({*it, isValidSlotNode(*it), pNodes[*it].fileData});
+
+        if (savedTaken.back().decremented) {
+          decrementFreeSlot(*it);
+        } else {
+          pNodes[*it].fileData.freeSlotsCount = 0;
+          pNodes[*it].fileData.takenSlotsCount = 1;
+        }
+      }
+    }
+
+    for (size_t k = 0; k < nReplicas; k++) {
+      tFastTreeIdx idx;
+
+      if (!findFreeSlot(idx, (k < nReplicas - nFromStart) ? 0 : startFrom, true,
+                        true, false)) {
+        success = false;
+        break;
+      }
+
+      newReplicas.push_back(idx);
+    }
+
+    // undo everything in the reverse order
+    for (auto it = newReplicas.rbegin(); it != newReplicas.rend(); ++it) {
+      incrementFreeSlot(*it);
+    }
+
+    for (auto it = savedTaken.rbegin(); it != savedTaken.rend(); ++it) {
+      if (it->decremented) {
+        incrementFreeSlot(it->idx);
+      } else {
+        pNodes[it->idx].fileData = it->fileData;
+      }
+    }
+
+    for (auto it = savedUnavailable.rbegin(); it != savedUnavailable.rend();
+         ++it) {
+      pNodes[it->first] = it->second;
+
+      if (!fullUpdate) {
+        fixBranch(it->first);
+      }
+    }
+
+    if (fullUpdate) {
+      updateTree();
+    }
+
+    return success;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Book space on a file system of a working copy and lower its scores, so
+  //! that the next placements done in this working copy take them into account
+  //!
+  //! @param node file system node
+  //! @param bookingSize space to book
+  //! @param dlPenalty download score penalty
+  //! @param ulPenalty upload score penalty
+  //----------------------------------------------------------------------------
+  inline void
+  bookFreeSlot(tFastTreeIdx node, float bookingSize, char dlPenalty,
+               char ulPenalty)
+  {
+    FsData& fsData = pNodes[node].fsData;
+    fsData.totalSpace = (fsData.totalSpace > bookingSize) ?
+                        fsData.totalSpace - bookingSize : 0;
+
+    if (fsData.dlScore > 0) {
+      fsData.dlScore -= dlPenalty;
+    }
+
+    if (fsData.ulScore > 0) {
+      fsData.ulScore -= ulPenalty;
+    }
+
+    pNodes[node].fileData.maxDlScore = fsData.dlScore;
+    pNodes[node].fileData.maxUlScore = fsData.ulScore;
+    pNodes[node].fileData.avgDlScore = fsData.dlScore;
+    pNodes[node].fileData.avgUlScore = fsData.ulScore;
+    fixBranch(node);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Fix the branches above a single modified node. Unlike updateBranch, only
+  //! the branch of the modified node is moved at each level instead of
+  //! sorting all of them, which requires the rest of the tree to be up to date.
+  //----------------------------------------------------------------------------
+  inline void
+  fixBranch(tFastTreeIdx node)
+  {
+    while (pNodes[node].treeData.fatherIdx != node) {
+      const tFastTreeIdx father = pNodes[node].treeData.fatherIdx;
+      tFastTreeIdx matchBranchIdx = pNodes[father].treeData.firstBranchIdx;
+
+      while (pBranches[matchBranchIdx].sonIdx != node) {
+        matchBranchIdx++;
+      }
+
+      fixBranchSorting(father, matchBranchIdx);
+      aggregateFsData(father);
+      aggregateFileData(father);
+      node = father;
+    }
+  }
+
   inline void disableSubTree(const tFastTreeIdx& node)
   {
     // need to call update after calling this function
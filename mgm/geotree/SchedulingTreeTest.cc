@@ -161,6 +161,31 @@ void functionalTestFastTree(FastTree<T1, T2>* fptree, FastTree<T3, T4>* fatree,
                             GeoTag2NodeIdxMap* geomap,
                             SchedTreeBase::FastTreeInfo* treeinfo, size_t nMaxReplicas)
 {
+  // do verification of the placements reusing a single working copy
+  if (nMaxReplicas > 1) {
+    char buffer[bufferSize];
+    assert(fptree->copyToBuffer(buffer, bufferSize) == 0);
+    FastPlacementTree* ftree = (FastPlacementTree*) buffer;
+    vector<SchedTreeBase::tFastTreeIdx> existing, newReplicas;
+
+    for (size_t loop = 0; loop < 1000; loop++) {
+      // leave enough free slots for the existing replicas of the previous loop
+      size_t nreplica = 1 + rand() % (nMaxReplicas / 2);
+      assert(ftree->findFreeSlotsInPlace(newReplicas, nreplica, 0, 0, &existing));
+      assert(newReplicas.size() == nreplica);
+      // the new replicas are distinct and not on the existing ones
+      set<SchedTreeBase::tFastTreeIdx> repIdxs(newReplicas.begin(),
+          newReplicas.end());
+      assert(repIdxs.size() == nreplica);
+
+      for (auto it = existing.begin(); it != existing.end(); it++) {
+        assert(!repIdxs.count(*it));
+      }
+
+      existing.swap(newReplicas);
+    }
+  }
+
   // do verification regarding the placement, the access and the geolocation
   for (size_t loop = 0; loop < 1000; loop++) {
     // select a random number of replicas
@@ -948,6 +973,66 @@ int mainFull()
   cout << "speed        : " << 3 * schedGroups.size() * nbIter / (float (
          elapsed) / CLOCKS_PER_SEC)
        << " placements/sec " << endl;
+  cout << "cost         : " << 1e6 * (float (elapsed) / CLOCKS_PER_SEC) /
+       (3 * schedGroups.size() * nbIter) << " us/placement " << endl;
+  cout << "----------------------------" << endl << endl;
+  begin = clock();
+
+  // one working copy per file updated before the placement, as done by the
+  // GeoTreeEngine when some space is booked
+  for (size_t i = 0; i < schedGroups.size() * nbIter; i++) {
+    char buffer[bufferSize];
+    assert(fptrees[i % schedGroups.size()].copyToBuffer(buffer, bufferSize) == 0);
+    FastPlacementTree* ftree = (FastPlacementTree*) buffer;
+    SchedTreeBase::tFastTreeIdx repId;
+    ftree->updateTree();
+
+    for (int k = 0; k < 3; k++) {
+      ftree->findFreeSlot(repId, 0, true, true, false);
+    }
+  }
+
+  elapsed = clock() - begin;
+  cout << "REPLICA PLACEMENT WITH TREE UPDATE SPEED TEST" << endl;
+  cout << "elapsed time : " << float (elapsed) / CLOCKS_PER_SEC << " sec." <<
+       endl;
+  cout << "speed        : " << 3 * schedGroups.size() * nbIter / (float (
+         elapsed) / CLOCKS_PER_SEC)
+       << " placements/sec " << endl;
+  cout << "cost         : " << 1e6 * (float (elapsed) / CLOCKS_PER_SEC) /
+       (3 * schedGroups.size() * nbIter) << " us/placement " << endl;
+  cout << "----------------------------" << endl << endl;
+  begin = clock();
+
+  // one working copy per group reused for all the files, each file having
+  // the replicas of the previous one as existing replicas and the penalties
+  // of the placements being applied to the working copy
+  for (size_t g = 0; g < schedGroups.size(); g++) {
+    char buffer[bufferSize];
+    assert(fptrees[g].copyToBuffer(buffer, bufferSize) == 0);
+    FastPlacementTree* ftree = (FastPlacementTree*) buffer;
+    vector<SchedTreeBase::tFastTreeIdx> existing, newReplicas;
+
+    for (size_t i = 0; i < nbIter; i++) {
+      ftree->findFreeSlotsInPlace(newReplicas, 3, 0, 0, &existing);
+
+      for (auto it = newReplicas.begin(); it != newReplicas.end(); it++) {
+        ftree->bookFreeSlot(*it, 0, 1, 1);
+      }
+
+      existing.swap(newReplicas);
+    }
+  }
+
+  elapsed = clock() - begin;
+  cout << "BULK REPLICA PLACEMENT SPEED TEST" << endl;
+  cout << "elapsed time : " << float (elapsed) / CLOCKS_PER_SEC << " sec." <<
+       endl;
+  cout << "speed        : " << 3 * schedGroups.size() * nbIter / (float (
+         elapsed) / CLOCKS_PER_SEC)
+       << " placements/sec " << endl;
+  cout << "cost         : " << 1e6 * (float (elapsed) / CLOCKS_PER_SEC) /
+       (3 * schedGroups.size() * nbIter) << " us/placement " << endl;
   cout << "----------------------------" << endl << endl;
   begin = clock();
 
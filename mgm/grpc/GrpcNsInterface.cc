@@ -39,13 +39,17 @@
 #include "mgm/proc/user/TokenCmd.hh"
 #include "mgm/XrdMgmOfs.hh"
 #include "mgm/XrdMgmOfsDirectory.hh"
+#include "mgm/PolicyIndex.hh"
 #include "mgm/Recycle.hh"
 #include "namespace/Prefetcher.hh"
 #include "namespace/MDException.hh"
 #include "namespace/interface/ContainerIterators.hh"
 #include "namespace/utils/Etag.hh"
+#include <folly/executors/InlineExecutor.h>
 
 #include <regex.h>
+#include <mutex>
+#include <set>
 /*----------------------------------------------------------------------------*/
 
 
@@ -53,6 +57,131 @@ EOSMGMNAMESPACE_BEGIN
 
 #ifdef EOS_GRPC
 
+namespace
+{
+//------------------------------------------------------------------------------
+//! Ids of the entries currently inserted through FileInsert/ContainerInsert.
+//! The existence of an id is first looked up before taking the namespace
+//! write lock, the reservation makes sure that no concurrent request inserts
+//! the same id in the meantime. The lookup is repeated under the write lock
+//! since other writers don't go through the reservations.
+//------------------------------------------------------------------------------
+class InsertReservations
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Ids reserved by a single request, released once it is destroyed however
+  //! the request finishes
+  //----------------------------------------------------------------------------
+  class Guard
+  {
+  public:
+    Guard(InsertReservations& reservations):
+      mReservations(reservations)
+    {}
+
+    ~Guard()
+    {
+      std::lock_guard<std::mutex> lock(mReservations.mMutex);
+
+      for (const auto id : mIds) {
+        mReservations.mIds.erase(id);
+      }
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+    //--------------------------------------------------------------------------
+    //! Reserve id, an id appearing several times in the request is reserved
+    //! only once
+    //!
+    //! @return true if reserved by this request, false if by another one
+    //--------------------------------------------------------------------------
+    bool Reserve(uint64_t id)
+    {
+      if (mIds.count(id)) {
+        return true;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mReservations.mMutex);
+
+        if (!mReservations.mIds.insert(id).second) {
+          return false;
+        }
+      }
+
+      mIds.insert(id);
+      return true;
+    }
+
+  private:
+    InsertReservations& mReservations;
+    std::set<uint64_t> mIds;
+  };
+
+private:
+  std::mutex mMutex;
+  std::set<uint64_t> mIds;
+};
+
+InsertReservations sFileReservations;
+InsertReservations sContainerReservations;
+
+//------------------------------------------------------------------------------
+// Start loading the parent container of the given path, errors are ignored
+// as they are reported by the insertion itself
+//------------------------------------------------------------------------------
+void
+StageParent(const std::string& path, std::set<std::string>& staged,
+            std::vector<folly::Future<int>>& lookups)
+{
+  if (gOFS->eosView->inMemory()) {
+    return;
+  }
+
+  eos::common::Path cPath(path);
+  std::string parent = cPath.GetParentPath();
+
+  if (!staged.insert(parent).second) {
+    return;
+  }
+
+  try {
+    lookups.emplace_back(gOFS->eosView->getContainerFut(parent, true)
+    .thenTry([](folly::Try<eos::IContainerMDPtr>&&) {
+      return 0;
+    }));
+  } catch (const eos::MDException& e) {
+    // ignore
+  }
+}
+
+//------------------------------------------------------------------------------
+// Collect the lookup results, the first num ones are the conflict checks of
+// the request entries and the rest are parent prefetches
+//------------------------------------------------------------------------------
+folly::Future<GrpcNsInterface::InsertConflicts>
+CollectConflicts(std::vector<folly::Future<int>>&& lookups, size_t num,
+                 std::shared_ptr<InsertReservations::Guard> reservation,
+                 folly::Executor* executor)
+{
+  return folly::collectAll(lookups.begin(), lookups.end()).via(executor)
+  .thenValue([num, reservation](std::vector<folly::Try<int>>&& res) {
+    GrpcNsInterface::InsertConflicts conflicts;
+    conflicts.mReservation = reservation;
+    conflicts.mCodes.reserve(num);
+
+    for (size_t i = 0; i < num; ++i) {
+      conflicts.mCodes.push_back(res[i].hasValue() ? res[i].value() : 0);
+    }
+
+    return conflicts;
+  });
+}
+}
+
 bool
 GrpcNsInterface::Filter(std::shared_ptr<eos::IFileMD> md,
                         const eos::rpc::MDSelection& filter)
@@ -1005,6 +1134,53 @@ grpc::Status
 GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
                             eos::rpc::InsertReply* reply,
                             const eos::rpc::FileInsertRequest* request)
+{
+  InsertConflicts conflicts = PrefetchFileInsert(vid, request,
+                              &folly::InlineExecutor::instance()).get();
+  return FileInsert(vid, reply, request, conflicts);
+}
+
+folly::Future<GrpcNsInterface::InsertConflicts>
+GrpcNsInterface::PrefetchFileInsert(eos::common::VirtualIdentity& vid,
+                                    const eos::rpc::FileInsertRequest* request,
+                                    folly::Executor* executor)
+{
+  if (!vid.sudoer) {
+    return folly::makeFuture(InsertConflicts());
+  }
+
+  std::vector<folly::Future<int>> lookups;
+  std::set<std::string> parents;
+  auto reservation = std::make_shared<InsertReservations::Guard>(sFileReservations);
+
+  for (const auto& it : request->files()) {
+    if (it.id() <= 0) {
+      lookups.emplace_back(folly::makeFuture<int>(0));
+    } else if (!reservation->Reserve(it.id())) {
+      lookups.emplace_back(folly::makeFuture<int>(EBUSY));
+    } else {
+      const uint64_t id = it.id();
+      lookups.emplace_back(folly::makeFutureWith([id]() {
+        return gOFS->eosFileService->getFileMDFut(id);
+      }).thenTry([](folly::Try<eos::IFileMDPtr>&& fmd) {
+        return (fmd.hasValue() && fmd.value()) ? EEXIST : 0;
+      }));
+    }
+  }
+
+  for (const auto& it : request->files()) {
+    StageParent(it.path(), parents, lookups);
+  }
+
+  return CollectConflicts(std::move(lookups), request->files_size(),
+                          reservation, executor);
+}
+
+grpc::Status
+GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
+                            eos::rpc::InsertReply* reply,
+                            const eos::rpc::FileInsertRequest* request,
+                            const InsertConflicts& conflicts)
 {
   if (!vid.sudoer) {
     // block every one who is not a sudoer
@@ -1016,31 +1192,45 @@ GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
   std::shared_ptr<eos::IFileMD> newfile;
   eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__,
                                      __FILE__);
-  std::vector<folly::Future<eos::IFileMDPtr>> conflicts;
+  // The conflicts looked up before only warmed up the cache, check again under
+  // the write lock as the ids might have been taken by another writer since
+  std::vector<folly::Future<eos::IFileMDPtr>> rechecks;
 
-  for (auto it : request->files()) {
-    if (it.id() <= 0) {
-      conflicts.emplace_back(eos::IFileMDPtr(
-                               nullptr)); // folly::makeFuture<eos::IFileMDPtr>(eos::IFileMDPtr(nullptr)));
+  for (const auto& it : request->files()) {
+    if ((it.id() <= 0) || conflicts.mCodes[rechecks.size()]) {
+      rechecks.emplace_back(eos::IFileMDPtr(nullptr));
     } else {
-      conflicts.emplace_back(gOFS->eosFileService->getFileMDFut(it.id()));
+      rechecks.emplace_back(gOFS->eosFileService->getFileMDFut(it.id()));
     }
   }
 
   int counter = -1;
+  std::set<uint64_t> inserted;
 
   for (auto it : request->files()) {
     counter++;
-    conflicts[counter].wait();
 
-    if (!conflicts[counter].hasException() &&
-        std::move(conflicts[counter]).get() != nullptr) {
+    int conflict = conflicts.mCodes[counter];
+
+    if (conflict == 0) {
+      rechecks[counter].wait();
+
+      if ((!rechecks[counter].hasException() &&
+           std::move(rechecks[counter]).get() != nullptr) ||
+          inserted.count(it.id())) {
+        // Created by another writer or an earlier entry of the same request
+        conflict = EEXIST;
+      }
+    }
+
+    if (conflict) {
       std::ostringstream ss;
       ss << "Attempted to create file with id=" << it.id() <<
-         ", which already exists";
+         ((conflict == EBUSY) ? ", which is being inserted concurrently" :
+          ", which already exists");
       eos_static_err("%s", ss.str().c_str());
       reply->add_message(ss.str());
-      reply->add_retc(EINVAL);
+      reply->add_retc((conflict == EBUSY) ? EBUSY : EINVAL);
       continue;
     }
 
@@ -1090,6 +1280,10 @@ GrpcNsInterface::FileInsert(eos::common::VirtualIdentity& vid,
         throw;
       }
 
+      if (it.id() > 0) {
+        inserted.insert(it.id());
+      }
+
       reply->add_message("");
       reply->add_retc(0);
     } catch (eos::MDException& e) {
@@ -1109,6 +1303,53 @@ grpc::Status
 GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
                                  eos::rpc::InsertReply* reply,
                                  const eos::rpc::ContainerInsertRequest* request)
+{
+  InsertConflicts conflicts = PrefetchContainerInsert(vid, request,
+                              &folly::InlineExecutor::instance()).get();
+  return ContainerInsert(vid, reply, request, conflicts);
+}
+
+folly::Future<GrpcNsInterface::InsertConflicts>
+GrpcNsInterface::PrefetchContainerInsert(eos::common::VirtualIdentity& vid,
+    const eos::rpc::ContainerInsertRequest* request,
+    folly::Executor* executor)
+{
+  if (!vid.sudoer) {
+    return folly::makeFuture(InsertConflicts());
+  }
+
+  std::vector<folly::Future<int>> lookups;
+  std::set<std::string> parents;
+  auto reservation = std::make_shared<InsertReservations::Guard>(sContainerReservations);
+
+  for (const auto& it : request->container()) {
+    if (it.id() <= 0) {
+      lookups.emplace_back(folly::makeFuture<int>(0));
+    } else if (!reservation->Reserve(it.id())) {
+      lookups.emplace_back(folly::makeFuture<int>(EBUSY));
+    } else {
+      const uint64_t id = it.id();
+      lookups.emplace_back(folly::makeFutureWith([id]() {
+        return gOFS->eosDirectoryService->getContainerMDFut(id);
+      }).thenTry([](folly::Try<eos::IContainerMDPtr>&& cmd) {
+        return (cmd.hasValue() && cmd.value()) ? EEXIST : 0;
+      }));
+    }
+  }
+
+  for (const auto& it : request->container()) {
+    StageParent(it.path(), parents, lookups);
+  }
+
+  return CollectConflicts(std::move(lookups), request->container_size(),
+                          reservation, executor);
+}
+
+grpc::Status
+GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
+                                 eos::rpc::InsertReply* reply,
+                                 const eos::rpc::ContainerInsertRequest* request,
+                                 const InsertConflicts& conflicts)
 {
   if (!vid.sudoer) {
     // block every one who is not a sudoer
@@ -1120,31 +1361,46 @@ GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
   std::shared_ptr<eos::IContainerMD> newdir;
   eos::common::RWMutexWriteLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__,
                                      __FILE__);
-  std::vector<folly::Future<eos::IContainerMDPtr>> conflicts;
+  // The conflicts looked up before only warmed up the cache, check again under
+  // the write lock as the ids might have been taken by another writer since
+  std::vector<folly::Future<eos::IContainerMDPtr>> rechecks;
 
-  for (auto it : request->container()) {
-    if (it.id() <= 0) {
-      conflicts.emplace_back(eos::IContainerMDPtr(nullptr));
+  for (const auto& it : request->container()) {
+    if ((it.id() <= 0) || conflicts.mCodes[rechecks.size()]) {
+      rechecks.emplace_back(eos::IContainerMDPtr(nullptr));
     } else {
-      conflicts.emplace_back(gOFS->eosDirectoryService->getContainerMDFut(it.id()));
+      rechecks.emplace_back(gOFS->eosDirectoryService->getContainerMDFut(it.id()));
     }
   }
 
   int counter = -1;
+  std::set<uint64_t> inserted;
   bool inherit = request->inherit_md();
 
   for (auto it : request->container()) {
     counter++;
-    conflicts[counter].wait();
 
-    if (!conflicts[counter].hasException() &&
-        std::move(conflicts[counter]).get() != nullptr) {
+    int conflict = conflicts.mCodes[counter];
+
+    if (conflict == 0) {
+      rechecks[counter].wait();
+
+      if ((!rechecks[counter].hasException() &&
+           std::move(rechecks[counter]).get() != nullptr) ||
+          inserted.count(it.id())) {
+        // Created by another writer or an earlier entry of the same request
+        conflict = EEXIST;
+      }
+    }
+
+    if (conflict) {
       std::ostringstream ss;
       ss << "Attempted to create container with id=" << it.id() <<
-         ", which already exists";
+         ((conflict == EBUSY) ? ", which is being inserted concurrently" :
+          ", which already exists");
       eos_static_err("%s", ss.str().c_str());
       reply->add_message(ss.str());
-      reply->add_retc(EINVAL);
+      reply->add_retc((conflict == EBUSY) ? EBUSY : EINVAL);
       continue;
     }
 
@@ -1216,6 +1472,8 @@ GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
 
       try {
         gOFS->eosView->updateContainerStore(newdir.get());
+        // Inherited or explicitly given policy attributes need indexing
+        PolicyIndex::Add(newdir.get());
 
         if (parent) {
           parent->setMTime(ctime);
@@ -1230,6 +1488,10 @@ GrpcNsInterface::ContainerInsert(eos::common::VirtualIdentity& vid,
         throw;
       }
 
+      if (it.id() > 0) {
+        inserted.insert(it.id());
+      }
+
       reply->add_message("");
       reply->add_retc(0);
     } catch (eos::MDException& e) {
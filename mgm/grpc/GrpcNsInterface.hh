@@ -32,6 +32,7 @@
 #include "GrpcServer.hh"
 #include "proto/Rpc.grpc.pb.h"
 #include <grpc++/grpc++.h>
+#include <folly/futures/Future.h>
 
 /*----------------------------------------------------------------------------*/
 
@@ -75,14 +76,48 @@ public:
                              eos::rpc::NsStatResponse* reply,
                              const eos::rpc::NsStatRequest* request);
 
+  //! Result of the conflict lookup of an insert request
+  struct InsertConflicts {
+    //! For each entry of the request: 0 if the id is free, EEXIST if it
+    //! exists already, EBUSY if it is being inserted by a concurrent request
+    std::vector<int> mCodes;
+    //! Ids reserved for the request, released once the last copy is gone
+    std::shared_ptr<void> mReservation;
+  };
+
   static grpc::Status FileInsert(eos::common::VirtualIdentity& vid,
                                  eos::rpc::InsertReply* reply,
                                  const eos::rpc::FileInsertRequest* request);
 
+  //! Look up the conflicts and parents of a FileInsert request without holding
+  //! the namespace lock. The returned conflicts must be passed to FileInsert,
+  //! which looks up the free ids again under the write lock. The ids reserved
+  //! here are released once the conflicts are destroyed.
+  static folly::Future<InsertConflicts>
+  PrefetchFileInsert(eos::common::VirtualIdentity& vid,
+                     const eos::rpc::FileInsertRequest* request,
+                     folly::Executor* executor);
+
+  static grpc::Status FileInsert(eos::common::VirtualIdentity& vid,
+                                 eos::rpc::InsertReply* reply,
+                                 const eos::rpc::FileInsertRequest* request,
+                                 const InsertConflicts& conflicts);
+
   static grpc::Status ContainerInsert(eos::common::VirtualIdentity& vid,
                                       eos::rpc::InsertReply* reply,
                                       const eos::rpc::ContainerInsertRequest* request);
 
+  //! Same as PrefetchFileInsert for a ContainerInsert request
+  static folly::Future<InsertConflicts>
+  PrefetchContainerInsert(eos::common::VirtualIdentity& vid,
+                          const eos::rpc::ContainerInsertRequest* request,
+                          folly::Executor* executor);
+
+  static grpc::Status ContainerInsert(eos::common::VirtualIdentity& vid,
+                                      eos::rpc::InsertReply* reply,
+                                      const eos::rpc::ContainerInsertRequest* request,
+                                      const InsertConflicts& conflicts);
+
   static grpc::Status Exec(eos::common::VirtualIdentity& vid,
 			    eos::rpc::NSResponse* reply,
 			    const eos::rpc::NSRequest* request);
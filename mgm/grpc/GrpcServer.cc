@@ -30,15 +30,20 @@
 #include "common/StringConversion.hh"
 #include "mgm/Macros.hh"
 #include "XrdSec/XrdSecEntity.hh"
+#include <folly/executors/CPUThreadPoolExecutor.h>
 
 #ifdef EOS_GRPC
 #include "proto/Rpc.grpc.pb.h"
 #include <grpc++/security/credentials.h>
+#include <algorithm>
+#include <functional>
 
 using grpc::Server;
 using grpc::ServerBuilder;
 using grpc::ServerContext;
 using grpc::ServerWriter;
+using grpc::ServerAsyncResponseWriter;
+using grpc::ServerCompletionQueue;
 using grpc::Status;
 using eos::rpc::Eos;
 using eos::rpc::PingRequest;
@@ -55,48 +60,12 @@ EOSMGMNAMESPACE_BEGIN
 
 #ifdef EOS_GRPC
 
-class RequestServiceImpl final : public Eos::Service
+//------------------------------------------------------------------------------
+//! Synchronous part of the service: the streaming calls and the rarely used
+//! ones, each of them occupies a gRPC thread until it completes
+//------------------------------------------------------------------------------
+class RequestServiceImpl : public Eos::Service
 {
-
-  Status Ping(ServerContext* context, const eos::rpc::PingRequest* request,
-              eos::rpc::PingReply* reply) override
-  {
-    eos_static_info("grpc::ping from client peer=%s ip=%s DN=%s token=%s len=%lu",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str(),
-                    request->message().length());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    reply->set_message(request->message());
-    return Status::OK;
-  }
-
-  Status FileInsert(ServerContext* context,
-                    const eos::rpc::FileInsertRequest* request,
-                    eos::rpc::InsertReply* reply) override
-  {
-    eos_static_info("grpc::fileinsert from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::FileInsert(vid, reply, request);
-  }
-
-  Status ContainerInsert(ServerContext* context,
-                         const eos::rpc::ContainerInsertRequest* request,
-                         eos::rpc::InsertReply* reply) override
-  {
-    eos_static_info("grpc::containerinsert from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::ContainerInsert(vid, reply, request);
-  }
-
   Status MD(ServerContext* context, const eos::rpc::MDRequest* request,
             ServerWriter<eos::rpc::MDResponse>* writer) override
   {
@@ -137,19 +106,6 @@ class RequestServiceImpl final : public Eos::Service
     return GrpcNsInterface::Find(vid, writer, request);
   }
 
-  Status NsStat(ServerContext* context,
-                const eos::rpc::NsStatRequest* request,
-                eos::rpc::NsStatResponse* reply) override
-  {
-    eos_static_info("grpc::nsstat::request from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::NsStat(vid, reply, request);
-  }
-
   Status ManilaServerRequest(ServerContext* context,
                              const eos::rpc::ManilaRequest* request,
                              eos::rpc::ManilaResponse* reply) override
@@ -174,21 +130,255 @@ class RequestServiceImpl final : public Eos::Service
     eos_static_notice("\nreply:\n%s", jsonstring.c_str());
     return st;
   }
+};
+
+//------------------------------------------------------------------------------
+//! Service with the unary namespace calls handled asynchronously through the
+//! completion queue, the rest is served by RequestServiceImpl
+//------------------------------------------------------------------------------
+using AsyncRequestService =
+  Eos::WithAsyncMethod_Ping<
+  Eos::WithAsyncMethod_FileInsert<
+  Eos::WithAsyncMethod_ContainerInsert<
+  Eos::WithAsyncMethod_NsStat<
+  Eos::WithAsyncMethod_Exec<RequestServiceImpl>>>>>;
+
+//------------------------------------------------------------------------------
+//! Base class of the calls handled through the completion queue, the address
+//! of the object is used as tag
+//------------------------------------------------------------------------------
+class AsyncCall
+{
+public:
+  virtual ~AsyncCall() = default;
+
+  //----------------------------------------------------------------------------
+  //! Handle completion queue event
+  //!
+  //! @param ok status of the completed operation
+  //----------------------------------------------------------------------------
+  virtual void Proceed(bool ok) = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Unary call - waits for a request, passes it to the handler and sends the
+//! reply once the handler calls Finish, possibly from a different thread. For
+//! every accepted request a new call is queued so that the server keeps
+//! accepting requests while the current one is processed.
+//------------------------------------------------------------------------------
+template<typename Request, typename Reply>
+class AsyncUnaryCall: public AsyncCall
+{
+public:
+  using Requester = std::function<void(ServerContext*, Request*,
+                                       ServerAsyncResponseWriter<Reply>*,
+                                       ServerCompletionQueue*, void*)>;
+  using Handler = std::function<void(AsyncUnaryCall*)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor - starts waiting for a request
+  //!
+  //! @param cq completion queue
+  //! @param requester function registering the call with the service
+  //! @param handler function processing the request, it must call Finish
+  //----------------------------------------------------------------------------
+  AsyncUnaryCall(ServerCompletionQueue* cq, Requester requester,
+                 Handler handler):
+    mCq(cq), mRequester(std::move(requester)), mHandler(std::move(handler)),
+    mResponder(&mContext)
+  {
+    mRequester(&mContext, &mRequest, &mResponder, mCq, this);
+  }
 
-  Status Exec(ServerContext* context,
-              const eos::rpc::NSRequest* request,
-              eos::rpc::NSResponse* reply) override
+  void Proceed(bool ok) override
   {
-    eos_static_info("grpc::exec::request from client peer=%s ip=%s DN=%s token=%s",
-                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
-                    GrpcServer::DN(context).c_str(), request->authkey().c_str());
-    eos::common::VirtualIdentity vid;
-    GrpcServer::Vid(context, vid, request->authkey());
-    WAIT_BOOT;
-    return GrpcNsInterface::Exec(vid, reply, request);
+    if (mFinished || !ok) {
+      // Reply sent or server shutting down
+      delete this;
+      return;
+    }
+
+    new AsyncUnaryCall(mCq, mRequester, mHandler);
+    mHandler(this);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Send the reply, the object is deleted once this completes
+  //----------------------------------------------------------------------------
+  void Finish(const Status& status)
+  {
+    mFinished = true;
+    mResponder.Finish(mReply, status, this);
   }
+
+  ServerContext* GetContext()
+  {
+    return &mContext;
+  }
+
+  const Request* GetRequest() const
+  {
+    return &mRequest;
+  }
+
+  Reply* GetReply()
+  {
+    return &mReply;
+  }
+
+private:
+  ServerCompletionQueue* mCq;
+  Requester mRequester;
+  Handler mHandler;
+  ServerContext mContext;
+  Request mRequest;
+  Reply mReply;
+  ServerAsyncResponseWriter<Reply> mResponder;
+  bool mFinished {false};
 };
 
+//------------------------------------------------------------------------------
+// Run a blocking handler on the executor and send its reply
+//------------------------------------------------------------------------------
+template<typename Request, typename Reply>
+void
+RunOnExecutor(folly::Executor* executor, AsyncUnaryCall<Request, Reply>* call,
+              std::function<Status(eos::common::VirtualIdentity&,
+                                   AsyncUnaryCall<Request, Reply>*)> handler)
+{
+  executor->add([call, handler]() {
+    try {
+      eos::common::VirtualIdentity vid;
+      GrpcServer::Vid(call->GetContext(), vid, call->GetRequest()->authkey());
+      WAIT_BOOT;
+      call->Finish(handler(vid, call));
+    } catch (const std::exception& e) {
+      eos_static_err("msg=\"exception in grpc handler\" emsg=\"%s\"", e.what());
+      call->Finish(Status(grpc::StatusCode::INTERNAL, e.what()));
+    }
+  });
+}
+
+//------------------------------------------------------------------------------
+// Queue the first call of every asynchronous method
+//------------------------------------------------------------------------------
+void
+RequestAsyncCalls(AsyncRequestService* service, ServerCompletionQueue* cq,
+                  folly::Executor* executor)
+{
+  using PingCall = AsyncUnaryCall<PingRequest, PingReply>;
+  using FileInsertCall = AsyncUnaryCall<FileInsertRequest, InsertReply>;
+  using ContainerInsertCall = AsyncUnaryCall<ContainerInsertRequest, InsertReply>;
+  using NsStatCall = AsyncUnaryCall<eos::rpc::NsStatRequest,
+        eos::rpc::NsStatResponse>;
+  using ExecCall = AsyncUnaryCall<eos::rpc::NSRequest, eos::rpc::NSResponse>;
+  // Ping does not touch the namespace, reply directly from the polling thread
+  new PingCall(cq, [service](ServerContext * ctx, PingRequest * req,
+                             ServerAsyncResponseWriter<PingReply>* resp,
+  ServerCompletionQueue * queue, void* tag) {
+    service->RequestPing(ctx, req, resp, queue, queue, tag);
+  }, [](PingCall * call) {
+    ServerContext* context = call->GetContext();
+    const PingRequest* request = call->GetRequest();
+    eos_static_info("grpc::ping from client peer=%s ip=%s DN=%s token=%s len=%lu",
+                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                    GrpcServer::DN(context).c_str(), request->authkey().c_str(),
+                    request->message().length());
+    call->GetReply()->set_message(request->message());
+    call->Finish(Status::OK);
+  });
+  // Inserts look up their conflicts asynchronously and only occupy an
+  // executor thread while holding the namespace write lock
+  new FileInsertCall(cq, [service](ServerContext * ctx, FileInsertRequest * req,
+                                   ServerAsyncResponseWriter<InsertReply>* resp,
+  ServerCompletionQueue * queue, void* tag) {
+    service->RequestFileInsert(ctx, req, resp, queue, queue, tag);
+  }, [executor](FileInsertCall * call) {
+    ServerContext* context = call->GetContext();
+    eos_static_info("grpc::fileinsert from client peer=%s ip=%s DN=%s token=%s",
+                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                    GrpcServer::DN(context).c_str(),
+                    call->GetRequest()->authkey().c_str());
+    auto vid = std::make_shared<eos::common::VirtualIdentity>();
+    folly::via(executor, [call, vid, executor]() {
+      GrpcServer::Vid(call->GetContext(), *vid, call->GetRequest()->authkey());
+      WAIT_BOOT;
+      return GrpcNsInterface::PrefetchFileInsert(*vid, call->GetRequest(),
+             executor);
+    })
+    .thenTry([call, vid](folly::Try<GrpcNsInterface::InsertConflicts>&& res) {
+      if (res.hasException()) {
+        call->Finish(Status(grpc::StatusCode::INTERNAL,
+                            res.exception().what().toStdString()));
+        return;
+      }
+
+      call->Finish(GrpcNsInterface::FileInsert(*vid, call->GetReply(),
+                   call->GetRequest(), res.value()));
+    });
+  });
+  new ContainerInsertCall(cq, [service](ServerContext * ctx,
+                                        ContainerInsertRequest * req,
+                                        ServerAsyncResponseWriter<InsertReply>* resp,
+  ServerCompletionQueue * queue, void* tag) {
+    service->RequestContainerInsert(ctx, req, resp, queue, queue, tag);
+  }, [executor](ContainerInsertCall * call) {
+    ServerContext* context = call->GetContext();
+    eos_static_info("grpc::containerinsert from client peer=%s ip=%s DN=%s token=%s",
+                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                    GrpcServer::DN(context).c_str(),
+                    call->GetRequest()->authkey().c_str());
+    auto vid = std::make_shared<eos::common::VirtualIdentity>();
+    folly::via(executor, [call, vid, executor]() {
+      GrpcServer::Vid(call->GetContext(), *vid, call->GetRequest()->authkey());
+      WAIT_BOOT;
+      return GrpcNsInterface::PrefetchContainerInsert(*vid, call->GetRequest(),
+             executor);
+    })
+    .thenTry([call, vid](folly::Try<GrpcNsInterface::InsertConflicts>&& res) {
+      if (res.hasException()) {
+        call->Finish(Status(grpc::StatusCode::INTERNAL,
+                            res.exception().what().toStdString()));
+        return;
+      }
+
+      call->Finish(GrpcNsInterface::ContainerInsert(*vid, call->GetReply(),
+                   call->GetRequest(), res.value()));
+    });
+  });
+  new NsStatCall(cq, [service](ServerContext * ctx,
+                               eos::rpc::NsStatRequest * req,
+                               ServerAsyncResponseWriter<eos::rpc::NsStatResponse>* resp,
+  ServerCompletionQueue * queue, void* tag) {
+    service->RequestNsStat(ctx, req, resp, queue, queue, tag);
+  }, [executor](NsStatCall * call) {
+    ServerContext* context = call->GetContext();
+    eos_static_info("grpc::nsstat::request from client peer=%s ip=%s DN=%s token=%s",
+                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                    GrpcServer::DN(context).c_str(),
+                    call->GetRequest()->authkey().c_str());
+    RunOnExecutor<eos::rpc::NsStatRequest, eos::rpc::NsStatResponse>
+    (executor, call, [](eos::common::VirtualIdentity & vid, NsStatCall * c) {
+      return GrpcNsInterface::NsStat(vid, c->GetReply(), c->GetRequest());
+    });
+  });
+  new ExecCall(cq, [service](ServerContext * ctx, eos::rpc::NSRequest * req,
+                             ServerAsyncResponseWriter<eos::rpc::NSResponse>* resp,
+  ServerCompletionQueue * queue, void* tag) {
+    service->RequestExec(ctx, req, resp, queue, queue, tag);
+  }, [executor](ExecCall * call) {
+    ServerContext* context = call->GetContext();
+    eos_static_info("grpc::exec::request from client peer=%s ip=%s DN=%s token=%s",
+                    context->peer().c_str(), GrpcServer::IP(context).c_str(),
+                    GrpcServer::DN(context).c_str(),
+                    call->GetRequest()->authkey().c_str());
+    RunOnExecutor<eos::rpc::NSRequest, eos::rpc::NSResponse>
+    (executor, call, [](eos::common::VirtualIdentity & vid, ExecCall * c) {
+      return GrpcNsInterface::Exec(vid, c->GetReply(), c->GetRequest());
+    });
+  });
+}
+
 /* return client DN*/
 std::string
 GrpcServer::DN(grpc::ServerContext* context)
@@ -291,6 +481,31 @@ GrpcServer::Vid(grpc::ServerContext* context,
 
 #endif
 
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+GrpcServer::~GrpcServer()
+{
+#ifdef EOS_GRPC
+
+  if (mServer) {
+    mServer->Shutdown();
+  }
+
+  // Handlers still running must send their reply before the completion
+  // queue goes away
+  if (mExecutor) {
+    mExecutor->join();
+  }
+
+  if (mCompletionQueue) {
+    mCompletionQueue->Shutdown();
+  }
+
+#endif
+  mThread.join();
+}
+
 void
 GrpcServer::Run(ThreadAssistant& assistant) noexcept
 {
@@ -324,7 +539,14 @@ GrpcServer::Run(ThreadAssistant& assistant) noexcept
     }
   }
 
-  RequestServiceImpl service;
+  unsigned int nthreads = sDefaultAsyncThreads;
+
+  if (getenv("EOS_MGM_GRPC_ASYNC_THREADS")) {
+    nthreads = std::max(1, atoi(getenv("EOS_MGM_GRPC_ASYNC_THREADS")));
+  }
+
+  mExecutor.reset(new folly::CPUThreadPoolExecutor(nthreads));
+  AsyncRequestService service;
   std::string bind_address = "0.0.0.0:";
   bind_address += std::to_string(mPort);
   grpc::ServerBuilder builder;
@@ -344,8 +566,23 @@ GrpcServer::Run(ThreadAssistant& assistant) noexcept
   }
 
   builder.RegisterService(&service);
+  mCompletionQueue = builder.AddCompletionQueue();
   mServer = builder.BuildAndStart();
-  mServer->Wait();
+
+  if (!mServer) {
+    eos_static_crit("msg=\"failed to start grpc server\" address=%s",
+                    bind_address.c_str());
+    return;
+  }
+
+  RequestAsyncCalls(&service, mCompletionQueue.get(), mExecutor.get());
+  // Dispatch the completion queue events until shutdown
+  void* tag;
+  bool ok;
+
+  while (mCompletionQueue->Next(&tag, &ok)) {
+    static_cast<AsyncCall*>(tag)->Proceed(ok);
+  }
 #else
   // Make the compiler happy
   (void) mPort;
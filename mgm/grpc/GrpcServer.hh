@@ -29,6 +29,11 @@
 #include <grpc++/grpc++.h>
 #endif
 
+namespace folly
+{
+class CPUThreadPoolExecutor;
+}
+
 EOSMGMNAMESPACE_BEGIN
 
 /**
@@ -51,22 +56,23 @@ private:
 
 #ifdef EOS_GRPC
   std::unique_ptr<grpc::Server> mServer;
+  //! Queue of the asynchronously handled calls
+  std::unique_ptr<grpc::ServerCompletionQueue> mCompletionQueue;
 #endif
+  //! Executor running the asynchronously handled calls
+  std::unique_ptr<folly::CPUThreadPoolExecutor> mExecutor;
   AssistedThread mThread; ///< Thread running GRPC service
 
 public:
+  //! Default number of threads handling the asynchronous calls, can be
+  //! changed with EOS_MGM_GRPC_ASYNC_THREADS
+  static constexpr unsigned int sDefaultAsyncThreads = 16;
 
   /* Default Constructor - enabling port 50051 by default
    */
   GrpcServer(int port = 50051) : mPort(port), mSSL(false) { }
 
-  virtual ~GrpcServer()
-  {
-#ifdef EOS_GRPC
-    mServer->Shutdown();
-#endif
-    mThread.join();
-  }
+  virtual ~GrpcServer();
 
   /* Run function */
   void Run(ThreadAssistant& assistant) noexcept;
@@ -0,0 +1,221 @@
+//------------------------------------------------------------------------------
+//! @file XmlBuffer.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <cstring>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class XmlBuffer - appends XML elements directly to a string buffer, used
+//! for large HTTP listings instead of building a document tree first. Element
+//! values are escaped the same way as by the rapidxml printer and elements
+//! without a value are written as <name/>.
+//------------------------------------------------------------------------------
+class XmlBuffer
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param reserve number of bytes to preallocate
+  //----------------------------------------------------------------------------
+  XmlBuffer(size_t reserve = 0)
+  {
+    mData.reserve(reserve);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Preallocate the given number of bytes
+  //----------------------------------------------------------------------------
+  inline void Reserve(size_t size)
+  {
+    mData.reserve(size);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append raw data, must already be valid XML
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Raw(const char* data)
+  {
+    mData += data;
+    return *this;
+  }
+
+  inline XmlBuffer& Raw(const std::string& data)
+  {
+    mData += data;
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append opening tag <name>
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Open(const char* name)
+  {
+    mData += '<';
+    mData += name;
+    mData += '>';
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append closing tag </name>
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Close(const char* name)
+  {
+    mData += "</";
+    mData += name;
+    mData += '>';
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append element without value <name/>
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Empty(const char* name)
+  {
+    mData += '<';
+    mData += name;
+    mData += "/>";
+    return *this;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append element with the given escaped value, <name/> if empty
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Element(const char* name, const char* value, size_t len)
+  {
+    if (len == 0) {
+      return Empty(name);
+    }
+
+    Open(name);
+    Escape(value, len);
+    return Close(name);
+  }
+
+  inline XmlBuffer& Element(const char* name, const std::string& value)
+  {
+    return Element(name, value.c_str(), value.length());
+  }
+
+  inline XmlBuffer& Element(const char* name, const char* value)
+  {
+    return Element(name, value, strlen(value));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Append escaped text
+  //----------------------------------------------------------------------------
+  inline XmlBuffer& Escape(const char* data, size_t len)
+  {
+    const char* end = data + len;
+
+    while (data != end) {
+      // Copy the longest run which does not need escaping at once
+      const char* run = data;
+
+      while ((run != end) && (*run != '<') && (*run != '>') && (*run != '&') &&
+             (*run != '"') && (*run != '\'')) {
+        ++run;
+      }
+
+      mData.append(data, run - data);
+
+      if (run == end) {
+        break;
+      }
+
+      switch (*run) {
+      case '<':
+        mData += "&lt;";
+        break;
+
+      case '>':
+        mData += "&gt;";
+        break;
+
+      case '&':
+        mData += "&amp;";
+        break;
+
+      case '"':
+        mData += "&quot;";
+        break;
+
+      default:
+        mData += "&apos;";
+      }
+
+      data = run + 1;
+    }
+
+    return *this;
+  }
+
+  inline XmlBuffer& Escape(const std::string& data)
+  {
+    return Escape(data.c_str(), data.length());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get current size of the buffer
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mData.size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop everything appended after the given size
+  //----------------------------------------------------------------------------
+  inline void Truncate(size_t size)
+  {
+    if (size < mData.size()) {
+      mData.resize(size);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get the buffer
+  //----------------------------------------------------------------------------
+  inline const std::string& GetString() const
+  {
+    return mData;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move out the buffer
+  //----------------------------------------------------------------------------
+  inline std::string Take()
+  {
+    return std::move(mData);
+  }
+
+private:
+  std::string mData;
+};
+
+EOSMGMNAMESPACE_END
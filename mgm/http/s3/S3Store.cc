@@ -24,8 +24,8 @@
 #include "mgm/http/HttpServer.hh"
 #include "mgm/http/s3/S3Store.hh"
 #include "mgm/http/s3/S3Handler.hh"
+#include "mgm/http/XmlBuffer.hh"
 #include "mgm/XrdMgmOfs.hh"
-#include "mgm/XrdMgmOfsDirectory.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/utils/Checksum.hh"
 #include "common/http/PlainHttpResponse.hh"
@@ -33,6 +33,7 @@
 #include "common/LayoutId.hh"
 #include "common/FileId.hh"
 #include "common/Timing.hh"
+#include <algorithm>
 
 EOSMGMNAMESPACE_BEGIN
 
@@ -234,7 +235,6 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
 
   XrdOucEnv parameter(query.c_str());
   XrdOucString lPrefix, lBucket;
-  XrdMgmOfsDirectory bucketdir;
   uint64_t cnt = 0;
   uint64_t max_keys = 1000;
   std::string marker = "";
@@ -310,23 +310,20 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
   bool truncated = false;
   size_t truncate_pos = result.length() + 13;
   result += "<IsTruncated>false</IsTruncated>";
-  // list directory
+  // list directory, all the entries are stat'ed in one pass
   std::string directory = lBucket.c_str();
   directory += lPrefix.c_str();
-  int listrc = bucketdir.open(directory.c_str(), vid, (const char*) 0);
+  std::vector<XrdMgmOfs::StatListEntry> entries;
+  int listrc = gOFS->stat_list(directory.c_str(), error, vid, entries);
 
   if (!listrc) {
-    const char* name = 0;
+    // Build the entries directly into the output, roughly 512B per entry
+    XmlBuffer xml(result.length() + 512 * std::min<uint64_t>(entries.size(),
+                  max_keys + 1) + 64);
+    xml.Raw(result);
 
     // loop over the directory contents
-    while ((name = bucketdir.nextEntry())) {
-      std::string entry = "";
-      std::string sname = name;
-
-      if ((sname == ".") || (sname == "..")) {
-        continue;
-      }
-
+    for (const auto& entry : entries) {
       // don't return more than max-keys
       if (cnt++ > max_keys) {
         truncated = true;
@@ -335,9 +332,7 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
 
       // construct object name
       std::string objectname = lPrefix.c_str();
-      objectname += sname;
-      std::string fullname = lBucket.c_str();
-      fullname += objectname;
+      objectname += entry.name;
 
       // check if output should begin
       if (!marker_reached) {
@@ -348,109 +343,11 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
         continue;
       }
 
-      {
-        // attempt file metadata retrieval
-        eos::common::RWMutexReadLock lock(gOFS->eosViewRWMutex, __FUNCTION__, __LINE__, __FILE__);
-        std::shared_ptr<eos::IContainerMD> cmd;
-        std::shared_ptr<eos::IFileMD> fmd;
-        int errc = 0;
-
-        try {
-          fmd = gOFS->eosView->getFile(fullname);
-          entry = "<Contents>";
-          entry += "<Key>";
-          entry += objectname.c_str();
-          entry += "</Key>";
-          entry += "<LastModified>";
-          eos::IFileMD::ctime_t mtime;
-          fmd->getMTime(mtime);
-          entry += Timing::UnixTimestamp_to_ISO8601(mtime.tv_sec);
-          entry += "</LastModified>";
-          entry += "<ETag>\"";
-          eos::appendChecksumOnStringAsHex(fmd.get(), entry);
-          entry += "\"</ETag>";
-          entry += "<Size>";
-          std::string sconv;
-          entry += StringConversion::GetSizeString(sconv, (unsigned long long)
-                   fmd->getSize());
-          entry += "</Size>";
-          entry += "<StorageClass>STANDARD</StorageClass>";
-          entry += "<Owner>";
-          entry += "<ID>";
-          entry += Mapping::UidToUserName(fmd->getCUid(), errc);
-          entry += "</ID>";
-          entry += "<DisplayName>";
-          entry += Mapping::UidToUserName(fmd->getCUid(), errc);
-          entry += ":";
-          entry += Mapping::GidToGroupName(fmd->getCGid(), errc);
-          entry += "</DisplayName>";
-          entry += "</Owner>";
-          entry += "</Contents>";
-        } catch (eos::MDException& e) {
-          fmd.reset();
-
-          if (e.getErrno() != ENOENT) {
-            errno = e.getErrno();
-            eos_static_err("msg=\"could not open file\" ec=%d emsg=\"%s\" filepath=%s\n",
-                           e.getErrno(), e.getMessage().str().c_str(),
-                           fullname.c_str());
-            return S3Handler::RestErrorResponse(
-                     eos::common::HttpResponse::INTERNAL_SERVER_ERROR,
-                     "Internal Error", "Unable to open path",
-                     fullname.c_str(), "");
-          }
-        }
-
-        // should be a container
-        if (!fmd) {
-          // attempt container metadata retrieval
-          try {
-            cmd = gOFS->eosView->getContainer(fullname);
-            entry = "<Contents>";
-            entry += "<Key>";
-            entry += objectname.c_str();
-            entry += "/";
-            entry += "</Key>";
-            entry += "<LastModified>";
-            eos::IContainerMD::ctime_t mtime;
-            cmd->getMTime(mtime);
-            entry += Timing::UnixTimestamp_to_ISO8601(mtime.tv_sec);
-            entry += "</LastModified>";
-            entry += "<ETag>";
-            entry += "</ETag>";
-            entry += "<Size>0</Size>";
-            entry += "<StorageClass>STANDARD</StorageClass>";
-            entry += "<Owner>";
-            entry += "<ID>";
-            entry += Mapping::UidToUserName(cmd->getCUid(), errc);
-            entry += "</ID>";
-            entry += "<DisplayName>";
-            entry += Mapping::UidToUserName(cmd->getCUid(), errc);
-            entry += ":";
-            entry += Mapping::GidToGroupName(cmd->getCGid(), errc);
-            entry += "</DisplayName>";
-            entry += "</Owner>";
-            entry += "</Contents>";
-          } catch (eos::MDException& e) {
-            cmd.reset();
-            errno = e.getErrno();
-            eos_static_err("msg=\"could not open directory\" ec=%d emsg=\"%s\" dirpath=%s\n",
-                           e.getErrno(), e.getMessage().str().c_str(),
-                           fullname.c_str());
-            return S3Handler::RestErrorResponse(
-                     eos::common::HttpResponse::INTERNAL_SERVER_ERROR,
-                     "Internal Error", "Unable to open path",
-                     fullname.c_str(), "");
-          }
-        }
-      }
-
-      // append this entry to the final result
-      result += entry;
+      AppendContents(xml, objectname, entry.buf, entry.checksum);
     }
-  }
 
-  bucketdir.close();
+    result = xml.Take();
+  }
 
   if (truncated) {
     result.replace(truncate_pos, 18, "true</IsTruncated>");
@@ -464,6 +361,51 @@ S3Store::ListBucket(const std::string& bucket, const std::string& query)
   return response;
 }
 
+/*----------------------------------------------------------------------------*/
+void
+S3Store::AppendContents(XmlBuffer& xml, const std::string& key,
+                        const struct stat& buf, const std::string& checksum)
+{
+  using namespace eos::common;
+  int errc = 0;
+  std::string sconv;
+  const bool isdir = S_ISDIR(buf.st_mode);
+  xml.Open("Contents");
+  xml.Open("Key").Escape(key);
+
+  if (isdir) {
+    xml.Raw("/");
+  }
+
+  xml.Close("Key");
+  xml.Open("LastModified");
+  xml.Raw(Timing::UnixTimestamp_to_ISO8601(buf.st_mtim.tv_sec));
+  xml.Close("LastModified");
+
+  if (isdir) {
+    xml.Raw("<ETag></ETag>");
+    xml.Raw("<Size>0</Size>");
+  } else {
+    xml.Raw("<ETag>\"").Raw(checksum).Raw("\"</ETag>");
+    xml.Open("Size");
+    xml.Raw(StringConversion::GetSizeString(sconv, (unsigned long long)
+                                            buf.st_size));
+    xml.Close("Size");
+  }
+
+  xml.Raw("<StorageClass>STANDARD</StorageClass>");
+  xml.Open("Owner");
+  xml.Open("ID").Escape(Mapping::UidToUserName(buf.st_uid, errc));
+  xml.Close("ID");
+  xml.Open("DisplayName");
+  xml.Escape(Mapping::UidToUserName(buf.st_uid, errc));
+  xml.Raw(":");
+  xml.Escape(Mapping::GidToGroupName(buf.st_gid, errc));
+  xml.Close("DisplayName");
+  xml.Close("Owner");
+  xml.Close("Contents");
+}
+
 /*----------------------------------------------------------------------------*/
 eos::common::HttpResponse*
 S3Store::HeadBucket(const std::string& id,
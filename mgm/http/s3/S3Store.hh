@@ -40,10 +40,13 @@
 #include <map>
 #include <set>
 #include <string>
+#include <sys/stat.h>
 /*----------------------------------------------------------------------------*/
 
 EOSMGMNAMESPACE_BEGIN
 
+class XmlBuffer;
+
 class S3Store
 {
 
@@ -103,6 +106,18 @@ public:
   eos::common::HttpResponse*
   ListBucket (const std::string &bucket, const std::string &query);
 
+  /**
+   * Append the Contents element of one bucket listing entry
+   *
+   * @param xml       buffer to append to
+   * @param key       object name inside the bucket
+   * @param buf       stat information of the entry
+   * @param checksum  hex checksum of the entry, ignored for directories
+   */
+  static void
+  AppendContents (XmlBuffer &xml, const std::string &key,
+                  const struct stat &buf, const std::string &checksum);
+
   /**
    * Head a bucket (acts like stat on a bucket)
    *
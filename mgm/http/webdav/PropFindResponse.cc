@@ -23,7 +23,6 @@
 
 #include "mgm/http/webdav/PropFindResponse.hh"
 #include "mgm/XrdMgmOfs.hh"
-#include "mgm/XrdMgmOfsDirectory.hh"
 #include "mgm/Quota.hh"
 #include "mgm/Access.hh"
 #include "mgm/XrdMgmOfs.hh"
@@ -123,19 +122,6 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     }
   }
 
-  // Build the response
-  // xml declaration
-  xml_node<>* decl = mXMLResponseDocument.allocate_node(node_declaration);
-  decl->append_attribute(AllocateAttribute("version", "1.0"));
-  decl->append_attribute(AllocateAttribute("encoding", "utf-8"));
-  mXMLResponseDocument.append_node(decl);
-  // <multistatus/> node
-  xml_node<>* multistatusNode = AllocateNode("d:multistatus");
-  multistatusNode->append_attribute(AllocateAttribute("xmlns:d", "DAV:"));
-  multistatusNode->append_attribute(
-    AllocateAttribute(eos::common::OwnCloud::OwnCloudNs(),
-                      eos::common::OwnCloud::OwnCloudNsUrl()));
-  mXMLResponseDocument.append_node(multistatusNode);
   // Is the requested resource a file or directory?
   XrdOucErrInfo error;
   struct stat statInfo;
@@ -156,63 +142,57 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
   //  }
   eos_static_debug("depth=%s, isdir=%d", depth.c_str(),
                    S_ISDIR(statInfo.st_mode));
-  xml_node<>* responseNode = 0;
+  // Build the response directly into the output buffer, roughly 1KB per
+  // <response/> element
+  XmlBuffer xml(1024);
+  xml.Raw("<?xml version=\"1.0\" encoding=\"utf-8\"?>");
+  xml.Raw("<d:multistatus xmlns:d=\"DAV:\" ");
+  xml.Raw(eos::common::OwnCloud::OwnCloudNs()).Raw("=\"");
+  xml.Raw(eos::common::OwnCloud::OwnCloudNsUrl()).Raw("\">");
 
   if (depth == "0" || !S_ISDIR(statInfo.st_mode)) {
     // Simply stat the file or direcAtory
-    responseNode = BuildResponseNode(request->GetUrl(), request->GetUrl(true));
-
-    if (responseNode) {
-      multistatusNode->append_node(responseNode);
-    } else {
+    if (!AppendResponseNode(xml, request->GetUrl(), request->GetUrl(true))) {
       return this;
     }
   } else if (depth == "1") {
-    // Stat the resource and all child resources
-    XrdMgmOfsDirectory directory;
-    int listrc = directory.open(request->GetUrl().c_str(), *mVirtualIdentity,
-                                (const char*) 0);
-    responseNode = BuildResponseNode(request->GetUrl().c_str(),
-                                     request->GetUrl(true).c_str());
-
-    if (responseNode) {
-      multistatusNode->append_node(responseNode);
-    }
+    // Stat the resource and all child resources in one pass
+    std::vector<XrdMgmOfs::StatListEntry> entries;
+    int listrc = gOFS->stat_list(request->GetUrl().c_str(), error,
+                                 *mVirtualIdentity, entries);
+
+    (void) AppendResponseNode(xml, request->GetUrl(), request->GetUrl(true));
 
     if (!listrc) {
-      const char* val;
+      xml.Reserve(xml.Size() + 1024 * entries.size());
 
-      while ((val = directory.nextEntry())) {
-        XrdOucString entryname = val;
+      for (const auto& entry : entries) {
+        XrdOucString entryname = entry.name.c_str();
 
         // don't display . .., atomic(+version) uploads and version directories
         if (entryname.beginswith(EOS_COMMON_PATH_VERSION_FILE_PREFIX) ||
             entryname.beginswith(EOS_COMMON_PATH_ATOMIC_FILE_PREFIX) ||
             entryname.beginswith(EOS_WEBDAV_HIDE_IN_PROPFIND_PREFIX) ||
-	    entryname.beginswith("...eos.ino...") ||
-            (entryname == ".") ||
-            (entryname == "..")) {
-          // skip over . .., and hidden files
+	    entryname.beginswith("...eos.ino...")) {
+          // skip over hidden files
           continue;
         }
 
-        // one response node for each file...
-        eos::common::Path path((request->GetUrl() + std::string("/") + std::string(
-                                  val)).c_str());
-        eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
-                                   std::string(val)).c_str());
-        responseNode = BuildResponseNode(path.GetPath(), refpath.GetPath());
-
-        if (responseNode) {
-          multistatusNode->append_node(responseNode);
-        } else {
-          // We might have a failed stat in the BuildResponseNode if there are
-          // symlinks present
-          SetResponseCode(HttpResponse::OK);
+        // hide hardlinks
+        if (entry.etag == "hardlink") {
+          continue;
         }
+
+        // one response element for each file...
+        eos::common::Path path((request->GetUrl() + std::string("/") +
+                                entry.name).c_str());
+        eos::common::Path refpath((request->GetUrl(true) + std::string("/") +
+                                   entry.name).c_str());
+        AppendResponse(xml, path.GetPath(), refpath.GetPath(), entry.buf,
+                       entry.etag);
       }
     } else {
-      eos_static_warning("msg=\"error opening directory - might be stalled/banned\"");
+      eos_static_warning("msg=\"error listing directory - might be stalled/banned\"");
       SetResponseCode(ResponseCodes::FORBIDDEN);
       return this;
     }
@@ -226,14 +206,11 @@ PropFindResponse::BuildResponse(eos::common::HttpRequest* request)
     return this;
   }
 
-  std::string responseString;
-  rapidxml::print(std::back_inserter(responseString), mXMLResponseDocument,
-                  rapidxml::print_no_indenting);
-  mXMLResponseDocument.clear();
+  xml.Close("d:multistatus");
   SetResponseCode(HttpResponse::MULTI_STATUS);
-  AddHeader("Content-Length", std::to_string((long long) responseString.size()));
+  AddHeader("Content-Length", std::to_string((long long) xml.Size()));
   AddHeader("Content-Type", "application/xml; charset=utf-8");
-  SetBody(responseString);
+  SetBody(xml.Take());
   return this;
 }
 
@@ -305,16 +282,13 @@ PropFindResponse::ParseRequestPropertyTypes(rapidxml::xml_node<>* node)
 }
 
 /*----------------------------------------------------------------------------*/
-rapidxml::xml_node<>*
-PropFindResponse::BuildResponseNode(const std::string& url,
-                                    const std::string& hrefurl)
+bool
+PropFindResponse::AppendResponseNode(XmlBuffer& xml, const std::string& url,
+                                     const std::string& hrefurl)
 {
-  using namespace rapidxml;
   XrdOucErrInfo error;
   struct stat statInfo;
   std::string etag;
-  std::string id;
-  bool allpropresponse = false;
   XrdOucString urlp = url.c_str();
   XrdOucString hrefp = hrefurl.c_str();
 
@@ -336,7 +310,7 @@ PropFindResponse::BuildResponseNode(const std::string& url,
     } else {
       SetResponseCode(ResponseCodes::NOT_FOUND);
     }
-    return NULL;
+    return false;
   }
 
   // hide hardlinks
@@ -345,258 +319,182 @@ PropFindResponse::BuildResponseNode(const std::string& url,
     eos_static_err("msg=\"hiding hardlinkg %s: %s\"", urlp.c_str(),
                    error.getErrText());
     SetResponseCode(ResponseCodes::NOT_FOUND);
-    return NULL;
-  }
-
-  eos_static_debug("url=%s etag=%s", urlp.c_str(), etag.c_str());
-  // encode the url's
-  urlp = EncodeURI(urlp.c_str()).c_str();
-  hrefp = EncodeURI(hrefp.c_str()).c_str();
-  // <response/> node
-  xml_node<>* responseNode = AllocateNode("d:response");
-  // <href/> node
-  xml_node<>* href = AllocateNode("d:href");
-
-  if (S_ISDIR(statInfo.st_mode)) {
-    if (hrefp[hrefp.length() - 1] != '/') {
-      hrefp += "/";
-    }
-  }
-
-  SetValue(href, hrefp.c_str());
-  responseNode->append_node(href);
-  // <propstat/> node for "found" properties
-  xml_node<>* propstatFound = AllocateNode("d:propstat");
-  responseNode->append_node(propstatFound);
-  // <status/> "found" node
-  xml_node<>* statusFound = AllocateNode("d:status");
-  SetValue(statusFound, "HTTP/1.1 200 OK");
-  propstatFound->append_node(statusFound);
-  // <prop/> "found" node
-  xml_node<>* propFound = AllocateNode("d:prop");
-  propstatFound->append_node(propFound);
-  // <propstat/> node for "not found" properties
-  xml_node<>* propstatNotFound = AllocateNode("d:propstat");
-  responseNode->append_node(propstatNotFound);
-  // <status/> "not found" node
-  xml_node<>* statusNotFound = AllocateNode("d:status");
-  SetValue(statusNotFound, "HTTP/1.1 404 Not Found");
-  propstatNotFound->append_node(statusNotFound);
-  // <prop/> "not found" node
-  xml_node<>* propNotFound = AllocateNode("d:prop");
-  propstatNotFound->append_node(propNotFound);
-  xml_node<>* contentLength = 0;
-  xml_node<>* lastModified = 0;
-  xml_node<>* resourceType = 0;
-  xml_node<>* checkedIn = 0;
-  xml_node<>* checkedOut = 0;
-  xml_node<>* creationDate = 0;
-  xml_node<>* eTag = 0;
-  xml_node<>* displayName = 0;
-  xml_node<>* contentType = 0;
-  xml_node<>* quotaAvail = 0;
-  xml_node<>* quotaUsed = 0;
-  xml_node<>* ocid = 0;
-  xml_node<>* ocsize = 0;
-  xml_node<>* ocperm = 0;
-
-  if (mRequestPropertyTypes & PropertyTypes::GET_CONTENT_LENGTH) {
-    contentLength = AllocateNode("d:getcontentlength");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::GET_CONTENT_TYPE) {
-    contentType = AllocateNode("d:getcontenttype");
+    return false;
   }
 
-  if (mRequestPropertyTypes & PropertyTypes::GET_LAST_MODIFIED) {
-    lastModified = AllocateNode("d:getlastmodified");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::CREATION_DATE) {
-    creationDate = AllocateNode("d:creationdate");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::RESOURCE_TYPE) {
-    resourceType = AllocateNode("d:resourcetype");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::DISPLAY_NAME) {
-    displayName = AllocateNode("d:displayname");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::GET_ETAG) {
-    eTag = AllocateNode("d:getetag");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::CHECKED_IN) {
-    checkedIn = AllocateNode("d:checked-in");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::CHECKED_OUT) {
-    checkedOut = AllocateNode("d:checked-out");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::GET_OCID) {
-    ocid = AllocateNode("oc:id");
-  }
-
-  if (mRequestPropertyTypes & PropertyTypes::GET_OCSIZE) {
-    ocsize = AllocateNode("oc:size");
-  }
+  AppendResponse(xml, urlp.c_str(), hrefp.c_str(), statInfo, etag);
+  return true;
+}
 
-  if (mRequestPropertyTypes & PropertyTypes::GET_OCPERM) {
-    ocperm = AllocateNode("oc:permissions");
-  }
+/*----------------------------------------------------------------------------*/
+void
+PropFindResponse::AppendResponse(XmlBuffer& xml, const std::string& url,
+                                 const std::string& hrefurl,
+                                 const struct stat& statInfo,
+                                 const std::string& etag)
+{
+  XrdOucErrInfo error;
+  std::string id;
+  const bool isdir = S_ISDIR(statInfo.st_mode);
+  const int props = mRequestPropertyTypes;
+  // ANDROID does not digest the not found properties in allprop requests
+  const bool allpropresponse = (props & PropertyTypes::ALLPROP_MARKER);
+  eos_static_debug("url=%s etag=%s", url.c_str(), etag.c_str());
+  // encode the url's
+  std::string hrefp = EncodeURI(hrefurl.c_str());
 
-  if (mRequestPropertyTypes & PropertyTypes::ALLPROP_MARKER) {
-    allpropresponse = true;
+  if (isdir && (hrefp.empty() || (hrefp.back() != '/'))) {
+    hrefp += "/";
   }
 
-  if ((S_ISDIR(statInfo.st_mode)) &&
-      ((mRequestPropertyTypes & PropertyTypes::QUOTA_AVAIL) ||
-       (mRequestPropertyTypes & PropertyTypes::QUOTA_USED))) {
-    // -----------------------------------------------------------
-    // retrieve the current quota
-    // -----------------------------------------------------------
-    XrdOucString path = url.c_str();
-
-    if (!path.endswith("/")) {
-      path += "/";
-    }
-
-    while (path.replace("//", "/")) {}
-
-    long long maxbytes = 0;
-    long long freebytes = 0;
-    long long maxfiles = 0;
-    long long freefiles = 0;
-    Quota::GetIndividualQuota(*mVirtualIdentity, path.c_str(), maxbytes, freebytes,
-                              maxfiles, freefiles, true);
-
-    if (mRequestPropertyTypes & PropertyTypes::QUOTA_AVAIL) {
-      std::string sQuotaAvail;
-      quotaAvail = AllocateNode("d:quota-available-bytes");
-
-      if (quotaAvail) {
-        SetValue(quotaAvail, eos::common::StringConversion::GetSizeString(sQuotaAvail,
-                 (unsigned long long) freebytes));
-      }
-    }
-
-    if (mRequestPropertyTypes & PropertyTypes::QUOTA_USED) {
-      std::string sQuotaUsed;
-      quotaUsed = AllocateNode("d:quota-used-bytes");
-      SetValue(quotaUsed, eos::common::StringConversion::GetSizeString(sQuotaUsed,
-               (unsigned long long) statInfo.st_size));
-    }
-  }
+  xml.Open("d:response");
+  xml.Element("d:href", hrefp);
+  // <propstat/> element for "found" properties
+  xml.Open("d:propstat");
+  xml.Element("d:status", "HTTP/1.1 200 OK");
+  const size_t prop_pos = xml.Size();
+  xml.Open("d:prop");
+  const size_t prop_start = xml.Size();
 
   // getlastmodified, creationdate, displayname and getetag properties are
   // common to all resources
-  if (lastModified) {
-    std::string lm = eos::common::Timing::utctime(
-                       statInfo.st_mtim.tv_sec);
-    SetValue(lastModified, lm.c_str());
-    propFound->append_node(lastModified);
+  if (props & PropertyTypes::GET_LAST_MODIFIED) {
+    xml.Element("d:getlastmodified",
+                eos::common::Timing::utctime(statInfo.st_mtim.tv_sec));
   }
 
-  if (creationDate) {
-    std::string cd = eos::common::Timing::UnixTimestamp_to_ISO8601(
-                       statInfo.st_ctim.tv_sec);
-    SetValue(creationDate, cd.c_str());
-    propFound->append_node(creationDate);
+  if (props & PropertyTypes::CREATION_DATE) {
+    xml.Element("d:creationdate",
+                eos::common::Timing::UnixTimestamp_to_ISO8601(
+                  statInfo.st_ctim.tv_sec));
   }
 
-  if (eTag) {
-    SetValue(eTag, etag.c_str());
-    propFound->append_node(eTag);
+  if (props & PropertyTypes::GET_ETAG) {
+    xml.Element("d:getetag", etag);
   }
 
-  if (ocid) {
-    SetValue(ocid, eos::common::StringConversion::GetSizeString(id,
-             (unsigned long long) statInfo.st_ino));
-    propFound->append_node(ocid);
+  if (props & PropertyTypes::GET_OCID) {
+    xml.Element("oc:id", eos::common::StringConversion::GetSizeString(id,
+                (unsigned long long) statInfo.st_ino));
   }
 
-  if (ocsize) {
-    SetValue(ocsize, eos::common::StringConversion::GetSizeString(id,
-             (unsigned long long) statInfo.st_size));
-    propFound->append_node(ocsize);
+  if (props & PropertyTypes::GET_OCSIZE) {
+    xml.Element("oc:size", eos::common::StringConversion::GetSizeString(id,
+                (unsigned long long) statInfo.st_size));
   }
 
-  if (ocperm) {
+  if (props & PropertyTypes::GET_OCPERM) {
     // test access permissions
     std::string oc_perm = "";
     gOFS->acc_access(url.c_str(), error, *mVirtualIdentity, oc_perm);
-    SetValue(ocperm, oc_perm.c_str());
-    propFound->append_node(ocperm);
+    xml.Element("oc:permissions", oc_perm);
   }
 
-  if (displayName) {
-    eos::common::Path path(urlp.c_str());
+  if (props & PropertyTypes::DISPLAY_NAME) {
+    eos::common::Path path(EncodeURI(url.c_str()).c_str());
     eos_static_debug("msg=\"display name: %s\"", path.GetName());
-    SetValue(displayName, path.GetName());
-    propFound->append_node(displayName);
+    xml.Element("d:displayname", path.GetName());
   }
 
   // Directory
-  if (S_ISDIR(statInfo.st_mode)) {
-    if (resourceType) {
-      xml_node<>* container = AllocateNode("d:collection");
-      resourceType->append_node(container);
-      propFound->append_node(resourceType);
+  if (isdir) {
+    if (props & PropertyTypes::RESOURCE_TYPE) {
+      xml.Open("d:resourcetype").Empty("d:collection").Close("d:resourcetype");
     }
 
-    if (!allpropresponse) {
-      // ANDROID does not digest this response properly in allprop requests
-      if (contentLength) {
-        propNotFound->append_node(contentLength);
-      }
+    if (props & PropertyTypes::GET_CONTENT_TYPE) {
+      xml.Element("d:getcontenttype", "httpd/unix-directory");
     }
 
-    if (contentType) {
-      SetValue(contentType, "httpd/unix-directory");
-      propFound->append_node(contentType);
-    }
+    if ((props & PropertyTypes::QUOTA_AVAIL) ||
+        (props & PropertyTypes::QUOTA_USED)) {
+      // -----------------------------------------------------------
+      // retrieve the current quota
+      // -----------------------------------------------------------
+      XrdOucString path = url.c_str();
 
-    if (quotaAvail) {
-      propFound->append_node(quotaAvail);
-    }
+      if (!path.endswith("/")) {
+        path += "/";
+      }
+
+      while (path.replace("//", "/")) {}
+
+      long long maxbytes = 0;
+      long long freebytes = 0;
+      long long maxfiles = 0;
+      long long freefiles = 0;
+      Quota::GetIndividualQuota(*mVirtualIdentity, path.c_str(), maxbytes,
+                                freebytes, maxfiles, freefiles, true);
+
+      if (props & PropertyTypes::QUOTA_AVAIL) {
+        std::string sQuotaAvail;
+        xml.Element("d:quota-available-bytes",
+                    eos::common::StringConversion::GetSizeString(sQuotaAvail,
+                        (unsigned long long) freebytes));
+      }
 
-    if (quotaUsed) {
-      propFound->append_node(quotaUsed);
+      if (props & PropertyTypes::QUOTA_USED) {
+        std::string sQuotaUsed;
+        xml.Element("d:quota-used-bytes",
+                    eos::common::StringConversion::GetSizeString(sQuotaUsed,
+                        (unsigned long long) statInfo.st_size));
+      }
     }
   }
   // File
   else {
-    if (resourceType) {
-      propFound->append_node(resourceType);
+    if (props & PropertyTypes::RESOURCE_TYPE) {
+      xml.Empty("d:resourcetype");
     }
 
-    if (contentLength) {
-      SetValue(contentLength, std::to_string((long long) statInfo.st_size).c_str());
-      propFound->append_node(contentLength);
+    if (props & PropertyTypes::GET_CONTENT_LENGTH) {
+      xml.Element("d:getcontentlength",
+                  std::to_string((long long) statInfo.st_size));
     }
 
-    if (contentType) {
-      SetValue(contentType, HttpResponse::ContentType(url.c_str()).c_str());
-      propFound->append_node(contentType);
+    if (props & PropertyTypes::GET_CONTENT_TYPE) {
+      xml.Element("d:getcontenttype", HttpResponse::ContentType(url.c_str()));
     }
   }
 
-  // We don't use these (yet)
-  if (!allpropresponse) {
-    // ANDROID does not digest this response properly in allprop requests
-    if (checkedIn) {
-      propNotFound->append_node(checkedIn);
+  if (xml.Size() == prop_start) {
+    xml.Truncate(prop_pos);
+    xml.Empty("d:prop");
+  } else {
+    xml.Close("d:prop");
+  }
+
+  xml.Close("d:propstat");
+  // <propstat/> element for "not found" properties
+  xml.Open("d:propstat");
+  xml.Element("d:status", "HTTP/1.1 404 Not Found");
+
+  if (!allpropresponse &&
+      ((isdir && (props & PropertyTypes::GET_CONTENT_LENGTH)) ||
+       (props & PropertyTypes::CHECKED_IN) ||
+       (props & PropertyTypes::CHECKED_OUT))) {
+    xml.Open("d:prop");
+
+    if (isdir && (props & PropertyTypes::GET_CONTENT_LENGTH)) {
+      xml.Empty("d:getcontentlength");
+    }
+
+    // We don't use these (yet)
+    if (props & PropertyTypes::CHECKED_IN) {
+      xml.Empty("d:checked-in");
     }
 
-    if (checkedOut) {
-      propNotFound->append_node(checkedOut);
+    if (props & PropertyTypes::CHECKED_OUT) {
+      xml.Empty("d:checked-out");
     }
+
+    xml.Close("d:prop");
+  } else {
+    xml.Empty("d:prop");
   }
 
-  return responseNode;
+  xml.Close("d:propstat");
+  xml.Close("d:response");
 }
 
 /*----------------------------------------------------------------------------*/
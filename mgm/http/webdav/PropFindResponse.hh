@@ -35,6 +35,7 @@
 
 /*----------------------------------------------------------------------------*/
 #include "mgm/http/webdav/WebDAVResponse.hh"
+#include "mgm/http/XmlBuffer.hh"
 #include "mgm/Namespace.hh"
 #include "common/Mapping.hh"
 #include "common/Logging.hh"
@@ -141,15 +142,34 @@ public:
 
 
   /**
-   * Build a response XML <response/> node containing the properties that were
-   * requested, whether they were found or not, etc (see RFC)
+   * Stat the given resource and append a <response/> element containing the
+   * properties that were requested, whether they were found or not, etc
+   * (see RFC)
    *
-   * @param url  the URL of the resource to build a response node for
+   * @param xml      the buffer to append to
+   * @param url      the URL of the resource to build a response element for
+   * @param hrefurl  the URL to be reported in the <href/> element
    *
-   * @return the newly build response node
+   * @return true if the element was appended, false if the stat failed
    */
-  rapidxml::xml_node<>*
-  BuildResponseNode (const std::string &url, const std::string &hrefurl);
+  bool
+  AppendResponseNode (XmlBuffer &xml, const std::string &url,
+                      const std::string &hrefurl);
+
+  /**
+   * Append a <response/> element for a resource which was already stat'ed
+   *
+   * @param xml       the buffer to append to
+   * @param url       the URL of the resource, without duplicate slashes
+   * @param hrefurl   the URL to be reported in the <href/> element, without
+   *                  duplicate slashes
+   * @param statInfo  the stat information of the resource
+   * @param etag      the etag of the resource
+   */
+  void
+  AppendResponse (XmlBuffer &xml, const std::string &url,
+                  const std::string &hrefurl, const struct stat &statInfo,
+                  const std::string &etag);
 
   /**
    * Convert the given property type string into its integer constant
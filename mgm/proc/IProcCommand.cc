@@ -37,11 +37,14 @@ std::atomic_uint_least64_t IProcCommand::uuid{0};
 std::mutex IProcCommand::mMapCmdsMutex;
 std::map<eos::console::RequestProto::CommandCase, uint64_t>
 IProcCommand::mCmdsExecuting;
+std::atomic<uint64_t> IProcCommand::sNumStreaming {0};
+constexpr uint64_t IProcCommand::sMaxStreaming;
+constexpr std::chrono::seconds IProcCommand::sStreamReadTimeout;
 
 //------------------------------------------------------------------------------
 // Open a proc command e.g. call the appropriate user or admin command and
-// store the output in a resultstream or in case of find in a temporary output
-// file.
+// store the output in a resultstream or in case of find stream it directly
+// to the client while the command is still running.
 //------------------------------------------------------------------------------
 int
 IProcCommand::open(const char* path, const char* info,
@@ -52,18 +55,44 @@ IProcCommand::open(const char* path, const char* info,
   int delay = 5;
 
   if (!mExecRequest) {
+    if (IsStreaming() && !HasStreamingSlot()) {
+      eos_notice("%s", SSTR("cmd_type=" << mReqProto.command_case() <<
+                            " no more streaming slots, stall client 3 seconds").c_str());
+      return delay - 2;
+    }
+
     if (HasSlot()) {
       LaunchJob();
       mExecRequest = true;
     } else {
+      ReleaseStreamingSlot();
       eos_notice("%s", SSTR("cmd_type=" << mReqProto.command_case() <<
                             " no more slots, stall client 3 seconds").c_str());
       return delay - 2;
     }
   }
 
-  if (mFuture.wait_for(std::chrono::seconds(delay)) !=
-      std::future_status::ready) {
+  // Wait for the command to either finish or stream some output
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(delay);
+  bool ready = false;
+
+  while (true) {
+    ready = (mFuture.wait_for(std::chrono::milliseconds(100)) ==
+             std::future_status::ready);
+
+    if (ready || (mStreamOut.IsOpen() && mStreamOut.HasData()) ||
+        (std::chrono::steady_clock::now() >= deadline)) {
+      break;
+    }
+  }
+
+  if (!ready && mStreamOut.IsOpen() && mStreamOut.HasData()) {
+    // Output is served by read while the command is still running
+    return SFS_OK;
+  }
+
+  if (!ready) {
     // Stall the client
     std::string msg = "command not ready, stall the client 5 seconds";
     eos_notice("%s", msg.c_str());
@@ -91,12 +120,10 @@ IProcCommand::open(const char* path, const char* info,
                             mRoutingInfo.port);
     }
 
-    // Output is written in file
-    if (!ofstdoutStreamFilename.empty() && !ofstderrStreamFilename.empty()) {
-      ifstdoutStream.open(ofstdoutStreamFilename, std::ifstream::in);
-      ifstderrStream.open(ofstderrStreamFilename, std::ifstream::in);
-      iretcStream.str(std::string("&mgm.proc.retc=") + std::to_string(reply.retc()));
-      readStdOutStream = true;
+    // Output is streamed, the command already finished
+    if (mStreamOut.IsOpen()) {
+      LogComment(reply.retc());
+      return SFS_OK;
     } else {
       std::ostringstream oss;
 
@@ -115,20 +142,7 @@ IProcCommand::open(const char* path, const char* info,
       mTmpResp = oss.str();
     }
 
-    // Store the client's command comment in the comments logbook
-    if ((vid.uid <= 2) || (vid.sudoer)) {
-      // Only instance users or sudoers can add to the logbook
-      if (mComment.length() && gOFS->mCommentLog) {
-        std::string argsJson;
-        (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
-
-        if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
-                                    mComment.c_str(), stdErr.c_str(), // @note stErr or reply.std_err()?
-                                    reply.retc())) {
-          eos_err("failed to log to comments logbook");
-        }
-      }
-    }
+    LogComment(reply.retc());
   }
 
   return SFS_OK;
@@ -142,32 +156,22 @@ IProcCommand::read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen)
 {
   size_t cpy_len = 0;
 
-  if (readStdOutStream && ifstdoutStream.is_open() && ifstderrStream.is_open()) {
-    ifstdoutStream.read(buff, blen);
-    cpy_len = (size_t)ifstdoutStream.gcount();
-
-    if (cpy_len < (size_t)blen) {
-      readStdOutStream = false;
-      readStdErrStream = true;
-      ifstderrStream.read(buff + cpy_len, blen - cpy_len);
-      cpy_len += (size_t)ifstderrStream.gcount();
-    }
-  } else if (readStdErrStream && ifstderrStream.is_open()) {
-    ifstderrStream.read(buff, blen);
-    cpy_len = (size_t)ifstderrStream.gcount();
-
-    if (cpy_len < (size_t)blen) {
-      readStdErrStream = false;
-      readRetcStream = true;
-      iretcStream.read(buff + cpy_len, blen - cpy_len);
-      cpy_len += (size_t)iretcStream.gcount();
-    }
-  } else if (readRetcStream) {
-    iretcStream.read(buff, blen);
-    cpy_len = (size_t)iretcStream.gcount();
-
-    if (cpy_len < (size_t)blen) {
-      readRetcStream = false;
+  if (mStreamOut.IsOpen()) {
+    // Streamed output is consumed sequentially, the offset is irrelevant.
+    // Hand over whatever is available instead of waiting for a full buffer.
+    cpy_len = mStreamOut.Read(buff, blen, sStreamReadTimeout);
+
+    if ((cpy_len == 0) && !mStreamOut.IsFinished()) {
+      // Don't block the client forever, terminate the response with an error
+      eos_err("msg=\"no streamed output within %llus, abort command\" "
+              "cmd_type=%d", (unsigned long long) sStreamReadTimeout.count(),
+              mReqProto.command_case());
+      mForceKill.store(true);
+      mStreamOut.Cancel();
+      std::string tail = SSTR("&mgm.proc.stderr=error: command timed out"
+                              "&mgm.proc.retc=" << ETIMEDOUT);
+      cpy_len = std::min(tail.length(), (size_t)blen);
+      memcpy(buff, tail.data(), cpy_len);
     }
   } else if ((size_t)offset < mTmpResp.length()) {
     cpy_len = std::min((size_t)(mTmpResp.size() - offset), (size_t)blen);
@@ -183,19 +187,36 @@ IProcCommand::read(XrdSfsFileOffset offset, char* buff, XrdSfsXferSize blen)
 void
 IProcCommand::LaunchJob()
 {
+  // Run the command and terminate its streamed output, if any
+  auto job = [this]() -> eos::console::ReplyProto {
+    eos::console::ReplyProto reply = ProcessRequest();
+
+    if (mStreamOut.IsOpen()) {
+      ofstdoutStream.flush();
+      std::string tail = ofstderrStream.str();
+      tail += "&mgm.proc.retc=";
+      tail += std::to_string(reply.retc());
+      (void) mStreamOut.Write(tail.c_str(), tail.length());
+      mStreamOut.Close();
+    }
+
+    ReleaseStreamingSlot();
+    return reply;
+  };
+
   if (mDoAsync) {
     mFuture = ProcInterface::sProcThreads.PushTask<eos::console::ReplyProto>
-    ([this]() -> eos::console::ReplyProto {
-      return ProcessRequest();
-    });
+              (std::move(job));
 
     if (EOS_LOGS_DEBUG) {
       eos_debug("%s", ProcInterface::sProcThreads.GetInfo().c_str());
     }
   } else {
+    // Nobody drains the channel while the command runs in this thread
+    mStreamOut.SetCapacity(0);
     std::promise<eos::console::ReplyProto> promise;
     mFuture = promise.get_future();
-    promise.set_value(ProcessRequest());
+    promise.set_value(job());
   }
 }
 
@@ -221,61 +242,71 @@ IProcCommand::KillJob()
 }
 
 //------------------------------------------------------------------------------
-// Open temporary output files for file based results
+// Start streaming the output of the command to the client
 //------------------------------------------------------------------------------
 bool
-IProcCommand::OpenTemporaryOutputFiles()
+IProcCommand::OpenStreamingOutput()
 {
-  ostringstream tmpdir;
-  tmpdir << "/var/tmp/eos/mgm/";
-  tmpdir << uuid++;
-  ofstdoutStreamFilename = tmpdir.str();
-  ofstdoutStreamFilename += ".stdout";
-  ofstderrStreamFilename = tmpdir.str();
-  ofstderrStreamFilename += ".stderr";
-  eos::common::Path cPath(ofstdoutStreamFilename.c_str());
-
-  if (!cPath.MakeParentPath(S_IRWXU)) {
-    eos_err("Unable to create temporary outputfile directory %s",
-            tmpdir.str().c_str());
-    return false;
-  }
+  ofstdoutStream << "mgm.proc.stdout=";
+  ofstderrStream << "&mgm.proc.stderr=";
+  mStreamOut.Open();
+  return true;
+}
 
-  // own the directory by daemon
-  if (::chown(cPath.GetParentPath(), 2, 2)) {
-    eos_err("Unable to own temporary outputfile directory %s",
-            cPath.GetParentPath());
-  }
+//------------------------------------------------------------------------------
+// Flush the streamed output
+//------------------------------------------------------------------------------
+bool
+IProcCommand::CloseStreamingOutput()
+{
+  ofstdoutStream.flush();
+  return !ofstdoutStream.fail();
+}
 
-  ofstdoutStream.open(ofstdoutStreamFilename, std::ofstream::out);
-  ofstderrStream.open(ofstderrStreamFilename, std::ofstream::out);
+//------------------------------------------------------------------------------
+// Cancel the streaming and wait for the job still producing the output
+//------------------------------------------------------------------------------
+void
+IProcCommand::StopStreamingJob()
+{
+  if (!mStreamOut.IsOpen()) {
+    return;
+  }
 
-  if ((!ofstdoutStream) || (!ofstderrStream)) {
-    if (ofstdoutStream.is_open()) {
-      ofstdoutStream.close();
-    }
+  mStreamOut.Cancel();
 
-    if (ofstderrStream.is_open()) {
-      ofstderrStream.close();
-    }
-
-    return false;
+  if (mFuture.valid()) {
+    mForceKill.store(true);
+    eos::console::ReplyProto reply = mFuture.get();
+    LogComment(reply.retc());
   }
-
-  ofstdoutStream << "mgm.proc.stdout=";
-  ofstderrStream << "&mgm.proc.stderr=";
-  return true;
 }
 
 //------------------------------------------------------------------------------
-// Open temporary output files for file based results
+// Store the client's command comment in the comments logbook
 //------------------------------------------------------------------------------
-bool
-IProcCommand::CloseTemporaryOutputFiles()
+void
+IProcCommand::LogComment(int rc)
 {
-  ofstdoutStream.close();
-  ofstderrStream.close();
-  return !(ofstdoutStream.is_open() || ofstderrStream.is_open());
+  if (mCommentLogged) {
+    return;
+  }
+
+  mCommentLogged = true;
+
+  // Only instance users or sudoers can add to the logbook
+  if ((mVid.uid <= 2) || (mVid.sudoer)) {
+    if (mComment.length() && gOFS->mCommentLog) {
+      std::string argsJson;
+      (void) google::protobuf::util::MessageToJsonString(mReqProto, &argsJson);
+
+      if (!gOFS->mCommentLog->Add(mTimestamp, "", "", argsJson.c_str(),
+                                  mComment.c_str(), stdErr.c_str(), // @note stErr or reply.std_err()?
+                                  rc)) {
+        eos_err("failed to log to comments logbook");
+      }
+    }
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -531,6 +562,39 @@ IProcCommand::ShouldRoute(const std::string& path,
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Take one of the slots reserved for streaming commands
+//------------------------------------------------------------------------------
+bool
+IProcCommand::HasStreamingSlot()
+{
+  if (mHasStreamingSlot) {
+    return true;
+  }
+
+  uint64_t num = sNumStreaming.load();
+
+  do {
+    if (num >= sMaxStreaming) {
+      return false;
+    }
+  } while (!sNumStreaming.compare_exchange_weak(num, num + 1));
+
+  mHasStreamingSlot = true;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Release the streaming slot, if any
+//------------------------------------------------------------------------------
+void
+IProcCommand::ReleaseStreamingSlot()
+{
+  if (mHasStreamingSlot.exchange(false)) {
+    --sNumStreaming;
+  }
+}
+
 //------------------------------------------------------------------------------
 // Check if there is still an available slot for the current type of command
 //------------------------------------------------------------------------------
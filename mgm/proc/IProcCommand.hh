@@ -23,6 +23,7 @@
 
 #pragma once
 #include "mgm/Namespace.hh"
+#include "mgm/proc/ProcResponseStream.hh"
 #include "common/Mapping.hh"
 #include "common/Logging.hh"
 #include "proto/ConsoleReply.pb.h"
@@ -83,18 +84,8 @@ public:
   virtual ~IProcCommand()
   {
     mForceKill.store(true);
-
-    if (ofstdoutStream.is_open()) {
-      ofstdoutStream.close();
-    }
-
-    unlink(ofstdoutStreamFilename.c_str());
-
-    if (ofstderrStream.is_open()) {
-      ofstderrStream.close();
-    }
-
-    unlink(ofstderrStreamFilename.c_str());
+    StopStreamingJob();
+    ReleaseStreamingSlot();
 
     if (mHasSlot) {
       std::unique_lock<std::mutex> lock(mMapCmdsMutex);
@@ -104,8 +95,8 @@ public:
 
   //----------------------------------------------------------------------------
   //! Open a proc command e.g. call the appropriate user or admin command and
-  //! store the output in a resultstream of in case of find in temporary output
-  //! files.
+  //! store the output in a resultstream or in case of find stream it directly
+  //! to the client while the command is still running.
   //!
   //! @param inpath path indicating user or admin command
   //! @param info CGI describing the proc command
@@ -138,21 +129,8 @@ public:
   //----------------------------------------------------------------------------
   virtual int stat(struct stat* buf)
   {
-    off_t size = 0;
-
-    if (readStdOutStream) {
-      ifstdoutStream.seekg(0, ifstdoutStream.end);
-      size += ifstdoutStream.tellg();
-      ifstdoutStream.seekg(0, ifstdoutStream.beg);
-      ifstderrStream.seekg(0, ifstderrStream.end);
-      size += ifstderrStream.tellg();
-      ifstderrStream.seekg(0, ifstderrStream.beg);
-      iretcStream.seekg(0, iretcStream.end);
-      size += iretcStream.tellg();
-      iretcStream.seekg(0, iretcStream.beg);
-    } else {
-      size = mTmpResp.length();
-    }
+    // The size of a streamed response is not known in advance
+    off_t size = (mStreamOut.IsOpen() ? 0 : mTmpResp.length());
 
     memset(buf, 0, sizeof(struct stat));
     buf->st_size = size;
@@ -166,14 +144,7 @@ public:
   //----------------------------------------------------------------------------
   virtual int close()
   {
-    if (ifstdoutStream.is_open()) {
-      ifstdoutStream.close();
-    }
-
-    if (ifstderrStream.is_open()) {
-      ifstderrStream.close();
-    }
-
+    StopStreamingJob();
     return SFS_OK;
   }
 
@@ -211,9 +182,46 @@ public:
 
   virtual void SetError(XrdOucErrInfo* error) {};
 
+  //----------------------------------------------------------------------------
+  //! Check if the command streams its output to the client while running,
+  //! such commands hold a proc thread for their whole duration
+  //----------------------------------------------------------------------------
+  virtual bool IsStreaming() const
+  {
+    return false;
+  }
+
 protected:
-  virtual bool OpenTemporaryOutputFiles();
-  virtual bool CloseTemporaryOutputFiles();
+  //----------------------------------------------------------------------------
+  //! Start streaming the output of the command to the client. From now on
+  //! ofstdoutStream is forwarded to the client through a bounded channel while
+  //! ofstderrStream is buffered in memory as it comes after the stdout in the
+  //! response. The return code is appended once ProcessRequest returns.
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool OpenStreamingOutput();
+
+  //----------------------------------------------------------------------------
+  //! Flush the streamed output
+  //!
+  //! @return true if successful, false if the client is gone
+  //----------------------------------------------------------------------------
+  bool CloseStreamingOutput();
+
+  //----------------------------------------------------------------------------
+  //! Check if the client stopped reading the streamed output
+  //----------------------------------------------------------------------------
+  inline bool IsStreamingCancelled() const
+  {
+    return mStreamOut.IsCancelled();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Cancel the streaming and wait for the job still producing the output.
+  //! Must be called before the object of the derived class is destroyed.
+  //----------------------------------------------------------------------------
+  void StopStreamingJob();
 
   //----------------------------------------------------------------------------
   //! Retrieve the file's full path given its numeric id.
@@ -327,6 +335,26 @@ protected:
   //----------------------------------------------------------------------------
   bool HasSlot();
 
+  //----------------------------------------------------------------------------
+  //! Take one of the slots limiting the number of concurrent streaming
+  //! commands, so that they can not occupy all the proc threads
+  //!
+  //! @return true if slot taken, otherwise false
+  //----------------------------------------------------------------------------
+  bool HasStreamingSlot();
+
+  //----------------------------------------------------------------------------
+  //! Release the streaming slot, if any
+  //----------------------------------------------------------------------------
+  void ReleaseStreamingSlot();
+
+  //----------------------------------------------------------------------------
+  //! Store the client's command comment in the comments logbook
+  //!
+  //! @param rc return code of the command
+  //----------------------------------------------------------------------------
+  void LogComment(int rc);
+
   //----------------------------------------------------------------------------
   //! Store routing information
   //----------------------------------------------------------------------------
@@ -343,8 +371,18 @@ protected:
   static std::map<eos::console::RequestProto::CommandCase, uint64_t>
   mCmdsExecuting;
 
+  //! Max number of concurrent streaming commands, half of the minimum size
+  //! of the proc thread pool
+  static constexpr uint64_t sMaxStreaming = 32;
+  //! Number of streaming commands currently running
+  static std::atomic<uint64_t> sNumStreaming;
+  //! Max time a read waits for streamed output before failing the command
+  static constexpr std::chrono::seconds sStreamReadTimeout {300};
+
   //! Indicate if current command has taken a slot in the queue
   std::atomic<bool> mHasSlot;
+  //! Indicate if current command has taken a streaming slot
+  std::atomic<bool> mHasStreamingSlot {false};
   bool mExecRequest; ///< Indicate if request is launched asynchronously
   eos::console::RequestProto mReqProto; ///< Client request protobuf object
   std::future<eos::console::ReplyProto> mFuture; ///< Response future
@@ -359,16 +397,12 @@ protected:
   XrdOucString stdJson; ///< JSON output returned by proc command
   int retc; ///< Return code from the proc command
   std::string mTmpResp; ///< String used for streaming the response
-  std::ofstream ofstdoutStream;
-  std::ofstream ofstderrStream;
-  std::string ofstdoutStreamFilename;
-  std::string ofstderrStreamFilename;
-  std::ifstream ifstdoutStream;
-  std::ifstream ifstderrStream;
-  std::istringstream iretcStream;
-  bool readStdOutStream {false};
-  bool readStdErrStream {false};
-  bool readRetcStream {false};
+  //! Channel used for streaming the response while the command is running
+  ProcResponseStream mStreamOut;
+  ProcResponseStreamBuf mStreamOutBuf {mStreamOut};
+  std::ostream ofstdoutStream {&mStreamOutBuf}; ///< Streamed stdout
+  std::ostringstream ofstderrStream; ///< Buffered stderr of streamed response
+  bool mCommentLogged {false}; ///< Mark if the comment was already logged
 };
 
 EOSMGMNAMESPACE_END
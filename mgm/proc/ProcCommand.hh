@@ -171,7 +171,7 @@ public:
   //!
   //! @return true if successful otherwise false
   //----------------------------------------------------------------------------
-  bool OpenTemporaryOutputFiles() override;
+  bool OpenTemporaryOutputFiles();
 
   //----------------------------------------------------------------------------
   //! Get the return code of a proc command
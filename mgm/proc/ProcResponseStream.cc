@@ -0,0 +1,249 @@
+//------------------------------------------------------------------------------
+//! @file ProcResponseStream.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/proc/ProcResponseStream.hh"
+#include <algorithm>
+#include <cstring>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr size_t ProcResponseStream::sDefaultCapacity;
+constexpr size_t ProcResponseStreamBuf::sChunkSize;
+
+//------------------------------------------------------------------------------
+// Change the capacity
+//------------------------------------------------------------------------------
+void
+ProcResponseStream::SetCapacity(size_t capacity)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCapacity = capacity;
+  mCvWrite.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Mark the start of the streaming
+//------------------------------------------------------------------------------
+void
+ProcResponseStream::Open()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mOpen = true;
+}
+
+//------------------------------------------------------------------------------
+// Check if the producer started streaming
+//------------------------------------------------------------------------------
+bool
+ProcResponseStream::IsOpen() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mOpen;
+}
+
+//------------------------------------------------------------------------------
+// Append data, blocking while the channel is full
+//------------------------------------------------------------------------------
+bool
+ProcResponseStream::Write(const char* data, size_t len)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  // A chunk bigger than the capacity is accepted once the channel is empty
+  mCvWrite.wait(lock, [&]() {
+    return mCancelled || mClosed || (mCapacity == 0) || (mBuffered == 0) ||
+           (mBuffered + len <= mCapacity);
+  });
+
+  if (mCancelled || mClosed) {
+    return false;
+  }
+
+  if (len) {
+    mChunks.emplace_back(data, len);
+    mBuffered += len;
+    mCvRead.notify_all();
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Mark the end of the data
+//------------------------------------------------------------------------------
+void
+ProcResponseStream::Close()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mClosed = true;
+  mCvRead.notify_all();
+  mCvWrite.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Read the data available, waiting at most the given timeout for some
+//------------------------------------------------------------------------------
+size_t
+ProcResponseStream::Read(char* buff, size_t len,
+                         std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCvRead.wait_for(lock, timeout, [&]() {
+    return mCancelled || mClosed || mBuffered;
+  });
+
+  if (mCancelled) {
+    return 0;
+  }
+
+  size_t cpy_len = 0;
+
+  while ((cpy_len < len) && !mChunks.empty()) {
+    const std::string& chunk = mChunks.front();
+    size_t sz = std::min(len - cpy_len, chunk.size() - mHeadOffset);
+    memcpy(buff + cpy_len, chunk.data() + mHeadOffset, sz);
+    cpy_len += sz;
+    mHeadOffset += sz;
+
+    if (mHeadOffset == chunk.size()) {
+      mChunks.pop_front();
+      mHeadOffset = 0;
+    }
+  }
+
+  mBuffered -= cpy_len;
+
+  if (cpy_len) {
+    mCvWrite.notify_all();
+  }
+
+  return cpy_len;
+}
+
+//------------------------------------------------------------------------------
+// Check if there is data to read or the end of the data was reached
+//------------------------------------------------------------------------------
+bool
+ProcResponseStream::HasData() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return (mCancelled || mClosed || mBuffered);
+}
+
+//------------------------------------------------------------------------------
+// Check if all data was consumed or the channel was cancelled
+//------------------------------------------------------------------------------
+bool
+ProcResponseStream::IsFinished() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return (mCancelled || (mClosed && (mBuffered == 0)));
+}
+
+//------------------------------------------------------------------------------
+// Drop buffered data and make all further writes fail
+//------------------------------------------------------------------------------
+void
+ProcResponseStream::Cancel()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mCancelled = true;
+  mChunks.clear();
+  mHeadOffset = 0;
+  mBuffered = 0;
+  mCvRead.notify_all();
+  mCvWrite.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Check if the channel was cancelled
+//------------------------------------------------------------------------------
+bool
+ProcResponseStream::IsCancelled() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mCancelled;
+}
+
+//------------------------------------------------------------------------------
+// Get number of buffered bytes
+//------------------------------------------------------------------------------
+size_t
+ProcResponseStream::GetBufferedSize() const
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  return mBuffered;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ProcResponseStreamBuf::ProcResponseStreamBuf(ProcResponseStream& channel):
+  mChannel(channel), mBuffer(sChunkSize)
+{
+  setp(mBuffer.data(), mBuffer.data() + mBuffer.size());
+}
+
+//------------------------------------------------------------------------------
+// Push the pending data into the channel
+//------------------------------------------------------------------------------
+bool
+ProcResponseStreamBuf::Flush()
+{
+  size_t len = pptr() - pbase();
+  setp(mBuffer.data(), mBuffer.data() + mBuffer.size());
+
+  if (len == 0) {
+    return !mChannel.IsCancelled();
+  }
+
+  return mChannel.Write(mBuffer.data(), len);
+}
+
+//------------------------------------------------------------------------------
+// Put area is full
+//------------------------------------------------------------------------------
+ProcResponseStreamBuf::int_type
+ProcResponseStreamBuf::overflow(int_type ch)
+{
+  if (!Flush()) {
+    return traits_type::eof();
+  }
+
+  if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+  }
+
+  return traits_type::not_eof(ch);
+}
+
+//------------------------------------------------------------------------------
+// Flush the put area
+//------------------------------------------------------------------------------
+int
+ProcResponseStreamBuf::sync()
+{
+  return (Flush() ? 0 : -1);
+}
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+//! @file ProcResponseStream.hh
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class ProcResponseStream - bounded channel of bytes between a proc command
+//! producing its output and the client reading it through XrdMgmOfsFile::read.
+//!
+//! The producer blocks once the given number of bytes is buffered and resumes
+//! as the client drains the channel, therefore the memory used by a command
+//! is bounded independently of the size of its output. Once the consumer
+//! cancels the channel all further writes fail immediately.
+//------------------------------------------------------------------------------
+class ProcResponseStream
+{
+public:
+  //! Default maximum number of buffered bytes
+  static constexpr size_t sDefaultCapacity = 4 * 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param capacity max number of buffered bytes, 0 means unbounded
+  //----------------------------------------------------------------------------
+  ProcResponseStream(size_t capacity = sDefaultCapacity):
+    mCapacity(capacity)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Change the capacity, 0 means unbounded. Used when there is no separate
+  //! consumer thread which could drain the channel.
+  //----------------------------------------------------------------------------
+  void SetCapacity(size_t capacity);
+
+  //----------------------------------------------------------------------------
+  //! Mark the start of the streaming, called by the producer
+  //----------------------------------------------------------------------------
+  void Open();
+
+  //----------------------------------------------------------------------------
+  //! Check if the producer started streaming
+  //----------------------------------------------------------------------------
+  bool IsOpen() const;
+
+  //----------------------------------------------------------------------------
+  //! Append data, blocking while the channel is full
+  //!
+  //! @return true if successful, false if the channel was cancelled or closed
+  //----------------------------------------------------------------------------
+  bool Write(const char* data, size_t len);
+
+  //----------------------------------------------------------------------------
+  //! Mark the end of the data, called by the producer
+  //----------------------------------------------------------------------------
+  void Close();
+
+  //----------------------------------------------------------------------------
+  //! Read the data available, waiting at most the given timeout for some to
+  //! be produced. Returns as soon as there is any data, without waiting for
+  //! the output buffer to be filled.
+  //!
+  //! @param buff output buffer
+  //! @param len size of the output buffer
+  //! @param timeout max time to wait for data
+  //!
+  //! @return number of bytes read, 0 if no data was produced within the
+  //!         timeout or once all data was consumed - see IsFinished
+  //----------------------------------------------------------------------------
+  size_t Read(char* buff, size_t len, std::chrono::milliseconds timeout);
+
+  //----------------------------------------------------------------------------
+  //! Check if there is data to read or the end of the data was reached
+  //----------------------------------------------------------------------------
+  bool HasData() const;
+
+  //----------------------------------------------------------------------------
+  //! Check if all data was consumed or the channel was cancelled
+  //----------------------------------------------------------------------------
+  bool IsFinished() const;
+
+  //----------------------------------------------------------------------------
+  //! Drop buffered data and make all further writes fail, called by the
+  //! consumer when it is no longer interested in the output
+  //----------------------------------------------------------------------------
+  void Cancel();
+
+  //----------------------------------------------------------------------------
+  //! Check if the channel was cancelled
+  //----------------------------------------------------------------------------
+  bool IsCancelled() const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of buffered bytes
+  //----------------------------------------------------------------------------
+  size_t GetBufferedSize() const;
+
+private:
+  mutable std::mutex mMutex;
+  std::condition_variable mCvRead; ///< Notified when data is available
+  std::condition_variable mCvWrite; ///< Notified when space is available
+  std::deque<std::string> mChunks; ///< Buffered chunks
+  size_t mHeadOffset {0}; ///< Bytes already consumed from the first chunk
+  size_t mBuffered {0}; ///< Number of buffered bytes
+  size_t mCapacity; ///< Max number of buffered bytes, 0 if unbounded
+  bool mOpen {false};
+  bool mClosed {false};
+  bool mCancelled {false};
+};
+
+//------------------------------------------------------------------------------
+//! Class ProcResponseStreamBuf - std::streambuf adapter batching the output
+//! of a std::ostream into chunks written to a ProcResponseStream. Once the
+//! channel is cancelled the stream goes into a bad state.
+//------------------------------------------------------------------------------
+class ProcResponseStreamBuf: public std::streambuf
+{
+public:
+  //! Size of the chunks pushed into the channel
+  static constexpr size_t sChunkSize = 64 * 1024;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  ProcResponseStreamBuf(ProcResponseStream& channel);
+
+protected:
+  int_type overflow(int_type ch) override;
+  int sync() override;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Push the pending data into the channel
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Flush();
+
+  ProcResponseStream& mChannel;
+  std::vector<char> mBuffer;
+};
+
+EOSMGMNAMESPACE_END
@@ -352,6 +352,14 @@ NsCmd::StatSubcmd(const eos::console::NsProto_StatProto& stat,
         << std::endl
         << "uid=all gid=all ns.cache.containers.occupancy=" <<
         containerCacheStats.occupancy << std::endl
+        << "uid=all gid=all ns.cache.files.hits=" << fileCacheStats.hits
+        << std::endl
+        << "uid=all gid=all ns.cache.files.misses=" << fileCacheStats.misses
+        << std::endl
+        << "uid=all gid=all ns.cache.containers.hits=" << containerCacheStats.hits
+        << std::endl
+        << "uid=all gid=all ns.cache.containers.misses="
+        << containerCacheStats.misses << std::endl
         << "uid=all gid=all ns.total.files.changelog.size="
         << StringConversion::GetSizeString(clfsize, (unsigned long long) statf.st_size)
         << std::endl
@@ -532,6 +532,9 @@ ProcCommand::Space()
                   (key == "drainer.node.nfs") ||
                   (key == "drainer.retries") ||
                   (key == "drainer.fs.ntx") ||
+                  (key == "drainer.node.maxbw") ||
+                  (key == "drainer.group.maxbw") ||
+                  (key == "drainer.link.maxbw") ||
                   (key == "converter") ||
                   (key == "tracker") ||
                   (key == "inspector") ||
@@ -712,6 +712,9 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
             (key == "drainer.node.nfs") ||
             (key == "drainer.retries") ||
             (key == "drainer.fs.ntx") ||
+            (key == "drainer.node.maxbw") ||
+            (key == "drainer.group.maxbw") ||
+            (key == "drainer.link.maxbw") ||
             (key == "converter") ||
             (key == "tracker") ||
             (key == "inspector") ||
@@ -721,6 +724,8 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
             (key == "wfe") ||
             (key == "wfe.interval") ||
             (key == "wfe.ntx") ||
+            (key == "wfe.queue") ||
+            (key.compare(0, 8, "wfe.ntx.") == 0) ||
             (key == "converter.ntx") ||
             (key == "groupbalancer") ||
             (key == "groupbalancer.ntx") ||
@@ -878,6 +883,22 @@ void SpaceCmd::ConfigSubcmd(const eos::console::SpaceProto_ConfigProto& config,
                 std_out << "success: wfe is " << status << "!";
               }
             }
+          } else if (key == "wfe.queue") {
+            applied = true;
+
+            if ((value != "ns") && (value != "qdb")) {
+              ret_c = EINVAL;
+              std_err.str("error: value has to either ns or qdb");
+            } else {
+              if (!FsView::gFsView.mSpaceView[config.mgmspace_name()]->SetConfigMember(key,
+                  value)) {
+                ret_c = EIO;
+                std_err.str("error: cannot set space config value");
+              } else {
+                std_out << "success: wfe jobs are queued in "
+                        << ((value == "qdb") ? "QuarkDB" : "the namespace") << "!";
+              }
+            }
           } else {
             errno = 0;
             unsigned long long size = eos::common::StringConversion::GetSizeFromString(
@@ -264,7 +264,7 @@ static bool hasStripeDiff(std::shared_ptr<eos::IFileMD>& fmd) {
 //------------------------------------------------------------------------------
 // Print path.
 //------------------------------------------------------------------------------
-static void printPath(std::ofstream& ss, const std::string& path,
+static void printPath(std::ostream& ss, const std::string& path,
                       bool url)
 {
   if (url) {
@@ -278,7 +278,7 @@ static void printPath(std::ofstream& ss, const std::string& path,
 // Print uid / gid of a FileMD or ContainerMD, if requested by req.
 //------------------------------------------------------------------------------
 template<typename T>
-static void printUidGid(std::ofstream& ss, const eos::console::FindProto& req,
+static void printUidGid(std::ostream& ss, const eos::console::FindProto& req,
                         const T& md)
 {
   ss << "\t";
@@ -294,7 +294,7 @@ static void printUidGid(std::ofstream& ss, const eos::console::FindProto& req,
 
 
 template<typename T>
-static void printAttributes(std::ofstream& ss,
+static void printAttributes(std::ostream& ss,
                 const eos::console::FindProto& req, const T& md) {
 
   if (!req.printkey().empty()) {
@@ -310,7 +310,7 @@ static void printAttributes(std::ofstream& ss,
 //------------------------------------------------------------------------------
 // Print directories and files count of a ContainerMD, if requested by req.
 //------------------------------------------------------------------------------
-//static void printChildCount(std::ofstream& ss, const eos::console::FindProto& req,
+//static void printChildCount(std::ostream& ss, const eos::console::FindProto& req,
 //                            const std::shared_ptr<eos::IContainerMD>& cmd)
 //{
 //  if (req.childcount()) {
@@ -325,7 +325,7 @@ static void printAttributes(std::ofstream& ss,
 //------------------------------------------------------------------------------
 // Print hex checksum of given fmd, if requested by req.
 //------------------------------------------------------------------------------
-static void printChecksum(std::ofstream& ss, const eos::console::FindProto& req,
+static void printChecksum(std::ostream& ss, const eos::console::FindProto& req,
                           const std::shared_ptr<eos::IFileMD>& fmd)
 {
   if (req.checksum()) {
@@ -339,7 +339,7 @@ static void printChecksum(std::ofstream& ss, const eos::console::FindProto& req,
 //------------------------------------------------------------------------------
 // Print replica location of an fmd.
 //------------------------------------------------------------------------------
-static void printReplicas(std::ofstream& ss,
+static void printReplicas(std::ostream& ss,
                           const std::shared_ptr<eos::IFileMD>& fmd, bool onlyhost, bool selectonline)
 {
   if (onlyhost) {
@@ -394,7 +394,7 @@ static void printReplicas(std::ofstream& ss,
 //------------------------------------------------------------------------------
 // Print fs of a FileMD.
 //------------------------------------------------------------------------------
-static void printFs(std::ofstream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
+static void printFs(std::ostream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
 {
   ss << " fsid=";
   eos::IFileMD::LocationVector loc_vect = fmd->getLocations();
@@ -412,7 +412,7 @@ static void printFs(std::ofstream& ss, const std::shared_ptr<eos::IFileMD>& fmd)
 //------------------------------------------------------------------------------
 // Print a selected FileMD, according to formatting settings in req.
 //------------------------------------------------------------------------------
-static void printFMD(std::ofstream& ss, const eos::console::FindProto& req,
+static void printFMD(std::ostream& ss, const eos::console::FindProto& req,
                      const std::shared_ptr<eos::IFileMD>& fmd)
 {
   if (req.size()) {
@@ -472,7 +472,7 @@ static void printFMD(std::ofstream& ss, const eos::console::FindProto& req,
 // Purge atomic files
 //------------------------------------------------------------------------------
 void
-NewfindCmd::ProcessAtomicFilePurge(std::ofstream& ss,
+NewfindCmd::ProcessAtomicFilePurge(std::ostream& ss,
                                      const std::string& fspath,
                                      eos::IFileMD& fmd)
 {
@@ -517,7 +517,7 @@ NewfindCmd::ProcessAtomicFilePurge(std::ofstream& ss,
 // Purge version directory.
 //------------------------------------------------------------------------------
 void
-NewfindCmd::PurgeVersions(std::ofstream& ss, int64_t maxVersion,
+NewfindCmd::PurgeVersions(std::ostream& ss, int64_t maxVersion,
                           const std::string& dirpath)
 {
   if (dirpath.find(EOS_COMMON_PATH_VERSION_PREFIX) == std::string::npos) {
@@ -541,7 +541,7 @@ NewfindCmd::PurgeVersions(std::ofstream& ss, int64_t maxVersion,
 // Modify layout stripes
 //------------------------------------------------------------------------------
 void
-NewfindCmd::ModifyLayoutStripes(std::ofstream& ss,
+NewfindCmd::ModifyLayoutStripes(std::ostream& ss,
                                        const eos::console::FindProto& req,
                                        const std::string& fspath)
 {
@@ -670,6 +670,7 @@ public:
       options.depthLimit = depthlimit;
       options.expansionDecider.reset(new TraversalFilter(vid));
       options.ignoreFiles = ignore_files;
+      options.parallelism = ExplorationOptions::sDefaultParallelism;
       explorer.reset(new NamespaceExplorer(path, options, *qcl,
                                            static_cast<QuarkNamespaceGroup*>(gOFS->namespaceGroup.get())->getExecutor()));
     }
@@ -819,9 +820,9 @@ NewfindCmd::ProcessRequest() noexcept
   XrdOucString m_err {""};
   eos::console::ReplyProto reply;
 
-  if (!OpenTemporaryOutputFiles()) {
+  if (!OpenStreamingOutput()) {
     reply.set_retc(EIO);
-    reply.set_std_err(SSTR("error: cannot write find result files on MGM" << std::endl));
+    reply.set_std_err(SSTR("error: cannot stream find results from MGM" << std::endl));
     return reply;
   }
 
@@ -902,9 +903,9 @@ NewfindCmd::ProcessRequest() noexcept
         eos_static_info("caught exception %d %s with newfind findRequest.name()=%s\n", e.code(), e.what(), findRequest.name().c_str());
         ofstderrStream << "error(caught exception " << e.code() << ' ' << e.what() << " with newfind --name=" << findRequest.name()
                        << ").\nPlease note that --name filters by 'egrep' style regex match, you may have to sanitize your input\n";
-        if (!CloseTemporaryOutputFiles()) {
+        if (!CloseStreamingOutput()) {
           reply.set_retc(EIO);
-          reply.set_std_err("error: cannot save find result files on MGM\n");
+          reply.set_std_err("error: cannot stream find results from MGM\n");
           return reply;
         } else {
           return reply;
@@ -940,6 +941,11 @@ NewfindCmd::ProcessRequest() noexcept
   std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
 
   while (findResultProvider->next(findResult)) {
+    // Client is gone, nobody is reading the results any more
+    if (mForceKill || IsStreamingCancelled()) {
+      reply.set_retc(ECANCELED);
+      break;
+    }
 
     if (limit_result) {
       if (dircounter >= dir_limit || filecounter >= file_limit) {
@@ -1089,9 +1095,9 @@ NewfindCmd::ProcessRequest() noexcept
     balanceCalculator.printSummary(ofstdoutStream);
   }
 
-  if (!CloseTemporaryOutputFiles()) {
+  if (!CloseStreamingOutput()) {
     reply.set_retc(EIO);
-    reply.set_std_err("error: cannot save find result files on MGM\n");
+    reply.set_std_err("error: cannot stream find results from MGM\n");
     return reply;
   }
 
@@ -44,12 +44,23 @@ public:
   //----------------------------------------------------------------------------
   explicit NewfindCmd(eos::console::RequestProto&& req,
                    eos::common::VirtualIdentity& vid):
-  IProcCommand(std::move(req), vid, false)
+  IProcCommand(std::move(req), vid, true)
   {}
   //----------------------------------------------------------------------------
-  //! Destructor
+  //! Destructor - the streaming job still uses this object
   //----------------------------------------------------------------------------
-  ~NewfindCmd() override = default;
+  ~NewfindCmd() override
+  {
+    StopStreamingJob();
+  }
+
+  //----------------------------------------------------------------------------
+  //! The results are streamed to the client while the traversal runs
+  //----------------------------------------------------------------------------
+  bool IsStreaming() const override
+  {
+    return true;
+  }
 
 
   //----------------------------------------------------------------------------
@@ -60,13 +71,13 @@ public:
 
 private:
   void PrintFileInfoMinusM(const std::string& path, XrdOucErrInfo& errInfo);
-  void ProcessAtomicFilePurge(std::ofstream& ss, const std::string& fspath,
+  void ProcessAtomicFilePurge(std::ostream& ss, const std::string& fspath,
                               eos::IFileMD& fmd);
 
-  void ModifyLayoutStripes(std::ofstream& ss,
+  void ModifyLayoutStripes(std::ostream& ss,
                            const eos::console::FindProto& req, const std::string& fspath);
 
-  void PurgeVersions(std::ofstream& ss, int64_t maxVersion,
+  void PurgeVersions(std::ostream& ss, int64_t maxVersion,
                      const std::string& dirpath);
 
 };
@@ -0,0 +1,478 @@
+//------------------------------------------------------------------------------
+// File: WFEJobQueue.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/wfe/WFEJobQueue.hh"
+#include "common/Logging.hh"
+#include <algorithm>
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+constexpr std::chrono::seconds WFEJobQueue::cMaxWait;
+constexpr unsigned int WFEJobQueue::cMaxThreads;
+constexpr std::chrono::seconds WFEJobQueue::cUnfinishedBackoff;
+constexpr std::chrono::seconds WFEJobQueue::cMaxUnfinishedBackoff;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+WFEJobQueue::WFEJobQueue(std::unique_ptr<IWFEJobStore> store,
+                         DispatchFn dispatch, unsigned int max_running):
+  mStore(std::move(store)), mDispatch(std::move(dispatch)),
+  mMaxRunning(max_running ? std::min(max_running, cMaxThreads) : cMaxThreads),
+  mThreadPool(std::min(mMaxRunning,
+                       std::max(1u, std::thread::hardware_concurrency())),
+              cMaxThreads, 10, 5, 3, "wfe")
+{}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+WFEJobQueue::~WFEJobQueue()
+{
+  Deactivate();
+  mThreadPool.Stop();
+}
+
+//------------------------------------------------------------------------------
+// Load the pending jobs from the store and start dispatching
+//------------------------------------------------------------------------------
+bool
+WFEJobQueue::Activate()
+{
+  if (mActive) {
+    return true;
+  }
+
+  std::map<std::string, std::string> pending;
+
+  if (!mStore->GetPending(pending)) {
+    eos_static_err("%s", "msg=\"failed to load pending workflow jobs\"");
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const time_t now = time(nullptr);
+
+    for (const auto& elem : pending) {
+      WFEJobRecord rec;
+
+      if (!rec.Deserialize(elem.second) || (rec.GetKey() != elem.first)) {
+        eos_static_err("msg=\"skip malformed workflow job\" key=\"%s\"",
+                       elem.first.c_str());
+        continue;
+      }
+
+      if (mJobs.emplace(elem.first, rec).second) {
+        Enqueue(rec, now);
+      }
+    }
+
+    eos_static_info("msg=\"activate workflow job queue\" pending=%zu",
+                    mJobs.size());
+  }
+
+  mActive = true;
+  mThread.reset(&WFEJobQueue::Schedule, this);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Stop dispatching and drop the in-memory state
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::Deactivate()
+{
+  mThread.join();
+
+  if (mActive) {
+    mActive = false;
+    // Jobs still running are kept in mRunningKeys so that they are not
+    // dispatched a second time after a quick re-activation
+    std::lock_guard<std::mutex> lock(mMutex);
+    mJobs.clear();
+    mDelayed.clear();
+    mReady.clear();
+    mUnfinished.clear();
+    eos_static_info("%s", "msg=\"deactivate workflow job queue\"");
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add new job
+//------------------------------------------------------------------------------
+bool
+WFEJobQueue::Push(WFEJobRecord rec)
+{
+  const time_t now = time(nullptr);
+
+  if (rec.mCtime == 0) {
+    rec.mCtime = now;
+  }
+
+  if (rec.mTime == 0) {
+    rec.mTime = rec.mCtime;
+  }
+
+  const std::string key = rec.GetKey();
+  {
+    // Reserve the key so that the job is not stored twice, it's only handed
+    // to the scheduler once it's durable
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    if (!mJobs.emplace(key, rec).second) {
+      return true;
+    }
+  }
+  bool stored = mStore->PutPending(key, rec.Serialize());
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (!stored) {
+    mJobs.erase(key);
+    return false;
+  }
+
+  Enqueue(rec, now);
+  mCv.notify_all();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Reschedule job at the due time of the record
+//------------------------------------------------------------------------------
+bool
+WFEJobQueue::Retry(const WFEJobRecord& rec)
+{
+  const std::string key = rec.GetKey();
+
+  if (!mStore->PutPending(key, rec.Serialize())) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  mJobs[key] = rec;
+  mUnfinished.erase(key);
+  Enqueue(rec, time(nullptr));
+  mCv.notify_all();
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Mark job as failed
+//------------------------------------------------------------------------------
+bool
+WFEJobQueue::Fail(const WFEJobRecord& rec)
+{
+  const std::string key = rec.GetKey();
+  bool retc = mStore->PutFailed(key, rec.Serialize());
+  retc = mStore->RemovePending(key) && retc;
+  std::lock_guard<std::mutex> lock(mMutex);
+  mJobs.erase(key);
+  mUnfinished.erase(key);
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Mark job as successfully done
+//------------------------------------------------------------------------------
+bool
+WFEJobQueue::Done(const std::string& key)
+{
+  bool retc = mStore->RemovePending(key);
+  std::lock_guard<std::mutex> lock(mMutex);
+  mJobs.erase(key);
+  mUnfinished.erase(key);
+  return retc;
+}
+
+//------------------------------------------------------------------------------
+// Drop the failed jobs due before the given time
+//------------------------------------------------------------------------------
+size_t
+WFEJobQueue::PurgeFailed(time_t older_than)
+{
+  size_t count = 0;
+  std::map<std::string, std::string> failed;
+
+  if (!mStore->GetFailed(failed)) {
+    return count;
+  }
+
+  for (const auto& elem : failed) {
+    WFEJobRecord rec;
+
+    if (!rec.Deserialize(elem.second) || (rec.mTime < older_than)) {
+      if (mStore->RemoveFailed(elem.first)) {
+        ++count;
+      }
+    }
+  }
+
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Set max number of jobs running at the same time
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::SetMaxRunning(unsigned int max)
+{
+  max = (max ? std::min(max, cMaxThreads) : cMaxThreads);
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (mMaxRunning != max) {
+    mMaxRunning = max;
+    mThreadPool.SetMaxThreads(max);
+    mCv.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Set max number of jobs of the given workflow running at the same time
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::SetWorkflowLimit(const std::string& workflow, unsigned int max)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (max == 0) {
+    mWorkflowLimits.erase(workflow);
+  } else {
+    mWorkflowLimits[workflow] = max;
+  }
+
+  mCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Set the delay before running again a job left unfinished the first time
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::SetUnfinishedBackoff(std::chrono::seconds backoff)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mUnfinishedBackoff = std::max(backoff, std::chrono::seconds(1));
+}
+
+//------------------------------------------------------------------------------
+// Get number of pending jobs
+//------------------------------------------------------------------------------
+size_t
+WFEJobQueue::GetNumPending() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mJobs.size();
+}
+
+//------------------------------------------------------------------------------
+// Get number of running jobs
+//------------------------------------------------------------------------------
+size_t
+WFEJobQueue::GetNumRunning() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mRunningKeys.size();
+}
+
+//------------------------------------------------------------------------------
+// Get number of running jobs of the given workflow
+//------------------------------------------------------------------------------
+size_t
+WFEJobQueue::GetNumRunning(const std::string& workflow) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto it = mRunningPerWorkflow.find(workflow);
+  return ((it == mRunningPerWorkflow.end()) ? 0 : it->second);
+}
+
+//------------------------------------------------------------------------------
+// Add job to the in-memory queues
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::Enqueue(const WFEJobRecord& rec, time_t now)
+{
+  if (rec.mTime <= now) {
+    mReady[rec.mWorkflow].push_back(rec.GetKey());
+  } else {
+    mDelayed.emplace(rec.mTime, rec.GetKey());
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get max number of running jobs of the given workflow
+//------------------------------------------------------------------------------
+unsigned int
+WFEJobQueue::GetLimit(const std::string& workflow) const
+{
+  auto it = mWorkflowLimits.find(workflow);
+
+  if (it == mWorkflowLimits.end()) {
+    return mMaxRunning;
+  }
+
+  return std::min(it->second, mMaxRunning);
+}
+
+//------------------------------------------------------------------------------
+// Dispatch the ready jobs within the limits
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::DispatchReady(time_t now)
+{
+  // Move the due jobs to the ready queues. An entry is stale if the job is
+  // gone or was rescheduled in the meantime.
+  auto end = mDelayed.upper_bound(now);
+
+  for (auto it = mDelayed.begin(); it != end; ++it) {
+    auto jt = mJobs.find(it->second);
+
+    if ((jt != mJobs.end()) && (jt->second.mTime <= now)) {
+      mReady[jt->second.mWorkflow].push_back(it->second);
+    }
+  }
+
+  mDelayed.erase(mDelayed.begin(), end);
+  bool progress = true;
+
+  // Take one job per workflow and pass, starting after the workflow which
+  // got the last slot
+  while (progress && !mReady.empty() && (mRunningKeys.size() < mMaxRunning)) {
+    progress = false;
+    std::vector<std::string> workflows;
+    workflows.reserve(mReady.size());
+    auto start = mReady.upper_bound(mLastWorkflow);
+
+    for (auto it = start; it != mReady.end(); ++it) {
+      workflows.push_back(it->first);
+    }
+
+    for (auto it = mReady.begin(); it != start; ++it) {
+      workflows.push_back(it->first);
+    }
+
+    for (const auto& workflow : workflows) {
+      if (mRunningKeys.size() >= mMaxRunning) {
+        break;
+      }
+
+      if (mRunningPerWorkflow[workflow] >= GetLimit(workflow)) {
+        continue;
+      }
+
+      auto& ready = mReady[workflow];
+
+      while (!ready.empty()) {
+        const std::string key = ready.front();
+        ready.pop_front();
+        auto jt = mJobs.find(key);
+
+        if ((jt == mJobs.end()) || (jt->second.mTime > now)) {
+          continue;
+        }
+
+        if (mRunningKeys.count(key)) {
+          // Previous run of the job did not return yet
+          mDelayed.emplace(now + 1, key);
+          continue;
+        }
+
+        mRunningKeys.insert(key);
+        ++mRunningPerWorkflow[workflow];
+        mLastWorkflow = workflow;
+        progress = true;
+        const WFEJobRecord rec = jt->second;
+        mThreadPool.PushTask<void>([this, rec]() {
+          Run(rec);
+        });
+        break;
+      }
+
+      if (ready.empty()) {
+        mReady.erase(workflow);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Run job and release its slot afterwards
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::Run(const WFEJobRecord& rec)
+{
+  try {
+    mDispatch(rec);
+  } catch (const std::exception& e) {
+    eos_static_err("msg=\"workflow job threw an exception\" key=\"%s\" "
+                   "emsg=\"%s\"", rec.GetKey().c_str(), e.what());
+  }
+
+  const std::string key = rec.GetKey();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mRunningKeys.erase(key);
+  auto it = mRunningPerWorkflow.find(rec.mWorkflow);
+
+  if ((it != mRunningPerWorkflow.end()) && (--it->second == 0)) {
+    mRunningPerWorkflow.erase(it);
+  }
+
+  auto jt = mJobs.find(key);
+
+  if ((jt != mJobs.end()) && (jt->second.mRetry == rec.mRetry) &&
+      (jt->second.mTime == rec.mTime)) {
+    // Neither done, failed nor rescheduled - run it again later, backing off
+    // while it keeps on returning unfinished
+    unsigned int& attempts = mUnfinished[key];
+    const int factor = (1 << std::min(attempts, 16u));
+    const std::chrono::seconds delay = std::min(cMaxUnfinishedBackoff,
+                                       mUnfinishedBackoff * factor);
+    ++attempts;
+    jt->second.mTime = time(nullptr) + delay.count();
+    mDelayed.emplace(jt->second.mTime, key);
+    eos_static_warning("msg=\"workflow job not finished, run it again later\" "
+                       "key=\"%s\" delay_sec=%lld", key.c_str(),
+                       (long long) delay.count());
+  }
+
+  mCv.notify_all();
+}
+
+//------------------------------------------------------------------------------
+// Scheduler thread
+//------------------------------------------------------------------------------
+void
+WFEJobQueue::Schedule(ThreadAssistant& assistant) noexcept
+{
+  assistant.registerCallback([this]() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCv.notify_all();
+  });
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  while (!assistant.terminationRequested()) {
+    DispatchReady(time(nullptr));
+    mCv.wait_for(lock, cMaxWait);
+  }
+}
+
+EOSMGMNAMESPACE_END
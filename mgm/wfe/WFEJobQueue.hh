@@ -0,0 +1,248 @@
+//------------------------------------------------------------------------------
+//! @file WFEJobQueue.hh
+//! @brief Durable queue of workflow engine jobs
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include "mgm/wfe/WFEJobStore.hh"
+#include "common/AssistedThread.hh"
+#include "common/ThreadPool.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Class WFEJobQueue
+//!
+//! Keeps the asynchronous workflow jobs in a durable store instead of the
+//! proc namespace and dispatches them to a thread pool. Every job is stored
+//! once when it is pushed and removed once when it is done, so that the
+//! engine neither creates, moves or deletes namespace entries per job nor
+//! crawls the queue directories to find the jobs to run. Jobs which are not
+//! due yet (retries) wait in a delay queue ordered by time. The number of
+//! running jobs is limited globally and optionally per workflow, the ready
+//! jobs of the different workflows being dispatched round-robin.
+//!
+//! A dispatched job has to be finished with Done, Retry or Fail. A job which
+//! is not finished when its dispatch function returns stays in the store and
+//! is run again after a delay which doubles with every unfinished run.
+//------------------------------------------------------------------------------
+class WFEJobQueue
+{
+public:
+  //! Function running a job
+  using DispatchFn = std::function<void(const WFEJobRecord&)>;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param store durable job store
+  //! @param dispatch function running a job
+  //! @param max_running max number of jobs running at the same time, 0 means
+  //!        only limited by the size of the thread pool
+  //----------------------------------------------------------------------------
+  WFEJobQueue(std::unique_ptr<IWFEJobStore> store, DispatchFn dispatch,
+              unsigned int max_running = 0);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~WFEJobQueue();
+
+  //----------------------------------------------------------------------------
+  //! Load the pending jobs from the store and start dispatching
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Activate();
+
+  //----------------------------------------------------------------------------
+  //! Stop dispatching and drop the in-memory state, the jobs already running
+  //! are not interrupted
+  //----------------------------------------------------------------------------
+  void Deactivate();
+
+  //----------------------------------------------------------------------------
+  //! Check if the queue is dispatching jobs
+  //----------------------------------------------------------------------------
+  inline bool IsActive() const
+  {
+    return mActive;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Add new job, if the creation time is not set it's set to the current
+  //! time. A job with the same key as a known one is ignored.
+  //!
+  //! @param rec job record
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Push(WFEJobRecord rec);
+
+  //----------------------------------------------------------------------------
+  //! Reschedule job at the due time of the record
+  //!
+  //! @param rec job record with updated retry count and due time
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Retry(const WFEJobRecord& rec);
+
+  //----------------------------------------------------------------------------
+  //! Mark job as failed, it's kept in the store of failed jobs
+  //!
+  //! @param rec job record with return code and log
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Fail(const WFEJobRecord& rec);
+
+  //----------------------------------------------------------------------------
+  //! Mark job as successfully done
+  //!
+  //! @param key job key
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Done(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Drop the failed jobs due before the given time
+  //!
+  //! @param older_than timestamp
+  //!
+  //! @return number of dropped jobs
+  //----------------------------------------------------------------------------
+  size_t PurgeFailed(time_t older_than);
+
+  //----------------------------------------------------------------------------
+  //! Set max number of jobs running at the same time, 0 means only limited
+  //! by the size of the thread pool
+  //----------------------------------------------------------------------------
+  void SetMaxRunning(unsigned int max);
+
+  //----------------------------------------------------------------------------
+  //! Set max number of jobs of the given workflow running at the same time,
+  //! 0 removes the limit of the workflow
+  //----------------------------------------------------------------------------
+  void SetWorkflowLimit(const std::string& workflow, unsigned int max);
+
+  //----------------------------------------------------------------------------
+  //! Set the delay before running again a job left unfinished the first time
+  //----------------------------------------------------------------------------
+  void SetUnfinishedBackoff(std::chrono::seconds backoff);
+
+  //----------------------------------------------------------------------------
+  //! Get number of pending jobs i.e. ready, delayed or running
+  //----------------------------------------------------------------------------
+  size_t GetNumPending() const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of running jobs
+  //----------------------------------------------------------------------------
+  size_t GetNumRunning() const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of running jobs of the given workflow
+  //----------------------------------------------------------------------------
+  size_t GetNumRunning(const std::string& workflow) const;
+
+private:
+  //! Max wait of the scheduler between two passes
+  static constexpr std::chrono::seconds cMaxWait {1};
+  //! Max number of threads of the pool
+  static constexpr unsigned int cMaxThreads {512};
+  //! Default delay before running again an unfinished job
+  static constexpr std::chrono::seconds cUnfinishedBackoff {10};
+  //! Max delay before running again an unfinished job
+  static constexpr std::chrono::seconds cMaxUnfinishedBackoff {600};
+
+  //----------------------------------------------------------------------------
+  //! Add job to the in-memory queues, requires the mutex
+  //!
+  //! @param rec job record
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void Enqueue(const WFEJobRecord& rec, time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Get max number of running jobs of the given workflow, requires the mutex
+  //----------------------------------------------------------------------------
+  unsigned int GetLimit(const std::string& workflow) const;
+
+  //----------------------------------------------------------------------------
+  //! Dispatch the ready jobs within the limits, requires the mutex
+  //!
+  //! @param now current time
+  //----------------------------------------------------------------------------
+  void DispatchReady(time_t now);
+
+  //----------------------------------------------------------------------------
+  //! Run job and release its slot afterwards
+  //!
+  //! @param rec job record
+  //----------------------------------------------------------------------------
+  void Run(const WFEJobRecord& rec);
+
+  //----------------------------------------------------------------------------
+  //! Scheduler thread moving due jobs to the ready queues and dispatching them
+  //----------------------------------------------------------------------------
+  void Schedule(ThreadAssistant& assistant) noexcept;
+
+  std::unique_ptr<IWFEJobStore> mStore; ///< Durable job store
+  DispatchFn mDispatch; ///< Function running a job
+  std::atomic<bool> mActive {false}; ///< Mark if the queue is dispatching
+  mutable std::mutex mMutex; ///< Mutex protecting the members below
+  std::condition_variable mCv; ///< Wakes up the scheduler
+  unsigned int mMaxRunning; ///< Max number of running jobs
+  //! Max number of running jobs per workflow
+  std::map<std::string, unsigned int> mWorkflowLimits;
+  //! Pending jobs indexed by key
+  std::map<std::string, WFEJobRecord> mJobs;
+  //! Keys of the jobs not due yet indexed by their due time
+  std::multimap<time_t, std::string> mDelayed;
+  //! Keys of the ready jobs per workflow
+  std::map<std::string, std::deque<std::string>> mReady;
+  //! Workflow of the last dispatched job used for the round-robin
+  std::string mLastWorkflow;
+  std::set<std::string> mRunningKeys; ///< Keys of the running jobs
+  //! Number of consecutive unfinished runs per job
+  std::map<std::string, unsigned int> mUnfinished;
+  //! Delay before running again a job left unfinished the first time
+  std::chrono::seconds mUnfinishedBackoff {cUnfinishedBackoff};
+  //! Number of running jobs per workflow
+  std::map<std::string, size_t> mRunningPerWorkflow;
+  eos::common::ThreadPool mThreadPool; ///< Pool running the jobs
+  AssistedThread mThread; ///< Scheduler thread
+};
+
+EOSMGMNAMESPACE_END
@@ -0,0 +1,287 @@
+//------------------------------------------------------------------------------
+// File: WFEJobStore.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mgm/wfe/WFEJobStore.hh"
+#include "common/Logging.hh"
+#include "namespace/ns_quarkdb/QdbContactDetails.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/QClient.hh"
+#include "namespace/ns_quarkdb/qclient/include/qclient/structures/QHash.hh"
+#include <vector>
+
+EOSMGMNAMESPACE_BEGIN
+
+namespace
+{
+//! Version tag of the serialized records
+const std::string kRecordVersion {"wfe1"};
+//! Batch size used when listing the QDB hashes
+const uint32_t kBatchSize {1000};
+
+//------------------------------------------------------------------------------
+// Append length-prefixed field
+//------------------------------------------------------------------------------
+void
+AppendField(std::string& out, const std::string& field)
+{
+  out += std::to_string(field.length());
+  out += ':';
+  out += field;
+}
+
+//------------------------------------------------------------------------------
+// Extract length-prefixed field starting at the given position
+//------------------------------------------------------------------------------
+bool
+ExtractField(const std::string& in, size_t& pos, std::string& field)
+{
+  size_t sep = in.find(':', pos);
+
+  if ((sep == std::string::npos) || (sep == pos)) {
+    return false;
+  }
+
+  size_t len = 0;
+
+  for (size_t i = pos; i < sep; ++i) {
+    if ((in[i] < '0') || (in[i] > '9')) {
+      return false;
+    }
+
+    len = len * 10 + (in[i] - '0');
+  }
+
+  if (sep + 1 + len > in.length()) {
+    return false;
+  }
+
+  field = in.substr(sep + 1, len);
+  pos = sep + 1 + len;
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+// Get unique key of the job
+//------------------------------------------------------------------------------
+std::string
+WFEJobRecord::GetKey() const
+{
+  char sfid[32];
+  snprintf(sfid, sizeof(sfid), "%016llx", (unsigned long long) mFid);
+  return std::to_string(mCtime) + ":" + sfid + ":" + mEvent + ":" + mWorkflow;
+}
+
+//------------------------------------------------------------------------------
+// Serialize the record
+//------------------------------------------------------------------------------
+std::string
+WFEJobRecord::Serialize() const
+{
+  std::string out;
+  AppendField(out, kRecordVersion);
+  AppendField(out, std::to_string(mFid));
+  AppendField(out, mEvent);
+  AppendField(out, mWorkflow);
+  AppendField(out, mAction);
+  AppendField(out, mVid);
+  AppendField(out, mErrorMessage);
+  AppendField(out, mLog);
+  AppendField(out, std::to_string(mCtime));
+  AppendField(out, std::to_string(mTime));
+  AppendField(out, std::to_string(mRetry));
+  AppendField(out, std::to_string(mRetc));
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Deserialize the record
+//------------------------------------------------------------------------------
+bool
+WFEJobRecord::Deserialize(const std::string& data)
+{
+  std::vector<std::string> fields;
+  std::string field;
+  size_t pos = 0;
+
+  while (pos < data.length()) {
+    if (!ExtractField(data, pos, field)) {
+      return false;
+    }
+
+    fields.push_back(field);
+  }
+
+  if ((fields.size() != 12) || (fields[0] != kRecordVersion)) {
+    return false;
+  }
+
+  try {
+    mFid = std::stoull(fields[1]);
+    mEvent = fields[2];
+    mWorkflow = fields[3];
+    mAction = fields[4];
+    mVid = fields[5];
+    mErrorMessage = fields[6];
+    mLog = fields[7];
+    mCtime = std::stoll(fields[8]);
+    mTime = std::stoll(fields[9]);
+    mRetry = std::stoi(fields[10]);
+    mRetc = std::stoi(fields[11]);
+  } catch (...) {
+    return false;
+  }
+
+  return true;
+}
+
+const std::string QdbWFEJobStore::sPendingKey {"eos-wfe-jobs-pending"};
+const std::string QdbWFEJobStore::sFailedKey {"eos-wfe-jobs-failed"};
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+QdbWFEJobStore::QdbWFEJobStore(const eos::QdbContactDetails& qdb_details)
+{
+  mQcl = std::make_unique<qclient::QClient>(qdb_details.members,
+         qdb_details.constructOptions());
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+QdbWFEJobStore::~QdbWFEJobStore() = default;
+
+//------------------------------------------------------------------------------
+// Add or update a pending job
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::PutPending(const std::string& key, const std::string& data)
+{
+  try {
+    qclient::QHash qhash(*mQcl, sPendingKey);
+    qhash.hset(key, data);
+    return true;
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to store pending workflow job\" key=\"%s\" "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Remove a pending job
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::RemovePending(const std::string& key)
+{
+  try {
+    qclient::QHash qhash(*mQcl, sPendingKey);
+    qhash.hdel(key);
+    return true;
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to remove pending workflow job\" key=\"%s\" "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get all pending jobs
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::GetPending(std::map<std::string, std::string>& jobs)
+{
+  return GetAll(sPendingKey, jobs);
+}
+
+//------------------------------------------------------------------------------
+// Add or update a failed job
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::PutFailed(const std::string& key, const std::string& data)
+{
+  try {
+    qclient::QHash qhash(*mQcl, sFailedKey);
+    qhash.hset(key, data);
+    return true;
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to store failed workflow job\" key=\"%s\" "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Remove a failed job
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::RemoveFailed(const std::string& key)
+{
+  try {
+    qclient::QHash qhash(*mQcl, sFailedKey);
+    qhash.hdel(key);
+    return true;
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to remove failed workflow job\" key=\"%s\" "
+                    "emsg=\"%s\"", key.c_str(), e.what());
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get all failed jobs
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::GetFailed(std::map<std::string, std::string>& jobs)
+{
+  return GetAll(sFailedKey, jobs);
+}
+
+//------------------------------------------------------------------------------
+// Get all the entries of a hash
+//------------------------------------------------------------------------------
+bool
+QdbWFEJobStore::GetAll(const std::string& hash_key,
+                       std::map<std::string, std::string>& jobs)
+{
+  jobs.clear();
+
+  try {
+    qclient::QHash qhash(*mQcl, hash_key);
+
+    for (auto it = qhash.getIterator(kBatchSize, "0"); it.valid(); it.next()) {
+      jobs.emplace(it.getKey(), it.getValue());
+    }
+  } catch (const std::exception& e) {
+    eos_static_crit("msg=\"failed to list workflow jobs\" key=%s emsg=\"%s\"",
+                    hash_key.c_str(), e.what());
+    return false;
+  }
+
+  return true;
+}
+
+EOSMGMNAMESPACE_END
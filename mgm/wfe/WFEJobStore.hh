@@ -0,0 +1,234 @@
+//------------------------------------------------------------------------------
+//! @file WFEJobStore.hh
+//! @brief Durable stores for the workflow engine jobs
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mgm/Namespace.hh"
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+//! Forward declarations
+namespace qclient
+{
+class QClient;
+}
+
+namespace eos
+{
+class QdbContactDetails;
+}
+
+EOSMGMNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Workflow job as kept by the job queue
+//------------------------------------------------------------------------------
+struct WFEJobRecord {
+  uint64_t mFid {0}; ///< File id
+  std::string mEvent; ///< Workflow event e.g. closew, prepare
+  std::string mWorkflow; ///< Workflow name
+  std::string mAction; ///< Workflow action e.g. bash:..., proto:...
+  std::string mVid; ///< Serialized virtual identity of the requestor
+  std::string mErrorMessage; ///< Error message of the triggering request
+  std::string mLog; ///< Result log of a failed job
+  time_t mCtime {0}; ///< Time when the job was created
+  time_t mTime {0}; ///< Time when the job is due
+  int mRetry {0}; ///< Number of retries done
+  int mRetc {0}; ///< Return code of a failed job
+
+  //----------------------------------------------------------------------------
+  //! Get unique key of the job, stays the same across retries
+  //----------------------------------------------------------------------------
+  std::string GetKey() const;
+
+  //----------------------------------------------------------------------------
+  //! Serialize the record
+  //----------------------------------------------------------------------------
+  std::string Serialize() const;
+
+  //----------------------------------------------------------------------------
+  //! Deserialize the record
+  //!
+  //! @param data serialized record
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool Deserialize(const std::string& data);
+};
+
+//------------------------------------------------------------------------------
+//! Interface of a durable store of workflow jobs. Jobs are kept in a pending
+//! set until they are done and failed jobs are moved to a failed set.
+//------------------------------------------------------------------------------
+class IWFEJobStore
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~IWFEJobStore() = default;
+
+  //----------------------------------------------------------------------------
+  //! Add or update a pending job
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool PutPending(const std::string& key, const std::string& data) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Remove a pending job
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool RemovePending(const std::string& key) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get all pending jobs
+  //!
+  //! @param jobs map of keys to serialized jobs
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool GetPending(std::map<std::string, std::string>& jobs) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Add or update a failed job
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool PutFailed(const std::string& key, const std::string& data) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Remove a failed job
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool RemoveFailed(const std::string& key) = 0;
+
+  //----------------------------------------------------------------------------
+  //! Get all failed jobs
+  //!
+  //! @param jobs map of keys to serialized jobs
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  virtual bool GetFailed(std::map<std::string, std::string>& jobs) = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Job store keeping the jobs in QuarkDB hashes
+//------------------------------------------------------------------------------
+class QdbWFEJobStore: public IWFEJobStore
+{
+public:
+  //! QDB hash keys
+  static const std::string sPendingKey;
+  static const std::string sFailedKey;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param qdb_details QuarkDB contact details
+  //----------------------------------------------------------------------------
+  QdbWFEJobStore(const eos::QdbContactDetails& qdb_details);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~QdbWFEJobStore();
+
+  bool PutPending(const std::string& key, const std::string& data) override;
+  bool RemovePending(const std::string& key) override;
+  bool GetPending(std::map<std::string, std::string>& jobs) override;
+  bool PutFailed(const std::string& key, const std::string& data) override;
+  bool RemoveFailed(const std::string& key) override;
+  bool GetFailed(std::map<std::string, std::string>& jobs) override;
+
+private:
+  //----------------------------------------------------------------------------
+  //! Get all the entries of a hash
+  //----------------------------------------------------------------------------
+  bool GetAll(const std::string& hash_key,
+              std::map<std::string, std::string>& jobs);
+
+  std::unique_ptr<qclient::QClient> mQcl; ///< Client talking to QDB
+};
+
+//------------------------------------------------------------------------------
+//! Job store keeping the jobs in memory, stand-in for QuarkDB in the tests
+//------------------------------------------------------------------------------
+class LocalWFEJobStore: public IWFEJobStore
+{
+public:
+  bool PutPending(const std::string& key, const std::string& data) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending[key] = data;
+    return true;
+  }
+
+  bool RemovePending(const std::string& key) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.erase(key);
+    return true;
+  }
+
+  bool GetPending(std::map<std::string, std::string>& jobs) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    jobs = mPending;
+    return true;
+  }
+
+  bool PutFailed(const std::string& key, const std::string& data) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFailed[key] = data;
+    return true;
+  }
+
+  bool RemoveFailed(const std::string& key) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFailed.erase(key);
+    return true;
+  }
+
+  bool GetFailed(std::map<std::string, std::string>& jobs) override
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    jobs = mFailed;
+    return true;
+  }
+
+private:
+  std::mutex mMutex;
+  std::map<std::string, std::string> mPending;
+  std::map<std::string, std::string> mFailed;
+};
+
+EOSMGMNAMESPACE_END
@@ -24,6 +24,8 @@
 #include "mq/XrdMqClient.hh"
 #include <XrdNet/XrdNetUtils.hh>
 #include <XrdCl/XrdClDefaultEnv.hh>
+#include <algorithm>
+#include <chrono>
 #include <setjmp.h>
 #include <signal.h>
 #include <sys/socket.h>
@@ -55,6 +57,12 @@ XrdMqClient::XrdMqClient(const char* clientid, const char* brokerurl,
   kRecvBuffer = nullptr;
   kRecvBufferAlloc = 0;
   kInternalBufferPosition = 0;
+
+  if (getenv("EOS_MQ_LONGPOLL_MS")) {
+    mLongPollMs = std::min(std::max(atoi(getenv("EOS_MQ_LONGPOLL_MS")), 0),
+                           XMQCMAXLONGPOLLMS);
+  }
+
   // Install sigbus signal handler
   struct sigaction act;
   memset(&act, 0, sizeof(act));
@@ -166,6 +174,11 @@ XrdMqClient::AddBroker(const std::string& broker_url, bool advisorystatus,
   oss << XMQCADVISORYSTATUS << "=" << advisorystatus << "&"
       << XMQCADVISORYQUERY << "=" << advisoryquery << "&"
       << XMQCADVISORYFLUSHBACKLOG << "=" << advisoryflushbacklog;
+
+  if (mLongPollMs) {
+    oss << "&" << XMQCLONGPOLL << "=" << mLongPollMs;
+  }
+
   std::string new_url = oss.str();
   mDefaultBrokerUrl = new_url;
   // Check validity of the new broker url
@@ -318,6 +331,7 @@ XrdMqClient::RecvMessage(ThreadAssistant* assistant)
   // Single broker case - check if there is still a buffered message
   XrdMqMessage* message;
   message = RecvFromInternalBuffer();
+  mHasLongPolled = false;
 
   if (message) {
     return message;
@@ -325,8 +339,15 @@ XrdMqClient::RecvMessage(ThreadAssistant* assistant)
 
   uint16_t timeout = (getenv("EOS_FST_OP_TIMEOUT") ?
                       atoi(getenv("EOS_FST_OP_TIMEOUT")) : 0);
+
+  // The broker may hold the stat for the long-poll time
+  if (timeout && mLongPollMs && (timeout * 1000 <= mLongPollMs)) {
+    timeout = mLongPollMs / 1000 + 5;
+  }
+
   XrdCl::StatInfo* stinfo = nullptr;
   recv_channel = mMapBrokerToChannels.begin()->second.first;
+  auto start = std::chrono::steady_clock::now();
 
   while (!recv_channel->Stat(true, stinfo, timeout).IsOK()) {
     // Any error on stat requires a refresh of the broker endpoints
@@ -350,6 +371,17 @@ XrdMqClient::RecvMessage(ThreadAssistant* assistant)
     } else {
       std::this_thread::sleep_for(std::chrono::seconds(2));
     }
+
+    start = std::chrono::steady_clock::now();
+  }
+
+  if (mLongPollMs) {
+    // An empty answer returned early means the broker did not wait e.g. too
+    // many clients were long-polling already
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>
+                   (std::chrono::steady_clock::now() - start);
+    mHasLongPolled = (stinfo->GetSize() ||
+                      (elapsed.count() >= mLongPollMs / 2));
   }
 
   if (stinfo->GetSize() == 0) {
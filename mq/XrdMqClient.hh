@@ -153,6 +153,15 @@ public:
     return std::atomic_exchange(&mNewMqBroker, false);
   }
 
+  //----------------------------------------------------------------------------
+  //! Check if the last receive call already waited in the broker for messages
+  //! to arrive (long-poll) i.e. the caller can retry right away
+  //----------------------------------------------------------------------------
+  inline bool HasLongPolled() const
+  {
+    return mHasLongPolled;
+  }
+
   //----------------------------------------------------------------------------
   //! Convenience operator to send a message
   //----------------------------------------------------------------------------
@@ -184,6 +193,10 @@ private:
   bool kInitOK;
   std::atomic<bool> mNewMqBroker {true};
   std::string mDefaultBrokerUrl;
+  //! Max time the broker holds a receive call waiting for messages, taken
+  //! from EOS_MQ_LONGPOLL_MS - 0 means no wait i.e. plain polling
+  int mLongPollMs {0};
+  bool mHasLongPolled {false}; ///< Last receive call waited in the broker
 
   //----------------------------------------------------------------------------
   //! Refresh the in/out-bound channels to all the brokers even if we don't
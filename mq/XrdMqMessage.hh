@@ -40,6 +40,9 @@
 #define XMQCADVISORYSTATUS       "xmqclient.advisory.status"
 #define XMQCADVISORYQUERY        "xmqclient.advisory.query"
 #define XMQCADVISORYFLUSHBACKLOG "xmqclient.advisory.flushbacklog"
+#define XMQCLONGPOLL             "xmqclient.longpoll"
+// max time in ms the broker holds a client waiting for messages to arrive
+#define XMQCMAXLONGPOLLMS        10000
 
 //------------------------------------------------------------------------------
 //! Class KeyWrapper
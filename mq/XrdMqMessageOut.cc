@@ -0,0 +1,105 @@
+//------------------------------------------------------------------------------
+// File: XrdMqMessageOut.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mq/XrdMqMessageOut.hh"
+#include <algorithm>
+#include <cstring>
+
+//------------------------------------------------------------------------------
+// Queue message
+//------------------------------------------------------------------------------
+void
+XrdMqMessageOut::Push(const XrdMqSharedPayload& payload)
+{
+  mMsgQueue.Push(payload);
+
+  // A waiter registers before checking the queue, so either it sees this
+  // message or we see the waiter
+  if (mWaiters.load()) {
+    std::unique_lock<std::mutex> lock(mWaitMutex);
+    mWaitCv.notify_all();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Move all queued messages to the pending list
+//------------------------------------------------------------------------------
+size_t
+XrdMqMessageOut::RetrieveMessages(uint64_t* retrieved)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  XrdMqSharedPayload payload;
+  uint64_t count = 0;
+
+  while (mMsgQueue.Pop(payload)) {
+    mPendingBytes += payload->length();
+    mPending.push_back(std::move(payload));
+    ++count;
+  }
+
+  if (retrieved) {
+    *retrieved += count;
+  }
+
+  return mPendingBytes;
+}
+
+//------------------------------------------------------------------------------
+// Copy pending bytes to the given buffer
+//------------------------------------------------------------------------------
+size_t
+XrdMqMessageOut::Read(char* buffer, size_t length)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  size_t done = 0;
+
+  while ((done < length) && !mPending.empty()) {
+    const std::string& data = *mPending.front();
+    const size_t len = std::min(length - done, data.length() - mPendingOffset);
+    memcpy(buffer + done, data.data() + mPendingOffset, len);
+    done += len;
+    mPendingOffset += len;
+
+    if (mPendingOffset == data.length()) {
+      mPending.pop_front();
+      mPendingOffset = 0;
+    }
+  }
+
+  mPendingBytes -= done;
+  return done;
+}
+
+//------------------------------------------------------------------------------
+// Wait until messages are queued or the timeout expires
+//------------------------------------------------------------------------------
+bool
+XrdMqMessageOut::WaitForMessages(std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mWaitMutex);
+  ++mWaiters;
+  bool found = mWaitCv.wait_for(lock, timeout, [this]() {
+    return (mMsgQueue.Size() != 0);
+  });
+  --mWaiters;
+  return found;
+}
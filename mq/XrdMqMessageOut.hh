@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqMessageOut.hh
+//! @brief Output queue of a client connected to the message broker
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include "mq/XrdMqMpscQueue.hh"
+#include "XrdOuc/XrdOucString.hh"
+#include "XrdSys/XrdSysSemWait.hh"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+//! Encoded message shared by all the queues it is delivered to
+using XrdMqSharedPayload = std::shared_ptr<const std::string>;
+
+//------------------------------------------------------------------------------
+//! Class XrdMqMessageOut
+//!
+//! Messages are pushed lock-free by the delivering threads and collected by
+//! the client connection of the queue with stat, which moves them to the
+//! pending list read out afterwards. The payloads are not copied on the way,
+//! read copies them straight into the client buffer.
+//------------------------------------------------------------------------------
+class XrdMqMessageOut
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  XrdMqMessageOut(const char* queuename):
+    AdvisoryStatus(false), AdvisoryQuery(false), AdvisoryFlushBackLog(false),
+    BrokenByFlush(false), QueueName(queuename)
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  virtual ~XrdMqMessageOut() = default;
+
+  //----------------------------------------------------------------------------
+  //! Queue message, can be called concurrently by any number of threads
+  //----------------------------------------------------------------------------
+  void Push(const XrdMqSharedPayload& payload);
+
+  //----------------------------------------------------------------------------
+  //! Get number of messages queued and not yet retrieved
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mMsgQueue.Size();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Move all queued messages to the pending list
+  //!
+  //! @param retrieved if given, incremented by the number of messages moved
+  //!
+  //! @return number of bytes pending to be read
+  //----------------------------------------------------------------------------
+  size_t RetrieveMessages(uint64_t* retrieved = nullptr);
+
+  //----------------------------------------------------------------------------
+  //! Copy pending bytes to the given buffer, dropping the messages read
+  //!
+  //! @return number of bytes copied
+  //----------------------------------------------------------------------------
+  size_t Read(char* buffer, size_t length);
+
+  //----------------------------------------------------------------------------
+  //! Wait until messages are queued or the timeout expires
+  //!
+  //! @return true if messages are queued, otherwise false
+  //----------------------------------------------------------------------------
+  bool WaitForMessages(std::chrono::milliseconds timeout);
+
+  bool AdvisoryStatus;
+  bool AdvisoryQuery;
+  bool AdvisoryFlushBackLog;
+  std::atomic<bool> BrokenByFlush;
+  XrdOucString QueueName;
+  XrdSysSemWait DeletionSem;
+
+private:
+  XrdMqMpscQueue<XrdMqSharedPayload> mMsgQueue;
+  //! Mutex serializing the consumer side, protects the pending list
+  std::mutex mMutex;
+  std::deque<XrdMqSharedPayload> mPending; ///< Retrieved messages
+  size_t mPendingOffset {0}; ///< Bytes of the first message already read
+  size_t mPendingBytes {0}; ///< Bytes left to read
+  std::mutex mWaitMutex; ///< Mutex used by the long-poll waiters
+  std::condition_variable mWaitCv;
+  std::atomic<int> mWaiters {0};
+};
@@ -86,7 +86,7 @@ XrdMqMessaging::Listen(ThreadAssistant& assistant) noexcept
       }
     }
 
-    if (new_msg == nullptr) {
+    if ((new_msg == nullptr) && !gMessageClient.HasLongPolled()) {
       assistant.wait_for(std::chrono::seconds(1));
     }
   }
@@ -0,0 +1,123 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqMpscQueue.hh
+//! @brief Lock-free multi-producer single-consumer queue
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+//------------------------------------------------------------------------------
+//! Class XrdMqMpscQueue - intrusive linked list queue where producers only
+//! exchange the head pointer, so any number of threads can push concurrently
+//! without taking a lock. Pop must be serialized by the caller.
+//!
+//! A push becomes visible to the consumer once it linked its node, while a
+//! producer is in between the two steps the consumer sees the queue ending
+//! before that node and picks up the rest with the next pop.
+//------------------------------------------------------------------------------
+template<typename T>
+class XrdMqMpscQueue
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  XrdMqMpscQueue():
+    mHead(new Node()), mTail(mHead.load())
+  {}
+
+  //----------------------------------------------------------------------------
+  //! Destructor - no producer or consumer may be active
+  //----------------------------------------------------------------------------
+  ~XrdMqMpscQueue()
+  {
+    T value;
+
+    while (Pop(value)) {}
+
+    delete mTail;
+  }
+
+  XrdMqMpscQueue(const XrdMqMpscQueue&) = delete;
+  XrdMqMpscQueue& operator=(const XrdMqMpscQueue&) = delete;
+
+  //----------------------------------------------------------------------------
+  //! Append value, can be called concurrently by any number of threads
+  //----------------------------------------------------------------------------
+  void Push(T value)
+  {
+    Node* node = new Node(std::move(value));
+    // Count before publishing so that the size never goes negative
+    mSize.fetch_add(1);
+    Node* prev = mHead.exchange(node, std::memory_order_acq_rel);
+    prev->mNext.store(node, std::memory_order_release);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove the oldest value, single consumer only
+  //!
+  //! @param value output value
+  //!
+  //! @return true if a value was removed, otherwise false
+  //----------------------------------------------------------------------------
+  bool Pop(T& value)
+  {
+    Node* tail = mTail;
+    Node* next = tail->mNext.load(std::memory_order_acquire);
+
+    if (next == nullptr) {
+      return false;
+    }
+
+    value = std::move(next->mValue);
+    next->mValue = T();
+    mTail = next;
+    delete tail;
+    mSize.fetch_sub(1);
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of values pushed and not yet popped
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mSize.load();
+  }
+
+private:
+  struct Node {
+    Node() = default;
+
+    explicit Node(T&& value):
+      mValue(std::move(value))
+    {}
+
+    T mValue {};
+    std::atomic<Node*> mNext {nullptr};
+  };
+
+  std::atomic<Node*> mHead; ///< Last pushed node, producers side
+  Node* mTail; ///< Stub node preceding the oldest value, consumer side
+  std::atomic<size_t> mSize {0};
+};
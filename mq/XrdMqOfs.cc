@@ -37,6 +37,8 @@
 #include "common/PasswordHandler.hh"
 #include "common/Strerror_r_wrapper.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
+#include <algorithm>
+#include <chrono>
 #include <pwd.h>
 #include <grp.h>
 #include <signal.h>
@@ -94,7 +96,7 @@ XrdMqOfsFile::open(const char* queuename, XrdSfsFileOpenMode openMode,
   eos_info("connecting queue: %s", queuename);
   MAYREDIRECT;
   mQueueName = queuename;
-  XrdSysMutexHelper scope_lock(gMqFS->mQueueOutMutex);
+  eos::common::RWMutexWriteLock wr_lock(gMqFS->mQueueOutMutex);
 
   //  printf("%s %s %s\n",mQueueName.c_str(),gMqFS->QueuePrefix.c_str(),opaque);
   // check if this queue is accepted by the broker
@@ -131,11 +133,25 @@ XrdMqOfsFile::open(const char* queuename, XrdSfsFileOpenMode openMode,
     advisoryflushbacklog = atoi(val);
   }
 
+  if ((val = queueenv.Get(XMQCLONGPOLL))) {
+    mLongPollMs = std::min(std::max(atoi(val), 0), XMQCMAXLONGPOLLMS);
+  }
+
   mMsgOut->AdvisoryStatus = advisorystatus;
   mMsgOut->AdvisoryQuery  = advisoryquery;
   mMsgOut->AdvisoryFlushBackLog = advisoryflushbacklog;
   mMsgOut->BrokenByFlush = false;
   gMqFS->mQueueOut.insert(std::make_pair(mQueueName, mMsgOut));
+  gMqFS->mQueueIndex.Insert(mQueueName, mMsgOut);
+
+  if (advisorystatus) {
+    gMqFS->mStatusReceivers.push_back(mMsgOut);
+  }
+
+  if (advisoryquery) {
+    gMqFS->mQueryReceivers.push_back(mMsgOut);
+  }
+
   eos_info("connected queue: %s", mQueueName.c_str());
   mIsOpen = true;
   return SFS_OK;
@@ -177,12 +193,20 @@ XrdMqOfsFile::stat(struct stat* buf)
     amg.kMessageHeader.kSenderId = gMqFS->BrokerId;
     amg.Encode();
     // amg.Print();
-    XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
-    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
+    XrdOucEnv env(amg.GetMessageBuffer());
+    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), &env, tident,
                             XrdMqMessageHeader::kQueryMessage, mQueueName.c_str());
+    (void) gMqFS->Deliver(matches);
+
+    // Long-poll: rather than making the client come back later wait here
+    // until something arrives, as long as not too many threads are parked
+    if (mLongPollMs && (mMsgOut->Size() == 0)) {
+      if (++gMqFS->mLongPolls <= gMqFS->mMaxLongPolls) {
+        ZTRACE(stat, "Waiting for message up to " << mLongPollMs << " ms");
+        (void) mMsgOut->WaitForMessages(std::chrono::milliseconds(mLongPollMs));
+      }
 
-    if (!gMqFS->Deliver(matches)) {
-      delete env;
+      --gMqFS->mLongPolls;
     }
 
     ZTRACE(stat, "Grabbing message");
@@ -193,7 +217,9 @@ XrdMqOfsFile::stat(struct stat* buf)
     buf->st_nlink  = 1;
     buf->st_uid    = 0;
     buf->st_gid    = 0;
-    buf->st_size   = mMsgOut->RetrieveMessages();
+    uint64_t retrieved = 0;
+    buf->st_size   = mMsgOut->RetrieveMessages(&retrieved);
+    gMqFS->mDeliveredMessages += retrieved;
     buf->st_atime  = 0;
     buf->st_mtime  = 0;
     buf->st_ctime  = 0;
@@ -224,19 +250,8 @@ XrdMqOfsFile::read(XrdSfsFileOffset fileOffset, char* buffer,
   ZTRACE(read, "read");
 
   if (mMsgOut) {
-    unsigned int mlen = mMsgOut->mMsgBuffer.length();
     ZTRACE(read, "reading size:" << buffer_size);
-
-    if ((unsigned long) buffer_size < mlen) {
-      memcpy(buffer, mMsgOut->mMsgBuffer.c_str(), buffer_size);
-      mMsgOut->mMsgBuffer.erase(0, buffer_size);
-      return buffer_size;
-    } else {
-      memcpy(buffer, mMsgOut->mMsgBuffer.c_str(), mlen);
-      mMsgOut->mMsgBuffer.clear();
-      mMsgOut->mMsgBuffer.reserve(0);
-      return mlen;
-    }
+    return mMsgOut->Read(buffer, (buffer_size > 0) ? buffer_size : 0);
   }
 
   error.setErrInfo(-1, "");
@@ -256,15 +271,23 @@ XrdMqOfsFile::close()
   mIsOpen = false;
   eos_info("disconnecting queue: %s", mQueueName.c_str());
   {
-    XrdSysMutexHelper scope_lock(gMqFS->mQueueOutMutex);
+    eos::common::RWMutexWriteLock wr_lock(gMqFS->mQueueOutMutex);
 
     if ((gMqFS->mQueueOut.count(mQueueName)) &&
         (mMsgOut = gMqFS->mQueueOut[mQueueName])) {
       // hmm this could create a dead lock
       //      mMsgOut->DeletionSem.Wait();
-      // Take away all pending messages
-      mMsgOut->RetrieveMessages();
       gMqFS->mQueueOut.erase(mQueueName);
+      gMqFS->mQueueIndex.Erase(mQueueName);
+
+      for (auto* receivers : {
+             &gMqFS->mStatusReceivers, &gMqFS->mQueryReceivers
+           }) {
+        receivers->erase(std::remove(receivers->begin(), receivers->end(),
+                                     mMsgOut), receivers->end());
+      }
+
+      // Pending messages are released together with the queue
       delete mMsgOut;
     }
 
@@ -282,13 +305,10 @@ XrdMqOfsFile::close()
     amg.kMessageHeader.kSenderId = gMqFS->BrokerId;
     amg.Encode();
     //    amg.Print();
-    XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
-    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
+    XrdOucEnv env(amg.GetMessageBuffer());
+    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), &env, tident,
                             XrdMqMessageHeader::kStatusMessage, mQueueName.c_str());
-
-    if (!gMqFS->Deliver(matches)) {
-      delete env;
-    }
+    (void) gMqFS->Deliver(matches);
   }
   eos_info("disconnected queue: %s", mQueueName.c_str());
   return SFS_OK;
@@ -328,9 +348,11 @@ XrdSfsFileSystem* XrdSfsGetFileSystem(XrdSfsFileSystem* native_fs,
 // Constructor
 //------------------------------------------------------------------------------
 XrdMqOfs::XrdMqOfs(XrdSysError* ep):
-  myPort(1097), mDeliveredMessages(0ull), mFanOutMessages(0ull),
+  myPort(1097), mPendingMessages(0ull), mDeliveredMessages(0ull),
+  mFanOutMessages(0ull),
   mMaxQueueBacklog(MQOFSMAXQUEUEBACKLOG),
-  mRejectQueueBacklog(MQOFSREJECTQUEUEBACKLOG), mQdbCluster(), mQdbPassword(),
+  mRejectQueueBacklog(MQOFSREJECTQUEUEBACKLOG),
+  mMaxLongPolls(MQOFSMAXLONGPOLLS), mLongPolls(0), mQdbCluster(), mQdbPassword(),
   mQdbContactDetails(), mQcl(nullptr), mMgmId()
 {
   ConfigFN  = 0;
@@ -351,7 +373,6 @@ XrdMqOfs::XrdMqOfs(XrdSysError* ep):
   HostName = 0;
   HostPref = 0;
   eos_info("Addr:mQueueOutMutex: 0x%llx", &mQueueOutMutex);
-  eos_info("Addr:MessageMutex:   0x%llx", &mMsgsMutex);
 }
 
 //------------------------------------------------------------------------------
@@ -463,6 +484,12 @@ int XrdMqOfs::Configure(XrdSysError& Eroute)
           }
         }
 
+        if (!strcmp("maxlongpolls", var)) {
+          if ((val = Config.GetWord())) {
+            mMaxLongPolls = atoi(val);
+          }
+        }
+
         if (!strcmp("trace", var)) {
           if ((val = Config.GetWord())) {
             auto& g_logging = eos::common::Logging::GetInstance();
@@ -611,7 +638,7 @@ XrdMqOfs::stat(const char* queuename, struct stat* buf, XrdOucErrInfo& error,
   ZTRACE(stat, "stat by buf: " << queuename);
   std::string squeue = queuename;
   {
-    XrdSysMutexHelper scope_lock(mQueueOutMutex);
+    eos::common::RWMutexReadLock rd_lock(mQueueOutMutex);
 
     if ((!gMqFS->mQueueOut.count(squeue)) ||
         (!(msg_out = gMqFS->mQueueOut[squeue]))) {
@@ -632,13 +659,10 @@ XrdMqOfs::stat(const char* queuename, struct stat* buf, XrdOucErrInfo& error,
     amg.kMessageHeader.kSenderId = gMqFS->BrokerId;
     amg.Encode();
     //    amg.Print();
-    XrdSmartOucEnv* env = new XrdSmartOucEnv(amg.GetMessageBuffer());
-    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), env, tident,
+    XrdOucEnv env(amg.GetMessageBuffer());
+    XrdMqOfsMatches matches(gMqFS->QueueAdvisory.c_str(), &env, tident,
                             XrdMqMessageHeader::kQueryMessage, queuename);
-
-    if (!gMqFS->Deliver(matches)) {
-      delete env;
-    }
+    (void) gMqFS->Deliver(matches);
   }
   // this should be the case always ...
   ZTRACE(stat, "Waiting for message");
@@ -650,7 +674,9 @@ XrdMqOfs::stat(const char* queuename, struct stat* buf, XrdOucErrInfo& error,
   buf->st_nlink  = 1;
   buf->st_uid    = 0;
   buf->st_gid    = 0;
-  buf->st_size   = msg_out->RetrieveMessages();
+  uint64_t retrieved = 0;
+  buf->st_size   = msg_out->RetrieveMessages(&retrieved);
+  mDeliveredMessages += retrieved;
   buf->st_atime  = 0;
   buf->st_mtime  = 0;
   buf->st_ctime  = 0;
@@ -747,7 +773,7 @@ XrdMqOfs::Statistics()
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.total                  %lld\n", NoMessages);
       rc = write(fd, line, strlen(line));
-      sprintf(line, "mq.queued                 %d\n", (int)Messages.size());
+      sprintf(line, "mq.queued                 %lu\n", mPendingMessages.load());
       rc = write(fd, line, strlen(line));
       sprintf(line, "mq.nqueues                %d\n", (int)mQueueOut.size());
       rc = write(fd, line, strlen(line));
@@ -794,7 +820,7 @@ XrdMqOfs::Statistics()
     ZTRACE(getstats, "Discarded Monitoring Messages : " <<
            DiscardedMonitoringMessages);
     ZTRACE(getstats, "No        Messages            : " << NoMessages);
-    ZTRACE(getstats, "Queue     Messages            : " << Messages.size());
+    ZTRACE(getstats, "Queue     Messages            : " << mPendingMessages);
     ZTRACE(getstats, "#Queues                       : " << mQueueOut.size());
     ZTRACE(getstats, "Deferred  Messages (backlog)  : " << BacklogDeferred);
     ZTRACE(getstats, "Backlog   Messages Hits       : " << QueueBacklogHits);
@@ -1139,8 +1165,7 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
   }
 
   // check for backlog
-  if ((long long)Messages.size() > MaxMessageBacklog) {
-    // this is not absolutely threadsafe .... better would lock
+  if ((long long) mPendingMessages.load() > MaxMessageBacklog) {
     BacklogDeferred++;
     eos_static_err("%s", "msg=\"too many pending messages, reject message\"");
     gMqFS->Emsg(epname, error, ENOMEM, "accept message - too many pending messages",
@@ -1170,19 +1195,12 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
     opaque.assign(args.Arg2, 0, args.Arg2Len);
   }
 
-  XrdSmartOucEnv* env = new XrdSmartOucEnv(opaque.c_str());
-
-  if (!env) {
-    gMqFS->Emsg(epname, error, ENOMEM, "allocate memory", "");
-    return SFS_ERROR;
-  }
-
+  std::unique_ptr<XrdOucEnv> env(new XrdOucEnv(opaque.c_str()));
   // look into the header
   XrdMqMessageHeader mh;
 
   if (!mh.Decode(opaque.c_str())) {
     gMqFS->Emsg(epname, error, EINVAL, "decode message header", "");
-    delete env;
     return SFS_ERROR;
   }
 
@@ -1201,9 +1219,8 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
   int p2 = envstring.find("&", p1 + 1);
   envstring.erase(p1, p2 - 1);
   envstring.insert(mh.GetHeaderBuffer(), p1);
-  delete env;
-  env = new XrdSmartOucEnv(envstring.c_str());
-  XrdMqOfsMatches matches(mh.kReceiverQueue.c_str(), env, tident, mh.kType,
+  env.reset(new XrdOucEnv(envstring.c_str()));
+  XrdMqOfsMatches matches(mh.kReceiverQueue.c_str(), env.get(), tident, mh.kType,
                           mh.kSenderId.c_str());
   Deliver(matches);
 
@@ -1219,11 +1236,6 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
     }
 
     TRACES(backlogmessage.c_str());
-
-    if (!matches.message->Refs()) {
-      delete env;
-    }
-
     return SFS_ERROR;
   }
 
@@ -1259,10 +1271,6 @@ XrdMqOfs::FSctl(const int cmd, XrdSfsFSctl& args, XrdOucErrInfo& error,
       ismonitor = true;
     }
 
-    int envlen;
-    std::string c = env->Env(envlen);
-    delete env;
-
     // This is a new hook for special monitoring message, to just accept them
     // and if nobody listens they just go to nirvana.
     if (!ismonitor) {
@@ -1290,79 +1298,35 @@ bool
 XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
 {
   EPNAME("Deliver");
-  XrdSysMutexHelper scope_lock(mQueueOutMutex);
+  // Deliveries only read the set of queues and run concurrently
+  eos::common::RWMutexReadLock rd_lock(mQueueOutMutex);
   const char* tident = Matches.mTident;
   std::string sendername = Matches.sendername.c_str();
   // Store all the queues where we need to deliver this message
   std::vector<XrdMqMessageOut*> matched_out_queues;
-  Matches.message->procmutex.Lock();
 
-  // If we have a status message we have to do a complete loop
+  // If we have a status message all queues interested in it get it
   if (((Matches.messagetype) == XrdMqMessageHeader::kStatusMessage) ||
       ((Matches.messagetype) == XrdMqMessageHeader::kQueryMessage)) {
-    for (auto it = mQueueOut.begin(); it != mQueueOut.end(); ++it) {
-      XrdMqMessageOut* msg_out = it->second;
+    const auto& receivers =
+      ((Matches.messagetype) == XrdMqMessageHeader::kStatusMessage) ?
+      mStatusReceivers : mQueryReceivers;
 
+    for (auto msg_out : receivers) {
       // If this is be a loop back message we continue
-      if (sendername == it->first) {
-        // avoid feedback to the same queue
-        continue;
-      }
-
-      // If this queue does not take advisory status messages we continue
-      if ((Matches.messagetype == XrdMqMessageHeader::kStatusMessage) &&
-          (!msg_out->AdvisoryStatus)) {
-        continue;
-      }
-
-      // if this queue does not take advisory query messages we continue
-      if ((Matches.messagetype == XrdMqMessageHeader::kQueryMessage)  &&
-          (!msg_out->AdvisoryQuery)) {
-        continue;
-      } else {
+      if (sendername != msg_out->QueueName.c_str()) {
         matched_out_queues.push_back(msg_out);
       }
     }
   } else {
-    // If we have a wildcard match we have to do a complete loop
-    if ((Matches.queuename.find("*") != STR_NPOS)) {
-      for (auto it = mQueueOut.begin(); it != mQueueOut.end(); ++it) {
-        XrdMqMessageOut* msg_out = it->second;
-
-        // fprintf(stderr,"current queue name: %s <=> sender :%s\n",
-        //        it->first.c_str(), sendername.c_str());
-        // If this would be a loop back message we continue
-        if (sendername == it->first) {
-          // avoid feedback to the same queue
-          continue;
-        }
-
-        XrdOucString Key = it->first.c_str();
-        XrdOucString nowildcard = Matches.queuename;
-        nowildcard.replace("*", "");
-        int nmatch = Key.matches(Matches.queuename.c_str(), '*');
-
-        if (nmatch == nowildcard.length()) {
-          // this is a match
-          ZTRACE(fsctl, "Adding Wildcard matched Message to Queuename: "
-                 << msg_out->QueueName.c_str());
-          matched_out_queues.push_back(msg_out);
-        }
-      }
-    } else {
-      // We have just to find one named queue
-      std::string queuename = Matches.queuename.c_str();
-      XrdMqMessageOut* msg_out = 0;
-
-      if (mQueueOut.count(queuename)) {
-        msg_out = mQueueOut[queuename];
-      }
+    mQueueIndex.Match(Matches.queuename.c_str(), matched_out_queues);
 
-      if (msg_out) {
-        ZTRACE(fsctl, "Adding full matched Message to Queuename: " <<
-               msg_out->QueueName.c_str());
-        matched_out_queues.push_back(msg_out);
-      }
+    // Avoid feedback to the sender of a wildcard message
+    if ((Matches.queuename.find("*") != STR_NPOS)) {
+      matched_out_queues.erase(std::remove_if(matched_out_queues.begin(),
+      matched_out_queues.end(), [&](XrdMqMessageOut * msg_out) {
+        return (sendername == msg_out->QueueName.c_str());
+      }), matched_out_queues.end());
     }
   }
 
@@ -1370,22 +1334,20 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
   if (matched_out_queues.size()) {
     Matches.backlog = false;
     Matches.backlogrejected = false;
+    // The encoded message is built once and shared by all the queues
+    XrdMqSharedPayload payload;
 
-    // Lock all matched queues at once
     for (auto msg_out : matched_out_queues) {
-      msg_out->Lock();
-    }
+      const size_t queued = msg_out->Size();
 
-    for (auto msg_out : matched_out_queues) {
       // check for backlog on this queue and set a warning flag
-      if (msg_out->mMsgQueue.size() > mMaxQueueBacklog) {
+      if (queued > mMaxQueueBacklog) {
         // Only set the backlog flag if the queue has not set the advisory
         // flush back log flag
         if (!msg_out->AdvisoryFlushBackLog) {
           Matches.backlog = true;
         } else {
-          if (!msg_out->BrokenByFlush) {
-            msg_out->BrokenByFlush = true;
+          if (!msg_out->BrokenByFlush.exchange(true)) {
             TRACES("warning: queue " << msg_out->QueueName
                    << " is broken by backlog flush of "
                    << mMaxQueueBacklog  << " message!");
@@ -1402,22 +1364,19 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
                  << " message!");
         }
       } else {
-        if (msg_out->BrokenByFlush) {
-          msg_out->BrokenByFlush = false;
+        if (msg_out->BrokenByFlush.exchange(false)) {
           TRACES("warning: re-enabling queue " << msg_out->QueueName
-                 << " backlog is now " << msg_out->mMsgQueue.size()
-                 << " messages!");
+                 << " backlog is now " << queued << " messages!");
         }
       }
 
-      if (msg_out->mMsgQueue.size() > mRejectQueueBacklog) {
+      if (queued > mRejectQueueBacklog) {
         // Only set the reject flag if the queue has not set the advisory
         // flush back log flag
         if (!msg_out->AdvisoryFlushBackLog) {
           Matches.backlogrejected = true;
         } else {
-          if (!msg_out->BrokenByFlush) {
-            msg_out->BrokenByFlush = true;
+          if (!msg_out->BrokenByFlush.exchange(true)) {
             TRACES("warning: queue " << msg_out->QueueName
                    << " is broken by backlog flush of " << mRejectQueueBacklog
                    << " message!");
@@ -1438,71 +1397,33 @@ XrdMqOfs::Deliver(XrdMqOfsMatches& Matches)
           // get out of this situation
           Matches.matches++;
 
-          if (Matches.matches == 1) {
-            // add to the message hash
-            std::string messageid = Matches.message->Get(XMQHEADER);
-            XrdSysMutexHelper scope_lock(gMqFS->mMsgsMutex);
-            gMqFS->Messages.insert(std::pair<std::string, XrdSmartOucEnv*> (messageid,
-                                   Matches.message));
+          if (!payload) {
+            payload = MakePayload(*Matches.message);
           }
 
           ZTRACE(fsctl, "Adding Message to Queuename: " << msg_out->QueueName.c_str());
-          msg_out->mMsgQueue.push_back(Matches.message);
-          Matches.message->AddRefs(1);
+          msg_out->Push(payload);
         }
       }
     }
-
-    // Unlock all matched queues at once
-    for (auto msg_out : matched_out_queues) {
-      msg_out->UnLock();
-    }
   }
 
-  Matches.message->procmutex.UnLock();
   return (Matches.matches > 0);
 }
 
 //------------------------------------------------------------------------------
-// Collect all messages from the queue and append them to the internal
-// buffer. Also delete messages if this was the last reference towards them.
+// Build the payload shared by the output queues
 //------------------------------------------------------------------------------
-size_t
-XrdMqMessageOut::RetrieveMessages()
+XrdMqSharedPayload
+XrdMqOfs::MakePayload(XrdOucEnv& message)
 {
-  XrdSmartOucEnv* message {nullptr};
-  XrdSysMutexHelper scope_lock(mMutex);
-
-  while (mMsgQueue.size()) {
-    message = mMsgQueue.front();
-    mMsgQueue.pop_front();
-    message->procmutex.Lock();
-    // fprintf(stderr,"%llu %s Message %llu nref: %d\n", (unsigned long long)
-    // &mMsgQueue, QueueName.c_str(), (unsigned long long) message, message->Refs());
-    int len;
-    mMsgBuffer += message->Env(len);
-    ++gMqFS->mDeliveredMessages;
-    message->DecRefs();
-
-    if (message->Refs() <= 0) {
-      // We can delete this message from the queue!
-      const char* ptr = message->Get(XMQHEADER);
-
-      if (ptr) {
-        std::string msg_id = message->Get(XMQHEADER);
-        XrdSysMutexHelper scope_lock(gMqFS->mMsgsMutex);
-        gMqFS->Messages.erase(msg_id.c_str());
-      }
-
-      message->procmutex.UnLock();
-      // fprintf(stderr,"%s delete %llu \n", QueueName.c_str(),
-      // (unsigned long long) message);
-      delete message;
-      ++gMqFS->mFanOutMessages;
-    } else {
-      message->procmutex.UnLock();
-    }
-  }
-
-  return mMsgBuffer.length();
+  int len = 0;
+  const char* data = message.Env(len);
+  ++mPendingMessages;
+  return XrdMqSharedPayload(new std::string(data, len),
+  [this](const std::string * payload) {
+    delete payload;
+    --mPendingMessages;
+    ++mFanOutMessages;
+  });
 }
@@ -32,6 +32,9 @@
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdSys/XrdSysSemWait.hh"
 #include "common/Logging.hh"
+#include "common/RWMutex.hh"
+#include "mq/XrdMqMessageOut.hh"
+#include "mq/XrdMqQueueIndex.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include <sys/types.h>
 #include <unistd.h>
@@ -42,13 +45,14 @@
 #include <map>
 #include <string>
 #include <vector>
-#include <deque>
 #include <atomic>
 
 // if we have too many messages pending we don't take new ones for the moment
 #define MQOFSMAXMESSAGEBACKLOG 100000
 #define MQOFSMAXQUEUEBACKLOG 50000
 #define MQOFSREJECTQUEUEBACKLOG 100000
+// max number of clients waiting in stat for messages to arrive
+#define MQOFSMAXLONGPOLLS 1024
 
 #define MAYREDIRECT {                                         \
     int port=0;                                               \
@@ -68,39 +72,6 @@ namespace qclient
 class QClient;
 }
 
-//------------------------------------------------------------------------------
-//! Class XrdSmartOucEnv
-//------------------------------------------------------------------------------
-class XrdSmartOucEnv : public XrdOucEnv
-{
-public:
-  XrdSmartOucEnv(const char* vardata = 0, int vardlen = 0) :
-    XrdOucEnv(vardata, vardlen), nref(0)
-  {}
-
-  virtual ~XrdSmartOucEnv() {}
-
-  int Refs()
-  {
-    return nref;
-  }
-
-  void DecRefs()
-  {
-    --nref;
-  }
-
-  void AddRefs(int nrefs)
-  {
-    nref += nrefs;
-  }
-
-  XrdSysMutex procmutex;
-
-private:
-  std::atomic<int> nref;
-};
-
 //------------------------------------------------------------------------------
 //! Class XrdMqOfsMatches
 //------------------------------------------------------------------------------
@@ -110,7 +81,7 @@ public:
   //----------------------------------------------------------------------------
   //! Constructor
   //----------------------------------------------------------------------------
-  XrdMqOfsMatches(const char* qname, XrdSmartOucEnv* msg, const char* t,
+  XrdMqOfsMatches(const char* qname, XrdOucEnv* msg, const char* t,
                   int type, const char* sender = "ignore"):
     matches(0), messagetype(type), backlog(false), backlogrejected(false),
     backlogqueues(""), sendername(sender), queuename(qname), message(msg),
@@ -129,71 +100,10 @@ public:
   XrdOucString backlogqueues;
   XrdOucString sendername;
   XrdOucString queuename;
-  XrdSmartOucEnv* message;
+  XrdOucEnv* message; ///< Message to deliver, owned by the caller
   const char* mTident;
 };
 
-//------------------------------------------------------------------------------
-//! Class XrdMqMessageOut
-//------------------------------------------------------------------------------
-class XrdMqMessageOut
-{
-public:
-  //----------------------------------------------------------------------------
-  //! Constructor
-  //----------------------------------------------------------------------------
-  XrdMqMessageOut(const char* queuename):
-    AdvisoryStatus(false), AdvisoryQuery(false), AdvisoryFlushBackLog(false),
-    BrokenByFlush(false), QueueName(queuename), mMsgBuffer("")
-  {
-    mMsgQueue.clear();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Destructor
-  //----------------------------------------------------------------------------
-  virtual ~XrdMqMessageOut()
-  {
-    RetrieveMessages();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Lock current object
-  //----------------------------------------------------------------------------
-  void Lock() const
-  {
-    mMutex.Lock();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Unlock current object
-  //----------------------------------------------------------------------------
-  void UnLock() const
-  {
-    mMutex.UnLock();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Collect all messages from the queue and append them to the internal
-  //! buffer. Also delete messages if this was the last reference towards them.
-  //!
-  //! @return size of the internal buffer
-  //----------------------------------------------------------------------------
-  size_t RetrieveMessages();
-
-  bool AdvisoryStatus;
-  bool AdvisoryQuery;
-  bool AdvisoryFlushBackLog;
-  bool BrokenByFlush;
-  XrdOucString QueueName;
-  std::string mMsgBuffer;
-  XrdSysSemWait DeletionSem;
-  std::deque<XrdSmartOucEnv*> mMsgQueue;
-
-private:
-  mutable XrdSysMutex mMutex; ///< Mutex protecting access to the msg queue
-};
-
 //------------------------------------------------------------------------------
 //! Class XrdMqOfsFile
 //------------------------------------------------------------------------------
@@ -205,7 +115,8 @@ public:
   //----------------------------------------------------------------------------
   XrdMqOfsFile(char* user = 0):
     XrdSfsFile(user), eos::common::LogId(),
-    mMsgOut(nullptr), mQueueName(), mIsOpen(false), tident("")
+    mMsgOut(nullptr), mQueueName(), mIsOpen(false), mLongPollMs(0),
+    tident("")
   {}
 
   //----------------------------------------------------------------------------
@@ -285,6 +196,7 @@ private:
   XrdMqMessageOut* mMsgOut;
   std::string mQueueName;
   bool mIsOpen;
+  int mLongPollMs; ///< Max time stat waits for messages, 0 means no wait
   const char* tident;
 };
 
@@ -352,10 +264,17 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Deliver a message into matching output queues
+  //! Deliver a message into matching output queues. The message is encoded
+  //! once and shared by all the queues, the caller keeps its ownership.
   //----------------------------------------------------------------------------
   bool Deliver(XrdMqOfsMatches& Match);
 
+  //----------------------------------------------------------------------------
+  //! Build the payload shared by the output queues, counted as pending until
+  //! the last queue released it
+  //----------------------------------------------------------------------------
+  XrdMqSharedPayload MakePayload(XrdOucEnv& message);
+
   int stat(const char* Name, struct stat* buf, XrdOucErrInfo& error,
            const XrdSecEntity* client = 0, const char* opaque = 0);
 
@@ -381,8 +300,7 @@ public:
   XrdOucString QueuePrefix; ///< Prefix of the accepted queues to server
   XrdOucString QueueAdvisory; ///< "<queueprefix>/*" for advisory message matches
   XrdOucString BrokerId; ///< Manger id + queue name as path
-  std::map<std::string, XrdSmartOucEnv*> Messages; ///< Hash with all messages
-  XrdSysMutex mMsgsMutex;  ///< Mutex protecting the message hash
+  std::atomic<uint64_t> mPendingMessages; ///< Messages not yet delivered
 
   XrdSysMutex  StatLock;
   time_t       StartupTime;
@@ -399,6 +317,8 @@ public:
   long long    MaxMessageBacklog;
   uint64_t     mMaxQueueBacklog;
   uint64_t     mRejectQueueBacklog;
+  int          mMaxLongPolls; ///< Max number of clients waiting in stat
+  std::atomic<int> mLongPolls; ///< Number of clients waiting in stat
   void         Statistics();
   XrdOucString StatisticsFile;
   char*         ConfigFN;
@@ -408,7 +328,14 @@ private:
   static std::string sLeaseKey;
   //! Hash of all output's connected
   std::map<std::string, XrdMqMessageOut*> mQueueOut;
-  XrdSysMutex mQueueOutMutex;  ///< Mutex protecting the output hash
+  //! Subscription index of the output queues
+  XrdMqQueueIndex<XrdMqMessageOut> mQueueIndex;
+  //! Output queues taking advisory status and query messages
+  std::vector<XrdMqMessageOut*> mStatusReceivers;
+  std::vector<XrdMqMessageOut*> mQueryReceivers;
+  //! Mutex protecting the output queues, only held in write mode while
+  //! clients connect or disconnect
+  eos::common::RWMutex mQueueOutMutex;
   std::string mQdbCluster; ///< Quarkdb cluster info host1:port1 host2:port2 ..
   std::string mQdbPassword; ///< Quarkdb cluster password
   eos::QdbContactDetails mQdbContactDetails; ///< QuarkDB contact details
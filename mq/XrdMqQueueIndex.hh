@@ -0,0 +1,299 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqQueueIndex.hh
+//! @brief Prefix trie of the broker queues used to route wildcard messages
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Class XrdMqQueueIndex - maps queue names to their subscribers. The names
+//! are stored in a trie with one level per path component, a pattern only
+//! visits the subtree below its literal prefix i.e. the part before the
+//! first '*'. Since senders use a handful of patterns over and over (e.g.
+//! "/eos/*/fst" for all FSTs) the result of every pattern is cached until the
+//! next subscriber comes or goes.
+//!
+//! Insert and Erase must be serialized with Match/Find by the caller, the
+//! latter can run concurrently with each other.
+//------------------------------------------------------------------------------
+template<typename T>
+class XrdMqQueueIndex
+{
+public:
+  //! Max number of patterns kept in the cache
+  static constexpr size_t sMaxCacheEntries = 4096;
+
+  //----------------------------------------------------------------------------
+  //! Add subscriber, replaces any previous one with the same name
+  //----------------------------------------------------------------------------
+  void Insert(const std::string& name, T* value)
+  {
+    Node* node = &mRoot;
+
+    for (const auto& segment : Split(name)) {
+      auto& child = node->mChildren[segment];
+
+      if (!child) {
+        child.reset(new Node());
+      }
+
+      node = child.get();
+    }
+
+    if (!node->mValue) {
+      ++mSize;
+    }
+
+    node->mValue = value;
+    node->mName = name;
+    ClearCache();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Remove subscriber
+  //----------------------------------------------------------------------------
+  void Erase(const std::string& name)
+  {
+    std::vector<std::pair<Node*, std::string>> path;
+    Node* node = &mRoot;
+
+    for (const auto& segment : Split(name)) {
+      auto it = node->mChildren.find(segment);
+
+      if (it == node->mChildren.end()) {
+        return;
+      }
+
+      path.emplace_back(node, segment);
+      node = it->second.get();
+    }
+
+    if (node->mValue) {
+      --mSize;
+    }
+
+    node->mValue = nullptr;
+    node->mName.clear();
+
+    // Prune the branches left empty
+    while (!path.empty() && !node->mValue && node->mChildren.empty()) {
+      node = path.back().first;
+      node->mChildren.erase(path.back().second);
+      path.pop_back();
+    }
+
+    ClearCache();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find subscriber by exact name
+  //!
+  //! @return subscriber or nullptr
+  //----------------------------------------------------------------------------
+  T* Find(const std::string& name) const
+  {
+    const Node* node = Descend(Split(name));
+    return (node ? node->mValue : nullptr);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Collect the subscribers matching the given pattern. A pattern without
+  //! '*' is an exact name, otherwise '*' matches any sequence of characters
+  //! including '/'.
+  //!
+  //! @param pattern queue name or pattern
+  //! @param out subscribers appended here
+  //----------------------------------------------------------------------------
+  void Match(const std::string& pattern, std::vector<T*>& out) const
+  {
+    const size_t star = pattern.find('*');
+
+    if (star == std::string::npos) {
+      if (T* value = Find(pattern)) {
+        out.push_back(value);
+      }
+
+      return;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mCacheMutex);
+      auto it = mCache.find(pattern);
+
+      if (it != mCache.end()) {
+        out.insert(out.end(), it->second.begin(), it->second.end());
+        return;
+      }
+    }
+
+    std::vector<T*> result;
+    const std::string literal = pattern.substr(0, star);
+    const size_t pos = literal.rfind('/');
+    const Node* node = &mRoot;
+    std::string partial = literal;
+
+    if (pos != std::string::npos) {
+      node = Descend(Split(literal.substr(0, pos)));
+      partial = literal.substr(pos + 1);
+    }
+
+    if (node) {
+      // Only the children starting with the rest of the literal prefix
+      for (auto it = node->mChildren.lower_bound(partial);
+           (it != node->mChildren.end()) &&
+           (it->first.compare(0, partial.length(), partial) == 0); ++it) {
+        Collect(*it->second, pattern.c_str(), result);
+      }
+    }
+
+    out.insert(out.end(), result.begin(), result.end());
+    std::unique_lock<std::mutex> lock(mCacheMutex);
+
+    if (mCache.size() >= sMaxCacheEntries) {
+      mCache.clear();
+    }
+
+    mCache[pattern] = std::move(result);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of subscribers
+  //----------------------------------------------------------------------------
+  inline size_t Size() const
+  {
+    return mSize;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Check if name matches pattern where '*' matches any sequence of
+  //! characters
+  //----------------------------------------------------------------------------
+  static bool WildcardMatch(const char* name, const char* pattern)
+  {
+    const char* star = nullptr;
+    const char* retry = nullptr;
+
+    while (*name) {
+      if (*pattern == '*') {
+        star = pattern++;
+        retry = name;
+      } else if (*pattern == *name) {
+        ++pattern;
+        ++name;
+      } else if (star) {
+        // Let the last star swallow one more character
+        pattern = star + 1;
+        name = ++retry;
+      } else {
+        return false;
+      }
+    }
+
+    while (*pattern == '*') {
+      ++pattern;
+    }
+
+    return (*pattern == '\0');
+  }
+
+private:
+  struct Node {
+    std::map<std::string, std::unique_ptr<Node>> mChildren;
+    T* mValue {nullptr};
+    std::string mName; ///< Full queue name if mValue is set
+  };
+
+  //----------------------------------------------------------------------------
+  //! Split name in its path components, n slashes give n + 1 components
+  //----------------------------------------------------------------------------
+  static std::vector<std::string> Split(const std::string& name)
+  {
+    std::vector<std::string> segments;
+    size_t start = 0;
+    size_t pos;
+
+    while ((pos = name.find('/', start)) != std::string::npos) {
+      segments.push_back(name.substr(start, pos - start));
+      start = pos + 1;
+    }
+
+    segments.push_back(name.substr(start));
+    return segments;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get node of the given path components
+  //----------------------------------------------------------------------------
+  const Node* Descend(const std::vector<std::string>& segments) const
+  {
+    const Node* node = &mRoot;
+
+    for (const auto& segment : segments) {
+      auto it = node->mChildren.find(segment);
+
+      if (it == node->mChildren.end()) {
+        return nullptr;
+      }
+
+      node = it->second.get();
+    }
+
+    return node;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Collect the subscribers of the subtree matching the pattern
+  //----------------------------------------------------------------------------
+  static void Collect(const Node& node, const char* pattern,
+                      std::vector<T*>& out)
+  {
+    if (node.mValue && WildcardMatch(node.mName.c_str(), pattern)) {
+      out.push_back(node.mValue);
+    }
+
+    for (const auto& child : node.mChildren) {
+      Collect(*child.second, pattern, out);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  //! Drop all cached pattern results
+  //----------------------------------------------------------------------------
+  void ClearCache()
+  {
+    std::unique_lock<std::mutex> lock(mCacheMutex);
+    mCache.clear();
+  }
+
+  Node mRoot;
+  size_t mSize {0};
+  mutable std::mutex mCacheMutex; ///< Mutex protecting the pattern cache
+  mutable std::unordered_map<std::string, std::vector<T*>> mCache;
+};
+
+template<typename T>
+constexpr size_t XrdMqQueueIndex<T>::sMaxCacheEntries;
@@ -0,0 +1,211 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashCodec.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "mq/XrdMqSharedHashCodec.hh"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace
+{
+const char sDigits[] =
+  "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+//------------------------------------------------------------------------------
+// Get value of prefix digit or -1 if not a digit
+//------------------------------------------------------------------------------
+int
+DigitValue(char c)
+{
+  if ((c >= '0') && (c <= '9')) {
+    return c - '0';
+  } else if ((c >= 'A') && (c <= 'Z')) {
+    return c - 'A' + 10;
+  } else if ((c >= 'a') && (c <= 'z')) {
+    return c - 'a' + 36;
+  }
+
+  return -1;
+}
+}
+
+constexpr size_t XrdMqSharedHashCodec::sMaxPrefix;
+
+//------------------------------------------------------------------------------
+// Start the records of the next subject
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::NextSubject()
+{
+  if (mNumSubjects++) {
+    mOut += '%';
+  }
+
+  mLastKey.clear();
+}
+
+//------------------------------------------------------------------------------
+// Add key-value pair to the current subject
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::AddPair(const std::string& key, const std::string& value)
+{
+  AddKey(key);
+  mOut += '~';
+  mOut += value;
+}
+
+//------------------------------------------------------------------------------
+// Add deletion of key to the current subject
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::AddDeletion(const std::string& key)
+{
+  AddKey(key);
+}
+
+//------------------------------------------------------------------------------
+// Append the front coded key
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHashCodec::AddKey(const std::string& key)
+{
+  const size_t max = std::min({key.length(), mLastKey.length(), sMaxPrefix});
+  size_t shared = 0;
+
+  while ((shared < max) && (key[shared] == mLastKey[shared])) {
+    ++shared;
+  }
+
+  mOut += '|';
+  mOut += sDigits[shared];
+  mOut.append(key, shared, std::string::npos);
+  mLastKey = key;
+  ++mNumRecords;
+}
+
+//------------------------------------------------------------------------------
+// Decode records
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::Decode(const std::string& in,
+                             std::vector<std::vector<Record>>& subjects)
+{
+  subjects.clear();
+  subjects.emplace_back();
+  std::string last_key;
+  size_t pos = 0;
+
+  while (pos < in.length()) {
+    if (in[pos] == '%') {
+      subjects.emplace_back();
+      last_key.clear();
+      ++pos;
+      continue;
+    }
+
+    if ((in[pos] != '|') || (pos + 1 >= in.length())) {
+      return false;
+    }
+
+    const int shared = DigitValue(in[pos + 1]);
+
+    if ((shared < 0) || ((size_t) shared > last_key.length())) {
+      return false;
+    }
+
+    const size_t key_start = pos + 2;
+    const size_t key_end = std::min(in.find_first_of("~|%", key_start),
+                                    in.length());
+    Record rec;
+    rec.mKey.reserve(shared + key_end - key_start);
+    rec.mKey.assign(last_key, 0, shared);
+    rec.mKey.append(in, key_start, key_end - key_start);
+    pos = key_end;
+
+    if ((pos < in.length()) && (in[pos] == '~')) {
+      const size_t value_end = std::min(in.find_first_of("|%", pos + 1),
+                                        in.length());
+      rec.mValue.assign(in, pos + 1, value_end - pos - 1);
+      pos = value_end;
+    } else {
+      rec.mDeleted = true;
+    }
+
+    last_key = rec.mKey;
+    subjects.back().push_back(std::move(rec));
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Encode sequence range
+//------------------------------------------------------------------------------
+std::string
+XrdMqSharedHashCodec::EncodeRange(uint64_t epoch, uint64_t base, uint64_t seq)
+{
+  char buff[64];
+  snprintf(buff, sizeof(buff), "%" PRIx64 ".%" PRIu64 ".%" PRIu64, epoch,
+           base, seq);
+  return buff;
+}
+
+//------------------------------------------------------------------------------
+// Decode sequence range
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::DecodeRange(const std::string& in, uint64_t& epoch,
+                                  uint64_t& base, uint64_t& seq)
+{
+  int len = 0;
+
+  if ((sscanf(in.c_str(), "%" SCNx64 ".%" SCNu64 ".%" SCNu64 "%n", &epoch,
+              &base, &seq, &len) != 3) || ((size_t) len != in.length())) {
+    return false;
+  }
+
+  return (base <= seq);
+}
+
+//------------------------------------------------------------------------------
+// Encode the last change seen of a producer
+//------------------------------------------------------------------------------
+std::string
+XrdMqSharedHashCodec::EncodeSince(uint64_t epoch, uint64_t seq)
+{
+  char buff[48];
+  snprintf(buff, sizeof(buff), "%" PRIx64 ".%" PRIu64, epoch, seq);
+  return buff;
+}
+
+//------------------------------------------------------------------------------
+// Decode the last change seen of a producer
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHashCodec::DecodeSince(const std::string& in, uint64_t& epoch,
+                                  uint64_t& seq)
+{
+  int len = 0;
+  return ((sscanf(in.c_str(), "%" SCNx64 ".%" SCNu64 "%n", &epoch, &seq,
+                  &len) == 2) && ((size_t) len == in.length()));
+}
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+//! @file XrdMqSharedHashCodec.hh
+//! @brief Compact encoding of the shared hash delta messages
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+//! Class XrdMqSharedHashCodec
+//!
+//! Encodes the records of a delta message as "|<p><suffix>~<value>" where <p>
+//! is a single character [0-9A-Za-z] giving the number of leading characters
+//! shared with the previous key of the same subject, a deletion is a record
+//! without the "~<value>" part. Keys are expected in sorted order, as they
+//! come out of the maps and sets of the shared hash, so that the common
+//! "stat." prefixes are sent only once. The records of consecutive subjects
+//! are separated by '%'. Keys and values have the same restrictions as in the
+//! plain encoding i.e. they can not contain '&', '|', '~' or '%'.
+//!
+//! The message also carries for every subject the sequence range as
+//! "<epoch>.<base>.<seq>", the epoch in hex, meaning that the records bring
+//! the hash of the producer from change id <base> to <seq>.
+//------------------------------------------------------------------------------
+class XrdMqSharedHashCodec
+{
+public:
+  //! Max number of shared characters encoded in one prefix digit
+  static constexpr size_t sMaxPrefix = 61;
+
+  struct Record {
+    std::string mKey;
+    std::string mValue;
+    bool mDeleted {false};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Start the records of the next subject
+  //----------------------------------------------------------------------------
+  void NextSubject();
+
+  //----------------------------------------------------------------------------
+  //! Add key-value pair to the current subject
+  //----------------------------------------------------------------------------
+  void AddPair(const std::string& key, const std::string& value);
+
+  //----------------------------------------------------------------------------
+  //! Add deletion of key to the current subject
+  //----------------------------------------------------------------------------
+  void AddDeletion(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Get encoded records
+  //----------------------------------------------------------------------------
+  inline const std::string& GetOutput() const
+  {
+    return mOut;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get number of records encoded
+  //----------------------------------------------------------------------------
+  inline size_t GetNumRecords() const
+  {
+    return mNumRecords;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Decode records
+  //!
+  //! @param in encoded records
+  //! @param subjects records of each subject
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool Decode(const std::string& in,
+                     std::vector<std::vector<Record>>& subjects);
+
+  //----------------------------------------------------------------------------
+  //! Encode sequence range
+  //----------------------------------------------------------------------------
+  static std::string EncodeRange(uint64_t epoch, uint64_t base, uint64_t seq);
+
+  //----------------------------------------------------------------------------
+  //! Decode sequence range
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool DecodeRange(const std::string& in, uint64_t& epoch,
+                          uint64_t& base, uint64_t& seq);
+
+  //----------------------------------------------------------------------------
+  //! Encode the last change seen of a producer as "<epoch>.<seq>"
+  //----------------------------------------------------------------------------
+  static std::string EncodeSince(uint64_t epoch, uint64_t seq);
+
+  //----------------------------------------------------------------------------
+  //! Decode the last change seen of a producer
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  static bool DecodeSince(const std::string& in, uint64_t& epoch,
+                          uint64_t& seq);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Append the front coded key
+  //----------------------------------------------------------------------------
+  void AddKey(const std::string& key);
+
+  std::string mOut; ///< Encoded records
+  std::string mLastKey; ///< Last key of the current subject
+  size_t mNumSubjects {0}; ///< Number of subjects started
+  size_t mNumRecords {0}; ///< Number of records encoded
+};
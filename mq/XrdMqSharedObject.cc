@@ -31,6 +31,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <algorithm>
+#include <random>
 
 using eos::common::RWMutexReadLock;
 using eos::common::RWMutexWriteLock;
@@ -72,7 +73,7 @@ XrdMqSharedObjectChangeNotifier::tlSubscriber = NULL;
 // Constructor
 //------------------------------------------------------------------------------
 XrdMqSharedHashEntry::XrdMqSharedHashEntry():
-  mKey(""), mValue(""), mChangeId(0)
+  mKey(""), mValue(""), mChangeId(0), mEpoch(0)
 {
   mMtime.tv_sec = 0;
   mMtime.tv_usec = 0;
@@ -82,7 +83,7 @@ XrdMqSharedHashEntry::XrdMqSharedHashEntry():
 // Constructor with parameters
 //------------------------------------------------------------------------------
 XrdMqSharedHashEntry::XrdMqSharedHashEntry(const char* key, const char* value):
-  mChangeId(0)
+  mChangeId(0), mEpoch(0)
 {
   gettimeofday(&mMtime, 0);
   mKey = (key ? key : "");
@@ -97,6 +98,7 @@ XrdMqSharedHashEntry::operator=(const XrdMqSharedHashEntry& other)
 {
   if (this != &other) {
     mChangeId = other.mChangeId;
+    mEpoch = other.mEpoch;
     mKey = other.mKey;
     mValue = other.mValue;
     mMtime.tv_sec = other.mMtime.tv_sec;
@@ -119,7 +121,7 @@ XrdMqSharedHashEntry::XrdMqSharedHashEntry(const XrdMqSharedHashEntry& other)
 //----------------------------------------------------------------------------
 XrdMqSharedHashEntry::XrdMqSharedHashEntry(XrdMqSharedHashEntry&& other):
   mKey(std::move(other.mKey)), mValue(std::move(other.mValue)),
-  mChangeId(other.mChangeId), mMtime(other.mMtime)
+  mChangeId(other.mChangeId), mEpoch(other.mEpoch), mMtime(other.mMtime)
 {}
 
 //------------------------------------------------------------------------------
@@ -132,6 +134,7 @@ XrdMqSharedHashEntry::operator=(XrdMqSharedHashEntry&& other)
     mKey = std::move(other.mKey);
     mValue = std::move(other.mValue);
     mChangeId = other.mChangeId;
+    mEpoch = other.mEpoch;
     mMtime = other.mMtime;
   }
 
@@ -184,8 +187,15 @@ XrdMqSharedHash::XrdMqSharedHash(const char* subject, const char* bcast_queue,
                                  XrdMqSharedObjectManager* som):
   mType("hash"), mSOM(som), mSubject((subject ? subject : "")),
   mIsTransaction(false), mBroadcastQueue((bcast_queue ? bcast_queue : "")),
-  mTransactMutex(new XrdSysMutex()), mStoreMutex(new eos::common::RWMutex())
-{}
+  mTransactMutex(new XrdSysMutex()), mStoreMutex(new eos::common::RWMutex()),
+  mEpoch(0), mSeq(0), mFlushedSeq(0), mTombstoneFloor(0)
+{
+  std::random_device rd;
+
+  while (mEpoch == 0) {
+    mEpoch = ((uint64_t) rd() << 32) | rd();
+  }
+}
 
 //------------------------------------------------------------------------------
 // Move constructor
@@ -216,6 +226,13 @@ XrdMqSharedHash::operator=(XrdMqSharedHash&& other)
     std::swap(mTransactions, other.mTransactions);
     std::swap(mTransactMutex, other.mTransactMutex);
     std::swap(mStoreMutex, other.mStoreMutex);
+    mEpoch = other.mEpoch;
+    mSeq = other.mSeq;
+    mFlushedSeq = other.mFlushedSeq.load();
+    std::swap(mTombstones, other.mTombstones);
+    std::swap(mTombstoneSeqs, other.mTombstoneSeqs);
+    mTombstoneFloor = other.mTombstoneFloor;
+    std::swap(mRemoteStreams, other.mRemoteStreams);
   }
 
   return *this;
@@ -354,6 +371,19 @@ XrdMqSharedHash::CloseTransaction()
 {
   bool retval = true;
 
+  if (mSOM->mBroadcast && IsDeltaSync()) {
+    // Modifications and deletions go out together in one delta message
+    if (mTransactions.size() || mDeletions.size()) {
+      retval = SendDelta();
+    }
+
+    mDeletions.clear();
+    mTransactions.clear();
+    mIsTransaction = false;
+    mTransactMutex->UnLock();
+    return retval;
+  }
+
   if (mSOM->mBroadcast && mTransactions.size()) {
     XrdOucString txmessage = "";
     MakeUpdateEnvHeader(txmessage);
@@ -485,8 +515,13 @@ XrdMqSharedHash::MakeRemoveEnvHeader(XrdOucString& out)
 // Broadcast hash as env string
 //-------------------------------------------------------------------------------
 bool
-XrdMqSharedHash::BroadCastEnvString(const char* receiver)
+XrdMqSharedHash::BroadCastEnvString(const char* receiver,
+                                    const std::string& since)
 {
+  if (IsDeltaSync()) {
+    return SendSyncReply(receiver, since);
+  }
+
   XrdOucString txmessage = "";
   {
     XrdSysMutexHelper lock(*mTransactMutex);
@@ -588,6 +623,33 @@ XrdMqSharedHash::AddDeletionsToEnvString(XrdOucString& out)
 //-------------------------------------------------------------------------------
 bool
 XrdMqSharedHash::BroadcastRequest(const char* req_target)
+{
+  std::string since;
+
+  if (IsDeltaSync()) {
+    RWMutexReadLock rd_lock(*mStoreMutex);
+    const RemoteStream* latest = nullptr;
+
+    for (const auto& stream : mRemoteStreams) {
+      if (!latest || (stream.mLastUpdate > latest->mLastUpdate)) {
+        latest = &stream;
+      }
+    }
+
+    if (latest) {
+      since = XrdMqSharedHashCodec::EncodeSince(latest->mEpoch, latest->mSeq);
+    }
+  }
+
+  return SendBroadcastRequest(req_target, since);
+}
+
+//-------------------------------------------------------------------------------
+// Send broadcast request
+//-------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::SendBroadcastRequest(const char* req_target,
+                                      const std::string& since)
 {
   XrdOucString out;
   XrdMqMessage message("XrdMqSharedHashMessage");
@@ -604,6 +666,14 @@ XrdMqSharedHash::BroadcastRequest(const char* req_target)
   out += XRDMQSHAREDHASH_TYPE;
   out += "=";
   out += mType.c_str();
+
+  if (!since.empty()) {
+    out += "&";
+    out += XRDMQSHAREDHASH_SINCE;
+    out += "=";
+    out += since.c_str();
+  }
+
   message.SetBody(out.c_str());
   message.MarkAsMonitor();
   return XrdMqMessaging::gMessageClient.SendMessage(message, req_target, false,
@@ -642,6 +712,10 @@ XrdMqSharedHash::Delete(const std::string& key, bool broadcast)
     deleted = true;
 
     if (mSOM->mBroadcast && broadcast) {
+      if (IsDeltaSync()) {
+        AddTombstone(key);
+      }
+
       // Emulate transaction for single shot deletions
       if (!mIsTransaction) {
         mTransactMutex->Lock();
@@ -693,6 +767,10 @@ XrdMqSharedHash::Clear(bool broadcast)
     if (mIsTransaction) {
       if (mSOM->mBroadcast && broadcast) {
         mDeletions.insert(it->first);
+
+        if (IsDeltaSync()) {
+          AddTombstone(it->first);
+        }
       }
 
       mTransactions.erase(it->first);
@@ -709,17 +787,31 @@ bool
 XrdMqSharedHash::SetImpl(const char* key, const char* value, bool broadcast)
 {
   std::string skey = key;
+  bool changed = true;
   {
     RWMutexWriteLock wr_lock(*mStoreMutex);
+    auto it = mStore.find(skey);
+    XrdMqSharedHashEntry entry(key, value);
+    EraseTombstone(skey);
+
+    if (mSOM->mBroadcast && broadcast && IsDeltaSync()) {
+      // Only actual changes get a change id and are replicated
+      if ((it != mStore.end()) && (strcmp(it->second.GetValue(), value) == 0)) {
+        changed = false;
+        entry.SetChangeId(it->second.GetEpoch(), it->second.GetChangeId());
+      } else {
+        entry.SetChangeId(mEpoch, ++mSeq);
+      }
+    }
 
-    if (mStore.count(skey) == 0) {
-      mStore.insert(std::make_pair(skey, XrdMqSharedHashEntry(key, value)));
+    if (it == mStore.end()) {
+      mStore.insert(std::make_pair(skey, std::move(entry)));
     } else {
-      mStore[skey] = XrdMqSharedHashEntry(key, value);
+      it->second = std::move(entry);
     }
   }
 
-  if (mSOM->mBroadcast && broadcast) {
+  if (mSOM->mBroadcast && broadcast && changed) {
     bool is_transact = false;
 
     // mSOM->IsMuxTransaction is tested first to avoid contention on the
@@ -773,6 +865,342 @@ XrdMqSharedHash::SetImpl(const char* key, const char* value, bool broadcast)
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Check if changes are replicated as deltas
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::IsDeltaSync() const
+{
+  // Queues keep the plain messages since they rely on the order of the keys
+  return (mSOM && mSOM->mDeltaSync && (mType == "hash"));
+}
+
+//------------------------------------------------------------------------------
+// Remember deletion of a key
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::AddTombstone(const std::string& key)
+{
+  EraseTombstone(key);
+  const uint64_t seq = ++mSeq;
+  mTombstones[key] = seq;
+  mTombstoneSeqs[seq] = key;
+
+  if (mTombstones.size() > sMaxTombstones) {
+    // Receivers which did not see the oldest deletion get a snapshot
+    auto oldest = mTombstoneSeqs.begin();
+    mTombstoneFloor = oldest->first;
+    mTombstones.erase(oldest->second);
+    mTombstoneSeqs.erase(oldest);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Forget deletion of a key
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::EraseTombstone(const std::string& key)
+{
+  auto it = mTombstones.find(key);
+
+  if (it != mTombstones.end()) {
+    mTombstoneSeqs.erase(it->second);
+    mTombstones.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Take the range of change ids covered by the message being built
+//------------------------------------------------------------------------------
+std::string
+XrdMqSharedHash::TakeSeqRange()
+{
+  const uint64_t seq = mSeq;
+  uint64_t base = mFlushedSeq.load();
+
+  // The flushes of a mux and of a hash transaction can overtake each other,
+  // the one coming second then covers no new range
+  while ((base < seq) && !mFlushedSeq.compare_exchange_weak(base, seq)) {}
+
+  return XrdMqSharedHashCodec::EncodeRange(mEpoch, std::min(base, seq), seq);
+}
+
+//------------------------------------------------------------------------------
+// Add the given keys as delta records
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::AddDeltaRecords(XrdMqSharedHashCodec& codec,
+                                 const std::set<std::string>& keys,
+                                 const std::set<std::string>& deletions)
+{
+  auto it_key = keys.begin();
+  auto it_del = deletions.begin();
+
+  // Merge both sets to keep the keys sorted
+  while ((it_key != keys.end()) || (it_del != deletions.end())) {
+    bool deleted = false;
+    const std::string* key;
+
+    if ((it_del == deletions.end()) ||
+        ((it_key != keys.end()) && (*it_key <= *it_del))) {
+      key = &*it_key;
+
+      if ((it_del != deletions.end()) && (*it_del == *it_key)) {
+        deleted = true;
+        ++it_del;
+      }
+
+      ++it_key;
+    } else {
+      key = &*it_del;
+      deleted = true;
+      ++it_del;
+    }
+
+    auto it = mStore.find(*key);
+
+    if (it != mStore.end()) {
+      codec.AddPair(*key, it->second.GetValue());
+    } else if (deleted) {
+      codec.AddDeletion(*key);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Build delta or snapshot message
+//------------------------------------------------------------------------------
+static std::string
+MakeDeltaEnvString(const char* cmd, const std::string& subjects,
+                   const std::string& type, const std::string& ranges,
+                   const std::string& pairs)
+{
+  std::string out = cmd;
+  out.reserve(out.length() + subjects.length() + ranges.length() +
+              pairs.length() + 64);
+  out += "&";
+  out += XRDMQSHAREDHASH_SUBJECT;
+  out += "=";
+  out += subjects;
+  out += "&";
+  out += XRDMQSHAREDHASH_TYPE;
+  out += "=";
+  out += type;
+  out += "&";
+  out += XRDMQSHAREDHASH_SEQ;
+  out += "=";
+  out += ranges;
+  out += "&";
+  out += XRDMQSHAREDHASH_PAIRS;
+  out += "=";
+  out += pairs;
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Send the pending transactions and deletions as delta message
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::SendDelta()
+{
+  XrdMqSharedHashCodec codec;
+  std::string range;
+  {
+    RWMutexReadLock rd_lock(*mStoreMutex);
+    codec.NextSubject();
+    AddDeltaRecords(codec, mTransactions, mDeletions);
+    range = TakeSeqRange();
+  }
+  XrdMqMessage message("XrdMqSharedHashMessage");
+  message.SetBody(MakeDeltaEnvString(XRDMQSHAREDHASH_DELTA, mSubject, mType,
+                                     range, codec.GetOutput()).c_str());
+  message.MarkAsMonitor();
+  return XrdMqMessaging::gMessageClient.SendMessage(message,
+         mBroadcastQueue.c_str(), false, false, true);
+}
+
+//------------------------------------------------------------------------------
+// Reply to a broadcast request in delta mode
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedHash::SendSyncReply(const char* receiver, const std::string& since)
+{
+  uint64_t since_epoch = 0;
+  uint64_t since_seq = 0;
+  bool snapshot = true;
+  std::string range;
+  XrdMqSharedHashCodec codec;
+  codec.NextSubject();
+  {
+    RWMutexReadLock rd_lock(*mStoreMutex);
+
+    if (XrdMqSharedHashCodec::DecodeSince(since, since_epoch, since_seq) &&
+        (since_epoch == mEpoch) && (since_seq >= mTombstoneFloor) &&
+        (since_seq <= mSeq)) {
+      // Only the local changes and deletions the receiver has not seen, in
+      // key order
+      snapshot = false;
+      auto it_del = mTombstones.begin();
+
+      for (auto it = mStore.begin(); it != mStore.end(); ++it) {
+        for (; (it_del != mTombstones.end()) && (it_del->first < it->first);
+             ++it_del) {
+          if (it_del->second > since_seq) {
+            codec.AddDeletion(it_del->first);
+          }
+        }
+
+        if ((it->second.GetEpoch() == mEpoch) &&
+            (it->second.GetChangeId() > since_seq)) {
+          codec.AddPair(it->first, it->second.GetValue());
+        }
+      }
+
+      for (; it_del != mTombstones.end(); ++it_del) {
+        if (it_del->second > since_seq) {
+          codec.AddDeletion(it_del->first);
+        }
+      }
+
+      range = XrdMqSharedHashCodec::EncodeRange(mEpoch, since_seq, mSeq);
+    } else {
+      for (auto it = mStore.begin(); it != mStore.end(); ++it) {
+        codec.AddPair(it->first, it->second.GetValue());
+      }
+
+      range = XrdMqSharedHashCodec::EncodeRange(mEpoch, 0, mSeq);
+    }
+  }
+
+  if (mSOM->mBroadcast) {
+    std::string txmessage = MakeDeltaEnvString
+                            (snapshot ? XRDMQSHAREDHASH_SNAPSHOT : XRDMQSHAREDHASH_DELTA,
+                             mSubject, mType, range, codec.GetOutput());
+    XrdMqMessage message("XrdMqSharedHashMessage");
+    message.SetBody(txmessage.c_str());
+    message.MarkAsMonitor();
+
+    if (XrdMqSharedObjectManager::sDebug) {
+      fprintf(stderr,
+              "XrdMqSharedObjectManager::SendSyncReply=>[%s]=>%s msg=%s\n",
+              mSubject.c_str(), receiver, txmessage.c_str());
+    }
+
+    return XrdMqMessaging::gMessageClient.SendMessage(message, receiver, false,
+           false, true);
+  }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Apply records received from a remote producer
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::ApplyDelta(const std::vector<XrdMqSharedHashCodec::Record>&
+                            records, uint64_t epoch, uint64_t base,
+                            uint64_t seq, bool snapshot, std::string& since)
+{
+  std::vector<std::pair<std::string, int>> events;
+  {
+    RWMutexWriteLock wr_lock(*mStoreMutex);
+
+    if (snapshot) {
+      mStore.clear();
+    }
+
+    for (const auto& rec : records) {
+      auto it = mStore.find(rec.mKey);
+
+      // Skip records overtaken by a newer change of the same producer
+      if ((it != mStore.end()) && (it->second.GetEpoch() == epoch) &&
+          (it->second.GetChangeId() > seq)) {
+        continue;
+      }
+
+      if (rec.mDeleted) {
+        if (it != mStore.end()) {
+          mStore.erase(it);
+          events.emplace_back(rec.mKey,
+                              XrdMqSharedObjectManager::kMqSubjectKeyDeletion);
+        }
+
+        continue;
+      }
+
+      XrdMqSharedHashEntry entry(rec.mKey.c_str(), rec.mValue.c_str());
+      entry.SetChangeId(epoch, seq);
+      EraseTombstone(rec.mKey);
+
+      if (it == mStore.end()) {
+        mStore.insert(std::make_pair(rec.mKey, std::move(entry)));
+      } else {
+        it->second = std::move(entry);
+      }
+
+      events.emplace_back(rec.mKey,
+                          XrdMqSharedObjectManager::kMqSubjectModification);
+    }
+
+    const time_t now = time(NULL);
+    auto stream = std::find_if(mRemoteStreams.begin(), mRemoteStreams.end(),
+    [epoch](const RemoteStream & elem) {
+      return (elem.mEpoch == epoch);
+    });
+
+    if (stream == mRemoteStreams.end()) {
+      if (mRemoteStreams.size() < sMaxRemoteStreams) {
+        stream = mRemoteStreams.emplace(mRemoteStreams.end());
+      } else {
+        // Replace the producer not heard of for the longest time
+        stream = std::min_element(mRemoteStreams.begin(), mRemoteStreams.end(),
+        [](const RemoteStream & a, const RemoteStream & b) {
+          return (a.mLastUpdate < b.mLastUpdate);
+        });
+        *stream = RemoteStream();
+      }
+
+      stream->mEpoch = epoch;
+    }
+
+    stream->mLastUpdate = now;
+
+    if (snapshot) {
+      stream->mSeq = seq;
+    } else if (stream->mSeq >= base) {
+      stream->mSeq = std::max(stream->mSeq, seq);
+    } else if (now - stream->mRequested >= sSyncRetrySec) {
+      // Changes were missed, ask the producer for them
+      stream->mRequested = now;
+      since = XrdMqSharedHashCodec::EncodeSince(epoch, stream->mSeq);
+    }
+  }
+  PostNotifications(events);
+}
+
+//------------------------------------------------------------------------------
+// Queue notifications for keys of this hash
+//------------------------------------------------------------------------------
+void
+XrdMqSharedHash::PostNotifications(const std::vector<std::pair<std::string, int>>&
+                                   events)
+{
+  if (!mSOM || events.empty()) {
+    return;
+  }
+
+  XrdSysMutexHelper lock(mSOM->mSubjectsMutex);
+
+  for (const auto& event : events) {
+    std::string fkey = mSubject;
+    fkey += ";";
+    fkey += event.first;
+    mSOM->mNotificationSubjects.emplace_back
+    (fkey, (XrdMqSharedObjectManager::notification_t) event.second);
+    mSOM->SubjectsSem.Post();
+  }
+}
+
 //------------------------------------------------------------------------------
 //                 * * * Class XrdMqSharedQueue  * * *
 //------------------------------------------------------------------------------
@@ -2299,6 +2727,8 @@ XrdMqSharedObjectManager::XrdMqSharedObjectManager():
   AutoReplyQueue = "";
   AutoReplyQueueDerive = false;
   IsMuxTransaction = false;
+  const char* delta = getenv("EOS_MQ_SHARED_HASH_DELTA");
+  mDeltaSync = (delta && (strcmp(delta, "1") == 0));
   {
     XrdSysMutexHelper mLock(MuxTransactionsMutex);
     MuxTransactions.clear();
@@ -2936,8 +3366,18 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
         return true;
       }
 
+      if ((ftag == XRDMQSHAREDHASH_DELTA) || (ftag == XRDMQSHAREDHASH_SNAPSHOT)) {
+        return ApplyDeltaMessage(env, subjectlist, type,
+                                 message->kMessageHeader.kSenderId.c_str(),
+                                 (ftag == XRDMQSHAREDHASH_SNAPSHOT), error);
+      }
+
       if (ftag == XRDMQSHAREDHASH_BCREQUEST) {
         bool success = true;
+        // The last change seen only makes sense for a single subject
+        std::string since = ((env.Get(XRDMQSHAREDHASH_SINCE) &&
+                              (subjectlist.size() == 1)) ?
+                             env.Get(XRDMQSHAREDHASH_SINCE) : "");
 
         for (unsigned int l = 0; l < subjectlist.size(); l++) {
           // try 'queue' and 'hash' to have wildcard broadcasts for both
@@ -2948,7 +3388,7 @@ XrdMqSharedObjectManager::ParseEnvMessage(XrdMqMessage* message,
           }
 
           if (sh) {
-            success *= sh->BroadCastEnvString(reply.c_str());
+            success *= sh->BroadCastEnvString(reply.c_str(), since);
           }
         }
 
@@ -3037,7 +3477,9 @@ XrdMqSharedObjectManager::CloseMuxTransaction()
   // no deletions of subjects
   XrdSysMutexHelper mLock(MuxTransactionsMutex);
 
-  if (MuxTransactions.size()) {
+  if (MuxTransactions.size() && mDeltaSync) {
+    SendMuxDelta();
+  } else if (MuxTransactions.size()) {
     XrdOucString txmessage = "";
     MakeMuxUpdateEnvHeader(txmessage);
     AddMuxTransactionEnvString(txmessage);
@@ -3130,6 +3572,107 @@ XrdMqSharedObjectManager::AddMuxTransactionEnvString(XrdOucString& out)
 }
 
 
+//------------------------------------------------------------------------------
+// Send the mux transaction as one delta message for all its subjects
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedObjectManager::SendMuxDelta()
+{
+  static const std::set<std::string> no_deletions;
+  XrdMqSharedHashCodec codec;
+  std::string subjects;
+  std::string ranges;
+
+  for (auto it_subj = MuxTransactions.begin(); it_subj != MuxTransactions.end();
+       ++it_subj) {
+    XrdMqSharedHash* hash = GetObject(it_subj->first.c_str(),
+                                      MuxTransactionType.c_str());
+
+    if (!hash) {
+      continue;
+    }
+
+    if (!subjects.empty()) {
+      subjects += "%";
+      ranges += "%";
+    }
+
+    RWMutexReadLock lock(*(hash->mStoreMutex));
+    codec.NextSubject();
+    hash->AddDeltaRecords(codec, it_subj->second, no_deletions);
+    subjects += it_subj->first;
+    ranges += hash->TakeSeqRange();
+  }
+
+  if (subjects.empty()) {
+    return true;
+  }
+
+  XrdMqMessage message("XrdMqSharedHashMessage");
+  message.SetBody(MakeDeltaEnvString(XRDMQSHAREDHASH_DELTA, subjects,
+                                     MuxTransactionType, ranges,
+                                     codec.GetOutput()).c_str());
+  message.MarkAsMonitor();
+  return XrdMqMessaging::gMessageClient.SendMessage(message,
+         MuxTransactionBroadCastQueue.c_str(), false, false, true);
+}
+
+//------------------------------------------------------------------------------
+// Apply delta or snapshot message
+//------------------------------------------------------------------------------
+bool
+XrdMqSharedObjectManager::ApplyDeltaMessage(XrdOucEnv& env,
+    const std::vector<std::string>& subjects, const std::string& type,
+    const std::string& sender, bool snapshot, XrdOucString& error)
+{
+  std::string pairs = (env.Get(XRDMQSHAREDHASH_PAIRS) ?
+                       env.Get(XRDMQSHAREDHASH_PAIRS) : "");
+  std::string seqs = (env.Get(XRDMQSHAREDHASH_SEQ) ?
+                      env.Get(XRDMQSHAREDHASH_SEQ) : "");
+  std::vector<std::string> ranges;
+  std::vector<std::vector<XrdMqSharedHashCodec::Record>> records;
+  eos::common::StringConversion::Tokenize(seqs, ranges, "%");
+
+  if (!XrdMqSharedHashCodec::Decode(pairs, records) ||
+      (records.size() != subjects.size()) ||
+      (ranges.size() != subjects.size())) {
+    error = "delta: parsing error in pairs or seq tag";
+    return false;
+  }
+
+  for (size_t i = 0; i < subjects.size(); ++i) {
+    uint64_t epoch, base, seq;
+    XrdMqSharedHash* sh = GetObject(subjects[i].c_str(), type.c_str());
+
+    if (!sh) {
+      error = "delta: subject ";
+      error += subjects[i].c_str();
+      error += " does not exist";
+      return false;
+    }
+
+    if (!XrdMqSharedHashCodec::DecodeRange(ranges[i], epoch, base, seq)) {
+      error = "delta: parsing error in seq tag";
+      return false;
+    }
+
+    std::string since;
+    sh->ApplyDelta(records[i], epoch, base, seq, snapshot, since);
+
+    if (!since.empty() && !sender.empty()) {
+      if (sDebug) {
+        fprintf(stderr, "XrdMqSharedObjectManager::ApplyDeltaMessage=>[%s] "
+                "missed changes after %s, asking %s\n", subjects[i].c_str(),
+                since.c_str(), sender.c_str());
+      }
+
+      sh->SendBroadcastRequest(sender.c_str(), since);
+    }
+  }
+
+  return true;
+}
+
 //-------------------------------------------------------------------------------
 //
 //-------------------------------------------------------------------------------
@@ -32,6 +32,7 @@
 #include "common/RWMutex.hh"
 #include "common/Logging.hh"
 #include "common/table_formatter/TableCell.hh"
+#include "mq/XrdMqSharedHashCodec.hh"
 #include <string>
 #include <map>
 #include <vector>
@@ -47,14 +48,19 @@
 #define XRDMQSHAREDHASH_BCREPLY   "mqsh.cmd=bcreply"
 #define XRDMQSHAREDHASH_DELETE    "mqsh.cmd=delete"
 #define XRDMQSHAREDHASH_REMOVE    "mqsh.cmd=remove"
+#define XRDMQSHAREDHASH_DELTA     "mqsh.cmd=delta"
+#define XRDMQSHAREDHASH_SNAPSHOT  "mqsh.cmd=snapshot"
 #define XRDMQSHAREDHASH_SUBJECT   "mqsh.subject"
 #define XRDMQSHAREDHASH_PAIRS     "mqsh.pairs"
 #define XRDMQSHAREDHASH_KEYS      "mqsh.keys"
 #define XRDMQSHAREDHASH_REPLY     "mqsh.reply"
 #define XRDMQSHAREDHASH_TYPE      "mqsh.type"
+#define XRDMQSHAREDHASH_SEQ       "mqsh.seq"
+#define XRDMQSHAREDHASH_SINCE     "mqsh.since"
 
-//! Forward declaration
+//! Forward declarations
 class XrdMqSharedObjectManager;
+class XrdOucEnv;
 
 //------------------------------------------------------------------------------
 //! Class XrdMqSharedHashEntry
@@ -144,6 +150,28 @@ public:
     return mChangeId;
   }
 
+  //----------------------------------------------------------------------------
+  //! Get epoch of the producer the change id refers to
+  //!
+  //! @return epoch value, 0 if the change was not produced in delta mode
+  //----------------------------------------------------------------------------
+  inline unsigned long long GetEpoch() const
+  {
+    return mEpoch;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Set change id
+  //!
+  //! @param epoch epoch of the producer
+  //! @param cid change id in the sequence of the producer
+  //----------------------------------------------------------------------------
+  inline void SetChangeId(unsigned long long epoch, unsigned long long cid)
+  {
+    mEpoch = epoch;
+    mChangeId = cid;
+  }
+
   //----------------------------------------------------------------------------
   //! Get age in milliseconds
   //!
@@ -169,6 +197,7 @@ private:
   std::string mKey; ///< Entry key value
   std::string mValue; ///< Entry value
   unsigned long long mChangeId; ///< Entry change id i.e. epoch
+  unsigned long long mEpoch; ///< Epoch of the producer of the change id
   struct timeval mMtime; ///< Last modification time of current entry
 };
 
@@ -305,7 +334,9 @@ public:
   }
 
   //----------------------------------------------------------------------------
-  //! Build and send the broadcast request
+  //! Build and send the broadcast request. In delta mode the request carries
+  //! the last change seen from the producer so that it only replies with what
+  //! changed since.
   //!
   //! @param req_target queue name which should respond or otherwise the default
   //!        broadcast queue
@@ -417,6 +448,21 @@ protected:
   bool SetImpl(const char* key, const char* value,  bool broadcast);
 
 private:
+  //! Max number of deletions remembered to serve delta requests
+  static constexpr size_t sMaxTombstones = 4096;
+  //! Max number of remote producers tracked per hash
+  static constexpr size_t sMaxRemoteStreams = 8;
+  //! Min seconds between two delta requests to the same producer
+  static constexpr time_t sSyncRetrySec = 5;
+
+  //! Sync state of a remote producer of this hash
+  struct RemoteStream {
+    uint64_t mEpoch {0}; ///< Epoch of the producer
+    uint64_t mSeq {0}; ///< All changes up to this one were received
+    time_t mLastUpdate {0}; ///< Time of the last message received
+    time_t mRequested {0}; ///< Time of the last delta request
+  };
+
   std::string mSubject; ///< Hash subject
   std::atomic<bool> mIsTransaction; ///< True if ongoing transaction
   std::string mBroadcastQueue; ///< Name of the broadcast queue
@@ -426,6 +472,108 @@ private:
   std::unique_ptr<XrdSysMutex> mTransactMutex;
   //! RW Mutex protecting the mStore object
   std::unique_ptr<eos::common::RWMutex> mStoreMutex;
+  //! Random epoch of the local changes, a restarted producer starts over
+  uint64_t mEpoch;
+  uint64_t mSeq; ///< Change id of the last local change, under mStoreMutex
+  std::atomic<uint64_t> mFlushedSeq; ///< Highest change id sent out
+  //! Deleted keys and their change ids, under mStoreMutex
+  std::map<std::string, uint64_t> mTombstones;
+  std::map<uint64_t, std::string> mTombstoneSeqs; ///< Reverse of mTombstones
+  //! Deletions up to this change id may have been forgotten
+  uint64_t mTombstoneFloor;
+  //! Sync state of the remote producers, under mStoreMutex
+  std::vector<RemoteStream> mRemoteStreams;
+
+  //----------------------------------------------------------------------------
+  //! Check if changes are replicated as deltas
+  //----------------------------------------------------------------------------
+  bool IsDeltaSync() const;
+
+  //----------------------------------------------------------------------------
+  //! Remember deletion of a key - must be called with mStoreMutex write locked
+  //!
+  //! @param key deleted key
+  //----------------------------------------------------------------------------
+  void AddTombstone(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Forget deletion of a key - must be called with mStoreMutex write locked
+  //!
+  //! @param key key set again
+  //----------------------------------------------------------------------------
+  void EraseTombstone(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Take the range of change ids covered by the message being built - must
+  //! be called with mStoreMutex locked
+  //!
+  //! @return encoded sequence range
+  //----------------------------------------------------------------------------
+  std::string TakeSeqRange();
+
+  //----------------------------------------------------------------------------
+  //! Add the given keys as delta records, keys no longer in the store are
+  //! added as deletions if listed in the deletions - must be called with
+  //! mStoreMutex locked
+  //!
+  //! @param codec delta encoder
+  //! @param keys modified keys
+  //! @param deletions deleted keys
+  //----------------------------------------------------------------------------
+  void AddDeltaRecords(XrdMqSharedHashCodec& codec,
+                       const std::set<std::string>& keys,
+                       const std::set<std::string>& deletions);
+
+  //----------------------------------------------------------------------------
+  //! Send the pending transactions and deletions as delta message - must be
+  //! called with the mTransactMutex locked
+  //!
+  //! @return true if message sent successfully, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendDelta();
+
+  //----------------------------------------------------------------------------
+  //! Reply to a broadcast request in delta mode, with the changes since the
+  //! given one if still known, otherwise with a snapshot of the hash
+  //!
+  //! @param receiver target of the reply
+  //! @param since last change seen by the receiver, can be empty
+  //!
+  //! @return true if message sent successfully, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendSyncReply(const char* receiver, const std::string& since);
+
+  //----------------------------------------------------------------------------
+  //! Send broadcast request
+  //!
+  //! @param req_target queue name which should respond
+  //! @param since last change seen, can be empty
+  //!
+  //! @return true if message sent successfully, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendBroadcastRequest(const char* req_target, const std::string& since);
+
+  //----------------------------------------------------------------------------
+  //! Apply records received from a remote producer without broadcasting them
+  //!
+  //! @param records decoded records
+  //! @param epoch epoch of the producer
+  //! @param base change id the records start from
+  //! @param seq change id the records bring the hash to
+  //! @param snapshot if true the records replace the hash contents
+  //! @param since set to the last change seen if changes were missed and
+  //!        should be requested from the producer, otherwise left empty
+  //----------------------------------------------------------------------------
+  void ApplyDelta(const std::vector<XrdMqSharedHashCodec::Record>& records,
+                  uint64_t epoch, uint64_t base, uint64_t seq, bool snapshot,
+                  std::string& since);
+
+  //----------------------------------------------------------------------------
+  //! Queue notifications for keys of this hash
+  //!
+  //! @param events list of keys and XrdMqSharedObjectManager::notification_t
+  //----------------------------------------------------------------------------
+  void PostNotifications(const std::vector<std::pair<std::string, int>>& events);
 
   //----------------------------------------------------------------------------
   //! Construct broadcast env header
@@ -474,10 +622,11 @@ private:
   //! Broadcast hash as env string
   //!
   //! @param receiver target of the broadcast message
+  //! @param since last change seen by the receiver, only used in delta mode
   //!
   //! @return true if message sent successful, otherwise false
   //----------------------------------------------------------------------------
-  bool BroadCastEnvString(const char* receiver);
+  bool BroadCastEnvString(const char* receiver, const std::string& since = "");
 };
 
 
@@ -642,6 +791,27 @@ public:
     return mBroadcast;
   }
 
+  //----------------------------------------------------------------------------
+  //! Switch to replicate the hash changes as delta messages with per-hash
+  //! sequence numbers instead of the plain update messages. All the nodes
+  //! sharing the hashes must support the delta messages. Default taken from
+  //! the EOS_MQ_SHARED_HASH_DELTA environment variable.
+  //!
+  //! @param enable if true enable delta mode, otherwise disable
+  //----------------------------------------------------------------------------
+  inline void EnableDeltaSync(bool enable)
+  {
+    mDeltaSync = enable;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Indicate if changes are replicated as delta messages
+  //----------------------------------------------------------------------------
+  inline bool IsDeltaSync() const
+  {
+    return mDeltaSync;
+  }
+
   //----------------------------------------------------------------------------
   //!
   //----------------------------------------------------------------------------
@@ -750,6 +920,24 @@ public:
   //----------------------------------------------------------------------------
   bool ParseEnvMessage(XrdMqMessage* message, XrdOucString& error);
 
+  //----------------------------------------------------------------------------
+  //! Apply delta or snapshot message - must be called with the HashMutex
+  //! read locked
+  //!
+  //! @param env message contents
+  //! @param subjects subjects of the message
+  //! @param type type of the shared objects
+  //! @param sender queue of the producer
+  //! @param snapshot if true the message is a snapshot
+  //! @param error error message if any
+  //!
+  //! @return true if successful, otherwise false
+  //----------------------------------------------------------------------------
+  bool ApplyDeltaMessage(XrdOucEnv& env,
+                         const std::vector<std::string>& subjects,
+                         const std::string& type, const std::string& sender,
+                         bool snapshot, XrdOucString& error);
+
   //----------------------------------------------------------------------------
   //! Set debug level
   //!
@@ -797,6 +985,14 @@ public:
   //----------------------------------------------------------------------------
   void AddMuxTransactionEnvString(XrdOucString& out);
 
+  //----------------------------------------------------------------------------
+  //! Send the mux transaction as one delta message for all its subjects -
+  //! must be called with the MuxTransactionsMutex locked
+  //!
+  //! @return true if message sent successfully, otherwise false
+  //----------------------------------------------------------------------------
+  bool SendMuxDelta();
+
 protected:
   XrdSysMutex MuxTransactionsMutex; ///< protects the mux transaction map
   std::string MuxTransactionType; ///<
@@ -811,6 +1007,7 @@ protected:
 
 private:
   std::atomic<bool> mBroadcast {true}; ///< Broadcast mode, default on
+  std::atomic<bool> mDeltaSync {false}; ///< Delta replication mode
   AssistedThread mDumperTid; ///< Dumper thread tid
   ///! Map of subjects to shared hash objects
   std::map<std::string, XrdMqSharedHash*> mHashSubjects;
@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+// File: XrdMqBrokerBench.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Throughput benchmark of the broker delivery path: routing through the
+// subscription index, shared payload fan-out into the output queues and the
+// collection by the connected clients, all in-process without XRootD. Every
+// simulated FST has its own output queue, the MGM broadcasts a configurable
+// share of the messages to all of them with "/eos/*/fst" and sends the rest
+// to a single FST. With --linear the queues are matched one by one as done
+// by the broker before the subscription index existed.
+//------------------------------------------------------------------------------
+
+#include "mq/XrdMqMessageOut.hh"
+#include "mq/XrdMqQueueIndex.hh"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+  uint64_t num_queues = 2000;
+  uint64_t num_msgs = 20000;
+  uint64_t num_senders = 4;
+  uint64_t num_receivers = 8;
+  uint64_t bcast_pct = 10;
+  uint64_t msg_size = 512;
+  bool linear = false;
+  std::vector<std::string> args;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--linear")) {
+      linear = true;
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+
+  if ((args.size() > 5) || ((args.size() >= 1) && (args[0] == "-h"))) {
+    std::cerr << "Usage: " << argv[0] << " [--linear] [num_queues] [num_msgs] "
+              << "[num_senders] [broadcast_percent] [msg_size]" << std::endl;
+    exit(-1);
+  }
+
+  uint64_t* params[] = {&num_queues, &num_msgs, &num_senders, &bcast_pct,
+                        &msg_size
+                       };
+
+  for (size_t i = 0; i < args.size(); ++i) {
+    *params[i] = std::stoull(args[i]);
+  }
+
+  num_senders = std::max(num_senders, (uint64_t) 1);
+  std::vector<std::unique_ptr<XrdMqMessageOut>> queues;
+  std::map<std::string, XrdMqMessageOut*> queue_map;
+  XrdMqQueueIndex<XrdMqMessageOut> index;
+  std::shared_timed_mutex mutex;
+
+  for (uint64_t i = 0; i < num_queues; ++i) {
+    std::string name = "/eos/fst" + std::to_string(i) + ".cern.ch:1095/fst";
+    queues.emplace_back(new XrdMqMessageOut(name.c_str()));
+    queue_map[name] = queues.back().get();
+    index.Insert(name, queues.back().get());
+  }
+
+  const std::string bcast_pattern = "/eos/*/fst";
+  std::atomic<uint64_t> deliveries {0};
+  std::atomic<uint64_t> bytes_read {0};
+  std::atomic<bool> sending {true};
+  auto start = std::chrono::steady_clock::now();
+  // Receivers collect the messages of their share of the queues
+  std::vector<std::thread> receivers;
+
+  for (uint64_t r = 0; r < num_receivers; ++r) {
+    receivers.emplace_back([&, r]() {
+      std::vector<char> buffer(1024 * 1024);
+
+      while (true) {
+        const bool last_round = !sending;
+        uint64_t nread = 0;
+
+        for (uint64_t i = r; i < queues.size(); i += num_receivers) {
+          if (queues[i]->RetrieveMessages()) {
+            size_t len;
+
+            while ((len = queues[i]->Read(buffer.data(), buffer.size()))) {
+              nread += len;
+            }
+          }
+        }
+
+        bytes_read += nread;
+
+        if (last_round) {
+          break;
+        }
+
+        if (!nread) {
+          std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+      }
+    });
+  }
+
+  std::vector<std::thread> senders;
+
+  for (uint64_t s = 0; s < num_senders; ++s) {
+    senders.emplace_back([&, s]() {
+      std::mt19937_64 rng(s);
+      std::vector<XrdMqMessageOut*> matched;
+      const std::string body(msg_size, 'x');
+
+      for (uint64_t n = s; n < num_msgs; n += num_senders) {
+        const bool bcast = ((rng() % 100) < bcast_pct);
+        const std::string target = bcast ? bcast_pattern :
+                                   queues[rng() % queues.size()]->QueueName.c_str();
+        matched.clear();
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+
+        if (!linear) {
+          index.Match(target, matched);
+        } else if (!bcast) {
+          auto it = queue_map.find(target);
+
+          if (it != queue_map.end()) {
+            matched.push_back(it->second);
+          }
+        } else {
+          for (const auto& elem : queue_map) {
+            XrdOucString key = elem.first.c_str();
+            XrdOucString nowildcard = target.c_str();
+            nowildcard.replace("*", "");
+
+            if (key.matches(target.c_str(), '*') == nowildcard.length()) {
+              matched.push_back(elem.second);
+            }
+          }
+        }
+
+        if (matched.empty()) {
+          continue;
+        }
+
+        auto payload = std::make_shared<const std::string>(body);
+
+        for (auto* msg_out : matched) {
+          msg_out->Push(payload);
+        }
+
+        deliveries += matched.size();
+      }
+    });
+  }
+
+  for (auto& sender : senders) {
+    sender.join();
+  }
+
+  const double send_time = std::chrono::duration<double>
+                           (std::chrono::steady_clock::now() - start).count();
+  sending = false;
+
+  for (auto& receiver : receivers) {
+    receiver.join();
+  }
+
+  const double total_time = std::chrono::duration<double>
+                            (std::chrono::steady_clock::now() - start).count();
+  std::cout << "routing            : " << (linear ? "linear" : "index")
+            << std::endl
+            << "queues             : " << num_queues << std::endl
+            << "messages           : " << num_msgs << " ("
+            << bcast_pct << "% broadcast)" << std::endl
+            << "deliveries         : " << deliveries << std::endl
+            << "bytes read         : " << bytes_read << std::endl
+            << "send time          : " << send_time << " s" << std::endl
+            << "total time         : " << total_time << " s" << std::endl
+            << "message rate       : " << (num_msgs / send_time) << " Hz"
+            << std::endl
+            << "delivery rate      : " << (deliveries / total_time) << " Hz"
+            << std::endl;
+
+  if (bytes_read != deliveries * msg_size) {
+    std::cerr << "error: expected " << deliveries * msg_size
+              << " bytes to be read" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,195 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashBench.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+// Bytes and CPU time per update of the shared hash replication: an FST
+// publishes the statistics of all its file systems once per cycle in a mux
+// transaction. The plain encoding sends every key set during the cycle as
+// "|#<idx>#<key>~<value>%<cid>", the delta encoding sends only the keys
+// whose value changed, front coded. The CPU time covers encoding on the
+// producer and decoding on the receiver.
+//------------------------------------------------------------------------------
+
+#include "mq/XrdMqSharedHashCodec.hh"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+static const char* sKeys[] = {
+  "stat.active", "stat.balancer.running", "stat.boot", "stat.bootdonetime",
+  "stat.disk.bw", "stat.disk.iops", "stat.disk.load", "stat.disk.readratemb",
+  "stat.disk.writeratemb", "stat.errc", "stat.errmsg", "stat.geotag",
+  "stat.health", "stat.health.drives_failed", "stat.health.drives_total",
+  "stat.health.indicator", "stat.health.redundancy_factor", "stat.http.port",
+  "stat.net.ethratemib", "stat.net.inratemib", "stat.net.outratemib",
+  "stat.nominal.filled", "stat.publishtimestamp", "stat.ropen",
+  "stat.ropen.hotbytes", "stat.ropen.hotfiles", "stat.statfs.bavail",
+  "stat.statfs.bfree", "stat.statfs.blocks", "stat.statfs.bsize",
+  "stat.statfs.bused", "stat.statfs.capacity", "stat.statfs.ffree",
+  "stat.statfs.files", "stat.statfs.filled", "stat.statfs.freebytes",
+  "stat.statfs.fused", "stat.statfs.namelen", "stat.statfs.type",
+  "stat.statfs.usedbytes", "stat.sys.eos.start", "stat.sys.eos.version",
+  "stat.sys.kernel", "stat.sys.keytab", "stat.sys.rss", "stat.sys.sockets",
+  "stat.sys.threads", "stat.sys.uptime", "stat.sys.vsize",
+  "stat.sys.xrootd.version", "stat.usedfiles", "stat.wopen",
+  "stat.wopen.hotbytes", "stat.wopen.hotfiles"
+};
+
+//------------------------------------------------------------------------------
+// Decode the plain encoding the way the receiver does
+//------------------------------------------------------------------------------
+static size_t
+DecodePlain(const std::string& val, std::map<std::string, std::string>& out)
+{
+  size_t count = 0;
+  size_t pos = 0;
+
+  while ((pos = val.find('|', pos)) != std::string::npos) {
+    const size_t vpos = val.find('~', pos);
+    const size_t cpos = val.find('%', vpos);
+    std::string key = val.substr(pos + 1, vpos - pos - 1);
+    key.erase(0, key.find('#', 1) + 1);
+    out[key] = val.substr(vpos + 1, cpos - vpos - 1);
+    pos = cpos;
+    ++count;
+  }
+
+  return count;
+}
+
+int main(int argc, char* argv[])
+{
+  uint64_t num_fs = 48;
+  uint64_t num_cycles = 1000;
+  uint64_t change_pct = 20;
+
+  if ((argc > 4) || ((argc > 1) && !strcmp(argv[1], "-h"))) {
+    std::cerr << "Usage: " << argv[0] << " [num_filesystems] [num_cycles] "
+              << "[changed_keys_percent]" << std::endl;
+    exit(-1);
+  }
+
+  uint64_t* params[] = {&num_fs, &num_cycles, &change_pct};
+
+  for (int i = 1; i < argc; ++i) {
+    *params[i - 1] = std::stoull(argv[i]);
+  }
+
+  const size_t num_keys = sizeof(sKeys) / sizeof(sKeys[0]);
+  std::vector<std::map<std::string, std::string>> hashes(num_fs);
+  std::mt19937_64 rng(0);
+
+  for (auto& hash : hashes) {
+    for (size_t k = 0; k < num_keys; ++k) {
+      hash[sKeys[k]] = std::to_string(rng() % 100000000);
+    }
+  }
+
+  uint64_t plain_bytes = 0, plain_updates = 0;
+  uint64_t delta_bytes = 0, delta_updates = 0;
+  double plain_time = 0, delta_time = 0;
+  std::map<std::string, std::string> received;
+  std::vector<std::vector<XrdMqSharedHashCodec::Record>> subjects;
+
+  for (uint64_t cycle = 0; cycle < num_cycles; ++cycle) {
+    // Keys changed during this cycle per file system
+    std::vector<std::vector<std::string>> changed(num_fs);
+
+    for (size_t fs = 0; fs < num_fs; ++fs) {
+      for (size_t k = 0; k < num_keys; ++k) {
+        if ((rng() % 100) < change_pct) {
+          hashes[fs][sKeys[k]] = std::to_string(rng() % 100000000);
+          changed[fs].push_back(sKeys[k]);
+        }
+      }
+    }
+
+    // Plain encoding: all keys set during the cycle
+    auto start = std::chrono::steady_clock::now();
+    std::string plain;
+
+    for (size_t fs = 0; fs < num_fs; ++fs) {
+      const std::string prefix = "|#" + std::to_string(fs) + "#";
+
+      for (const auto& elem : hashes[fs]) {
+        plain += prefix;
+        plain += elem.first;
+        plain += "~";
+        plain += elem.second;
+        plain += "%0";
+      }
+    }
+
+    received.clear();
+    plain_updates += DecodePlain(plain, received);
+    plain_time += std::chrono::duration<double>
+                  (std::chrono::steady_clock::now() - start).count();
+    plain_bytes += plain.length();
+    // Delta encoding: only the changed keys
+    start = std::chrono::steady_clock::now();
+    XrdMqSharedHashCodec codec;
+
+    for (size_t fs = 0; fs < num_fs; ++fs) {
+      codec.NextSubject();
+
+      for (const auto& key : changed[fs]) {
+        codec.AddPair(key, hashes[fs][key]);
+      }
+    }
+
+    if (!XrdMqSharedHashCodec::Decode(codec.GetOutput(), subjects) ||
+        (subjects.size() != num_fs)) {
+      std::cerr << "error: failed to decode delta message" << std::endl;
+      return 1;
+    }
+
+    delta_time += std::chrono::duration<double>
+                  (std::chrono::steady_clock::now() - start).count();
+    delta_bytes += codec.GetOutput().length();
+    delta_updates += codec.GetNumRecords();
+  }
+
+  const uint64_t changes = delta_updates;
+  std::cout << "file systems       : " << num_fs << std::endl
+            << "keys per fs        : " << num_keys << std::endl
+            << "cycles             : " << num_cycles << " ("
+            << change_pct << "% keys changed)" << std::endl
+            << "plain bytes/cycle  : " << plain_bytes / num_cycles << std::endl
+            << "delta bytes/cycle  : " << delta_bytes / num_cycles << std::endl
+            << "plain bytes/update : " << (double) plain_bytes / plain_updates
+            << std::endl
+            << "delta bytes/update : " << (double) delta_bytes / delta_updates
+            << std::endl
+            << "plain bytes/change : " << (double) plain_bytes / changes
+            << std::endl
+            << "delta bytes/change : " << (double) delta_bytes / changes
+            << std::endl
+            << "plain cpu/change   : " << plain_time * 1e9 / changes << " ns"
+            << std::endl
+            << "delta cpu/change   : " << delta_time * 1e9 / changes << " ns"
+            << std::endl;
+  return 0;
+}
@@ -184,6 +184,14 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(ContainerIdentifier id) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the metadata cache
+  //!
+  //! @param max_num maximum number of ids to return
+  //----------------------------------------------------------------------------
+  virtual std::vector<ContainerIdentifier>
+  getRecentlyUsedIds(uint64_t max_num) = 0;
+
 };
 
 EOSNSNAMESPACE_END
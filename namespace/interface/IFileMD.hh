@@ -436,9 +436,6 @@ public:
 
   IFileMD& operator=(const IFileMD& other) = delete;
 
-protected:
-  mutable std::shared_timed_mutex mMutex;
-
 private:
 
   std::atomic<bool> mIsDeleted; ///< Mark if object is still in cache but it was deleted
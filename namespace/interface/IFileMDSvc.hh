@@ -32,6 +32,7 @@
 #include <folly/futures/Future.h>
 #include <map>
 #include <string>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -215,6 +216,13 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(FileIdentifier id) = 0;
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used files in the metadata cache
+  //!
+  //! @param max_num maximum number of ids to return
+  //----------------------------------------------------------------------------
+  virtual std::vector<FileIdentifier> getRecentlyUsedIds(uint64_t max_num) = 0;
+
 };
 
 EOSNSNAMESPACE_END
@@ -36,6 +36,8 @@ struct CacheStatistics {
   uint64_t maxNum = 0;
   uint64_t occupancy = 0;
   uint64_t inFlight = 0;
+  uint64_t hits = 0; ///< Lookups served from the cache
+  uint64_t misses = 0; ///< Lookups that had to go to the backend
 };
 
 EOSNSNAMESPACE_END
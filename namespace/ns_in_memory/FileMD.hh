@@ -28,6 +28,7 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include <stdint.h>
 #include <cstring>
+#include <shared_mutex>
 #include <string>
 #include <vector>
 #include <sys/time.h>
@@ -662,6 +663,7 @@ protected:
   //----------------------------------------------------------------------------
   // Data members
   //----------------------------------------------------------------------------
+  mutable std::shared_timed_mutex mMutex;
   IFileMD::id_t       pId;
   ctime_t             pCTime;
   ctime_t             pMTime;
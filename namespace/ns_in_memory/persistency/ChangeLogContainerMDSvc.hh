@@ -363,6 +363,16 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(ContainerIdentifier id) override {}
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers - no cache for in-memory
+  //! namespace
+  //----------------------------------------------------------------------------
+  virtual std::vector<ContainerIdentifier>
+  getRecentlyUsedIds(uint64_t max_num) override
+  {
+    return {};
+  }
+
 
 private:
   //--------------------------------------------------------------------------
@@ -360,6 +360,16 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(FileIdentifier id) override {}
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used files - no cache for in-memory
+  //! namespace
+  //----------------------------------------------------------------------------
+  virtual std::vector<FileIdentifier>
+  getRecentlyUsedIds(uint64_t max_num) override
+  {
+    return {};
+  }
+
 
 private:
   //----------------------------------------------------------------------------
@@ -133,6 +133,11 @@ public:
   }
 
   virtual void blacklistBelow(eos::FileIdentifier id) {}
+
+  virtual std::vector<eos::FileIdentifier> getRecentlyUsedIds(uint64_t max_num)
+  {
+    return {};
+  }
 };
 
 //------------------------------------------------------------------------------
@@ -0,0 +1,890 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
+#include "namespace/MDException.hh"
+#include <cstring>
+#include <limits>
+#include <new>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Append varint encoded value to the buffer
+//------------------------------------------------------------------------------
+void PutVarint(std::string& out, uint64_t value)
+{
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+
+  out.push_back(static_cast<char>(value));
+}
+
+//------------------------------------------------------------------------------
+// Decode varint from the buffer and advance the position
+//
+// @return true if successful, otherwise false
+//------------------------------------------------------------------------------
+bool GetVarint(std::string_view data, size_t& pos, uint64_t& value)
+{
+  value = 0;
+
+  for (unsigned int shift = 0; (pos < data.size()) && (shift < 64);
+       shift += 7) {
+    unsigned char byte = static_cast<unsigned char>(data[pos++]);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Encode a raw timespec as stored in the protobuf object, anything else than
+// a full timespec is considered unset
+//------------------------------------------------------------------------------
+void PutTime(std::string& out, const std::string& raw)
+{
+  if (raw.size() != sizeof(IFileMD::ctime_t)) {
+    return;
+  }
+
+  IFileMD::ctime_t ts;
+  (void) memcpy(&ts, raw.data(), sizeof(ts));
+  PutVarint(out, static_cast<uint64_t>(ts.tv_sec));
+  PutVarint(out, static_cast<uint64_t>(ts.tv_nsec));
+}
+
+//------------------------------------------------------------------------------
+// Encode a timestamp section
+//------------------------------------------------------------------------------
+std::string EncodeTime(const IFileMD::ctime_t& ts)
+{
+  std::string out;
+  PutVarint(out, static_cast<uint64_t>(ts.tv_sec));
+  PutVarint(out, static_cast<uint64_t>(ts.tv_nsec));
+  return out;
+}
+}
+
+//------------------------------------------------------------------------------
+// Get the global interner instance
+//------------------------------------------------------------------------------
+XattrKeyInterner&
+XattrKeyInterner::Global()
+{
+  static XattrKeyInterner sInterner;
+  return sInterner;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+XattrKeyInterner::XattrKeyInterner()
+{
+  mTables.emplace_back(new Table(64));
+  mTable.store(mTables.back().get(), std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Table constructor
+//------------------------------------------------------------------------------
+XattrKeyInterner::Table::Table(size_t capacity):
+  mMask(capacity - 1),
+  mSlots(new std::atomic<const Entry*>[capacity]),
+  mById(new std::atomic<const Entry*>[capacity / 2])
+{
+  for (size_t i = 0; i < capacity; ++i) {
+    mSlots[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  for (size_t i = 0; i < capacity / 2; ++i) {
+    mById[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Add entry to the table
+//------------------------------------------------------------------------------
+void
+XattrKeyInterner::Table::Insert(const Entry* entry)
+{
+  size_t pos = std::hash<std::string_view>()(entry->mKey) & mMask;
+
+  while (mSlots[pos].load(std::memory_order_relaxed) != nullptr) {
+    pos = (pos + 1) & mMask;
+  }
+
+  mById[entry->mId].store(entry, std::memory_order_release);
+  mSlots[pos].store(entry, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+// Get the id of the given key, registering it if not yet known
+//------------------------------------------------------------------------------
+uint32_t
+XattrKeyInterner::Intern(std::string_view key)
+{
+  uint32_t id;
+
+  if (Find(key, id)) {
+    return id;
+  }
+
+  std::unique_lock<std::mutex> lock(mWriteMutex);
+
+  if (Find(key, id)) {
+    return id;
+  }
+
+  id = mEntries.size();
+  mEntries.push_back(Entry{std::string(key), id});
+  Table* table = mTables.back().get();
+
+  if (mEntries.size() > (table->mMask + 1) / 2) {
+    // Publish a table twice as big, the old one stays valid for the readers
+    // still holding it
+    mTables.emplace_back(new Table(2 * (table->mMask + 1)));
+    table = mTables.back().get();
+
+    for (const auto& entry : mEntries) {
+      table->Insert(&entry);
+    }
+
+    mTable.store(table, std::memory_order_release);
+  } else {
+    table->Insert(&mEntries.back());
+  }
+
+  mSize.store(mEntries.size(), std::memory_order_release);
+  return id;
+}
+
+//------------------------------------------------------------------------------
+// Get the key for the given id
+//------------------------------------------------------------------------------
+std::string_view
+XattrKeyInterner::Lookup(uint32_t id) const
+{
+  const Table* table = mTable.load(std::memory_order_acquire);
+
+  if (id >= (table->mMask + 1) / 2) {
+    return std::string_view();
+  }
+
+  const Entry* entry = table->mById[id].load(std::memory_order_acquire);
+  return (entry ? std::string_view(entry->mKey) : std::string_view());
+}
+
+//------------------------------------------------------------------------------
+// Get the id of an already registered key
+//------------------------------------------------------------------------------
+bool
+XattrKeyInterner::Find(std::string_view key, uint32_t& id) const
+{
+  const Table* table = mTable.load(std::memory_order_acquire);
+  size_t pos = std::hash<std::string_view>()(key) & table->mMask;
+
+  while (true) {
+    const Entry* entry = table->mSlots[pos].load(std::memory_order_acquire);
+
+    if (entry == nullptr) {
+      return false;
+    }
+
+    if (entry->mKey == key) {
+      id = entry->mId;
+      return true;
+    }
+
+    pos = (pos + 1) & table->mMask;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get number of registered keys
+//------------------------------------------------------------------------------
+size_t
+XattrKeyInterner::Size() const
+{
+  return mSize.load(std::memory_order_acquire);
+}
+
+//------------------------------------------------------------------------------
+// Build a compact snapshot from the given protobuf object
+//------------------------------------------------------------------------------
+CompactFileMD::Ptr
+CompactFileMD::Create(const eos::ns::FileMdProto& proto)
+{
+  if ((proto.uid() > std::numeric_limits<uint32_t>::max()) ||
+      (proto.gid() > std::numeric_limits<uint32_t>::max())) {
+    throw_mdexception(EOVERFLOW, "uid/gid out of range for file id="
+                      << proto.id() << " uid=" << proto.uid()
+                      << " gid=" << proto.gid());
+  }
+
+  XattrKeyInterner& interner = XattrKeyInterner::Global();
+  // Serialize the variable size sections into a temporary buffer first
+  uint32_t end[kNumSections];
+  std::string payload;
+  payload.reserve(proto.name().size() + proto.link_name().size() +
+                  proto.checksum().size() + 64);
+  payload.append(proto.name());
+  end[kName] = payload.size();
+  payload.append(proto.link_name());
+  end[kLink] = payload.size();
+  payload.append(proto.checksum());
+  end[kChecksum] = payload.size();
+  payload.append(proto.clonefst());
+  end[kCloneFst] = payload.size();
+  PutTime(payload, proto.ctime());
+  end[kCTime] = payload.size();
+  PutTime(payload, proto.mtime());
+  end[kMTime] = payload.size();
+  PutTime(payload, proto.stime());
+  end[kSTime] = payload.size();
+
+  for (const auto& loc : proto.locations()) {
+    PutVarint(payload, loc);
+  }
+
+  end[kLocations] = payload.size();
+
+  for (const auto& loc : proto.unlink_locations()) {
+    PutVarint(payload, loc);
+  }
+
+  end[kUnlinkedLocations] = payload.size();
+
+  for (const auto& elem : proto.xattrs()) {
+    PutVarint(payload, interner.Intern(elem.first));
+    PutVarint(payload, elem.second.size());
+    payload.append(elem.second);
+  }
+
+  end[kXattrs] = payload.size();
+  CompactFileMD* obj = Allocate(payload.size());
+  (void) memcpy(const_cast<char*>(obj->Payload()), payload.data(),
+                payload.size());
+  (void) memcpy(obj->mEnd, end, sizeof(end));
+  obj->mId = proto.id();
+  obj->mFields.mContId = proto.cont_id();
+  obj->mFields.mSize = proto.size();
+  obj->mFields.mCloneId = proto.cloneid();
+  obj->mFields.mUid = proto.uid();
+  obj->mFields.mGid = proto.gid();
+  obj->mFields.mLayoutId = proto.layout_id();
+  obj->mFields.mFlags = proto.flags();
+  return Wrap(obj);
+}
+
+//------------------------------------------------------------------------------
+// Allocate an object followed by its payload
+//------------------------------------------------------------------------------
+CompactFileMD*
+CompactFileMD::Allocate(size_t payload_size)
+{
+  // Single allocation holding the object followed by its payload
+  void* mem = ::operator new(sizeof(CompactFileMD) + payload_size);
+  return new(mem) CompactFileMD();
+}
+
+//------------------------------------------------------------------------------
+// Wrap an allocated object into a shared pointer
+//------------------------------------------------------------------------------
+CompactFileMD::Ptr
+CompactFileMD::Wrap(CompactFileMD* obj)
+{
+  return Ptr(obj, [](const CompactFileMD * ptr) {
+    ptr->~CompactFileMD();
+    ::operator delete(const_cast<CompactFileMD*>(ptr));
+  });
+}
+
+//------------------------------------------------------------------------------
+// Copy with different fixed size fields
+//------------------------------------------------------------------------------
+CompactFileMD::Ptr
+CompactFileMD::CloneWithFields(const Fields& fields) const
+{
+  size_t payload_size = mEnd[kNumSections - 1];
+  CompactFileMD* obj = Allocate(payload_size);
+  (void) memcpy(const_cast<char*>(obj->Payload()), Payload(), payload_size);
+  (void) memcpy(obj->mEnd, mEnd, sizeof(mEnd));
+  obj->mId = mId;
+  obj->mFields = fields;
+  return Wrap(obj);
+}
+
+//------------------------------------------------------------------------------
+// Copy with one payload section replaced
+//------------------------------------------------------------------------------
+CompactFileMD::Ptr
+CompactFileMD::CloneWithSection(Section section, std::string_view data) const
+{
+  uint32_t begin = (section == kName) ? 0 : mEnd[section - 1];
+  uint32_t old_end = mEnd[section];
+  uint32_t total = mEnd[kNumSections - 1];
+  int64_t delta = static_cast<int64_t>(data.size()) - (old_end - begin);
+  CompactFileMD* obj = Allocate(total + delta);
+  char* out = const_cast<char*>(obj->Payload());
+  (void) memcpy(out, Payload(), begin);
+
+  if (!data.empty()) {
+    (void) memcpy(out + begin, data.data(), data.size());
+  }
+
+  (void) memcpy(out + begin + data.size(), Payload() + old_end,
+                total - old_end);
+
+  for (int i = 0; i < kNumSections; ++i) {
+    obj->mEnd[i] = (i < section) ? mEnd[i] : mEnd[i] + delta;
+  }
+
+  obj->mId = mId;
+  obj->mFields = mFields;
+  return Wrap(obj);
+}
+
+//------------------------------------------------------------------------------
+// Decode a timestamp section
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::GetTime(Section section, IFileMD::ctime_t& ts) const
+{
+  std::string_view data = GetSection(section);
+  size_t pos = 0;
+  uint64_t sec, nsec;
+
+  if (!GetVarint(data, pos, sec) || !GetVarint(data, pos, nsec)) {
+    ts.tv_sec = 0;
+    ts.tv_nsec = 0;
+    return false;
+  }
+
+  ts.tv_sec = static_cast<decltype(ts.tv_sec)>(sec);
+  ts.tv_nsec = static_cast<decltype(ts.tv_nsec)>(nsec);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Get creation time
+//------------------------------------------------------------------------------
+void
+CompactFileMD::getCTime(IFileMD::ctime_t& ctime) const
+{
+  (void) GetTime(kCTime, ctime);
+}
+
+//------------------------------------------------------------------------------
+// Get modification time
+//------------------------------------------------------------------------------
+void
+CompactFileMD::getMTime(IFileMD::ctime_t& mtime) const
+{
+  (void) GetTime(kMTime, mtime);
+}
+
+//------------------------------------------------------------------------------
+// Get sync time, falls back to the modification time if not set
+//------------------------------------------------------------------------------
+void
+CompactFileMD::getSyncTime(IFileMD::ctime_t& stime) const
+{
+  (void) GetTime(kSTime, stime);
+
+  if (stime.tv_sec == 0) {
+    (void) GetTime(kMTime, stime);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Decode all the locations in a varint packed section
+//------------------------------------------------------------------------------
+IFileMD::LocationVector
+CompactFileMD::GetLocationSection(Section section) const
+{
+  std::string_view data = GetSection(section);
+  IFileMD::LocationVector locations;
+  locations.reserve(CountVarints(data));
+  size_t pos = 0;
+  uint64_t loc;
+
+  while (GetVarint(data, pos, loc)) {
+    locations.push_back(static_cast<IFileMD::location_t>(loc));
+  }
+
+  return locations;
+}
+
+//------------------------------------------------------------------------------
+// Check if location is part of a varint packed section
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::HasLocationInSection(Section section,
+                                    IFileMD::location_t location) const
+{
+  std::string_view data = GetSection(section);
+  size_t pos = 0;
+  uint64_t loc;
+
+  while (GetVarint(data, pos, loc)) {
+    if (loc == location) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Get locations
+//------------------------------------------------------------------------------
+IFileMD::LocationVector
+CompactFileMD::getLocations() const
+{
+  return GetLocationSection(kLocations);
+}
+
+//------------------------------------------------------------------------------
+// Get location at the given index
+//------------------------------------------------------------------------------
+IFileMD::location_t
+CompactFileMD::getLocation(unsigned int index) const
+{
+  std::string_view data = GetSection(kLocations);
+  size_t pos = 0;
+  uint64_t loc;
+
+  for (unsigned int i = 0; GetVarint(data, pos, loc); ++i) {
+    if (i == index) {
+      return static_cast<IFileMD::location_t>(loc);
+    }
+  }
+
+  return 0;
+}
+
+//------------------------------------------------------------------------------
+// Get unlinked locations
+//------------------------------------------------------------------------------
+IFileMD::LocationVector
+CompactFileMD::getUnlinkedLocations() const
+{
+  return GetLocationSection(kUnlinkedLocations);
+}
+
+//------------------------------------------------------------------------------
+// Check if file has the given location
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::hasLocation(IFileMD::location_t location) const
+{
+  return HasLocationInSection(kLocations, location);
+}
+
+//------------------------------------------------------------------------------
+// Check if file has the given unlinked location
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::hasUnlinkedLocation(IFileMD::location_t location) const
+{
+  return HasLocationInSection(kUnlinkedLocations, location);
+}
+
+//------------------------------------------------------------------------------
+// Iterate over xattrs
+//------------------------------------------------------------------------------
+void
+CompactFileMD::ForEachAttribute(const
+                                std::function<bool(uint32_t, std::string_view)>& cb) const
+{
+  std::string_view data = GetSection(kXattrs);
+  size_t pos = 0;
+  uint64_t key_id, len;
+
+  while (GetVarint(data, pos, key_id) && GetVarint(data, pos, len)) {
+    if (len > data.size() - pos) {
+      return;
+    }
+
+    if (!cb(static_cast<uint32_t>(key_id), data.substr(pos, len))) {
+      return;
+    }
+
+    pos += len;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get attribute value
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::getAttribute(std::string_view key, std::string& value) const
+{
+  uint32_t id;
+
+  if (!XattrKeyInterner::Global().Find(key, id)) {
+    return false;
+  }
+
+  bool found = false;
+  ForEachAttribute([&](uint32_t key_id, std::string_view val) {
+    if (key_id == id) {
+      value.assign(val.data(), val.size());
+      found = true;
+      return false;
+    }
+
+    return true;
+  });
+  return found;
+}
+
+//------------------------------------------------------------------------------
+// Check if attribute exists
+//------------------------------------------------------------------------------
+bool
+CompactFileMD::hasAttribute(std::string_view key) const
+{
+  std::string value;
+  return getAttribute(key, value);
+}
+
+//------------------------------------------------------------------------------
+// Get all the attributes
+//------------------------------------------------------------------------------
+IFileMD::XAttrMap
+CompactFileMD::getAttributes() const
+{
+  IFileMD::XAttrMap xattrs;
+  const XattrKeyInterner& interner = XattrKeyInterner::Global();
+  ForEachAttribute([&](uint32_t key_id, std::string_view val) {
+    std::string_view key = interner.Lookup(key_id);
+    xattrs.emplace(std::string(key), std::string(val));
+    return true;
+  });
+  return xattrs;
+}
+
+//------------------------------------------------------------------------------
+// Get number of attributes
+//------------------------------------------------------------------------------
+size_t
+CompactFileMD::numAttributes() const
+{
+  size_t count = 0;
+  ForEachAttribute([&](uint32_t, std::string_view) {
+    ++count;
+    return true;
+  });
+  return count;
+}
+
+//------------------------------------------------------------------------------
+// Expand back into the protobuf representation
+//------------------------------------------------------------------------------
+void
+CompactFileMD::toProto(eos::ns::FileMdProto& proto) const
+{
+  proto.Clear();
+  proto.set_id(mId);
+  proto.set_cont_id(mFields.mContId);
+  proto.set_uid(mFields.mUid);
+  proto.set_gid(mFields.mGid);
+  proto.set_size(mFields.mSize);
+  proto.set_layout_id(mFields.mLayoutId);
+  proto.set_flags(mFields.mFlags);
+  proto.set_cloneid(mFields.mCloneId);
+  std::string_view sv = getName();
+  proto.set_name(sv.data(), sv.size());
+  sv = getLink();
+  proto.set_link_name(sv.data(), sv.size());
+  sv = getChecksum();
+  proto.set_checksum(sv.data(), sv.size());
+  sv = getCloneFST();
+  proto.set_clonefst(sv.data(), sv.size());
+  IFileMD::ctime_t ts;
+
+  if (GetTime(kCTime, ts)) {
+    proto.set_ctime(&ts, sizeof(ts));
+  }
+
+  if (GetTime(kMTime, ts)) {
+    proto.set_mtime(&ts, sizeof(ts));
+  }
+
+  if (GetTime(kSTime, ts)) {
+    proto.set_stime(&ts, sizeof(ts));
+  }
+
+  for (const auto& loc : getLocations()) {
+    proto.add_locations(loc);
+  }
+
+  for (const auto& loc : getUnlinkedLocations()) {
+    proto.add_unlink_locations(loc);
+  }
+
+  auto* xattrs = proto.mutable_xattrs();
+  const XattrKeyInterner& interner = XattrKeyInterner::Global();
+  ForEachAttribute([&](uint32_t key_id, std::string_view val) {
+    std::string_view key = interner.Lookup(key_id);
+    (*xattrs)[std::string(key)] = std::string(val);
+    return true;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Publish the snapshot built from the current one
+//------------------------------------------------------------------------------
+bool
+CompactFileMDSlot::Publish(const
+                           std::function<CompactFileMD::Ptr(const CompactFileMD&)>& build)
+{
+  CompactFileMD::Ptr current = Load();
+
+  while (true) {
+    if (!current) {
+      CompactFileMD::Ptr empty = CompactFileMD::Create(eos::ns::FileMdProto());
+
+      if (!std::atomic_compare_exchange_strong(&mSnapshot, &current, empty)) {
+        continue;
+      }
+
+      current = empty;
+    }
+
+    CompactFileMD::Ptr updated = build(*current);
+
+    if (!updated) {
+      return false;
+    }
+
+    // On failure current is refreshed with the latest published snapshot
+    if (std::atomic_compare_exchange_strong(&mSnapshot, &current, updated)) {
+      return true;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Apply a modification to the current snapshot and publish the result
+//------------------------------------------------------------------------------
+bool
+CompactFileMDSlot::Update(const std::function<bool(eos::ns::FileMdProto&)>&
+                          modifier)
+{
+  eos::ns::FileMdProto proto;
+  return Publish([&](const CompactFileMD & current) -> CompactFileMD::Ptr {
+    current.toProto(proto);
+
+    if (!modifier(proto)) {
+      return nullptr;
+    }
+
+    return CompactFileMD::Create(proto);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Apply a modification to the fixed size fields only
+//------------------------------------------------------------------------------
+bool
+CompactFileMDSlot::UpdateFields(const
+                                std::function<bool(CompactFileMD::Fields&)>& modifier)
+{
+  return Publish([&](const CompactFileMD & current) -> CompactFileMD::Ptr {
+    CompactFileMD::Fields fields = current.mFields;
+
+    if (!modifier(fields)) {
+      return nullptr;
+    }
+
+    return current.CloneWithFields(fields);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Replace the given payload section
+//------------------------------------------------------------------------------
+void
+CompactFileMDSlot::SetSection(CompactFileMD::Section section,
+                              std::string_view data)
+{
+  (void) Publish([&](const CompactFileMD & current) {
+    return current.CloneWithSection(section, data);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Replace a single variable size field
+//------------------------------------------------------------------------------
+void
+CompactFileMDSlot::SetName(std::string_view name)
+{
+  SetSection(CompactFileMD::kName, name);
+}
+
+void
+CompactFileMDSlot::SetLink(std::string_view link)
+{
+  SetSection(CompactFileMD::kLink, link);
+}
+
+void
+CompactFileMDSlot::SetChecksum(std::string_view checksum)
+{
+  SetSection(CompactFileMD::kChecksum, checksum);
+}
+
+void
+CompactFileMDSlot::SetCloneFST(std::string_view clonefst)
+{
+  SetSection(CompactFileMD::kCloneFst, clonefst);
+}
+
+void
+CompactFileMDSlot::SetCTime(const IFileMD::ctime_t& ctime)
+{
+  SetSection(CompactFileMD::kCTime, EncodeTime(ctime));
+}
+
+void
+CompactFileMDSlot::SetMTime(const IFileMD::ctime_t& mtime)
+{
+  SetSection(CompactFileMD::kMTime, EncodeTime(mtime));
+}
+
+void
+CompactFileMDSlot::SetSyncTime(const IFileMD::ctime_t& stime)
+{
+  SetSection(CompactFileMD::kSTime, EncodeTime(stime));
+}
+
+//------------------------------------------------------------------------------
+// Apply a modification to the locations only
+//------------------------------------------------------------------------------
+bool
+CompactFileMDSlot::UpdateLocations(const
+                                   std::function<bool(IFileMD::LocationVector&, IFileMD::LocationVector&)>&
+                                   modifier)
+{
+  return Publish([&](const CompactFileMD & current) -> CompactFileMD::Ptr {
+    IFileMD::LocationVector locations = current.getLocations();
+    IFileMD::LocationVector unlinked = current.getUnlinkedLocations();
+
+    if (!modifier(locations, unlinked)) {
+      return nullptr;
+    }
+
+    std::string data;
+
+    for (const auto& loc : locations) {
+      PutVarint(data, loc);
+    }
+
+    CompactFileMD::Ptr updated =
+      current.CloneWithSection(CompactFileMD::kLocations, data);
+    data.clear();
+
+    for (const auto& loc : unlinked) {
+      PutVarint(data, loc);
+    }
+
+    return updated->CloneWithSection(CompactFileMD::kUnlinkedLocations, data);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Add or replace an extended attribute
+//------------------------------------------------------------------------------
+void
+CompactFileMDSlot::SetAttribute(std::string_view key, std::string_view value)
+{
+  uint32_t id = XattrKeyInterner::Global().Intern(key);
+  (void) Publish([&](const CompactFileMD & current) {
+    std::string data;
+    current.ForEachAttribute([&](uint32_t key_id, std::string_view val) {
+      if (key_id != id) {
+        PutVarint(data, key_id);
+        PutVarint(data, val.size());
+        data.append(val.data(), val.size());
+      }
+
+      return true;
+    });
+    PutVarint(data, id);
+    PutVarint(data, value.size());
+    data.append(value.data(), value.size());
+    return current.CloneWithSection(CompactFileMD::kXattrs, data);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Remove an extended attribute
+//------------------------------------------------------------------------------
+bool
+CompactFileMDSlot::RemoveAttribute(std::string_view key)
+{
+  uint32_t id;
+
+  if (!XattrKeyInterner::Global().Find(key, id)) {
+    return false;
+  }
+
+  return Publish([&](const CompactFileMD & current) -> CompactFileMD::Ptr {
+    std::string data;
+    bool found = false;
+    current.ForEachAttribute([&](uint32_t key_id, std::string_view val) {
+      if (key_id == id) {
+        found = true;
+      } else {
+        PutVarint(data, key_id);
+        PutVarint(data, val.size());
+        data.append(val.data(), val.size());
+      }
+
+      return true;
+    });
+
+    if (!found) {
+      return nullptr;
+    }
+
+    return current.CloneWithSection(CompactFileMD::kXattrs, data);
+  });
+}
+
+//------------------------------------------------------------------------------
+// Remove all extended attributes
+//------------------------------------------------------------------------------
+void
+CompactFileMDSlot::ClearAttributes()
+{
+  SetSection(CompactFileMD::kXattrs, std::string_view());
+}
+
+EOSNSNAMESPACE_END
@@ -0,0 +1,503 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compact, immutable in-memory representation of the file metadata
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_COMPACT_FILE_MD_HH__
+#define __EOS_NS_COMPACT_FILE_MD_HH__
+
+#include "namespace/Namespace.hh"
+#include "namespace/interface/IFileMD.hh"
+#include "proto/FileMd.pb.h"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Process-wide pool of extended attribute keys. The set of distinct xattr
+//! keys is tiny compared to the number of files, therefore each compact file
+//! object only stores a small integer id per key.
+//!
+//! Lookups are on the hot path of every getAttribute/hasAttribute and never
+//! take a lock: the keys live in an open addressing table of atomic pointers
+//! which is only ever appended to. Registering a new key is serialized by a
+//! mutex and, when the table gets half full, publishes a bigger copy. The
+//! replaced tables are kept around since readers might still use them, their
+//! total size is bounded by the size of the current one.
+//------------------------------------------------------------------------------
+class XattrKeyInterner
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Get the global interner instance
+  //----------------------------------------------------------------------------
+  static XattrKeyInterner& Global();
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  XattrKeyInterner();
+
+  //----------------------------------------------------------------------------
+  //! Get the id of the given key, registering it if not yet known
+  //----------------------------------------------------------------------------
+  uint32_t Intern(std::string_view key);
+
+  //----------------------------------------------------------------------------
+  //! Get the key for the given id, empty if unknown. The returned view stays
+  //! valid for the lifetime of the interner.
+  //----------------------------------------------------------------------------
+  std::string_view Lookup(uint32_t id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get the id of an already registered key
+  //!
+  //! @return true if key known, otherwise false
+  //----------------------------------------------------------------------------
+  bool Find(std::string_view key, uint32_t& id) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of registered keys
+  //----------------------------------------------------------------------------
+  size_t Size() const;
+
+private:
+  struct Entry {
+    std::string mKey;
+    uint32_t mId;
+  };
+
+  struct Table {
+    //--------------------------------------------------------------------------
+    //! Constructor
+    //!
+    //! @param capacity number of hash slots, must be a power of two
+    //--------------------------------------------------------------------------
+    explicit Table(size_t capacity);
+
+    //--------------------------------------------------------------------------
+    //! Add entry, the caller makes sure there is enough room
+    //--------------------------------------------------------------------------
+    void Insert(const Entry* entry);
+
+    size_t mMask;
+    //! Hash slots with linear probing, at most half of them are used
+    std::unique_ptr<std::atomic<const Entry*>[]> mSlots;
+    //! Entries indexed by id, capacity / 2 of them
+    std::unique_ptr<std::atomic<const Entry*>[]> mById;
+  };
+
+  //! Currently published table
+  std::atomic<const Table*> mTable;
+  std::atomic<size_t> mSize {0};
+  //! Serializes writers, protects the members below
+  std::mutex mWriteMutex;
+  //! Entry storage, deque elements are never relocated
+  std::deque<Entry> mEntries;
+  //! Current and replaced tables
+  std::vector<std::unique_ptr<Table>> mTables;
+};
+
+//------------------------------------------------------------------------------
+//! Immutable snapshot of a FileMdProto packed in a single allocation.
+//!
+//! The fixed size fields live in the object itself, while all the variable
+//! length ones are stored back to back right after it: the name and link
+//! inline without any std::string overhead, the locations as varint packed
+//! vectors and the xattrs as (interned key id, value) pairs. Since the object
+//! is never modified after construction it can be read concurrently without
+//! any locking, updates go through a CompactFileMDSlot which swaps in a new
+//! snapshot (copy-on-write).
+//------------------------------------------------------------------------------
+class CompactFileMD
+{
+public:
+  using Ptr = std::shared_ptr<const CompactFileMD>;
+
+  //----------------------------------------------------------------------------
+  //! Fixed size fields which can be changed without touching the payload
+  //----------------------------------------------------------------------------
+  struct Fields {
+    IFileMD::id_t mContId {0};
+    uint64_t mSize {0};
+    uint64_t mCloneId {0};
+    uint32_t mUid {0};
+    uint32_t mGid {0};
+    IFileMD::layoutId_t mLayoutId {0};
+    uint32_t mFlags {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Build a compact snapshot from the given protobuf object, the xattr keys
+  //! are pooled in the global XattrKeyInterner
+  //!
+  //! @param proto file metadata
+  //!
+  //! @note throws MDException(EOVERFLOW) if the uid or gid does not fit in
+  //!       32 bits rather than silently truncating it
+  //----------------------------------------------------------------------------
+  static Ptr Create(const eos::ns::FileMdProto& proto);
+
+  //----------------------------------------------------------------------------
+  //! Fixed size fields
+  //----------------------------------------------------------------------------
+  inline IFileMD::id_t getId() const
+  {
+    return mId;
+  }
+
+  inline IFileMD::id_t getContainerId() const
+  {
+    return mFields.mContId;
+  }
+
+  inline uint64_t getSize() const
+  {
+    return mFields.mSize;
+  }
+
+  inline uint32_t getCUid() const
+  {
+    return mFields.mUid;
+  }
+
+  inline uint32_t getCGid() const
+  {
+    return mFields.mGid;
+  }
+
+  inline IFileMD::layoutId_t getLayoutId() const
+  {
+    return mFields.mLayoutId;
+  }
+
+  inline uint32_t getFlags() const
+  {
+    return mFields.mFlags;
+  }
+
+  inline uint64_t getCloneId() const
+  {
+    return mFields.mCloneId;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Variable size fields, the views are valid as long as the object lives
+  //----------------------------------------------------------------------------
+  inline std::string_view getName() const
+  {
+    return GetSection(kName);
+  }
+
+  inline std::string_view getLink() const
+  {
+    return GetSection(kLink);
+  }
+
+  inline std::string_view getChecksum() const
+  {
+    return GetSection(kChecksum);
+  }
+
+  inline std::string_view getCloneFST() const
+  {
+    return GetSection(kCloneFst);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Timestamps, zero if not set. Sync time falls back to the modification
+  //! time like in QuarkFileMD.
+  //----------------------------------------------------------------------------
+  void getCTime(IFileMD::ctime_t& ctime) const;
+  void getMTime(IFileMD::ctime_t& mtime) const;
+  void getSyncTime(IFileMD::ctime_t& stime) const;
+
+  //----------------------------------------------------------------------------
+  //! Locations
+  //----------------------------------------------------------------------------
+  IFileMD::LocationVector getLocations() const;
+  IFileMD::LocationVector getUnlinkedLocations() const;
+  bool hasLocation(IFileMD::location_t location) const;
+
+  //----------------------------------------------------------------------------
+  //! Get location at the given index, 0 if out of range
+  //----------------------------------------------------------------------------
+  IFileMD::location_t getLocation(unsigned int index) const;
+  bool hasUnlinkedLocation(IFileMD::location_t location) const;
+
+  inline size_t getNumLocation() const
+  {
+    return CountVarints(GetSection(kLocations));
+  }
+
+  inline size_t getNumUnlinkedLocation() const
+  {
+    return CountVarints(GetSection(kUnlinkedLocations));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Extended attributes
+  //----------------------------------------------------------------------------
+  bool getAttribute(std::string_view key, std::string& value) const;
+  bool hasAttribute(std::string_view key) const;
+  IFileMD::XAttrMap getAttributes() const;
+  size_t numAttributes() const;
+
+  //----------------------------------------------------------------------------
+  //! Expand back into the protobuf representation
+  //----------------------------------------------------------------------------
+  void toProto(eos::ns::FileMdProto& proto) const;
+
+  //----------------------------------------------------------------------------
+  //! Get number of bytes used by this object (excluding the shared_ptr
+  //! control block)
+  //----------------------------------------------------------------------------
+  inline size_t getMemoryFootprint() const
+  {
+    return sizeof(CompactFileMD) + mEnd[kNumSections - 1];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Disable copy/move, the object is always followed by its payload
+  //----------------------------------------------------------------------------
+  CompactFileMD(const CompactFileMD&) = delete;
+  CompactFileMD& operator=(const CompactFileMD&) = delete;
+
+private:
+  friend class CompactFileMDSlot;
+
+  //! Variable size sections stored in this order after the object
+  enum Section {
+    kName = 0, kLink, kChecksum, kCloneFst, kCTime, kMTime, kSTime,
+    kLocations, kUnlinkedLocations, kXattrs, kNumSections
+  };
+
+  //----------------------------------------------------------------------------
+  //! Private constructor, use Create
+  //----------------------------------------------------------------------------
+  CompactFileMD() = default;
+
+  ~CompactFileMD() = default;
+
+  //----------------------------------------------------------------------------
+  //! Allocate an object followed by a payload of the given size
+  //----------------------------------------------------------------------------
+  static CompactFileMD* Allocate(size_t payload_size);
+
+  //----------------------------------------------------------------------------
+  //! Wrap an allocated object into a shared pointer releasing the payload too
+  //----------------------------------------------------------------------------
+  static Ptr Wrap(CompactFileMD* obj);
+
+  //----------------------------------------------------------------------------
+  //! Copy of this object with different fixed size fields, the payload is
+  //! copied as is
+  //----------------------------------------------------------------------------
+  Ptr CloneWithFields(const Fields& fields) const;
+
+  //----------------------------------------------------------------------------
+  //! Copy of this object with the given payload section replaced
+  //----------------------------------------------------------------------------
+  Ptr CloneWithSection(Section section, std::string_view data) const;
+
+  //----------------------------------------------------------------------------
+  //! Get start of the payload
+  //----------------------------------------------------------------------------
+  inline const char* Payload() const
+  {
+    return reinterpret_cast<const char*>(this + 1);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get view of the given section of the payload
+  //----------------------------------------------------------------------------
+  inline std::string_view GetSection(Section section) const
+  {
+    uint32_t begin = (section == kName) ? 0 : mEnd[section - 1];
+    return std::string_view(Payload() + begin, mEnd[section] - begin);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Count the varints in the given buffer i.e. the bytes without the
+  //! continuation bit set
+  //----------------------------------------------------------------------------
+  static inline size_t CountVarints(std::string_view data)
+  {
+    size_t count = 0;
+
+    for (char c : data) {
+      count += ((static_cast<unsigned char>(c) & 0x80) == 0);
+    }
+
+    return count;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Decode a timestamp section
+  //----------------------------------------------------------------------------
+  bool GetTime(Section section, IFileMD::ctime_t& ts) const;
+
+  //----------------------------------------------------------------------------
+  //! Decode all the locations in a varint packed section
+  //----------------------------------------------------------------------------
+  IFileMD::LocationVector GetLocationSection(Section section) const;
+
+  //----------------------------------------------------------------------------
+  //! Check if location is part of a varint packed section
+  //----------------------------------------------------------------------------
+  bool HasLocationInSection(Section section, IFileMD::location_t loc) const;
+
+  //----------------------------------------------------------------------------
+  //! Iterate over xattrs, stops when the callback returns false
+  //----------------------------------------------------------------------------
+  void ForEachAttribute(const std::function<bool(uint32_t, std::string_view)>&
+                        cb) const;
+
+  IFileMD::id_t mId {0};
+  Fields mFields;
+  //! End offset of each section inside the payload
+  uint32_t mEnd[kNumSections] {};
+};
+
+//------------------------------------------------------------------------------
+//! Holder of the current compact snapshot of a file. Readers grab the current
+//! snapshot without blocking writers and keep using it even if it gets
+//! replaced in the meantime. Writers build a new snapshot and publish it
+//! atomically, concurrent updates are serialized by retrying. This is what
+//! QuarkFileMD uses instead of a per-object mutex.
+//------------------------------------------------------------------------------
+class CompactFileMDSlot
+{
+public:
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //----------------------------------------------------------------------------
+  CompactFileMDSlot(CompactFileMD::Ptr snapshot = nullptr):
+    mSnapshot(std::move(snapshot)) {}
+
+  //----------------------------------------------------------------------------
+  //! Get the current snapshot
+  //----------------------------------------------------------------------------
+  inline CompactFileMD::Ptr Load() const
+  {
+    return std::atomic_load(&mSnapshot);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Replace the current snapshot
+  //----------------------------------------------------------------------------
+  inline void Store(CompactFileMD::Ptr snapshot)
+  {
+    std::atomic_store(&mSnapshot, std::move(snapshot));
+  }
+
+  //----------------------------------------------------------------------------
+  //! Apply a modification to the current snapshot and publish the result
+  //!
+  //! @param modifier function changing the expanded protobuf object, it might
+  //!        be called more than once in case of concurrent updates. It
+  //!        returns false if there is nothing to change.
+  //!
+  //! @return true if a new snapshot was published, otherwise false
+  //----------------------------------------------------------------------------
+  bool Update(const std::function<bool(eos::ns::FileMdProto&)>& modifier);
+
+  //----------------------------------------------------------------------------
+  //! Apply a modification to the fixed size fields only. This only copies the
+  //! current snapshot, without expanding it to a protobuf object.
+  //!
+  //! @param modifier same contract as for Update
+  //!
+  //! @return true if a new snapshot was published, otherwise false
+  //----------------------------------------------------------------------------
+  bool UpdateFields(const std::function<bool(CompactFileMD::Fields&)>&
+                    modifier);
+
+  //----------------------------------------------------------------------------
+  //! Replace a single variable size field, like UpdateFields the rest of the
+  //! snapshot is copied as is
+  //----------------------------------------------------------------------------
+  void SetName(std::string_view name);
+  void SetLink(std::string_view link);
+  void SetChecksum(std::string_view checksum);
+  void SetCloneFST(std::string_view clonefst);
+  void SetCTime(const IFileMD::ctime_t& ctime);
+  void SetMTime(const IFileMD::ctime_t& mtime);
+  void SetSyncTime(const IFileMD::ctime_t& stime);
+
+  //----------------------------------------------------------------------------
+  //! Apply a modification to the locations and unlinked locations only
+  //!
+  //! @param modifier same contract as for Update
+  //!
+  //! @return true if a new snapshot was published, otherwise false
+  //----------------------------------------------------------------------------
+  bool UpdateLocations(const std::function<bool(IFileMD::LocationVector&,
+                       IFileMD::LocationVector&)>& modifier);
+
+  //----------------------------------------------------------------------------
+  //! Add or replace an extended attribute
+  //----------------------------------------------------------------------------
+  void SetAttribute(std::string_view key, std::string_view value);
+
+  //----------------------------------------------------------------------------
+  //! Remove an extended attribute
+  //!
+  //! @return true if the attribute existed, otherwise false
+  //----------------------------------------------------------------------------
+  bool RemoveAttribute(std::string_view key);
+
+  //----------------------------------------------------------------------------
+  //! Remove all extended attributes
+  //----------------------------------------------------------------------------
+  void ClearAttributes();
+
+private:
+  //----------------------------------------------------------------------------
+  //! Publish the snapshot built from the current one, retrying in case of
+  //! concurrent updates
+  //!
+  //! @param build function returning the new snapshot or nullptr if there is
+  //!        nothing to change
+  //!
+  //! @return true if a new snapshot was published, otherwise false
+  //----------------------------------------------------------------------------
+  bool Publish(const std::function<CompactFileMD::Ptr(const CompactFileMD&)>&
+               build);
+
+  //----------------------------------------------------------------------------
+  //! Replace the given payload section
+  //----------------------------------------------------------------------------
+  void SetSection(CompactFileMD::Section section, std::string_view data);
+
+  CompactFileMD::Ptr mSnapshot;
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_COMPACT_FILE_MD_HH__
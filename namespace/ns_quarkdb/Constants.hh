@@ -65,6 +65,8 @@ static const std::string sMaxSizeCacheFiles {"max_size_cache_files"};
 static const std::string sMaxNumCacheDirs {"max_num_cache_dirs"};
 //! Tag for max size (bytes) of dir/container entries cached at the MGM
 static const std::string sMaxSizeCacheDirs {"max_size_cache_dirs"};
+//! Tag for max num of path to container id translations cached at the MGM
+static const std::string sMaxNumCachePaths {"max_num_cache_paths"};
 
 //! Channel for incoming fid cache invalidation notifications
 static const std::string sCacheInvalidationFidChannel {"eos-md-cache-invalidation-fid"};
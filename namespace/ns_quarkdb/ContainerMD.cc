@@ -25,6 +25,7 @@
 #include "namespace/utils/StringConvertion.hh"
 #include "namespace/ns_quarkdb/persistency/Serialization.hh"
 #include "namespace/ns_quarkdb/persistency/MetadataFetcher.hh"
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
 #include "namespace/PermissionHandler.hh"
 #include "google/protobuf/io/zero_copy_stream_impl.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
@@ -227,10 +228,14 @@ QuarkContainerMD::removeContainer(const std::string& name)
     throw e;
   }
 
+  IContainerMD::id_t cid = it->second;
   mSubcontainers->erase(it);
   // mSubcontainers->resize(0);
   // Delete container also from KV backend
   pFlusher->hdel(pDirsKey, name);
+  lock.unlock();
+  // Paths going through the removed container are no longer valid
+  ContainerPathCache::notifyRemoval(cid);
 }
 
 //------------------------------------------------------------------------------
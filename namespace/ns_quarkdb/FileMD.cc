@@ -36,7 +36,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 // Empty constructor
 //------------------------------------------------------------------------------
-QuarkFileMD::QuarkFileMD()
+QuarkFileMD::QuarkFileMD():
+  mFile(CompactFileMD::Create(eos::ns::FileMdProto()))
 {
   pFileMDSvc = nullptr;
 }
@@ -47,7 +48,9 @@ QuarkFileMD::QuarkFileMD()
 QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
   pFileMDSvc(fileMDSvc)
 {
-  mFile.set_id(id);
+  eos::ns::FileMdProto proto;
+  proto.set_id(id);
+  mFile.Store(CompactFileMD::Create(proto));
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
 }
 
@@ -57,7 +60,6 @@ QuarkFileMD::QuarkFileMD(IFileMD::id_t id, IFileMDSvc* fileMDSvc):
 QuarkFileMD*
 QuarkFileMD::clone() const
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
   return new QuarkFileMD(*this);
 }
 
@@ -75,9 +77,9 @@ QuarkFileMD::QuarkFileMD(const QuarkFileMD& other)
 QuarkFileMD&
 QuarkFileMD::operator = (const QuarkFileMD& other)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = other.mFile;
-  mClock = other.mClock;
+  // Snapshots are immutable therefore they can be shared between objects
+  mFile.Store(other.mFile.Load());
+  mClock = other.mClock.load();
   pFileMDSvc   = 0;
   return *this;
 }
@@ -93,8 +95,7 @@ void QuarkFileMD::setName(const std::string& name)
     throw_mdexception(EINVAL, "Bug, detected slashes in file name: " << name);
   }
 
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_name(name);
+  mFile.SetName(name);
 }
 
 //------------------------------------------------------------------------------
@@ -103,14 +104,22 @@ void QuarkFileMD::setName(const std::string& name)
 void
 QuarkFileMD::addLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+  bool added = mFile.UpdateLocations([&](LocationVector & locations,
+  LocationVector&) {
+    for (const auto& loc : locations) {
+      if (loc == location) {
+        return false;
+      }
+    }
+
+    locations.push_back(location);
+    return true;
+  });
 
-  if (hasLocationNoLock(location)) {
+  if (!added) {
     return;
   }
 
-  mFile.add_locations(location);
-  lock.unlock();
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::LocationAdded,
                                  location);
   pFileMDSvc->notifyListeners(&e);
@@ -122,18 +131,22 @@ QuarkFileMD::addLocation(location_t location)
 void
 QuarkFileMD::removeLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-
-  for (auto it = mFile.mutable_unlink_locations()->cbegin();
-       it != mFile.mutable_unlink_locations()->cend(); ++it) {
-    if (*it == location) {
-      it = mFile.mutable_unlink_locations()->erase(it);
-      lock.unlock();
-      IFileMDChangeListener::Event
-      e(this, IFileMDChangeListener::LocationRemoved, location);
-      pFileMDSvc->notifyListeners(&e);
-      return;
+  bool removed = mFile.UpdateLocations([&](LocationVector&,
+  LocationVector & unlinked) {
+    for (auto it = unlinked.begin(); it != unlinked.end(); ++it) {
+      if (*it == location) {
+        unlinked.erase(it);
+        return true;
+      }
     }
+
+    return false;
+  });
+
+  if (removed) {
+    IFileMDChangeListener::Event
+    e(this, IFileMDChangeListener::LocationRemoved, location);
+    pFileMDSvc->notifyListeners(&e);
   }
 }
 
@@ -144,16 +157,13 @@ void
 QuarkFileMD::removeAllLocations()
 {
   while (true) {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.unlink_locations().cbegin();
+    CompactFileMD::Ptr file = mFile.Load();
 
-    if (it == mFile.unlink_locations().cend()) {
+    if (file->getNumUnlinkedLocation() == 0) {
       return;
     }
 
-    location_t location = *it;
-    lock.unlock();
-    removeLocation(location);
+    removeLocation(file->getUnlinkedLocations().front());
   }
 }
 
@@ -163,23 +173,36 @@ QuarkFileMD::removeAllLocations()
 void
 QuarkFileMD::unlinkLocation(location_t location)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-
-  for (auto it = mFile.mutable_locations()->cbegin();
-       it != mFile.mutable_locations()->cend(); ++it) {
-    if (*it == location) {
-      // If location is already unlink, skip adding it
-      if (!hasUnlinkedLocationNoLock(location)) {
-        mFile.add_unlink_locations(*it);
+  bool unlinked = mFile.UpdateLocations([&](LocationVector & locations,
+  LocationVector & unlinked_locations) {
+    for (auto it = locations.begin(); it != locations.end(); ++it) {
+      if (*it == location) {
+        // If location is already unlink, skip adding it
+        bool is_unlinked = false;
+
+        for (const auto& loc : unlinked_locations) {
+          if (loc == location) {
+            is_unlinked = true;
+            break;
+          }
+        }
+
+        if (!is_unlinked) {
+          unlinked_locations.push_back(*it);
+        }
+
+        locations.erase(it);
+        return true;
       }
-
-      it = mFile.mutable_locations()->erase(it);
-      lock.unlock();
-      IFileMDChangeListener::Event
-      e(this, IFileMDChangeListener::LocationUnlinked, location);
-      pFileMDSvc->notifyListeners(&e);
-      return;
     }
+
+    return false;
+  });
+
+  if (unlinked) {
+    IFileMDChangeListener::Event
+    e(this, IFileMDChangeListener::LocationUnlinked, location);
+    pFileMDSvc->notifyListeners(&e);
   }
 }
 
@@ -190,16 +213,13 @@ void
 QuarkFileMD::unlinkAllLocations()
 {
   while (true) {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.locations().cbegin();
+    CompactFileMD::Ptr file = mFile.Load();
 
-    if (it == mFile.locations().cend()) {
+    if (file->getNumLocation() == 0) {
       return;
     }
 
-    location_t location = *it;
-    lock.unlock();
-    unlinkLocation(location);
+    unlinkLocation(file->getLocation(0));
   }
 }
 
@@ -209,10 +229,10 @@ QuarkFileMD::unlinkAllLocations()
 void
 QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  CompactFileMD::Ptr file = mFile.Load();
   env = "";
   std::ostringstream oss;
-  std::string saveName = mFile.name();
+  std::string saveName(file->getName());
 
   if (escapeAnd) {
     if (!saveName.empty()) {
@@ -222,39 +242,40 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
 
   ctime_t ctime;
   ctime_t mtime;
-  (void) getCTimeNoLock(ctime);
-  (void) getMTimeNoLock(mtime);
-  oss << "name=" << saveName << "&id=" << mFile.id()
+  file->getCTime(ctime);
+  file->getMTime(mtime);
+  oss << "name=" << saveName << "&id=" << file->getId()
       << "&ctime=" << ctime.tv_sec << "&ctime_ns=" << ctime.tv_nsec
       << "&mtime=" << mtime.tv_sec << "&mtime_ns=" << mtime.tv_nsec
-      << "&size=" << mFile.size() << "&cid=" << mFile.cont_id()
-      << "&uid=" << mFile.uid() << "&gid=" << mFile.gid()
-      << "&lid=" << mFile.layout_id() << "&flags=" << mFile.flags()
-      << "&link=" << mFile.link_name();
+      << "&size=" << file->getSize() << "&cid=" << file->getContainerId()
+      << "&uid=" << file->getCUid() << "&gid=" << file->getCGid()
+      << "&lid=" << file->getLayoutId() << "&flags=" << file->getFlags()
+      << "&link=" << file->getLink();
   env += oss.str();
   env += "&location=";
   char locs[16];
 
-  for (const auto& elem : mFile.locations()) {
+  for (const auto& elem : file->getLocations()) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
-  for (const auto& elem : mFile.unlink_locations()) {
+  for (const auto& elem : file->getUnlinkedLocations()) {
     snprintf(static_cast<char*>(locs), sizeof(locs), "!%u", elem);
     env += static_cast<char*>(locs);
     env += ",";
   }
 
   env += "&checksum=";
-  uint8_t size = mFile.checksum().size();
+  std::string_view checksum = file->getChecksum();
+  uint8_t size = checksum.size();
 
   for (uint8_t i = 0; i < size; i++) {
     char hx[3];
     hx[0] = 0;
     snprintf(static_cast<char*>(hx), sizeof(hx), "%02x",
-             *(unsigned char*)(mFile.checksum().data() + i));
+             *(unsigned char*)(checksum.data() + i));
     env += static_cast<char*>(hx);
   }
 }
@@ -265,11 +286,12 @@ QuarkFileMD::getEnv(std::string& env, bool escapeAnd)
 void
 QuarkFileMD::serialize(eos::Buffer& buffer)
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+  eos::ns::FileMdProto proto;
+  mFile.Load()->toProto(proto);
   // Increase clock to mark that metadata file has suffered updates
   mClock = std::chrono::high_resolution_clock::now().time_since_epoch().count();
   // Align the buffer to 4 bytes to efficiently compute the checksum
-  size_t obj_size = mFile.ByteSizeLong();
+  size_t obj_size = proto.ByteSizeLong();
   uint32_t align_size = (obj_size + 3) >> 2 << 2;
   size_t sz = sizeof(align_size);
   size_t msg_size = align_size + 2 * sz;
@@ -279,7 +301,7 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
   const char* ptr = buffer.getDataPtr() + 2 * sz;
   google::protobuf::io::ArrayOutputStream aos((void*)ptr, align_size);
 
-  if (!mFile.SerializeToZeroCopyStream(&aos)) {
+  if (!proto.SerializeToZeroCopyStream(&aos)) {
     MDException ex(EIO);
     ex.getMessage() << "Failed while serializing buffer";
     throw ex;
@@ -301,8 +323,7 @@ QuarkFileMD::serialize(eos::Buffer& buffer)
 void
 QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile = std::move(proto);
+  mFile.Store(CompactFileMD::Create(proto));
 }
 
 //------------------------------------------------------------------------------
@@ -311,17 +332,20 @@ QuarkFileMD::initialize(eos::ns::FileMdProto&& proto)
 void
 QuarkFileMD::deserialize(const eos::Buffer& buffer)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  Serialization::deserializeFile(buffer, mFile);
+  eos::ns::FileMdProto proto;
+  Serialization::deserializeFile(buffer, proto);
+  mFile.Store(CompactFileMD::Create(proto));
 }
 
 //----------------------------------------------------------------------------
-// Get reference to underlying protobuf object
+// Get copy of the file metadata as protobuf object
 //----------------------------------------------------------------------------
-const eos::ns::FileMdProto&
+eos::ns::FileMdProto
 QuarkFileMD::getProto() const
 {
-  return mFile;
+  eos::ns::FileMdProto proto;
+  mFile.Load()->toProto(proto);
+  return proto;
 }
 
 //------------------------------------------------------------------------------
@@ -330,32 +354,24 @@ QuarkFileMD::getProto() const
 void
 QuarkFileMD::setSize(uint64_t size)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  int64_t sizeChange = (size & 0x0000ffffffffffff) - mFile.size();
-  mFile.set_size(size & 0x0000ffffffffffff);
-  lock.unlock();
+  int64_t sizeChange = 0;
+  mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+    sizeChange = (size & 0x0000ffffffffffff) - fields.mSize;
+    fields.mSize = size & 0x0000ffffffffffff;
+    return true;
+  });
   IFileMDChangeListener::Event e(this, IFileMDChangeListener::SizeChange, 0,
                                  sizeChange);
   pFileMDSvc->notifyListeners(&e);
 }
 
-//------------------------------------------------------------------------------
-// Get creation time, no lock
-//------------------------------------------------------------------------------
-void
-QuarkFileMD::getCTimeNoLock(ctime_t& ctime) const
-{
-  (void) memcpy(&ctime, mFile.ctime().data(), sizeof(ctime_t));
-}
-
 //------------------------------------------------------------------------------
 // Get creation time
 //------------------------------------------------------------------------------
 void
 QuarkFileMD::getCTime(ctime_t& ctime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  getCTimeNoLock(ctime);
+  mFile.Load()->getCTime(ctime);
 }
 
 //------------------------------------------------------------------------------
@@ -364,8 +380,7 @@ QuarkFileMD::getCTime(ctime_t& ctime) const
 void
 QuarkFileMD::setCTime(ctime_t ctime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_ctime(&ctime, sizeof(ctime));
+  mFile.SetCTime(ctime);
 }
 
 //----------------------------------------------------------------------------
@@ -386,23 +401,13 @@ QuarkFileMD::setCTimeNow()
   setCTime(tnow);
 }
 
-//------------------------------------------------------------------------------
-// Get modification time, no locks
-//------------------------------------------------------------------------------
-void
-QuarkFileMD::getMTimeNoLock(ctime_t& mtime) const
-{
-  (void) memcpy(&mtime, mFile.mtime().data(), sizeof(ctime_t));
-}
-
 //------------------------------------------------------------------------------
 // Get modification time
 //------------------------------------------------------------------------------
 void
 QuarkFileMD::getMTime(ctime_t& mtime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  getMTimeNoLock(mtime);
+  mFile.Load()->getMTime(mtime);
 }
 
 //------------------------------------------------------------------------------
@@ -411,8 +416,7 @@ QuarkFileMD::getMTime(ctime_t& mtime) const
 void
 QuarkFileMD::setMTime(ctime_t mtime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_mtime(&mtime, sizeof(mtime));
+  mFile.SetMTime(mtime);
 }
 
 //------------------------------------------------------------------------------
@@ -441,27 +445,14 @@ QuarkFileMD::setMTimeNow()
  * zero when MTime is set to now (thus logically setting them both).
  */
 
-//------------------------------------------------------------------------------
-// Get sync time, no lock
-//------------------------------------------------------------------------------
-void
-QuarkFileMD::getSyncTimeNoLock(ctime_t& stime) const
-{
-  (void) memcpy(&stime, mFile.stime().data(), sizeof(stime));
-
-  if (stime.tv_sec == 0) {  /* fall back to mtime if default */
-    (void) memcpy(&stime, mFile.mtime().data(), sizeof(stime));
-  }
-}
-
 //------------------------------------------------------------------------------
 // Get sync time
 //------------------------------------------------------------------------------
 void
 QuarkFileMD::getSyncTime(ctime_t& stime) const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  getSyncTimeNoLock(stime);
+  // Falls back to mtime if not set
+  mFile.Load()->getSyncTime(stime);
 }
 
 //------------------------------------------------------------------------------
@@ -470,8 +461,7 @@ QuarkFileMD::getSyncTime(ctime_t& stime) const
 void
 QuarkFileMD::setSyncTime(ctime_t stime)
 {
-  std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-  mFile.set_stime(&stime, sizeof(stime));
+  mFile.SetSyncTime(stime);
 }
 
 //------------------------------------------------------------------------------
@@ -491,14 +481,7 @@ QuarkFileMD::setSyncTimeNow()
 eos::IFileMD::XAttrMap
 QuarkFileMD::getAttributes() const
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  std::map<std::string, std::string> xattrs;
-
-  for (const auto& elem : mFile.xattrs()) {
-    xattrs.insert(elem);
-  }
-
-  return xattrs;
+  return mFile.Load()->getAttributes();
 }
 
 //------------------------------------------------------------------------------
@@ -506,22 +489,7 @@ QuarkFileMD::getAttributes() const
 //------------------------------------------------------------------------------
 bool QuarkFileMD::hasUnlinkedLocation(IFileMD::location_t location)
 {
-  std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-  return hasUnlinkedLocationNoLock(location);
-}
-
-//------------------------------------------------------------------------------
-// Test the unlinked location, no locks
-//------------------------------------------------------------------------------
-bool QuarkFileMD::hasUnlinkedLocationNoLock(location_t location) const
-{
-  for (int i = 0; i < mFile.unlink_locations_size(); ++i) {
-    if (mFile.unlink_locations()[i] == location) {
-      return true;
-    }
-  }
-
-  return false;
+  return mFile.Load()->hasUnlinkedLocation(location);
 }
 
 
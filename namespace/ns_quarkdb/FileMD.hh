@@ -26,8 +26,10 @@
 
 #include "common/SharedMutexWrapper.hh"
 #include "namespace/interface/IFileMD.hh"
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
 #include "namespace/ns_quarkdb/persistency/FileMDSvc.hh"
 #include "proto/FileMd.pb.h"
+#include <atomic>
 #include <cstdint>
 #include <sys/time.h>
 
@@ -129,8 +131,7 @@ public:
   inline IFileMD::id_t
   getId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.id();
+    return mFile.Load()->getId();
   }
 
   //----------------------------------------------------------------------------
@@ -138,8 +139,7 @@ public:
   //----------------------------------------------------------------------------
   inline FileIdentifier getIdentifier() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return FileIdentifier(mFile.id());
+    return FileIdentifier(mFile.Load()->getId());
   }
 
   //----------------------------------------------------------------------------
@@ -148,8 +148,7 @@ public:
   inline uint64_t
   getSize() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.size();
+    return mFile.Load()->getSize();
   }
 
   //----------------------------------------------------------------------------
@@ -163,8 +162,7 @@ public:
   inline uint64_t
   getCloneId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cloneid();
+    return mFile.Load()->getCloneId();
   }
 
   //----------------------------------------------------------------------------
@@ -172,8 +170,10 @@ public:
   //----------------------------------------------------------------------------
   void setCloneId(uint64_t id) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cloneid(id);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mCloneId = id;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -182,8 +182,7 @@ public:
   const std::string
   getCloneFST() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.clonefst();
+    return std::string(mFile.Load()->getCloneFST());
   }
 
   //----------------------------------------------------------------------------
@@ -191,8 +190,7 @@ public:
   //----------------------------------------------------------------------------
   void setCloneFST(const std::string& data) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_clonefst(data);
+    mFile.SetCloneFST(data);
   }
 
   //----------------------------------------------------------------------------
@@ -201,8 +199,7 @@ public:
   inline IContainerMD::id_t
   getContainerId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.cont_id();
+    return mFile.Load()->getContainerId();
   }
 
   //----------------------------------------------------------------------------
@@ -211,8 +208,10 @@ public:
   void
   setContainerId(IContainerMD::id_t containerId) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_cont_id(containerId);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mContId = containerId;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -221,9 +220,10 @@ public:
   inline const Buffer
   getChecksum() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    Buffer buff(mFile.checksum().size());
-    buff.putData((void*)mFile.checksum().data(), mFile.checksum().size());
+    CompactFileMD::Ptr file = mFile.Load();
+    std::string_view checksum = file->getChecksum();
+    Buffer buff(checksum.size());
+    buff.putData((void*)checksum.data(), checksum.size());
     return buff;
   }
 
@@ -233,8 +233,8 @@ public:
   void
   setChecksum(const Buffer& checksum) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum.getDataPtr(), checksum.getSize());
+    mFile.SetChecksum(std::string_view(checksum.getDataPtr(),
+                                       checksum.getSize()));
   }
 
   //----------------------------------------------------------------------------
@@ -243,8 +243,7 @@ public:
   void
   clearChecksum(uint8_t size = 20) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_checksum();
+    mFile.SetChecksum(std::string_view());
   }
 
   //----------------------------------------------------------------------------
@@ -256,8 +255,8 @@ public:
   void
   setChecksum(const void* checksum, uint8_t size) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_checksum(checksum, size);
+    mFile.SetChecksum(std::string_view(static_cast<const char*>(checksum),
+                                       size));
   }
 
   //----------------------------------------------------------------------------
@@ -266,8 +265,7 @@ public:
   inline const std::string
   getName() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.name();
+    return std::string(mFile.Load()->getName());
   }
 
   //----------------------------------------------------------------------------
@@ -285,9 +283,7 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getLocations() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector locations(mFile.locations().begin(), mFile.locations().end());
-    return locations;
+    return mFile.Load()->getLocations();
   }
 
   //----------------------------------------------------------------------------
@@ -296,13 +292,7 @@ public:
   location_t
   getLocation(unsigned int index) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-
-    if (index < (unsigned int)mFile.locations_size()) {
-      return mFile.locations(index);
-    }
-
-    return 0;
+    return mFile.Load()->getLocation(index);
   }
 
   //----------------------------------------------------------------------------
@@ -321,23 +311,10 @@ public:
   void
   clearLocations() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_locations();
-  }
-
-  //----------------------------------------------------------------------------
-  //! Test if location exists, without taking lock
-  //----------------------------------------------------------------------------
-  bool
-  hasLocationNoLock(location_t location)
-  {
-    for (int i = 0; i < mFile.locations_size(); i++) {
-      if (mFile.locations(i) == location) {
-        return true;
-      }
-    }
-
-    return false;
+    mFile.UpdateLocations([](LocationVector & locations, LocationVector&) {
+      locations.clear();
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -346,8 +323,7 @@ public:
   bool
   hasLocation(location_t location) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return hasLocationNoLock(location);
+    return mFile.Load()->hasLocation(location);
   }
 
   //----------------------------------------------------------------------------
@@ -356,8 +332,7 @@ public:
   inline size_t
   getNumLocation() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.locations_size();
+    return mFile.Load()->getNumLocation();
   }
 
   //----------------------------------------------------------------------------
@@ -365,10 +340,7 @@ public:
   //----------------------------------------------------------------------------
   inline LocationVector getUnlinkedLocations() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    LocationVector unlinked_locations(mFile.unlink_locations().begin(),
-                                      mFile.unlink_locations().end());
-    return unlinked_locations;
+    return mFile.Load()->getUnlinkedLocations();
   }
 
   //----------------------------------------------------------------------------
@@ -387,8 +359,10 @@ public:
   inline void
   clearUnlinkedLocations() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_unlink_locations();
+    mFile.UpdateLocations([](LocationVector&, LocationVector & unlinked) {
+      unlinked.clear();
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -403,8 +377,7 @@ public:
   inline size_t
   getNumUnlinkedLocation() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.unlink_locations_size();
+    return mFile.Load()->getNumUnlinkedLocation();
   }
 
   //----------------------------------------------------------------------------
@@ -413,8 +386,7 @@ public:
   inline uid_t
   getCUid() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.uid();
+    return mFile.Load()->getCUid();
   }
 
   //----------------------------------------------------------------------------
@@ -423,8 +395,10 @@ public:
   inline void
   setCUid(uid_t uid) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_uid(uid);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mUid = uid;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -433,8 +407,7 @@ public:
   inline gid_t
   getCGid() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.gid();
+    return mFile.Load()->getCGid();
   }
 
   //----------------------------------------------------------------------------
@@ -443,8 +416,10 @@ public:
   inline void
   setCGid(gid_t gid) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_gid(gid);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mGid = gid;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -453,8 +428,7 @@ public:
   inline layoutId_t
   getLayoutId() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.layout_id();
+    return mFile.Load()->getLayoutId();
   }
 
   //----------------------------------------------------------------------------
@@ -463,8 +437,10 @@ public:
   inline void
   setLayoutId(layoutId_t layoutId) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_layout_id(layoutId);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mLayoutId = layoutId;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -473,8 +449,7 @@ public:
   inline uint16_t
   getFlags() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.flags();
+    return mFile.Load()->getFlags();
   }
 
   //----------------------------------------------------------------------------
@@ -483,8 +458,7 @@ public:
   inline bool
   getFlag(uint8_t n) override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (bool)(mFile.flags() & (0x0001 << n));
+    return (bool)(mFile.Load()->getFlags() & (0x0001 << n));
   }
 
   //----------------------------------------------------------------------------
@@ -493,8 +467,10 @@ public:
   inline void
   setFlags(uint16_t flags) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_flags(flags);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      fields.mFlags = flags;
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -503,13 +479,15 @@ public:
   void
   setFlag(uint8_t n, bool flag) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+    mFile.UpdateFields([&](CompactFileMD::Fields & fields) {
+      if (flag) {
+        fields.mFlags |= (1 << n);
+      } else {
+        fields.mFlags &= ~(1 << n);
+      }
 
-    if (flag) {
-      mFile.set_flags(mFile.flags() | (1 << n));
-    } else {
-      mFile.set_flags(mFile.flags() & (~(1 << n)));
-    }
+      return true;
+    });
   }
 
   //----------------------------------------------------------------------------
@@ -523,7 +501,6 @@ public:
   inline void
   setFileMDSvc(IFileMDSvc* fileMDSvc) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
     pFileMDSvc = static_cast<QuarkFileMDSvc*>(fileMDSvc);
   }
 
@@ -533,7 +510,6 @@ public:
   inline virtual IFileMDSvc*
   getFileMDSvc() override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
     return pFileMDSvc;
   }
 
@@ -543,8 +519,7 @@ public:
   inline std::string
   getLink() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.link_name();
+    return std::string(mFile.Load()->getLink());
   }
 
   //----------------------------------------------------------------------------
@@ -553,8 +528,7 @@ public:
   inline void
   setLink(std::string link_name) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.set_link_name(link_name);
+    mFile.SetLink(link_name);
   }
 
   //----------------------------------------------------------------------------
@@ -563,8 +537,7 @@ public:
   bool
   isLink() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return !mFile.link_name().empty();
+    return !mFile.Load()->getLink().empty();
   }
 
   //----------------------------------------------------------------------------
@@ -573,8 +546,7 @@ public:
   void
   setAttribute(const std::string& name, const std::string& value) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    (*mFile.mutable_xattrs())[name] = value;
+    mFile.SetAttribute(name, value);
   }
 
   //----------------------------------------------------------------------------
@@ -583,12 +555,7 @@ public:
   void
   removeAttribute(const std::string& name) override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
-
-    if (it != mFile.xattrs().end()) {
-      mFile.mutable_xattrs()->erase(it->first);
-    }
+    (void) mFile.RemoveAttribute(name);
   }
 
   //----------------------------------------------------------------------------
@@ -596,8 +563,7 @@ public:
   //----------------------------------------------------------------------------
   void clearAttributes() override
   {
-    std::unique_lock<std::shared_timed_mutex> lock(mMutex);
-    mFile.clear_xattrs();
+    mFile.ClearAttributes();
   }
 
   //----------------------------------------------------------------------------
@@ -606,8 +572,7 @@ public:
   bool
   hasAttribute(const std::string& name) const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return (mFile.xattrs().find(name) != mFile.xattrs().end());
+    return mFile.Load()->hasAttribute(name);
   }
 
   //----------------------------------------------------------------------------
@@ -616,8 +581,7 @@ public:
   inline size_t
   numAttributes() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    return mFile.xattrs().size();
+    return mFile.Load()->numAttributes();
   }
 
   //----------------------------------------------------------------------------
@@ -626,16 +590,15 @@ public:
   std::string
   getAttribute(const std::string& name) const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
-    auto it = mFile.xattrs().find(name);
+    std::string value;
 
-    if (it == mFile.xattrs().end()) {
+    if (!mFile.Load()->getAttribute(name, value)) {
       MDException e(ENOENT);
       e.getMessage() << "Attribute: " << name << " not found";
       throw e;
     }
 
-    return it->second;
+    return value;
   }
 
   //----------------------------------------------------------------------------
@@ -661,16 +624,24 @@ public:
   void deserialize(const Buffer& buffer) override;
 
   //----------------------------------------------------------------------------
-  //! Get reference to underlying protobuf object
+  //! Get copy of the file metadata as protobuf object
+  //----------------------------------------------------------------------------
+  eos::ns::FileMdProto getProto() const;
+
+  //----------------------------------------------------------------------------
+  //! Get the current compact snapshot of the file metadata, it stays valid
+  //! even if the file gets modified in the meantime
   //----------------------------------------------------------------------------
-  const eos::ns::FileMdProto& getProto() const;
+  inline CompactFileMD::Ptr getSnapshot() const
+  {
+    return mFile.Load();
+  }
 
   //----------------------------------------------------------------------------
   //! Get value tracking changes to the metadata object
   //----------------------------------------------------------------------------
   virtual uint64_t getClock() const override
   {
-    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
     return mClock;
   };
 
@@ -680,29 +651,10 @@ protected:
 private:
   FRIEND_TEST(VariousTests, EtagFormatting);
 
-  //----------------------------------------------------------------------------
-  //! Get modification time, no locks
-  //----------------------------------------------------------------------------
-  void getMTimeNoLock(ctime_t& mtime) const;
-
-  //----------------------------------------------------------------------------
-  //! Get modification time, no locks
-  //----------------------------------------------------------------------------
-  void getSyncTimeNoLock(ctime_t& stime) const;
-
-  //----------------------------------------------------------------------------
-  //! Get creation time, no locks
-  //----------------------------------------------------------------------------
-  void getCTimeNoLock(ctime_t& ctime) const;
-
-  //----------------------------------------------------------------------------
-  //! Test the unlinked location, no locks
-  //----------------------------------------------------------------------------
-  bool hasUnlinkedLocationNoLock(location_t location) const;
-
-
-  eos::ns::FileMdProto mFile; ///< Protobuf file representation
-  uint64_t mClock; ///< Value tracking metadata changes
+  //! Compact file representation, readers use the current snapshot without
+  //! any locking while writers publish a modified copy (copy-on-write)
+  CompactFileMDSlot mFile;
+  std::atomic<uint64_t> mClock {0}; ///< Value tracking metadata changes
 };
 
 EOSNSNAMESPACE_END
@@ -30,11 +30,13 @@
 #include "common/Murmur3.hh"
 #include "namespace/Namespace.hh"
 #include <google/dense_hash_map>
+#include <algorithm>
 #include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <vector>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -114,6 +116,15 @@ public:
   //----------------------------------------------------------------------------
   bool remove(IdT id);
 
+  //----------------------------------------------------------------------------
+  //! Get the ids of the most recently used entries
+  //!
+  //! @param max_num maximum number of ids to return
+  //!
+  //! @return ids ordered from the most to the least recently used
+  //----------------------------------------------------------------------------
+  std::vector<IdT> getRecentIds(std::uint64_t max_num) const;
+
   //----------------------------------------------------------------------------
   //! Get cache size
   //!
@@ -303,6 +314,25 @@ LRU<IdT, EntryT>::remove(IdT id)
   return true;
 }
 
+//------------------------------------------------------------------------------
+// Get the ids of the most recently used entries
+//------------------------------------------------------------------------------
+template <typename IdT, typename EntryT>
+std::vector<IdT>
+LRU<IdT, EntryT>::getRecentIds(std::uint64_t max_num) const
+{
+  std::vector<IdT> ids;
+  std::unique_lock<std::mutex> lock(mMutex);
+  ids.reserve(std::min(max_num, (std::uint64_t) mList.size()));
+
+  for (auto it = mList.rbegin(); (it != mList.rend()) && (ids.size() < max_num);
+       ++it) {
+    ids.push_back(IdT((*it)->getId()));
+  }
+
+  return ids;
+}
+
 //----------------------------------------------------------------------------
 // Cleaner job taking care of deallocating entries that are passed through
 // the queue to delete
@@ -22,6 +22,8 @@
 #include "namespace/utils/Attributes.hh"
 #include "common/Assert.hh"
 #include "common/Path.hh"
+#include <algorithm>
+#include <iostream>
 #include <memory>
 #include <numeric>
 #include <folly/executors/IOThreadPoolExecutor.h>
@@ -30,6 +32,8 @@
 
 EOSNSNAMESPACE_BEGIN
 
+constexpr size_t NamespaceExplorer::sFileChunkSize;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -212,6 +216,10 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
                       "NamespaceExplorer: asked to populate linked attrs, but view not provided");
   }
 
+  if (options.parallelism > 0) {
+    mParallel = std::make_shared<ParallelState>();
+  }
+
   std::vector<std::string> pathParts = eos::common::SplitPath(path);
   // This part is synchronous by necessity.
   staticPath.emplace_back(MetadataFetcher::getContainerFromId(qcl,
@@ -219,8 +227,7 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
 
   if (pathParts.empty()) {
     // We're running a search on the root node, expand.
-    dfsPath.emplace_back(new SearchNode(*this, ContainerIdentifier(1),
-                                        ContainerIdentifier(1), nullptr, executor, opts.ignoreFiles));
+    addStartNode(ContainerIdentifier(1), ContainerIdentifier(1));
   }
 
   // TODO: This for loop looks like a useful primitive for MetadataFetcher,
@@ -266,13 +273,29 @@ NamespaceExplorer::NamespaceExplorer(const std::string& pth,
         staticPath.emplace_back(MetadataFetcher::getContainerFromId(qcl, nextId).get());
       } else {
         // Final node, expand
-        dfsPath.emplace_back(new SearchNode(*this, parentID, nextId, nullptr, executor,
-                                            opts.ignoreFiles));
+        addStartNode(parentID, nextId);
       }
     }
   }
 }
 
+//------------------------------------------------------------------------------
+// Register the container where the exploration starts
+//------------------------------------------------------------------------------
+void NamespaceExplorer::addStartNode(ContainerIdentifier expectedParent,
+                                     ContainerIdentifier id)
+{
+  if (!mParallel) {
+    dfsPath.emplace_back(new SearchNode(*this, expectedParent, id, nullptr,
+                                        executor, options.ignoreFiles));
+    return;
+  }
+
+  mPendingStack.push_back(PendingContainer{mNextSeq++, expectedParent, id,
+                          std::make_shared<const std::string>(buildStaticPath()),
+                          false});
+}
+
 //------------------------------------------------------------------------------
 // Build static path
 //------------------------------------------------------------------------------
@@ -407,6 +430,10 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
     return true;
   }
 
+  if (mParallel) {
+    return fetchParallel(item);
+  }
+
   while (!dfsPath.empty()) {
     dfsPath.back()->handleAsync();
 
@@ -419,19 +446,7 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
       item.numFiles = dfsPath.back()->getNumFiles();
       item.numContainers = dfsPath.back()->getNumContainers();
       handleLinkedAttrs(item);
-      item.expansionFilteredOut = false;
-
-      if (options.expansionDecider) {
-        item.expansionFilteredOut = !options.expansionDecider->shouldExpandContainer(
-                                      item.containerMd, item.attrs, item.fullPath);
-      }
-
-      if (options.depthLimit > 0) {
-        eos::common::Path cpath{item.fullPath};
-        item.expansionFilteredOut = (item.expansionFilteredOut
-                                     || (cpath.GetSubPathSize() > options.depthLimit));
-      }
-
+      decideExpansion(item);
       dfsPath.back()->expansionFilteredOut = item.expansionFilteredOut;
       return true;
     }
@@ -462,4 +477,500 @@ bool NamespaceExplorer::fetch(NamespaceItem& item)
   return false;
 }
 
+//------------------------------------------------------------------------------
+// Apply expansion decider and depth limit to the given container item
+//------------------------------------------------------------------------------
+void NamespaceExplorer::decideExpansion(NamespaceItem& item)
+{
+  item.expansionFilteredOut = false;
+
+  if (options.expansionDecider) {
+    item.expansionFilteredOut = !options.expansionDecider->shouldExpandContainer(
+                                  item.containerMd, item.attrs, item.fullPath);
+  }
+
+  if (options.depthLimit > 0) {
+    eos::common::Path cpath{item.fullPath};
+    item.expansionFilteredOut = (item.expansionFilteredOut
+                                 || (cpath.GetSubPathSize() > options.depthLimit));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Number of entries held by the children of a container, used for the memory
+// bound
+//------------------------------------------------------------------------------
+static uint64_t getBufferedItems(const ExpandedContainer& cont)
+{
+  return cont.children.size() + cont.fileIds.size() + cont.files.size();
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: fetch container metadata and number of entries
+//------------------------------------------------------------------------------
+folly::Future<ContainerHeader>
+NamespaceExplorer::fetchHeader(ContainerIdentifier id)
+{
+  auto counts = MetadataFetcher::countContents(qcl, id);
+  return folly::collect(MetadataFetcher::getContainerFromId(qcl, id),
+                        std::move(counts.first), std::move(counts.second))
+         .via(executor)
+  .thenValue([ignoreFiles = options.ignoreFiles](
+  std::tuple<eos::ns::ContainerMdProto, uint64_t, uint64_t>&& res) {
+    ContainerHeader out;
+    out.containerMd = std::move(std::get<0>(res));
+    out.numFiles = (ignoreFiles ? 0 : std::get<1>(res));
+    out.numContainers = std::get<2>(res);
+    return out;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: fetch the metadata of the given files
+//------------------------------------------------------------------------------
+folly::Future<FileChunk>
+NamespaceExplorer::fetchFileChunk(qclient::QClient& qcl,
+                                  folly::Executor* executor,
+                                  const std::vector<IFileMD::id_t>& ids,
+                                  size_t begin, size_t end)
+{
+  std::vector<folly::Future<eos::ns::FileMdProto>> futs;
+  futs.reserve(end - begin);
+
+  for (size_t i = begin; i < end; ++i) {
+    futs.emplace_back(MetadataFetcher::getFileFromId(qcl, FileIdentifier(ids[i])));
+  }
+
+  return folly::collectAll(futs.begin(), futs.end()).via(executor);
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: fetch subcontainers, file ids and the first chunk of files
+//------------------------------------------------------------------------------
+folly::Future<ExpandedContainer>
+NamespaceExplorer::fetchChildren(const NamespaceItem& item)
+{
+  const ContainerIdentifier id(item.containerMd.id());
+  folly::Future<IContainerMD::ContainerMap> containerMap =
+    folly::makeFuture<IContainerMD::ContainerMap>(IContainerMD::ContainerMap());
+  folly::Future<IContainerMD::FileMap> fileMap =
+    folly::makeFuture<IContainerMD::FileMap>(IContainerMD::FileMap());
+
+  if (item.numContainers) {
+    containerMap = MetadataFetcher::getContainerMap(qcl, id);
+  }
+
+  if (item.numFiles) {
+    fileMap = MetadataFetcher::getFileMap(qcl, id);
+  }
+
+  qclient::QClient* qclient = &qcl;
+  folly::Executor* exec = executor;
+  return folly::collect(std::move(containerMap), std::move(fileMap))
+         .via(executor)
+  .thenValue([qclient, exec](std::tuple<IContainerMD::ContainerMap,
+  IContainerMD::FileMap>&& res) {
+    ExpandedContainer out;
+    const IContainerMD::ContainerMap& containerMap = std::get<0>(res);
+    out.children.reserve(containerMap.size());
+
+    for (auto it = containerMap.begin(); it != containerMap.end(); ++it) {
+      out.children.emplace_back(it->first, it->second);
+    }
+
+    std::sort(out.children.begin(), out.children.end());
+    // Files are returned sorted by name
+    const IContainerMD::FileMap& fileMap = std::get<1>(res);
+    std::vector<std::pair<std::string, IFileMD::id_t>> files;
+    files.reserve(fileMap.size());
+
+    for (auto it = fileMap.begin(); it != fileMap.end(); ++it) {
+      files.emplace_back(it->first, it->second);
+    }
+
+    std::sort(files.begin(), files.end());
+    out.fileIds.reserve(files.size());
+
+    for (const auto& file : files) {
+      out.fileIds.push_back(file.second);
+    }
+
+    const size_t end = std::min(out.fileIds.size(), sFileChunkSize);
+    folly::Future<FileChunk> chunk = fetchFileChunk(*qclient, exec, out.fileIds,
+                                     0, end);
+    return std::move(chunk).thenValue([out = std::move(out)](FileChunk && chunk)
+    mutable {
+      out.files = std::move(chunk);
+      return std::move(out);
+    });
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: start fetching the metadata of the given container
+//------------------------------------------------------------------------------
+void NamespaceExplorer::startHeader(PendingContainer& node)
+{
+  node.started = true;
+  ++mInFlight;
+  ++mParallel->running;
+  mStarted.emplace(node.seq, node);
+  std::shared_ptr<ParallelState> state = mParallel;
+  const uint64_t seq = node.seq;
+  // The state is shared so that the callback can safely run even if the
+  // explorer is destroyed in the meantime
+  fetchHeader(node.id)
+  .thenTry([state, seq](folly::Try<ContainerHeader>&& res) {
+    if (res.hasValue()) {
+      ++state->bufferedItems;
+    }
+
+    std::unique_lock<std::mutex> lock(state->mtx);
+    state->headers.emplace(seq, std::move(res));
+    --state->running;
+    state->cv.notify_all();
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: start fetching the children of the given container
+//------------------------------------------------------------------------------
+void NamespaceExplorer::startChildren(FetchedContainer& cont)
+{
+  cont.childrenStarted = true;
+  ++mParallel->running;
+  std::shared_ptr<ParallelState> state = mParallel;
+  const uint64_t seq = cont.seq;
+  fetchChildren(cont.item)
+  .thenTry([state, seq](folly::Try<ExpandedContainer>&& res) {
+    if (res.hasValue()) {
+      state->bufferedItems += getBufferedItems(res.value());
+    }
+
+    std::unique_lock<std::mutex> lock(state->mtx);
+    state->children.emplace(seq, std::move(res));
+    --state->running;
+    state->cv.notify_all();
+  });
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: check if more fetches can be started
+//------------------------------------------------------------------------------
+bool NamespaceExplorer::canStartFetch() const
+{
+  // Completed fetches only count towards the memory bound
+  return (mParallel->running < options.parallelism) &&
+         (mParallel->bufferedItems < options.maxBufferedItems);
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: take the expansion decision of the containers whose
+// metadata arrived
+//------------------------------------------------------------------------------
+void NamespaceExplorer::decideFetched()
+{
+  std::map<uint64_t, folly::Try<ContainerHeader>> headers;
+  {
+    std::unique_lock<std::mutex> lock(mParallel->mtx);
+    headers.swap(mParallel->headers);
+  }
+
+  for (auto& entry : headers) {
+    auto itStarted = mStarted.find(entry.first);
+    const PendingContainer& node = itStarted->second;
+    FetchedContainer& cont = mFetched[entry.first];
+    cont.seq = entry.first;
+
+    if (entry.second.hasException()) {
+      // Container could not be fetched, skip it just like the sequential DFS
+      cont.failed = true;
+      mStarted.erase(itStarted);
+      continue;
+    }
+
+    ContainerHeader& header = entry.second.value();
+    const eos::ns::ContainerMdProto& md = header.containerMd;
+
+    if (md.parent_id() != node.expectedParent.getUnderlyingUInt64()) {
+      std::cerr << "WARNING: Container #" << md.id() <<
+                " was expected to have #" <<
+                node.expectedParent.getUnderlyingUInt64() <<
+                " as parent; instead it has #" << md.parent_id() << std::endl;
+    }
+
+    NamespaceItem& item = cont.item;
+    item.isFile = false;
+
+    if (md.id() == 1) {
+      item.fullPath = *node.parentPath;
+    } else {
+      item.fullPath = *node.parentPath + md.name() + "/";
+    }
+
+    item.containerMd = std::move(header.containerMd);
+    item.numFiles = header.numFiles;
+    item.numContainers = header.numContainers;
+    handleLinkedAttrs(item);
+    decideExpansion(item);
+    mStarted.erase(itStarted);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: decide the expansion of the fetched containers and start
+// fetches while within the limits
+//------------------------------------------------------------------------------
+void NamespaceExplorer::startPending()
+{
+  decideFetched();
+
+  // The children of the containers consumed next are fetched first, the
+  // containers deeper in the stack have a higher sequence number
+  for (auto it = mFetched.rbegin(); it != mFetched.rend(); ++it) {
+    FetchedContainer& cont = it->second;
+
+    if (cont.failed || cont.childrenStarted || cont.item.expansionFilteredOut) {
+      continue;
+    }
+
+    if (!canStartFetch()) {
+      break;
+    }
+
+    startChildren(cont);
+  }
+
+  if (options.ordered) {
+    // The next container in DFS order is always needed, then prefetch the
+    // ones below it in the stack
+    for (size_t i = mPendingStack.size(); i > 0; --i) {
+      PendingContainer& node = mPendingStack[i - 1];
+
+      if (node.started) {
+        continue;
+      }
+
+      if ((i != mPendingStack.size()) && !canStartFetch()) {
+        break;
+      }
+
+      startHeader(node);
+    }
+
+    return;
+  }
+
+  // Unordered: take from the top of the stack to keep it small, make sure
+  // there is always something in flight while the stack is not empty
+  while (!mPendingStack.empty() && ((mInFlight == 0) || canStartFetch())) {
+    PendingContainer node = std::move(mPendingStack.back());
+    mPendingStack.pop_back();
+    startHeader(node);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: wait for the next container and make it current
+//------------------------------------------------------------------------------
+bool NamespaceExplorer::nextExpanded()
+{
+  while (true) {
+    startPending();
+    uint64_t seq = 0;
+
+    if (options.ordered) {
+      if (mPendingStack.empty()) {
+        return false;
+      }
+
+      seq = mPendingStack.back().seq;
+      mPendingStack.pop_back();
+
+      if (mFetched.count(seq) == 0) {
+        {
+          std::unique_lock<std::mutex> lock(mParallel->mtx);
+          mParallel->cv.wait(lock, [&]() {
+            return mParallel->headers.count(seq) != 0;
+          });
+        }
+        decideFetched();
+      }
+    } else {
+      if (mFetched.empty()) {
+        if (mStarted.empty()) {
+          return false;
+        }
+
+        {
+          std::unique_lock<std::mutex> lock(mParallel->mtx);
+          mParallel->cv.wait(lock, [&]() {
+            return !mParallel->headers.empty();
+          });
+        }
+        decideFetched();
+      }
+
+      // Take the deepest container to keep the stack small
+      seq = mFetched.rbegin()->first;
+    }
+
+    auto it = mFetched.find(seq);
+    mCurrent.reset(new FetchedContainer(std::move(it->second)));
+    mFetched.erase(it);
+    --mInFlight;
+
+    if (mCurrent->failed) {
+      mCurrent.reset();
+      continue;
+    }
+
+    --mParallel->bufferedItems;
+
+    if (!mCurrent->item.expansionFilteredOut && !mCurrent->childrenStarted) {
+      startChildren(*mCurrent);
+    }
+
+    mCurrentEmitted = false;
+    return true;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: wait for the children of the current container and push
+// the subcontainers on the stack
+//------------------------------------------------------------------------------
+void NamespaceExplorer::expandCurrent()
+{
+  const uint64_t seq = mCurrent->seq;
+  folly::Try<ExpandedContainer> res;
+  {
+    std::unique_lock<std::mutex> lock(mParallel->mtx);
+    mParallel->cv.wait(lock, [&]() {
+      return mParallel->children.count(seq) != 0;
+    });
+    auto it = mParallel->children.find(seq);
+    res = std::move(it->second);
+    mParallel->children.erase(it);
+  }
+  mCurrentChildren.reset(new ExpandedContainer());
+  mChunkIdx = 0;
+  mNextFileId = 0;
+  mPendingChunks.clear();
+
+  if (res.hasException()) {
+    // Children could not be fetched, nothing to return for this container
+    return;
+  }
+
+  *mCurrentChildren = std::move(res.value());
+  mNextFileId = mCurrentChildren->files.size();
+  // The subcontainers are now tracked by the stack
+  auto& children = mCurrentChildren->children;
+  mParallel->bufferedItems -= children.size();
+  // Push in reverse order so that the first child ends up on top
+  auto parentPath = std::make_shared<const std::string>(mCurrent->item.fullPath);
+  const ContainerIdentifier parentId(mCurrent->item.containerMd.id());
+
+  for (auto it = children.rbegin(); it != children.rend(); ++it) {
+    mPendingStack.push_back(PendingContainer{mNextSeq++, parentId,
+                            ContainerIdentifier(it->second), parentPath, false});
+  }
+
+  children.clear();
+  startPending();
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: get the next file of the current container
+//------------------------------------------------------------------------------
+bool NamespaceExplorer::nextFile(eos::ns::FileMdProto& output)
+{
+  ExpandedContainer& cont = *mCurrentChildren;
+
+  while (true) {
+    while (mChunkIdx < cont.files.size()) {
+      folly::Try<eos::ns::FileMdProto>& file = cont.files[mChunkIdx++];
+
+      // Skip the files whose metadata is missing
+      if (file.hasValue()) {
+        output = std::move(file.value());
+        return true;
+      }
+    }
+
+    // Current chunk consumed, move on to the next one
+    mParallel->bufferedItems -= cont.files.size();
+    cont.files.clear();
+    mChunkIdx = 0;
+    const size_t numIds = cont.fileIds.size();
+
+    // The next chunk is always needed, one more is prefetched if within the
+    // memory bound
+    for (size_t i = mPendingChunks.size(); (i < 2) && (mNextFileId < numIds);
+         ++i) {
+      if (!mPendingChunks.empty() &&
+          (mParallel->bufferedItems >= options.maxBufferedItems)) {
+        break;
+      }
+
+      const size_t end = std::min(numIds, mNextFileId + sFileChunkSize);
+      mParallel->bufferedItems += end - mNextFileId;
+      mPendingChunks.push_back(fetchFileChunk(qcl, executor, cont.fileIds,
+                                              mNextFileId, end));
+      mNextFileId = end;
+    }
+
+    if (mPendingChunks.empty()) {
+      mParallel->bufferedItems -= cont.fileIds.size();
+      cont.fileIds.clear();
+      return false;
+    }
+
+    folly::Try<FileChunk> chunk = std::move(mPendingChunks.front()).getTry();
+    mPendingChunks.pop_front();
+
+    if (chunk.hasValue()) {
+      cont.files = std::move(chunk.value());
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Parallel mode: fetch next item
+//------------------------------------------------------------------------------
+bool NamespaceExplorer::fetchParallel(NamespaceItem& item)
+{
+  while (true) {
+    if (!mCurrent && !nextExpanded()) {
+      // Search is over.
+      return false;
+    }
+
+    if (!mCurrentEmitted) {
+      mCurrentEmitted = true;
+      item = mCurrent->item;
+      return true;
+    }
+
+    if (!mCurrent->item.expansionFilteredOut) {
+      if (!mCurrentChildren) {
+        expandCurrent();
+      }
+
+      if (nextFile(item.fileMd)) {
+        item.isFile = true;
+        item.fullPath = mCurrent->item.fullPath + item.fileMd.name();
+        item.expansionFilteredOut = false;
+        handleLinkedAttrs(item);
+        return true;
+      }
+    }
+
+    // Done with the current container
+    mCurrentChildren.reset();
+    mCurrent.reset();
+  }
+}
+
 EOSNSNAMESPACE_END
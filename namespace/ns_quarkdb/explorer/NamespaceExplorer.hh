@@ -30,6 +30,10 @@
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/interface/Identifiers.hh"
 #include "namespace/ns_quarkdb/utils/FutureVectorIterator.hh"
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <deque>
@@ -61,6 +65,9 @@ public:
 };
 
 struct ExplorationOptions {
+  //! Suggested number of in-flight expansions for the parallel mode
+  static constexpr uint32_t sDefaultParallelism = 64;
+
   unsigned int depthLimit = 0;
   std::shared_ptr<ExpansionDecider> expansionDecider;
   bool populateLinkedAttributes = false;
@@ -75,6 +82,27 @@ struct ExplorationOptions {
   // Ignore files?
   //----------------------------------------------------------------------------
   bool ignoreFiles = false;
+
+  //----------------------------------------------------------------------------
+  // Number of container expansions kept in flight. 0 selects the sequential
+  // DFS, otherwise containers are fetched ahead of time on the executor.
+  //----------------------------------------------------------------------------
+  uint32_t parallelism = 0;
+
+  //----------------------------------------------------------------------------
+  // Parallel mode only: return items in the same order as the sequential DFS.
+  // If false, containers are returned as soon as they are fetched, each one
+  // followed by its files.
+  //----------------------------------------------------------------------------
+  bool ordered = true;
+
+  //----------------------------------------------------------------------------
+  // Parallel mode only: stop prefetching while more than this number of
+  // fetched entries (containers, subcontainer and file ids, file metadata) is
+  // waiting to be consumed. Bounds the memory used by the prefetching, the
+  // file metadata of a container is fetched in chunks.
+  //----------------------------------------------------------------------------
+  uint64_t maxBufferedItems = 1000000;
 };
 
 struct NamespaceItem {
@@ -101,6 +129,34 @@ struct NamespaceItem {
 
 class NamespaceExplorer;
 
+//------------------------------------------------------------------------------
+//! Container metadata fetched by the parallel exploration before deciding
+//! whether to expand the container.
+//------------------------------------------------------------------------------
+struct ContainerHeader {
+  eos::ns::ContainerMdProto containerMd;
+  // Number of files, 0 if files are ignored
+  uint64_t numFiles = 0;
+  uint64_t numContainers = 0;
+};
+
+//------------------------------------------------------------------------------
+//! Chunk of file metadata, missing files hold an exception
+//------------------------------------------------------------------------------
+using FileChunk = std::vector<folly::Try<eos::ns::FileMdProto>>;
+
+//------------------------------------------------------------------------------
+//! Children of a container expanded by the parallel exploration.
+//------------------------------------------------------------------------------
+struct ExpandedContainer {
+  // Subcontainers sorted by name
+  std::vector<std::pair<std::string, IContainerMD::id_t>> children;
+  // File ids sorted by file name
+  std::vector<IFileMD::id_t> fileIds;
+  // Metadata of the first chunk of files
+  FileChunk files;
+};
+
 //------------------------------------------------------------------------------
 //! Represents a node in the search tree.
 //------------------------------------------------------------------------------
@@ -179,7 +235,8 @@ private:
 //! Useful for "Find" commands - no consistency guarantees, if a write is in
 //! the flusher, it might not be seen here.
 //!
-//! Implemented by simple DFS on the namespace.
+//! Implemented by simple DFS on the namespace. If options.parallelism is set,
+//! the containers ahead of the current position are fetched concurrently.
 //------------------------------------------------------------------------------
 class NamespaceExplorer
 {
@@ -199,9 +256,124 @@ public:
 
 private:
   friend class SearchNode;
+
+  //! Parallel mode: number of files whose metadata is fetched at once
+  static constexpr size_t sFileChunkSize = 1000;
+
+  //----------------------------------------------------------------------------
+  //! Container waiting to be explored in parallel mode
+  //----------------------------------------------------------------------------
+  struct PendingContainer {
+    uint64_t seq;
+    ContainerIdentifier expectedParent;
+    ContainerIdentifier id;
+    std::shared_ptr<const std::string> parentPath;
+    bool started;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Container whose metadata was fetched in parallel mode, with the expansion
+  //! already decided
+  //----------------------------------------------------------------------------
+  struct FetchedContainer {
+    uint64_t seq = 0;
+    bool failed = false;
+    bool childrenStarted = false;
+    NamespaceItem item;
+  };
+
+  //----------------------------------------------------------------------------
+  //! State shared with the callbacks of the in-flight fetches
+  //----------------------------------------------------------------------------
+  struct ParallelState {
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::map<uint64_t, folly::Try<ContainerHeader>> headers;
+    std::map<uint64_t, folly::Try<ExpandedContainer>> children;
+    std::atomic<uint64_t> running {0};
+    std::atomic<uint64_t> bufferedItems {0};
+  };
+
   std::string buildStaticPath();
   std::string buildDfsPath();
-  
+
+  //----------------------------------------------------------------------------
+  // Register the container where the exploration starts
+  //----------------------------------------------------------------------------
+  void addStartNode(ContainerIdentifier expectedParent, ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  // Apply expansion decider and depth limit to the given container item
+  //----------------------------------------------------------------------------
+  void decideExpansion(NamespaceItem& item);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: fetch next item
+  //----------------------------------------------------------------------------
+  bool fetchParallel(NamespaceItem& item);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: check if more fetches can be started
+  //----------------------------------------------------------------------------
+  bool canStartFetch() const;
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: decide the expansion of the fetched containers and start
+  // fetches while within the limits
+  //----------------------------------------------------------------------------
+  void startPending();
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: take the expansion decision of the containers whose
+  // metadata arrived
+  //----------------------------------------------------------------------------
+  void decideFetched();
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: start fetching the metadata of the given container
+  //----------------------------------------------------------------------------
+  void startHeader(PendingContainer& node);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: start fetching the children of the given container
+  //----------------------------------------------------------------------------
+  void startChildren(FetchedContainer& cont);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: fetch container metadata and number of entries
+  //----------------------------------------------------------------------------
+  folly::Future<ContainerHeader> fetchHeader(ContainerIdentifier id);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: fetch subcontainers, file ids and the first chunk of files
+  //----------------------------------------------------------------------------
+  folly::Future<ExpandedContainer> fetchChildren(const NamespaceItem& item);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: fetch the metadata of the given files
+  //----------------------------------------------------------------------------
+  static folly::Future<FileChunk> fetchFileChunk(qclient::QClient& qcl,
+      folly::Executor* executor, const std::vector<IFileMD::id_t>& ids,
+      size_t begin, size_t end);
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: wait for the next container and make it current.
+  // Return false if the search is over.
+  //----------------------------------------------------------------------------
+  bool nextExpanded();
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: wait for the children of the current container and push
+  // the subcontainers on the stack
+  //----------------------------------------------------------------------------
+  void expandCurrent();
+
+  //----------------------------------------------------------------------------
+  // Parallel mode: get the next file of the current container, return false
+  // if there are no more files
+  //----------------------------------------------------------------------------
+  bool nextFile(eos::ns::FileMdProto& output);
+
   //----------------------------------------------------------------------------
   // Handle linked attributes
   //----------------------------------------------------------------------------
@@ -222,6 +394,30 @@ private:
 
   std::vector<std::unique_ptr<SearchNode>> dfsPath;
   std::map<std::string, eos::IContainerMD::XAttrMap> cachedAttrs;
+
+  //----------------------------------------------------------------------------
+  // Parallel mode
+  //----------------------------------------------------------------------------
+  std::shared_ptr<ParallelState> mParallel;
+  //! DFS stack of containers to explore, the back is the next one
+  std::vector<PendingContainer> mPendingStack;
+  //! Containers whose metadata fetch is in flight
+  std::map<uint64_t, PendingContainer> mStarted;
+  //! Containers whose metadata arrived, not yet consumed
+  std::map<uint64_t, FetchedContainer> mFetched;
+  uint64_t mNextSeq = 0;
+  //! Started metadata fetches not yet consumed, including the completed ones
+  uint64_t mInFlight = 0;
+  //! Container whose items are currently returned
+  std::unique_ptr<FetchedContainer> mCurrent;
+  std::unique_ptr<ExpandedContainer> mCurrentChildren;
+  bool mCurrentEmitted = false;
+  //! Index of the next file in the current chunk
+  size_t mChunkIdx = 0;
+  //! Index of the first file id whose metadata is not requested yet
+  size_t mNextFileId = 0;
+  //! Requested chunks of file metadata of the current container
+  std::deque<folly::Future<FileChunk>> mPendingChunks;
 };
 
 EOSNSNAMESPACE_END
@@ -17,6 +17,7 @@
  ************************************************************************/
 
 #include <inttypes.h>
+#include <cstring>
 #include <iostream>
 #include <list>
 #include <sstream>
@@ -26,6 +27,7 @@
 #include "namespace/ns_quarkdb/flusher/MetadataFlusher.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "common/Logging.hh"
+#include "common/ParseUtils.hh"
 #include <iostream>
 #include <chrono>
 #include "qclient/AssistedThread.hh"
@@ -35,6 +37,9 @@
 
 EOSNSNAMESPACE_BEGIN
 
+constexpr uint64_t MetadataFlusher::sDefaultCoalesceWindowMs;
+constexpr size_t MetadataFlusher::sMaxCoalescePending;
+
 //------------------------------------------------------------------------------
 // Constructor
 //------------------------------------------------------------------------------
@@ -44,8 +49,27 @@ MetadataFlusher::MetadataFlusher(const std::string& path,
   notifier(*this),
   backgroundFlusher(contactDetails.members, contactDetails.constructOptions(),
                     notifier, new qclient::RocksDBPersistency(path)),
+  mCoalesceWindowMs(sDefaultCoalesceWindowMs),
   sizePrinter(&MetadataFlusher::queueSizeMonitoring, this)
 {
+  const char* window = getenv("EOS_NS_QDB_FLUSHER_COALESCE_MS");
+
+  if (window) {
+    if (strcmp(window, "0") == 0) {
+      mCoalesceWindowMs = 0;
+    } else if (!eos::common::ParseUInt64(window, mCoalesceWindowMs)) {
+      eos_static_err("msg=\"failed to parse EOS_NS_QDB_FLUSHER_COALESCE_MS\" "
+                     "value=\"%s\"", window);
+      mCoalesceWindowMs = sDefaultCoalesceWindowMs;
+    }
+  }
+
+  if (mCoalesceWindowMs) {
+    mCoalesceThread.reset(&MetadataFlusher::coalesceFlushing, this);
+  }
+
+  eos_static_info("id=%s coalesce-window-ms=%llu", id.c_str(),
+                  (unsigned long long) mCoalesceWindowMs);
   synchronize();
 }
 
@@ -55,6 +79,7 @@ MetadataFlusher::MetadataFlusher(const std::string& path,
 MetadataFlusher::~MetadataFlusher()
 {
   sizePrinter.join();
+  mCoalesceThread.join();
   synchronize();
 }
 
@@ -63,6 +88,8 @@ MetadataFlusher::~MetadataFlusher()
 //------------------------------------------------------------------------------
 void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
 {
+  uint64_t last_received = 0;
+
   while (!assistant.terminationRequested()) {
     if (backgroundFlusher.size()) {
       eos_static_info("id=%s total-pending=%" PRId64 " enqueued=%" PRId64
@@ -72,17 +99,118 @@ void MetadataFlusher::queueSizeMonitoring(qclient::ThreadAssistant& assistant)
                       backgroundFlusher.getAcknowledgedAndClear());
     }
 
+    if (mCoalesceWindowMs) {
+      const uint64_t received = mNumReceived.load();
+      const uint64_t pushed = mNumPushed.load();
+
+      if (received != last_received) {
+        last_received = received;
+        eos_static_info("id=%s coalesce-received=%llu coalesce-merged=%llu "
+                        "coalesce-pushed=%llu coalesce-ratio=%.3f "
+                        "coalesce-bytes-saved=%llu", id.c_str(),
+                        (unsigned long long) received,
+                        (unsigned long long) mNumMerged.load(),
+                        (unsigned long long) pushed,
+                        (pushed ? (double) received / pushed : 1.0),
+                        (unsigned long long) mBytesSaved.load());
+      }
+    }
+
     assistant.wait_for(std::chrono::seconds(10));
   }
 }
 
+//------------------------------------------------------------------------------
+// Periodically flush the coalescing stage
+//------------------------------------------------------------------------------
+void MetadataFlusher::coalesceFlushing(qclient::ThreadAssistant& assistant)
+{
+  while (!assistant.terminationRequested()) {
+    assistant.wait_for(std::chrono::milliseconds(mCoalesceWindowMs));
+    flushCoalesced();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Stage command in the coalescing stage or directly in the backlog
+//------------------------------------------------------------------------------
+void MetadataFlusher::enqueue(std::vector<std::string>&& req)
+{
+  if (mCoalesceWindowMs == 0) {
+    ++mNumPushed;
+    backgroundFlusher.pushRequest(req);
+    return;
+  }
+
+  ++mNumReceived;
+  bool flush;
+  {
+    std::unique_lock<std::mutex> lock(mCoalesceMutex);
+    mCoalescer.push(std::move(req));
+    flush = (mCoalescer.size() >= sMaxCoalescePending);
+  }
+
+  if (flush) {
+    flushCoalesced();
+  }
+}
+
+//------------------------------------------------------------------------------
+// Push all the commands held by the coalescing stage to the backlog. The
+// coalescer is only swapped out under the lock, the batches are pushed in the
+// order they were swapped out without blocking the writers. Returns only once
+// all the batches swapped out so far have been pushed.
+//------------------------------------------------------------------------------
+void MetadataFlusher::flushCoalesced()
+{
+  RequestCoalescer batch;
+  uint64_t ticket;
+  bool swapped = false;
+  {
+    std::unique_lock<std::mutex> lock(mCoalesceMutex);
+    ticket = mNextBatch;
+
+    if (!mCoalescer.empty()) {
+      std::swap(batch, mCoalescer);
+      ++mNextBatch;
+      swapped = true;
+    }
+  }
+  std::vector<RequestCoalescer::Request> reqs;
+
+  if (swapped) {
+    reqs = batch.drain();
+    mNumMerged += batch.getNumMerged();
+    mBytesSaved += batch.getBytesSaved();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mPushMutex);
+    mPushCv.wait(lock, [&]() {
+      return mPushBatch >= ticket;
+    });
+
+    if (!swapped) {
+      return;
+    }
+
+    for (const auto& req : reqs) {
+      backgroundFlusher.pushRequest(req);
+    }
+
+    mNumPushed += reqs.size();
+    ++mPushBatch;
+  }
+  mPushCv.notify_all();
+}
+
 //------------------------------------------------------------------------------
 // Queue an hset command
 //------------------------------------------------------------------------------
 void MetadataFlusher::hset(const std::string& key, const std::string& field,
                            const std::string& value)
 {
-  backgroundFlusher.pushRequest({"HSET", key, field, value});
+  enqueue({"HSET", key, field, value});
 }
 
 //------------------------------------------------------------------------------
@@ -91,7 +219,7 @@ void MetadataFlusher::hset(const std::string& key, const std::string& field,
 void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
                               int64_t value)
 {
-  backgroundFlusher.pushRequest({"HINCRBY", key, field, std::to_string(value)});
+  enqueue({"HINCRBY", key, field, std::to_string(value)});
 }
 
 //------------------------------------------------------------------------------
@@ -99,7 +227,7 @@ void MetadataFlusher::hincrby(const std::string& key, const std::string& field,
 //------------------------------------------------------------------------------
 void MetadataFlusher::del(const std::string& key)
 {
-  backgroundFlusher.pushRequest({"DEL", key});
+  enqueue({"DEL", key});
 }
 
 //------------------------------------------------------------------------------
@@ -107,7 +235,7 @@ void MetadataFlusher::del(const std::string& key)
 //------------------------------------------------------------------------------
 void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"HDEL", key, field});
+  enqueue({"HDEL", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -115,7 +243,7 @@ void MetadataFlusher::hdel(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SADD", key, field});
+  enqueue({"SADD", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -123,7 +251,7 @@ void MetadataFlusher::sadd(const std::string& key, const std::string& field)
 //------------------------------------------------------------------------------
 void MetadataFlusher::srem(const std::string& key, const std::string& field)
 {
-  backgroundFlusher.pushRequest({"SREM", key, field});
+  enqueue({"SREM", key, field});
 }
 
 //------------------------------------------------------------------------------
@@ -138,7 +266,7 @@ void MetadataFlusher::srem(const std::string& key,
     req.emplace_back(*it);
   }
 
-  backgroundFlusher.pushRequest(req);
+  enqueue(std::move(req));
 }
 
 //------------------------------------------------------------------------------
@@ -147,6 +275,7 @@ void MetadataFlusher::srem(const std::string& key,
 void MetadataFlusher::synchronize(ItemIndex targetIndex)
 {
   if (targetIndex < 0) {
+    flushCoalesced();
     targetIndex = backgroundFlusher.getEndingIndex() - 1;
   }
 
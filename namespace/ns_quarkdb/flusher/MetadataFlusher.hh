@@ -25,10 +25,14 @@
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IContainerMD.hh"
 #include "namespace/ns_quarkdb/Constants.hh"
+#include "namespace/ns_quarkdb/flusher/RequestCoalescer.hh"
 #include "qclient/BackgroundFlusher.hh"
 #include "qclient/AssistedThread.hh"
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <map>
+#include <mutex>
 
 EOSNSNAMESPACE_BEGIN
 
@@ -72,7 +76,7 @@ public:
   template<typename... Args>
   void exec(const Args... args)
   {
-    backgroundFlusher.pushRequest(std::vector<std::string> {args...});
+    enqueue(std::vector<std::string> {args...});
   }
 
   void del(const std::string& key);
@@ -87,7 +91,7 @@ public:
 
   void execute(const std::vector<std::string>& req)
   {
-    backgroundFlusher.pushRequest(req);
+    enqueue(std::vector<std::string>(req));
   }
 
   //----------------------------------------------------------------------------
@@ -99,12 +103,54 @@ public:
   //----------------------------------------------------------------------------
   void synchronize(ItemIndex targetIndex = -1);
 
+  //----------------------------------------------------------------------------
+  //! Push all the commands held by the coalescing stage to the backlog
+  //----------------------------------------------------------------------------
+  void flushCoalesced();
+
 private:
+  //! Default coalescing window, can be changed with the
+  //! EOS_NS_QDB_FLUSHER_COALESCE_MS env variable, 0 disables coalescing.
+  //! Commands are acknowledged to the caller once staged, therefore enabling
+  //! it means a crash can lose up to one window worth of updates.
+  static constexpr uint64_t sDefaultCoalesceWindowMs = 0;
+  //! Flush the coalescing stage early once it holds that many commands
+  static constexpr size_t sMaxCoalescePending = 10000;
+
+  //----------------------------------------------------------------------------
+  //! Stage command, either directly in the backlog or in the coalescing stage
+  //----------------------------------------------------------------------------
+  void enqueue(std::vector<std::string>&& req);
+
+  //----------------------------------------------------------------------------
+  //! Periodically flush the coalescing stage
+  //----------------------------------------------------------------------------
+  void coalesceFlushing(qclient::ThreadAssistant& assistant);
+
   void queueSizeMonitoring(qclient::ThreadAssistant& assistant);
   std::string id;
 
   FlusherNotifier notifier;
   qclient::BackgroundFlusher backgroundFlusher;
+  //! Coalescing window in milliseconds, 0 if disabled
+  uint64_t mCoalesceWindowMs;
+  //! Protects the coalescer, only held to stage a command or swap it out
+  std::mutex mCoalesceMutex;
+  RequestCoalescer mCoalescer;
+  //! Ticket of the next batch swapped out of the coalescer
+  uint64_t mNextBatch {0};
+  //! Orders the pushes of the swapped out batches to the backlog
+  std::mutex mPushMutex;
+  std::condition_variable mPushCv;
+  //! Ticket of the next batch to be pushed to the backlog
+  uint64_t mPushBatch {0};
+  //! Coalescing statistics
+  std::atomic<uint64_t> mNumReceived {0};
+  std::atomic<uint64_t> mNumMerged {0};
+  std::atomic<uint64_t> mBytesSaved {0};
+  //! Number of commands pushed to the backlog after coalescing
+  std::atomic<uint64_t> mNumPushed {0};
+  qclient::AssistedThread mCoalesceThread;
   qclient::AssistedThread sizePrinter;
 };
 
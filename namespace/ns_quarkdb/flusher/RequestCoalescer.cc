@@ -0,0 +1,305 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/flusher/RequestCoalescer.hh"
+#include "common/ParseUtils.hh"
+#include <algorithm>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Parse increment argument, empty strings are rejected
+//------------------------------------------------------------------------------
+inline bool parseIncrement(const std::string& str, int64_t& value)
+{
+  return !str.empty() && eos::common::ParseInt64(str, value);
+}
+
+//------------------------------------------------------------------------------
+// Add the given increments, fails on overflow
+//------------------------------------------------------------------------------
+inline bool addIncrement(std::string& prev, const std::string& incr)
+{
+  int64_t a, b, sum;
+
+  if (!parseIncrement(prev, a) || !parseIncrement(incr, b) ||
+      __builtin_add_overflow(a, b, &sum)) {
+    return false;
+  }
+
+  prev = std::to_string(sum);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Append signature component
+//------------------------------------------------------------------------------
+inline void appendSig(std::string& sig, const std::string& part)
+{
+  sig += part;
+  sig += '\0';
+}
+}
+
+//------------------------------------------------------------------------------
+// Get approximate serialized size of a command
+//------------------------------------------------------------------------------
+uint64_t
+RequestCoalescer::getRequestSize(const Request& req)
+{
+  uint64_t size = 0;
+
+  for (const auto& arg : req) {
+    size += arg.size();
+  }
+
+  return size;
+}
+
+//------------------------------------------------------------------------------
+// Add command to the buffer
+//------------------------------------------------------------------------------
+void
+RequestCoalescer::push(Request&& req)
+{
+  if (req.empty()) {
+    return;
+  }
+
+  ++mNumReceived;
+  const std::string& cmd = req[0];
+  // Signature identifying the commands this one can be merged with, empty
+  // if the command can not be merged
+  std::string sig;
+  // Positions of the key/field pairs touched by the command
+  std::vector<std::pair<size_t, size_t>> fields;
+  int64_t incr;
+
+  if (((cmd == "HSET") && (req.size() == 4)) ||
+      ((cmd == "LHSET") && (req.size() == 5)) ||
+      ((cmd == "HINCRBY") && (req.size() == 4) && parseIncrement(req[3], incr))) {
+    appendSig(sig, cmd);
+    appendSig(sig, req[1]);
+    appendSig(sig, req[2]);
+    fields.emplace_back(1, 2);
+  } else if ((cmd == "HINCRBYMULTI") && (req.size() > 1) &&
+             ((req.size() - 1) % 3 == 0)) {
+    appendSig(sig, cmd);
+
+    for (size_t i = 1; i < req.size(); i += 3) {
+      if (!parseIncrement(req[i + 2], incr)) {
+        sig.clear();
+        break;
+      }
+
+      appendSig(sig, req[i]);
+      appendSig(sig, req[i + 1]);
+      fields.emplace_back(i, i + 1);
+    }
+
+    if (sig.empty()) {
+      touchAll();
+      mPending.push_back(std::move(req));
+      return;
+    }
+  } else if (((cmd == "HDEL") || (cmd == "LHDEL") || (cmd == "SADD") ||
+              (cmd == "SREM")) && (req.size() >= 3)) {
+    for (size_t i = 2; i < req.size(); ++i) {
+      fields.emplace_back(1, i);
+    }
+  } else if ((cmd == "DEL") && (req.size() >= 2)) {
+    for (size_t i = 1; i < req.size(); ++i) {
+      touchKey(req[i]);
+    }
+
+    mPending.push_back(std::move(req));
+    return;
+  } else {
+    touchAll();
+    mPending.push_back(std::move(req));
+    return;
+  }
+
+  for (const auto& elem : fields) {
+    touchField(req[elem.first], req[elem.second], sig);
+  }
+
+  if (sig.empty()) {
+    mPending.push_back(std::move(req));
+    return;
+  }
+
+  auto it = mMergeIndex.find(sig);
+
+  if (it != mMergeIndex.end()) {
+    // Nothing touched the same key/field pairs since the previous command,
+    // so the previous one can be delayed up to this point and combined
+    Request prev = std::move(mPending[it->second]);
+    const uint64_t sz_before = getRequestSize(prev) + getRequestSize(req);
+
+    if (merge(prev, req)) {
+      mPending[it->second].clear();
+      mBytesSaved += sz_before - getRequestSize(prev);
+      ++mNumMerged;
+      mPending.push_back(std::move(prev));
+    } else {
+      mPending[it->second] = std::move(prev);
+      mPending.push_back(std::move(req));
+    }
+
+    it->second = mPending.size() - 1;
+    return;
+  }
+
+  mMergeIndex.emplace(sig, mPending.size());
+
+  for (const auto& elem : fields) {
+    auto& sigs = mFieldIndex[req[elem.first]][req[elem.second]];
+
+    if (std::find(sigs.begin(), sigs.end(), sig) == sigs.end()) {
+      sigs.push_back(sig);
+    }
+  }
+
+  mPending.push_back(std::move(req));
+}
+
+//------------------------------------------------------------------------------
+// Extract all buffered commands in the order they need to be applied
+//------------------------------------------------------------------------------
+std::vector<RequestCoalescer::Request>
+RequestCoalescer::drain()
+{
+  std::vector<Request> out;
+  out.reserve(mPending.size());
+
+  for (auto& req : mPending) {
+    if (!req.empty()) {
+      out.push_back(std::move(req));
+    }
+  }
+
+  mPending.clear();
+  touchAll();
+  return out;
+}
+
+//------------------------------------------------------------------------------
+// Invalidate the merge candidates touching the given key/field pair
+//------------------------------------------------------------------------------
+void
+RequestCoalescer::touchField(const std::string& key, const std::string& field,
+                             const std::string& keep_sig)
+{
+  auto it_key = mFieldIndex.find(key);
+
+  if (it_key == mFieldIndex.end()) {
+    return;
+  }
+
+  auto it_field = it_key->second.find(field);
+
+  if (it_field == it_key->second.end()) {
+    return;
+  }
+
+  bool keep = false;
+
+  for (const auto& sig : it_field->second) {
+    if (!keep_sig.empty() && (sig == keep_sig)) {
+      keep = true;
+    } else {
+      mMergeIndex.erase(sig);
+    }
+  }
+
+  if (keep) {
+    it_field->second.assign(1, keep_sig);
+  } else {
+    it_key->second.erase(it_field);
+
+    if (it_key->second.empty()) {
+      mFieldIndex.erase(it_key);
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Invalidate all merge candidates touching the given key
+//------------------------------------------------------------------------------
+void
+RequestCoalescer::touchKey(const std::string& key)
+{
+  auto it_key = mFieldIndex.find(key);
+
+  if (it_key == mFieldIndex.end()) {
+    return;
+  }
+
+  for (const auto& elem : it_key->second) {
+    for (const auto& sig : elem.second) {
+      mMergeIndex.erase(sig);
+    }
+  }
+
+  mFieldIndex.erase(it_key);
+}
+
+//------------------------------------------------------------------------------
+// Invalidate all merge candidates
+//------------------------------------------------------------------------------
+void
+RequestCoalescer::touchAll()
+{
+  mMergeIndex.clear();
+  mFieldIndex.clear();
+}
+
+//------------------------------------------------------------------------------
+// Merge the given command into the previous one with the same signature
+//------------------------------------------------------------------------------
+bool
+RequestCoalescer::merge(Request& prev, const Request& req)
+{
+  const std::string& cmd = req[0];
+
+  if ((cmd == "HSET") || (cmd == "LHSET")) {
+    prev = req;
+    return true;
+  }
+
+  if (cmd == "HINCRBY") {
+    return addIncrement(prev[3], req[3]);
+  }
+
+  // HINCRBYMULTI, all or nothing
+  Request merged = prev;
+
+  for (size_t i = 3; i < req.size(); i += 3) {
+    if (!addIncrement(merged[i], req[i])) {
+      return false;
+    }
+  }
+
+  prev = std::move(merged);
+  return true;
+}
+
+EOSNSNAMESPACE_END
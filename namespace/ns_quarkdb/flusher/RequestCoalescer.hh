@@ -0,0 +1,139 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Merge redundant redis commands before they reach the flusher backlog
+//------------------------------------------------------------------------------
+
+#pragma once
+#include "namespace/Namespace.hh"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Buffer of redis commands which merges the ones made redundant by a later
+//! command of the same kind:
+//!   - HSET / LHSET of the same key and field keep only the last value
+//!   - HINCRBY of the same key and field are summed up
+//!   - HINCRBYMULTI touching the same key/field list are summed up elementwise
+//!
+//! A merge drops the earlier command and appends the combined one at the end
+//! of the buffer. It only happens if no other command touched any of the
+//! involved key/field pairs in between, therefore the final state of every
+//! key is the same as when applying the original sequence. Commands touching
+//! a key/field pair in a different way (HDEL, SADD, DEL etc.) act as barriers
+//! for that pair and unknown commands act as barriers for everything.
+//!
+//! The class is not thread-safe.
+//------------------------------------------------------------------------------
+class RequestCoalescer
+{
+public:
+  using Request = std::vector<std::string>;
+
+  //----------------------------------------------------------------------------
+  //! Add command to the buffer
+  //----------------------------------------------------------------------------
+  void push(Request&& req);
+
+  //----------------------------------------------------------------------------
+  //! Extract all buffered commands in the order they need to be applied
+  //----------------------------------------------------------------------------
+  std::vector<Request> drain();
+
+  //----------------------------------------------------------------------------
+  //! Number of slots used in the buffer, including the merged away ones
+  //----------------------------------------------------------------------------
+  inline size_t size() const
+  {
+    return mPending.size();
+  }
+
+  inline bool empty() const
+  {
+    return mPending.empty();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Statistics since construction
+  //----------------------------------------------------------------------------
+  inline uint64_t getNumReceived() const
+  {
+    return mNumReceived;
+  }
+
+  inline uint64_t getNumMerged() const
+  {
+    return mNumMerged;
+  }
+
+  inline uint64_t getBytesSaved() const
+  {
+    return mBytesSaved;
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get approximate serialized size of a command
+  //----------------------------------------------------------------------------
+  static uint64_t getRequestSize(const Request& req);
+
+private:
+  //----------------------------------------------------------------------------
+  //! Invalidate all merge candidates touching the given key/field pair apart
+  //! from the one with the given signature
+  //----------------------------------------------------------------------------
+  void touchField(const std::string& key, const std::string& field,
+                  const std::string& keep_sig);
+
+  //----------------------------------------------------------------------------
+  //! Invalidate all merge candidates touching the given key
+  //----------------------------------------------------------------------------
+  void touchKey(const std::string& key);
+
+  //----------------------------------------------------------------------------
+  //! Invalidate all merge candidates
+  //----------------------------------------------------------------------------
+  void touchAll();
+
+  //----------------------------------------------------------------------------
+  //! Merge the given command into the previous one, if possible
+  //!
+  //! @param prev previous command with the same signature, updated in place
+  //! @param req new command
+  //!
+  //! @return true if merged, otherwise false
+  //----------------------------------------------------------------------------
+  static bool merge(Request& prev, const Request& req);
+
+  //! Buffered commands, merged away ones are left empty
+  std::vector<Request> mPending;
+  //! Merge signature -> position in the pending buffer
+  std::unordered_map<std::string, size_t> mMergeIndex;
+  //! Key -> field -> signatures of the merge candidates touching it
+  std::unordered_map<std::string,
+      std::unordered_map<std::string, std::vector<std::string>>> mFieldIndex;
+  uint64_t mNumReceived {0};
+  uint64_t mNumMerged {0};
+  uint64_t mBytesSaved {0};
+};
+
+EOSNSNAMESPACE_END
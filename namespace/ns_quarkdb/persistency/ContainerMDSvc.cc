@@ -382,4 +382,13 @@ QuarkContainerMDSvc::blacklistBelow(ContainerIdentifier id)
   mUnifiedInodeProvider->blacklistContainerId(id.getUnderlyingUInt64());
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently used containers in the metadata cache
+//------------------------------------------------------------------------------
+std::vector<ContainerIdentifier>
+QuarkContainerMDSvc::getRecentlyUsedIds(uint64_t max_num)
+{
+  return mMetadataProvider->getRecentContainerIds(max_num);
+}
+
 EOSNSNAMESPACE_END
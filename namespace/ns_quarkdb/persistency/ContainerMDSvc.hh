@@ -201,6 +201,12 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(ContainerIdentifier id) override;
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the metadata cache
+  //----------------------------------------------------------------------------
+  virtual std::vector<ContainerIdentifier>
+  getRecentlyUsedIds(uint64_t max_num) override;
+
 private:
   typedef std::list<IContainerMDChangeListener*> ListenerList;
 
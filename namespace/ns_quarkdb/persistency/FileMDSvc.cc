@@ -324,6 +324,15 @@ void QuarkFileMDSvc::blacklistBelow(FileIdentifier id)
   mUnifiedInodeProvider.blacklistFileId(id.getUnderlyingUInt64());
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently used files in the metadata cache
+//------------------------------------------------------------------------------
+std::vector<FileIdentifier>
+QuarkFileMDSvc::getRecentlyUsedIds(uint64_t max_num)
+{
+  return mMetadataProvider->getRecentFileIds(max_num);
+}
+
 //------------------------------------------------------------------------------
 // Get pointer to metadata provider
 //------------------------------------------------------------------------------
@@ -171,6 +171,12 @@ public:
   //----------------------------------------------------------------------------
   virtual void blacklistBelow(FileIdentifier id) override;
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used files in the metadata cache
+  //----------------------------------------------------------------------------
+  virtual std::vector<FileIdentifier>
+  getRecentlyUsedIds(uint64_t max_num) override;
+
   //----------------------------------------------------------------------------
   //! Get pointer to metadata provider
   //----------------------------------------------------------------------------
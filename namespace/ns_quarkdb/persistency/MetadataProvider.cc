@@ -146,6 +146,8 @@ void aggregateStatistics(CacheStatistics &global, const CacheStatistics local) {
   global.occupancy += local.occupancy;
   global.maxNum += local.maxNum;
   global.inFlight += local.inFlight;
+  global.hits += local.hits;
+  global.misses += local.misses;
 }
 
 //------------------------------------------------------------------------------
@@ -178,6 +180,63 @@ CacheStatistics MetadataProvider::getContainerMDCacheStats()
   return globalStats;
 }
 
+//------------------------------------------------------------------------------
+// Merge the per shard lists of recently used ids keeping the most recent
+// ones of every shard at the front
+//------------------------------------------------------------------------------
+template <typename IdT>
+std::vector<IdT> interleaveIds(const std::vector<std::vector<IdT>>& shard_ids,
+                               uint64_t max_num)
+{
+  std::vector<IdT> ids;
+  bool more = true;
+
+  for (size_t pos = 0; more && (ids.size() < max_num); ++pos) {
+    more = false;
+
+    for (const auto& elem : shard_ids) {
+      if ((pos < elem.size()) && (ids.size() < max_num)) {
+        ids.push_back(elem[pos]);
+        more = true;
+      }
+    }
+  }
+
+  return ids;
+}
+
+//------------------------------------------------------------------------------
+// Get ids of the most recently used files in the cache
+//------------------------------------------------------------------------------
+std::vector<FileIdentifier>
+MetadataProvider::getRecentFileIds(uint64_t max_num)
+{
+  std::vector<std::vector<FileIdentifier>> shard_ids;
+  const uint64_t max_num_per_shard = (max_num + kShards - 1) / kShards;
+
+  for (size_t i = 0; i < mShards.size(); i++) {
+    shard_ids.push_back(mShards[i]->getRecentFileIds(max_num_per_shard));
+  }
+
+  return interleaveIds(shard_ids, max_num);
+}
+
+//------------------------------------------------------------------------------
+// Get ids of the most recently used containers in the cache
+//------------------------------------------------------------------------------
+std::vector<ContainerIdentifier>
+MetadataProvider::getRecentContainerIds(uint64_t max_num)
+{
+  std::vector<std::vector<ContainerIdentifier>> shard_ids;
+  const uint64_t max_num_per_shard = (max_num + kShards - 1) / kShards;
+
+  for (size_t i = 0; i < mShards.size(); i++) {
+    shard_ids.push_back(mShards[i]->getRecentContainerIds(max_num_per_shard));
+  }
+
+  return interleaveIds(shard_ids, max_num);
+}
+
 //------------------------------------------------------------------------------
 //! Pick shard based on FileIdentifier
 //------------------------------------------------------------------------------
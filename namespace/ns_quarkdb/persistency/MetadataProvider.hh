@@ -108,6 +108,18 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used files in the cache, taken evenly
+  //! from all shards
+  //----------------------------------------------------------------------------
+  std::vector<FileIdentifier> getRecentFileIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the cache, taken evenly
+  //! from all shards
+  //----------------------------------------------------------------------------
+  std::vector<ContainerIdentifier> getRecentContainerIds(uint64_t max_num);
+
 private:
   //----------------------------------------------------------------------------
   //! Pick shard based on FileIdentifier
@@ -28,6 +28,7 @@
 #include "namespace/ns_quarkdb/ContainerMD.hh"
 #include "namespace/MDException.hh"
 #include "namespace/ns_quarkdb/BackendClient.hh"
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
 #include "common/Assert.hh"
 #include <functional>
 
@@ -59,6 +60,8 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
   IContainerMDPtr result = mContainerCache.get(id);
 
   if (result) {
+    ++mContainerHits;
+
     // Handle special case where we're dealing with a tombstone.
     if (result->isDeleted()) {
       return folly::makeFuture<IContainerMDPtr>
@@ -75,6 +78,7 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
   auto it = mInFlightContainers.find(id);
 
   if (it != mInFlightContainers.end()) {
+    ++mContainerMisses;
     // Cache hit: A container with such ID has been staged already. Once a
     // response arrives, all futures tied to that container will be activated
     // automatically, with the same IContainerMDPtr.
@@ -86,6 +90,7 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 
   if (result) {
     lock.unlock();
+    ++mContainerHits;
 
     // Handle special case where we're dealing with a tombstone.
     if (result->isDeleted()) {
@@ -99,6 +104,7 @@ MetadataProviderShard::retrieveContainerMD(ContainerIdentifier id)
 
   // Nope, need to fetch, and insert into the in-flight staging area. Merge
   // three asynchronous operations into one.
+  ++mContainerMisses;
   folly::Future<eos::ns::ContainerMdProto> protoFut =
     MetadataFetcher::getContainerFromId(*mQcl, id);
   folly::Future<IContainerMD::FileMap> fileMapFut =
@@ -135,6 +141,8 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
   IFileMDPtr result = mFileCache.get(id);
 
   if (result) {
+    ++mFileHits;
+
     // Handle special case where we're dealing with a tombstone.
     if (result->isDeleted()) {
       return folly::makeFuture<IFileMDPtr>
@@ -161,6 +169,7 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
   auto it = mInFlightFiles.find(id);
 
   if (it != mInFlightFiles.end()) {
+    ++mFileMisses;
     // Cache hit: A container with such ID has been staged already. Once a
     // response arrives, all futures tied to that container will be activated
     // automatically, with the same IContainerMDPtr.
@@ -172,6 +181,7 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
 
   if (result) {
     lock.unlock();
+    ++mFileHits;
 
     // Handle special case where we're dealing with a tombstone.
     if (result->isDeleted()) {
@@ -184,6 +194,7 @@ MetadataProviderShard::retrieveFileMD(FileIdentifier id)
   }
 
   // Nope, need to fetch, and insert into the in-flight staging area.
+  ++mFileMisses;
   folly::Future<IFileMDPtr> fut = MetadataFetcher::getFileFromId(*mQcl, id)
                                   .via(mExecutor)
                                   .thenValue(std::bind(&MetadataProviderShard::processIncomingFileMdProto, this, id, _1))
@@ -213,6 +224,8 @@ MetadataProviderShard::dropCachedFileID(FileIdentifier id)
 bool
 MetadataProviderShard::dropCachedContainerID(ContainerIdentifier id)
 {
+  // The container might have been renamed or moved by another MGM
+  ContainerPathCache::notifyRemoval(id.getUnderlyingUInt64());
   std::unique_lock<std::mutex> lock(mMutex);
   return mContainerCache.remove(id);
 }
@@ -331,6 +344,8 @@ CacheStatistics MetadataProviderShard::getFileMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mFileCache.size();
   stats.maxNum = mFileCache.get_max_num();
+  stats.hits = mFileHits;
+  stats.misses = mFileMisses;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightFiles.size();
@@ -346,10 +361,30 @@ CacheStatistics MetadataProviderShard::getContainerMDCacheStats()
   stats.enabled = true;
   stats.occupancy = mContainerCache.size();
   stats.maxNum = mContainerCache.get_max_num();
+  stats.hits = mContainerHits;
+  stats.misses = mContainerMisses;
 
   std::lock_guard<std::mutex> lock(mMutex);
   stats.inFlight = mInFlightContainers.size();
   return stats;
 }
 
+//------------------------------------------------------------------------------
+// Get ids of the most recently used files in the cache
+//------------------------------------------------------------------------------
+std::vector<FileIdentifier>
+MetadataProviderShard::getRecentFileIds(uint64_t max_num)
+{
+  return mFileCache.getRecentIds(max_num);
+}
+
+//------------------------------------------------------------------------------
+// Get ids of the most recently used containers in the cache
+//------------------------------------------------------------------------------
+std::vector<ContainerIdentifier>
+MetadataProviderShard::getRecentContainerIds(uint64_t max_num)
+{
+  return mContainerCache.getRecentIds(max_num);
+}
+
 EOSNSNAMESPACE_END
@@ -33,6 +33,7 @@
 #include <qclient/QClient.hh>
 #include <folly/futures/Future.h>
 #include <folly/futures/FutureSplitter.h>
+#include <atomic>
 
 namespace folly
 {
@@ -112,6 +113,16 @@ public:
   //----------------------------------------------------------------------------
   CacheStatistics getContainerMDCacheStats();
 
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used files in the cache
+  //----------------------------------------------------------------------------
+  std::vector<FileIdentifier> getRecentFileIds(uint64_t max_num);
+
+  //----------------------------------------------------------------------------
+  //! Get ids of the most recently used containers in the cache
+  //----------------------------------------------------------------------------
+  std::vector<ContainerIdentifier> getRecentContainerIds(uint64_t max_num);
+
 private:
   //----------------------------------------------------------------------------
   //! Turn an incoming FileMDProto into FileMD, removing from the inFlight
@@ -141,6 +152,10 @@ private:
   LRU<ContainerIdentifier, IContainerMD> mContainerCache;
   LRU<FileIdentifier, IFileMD> mFileCache;
   folly::Executor *mExecutor; // no ownership
+  std::atomic<uint64_t> mFileHits {0};
+  std::atomic<uint64_t> mFileMisses {0};
+  std::atomic<uint64_t> mContainerHits {0};
+  std::atomic<uint64_t> mContainerMisses {0};
 };
 
 EOSNSNAMESPACE_END
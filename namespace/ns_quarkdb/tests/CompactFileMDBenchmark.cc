@@ -0,0 +1,209 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Compare memory usage and lookup latency of the cached file metadata
+//!        i.e. QuarkFileMD backed by CompactFileMD snapshots against the
+//!        previous layout of a FileMdProto guarded by a shared mutex
+//------------------------------------------------------------------------------
+
+#include "common/CLI11.hpp"
+#include "namespace/ns_quarkdb/FileMD.hh"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+#include <unistd.h>
+
+//! Sink for the lookup results
+std::atomic<uint64_t> gChecksum {0};
+
+//------------------------------------------------------------------------------
+//! Previous layout of the cached file metadata used as reference
+//------------------------------------------------------------------------------
+struct ProtoFileMD {
+  mutable std::shared_timed_mutex mMutex;
+  eos::ns::FileMdProto mFile;
+
+  uint64_t Lookup() const
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+    bool has_loc = false;
+
+    for (const auto& loc : mFile.locations()) {
+      if (loc == 1) {
+        has_loc = true;
+        break;
+      }
+    }
+
+    return std::string(mFile.name()).size() + mFile.size() +
+           mFile.locations_size() + has_loc;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Get resident set size of the current process in bytes
+//------------------------------------------------------------------------------
+uint64_t GetRss()
+{
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0, resident = 0;
+  statm >> size >> resident;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+//------------------------------------------------------------------------------
+//! Build a file metadata object resembling a typical production entry
+//------------------------------------------------------------------------------
+eos::ns::FileMdProto BuildProto(uint64_t id, std::mt19937_64& gen)
+{
+  eos::ns::FileMdProto proto;
+  proto.set_id(id);
+  proto.set_cont_id(1 + gen() % 100000);
+  proto.set_uid(1000 + gen() % 100);
+  proto.set_gid(1000 + gen() % 10);
+  proto.set_size(gen() % (1ull << 32));
+  proto.set_layout_id(0x00100112);
+  proto.set_flags(0644);
+  proto.set_name("file_" + std::to_string(id) + ".root");
+  uint32_t adler = gen();
+  proto.set_checksum(&adler, sizeof(adler));
+  eos::IFileMD::ctime_t ts {static_cast<time_t>(1600000000 + id), 0};
+  proto.set_ctime(&ts, sizeof(ts));
+  proto.set_mtime(&ts, sizeof(ts));
+  proto.add_locations(1 + gen() % 2000);
+  proto.add_locations(1 + gen() % 2000);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = std::to_string(ts.tv_sec) +
+      ".0";
+  (*proto.mutable_xattrs())["sys.fs.tracking"] = "+1+2";
+  return proto;
+}
+
+//------------------------------------------------------------------------------
+//! Run the given number of random lookups from multiple threads
+//!
+//! @return average lookup latency per thread in nanoseconds
+//------------------------------------------------------------------------------
+template <typename Lookup>
+double RunLookups(uint64_t num_entries, uint32_t num_threads,
+                  uint64_t num_requests, Lookup lookup)
+{
+  std::atomic<uint64_t> checksum {0};
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 gen(t);
+      uint64_t local = 0;
+
+      for (uint64_t i = 0; i < num_requests; ++i) {
+        local += lookup(gen() % num_entries);
+      }
+
+      checksum += local;
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>
+                  (std::chrono::steady_clock::now() - start).count();
+  // Make sure the lookups are not optimized away
+  gChecksum += checksum;
+  return (double) duration / num_requests;
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"File metadata representation benchmark tool"};
+  uint64_t num_entries = 1000000;
+  uint32_t num_threads = 4;
+  uint64_t num_requests = 1000000;
+  bool use_proto = false;
+  app.add_option("-n,--num_entries", num_entries, "number of cached entries");
+  app.add_option("-t,--num_threads", num_threads,
+                 "number of threads for lookup operations");
+  app.add_option("-r,--num_requests", num_requests,
+                 "number of lookups per thread");
+  app.add_flag("-p,--proto", use_proto,
+               "use the previous protobuf layout instead of QuarkFileMD");
+  CLI11_PARSE(app, argc, argv);
+
+  if (num_entries == 0) {
+    std::cerr << "error: number of entries must be positive" << std::endl;
+    return 1;
+  }
+
+  // Each run measures a single representation so that freed memory of one
+  // does not distort the numbers of the other
+  std::mt19937_64 gen(42);
+  std::vector<std::shared_ptr<eos::QuarkFileMD>> files;
+  std::vector<std::shared_ptr<ProtoFileMD>> proto_files;
+  files.reserve(use_proto ? 0 : num_entries);
+  proto_files.reserve(use_proto ? num_entries : 0);
+  uint64_t rss_start = GetRss();
+
+  for (uint64_t id = 1; id <= num_entries; ++id) {
+    eos::ns::FileMdProto proto = BuildProto(id, gen);
+
+    if (use_proto) {
+      auto file = std::make_shared<ProtoFileMD>();
+      file->mFile = std::move(proto);
+      proto_files.push_back(std::move(file));
+    } else {
+      auto file = std::make_shared<eos::QuarkFileMD>();
+      file->initialize(std::move(proto));
+      files.push_back(std::move(file));
+    }
+  }
+
+  uint64_t rss_end = GetRss();
+  double latency_ns;
+
+  if (use_proto) {
+    latency_ns = RunLookups(num_entries, num_threads, num_requests,
+    [&](uint64_t idx) {
+      return proto_files[idx]->Lookup();
+    });
+  } else {
+    latency_ns = RunLookups(num_entries, num_threads, num_requests,
+    [&](uint64_t idx) {
+      auto file = files[idx];
+      return file->getName().size() + file->getSize() +
+             file->getNumLocation() + file->hasLocation(1);
+    });
+  }
+
+  std::cout << "representation  : " << (use_proto ? "FileMdProto" :
+                                        "QuarkFileMD") << std::endl
+            << "entries         : " << num_entries << std::endl
+            << "bytes per entry : " << (rss_end - rss_start) / num_entries
+            << " (rss delta, includes shared_ptr control block)" << std::endl
+            << "lookup latency  : " << latency_ns << " ns" << std::endl;
+  return 0;
+}
@@ -0,0 +1,250 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief CompactFileMD tests
+//------------------------------------------------------------------------------
+
+#include "namespace/ns_quarkdb/CompactFileMD.hh"
+#include "namespace/MDException.hh"
+#include <gtest/gtest.h>
+#include <google/protobuf/util/message_differencer.h>
+#include <thread>
+
+//------------------------------------------------------------------------------
+// Build a fully populated protobuf object
+//------------------------------------------------------------------------------
+static eos::ns::FileMdProto
+buildProto()
+{
+  eos::ns::FileMdProto proto;
+  proto.set_id(123456789);
+  proto.set_cont_id(42);
+  proto.set_uid(1001);
+  proto.set_gid(2002);
+  proto.set_size(1ull << 40);
+  proto.set_layout_id(0x00100112);
+  proto.set_flags(0755);
+  proto.set_name("some_file.root");
+  proto.set_link_name("");
+  proto.set_checksum(std::string("\x01\x02\x00\xff", 4));
+  eos::IFileMD::ctime_t ts {1600000000, 123456789};
+  proto.set_ctime(&ts, sizeof(ts));
+  ts.tv_sec += 10;
+  proto.set_mtime(&ts, sizeof(ts));
+
+  for (uint32_t loc : std::vector<uint32_t> {1, 127, 128, 70000, 4000000000u}) {
+    proto.add_locations(loc);
+  }
+
+  proto.add_unlink_locations(5);
+  (*proto.mutable_xattrs())["sys.eos.btime"] = "1600000000.123";
+  (*proto.mutable_xattrs())["user.tag"] = std::string("a\0b", 3);
+  return proto;
+}
+
+//------------------------------------------------------------------------------
+// Round trip through the compact representation
+//------------------------------------------------------------------------------
+TEST(CompactFileMD, RoundTrip)
+{
+  eos::ns::FileMdProto proto = buildProto();
+  auto compact = eos::CompactFileMD::Create(proto);
+  size_t num_keys = eos::XattrKeyInterner::Global().Size();
+  ASSERT_EQ(compact->getId(), 123456789u);
+  ASSERT_EQ(compact->getContainerId(), 42u);
+  ASSERT_EQ(compact->getSize(), 1ull << 40);
+  ASSERT_EQ(compact->getCUid(), 1001u);
+  ASSERT_EQ(compact->getCGid(), 2002u);
+  ASSERT_EQ(compact->getName(), "some_file.root");
+  ASSERT_TRUE(compact->getLink().empty());
+  ASSERT_EQ(compact->getChecksum(), std::string("\x01\x02\x00\xff", 4));
+  ASSERT_EQ(compact->getNumLocation(), 5u);
+  ASSERT_EQ(compact->getLocations(),
+            eos::IFileMD::LocationVector({1, 127, 128, 70000, 4000000000u}));
+  ASSERT_EQ(compact->getLocation(3), 70000u);
+  ASSERT_EQ(compact->getLocation(5), 0u);
+  ASSERT_TRUE(compact->hasLocation(70000));
+  ASSERT_FALSE(compact->hasLocation(5));
+  ASSERT_TRUE(compact->hasUnlinkedLocation(5));
+  ASSERT_EQ(compact->getNumUnlinkedLocation(), 1u);
+  std::string value;
+  ASSERT_TRUE(compact->getAttribute("user.tag", value));
+  ASSERT_EQ(value, std::string("a\0b", 3));
+  ASSERT_FALSE(compact->hasAttribute("user.missing"));
+  ASSERT_EQ(compact->getAttributes().size(), 2u);
+  ASSERT_EQ(compact->numAttributes(), 2u);
+  eos::IFileMD::ctime_t ts;
+  compact->getCTime(ts);
+  ASSERT_EQ(ts.tv_sec, 1600000000);
+  ASSERT_EQ(ts.tv_nsec, 123456789);
+  // No sync time, falls back to mtime
+  compact->getSyncTime(ts);
+  ASSERT_EQ(ts.tv_sec, 1600000010);
+  eos::ns::FileMdProto expanded;
+  compact->toProto(expanded);
+  ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(proto,
+              expanded));
+  // Keys are shared between objects
+  auto other = eos::CompactFileMD::Create(proto);
+  ASSERT_EQ(eos::XattrKeyInterner::Global().Size(), num_keys);
+  ASSERT_EQ(other->getMemoryFootprint(), compact->getMemoryFootprint());
+}
+
+//------------------------------------------------------------------------------
+// Copy-on-write updates
+//------------------------------------------------------------------------------
+TEST(CompactFileMD, SlotUpdate)
+{
+  eos::CompactFileMDSlot slot(eos::CompactFileMD::Create(buildProto()));
+  auto before = slot.Load();
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&slot, i]() {
+      for (int j = 0; j < 100; ++j) {
+        slot.Update([i, j](eos::ns::FileMdProto & proto) {
+          proto.set_size(proto.size() + 1);
+          proto.add_locations(1000 + i * 100 + j);
+          return true;
+        });
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto after = slot.Load();
+  // Old snapshot is untouched, no update was lost
+  ASSERT_EQ(before->getSize(), 1ull << 40);
+  ASSERT_EQ(before->getNumLocation(), 5u);
+  ASSERT_EQ(after->getSize(), (1ull << 40) + 400);
+  ASSERT_EQ(after->getNumLocation(), 405u);
+  ASSERT_EQ(after->getName(), "some_file.root");
+  // Nothing published if the modifier has nothing to change
+  ASSERT_FALSE(slot.Update([](eos::ns::FileMdProto & proto) {
+    return false;
+  }));
+  ASSERT_EQ(slot.Load(), after);
+}
+
+//------------------------------------------------------------------------------
+// Updates which do not go through the protobuf representation
+//------------------------------------------------------------------------------
+TEST(CompactFileMD, SlotFastUpdate)
+{
+  eos::ns::FileMdProto proto = buildProto();
+  eos::CompactFileMDSlot slot(eos::CompactFileMD::Create(proto));
+  auto before = slot.Load();
+  ASSERT_TRUE(slot.UpdateFields([](eos::CompactFileMD::Fields & fields) {
+    fields.mSize = 17;
+    fields.mUid = 3003;
+    fields.mFlags |= 0x8000;
+    return true;
+  }));
+  ASSERT_FALSE(slot.UpdateFields([](eos::CompactFileMD::Fields&) {
+    return false;
+  }));
+  slot.SetName("renamed_file.root");
+  slot.SetChecksum(std::string_view());
+  eos::IFileMD::ctime_t ts {1700000000, 5};
+  slot.SetSyncTime(ts);
+  ASSERT_TRUE(slot.UpdateLocations([](eos::IFileMD::LocationVector & locs,
+  eos::IFileMD::LocationVector & unlinked) {
+    unlinked.push_back(locs.back());
+    locs.pop_back();
+    return true;
+  }));
+  slot.SetAttribute("user.tag", "new");
+  slot.SetAttribute("user.other", "x");
+  ASSERT_TRUE(slot.RemoveAttribute("sys.eos.btime"));
+  ASSERT_FALSE(slot.RemoveAttribute("sys.eos.btime"));
+  // Same result as the equivalent protobuf update
+  proto.set_size(17);
+  proto.set_uid(3003);
+  proto.set_flags(proto.flags() | 0x8000);
+  proto.set_name("renamed_file.root");
+  proto.clear_checksum();
+  proto.set_stime(&ts, sizeof(ts));
+  proto.mutable_locations()->RemoveLast();
+  proto.add_unlink_locations(4000000000u);
+  (*proto.mutable_xattrs())["user.tag"] = "new";
+  (*proto.mutable_xattrs())["user.other"] = "x";
+  proto.mutable_xattrs()->erase("sys.eos.btime");
+  eos::ns::FileMdProto expanded;
+  slot.Load()->toProto(expanded);
+  ASSERT_TRUE(google::protobuf::util::MessageDifferencer::Equals(proto,
+              expanded));
+  ASSERT_EQ(slot.Load()->getMemoryFootprint(),
+            eos::CompactFileMD::Create(proto)->getMemoryFootprint());
+  // Old snapshot is untouched
+  ASSERT_EQ(before->getName(), "some_file.root");
+  ASSERT_EQ(before->getSize(), 1ull << 40);
+  ASSERT_EQ(before->numAttributes(), 2u);
+  slot.ClearAttributes();
+  ASSERT_EQ(slot.Load()->numAttributes(), 0u);
+  ASSERT_EQ(slot.Load()->getName(), "renamed_file.root");
+}
+
+//------------------------------------------------------------------------------
+// Ids which do not fit the compact representation are rejected
+//------------------------------------------------------------------------------
+TEST(CompactFileMD, IdOverflow)
+{
+  eos::ns::FileMdProto proto = buildProto();
+  proto.set_uid(0xffffffffull);
+  ASSERT_EQ(eos::CompactFileMD::Create(proto)->getCUid(), 0xffffffffu);
+  proto.set_uid(1ull << 32);
+  ASSERT_THROW(eos::CompactFileMD::Create(proto), eos::MDException);
+  proto.set_uid(0);
+  proto.set_gid(1ull << 40);
+  ASSERT_THROW(eos::CompactFileMD::Create(proto), eos::MDException);
+}
+
+//------------------------------------------------------------------------------
+// Key interning while the table grows
+//------------------------------------------------------------------------------
+TEST(XattrKeyInterner, ConcurrentIntern)
+{
+  eos::XattrKeyInterner interner;
+  std::vector<std::thread> threads;
+
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&interner]() {
+      for (int j = 0; j < 1000; ++j) {
+        std::string key = "user.key." + std::to_string(j);
+        uint32_t id = interner.Intern(key);
+        uint32_t found;
+        ASSERT_TRUE(interner.Find(key, found));
+        ASSERT_EQ(found, id);
+        ASSERT_EQ(interner.Lookup(id), key);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ASSERT_EQ(interner.Size(), 1000u);
+  uint32_t id;
+  ASSERT_FALSE(interner.Find("user.missing", id));
+  ASSERT_TRUE(interner.Lookup(1000).empty());
+}
@@ -0,0 +1,230 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Measure the path prefix resolution latency of the ContainerPathCache,
+//!        which is paid by every open/stat before touching the namespace,
+//!        against the previous layout of exclusively locked shards doing an
+//!        exact LRU update on every lookup
+//------------------------------------------------------------------------------
+
+#include "common/CLI11.hpp"
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+
+//! Sink for the lookup results
+std::atomic<uint64_t> gChecksum {0};
+
+//------------------------------------------------------------------------------
+//! Previous layout of the cache used as reference: every lookup takes the
+//! shard mutex and moves the entry to the front of the LRU list
+//------------------------------------------------------------------------------
+class LockedLruCache
+{
+public:
+  static constexpr size_t sNumShards = 64;
+
+  void Insert(const std::deque<std::string>& chunks,
+              const std::vector<uint64_t>& ids)
+  {
+    for (size_t i = 0; i + 1 < ids.size(); ++i) {
+      uint64_t hash = Hash(ids[i], chunks[i]);
+      Shard& shard = mShards[hash % sNumShards];
+      std::unique_lock<std::mutex> lock(shard.mMutex);
+
+      if (shard.mEntries.count(hash) == 0) {
+        shard.mLru.push_front(Entry{ids[i], chunks[i], ids[i + 1]});
+        shard.mEntries[hash] = shard.mLru.begin();
+      }
+    }
+  }
+
+  size_t Lookup(const std::deque<std::string>& chunks, uint64_t& cid)
+  {
+    uint64_t parent = 1;
+    size_t covered = 0;
+
+    for (; covered < chunks.size(); ++covered) {
+      uint64_t hash = Hash(parent, chunks[covered]);
+      Shard& shard = mShards[hash % sNumShards];
+      std::unique_lock<std::mutex> lock(shard.mMutex);
+      auto it = shard.mEntries.find(hash);
+
+      if ((it == shard.mEntries.end()) || (it->second->parent != parent) ||
+          (it->second->name != chunks[covered])) {
+        break;
+      }
+
+      shard.mLru.splice(shard.mLru.begin(), shard.mLru, it->second);
+      parent = it->second->cid;
+    }
+
+    cid = parent;
+    return covered;
+  }
+
+private:
+  struct Entry {
+    uint64_t parent;
+    std::string name;
+    uint64_t cid;
+  };
+
+  struct Shard {
+    std::mutex mMutex;
+    std::list<Entry> mLru;
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> mEntries;
+  };
+
+  static uint64_t Hash(uint64_t parent, const std::string& name)
+  {
+    return std::hash<std::string>()(name) ^ (parent * 1099511628211ull);
+  }
+
+  Shard mShards[sNumShards];
+};
+
+//------------------------------------------------------------------------------
+//! Build the chunks of the given directory in a tree below /eos/ of the given
+//! fan-out and depth, the ids are assigned breadth first
+//------------------------------------------------------------------------------
+void BuildPath(uint64_t index, uint32_t fanout, uint32_t depth,
+               std::deque<std::string>& chunks, std::vector<uint64_t>& ids)
+{
+  chunks.assign({"eos"});
+  ids.assign({1, 2});
+  uint64_t first = 3;
+  uint64_t level_size = 1;
+  uint64_t pos = 0;
+
+  for (uint32_t d = 0; d < depth; ++d) {
+    uint64_t digit = (index / level_size) % fanout;
+    level_size *= fanout;
+    pos = pos * fanout + digit;
+    chunks.push_back("dir" + std::to_string(digit));
+    ids.push_back(first + pos);
+    first += level_size;
+  }
+}
+
+//------------------------------------------------------------------------------
+//! Run the given number of random path lookups from multiple threads
+//!
+//! @return average lookup latency per thread in nanoseconds
+//------------------------------------------------------------------------------
+double RunLookups(const std::vector<std::deque<std::string>>& paths,
+                  uint32_t num_threads, uint64_t num_requests,
+                  const std::function<size_t(const std::deque<std::string>&,
+                      uint64_t&)>& lookup)
+{
+  std::vector<std::thread> workers;
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint32_t t = 0; t < num_threads; ++t) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 gen(t);
+      uint64_t local = 0;
+
+      for (uint64_t i = 0; i < num_requests; ++i) {
+        uint64_t cid = 0;
+        local += lookup(paths[gen() % paths.size()], cid) + cid;
+      }
+
+      gChecksum += local;
+    });
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>
+                  (std::chrono::steady_clock::now() - start).count();
+  return (double) duration / num_requests;
+}
+
+//------------------------------------------------------------------------------
+// Main programm
+//------------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  CLI::App app{"Container path cache benchmark tool"};
+  uint32_t fanout = 10;
+  uint32_t depth = 4;
+  uint32_t num_threads = 16;
+  uint64_t num_requests = 1000000;
+  bool use_locked = false;
+  app.add_option("-f,--fanout", fanout, "subdirectories per directory");
+  app.add_option("-d,--depth", depth, "directory levels below /eos/");
+  app.add_option("-t,--num_threads", num_threads,
+                 "number of threads for lookup operations");
+  app.add_option("-r,--num_requests", num_requests,
+                 "number of lookups per thread");
+  app.add_flag("-l,--locked", use_locked,
+               "use the previous exclusively locked LRU layout");
+  CLI11_PARSE(app, argc, argv);
+
+  if ((fanout == 0) || (depth == 0)) {
+    std::cerr << "error: fanout and depth must be positive" << std::endl;
+    return 1;
+  }
+
+  uint64_t num_paths = 1;
+
+  for (uint32_t d = 0; d < depth; ++d) {
+    num_paths *= fanout;
+  }
+
+  // Big enough to hold all the translations, only the lookups are measured
+  eos::ContainerPathCache cache(4 * num_paths * depth +
+                                eos::ContainerPathCache::sNumShards);
+  LockedLruCache locked;
+  std::vector<std::deque<std::string>> paths(num_paths);
+  std::vector<uint64_t> ids;
+
+  for (uint64_t i = 0; i < num_paths; ++i) {
+    BuildPath(i, fanout, depth, paths[i], ids);
+
+    if (use_locked) {
+      locked.Insert(paths[i], ids);
+    } else {
+      cache.insert(paths[i], ids, cache.getRemovalSequence());
+    }
+  }
+
+  double latency_ns = RunLookups(paths, num_threads, num_requests,
+  [&](const std::deque<std::string>& path, uint64_t & cid) {
+    return (use_locked ? locked.Lookup(path, cid) :
+            cache.lookup(path, path.size(), cid));
+  });
+  std::cout << "layout          : " << (use_locked ? "locked LRU" :
+                                        "shared lock + CLOCK") << std::endl
+            << "paths           : " << num_paths << " (depth " << depth + 1
+            << ")" << std::endl
+            << "threads         : " << num_threads << std::endl
+            << "lookup latency  : " << latency_ns << " ns" << std::endl;
+  return 0;
+}
@@ -764,3 +764,35 @@ TEST_F(HierarchicalViewF, CustomFileId)
   eos::IFileMDPtr f1000 = view()->createFile("/f1000", 0, 0, 0);
   ASSERT_EQ(f1000->getId(), 1000);
 }
+
+TEST_F(HierarchicalViewF, PathCache)
+{
+  eos::QuarkHierarchicalView* quarkView =
+    dynamic_cast<eos::QuarkHierarchicalView*>(view());
+  ASSERT_NE(quarkView, nullptr);
+  const eos::ContainerPathCache& cache = quarkView->getPathCache();
+  eos::IContainerMDPtr cont = view()->createContainer("/a/b/c/d", true);
+  view()->createFile("/a/b/c/d/f1", 0, 0);
+  // First lookup resolves component by component and populates the cache
+  ASSERT_EQ(view()->getFile("/a/b/c/d/f1")->getName(), "f1");
+  uint64_t hits = cache.getNumHits();
+  ASSERT_EQ(view()->getFile("/a/b/c/d/f1")->getName(), "f1");
+  ASSERT_EQ(view()->getContainer("/a/b/c/d")->getId(), cont->getId());
+  ASSERT_EQ(cache.getNumHits(), hits + 2);
+  // Renaming an ancestor invalidates the cached translations
+  view()->renameContainer(view()->getContainer("/a/b").get(), "b2");
+  ASSERT_THROW(view()->getFile("/a/b/c/d/f1"), eos::MDException);
+  ASSERT_EQ(view()->getFile("/a/b2/c/d/f1")->getName(), "f1");
+  // Paths resolved through a symlink are not cached
+  view()->createLink("/link", "/a/b2/c", 0, 0);
+  ASSERT_EQ(view()->getFile("/link/d/f1")->getName(), "f1");
+  view()->removeLink("/link");
+  view()->createContainer("/link", false);
+  ASSERT_THROW(view()->getContainer("/link/d"), eos::MDException);
+  // Removal of a cached container
+  view()->removeFile(view()->getFile("/a/b2/c/d/f1").get());
+  view()->removeContainer("/a/b2/c/d");
+  ASSERT_THROW(view()->getContainer("/a/b2/c/d"), eos::MDException);
+  view()->createContainer("/a/b2/c/d", false);
+  ASSERT_NE(view()->getContainer("/a/b2/c/d")->getId(), cont->getId());
+}
@@ -25,10 +25,14 @@
 #include "namespace/ns_quarkdb/ConfigurationParser.hh"
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include "namespace/ns_quarkdb/LRU.hh"
+#include "namespace/ns_quarkdb/flusher/RequestCoalescer.hh"
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
 #include "namespace/utils/PathProcessor.hh"
 #include "namespace/utils/TestHelpers.hh"
 #include <gtest/gtest.h>
+#include <atomic>
 #include <sstream>
+#include <thread>
 
 //------------------------------------------------------------------------------
 // Check the path
@@ -179,6 +183,139 @@ TEST(LRU, BasicSanity)
   ASSERT_TRUE(!cache.get(100));
 }
 
+TEST(LRU, RecentIds)
+{
+  struct Entry {
+    explicit Entry(std::uint64_t id) : id_(id) {}
+
+    std::uint64_t
+    getId() const
+    {
+      return id_;
+    }
+
+    std::uint64_t id_;
+  };
+  eos::LRU<std::uint64_t, Entry> cache{100};
+  ASSERT_TRUE(cache.getRecentIds(10).empty());
+
+  for (std::uint64_t id = 1; id <= 5; ++id) {
+    ASSERT_TRUE(cache.put(id, std::make_shared<Entry>(id)));
+  }
+
+  // Accessing an entry moves it to the front of the recent ids
+  ASSERT_TRUE(cache.get(2));
+  std::vector<std::uint64_t> expected {2, 5, 4};
+  ASSERT_EQ(expected, cache.getRecentIds(3));
+  expected = {2, 5, 4, 3, 1};
+  ASSERT_EQ(expected, cache.getRecentIds(10));
+  ASSERT_TRUE(cache.remove(5));
+  expected = {2, 4};
+  ASSERT_EQ(expected, cache.getRecentIds(2));
+}
+
+TEST(ContainerPathCache, BasicSanity)
+{
+  eos::ContainerPathCache cache(1000);
+  std::deque<std::string> chunks {"eos", "dev", "dir1", "file1"};
+  uint64_t cid = 0;
+  ASSERT_EQ(cache.lookup(chunks, chunks.size(), cid), 0u);
+  uint64_t seq = cache.getRemovalSequence();
+  cache.insert(chunks, {1, 10, 11}, seq);
+  cache.insert(chunks, {1, 10, 11, 12}, seq);
+  ASSERT_EQ(cache.lookup(chunks, chunks.size(), cid), 3u);
+  ASSERT_EQ(cid, 12u);
+  ASSERT_EQ(cache.lookup(chunks, 2, cid), 2u);
+  ASSERT_EQ(cid, 11u);
+  // Removal of a container which is not part of any cached path
+  eos::ContainerPathCache::notifyRemoval(99);
+  ASSERT_EQ(cache.lookup(chunks, chunks.size(), cid), 3u);
+  // Insertion racing with the removal of a container on its path is dropped
+  std::deque<std::string> other {"eos", "other", "sub"};
+  cache.insert(other, {1, 10, 99, 100}, seq);
+  ASSERT_EQ(cache.lookup(other, other.size(), cid), 1u);
+  ASSERT_EQ(cid, 10u);
+  // Removal of an ancestor makes the paths below it unreachable
+  eos::ContainerPathCache::notifyRemoval(10);
+  ASSERT_EQ(cache.lookup(chunks, chunks.size(), cid), 0u);
+  // ... but keeps the translations below it e.g. once moved elsewhere
+  seq = cache.getRemovalSequence();
+  std::deque<std::string> moved {"eos2", "dev", "dir1", "file1"};
+  cache.insert(moved, {1, 10}, seq);
+  ASSERT_EQ(cache.lookup(moved, moved.size(), cid), 3u);
+  ASSERT_EQ(cid, 12u);
+  // Removal of a leaf only affects the paths going through it
+  eos::ContainerPathCache::notifyRemoval(12);
+  ASSERT_EQ(cache.lookup(moved, moved.size(), cid), 2u);
+  ASSERT_EQ(cid, 11u);
+  // Disabled cache
+  cache.setMaxEntries(0);
+  ASSERT_FALSE(cache.isEnabled());
+  cache.insert(moved, {1, 10, 11}, cache.getRemovalSequence());
+  ASSERT_EQ(cache.lookup(moved, moved.size(), cid), 0u);
+}
+
+TEST(ContainerPathCache, BoundedLRU)
+{
+  eos::ContainerPathCache cache(eos::ContainerPathCache::sNumShards * 4);
+  std::deque<std::string> hot {"hot"};
+  cache.insert(hot, {1, 2}, cache.getRemovalSequence());
+  uint64_t cid = 0;
+
+  for (uint64_t i = 0; i < 10000; ++i) {
+    std::deque<std::string> chunks {"dir" + std::to_string(i)};
+    cache.insert(chunks, {1, 100 + i}, cache.getRemovalSequence());
+    // The frequently used entry is never the least recently used one
+    ASSERT_EQ(cache.lookup(hot, hot.size(), cid), 1u);
+    ASSERT_EQ(cid, 2u);
+  }
+
+  ASSERT_LE(cache.size(), eos::ContainerPathCache::sNumShards * 4);
+}
+
+TEST(ContainerPathCache, ConcurrentLookups)
+{
+  eos::ContainerPathCache cache(eos::ContainerPathCache::sNumShards * 8);
+  std::deque<std::string> hot {"eos", "dev", "hot"};
+  cache.insert(hot, {1, 10, 11, 12}, cache.getRemovalSequence());
+  std::atomic<bool> stop {false};
+  std::vector<std::thread> readers;
+
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      uint64_t cid = 0;
+
+      while (!stop) {
+        // Either fully cached or, once evicted, a consistent shorter prefix
+        size_t covered = cache.lookup(hot, hot.size(), cid);
+
+        if (covered) {
+          ASSERT_EQ(cid, 9 + covered);
+        }
+      }
+    });
+  }
+
+  // Churn the shards with insertions, evictions and removals
+  for (uint64_t i = 0; i < 20000; ++i) {
+    std::deque<std::string> chunks {"eos", "dev", "dir" + std::to_string(i)};
+    cache.insert(chunks, {1, 10, 11, 1000 + i}, cache.getRemovalSequence());
+
+    if (i % 100 == 0) {
+      eos::ContainerPathCache::notifyRemoval(1000 + i / 2);
+    }
+  }
+
+  stop = true;
+
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  ASSERT_LE(cache.size(), eos::ContainerPathCache::sNumShards * 8);
+  ASSERT_GT(cache.getNumHits(), 0u);
+}
+
 TEST(PathProcessor, AbsPathTest)
 {
   std::string path = "/a/b/c/d/";
@@ -21,6 +21,7 @@
 //! @brief Various namespace tests
 //------------------------------------------------------------------------------
 
+#include <chrono>
 #include <memory>
 #include <gtest/gtest.h>
 
@@ -690,7 +691,10 @@ TEST_F(VariousTests, EtagFormatting)
   mtime.tv_nsec = 0;
   file1->setCTime(mtime);
   eos::QuarkFileMD* file1f = reinterpret_cast<QuarkFileMD*>(file1.get());
-  file1f->mFile.set_id(4697755903ull);
+  file1f->mFile.Update([](eos::ns::FileMdProto & proto) {
+    proto.set_id(4697755903ull);
+    return true;
+  });
   // File has no checksum, using inode + modification time.
   std::string outcome;
   eos::calculateEtag(file1.get(), outcome);
@@ -708,7 +712,10 @@ TEST_F(VariousTests, EtagFormatting)
   buff[2] = 0x99;
   buff[3] = 0x97;
   file1->setChecksum(buff, 4);
-  file1f->mFile.set_id(4697755939ull);
+  file1f->mFile.Update([](eos::ns::FileMdProto & proto) {
+    proto.set_id(4697755939ull);
+    return true;
+  });
   unsigned long layout = eos::common::LayoutId::GetId(
                            eos::common::LayoutId::kReplica,
                            eos::common::LayoutId::kAdler,
@@ -1135,6 +1142,169 @@ TEST_F(NamespaceExplorerF, ExpansionDecider)
   ASSERT_FALSE(explorer.fetch(item));
 }
 
+//------------------------------------------------------------------------------
+// Run exploration to the end, return "<path> <filtered>" for every item
+//------------------------------------------------------------------------------
+static std::vector<std::string> exploreAll(const std::string& path,
+    const ExplorationOptions& options, qclient::QClient& qcl,
+    folly::Executor* exec)
+{
+  std::vector<std::string> out;
+  NamespaceExplorer explorer(path, options, qcl, exec);
+  NamespaceItem item;
+
+  while (explorer.fetch(item)) {
+    out.emplace_back(SSTR(item.fullPath << " " << item.expansionFilteredOut));
+  }
+
+  return out;
+}
+
+TEST_F(NamespaceExplorerF, Parallel)
+{
+  populateDummyData1();
+  view()->createContainer("/eos/d2/d4/1/2/3/4/5/6/7/8", true);
+  view()->createFile("/eos/d2/d4/1/2/3/my-file");
+  mdFlusher()->synchronize();
+
+  for (int variant = 0; variant < 4; variant++) {
+    ExplorationOptions options;
+    options.ignoreFiles = (variant % 2);
+
+    if (variant < 2) {
+      options.depthLimit = 8;
+    } else {
+      options.depthLimit = 999;
+      options.expansionDecider.reset(new ContainerFilter());
+    }
+
+    for (const std::string path : {
+           "/", "/eos/d2"
+         }) {
+      options.parallelism = 0;
+      std::vector<std::string> sequential = exploreAll(path, options, qcl(),
+                                            executor());
+      // Ordered mode gives the exact same output, also with a tiny memory bound
+      options.parallelism = 4;
+      options.ordered = true;
+      options.maxBufferedItems = 1000;
+      ASSERT_EQ(sequential, exploreAll(path, options, qcl(), executor()));
+      options.maxBufferedItems = 1;
+      ASSERT_EQ(sequential, exploreAll(path, options, qcl(), executor()));
+      // Unordered mode gives the same items, starting with the root
+      options.ordered = false;
+
+      for (uint64_t maxBuffered : {
+             1, 1000
+           }) {
+        options.maxBufferedItems = maxBuffered;
+        std::vector<std::string> unordered = exploreAll(path, options, qcl(),
+                                             executor());
+        ASSERT_EQ(unordered.front(), sequential.front());
+        std::sort(unordered.begin(), unordered.end());
+        std::vector<std::string> sorted = sequential;
+        std::sort(sorted.begin(), sorted.end());
+        ASSERT_EQ(unordered, sorted);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Directories with more files than fetched at once are returned in full
+//------------------------------------------------------------------------------
+TEST_F(NamespaceExplorerF, ParallelLargeDirectory)
+{
+  const size_t numFiles = 2500;
+  view()->createContainer("/large/d1/sub", true);
+  view()->createContainer("/large/d2", true);
+
+  for (size_t i = 0; i < numFiles; i++) {
+    view()->createFile(SSTR("/large/d1/f" << i));
+  }
+
+  view()->createFile("/large/d2/f");
+  mdFlusher()->synchronize();
+  ExplorationOptions options;
+  options.depthLimit = 999;
+  options.parallelism = 0;
+  std::vector<std::string> sequential = exploreAll("/large", options, qcl(),
+                                        executor());
+  ASSERT_EQ(sequential.size(), 4 + numFiles + 1);
+  options.parallelism = 4;
+
+  for (uint64_t maxBuffered : {
+         1, 1000, 1000000
+       }) {
+    options.maxBufferedItems = maxBuffered;
+    options.ordered = true;
+    ASSERT_EQ(sequential, exploreAll("/large", options, qcl(), executor()));
+    options.ordered = false;
+    std::vector<std::string> unordered = exploreAll("/large", options, qcl(),
+                                         executor());
+    std::sort(unordered.begin(), unordered.end());
+    std::vector<std::string> sorted = sequential;
+    std::sort(sorted.begin(), sorted.end());
+    ASSERT_EQ(unordered, sorted);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Compare the sequential and the parallel exploration of a larger tree. Not a
+// real benchmark as QDB runs locally, but it shows the effect of having many
+// expansions in flight.
+//------------------------------------------------------------------------------
+TEST_F(NamespaceExplorerF, ParallelBenchmark)
+{
+  const size_t numDirs = 20;
+  const size_t numFiles = 10;
+
+  for (size_t i = 0; i < numDirs; i++) {
+    for (size_t j = 0; j < numDirs; j++) {
+      std::string dir = SSTR("/bench/d" << i << "/d" << j << "/");
+      view()->createContainer(dir, true);
+
+      for (size_t k = 0; k < numFiles; k++) {
+        view()->createFile(SSTR(dir << "f" << k));
+      }
+    }
+  }
+
+  mdFlusher()->synchronize();
+  std::vector<std::string> reference;
+
+  for (uint32_t parallelism : {
+         0, 1, 16, 64
+       }) {
+    for (bool ordered : {
+           true, false
+         }) {
+      if (parallelism == 0 && !ordered) {
+        continue;
+      }
+
+      ExplorationOptions options;
+      options.parallelism = parallelism;
+      options.ordered = ordered;
+      auto start = std::chrono::steady_clock::now();
+      std::vector<std::string> items = exploreAll("/bench", options, qcl(),
+                                       executor());
+      auto duration = std::chrono::duration_cast<std::chrono::milliseconds>
+                      (std::chrono::steady_clock::now() - start);
+      std::cout << "parallelism=" << parallelism << " ordered=" << ordered
+                << " items=" << items.size() << " duration="
+                << duration.count() << "ms" << std::endl;
+      ASSERT_EQ(items.size(), 1 + numDirs + numDirs * numDirs * (1 + numFiles));
+
+      if (reference.empty()) {
+        reference = items;
+      } else if (ordered) {
+        ASSERT_EQ(items, reference);
+      }
+    }
+  }
+}
+
 TEST_F(VariousTests, LinkedExtendedAttributes)
 {
   IContainerMDPtr cont1 = view()->createContainer("/eos/dir1", true);
@@ -82,6 +82,9 @@ MDStatus QuotaRecomputer::recompute(const std::string& cont_uri,
   ExplorationOptions options;
   options.depthLimit = 2048;
   options.expansionDecider.reset(new QuotaNodeFilter(cont_id));
+  // Only the totals matter, the order in which files are visited does not
+  options.parallelism = ExplorationOptions::sDefaultParallelism;
+  options.ordered = false;
   NamespaceExplorer explorer(cont_uri, options, *mQcl, mExecutor);
   NamespaceItem item;
 
@@ -0,0 +1,453 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
+#include <algorithm>
+#include <string_view>
+
+EOSNSNAMESPACE_BEGIN
+
+namespace
+{
+constexpr uint64_t sFnvOffset = 14695981039346656037ull;
+constexpr uint64_t sFnvPrime = 1099511628211ull;
+
+//------------------------------------------------------------------------------
+// Continue FNV-1a hash with the given data
+//------------------------------------------------------------------------------
+inline uint64_t hashAppend(uint64_t hash, std::string_view data)
+{
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= sFnvPrime;
+  }
+
+  return hash;
+}
+
+//------------------------------------------------------------------------------
+// Hash of a (parent id, name) translation
+//------------------------------------------------------------------------------
+inline uint64_t hashEntry(uint64_t parent, const std::string& name)
+{
+  uint64_t hash = hashAppend(sFnvOffset, std::string_view(
+                               reinterpret_cast<const char*>(&parent), sizeof(parent)));
+  return hashAppend(hash, name);
+}
+}
+
+constexpr size_t ContainerPathCache::sNumShards;
+constexpr size_t ContainerPathCache::sMaxTombstones;
+
+//------------------------------------------------------------------------------
+// Get the registry of all the caches
+//------------------------------------------------------------------------------
+ContainerPathCache::Registry&
+ContainerPathCache::getRegistry()
+{
+  static Registry* sRegistry = new Registry();
+  return *sRegistry;
+}
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+ContainerPathCache::ContainerPathCache(uint64_t max_entries):
+  mMaxPerShard(max_entries ? std::max<uint64_t>(1, max_entries / sNumShards) : 0)
+{
+  Registry& registry = getRegistry();
+  std::unique_lock<std::shared_timed_mutex> lock(registry.mMutex);
+  registry.mCaches.insert(this);
+}
+
+//------------------------------------------------------------------------------
+// Destructor
+//------------------------------------------------------------------------------
+ContainerPathCache::~ContainerPathCache()
+{
+  Registry& registry = getRegistry();
+  std::unique_lock<std::shared_timed_mutex> lock(registry.mMutex);
+  registry.mCaches.erase(this);
+}
+
+//------------------------------------------------------------------------------
+// Change the maximum number of cached translations
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::setMaxEntries(uint64_t max_entries)
+{
+  mMaxPerShard = (max_entries ?
+                  std::max<uint64_t>(1, max_entries / sNumShards) : 0);
+  clear();
+}
+
+//------------------------------------------------------------------------------
+// Find the longest cached prefix of the given path chunks
+//------------------------------------------------------------------------------
+size_t
+ContainerPathCache::lookup(const std::deque<std::string>& chunks,
+                           size_t max_chunks, uint64_t& cid)
+{
+  if (!isEnabled()) {
+    return 0;
+  }
+
+  max_chunks = std::min(max_chunks, chunks.size());
+  uint64_t parent = 1;
+  size_t covered = 0;
+  Shard* last = &mShards[0];
+
+  for (; covered < max_chunks; ++covered) {
+    const std::string& name = chunks[covered];
+    uint64_t hash = hashEntry(parent, name);
+    Shard& shard = getShard(hash);
+    last = &shard;
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mMutex);
+    auto it = shard.mEntries.find(hash);
+
+    if (it == shard.mEntries.end()) {
+      break;
+    }
+
+    const Entry& entry = shard.mClock[it->second];
+
+    if ((entry.parent != parent) || (entry.name != name)) {
+      break;
+    }
+
+    // Avoid dirtying the cache line of hot entries which are already marked
+    if (!entry.referenced.load(std::memory_order_relaxed)) {
+      entry.referenced.store(true, std::memory_order_relaxed);
+    }
+
+    parent = entry.cid;
+  }
+
+  if (covered == 0) {
+    last->mMisses.fetch_add(1, std::memory_order_relaxed);
+    return 0;
+  }
+
+  cid = parent;
+  last->mHits.fetch_add(1, std::memory_order_relaxed);
+  return covered;
+}
+
+//------------------------------------------------------------------------------
+// Cache the translations of a canonical path
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::insert(const std::deque<std::string>& chunks,
+                           const std::vector<uint64_t>& ids,
+                           uint64_t removal_seq)
+{
+  const uint64_t max_per_shard = mMaxPerShard.load();
+
+  if ((max_per_shard == 0) || (ids.size() < 2) ||
+      (chunks.size() < ids.size() - 1)) {
+    return;
+  }
+
+  for (size_t i = 0; i + 1 < ids.size(); ++i) {
+    const uint64_t parent = ids[i];
+    const uint64_t cid = ids[i + 1];
+    const std::string& name = chunks[i];
+    const uint64_t hash = hashEntry(parent, name);
+    uint64_t evicted_cid = 0;
+    uint64_t evicted_hash = 0;
+    {
+      Shard& shard = getShard(hash);
+      std::unique_lock<std::shared_timed_mutex> lock(shard.mMutex);
+      auto it = shard.mEntries.find(hash);
+
+      if (it != shard.mEntries.end()) {
+        Entry& entry = shard.mClock[it->second];
+
+        if (entry.cid != cid) {
+          evicted_cid = entry.cid;
+          evicted_hash = hash;
+        }
+
+        entry.parent = parent;
+        entry.name = name;
+        entry.cid = cid;
+        entry.referenced = true;
+      } else if (shard.mClock.size() >= max_per_shard) {
+        // Replace a translation not used since the hand last passed
+        size_t pos = pickVictim(shard);
+        Entry& victim = shard.mClock[pos];
+        evicted_cid = victim.cid;
+        evicted_hash = victim.hash;
+        shard.mEntries.erase(victim.hash);
+        victim = Entry(hash, parent, name, cid);
+        shard.mEntries[hash] = pos;
+      } else {
+        shard.mClock.emplace_back(hash, parent, name, cid);
+        shard.mEntries[hash] = shard.mClock.size() - 1;
+      }
+    }
+
+    if (evicted_cid) {
+      dropChild(evicted_cid, evicted_hash);
+    }
+
+    //--------------------------------------------------------------------------
+    // Index the container only once its translation is published. A removal
+    // either finds the index and drops the translation or leaves a tombstone
+    // which makes us drop it here.
+    //--------------------------------------------------------------------------
+    bool stale = false;
+    {
+      ChildShard& cshard = getChildShard(cid);
+      std::unique_lock<std::mutex> lock(cshard.mMutex);
+
+      if (removal_seq < cshard.mPurgedSeq) {
+        stale = true;
+      } else {
+        auto it = cshard.mChildren.find(cid);
+
+        if (it == cshard.mChildren.end()) {
+          cshard.mChildren.emplace(cid, ChildState{hash, 0});
+        } else if (it->second.removed_seq == 0) {
+          it->second.hash = hash;
+        } else if (it->second.removed_seq > removal_seq) {
+          stale = true;
+        } else {
+          // Removed before the resolution started e.g. moved elsewhere
+          it->second = ChildState{hash, 0};
+          --cshard.mNumTombstones;
+        }
+      }
+    }
+
+    if (stale) {
+      // Anything below is unreachable anyway
+      dropEntry(hash, cid);
+      return;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Notify all the caches that the given container was removed
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::notifyRemoval(uint64_t cid)
+{
+  Registry& registry = getRegistry();
+  std::shared_lock<std::shared_timed_mutex> lock(registry.mMutex);
+
+  for (auto* cache : registry.mCaches) {
+    cache->handleRemoval(cid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Handle removal of the given container
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::handleRemoval(uint64_t cid)
+{
+  if (!isEnabled()) {
+    return;
+  }
+
+  const uint64_t seq = ++mRemovalSeq;
+  bool cached = false;
+  uint64_t hash = 0;
+  {
+    ChildShard& cshard = getChildShard(cid);
+    std::unique_lock<std::mutex> lock(cshard.mMutex);
+    auto it = cshard.mChildren.find(cid);
+
+    if (it == cshard.mChildren.end()) {
+      cshard.mChildren.emplace(cid, ChildState{0, seq});
+      ++cshard.mNumTombstones;
+    } else {
+      if (it->second.removed_seq == 0) {
+        cached = true;
+        hash = it->second.hash;
+        ++cshard.mNumTombstones;
+      }
+
+      it->second = ChildState{0, seq};
+    }
+
+    // Keep the tombstones bounded, resolutions started before the most
+    // recent purged removal will not be cached
+    if (cshard.mNumTombstones > sMaxTombstones) {
+      for (auto cit = cshard.mChildren.begin(); cit != cshard.mChildren.end();) {
+        if (cit->second.removed_seq) {
+          cshard.mPurgedSeq = std::max(cshard.mPurgedSeq, cit->second.removed_seq);
+          cit = cshard.mChildren.erase(cit);
+        } else {
+          ++cit;
+        }
+      }
+
+      cshard.mNumTombstones = 0;
+    }
+  }
+
+  // Paths going through the container become unreachable, the translations
+  // below it are still valid
+  if (cached) {
+    dropEntry(hash, cid);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop the translation with the given hash if it leads to the container
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::dropEntry(uint64_t hash, uint64_t cid)
+{
+  Shard& shard = getShard(hash);
+  std::unique_lock<std::shared_timed_mutex> lock(shard.mMutex);
+  auto it = shard.mEntries.find(hash);
+
+  if ((it != shard.mEntries.end()) && (shard.mClock[it->second].cid == cid)) {
+    removeAt(shard, it->second);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Pick the entry to evict from a full shard
+//------------------------------------------------------------------------------
+size_t
+ContainerPathCache::pickVictim(Shard& shard)
+{
+  // Terminates within two rounds since every entry passed over is cleared
+  while (true) {
+    if (shard.mHand >= shard.mClock.size()) {
+      shard.mHand = 0;
+    }
+
+    size_t pos = shard.mHand++;
+
+    if (!shard.mClock[pos].referenced.exchange(false)) {
+      return pos;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Remove the entry at the given position of the clock
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::removeAt(Shard& shard, size_t pos)
+{
+  shard.mEntries.erase(shard.mClock[pos].hash);
+
+  // Fill the hole with the last entry to keep the clock dense
+  if (pos + 1 != shard.mClock.size()) {
+    shard.mClock[pos] = std::move(shard.mClock.back());
+    shard.mEntries[shard.mClock[pos].hash] = pos;
+  }
+
+  shard.mClock.pop_back();
+}
+
+//------------------------------------------------------------------------------
+// Drop the index entry of a container whose translation was evicted
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::dropChild(uint64_t cid, uint64_t hash)
+{
+  ChildShard& cshard = getChildShard(cid);
+  std::unique_lock<std::mutex> lock(cshard.mMutex);
+  auto it = cshard.mChildren.find(cid);
+
+  if ((it != cshard.mChildren.end()) && (it->second.removed_seq == 0) &&
+      (it->second.hash == hash)) {
+    cshard.mChildren.erase(it);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Drop all cached entries
+//------------------------------------------------------------------------------
+void
+ContainerPathCache::clear()
+{
+  // Resolutions in flight must not re-populate the cache with their results,
+  // done first so that whatever they already inserted is cleared below
+  const uint64_t seq = ++mRemovalSeq;
+
+  for (auto& cshard : mChildShards) {
+    std::unique_lock<std::mutex> lock(cshard.mMutex);
+    cshard.mChildren.clear();
+    cshard.mNumTombstones = 0;
+    cshard.mPurgedSeq = seq;
+  }
+
+  for (auto& shard : mShards) {
+    std::unique_lock<std::shared_timed_mutex> lock(shard.mMutex);
+    shard.mEntries.clear();
+    shard.mClock.clear();
+    shard.mHand = 0;
+  }
+}
+
+//------------------------------------------------------------------------------
+// Get number of lookups finding at least one translation
+//------------------------------------------------------------------------------
+uint64_t
+ContainerPathCache::getNumHits() const
+{
+  uint64_t total = 0;
+
+  for (const auto& shard : mShards) {
+    total += shard.mHits.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Get number of lookups finding no translation
+//------------------------------------------------------------------------------
+uint64_t
+ContainerPathCache::getNumMisses() const
+{
+  uint64_t total = 0;
+
+  for (const auto& shard : mShards) {
+    total += shard.mMisses.load(std::memory_order_relaxed);
+  }
+
+  return total;
+}
+
+//------------------------------------------------------------------------------
+// Get number of cached translations
+//------------------------------------------------------------------------------
+size_t
+ContainerPathCache::size() const
+{
+  size_t total = 0;
+
+  for (const auto& shard : mShards) {
+    std::shared_lock<std::shared_timed_mutex> lock(shard.mMutex);
+    total += shard.mEntries.size();
+  }
+
+  return total;
+}
+
+EOSNSNAMESPACE_END
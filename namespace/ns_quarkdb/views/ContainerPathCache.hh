@@ -0,0 +1,277 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Bounded cache mapping container paths to container ids
+//------------------------------------------------------------------------------
+
+#ifndef __EOS_NS_CONTAINER_PATH_CACHE_HH__
+#define __EOS_NS_CONTAINER_PATH_CACHE_HH__
+
+#include "namespace/Namespace.hh"
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+EOSNSNAMESPACE_BEGIN
+
+//------------------------------------------------------------------------------
+//! Cache of (parent container id, name) -> container id translations used to
+//! resolve the leading components of a path in memory, so that a deep path
+//! costs a single container fetch instead of one per component.
+//!
+//! Only canonical translations are cached i.e. the name is the one of the
+//! container itself, therefore no entry depends on symlinks, "." or "..".
+//! Since paths are resolved by walking the cached translations from the
+//! root, removing a container from its parent (unlink, rename or move) only
+//! needs to drop the translation of the container itself: all the paths
+//! going through it become unreachable while the rest of the cache, including
+//! the translations below the container, stays valid.
+//!
+//! Removals leave a tombstone for the removed container so that a concurrent
+//! path resolution which started before the removal can not cache a stale
+//! translation afterwards.
+//!
+//! The cache is sharded and every shard evicts translations which were not
+//! used recently once it reaches its maximum size. Recency is tracked with
+//! the CLOCK approximation of LRU: a lookup only takes the shard lock in
+//! shared mode and sets the referenced bit of the entry, so that hot
+//! translations like (1, "eos") shared by all the paths do not serialize
+//! the lookups.
+//------------------------------------------------------------------------------
+class ContainerPathCache
+{
+public:
+  //! Number of independently locked shards
+  static constexpr size_t sNumShards = 64;
+  //! Max number of tombstones per shard before they get purged
+  static constexpr size_t sMaxTombstones = 1024;
+
+  //----------------------------------------------------------------------------
+  //! Constructor
+  //!
+  //! @param max_entries maximum number of cached translations, 0 disables
+  //!        the cache
+  //----------------------------------------------------------------------------
+  ContainerPathCache(uint64_t max_entries = 0);
+
+  //----------------------------------------------------------------------------
+  //! Destructor
+  //----------------------------------------------------------------------------
+  ~ContainerPathCache();
+
+  //----------------------------------------------------------------------------
+  //! Change the maximum number of cached translations, drops all current
+  //! entries
+  //----------------------------------------------------------------------------
+  void setMaxEntries(uint64_t max_entries);
+
+  //----------------------------------------------------------------------------
+  //! Check if cache is enabled
+  //----------------------------------------------------------------------------
+  inline bool isEnabled() const
+  {
+    return (mMaxPerShard.load() != 0);
+  }
+
+  //----------------------------------------------------------------------------
+  //! Find the longest cached prefix of the given path chunks
+  //!
+  //! @param chunks path chunks, must not contain "." or ".."
+  //! @param max_chunks maximum number of chunks to consider
+  //! @param cid container id of the longest cached prefix
+  //!
+  //! @return number of chunks covered by the prefix, 0 if nothing found
+  //----------------------------------------------------------------------------
+  size_t lookup(const std::deque<std::string>& chunks, size_t max_chunks,
+                uint64_t& cid);
+
+  //----------------------------------------------------------------------------
+  //! Get the current removal sequence number. It must be taken before the
+  //! path resolution whose result is later passed to insert.
+  //----------------------------------------------------------------------------
+  inline uint64_t getRemovalSequence() const
+  {
+    return mRemovalSeq.load();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Cache the translations of a canonical path
+  //!
+  //! @param chunks path chunks, chunk i being the name of container ids[i + 1]
+  //! @param ids ids of all the containers on the path including the root and
+  //!        the container itself, only the first ids.size() - 1 chunks are
+  //!        used
+  //! @param removal_seq removal sequence number taken before the resolution,
+  //!        translations of containers removed since then are not cached
+  //----------------------------------------------------------------------------
+  void insert(const std::deque<std::string>& chunks,
+              const std::vector<uint64_t>& ids, uint64_t removal_seq);
+
+  //----------------------------------------------------------------------------
+  //! Notify all the caches that the given container was removed from its
+  //! parent (deleted, renamed or moved) or that it changed remotely
+  //----------------------------------------------------------------------------
+  static void notifyRemoval(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Drop all cached entries
+  //----------------------------------------------------------------------------
+  void clear();
+
+  //----------------------------------------------------------------------------
+  //! Statistics
+  //----------------------------------------------------------------------------
+  uint64_t getNumHits() const;
+  uint64_t getNumMisses() const;
+
+  size_t size() const;
+
+private:
+  //! Cached translation
+  struct Entry {
+    Entry(uint64_t h, uint64_t p, const std::string& n, uint64_t c):
+      hash(h), parent(p), name(n), cid(c), referenced(false) {}
+
+    Entry(Entry&& other) noexcept:
+      hash(other.hash), parent(other.parent), name(std::move(other.name)),
+      cid(other.cid), referenced(other.referenced.load()) {}
+
+    Entry& operator=(Entry&& other) noexcept
+    {
+      hash = other.hash;
+      parent = other.parent;
+      name = std::move(other.name);
+      cid = other.cid;
+      referenced = other.referenced.load();
+      return *this;
+    }
+
+    uint64_t hash; ///< Hash of the parent id and name
+    uint64_t parent; ///< Parent container id
+    std::string name; ///< Container name
+    uint64_t cid; ///< Container id
+    //! Used since the clock hand last passed, set under the shared lock
+    mutable std::atomic<bool> referenced;
+  };
+
+  //! Independently locked part of the translations. Lookups take the lock in
+  //! shared mode, modifications in exclusive mode.
+  struct Shard {
+    mutable std::shared_timed_mutex mMutex;
+    //! Entries in clock order
+    std::vector<Entry> mClock;
+    //! Translation hash to position in mClock
+    std::unordered_map<uint64_t, size_t> mEntries;
+    //! Next eviction candidate in mClock
+    size_t mHand {0};
+    //! Lookups ending (hits) or failing (misses) in this shard, kept per
+    //! shard so that the counters do not become a contention point
+    std::atomic<uint64_t> mHits {0};
+    std::atomic<uint64_t> mMisses {0};
+  };
+
+  //! State of a container referenced by the translations
+  struct ChildState {
+    uint64_t hash; ///< Hash of the translation leading to the container
+    uint64_t removed_seq; ///< Removal sequence number, 0 if not removed
+  };
+
+  //! Independently locked index from container id to its translation,
+  //! including the tombstones of the removed containers
+  struct ChildShard {
+    std::mutex mMutex;
+    std::unordered_map<uint64_t, ChildState> mChildren;
+    size_t mNumTombstones {0};
+    //! Highest sequence number of the purged tombstones
+    uint64_t mPurgedSeq {0};
+  };
+
+  //----------------------------------------------------------------------------
+  //! Handle removal of the given container
+  //----------------------------------------------------------------------------
+  void handleRemoval(uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Drop the translation with the given hash if it leads to the container
+  //----------------------------------------------------------------------------
+  void dropEntry(uint64_t hash, uint64_t cid);
+
+  //----------------------------------------------------------------------------
+  //! Drop the index entry of a container whose translation was evicted
+  //----------------------------------------------------------------------------
+  void dropChild(uint64_t cid, uint64_t hash);
+
+  //----------------------------------------------------------------------------
+  //! Pick the entry to evict from a full shard, clearing the referenced bit of
+  //! the entries passed over. Requires the shard lock in exclusive mode.
+  //!
+  //! @return position of the victim in the clock
+  //----------------------------------------------------------------------------
+  static size_t pickVictim(Shard& shard);
+
+  //----------------------------------------------------------------------------
+  //! Remove the entry at the given position of the clock. Requires the shard
+  //! lock in exclusive mode.
+  //----------------------------------------------------------------------------
+  static void removeAt(Shard& shard, size_t pos);
+
+  //----------------------------------------------------------------------------
+  //! Get shard responsible for the given translation hash
+  //----------------------------------------------------------------------------
+  inline Shard& getShard(uint64_t hash)
+  {
+    return mShards[hash % sNumShards];
+  }
+
+  //----------------------------------------------------------------------------
+  //! Get shard responsible for the given container id
+  //----------------------------------------------------------------------------
+  inline ChildShard& getChildShard(uint64_t cid)
+  {
+    return mChildShards[cid % sNumShards];
+  }
+
+  Shard mShards[sNumShards];
+  ChildShard mChildShards[sNumShards];
+  std::atomic<uint64_t> mMaxPerShard;
+  std::atomic<uint64_t> mRemovalSeq {0};
+
+  //! Registry of all the caches in the process, used for the notifications.
+  //! Notifications only take the lock in shared mode.
+  struct Registry {
+    std::shared_timed_mutex mMutex;
+    std::set<ContainerPathCache*> mCaches;
+  };
+
+  //----------------------------------------------------------------------------
+  //! Get the registry, never destroyed so that caches outliving the static
+  //! objects can still unregister
+  //----------------------------------------------------------------------------
+  static Registry& getRegistry();
+};
+
+EOSNSNAMESPACE_END
+
+#endif // __EOS_NS_CONTAINER_PATH_CACHE_HH__
@@ -18,8 +18,10 @@
 
 #include "common/Logging.hh"
 #include "common/Assert.hh"
+#include "common/ParseUtils.hh"
 #include "namespace/ns_quarkdb/views/HierarchicalView.hh"
 #include "namespace/Constants.hh"
+#include "namespace/ns_quarkdb/Constants.hh"
 #include "namespace/interface/IContainerMDSvc.hh"
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/ns_quarkdb/persistency/ContainerMDSvc.hh"
@@ -42,7 +44,8 @@ EOSNSNAMESPACE_BEGIN
 //------------------------------------------------------------------------------
 QuarkHierarchicalView::QuarkHierarchicalView(qclient::QClient *qcl, MetadataFlusher *flusher)
   : pQcl(qcl), pQuotaFlusher(flusher), pContainerSvc(nullptr), pFileSvc(nullptr),
-    pQuotaStats(new QuarkQuotaStats(pQcl, pQuotaFlusher)), pRoot(nullptr)
+    pQuotaStats(new QuarkQuotaStats(pQcl, pQuotaFlusher)), pRoot(nullptr),
+    mPathCache(sDefaultPathCacheSize)
 {
   pExecutor.reset(new folly::IOThreadPoolExecutor(32));
 }
@@ -76,6 +79,20 @@ QuarkHierarchicalView::configure(const std::map<std::string, std::string>& confi
   delete pQuotaStats;
   pQuotaStats = new QuarkQuotaStats(pQcl, pQuotaFlusher);
   pQuotaStats->configure(config);
+  auto it = config.find(constants::sMaxNumCachePaths);
+
+  if (it != config.end()) {
+    uint64_t max_paths = 0;
+
+    if (!eos::common::ParseUInt64(it->second, max_paths)) {
+      MDException e(EINVAL);
+      e.getMessage() << "Invalid " << constants::sMaxNumCachePaths << " value: "
+                     << it->second;
+      throw e;
+    }
+
+    mPathCache.setMaxEntries(max_paths);
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -183,11 +200,7 @@ QuarkHierarchicalView::getItem(const std::string& uri, bool follow)
   // Build our deque of pending chunks...
   //----------------------------------------------------------------------------
   std::deque<std::string> pendingChunks = eos::PathProcessor::insertChunksIntoDeque(uri);
-  //----------------------------------------------------------------------------
-  // Initial state: We're at "/", and have to look up all chunks.
-  //----------------------------------------------------------------------------
-  FileOrContainerMD initialState {nullptr, pRoot};
-  return getPathInternal(initialState, pendingChunks, follow, 0);
+  return getPathCached(std::move(pendingChunks), follow);
 }
 
 //------------------------------------------------------------------------------
@@ -235,6 +248,141 @@ QuarkHierarchicalView::getPathDeferred(folly::Future<IContainerMDPtr> fut,
                          follow, expendedEffort));
 }
 
+//------------------------------------------------------------------------------
+// Lookup a given path starting from the longest cached container prefix
+//------------------------------------------------------------------------------
+folly::Future<FileOrContainerMD>
+QuarkHierarchicalView::getPathCached(std::deque<std::string> chunks,
+                                     bool follow)
+{
+  //----------------------------------------------------------------------------
+  // Only plain paths go through the cache, "." and ".." need the full walk.
+  //----------------------------------------------------------------------------
+  bool cacheable = mPathCache.isEnabled() && !chunks.empty();
+
+  for (size_t i = 0; cacheable && (i < chunks.size()); ++i) {
+    if (chunks[i] == "." || chunks[i] == "..") {
+      cacheable = false;
+    }
+  }
+
+  if (!cacheable) {
+    return getPathInternal(FileOrContainerMD {nullptr, pRoot}, std::move(chunks),
+                           follow, 0);
+  }
+
+  //----------------------------------------------------------------------------
+  // Taken before the lookup so that concurrent removals prevent caching
+  // a stale result.
+  //----------------------------------------------------------------------------
+  const uint64_t removalSeq = mPathCache.getRemovalSequence();
+  uint64_t cid = 0;
+  size_t covered = mPathCache.lookup(chunks, chunks.size(), cid);
+  folly::Future<FileOrContainerMD> result = folly::Future<FileOrContainerMD>::makeEmpty();
+
+  if (covered == 0) {
+    result = getPathInternal(FileOrContainerMD {nullptr, pRoot}, chunks,
+                             follow, 0);
+  } else {
+    std::deque<std::string> pendingChunks(chunks.begin() + covered,
+                                          chunks.end());
+    folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(cid);
+
+    if (fut.isReady() && !fut.hasException()) {
+      result = getPathInternal(FileOrContainerMD {nullptr, std::move(fut).get()},
+                               std::move(pendingChunks), follow, 0);
+    } else {
+      //------------------------------------------------------------------------
+      // Single round trip for the cached container instead of one per path
+      // component. If it vanished in the meantime do the full lookup.
+      //------------------------------------------------------------------------
+      result = std::move(fut).via(pExecutor.get())
+      .thenTry([this, chunks, pendingChunks, follow](folly::Try<IContainerMDPtr>&&
+      cont) {
+        if (cont.hasException() || !cont.value()) {
+          return getPathInternal(FileOrContainerMD {nullptr, pRoot}, chunks,
+                                 follow, 0);
+        }
+
+        return getPathInternal(FileOrContainerMD {nullptr, cont.value()},
+                               pendingChunks, follow, 0);
+      });
+    }
+
+    if (covered == chunks.size()) {
+      // Nothing more to learn, the whole path is already cached
+      return result;
+    }
+  }
+
+  return std::move(result).thenValue([this, chunks = std::move(chunks),
+  covered, removalSeq](FileOrContainerMD item) {
+    populatePathCache(chunks, covered, item, removalSeq);
+    return item;
+  });
+}
+
+//------------------------------------------------------------------------------
+// Add the container holding the given item to the path cache
+//------------------------------------------------------------------------------
+void
+QuarkHierarchicalView::populatePathCache(const std::deque<std::string>& chunks,
+    size_t covered, const FileOrContainerMD& item, uint64_t removal_seq)
+{
+  IContainerMDPtr cont;
+  size_t depth = chunks.size();
+
+  if (item.container) {
+    cont = item.container;
+  } else if (item.file && (depth > covered + 1)) {
+    folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(
+                                           item.file->getContainerId());
+
+    if (!fut.isReady() || fut.hasException()) {
+      return;
+    }
+
+    cont = std::move(fut).get();
+    --depth;
+  } else {
+    return;
+  }
+
+  if (depth <= covered) {
+    return;
+  }
+
+  //----------------------------------------------------------------------------
+  // Walk up to the root, the names must match the requested chunks otherwise
+  // the lookup went through a symlink. Don't trigger any network requests,
+  // the ancestors of a freshly resolved container are normally in memory.
+  //----------------------------------------------------------------------------
+  std::vector<uint64_t> ids(depth + 1);
+
+  for (size_t i = depth; i > 0; --i) {
+    if (!cont || (cont->getId() == 1) || (cont->getName() != chunks[i - 1])) {
+      return;
+    }
+
+    ids[i] = cont->getId();
+    folly::Future<IContainerMDPtr> fut = pContainerSvc->getContainerMDFut(
+                                           cont->getParentId());
+
+    if (!fut.isReady() || fut.hasException()) {
+      return;
+    }
+
+    cont = std::move(fut).get();
+  }
+
+  if (!cont || (cont->getId() != 1)) {
+    return;
+  }
+
+  ids[0] = cont->getId();
+  mPathCache.insert(chunks, ids, removal_seq);
+}
+
 //------------------------------------------------------------------------------
 // Lookup a given path - internal function.
 //------------------------------------------------------------------------------
@@ -427,8 +575,7 @@ QuarkHierarchicalView::createFile(const std::string& uri, uid_t uid, gid_t gid,
 
   std::string lastChunk = chunks.back();
   chunks.pop_back();
-  FileOrContainerMD item = getPathInternal(FileOrContainerMD {nullptr, pRoot},
-                           chunks, true, 0).get();
+  FileOrContainerMD item = getPathCached(std::move(chunks), true).get();
 
   if (item.file) {
     throw_mdexception(ENOTDIR, "Not a directory");
@@ -678,8 +825,7 @@ QuarkHierarchicalView::getPathExpectContainer(const std::deque<std::string>& chu
     return pRoot;
   }
 
-  return getPathInternal(FileOrContainerMD {nullptr, pRoot}, chunks, true, 0)
-         .thenValue(extractContainerMD);
+  return getPathCached(chunks, true).thenValue(extractContainerMD);
 }
 
 //------------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include "namespace/interface/IFileMDSvc.hh"
 #include "namespace/interface/IView.hh"
 #include "namespace/ns_quarkdb/accounting/QuotaStats.hh"
+#include "namespace/ns_quarkdb/views/ContainerPathCache.hh"
 
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wunused-private-field"
@@ -299,7 +300,36 @@ public:
   virtual folly::Future<IContainerMDPtr> getParentContainer(
     IFileMD *file) override;
 
+  //----------------------------------------------------------------------------
+  //! Get path to container id cache
+  //----------------------------------------------------------------------------
+  const ContainerPathCache& getPathCache() const {
+    return mPathCache;
+  }
+
 private:
+  //! Default number of cached path to container id translations
+  static constexpr uint64_t sDefaultPathCacheSize = 1000000;
+
+  //----------------------------------------------------------------------------
+  //! Lookup a given path starting from the longest prefix found in the path
+  //! cache, populate the cache with the result.
+  //----------------------------------------------------------------------------
+  folly::Future<FileOrContainerMD>
+  getPathCached(std::deque<std::string> chunks, bool follow);
+
+  //----------------------------------------------------------------------------
+  //! Add the container holding the given item to the path cache if its path
+  //! is canonical and all its ancestors are in memory
+  //!
+  //! @param chunks path chunks used for the lookup
+  //! @param covered number of chunks already resolved from the cache
+  //! @param item lookup result
+  //! @param removal_seq path cache removal sequence before the lookup
+  //----------------------------------------------------------------------------
+  void populatePathCache(const std::deque<std::string>& chunks, size_t covered,
+    const FileOrContainerMD& item, uint64_t removal_seq);
+
   //----------------------------------------------------------------------------
   //! Lookup a given path - internal function.
   //----------------------------------------------------------------------------
@@ -368,6 +398,7 @@ private:
   IQuotaStats* pQuotaStats;
   std::shared_ptr<IContainerMD> pRoot;
   std::unique_ptr<folly::Executor> pExecutor;
+  ContainerPathCache mPathCache; ///< Path to container id translations
 };
 
 EOSNSNAMESPACE_END
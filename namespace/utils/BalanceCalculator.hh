@@ -85,7 +85,7 @@ public:
   //----------------------------------------------------------------------------
   //! Print a summary into the given stream
   //----------------------------------------------------------------------------
-  void printSummary(std::ofstream &ss)
+  void printSummary(std::ostream &ss)
   {
     XrdOucString sizestring = "";
 
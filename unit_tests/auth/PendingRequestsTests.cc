@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+// File: PendingRequestsTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "auth_plugin/PendingRequests.hh"
+
+using eos::auth::PendingRequests;
+
+//! Stand-in for the MGM backend
+struct FakeBackend {};
+using Pending = PendingRequests<FakeBackend>;
+
+//------------------------------------------------------------------------------
+// Replies are delivered to the callback of the request with the same id, also
+// when they arrive out of order
+//------------------------------------------------------------------------------
+TEST(PendingRequests, MatchReplyIds)
+{
+  Pending pending;
+  auto deadline = Pending::Clock::now() + std::chrono::seconds(60);
+  std::map<uint64_t, std::string> replies;
+
+  for (uint64_t id = 1; id <= 3; ++id) {
+    pending.Add(id, [id, &replies](const std::string * reply) {
+      replies[id] = (reply ? *reply : "none");
+    }, deadline);
+  }
+
+  ASSERT_EQ(3u, pending.Size());
+  Pending::Callback callback;
+
+  for (uint64_t id : {
+         3, 1, 2
+       }) {
+    ASSERT_TRUE(pending.Take(id, callback));
+    std::string reply = "reply" + std::to_string(id);
+    callback(&reply);
+  }
+
+  ASSERT_EQ(0u, pending.Size());
+  ASSERT_EQ((std::map<uint64_t, std::string> {
+    {1, "reply1"}, {2, "reply2"}, {3, "reply3"}
+  }), replies);
+  // A second reply with the same id or an unknown id is dropped
+  ASSERT_FALSE(pending.Take(2, callback));
+  ASSERT_FALSE(pending.Take(42, callback));
+}
+
+//------------------------------------------------------------------------------
+// Requests without reply by their deadline are taken out, later replies are
+// dropped
+//------------------------------------------------------------------------------
+TEST(PendingRequests, Expire)
+{
+  Pending pending;
+  auto now = Pending::Clock::now();
+  int calls = 0;
+  pending.Add(1, [&calls](const std::string*) {
+    ++calls;
+  }, now - std::chrono::seconds(1));
+  pending.Add(2, [&calls](const std::string*) {
+    ++calls;
+  }, now + std::chrono::seconds(60));
+  pending.Add(3, [&calls](const std::string*) {
+    ++calls;
+  }, now);
+  auto expired = pending.TakeExpired(now);
+  ASSERT_EQ(2u, expired.size());
+  ASSERT_EQ(1u, expired[0].first);
+  ASSERT_EQ(3u, expired[1].first);
+  ASSERT_EQ(0, calls);
+  ASSERT_EQ(1u, pending.Size());
+  Pending::Callback callback;
+  ASSERT_FALSE(pending.Take(1, callback));
+  ASSERT_TRUE(pending.Take(2, callback));
+  // Removed requests are dropped without calling back
+  pending.Add(4, [&calls](const std::string*) {
+    ++calls;
+  }, now);
+  pending.Remove(4);
+  ASSERT_EQ(0u, pending.Size());
+  ASSERT_EQ(0, calls);
+}
+
+//------------------------------------------------------------------------------
+// On a master switch only the requests sent to the previous master are taken,
+// the ones not sent yet go to the new master
+//------------------------------------------------------------------------------
+TEST(PendingRequests, MasterSwitch)
+{
+  Pending pending;
+  FakeBackend mgm1, mgm2;
+  auto deadline = Pending::Clock::now() + std::chrono::seconds(60);
+  std::vector<uint64_t> called;
+
+  for (uint64_t id = 1; id <= 4; ++id) {
+    pending.Add(id, [id, &called](const std::string*) {
+      called.push_back(id);
+    }, deadline);
+  }
+
+  pending.SetBackend(1, &mgm1);
+  pending.SetBackend(2, &mgm2);
+  pending.SetBackend(3, &mgm1);
+  // Unknown ids are ignored
+  pending.SetBackend(42, &mgm1);
+  auto taken = pending.TakeSentToOthers(&mgm2);
+  ASSERT_EQ(2u, taken.size());
+
+  for (auto& callback : taken) {
+    callback(nullptr);
+  }
+
+  ASSERT_EQ((std::vector<uint64_t> {1, 3}), called);
+  ASSERT_EQ(2u, pending.Size());
+  Pending::Callback callback;
+  ASSERT_FALSE(pending.Take(1, callback));
+  ASSERT_TRUE(pending.Take(2, callback));
+  ASSERT_TRUE(pending.Take(4, callback));
+}
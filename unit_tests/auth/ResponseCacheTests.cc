@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+// File: ResponseCacheTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "auth_plugin/ResponseCache.hh"
+#include <thread>
+
+using eos::auth::ResponseCache;
+
+//------------------------------------------------------------------------------
+// Nothing is cached until a time to live is set
+//------------------------------------------------------------------------------
+TEST(ResponseCache, DisabledByDefault)
+{
+  ResponseCache cache;
+  std::string value;
+  ASSERT_FALSE(cache.IsEnabled());
+  cache.Put("stat:/eos/file:user", "reply");
+  ASSERT_EQ(0u, cache.Size());
+  ASSERT_FALSE(cache.Get("stat:/eos/file:user", value));
+}
+
+//------------------------------------------------------------------------------
+// Replies are returned per key until they expire
+//------------------------------------------------------------------------------
+TEST(ResponseCache, GetPutExpire)
+{
+  ResponseCache cache;
+  std::string value;
+  cache.SetTtl(std::chrono::milliseconds(100));
+  ASSERT_TRUE(cache.IsEnabled());
+  cache.Put("stat:/eos/file:user1", "reply1");
+  cache.Put("stat:/eos/file:user2", "reply2");
+  ASSERT_TRUE(cache.Get("stat:/eos/file:user1", value));
+  ASSERT_EQ("reply1", value);
+  ASSERT_TRUE(cache.Get("stat:/eos/file:user2", value));
+  ASSERT_EQ("reply2", value);
+  ASSERT_FALSE(cache.Get("exists:/eos/file:user1", value));
+  // Overwriting refreshes the reply
+  cache.Put("stat:/eos/file:user1", "reply3");
+  ASSERT_TRUE(cache.Get("stat:/eos/file:user1", value));
+  ASSERT_EQ("reply3", value);
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  ASSERT_FALSE(cache.Get("stat:/eos/file:user1", value));
+  ASSERT_FALSE(cache.Get("stat:/eos/file:user2", value));
+  // Expired entries are dropped once looked up
+  ASSERT_EQ(0u, cache.Size());
+}
+
+//------------------------------------------------------------------------------
+// Clearing and changing the time to live drop all the replies
+//------------------------------------------------------------------------------
+TEST(ResponseCache, Clear)
+{
+  ResponseCache cache;
+  std::string value;
+  cache.SetTtl(std::chrono::seconds(10));
+  cache.Put("a", "1");
+  cache.Put("b", "2");
+  ASSERT_EQ(2u, cache.Size());
+  cache.Clear();
+  ASSERT_EQ(0u, cache.Size());
+  ASSERT_FALSE(cache.Get("a", value));
+  cache.Put("a", "1");
+  cache.SetTtl(std::chrono::seconds(20));
+  ASSERT_EQ(0u, cache.Size());
+  cache.SetTtl(std::chrono::milliseconds(0));
+  ASSERT_FALSE(cache.IsEnabled());
+  cache.Put("a", "1");
+  ASSERT_FALSE(cache.Get("a", value));
+}
+
+//------------------------------------------------------------------------------
+// The number of entries is bounded, expired entries are dropped first
+//------------------------------------------------------------------------------
+TEST(ResponseCache, MaxEntries)
+{
+  ResponseCache cache(3);
+  std::string value;
+  cache.SetTtl(std::chrono::milliseconds(200));
+  cache.Put("a", "1");
+  cache.Put("b", "2");
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  cache.Put("c", "3");
+  ASSERT_EQ(3u, cache.Size());
+  // Full, only the expired entries are dropped
+  cache.Put("d", "4");
+  ASSERT_EQ(2u, cache.Size());
+  ASSERT_TRUE(cache.Get("c", value));
+  ASSERT_EQ("3", value);
+  cache.Put("e", "5");
+  ASSERT_EQ(3u, cache.Size());
+  // Full with valid entries, everything is dropped
+  cache.Put("f", "6");
+  ASSERT_EQ(1u, cache.Size());
+  ASSERT_FALSE(cache.Get("c", value));
+  ASSERT_TRUE(cache.Get("f", value));
+  ASSERT_EQ("6", value);
+}
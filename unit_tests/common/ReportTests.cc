@@ -0,0 +1,98 @@
+//------------------------------------------------------------------------------
+//! @file ReportTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/Report.hh"
+
+TEST(Report, BinaryRoundTrip)
+{
+  XrdOucEnv env("log=abc&path=/eos/a/b&ruid=12&rgid=13&td=user.1:2@host"
+                "&host=fst1.cern.ch&lid=1048850&fid=1a2b&fsid=3&ots=100"
+                "&otms=5&cts=200&ctms=7000&rb=1000&wb=55&rt=1.5"
+                "&sec.host=lxplus1.cern.ch&sec.app=fuse");
+  eos::common::Report report(env);
+  std::string bin = report.ToBinary();
+  ASSERT_TRUE(eos::common::Report::IsBinary(bin));
+  ASSERT_FALSE(eos::common::Report::IsBinary("log=abc&path=/eos/a/b"));
+  auto decoded = eos::common::Report::FromBinary(bin);
+  ASSERT_TRUE(decoded != nullptr);
+  ASSERT_EQ("/eos/a/b", decoded->path);
+  ASSERT_EQ(0x1a2bull, decoded->fid);
+  ASSERT_EQ(1000u, decoded->rb);
+  ASSERT_EQ(55u, decoded->wb);
+  ASSERT_EQ(12u, decoded->uid);
+  ASSERT_EQ(13u, decoded->gid);
+  ASSERT_EQ(7000u, decoded->ctms);
+  ASSERT_EQ("fst1", decoded->server_name);
+  ASSERT_EQ("lxplus1", decoded->sec_host);
+  ASSERT_EQ("cern.ch", decoded->sec_domain);
+  ASSERT_EQ("fuse", decoded->sec_app);
+  ASSERT_FLOAT_EQ(1.5, decoded->rt);
+  // The env representation parses back to the same report
+  XrdOucEnv env2(decoded->ToEnvString().c_str());
+  eos::common::Report report2(env2);
+  ASSERT_EQ(bin, report2.ToBinary());
+  // Binary form is more compact than the env one
+  ASSERT_LT(bin.length(), decoded->ToEnvString().length());
+  // Truncated input is rejected
+  ASSERT_TRUE(eos::common::Report::FromBinary(bin.substr(0, 20)) == nullptr);
+}
+
+TEST(Report, EnvRoundTrip)
+{
+  // Report as built by XrdFstOfsFile::MakeReportEnv
+  XrdOucEnv env("log=abc&path=/eos/a/b&fstpath=/data01/00000000/0001a2b"
+                "&ruid=12&rgid=13&td=user.1:2@host&host=fst1.cern.ch"
+                "&lid=1048850&fid=1a2b&fsid=3&ots=100&otms=5&cts=200&ctms=700"
+                "&nrc=4&nwc=2&rb=1000&rb_min=10&rb_max=500&rb_sigma=12.25"
+                "&rv_op=1&rvb_min=3&rvb_max=4&rvb_sum=7&rvb_sigma=0.5"
+                "&rs_op=2&rsb_min=1&rsb_max=2&rsb_sum=3&rsb_sigma=0.75"
+                "&rc_min=1&rc_max=3&rc_sum=4&rc_sigma=1.5"
+                "&wb=55&wb_min=5&wb_max=50&wb_sigma=2.5"
+                "&sfwdb=1&sbwdb=2&sxlfwdb=3&sxlbwdb=4&nfwds=5&nbwds=6"
+                "&nxlfwds=7&nxlbwds=8&rt=1.5&rvt=0.25&wt=3.75&osize=9&csize=10"
+                "&delete_on_close=1&prio_c=2&prio_l=4&prio_d=1&forced_bw=100"
+                "&ms_sleep=42&sec.prot=krb5&sec.name=user&sec.host=lxplus1.cern.ch"
+                "&sec.vorg=vo&sec.grps=grp&sec.role=role&sec.info=info"
+                "&sec.app=fuse&tpc.src=src&tpc.dst=dst&tpc.src_lfn=/eos/src"
+                "&dsize=11&dc_t=12&dc_tns=13&dm_t=14&dm_tns=15&da_t=16"
+                "&da_tns=17");
+  eos::common::Report report(env);
+  ASSERT_EQ("/data01/00000000/0001a2b", report.fstpath);
+  ASSERT_EQ(1, report.delete_on_close);
+  ASSERT_EQ(42u, report.ms_sleep);
+  ASSERT_EQ("grp", report.sec_grps);
+  ASSERT_EQ(16u, report.da_ts);
+  ASSERT_DOUBLE_EQ(12.25, report.rb_sigma);
+  ASSERT_DOUBLE_EQ(1.5, report.rc_sigma);
+  // Every field survives the env and the binary representations
+  XrdOucEnv env2(report.ToEnvString().c_str());
+  eos::common::Report report2(env2);
+  ASSERT_EQ(report.ToEnvString(), report2.ToEnvString());
+  ASSERT_EQ(report.ToBinary(), report2.ToBinary());
+  auto decoded = eos::common::Report::FromBinary(report.ToBinary());
+  ASSERT_TRUE(decoded != nullptr);
+  ASSERT_EQ(report.ToEnvString(), decoded->ToEnvString());
+  ASSERT_EQ("/data01/00000000/0001a2b", decoded->fstpath);
+  ASSERT_EQ(100, decoded->forced_bw);
+  ASSERT_EQ(2, decoded->prio_c);
+}
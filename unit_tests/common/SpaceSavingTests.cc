@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+//! @file SpaceSavingTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "common/SpaceSaving.hh"
+
+TEST(SpaceSaving, ExactBelowCapacity)
+{
+  eos::common::SpaceSaving<uint64_t> sketch(8);
+
+  for (uint64_t i = 1; i <= 5; ++i) {
+    for (uint64_t j = 0; j < i; ++j) {
+      sketch.Add(i);
+    }
+  }
+
+  ASSERT_EQ(5u, sketch.Size());
+  ASSERT_EQ(15u, sketch.Total());
+  auto top = sketch.GetTop(3);
+  ASSERT_EQ(3u, top.size());
+  ASSERT_EQ(5u, top[0].key);
+  ASSERT_EQ(5u, top[0].count);
+  ASSERT_EQ(0u, top[0].error);
+  ASSERT_EQ(4u, top[1].key);
+  ASSERT_EQ(3u, top[2].key);
+  ASSERT_EQ(2u, sketch.GetCount(2));
+  ASSERT_EQ(0u, sketch.GetCount(42));
+  ASSERT_TRUE(sketch.GetTop(0).empty());
+  ASSERT_EQ(5u, sketch.GetTop(100).size());
+}
+
+TEST(SpaceSaving, HeavyHittersSurviveEviction)
+{
+  eos::common::SpaceSaving<uint64_t> sketch(4);
+
+  // Two heavy keys interleaved with a long tail of distinct keys
+  for (uint64_t i = 0; i < 1000; ++i) {
+    sketch.Add(1, 10);
+    sketch.Add(2, 5);
+    sketch.Add(1000 + i);
+  }
+
+  ASSERT_EQ(4u, sketch.Size());
+  auto top = sketch.GetTop(2);
+  ASSERT_EQ(1u, top[0].key);
+  ASSERT_EQ(2u, top[1].key);
+  ASSERT_GE(top[0].count, 10000u);
+  ASSERT_LE(top[0].count - top[0].error, 10000u);
+  ASSERT_GE(top[1].count, 5000u);
+}
+
+TEST(SpaceSaving, Decay)
+{
+  eos::common::SpaceSaving<std::string> sketch(4);
+  sketch.Add("a", 8);
+  sketch.Add("b", 1);
+  sketch.Decay(1);
+  ASSERT_EQ(1u, sketch.Size());
+  ASSERT_EQ(4u, sketch.GetCount("a"));
+  ASSERT_EQ(0u, sketch.GetCount("b"));
+  sketch.Add("c", 2);
+  auto top = sketch.GetTop(4);
+  ASSERT_EQ(2u, top.size());
+  ASSERT_EQ("a", top[0].key);
+  ASSERT_EQ("c", top[1].key);
+  sketch.Decay(64);
+  ASSERT_EQ(0u, sketch.Size());
+  ASSERT_EQ(0u, sketch.Total());
+}
@@ -0,0 +1,155 @@
+//------------------------------------------------------------------------------
+// File: CopyPipelineTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/io/CopyPipeline.hh"
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <string>
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Source data used by the tests
+//------------------------------------------------------------------------------
+std::string MakeSource(size_t size)
+{
+  std::string data(size, '\0');
+
+  for (size_t i = 0; i < size; ++i) {
+    data[i] = (char)((i * 7 + i / 13) & 0xff);
+  }
+
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Positional read from the source, at most max_read bytes at once
+//------------------------------------------------------------------------------
+eos::fst::CopyPipeline::ReadCallback
+MakeReader(const std::string& src, uint32_t max_read = UINT32_MAX)
+{
+  return [&src, max_read](uint64_t off, char* buff, uint32_t len) -> int64_t {
+    if (off >= src.size())
+    {
+      return 0;
+    }
+
+    size_t n = std::min<size_t>({len, max_read, src.size() - off});
+    memcpy(buff, src.data() + off, n);
+    return n;
+  };
+}
+}
+
+//------------------------------------------------------------------------------
+// Copy with sequential and parallel readers, whole file and ranges
+//------------------------------------------------------------------------------
+TEST(CopyPipeline, Copy)
+{
+  const std::string src = MakeSource(1000 * 1000 + 17);
+
+  for (uint32_t streams : {
+         1, 3
+       }) {
+    for (uint32_t depth : {
+           1, 2, 8
+         }) {
+      for (int64_t length : {
+             (int64_t) - 1, (int64_t) 0, (int64_t) 4096, (int64_t) 300001
+           }) {
+        const uint64_t offset = (length < 0) ? 0 : 123;
+        eos::fst::CopyPipeline pipeline(4096, depth, streams);
+        std::string dst;
+        std::string digested;
+        uint64_t expected_off = offset;
+        pipeline.SetDigest([&](uint64_t off, const char* buff, uint32_t len) {
+          digested.append(buff, len);
+        });
+        int rc = pipeline.Run(offset, length, MakeReader(src),
+        [&](uint64_t off, const char* buff, uint32_t len) {
+          EXPECT_EQ(expected_off, off);
+          expected_off += len;
+          dst.append(buff, len);
+          return true;
+        });
+        ASSERT_EQ(0, rc);
+        const std::string expected = (length < 0) ? src :
+                                     src.substr(offset, length);
+        ASSERT_EQ(expected, dst) << "streams=" << streams << " depth=" << depth
+                                 << " length=" << length;
+        ASSERT_EQ(expected, digested);
+        ASSERT_EQ(expected.size(), pipeline.GetStats().mBytes);
+      }
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Sequential readers must continue after short reads
+//------------------------------------------------------------------------------
+TEST(CopyPipeline, ShortReads)
+{
+  const std::string src = MakeSource(100 * 1000);
+  eos::fst::CopyPipeline pipeline(4096, 4, 1);
+  std::string dst;
+  int rc = pipeline.Run(0, -1, MakeReader(src, 1000),
+  [&](uint64_t off, const char* buff, uint32_t len) {
+    dst.append(buff, len);
+    return true;
+  });
+  ASSERT_EQ(0, rc);
+  ASSERT_EQ(src, dst);
+}
+
+//------------------------------------------------------------------------------
+// Read and write errors abort the copy
+//------------------------------------------------------------------------------
+TEST(CopyPipeline, Errors)
+{
+  const std::string src = MakeSource(100 * 1000);
+  auto reader = MakeReader(src);
+
+  for (uint32_t streams : {
+         1, 4
+       }) {
+    eos::fst::CopyPipeline pipeline(4096, 4, streams);
+    uint64_t written = 0;
+    int rc = pipeline.Run(0, -1, [&](uint64_t off, char* buff, uint32_t len) {
+      return (off >= 8192) ? -1 : reader(off, buff, len);
+    }, [&](uint64_t off, const char* buff, uint32_t len) {
+      written += len;
+      return true;
+    });
+    ASSERT_EQ(-EIO, rc);
+    ASSERT_EQ(8192u, pipeline.GetFailedOffset());
+    ASSERT_EQ(8192u, written);
+    int nwrites = 0;
+    rc = pipeline.Run(0, -1, reader,
+    [&](uint64_t off, const char* buff, uint32_t len) {
+      return (++nwrites < 3);
+    });
+    ASSERT_EQ(-ECANCELED, rc);
+    ASSERT_EQ(3, nwrites);
+  }
+}
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+// File: FmdDbMapTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/FmdDbMap.hh"
+#include <thread>
+
+using eos::fst::gFmdDbMapHandler;
+
+//------------------------------------------------------------------------------
+//! Fixture providing a DB for one file system in a temporary directory
+//------------------------------------------------------------------------------
+class FmdDbMapTests : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    char tmp_dir[] = "/tmp/eos.fmd.XXXXXX";
+    ASSERT_TRUE(mkdtemp(tmp_dir) != nullptr);
+    mDir = tmp_dir;
+    ASSERT_TRUE(gFmdDbMapHandler.SetDBFile(mDir.c_str(), mFsid));
+  }
+
+  void TearDown() override
+  {
+    (void) gFmdDbMapHandler.ShutdownDB(mFsid, true);
+    (void) system(("rm -rf " + mDir).c_str());
+  }
+
+  //----------------------------------------------------------------------------
+  //! Create a record with the given disk size
+  //----------------------------------------------------------------------------
+  void CreateFmd(eos::common::FileId::fileid_t fid, uint64_t disk_size)
+  {
+    auto fmd = gFmdDbMapHandler.LocalGetFmd(fid, mFsid, true, true);
+    ASSERT_TRUE(fmd != nullptr);
+    fmd->mProtoFmd.set_disksize(disk_size);
+    ASSERT_TRUE(gFmdDbMapHandler.Commit(fmd.get()));
+  }
+
+  const eos::common::FileSystem::fsid_t mFsid = 5;
+  std::string mDir;
+};
+
+//------------------------------------------------------------------------------
+// Batched updates are visible to lookups before being committed, and are
+// committed once old enough even if no more updates arrive
+//------------------------------------------------------------------------------
+TEST_F(FmdDbMapTests, BatchCommittedByAge)
+{
+  ASSERT_TRUE(gFmdDbMapHandler.BeginBatch(mFsid));
+  ASSERT_FALSE(gFmdDbMapHandler.BeginBatch(mFsid));
+
+  for (eos::common::FileId::fileid_t fid = 1; fid <= 3; ++fid) {
+    CreateFmd(fid, 1000 + fid);
+  }
+
+  ASSERT_NE(0u, gFmdDbMapHandler.GetPendingBatchSize(mFsid));
+  auto fmd = gFmdDbMapHandler.LocalGetFmd(2, mFsid, true, false);
+  ASSERT_TRUE(fmd != nullptr);
+  ASSERT_EQ(1002u, fmd->mProtoFmd.disksize());
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+  while (gFmdDbMapHandler.GetPendingBatchSize(mFsid) &&
+         (std::chrono::steady_clock::now() < deadline)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  ASSERT_EQ(0u, gFmdDbMapHandler.GetPendingBatchSize(mFsid));
+  ASSERT_TRUE(gFmdDbMapHandler.EndBatch(mFsid));
+  ASSERT_FALSE(gFmdDbMapHandler.EndBatch(mFsid));
+  // The records survive reopening the DB
+  ASSERT_TRUE(gFmdDbMapHandler.SetDBFile(mDir.c_str(), mFsid));
+
+  for (eos::common::FileId::fileid_t fid = 1; fid <= 3; ++fid) {
+    fmd = gFmdDbMapHandler.LocalGetFmd(fid, mFsid, true, false);
+    ASSERT_TRUE(fmd != nullptr);
+    ASSERT_EQ(1000 + fid, fmd->mProtoFmd.disksize());
+  }
+}
+
+//------------------------------------------------------------------------------
+// A removal commits the pending batch and is visible right away
+//------------------------------------------------------------------------------
+TEST_F(FmdDbMapTests, RemovalFlushesBatch)
+{
+  ASSERT_TRUE(gFmdDbMapHandler.BeginBatch(mFsid));
+  CreateFmd(10, 1);
+  CreateFmd(11, 2);
+  ASSERT_NE(0u, gFmdDbMapHandler.GetPendingBatchSize(mFsid));
+  gFmdDbMapHandler.LocalDeleteFmd(10, mFsid);
+  ASSERT_EQ(0u, gFmdDbMapHandler.GetPendingBatchSize(mFsid));
+  ASSERT_TRUE(gFmdDbMapHandler.LocalGetFmd(10, mFsid, true, false) == nullptr);
+  auto fmd = gFmdDbMapHandler.LocalGetFmd(11, mFsid, true, false);
+  ASSERT_TRUE(fmd != nullptr);
+  ASSERT_EQ(2u, fmd->mProtoFmd.disksize());
+  ASSERT_TRUE(gFmdDbMapHandler.EndBatch(mFsid));
+}
@@ -0,0 +1,74 @@
+//------------------------------------------------------------------------------
+// File: FmdIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "fst/FmdIndex.hh"
+
+using eos::fst::FmdIndex;
+
+//------------------------------------------------------------------------------
+// Entries are added, updated and removed
+//------------------------------------------------------------------------------
+TEST(FmdIndex, PutGetRemove)
+{
+  FmdIndex index;
+  FmdIndex::Entry entry;
+  ASSERT_FALSE(index.Get(1, entry));
+  index.Put(1, {100, FmdIndex::CompactXs("0a1b2c3d"), 0});
+  index.Put(2, {200, 0, FmdIndex::kSizeError});
+  ASSERT_EQ(2u, index.Size());
+  ASSERT_TRUE(index.Get(1, entry));
+  ASSERT_EQ(100u, entry.mSize);
+  ASSERT_EQ(0x0a1b2c3du, entry.mXs);
+  ASSERT_FALSE(entry.IsInconsistent());
+  index.Put(1, {150, 0, FmdIndex::kXsError});
+  ASSERT_EQ(2u, index.Size());
+  ASSERT_TRUE(index.Get(1, entry));
+  ASSERT_EQ(150u, entry.mSize);
+  ASSERT_TRUE(entry.IsInconsistent());
+  index.Remove(1);
+  ASSERT_FALSE(index.Get(1, entry));
+  ASSERT_EQ(1u, index.Size());
+  index.Clear();
+  ASSERT_EQ(0u, index.Size());
+}
+
+//------------------------------------------------------------------------------
+// Compact checksum and consistency flags
+//------------------------------------------------------------------------------
+TEST(FmdIndex, Flags)
+{
+  ASSERT_EQ(0u, FmdIndex::CompactXs(""));
+  ASSERT_EQ(0xabcu, FmdIndex::CompactXs("ABC"));
+  ASSERT_EQ(0xd41d8cd9u,
+            FmdIndex::CompactXs("d41d8cd98f00b204e9800998ecf8427e"));
+  ASSERT_EQ(0u, FmdIndex::CompactXs("xyz"));
+  FmdIndex::Entry entry;
+  ASSERT_FALSE(entry.IsInconsistent());
+  entry.mFlags = FmdIndex::kBlockXsError;
+  ASSERT_FALSE(entry.IsInconsistent());
+  // RAIN stripes are only refused for block checksum errors
+  entry.mFlags = FmdIndex::kRain | FmdIndex::kSizeError | FmdIndex::kXsError;
+  ASSERT_FALSE(entry.IsInconsistent());
+  entry.mFlags |= FmdIndex::kBlockXsError;
+  ASSERT_TRUE(entry.IsInconsistent());
+}
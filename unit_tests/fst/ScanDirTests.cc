@@ -112,17 +112,46 @@ TEST(ScanDir, AdjustScanRate)
   off_t offset = 0;
   int rate = 75;  // MB/s
   eos::fst::ScanDir sd(path.c_str(), fsid, &load, false, 0, rate, true);
-  uint64_t open_ts_sec = duration_cast<seconds>
-                         (sd.GetClock().getTime().time_since_epoch()).count();
+  uint64_t open_ts_ms = duration_cast<milliseconds>
+                        (sd.GetClock().getTime().time_since_epoch()).count();
   int old_rate = rate;
-  sd.EnforceAndAdjustScanRate(offset, open_ts_sec, rate);
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
   ASSERT_EQ(rate, old_rate);
 
   while (rate > 5) {
     old_rate = rate;
-    sd.EnforceAndAdjustScanRate(offset, open_ts_sec, rate);
+    sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
     ASSERT_EQ(rate, (int)(old_rate * 0.9));
   }
 
   ASSERT_LE(rate, 5);
 }
+
+TEST(ScanDir, RecoverScanRate)
+{
+  using namespace std::chrono;
+  using ::testing::_;
+  using ::testing::Return;
+  // Once the disk is no longer busy the scan_rate recovers gradually up to
+  // the configured maximum
+  MockLoad load;
+  EXPECT_CALL(load, GetDiskRate(_, _)
+             ).WillOnce(Return(800.0)).WillOnce(Return(800.0))
+  .WillRepeatedly(Return(100.0));
+  std::string path {"/"};
+  eos::common::FileSystem::fsid_t fsid = 1;
+  off_t offset = 0;
+  int rate = 75;  // MB/s
+  eos::fst::ScanDir sd(path.c_str(), fsid, &load, false, 0, rate, true);
+  uint64_t open_ts_ms = duration_cast<milliseconds>
+                        (sd.GetClock().getTime().time_since_epoch()).count();
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
+  ASSERT_EQ(60, rate);
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
+  ASSERT_EQ(66, rate);
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
+  ASSERT_EQ(72, rate);
+  sd.EnforceAndAdjustScanRate(offset, open_ts_ms, rate);
+  ASSERT_EQ(75, rate);
+}
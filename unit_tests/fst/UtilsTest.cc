@@ -179,3 +179,44 @@ TEST(OpenFileTracker, SortedByUseCount)
   auto hotFiles3 = oft.getHotFiles(3, 0);
   ASSERT_TRUE(hotFiles3.empty());
 }
+
+TEST(OpenFileTracker, HotFilesSketch)
+{
+  eos::common::SteadyClock clock(true);
+  eos::fst::OpenFileTracker oft(&clock);
+  ASSERT_TRUE(oft.getHotFilesByOpens(3, 10).empty());
+
+  for (size_t i = 0; i < 4; i++) {
+    oft.up(3, 100);
+    oft.down(3, 100);
+  }
+
+  oft.up(3, 101);
+  oft.up(3, 101);
+  oft.up(3, 102);
+  oft.addBytes(3, 102, 4096);
+  oft.addBytes(3, 101, 1024);
+  // Closed files are still reported as hot
+  auto hotFiles = oft.getHotFilesByOpens(3, 2);
+  ASSERT_EQ(hotFiles.size(), 2u);
+  eos::fst::OpenFileTracker::HotEntry entry {3, 100, 4};
+  ASSERT_EQ(hotFiles[0], entry);
+  entry = {3, 101, 2};
+  ASSERT_EQ(hotFiles[1], entry);
+  hotFiles = oft.getHotFilesByBytes(3, 10);
+  ASSERT_EQ(hotFiles.size(), 2u);
+  entry = {3, 102, 4096};
+  ASSERT_EQ(hotFiles[0], entry);
+  entry = {3, 101, 1024};
+  ASSERT_EQ(hotFiles[1], entry);
+  ASSERT_TRUE(oft.getHotFilesByBytes(4, 10).empty());
+  // Counters are halved for every elapsed window
+  clock.advance(eos::fst::OpenFileTracker::sHotDecayWindow * 2);
+  hotFiles = oft.getHotFilesByOpens(3, 10);
+  ASSERT_EQ(hotFiles.size(), 1u);
+  entry = {3, 100, 1};
+  ASSERT_EQ(hotFiles[0], entry);
+  hotFiles = oft.getHotFilesByBytes(3, 10);
+  entry = {3, 102, 1024};
+  ASSERT_EQ(hotFiles[0], entry);
+}
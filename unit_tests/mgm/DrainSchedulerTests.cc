@@ -0,0 +1,213 @@
+//------------------------------------------------------------------------------
+// File: DrainSchedulerTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/drain/DrainScheduler.hh"
+#include <future>
+
+using eos::mgm::DrainScheduler;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Build candidate
+//------------------------------------------------------------------------------
+DrainScheduler::Candidate
+MakeCandidate(uint64_t fid, uint64_t size, uint32_t risk = 0)
+{
+  DrainScheduler::Candidate candidate;
+  candidate.mFid = fid;
+  candidate.mSize = size;
+  candidate.mRisk = risk;
+  return candidate;
+}
+
+//------------------------------------------------------------------------------
+// Build file system placement
+//------------------------------------------------------------------------------
+DrainScheduler::FsInfo
+MakeInfo(const std::string& node, const std::string& group, uint32_t slots)
+{
+  DrainScheduler::FsInfo info;
+  info.mSpace = "default";
+  info.mNode = node;
+  info.mGroup = group;
+  info.mMaxSlots = slots;
+  return info;
+}
+}
+
+//------------------------------------------------------------------------------
+// Files are handed out by risk and size, small files in batches
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, PriorityAndBatching)
+{
+  const uint64_t MB = 1024 * 1024;
+  DrainScheduler scheduler(true);
+  std::vector<DrainScheduler::Batch> launched;
+  scheduler.Register(1, MakeInfo("node1", "default.0", 1),
+  [&](DrainScheduler::Batch && batch) {
+    launched.push_back(batch);
+  });
+  std::vector<DrainScheduler::Candidate> candidates {
+    MakeCandidate(1, 10 * MB), MakeCandidate(2, 100 * MB),
+    MakeCandidate(3, 5 * MB, 1)};
+
+  for (uint64_t fid = 10; fid < 50; ++fid) {
+    candidates.push_back(MakeCandidate(fid, 1024));
+  }
+
+  scheduler.Submit(1, std::move(candidates));
+  // Only one slot - the file missing a replica goes first
+  ASSERT_EQ(1u, launched.size());
+  ASSERT_EQ(1u, launched[0].size());
+  ASSERT_EQ(3u, launched[0][0].mFid);
+  ASSERT_EQ(1u, scheduler.GetRunning(1));
+  scheduler.Done(1, 5 * MB);
+  ASSERT_EQ(2u, launched.size());
+  ASSERT_EQ(2u, launched[1][0].mFid);
+  scheduler.Done(1, 100 * MB);
+  ASSERT_EQ(1u, launched[2][0].mFid);
+  scheduler.Done(1, 10 * MB);
+  // The 40 small files use two slots
+  ASSERT_EQ(DrainScheduler::sMaxBatchFiles, launched[3].size());
+  scheduler.Done(1, 0);
+  ASSERT_EQ(40 - DrainScheduler::sMaxBatchFiles, launched[4].size());
+  ASSERT_EQ(0u, scheduler.GetQueued(1));
+  scheduler.Done(1, 0);
+  ASSERT_EQ(5u, launched.size());
+  ASSERT_EQ(0u, scheduler.GetRunning(1));
+}
+
+//------------------------------------------------------------------------------
+// A node over its budget is skipped while the others go on
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, Budgets)
+{
+  const uint64_t MB = 1000 * 1000;
+  DrainScheduler scheduler(true);
+  DrainScheduler::Budget budget;
+  budget.mNodeRate = 100 * MB;
+  scheduler.SetBudget("default", budget);
+  std::map<eos::common::FileSystem::fsid_t, int> launched;
+
+  for (eos::common::FileSystem::fsid_t fsid : {
+         1, 2, 3
+       }) {
+    // File systems 1 and 2 share the same node
+    scheduler.Register(fsid, MakeInfo((fsid == 3) ? "node2" : "node1",
+                                      "default.0", 10),
+    [&launched, fsid](DrainScheduler::Batch && batch) {
+      ++launched[fsid];
+    });
+  }
+
+  for (eos::common::FileSystem::fsid_t fsid : {
+         1, 2, 3
+       }) {
+    std::vector<DrainScheduler::Candidate> candidates;
+
+    for (uint64_t fid = 0; fid < 10; ++fid) {
+      candidates.push_back(MakeCandidate(fsid * 100 + fid, 150 * MB));
+    }
+
+    scheduler.Submit(fsid, std::move(candidates));
+  }
+
+  // The 2s burst of node1 is used up by two files, node2 got two as well
+  ASSERT_EQ(2, launched[1] + launched[2]);
+  ASSERT_EQ(2, launched[3]);
+  // Nothing more until the budget refilled
+  scheduler.Dispatch();
+  ASSERT_EQ(2, launched[1] + launched[2]);
+  scheduler.GetClock().advance(std::chrono::seconds(2));
+  scheduler.Dispatch();
+  ASSERT_EQ(3, launched[1] + launched[2]);
+  ASSERT_EQ(3, launched[3]);
+  // Without budget everything up to the slots is dispatched
+  scheduler.SetBudget("default", DrainScheduler::Budget());
+  scheduler.Dispatch();
+  ASSERT_EQ(10, launched[1]);
+  ASSERT_EQ(10, launched[2]);
+  ASSERT_EQ(10, launched[3]);
+}
+
+//------------------------------------------------------------------------------
+// Drain rate and ETA are computed from the completed transfers
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, RateAndEta)
+{
+  DrainScheduler scheduler(true);
+  scheduler.Register(1, MakeInfo("node1", "default.0", 10),
+  [](DrainScheduler::Batch && batch) {});
+  ASSERT_EQ(-1, scheduler.GetEta(1, 1000));
+  scheduler.Done(1, 1000);
+  scheduler.GetClock().advance(std::chrono::seconds(10));
+  ASSERT_DOUBLE_EQ(100.0, scheduler.GetRate(1));
+  ASSERT_EQ(50, scheduler.GetEta(1, 5000));
+  // The rate adapts to the new throughput over time
+  scheduler.Done(1, 2000);
+  scheduler.GetClock().advance(std::chrono::seconds(10));
+  const double rate = scheduler.GetRate(1);
+  ASSERT_GT(rate, 100.0);
+  ASSERT_LT(rate, 200.0);
+  scheduler.Unregister(1);
+  ASSERT_EQ(0.0, scheduler.GetRate(1));
+}
+
+//------------------------------------------------------------------------------
+// Only the waiter of the file system whose batch completed is woken up
+//------------------------------------------------------------------------------
+TEST(DrainScheduler, WaitForEvent)
+{
+  using namespace std::chrono;
+  DrainScheduler scheduler(true);
+
+  for (DrainScheduler::fsid_t fsid : {
+         1, 2
+       }) {
+    scheduler.Register(fsid, MakeInfo("node1", "default.0", 10),
+    [](DrainScheduler::Batch && batch) {});
+  }
+
+  // Completions of other file systems are not events for this one
+  scheduler.Done(1, 0);
+  ASSERT_EQ(1u, scheduler.WaitForEvent(1, 0, milliseconds(0)));
+  ASSERT_EQ(0u, scheduler.WaitForEvent(2, 0, milliseconds(10)));
+  auto waiter = std::async(std::launch::async, [&]() {
+    return scheduler.WaitForEvent(2, 0, seconds(60));
+  });
+  scheduler.Done(1, 0);
+  ASSERT_EQ(std::future_status::timeout, waiter.wait_for(milliseconds(100)));
+  scheduler.Done(2, 0);
+  ASSERT_EQ(std::future_status::ready, waiter.wait_for(seconds(10)));
+  ASSERT_EQ(1u, waiter.get());
+  // Unregistering wakes up the waiter
+  waiter = std::async(std::launch::async, [&]() {
+    return scheduler.WaitForEvent(2, 1, seconds(60));
+  });
+  ASSERT_EQ(std::future_status::timeout, waiter.wait_for(milliseconds(100)));
+  scheduler.Unregister(2);
+  ASSERT_EQ(std::future_status::ready, waiter.wait_for(seconds(10)));
+  ASSERT_EQ(1u, waiter.get());
+  ASSERT_EQ(0u, scheduler.WaitForEvent(2, 0, milliseconds(0)));
+}
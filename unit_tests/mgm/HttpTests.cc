@@ -25,6 +25,9 @@
 #define IN_TEST_HARNESS
 #include "mgm/http/HttpServer.hh"
 #undef IN_TEST_HARNESS
+#include "mgm/http/XmlBuffer.hh"
+#include "mgm/http/s3/S3Store.hh"
+#include <cstring>
 
 //------------------------------------------------------------------------------
 // Test clientDN formatting according to different standards
@@ -41,3 +44,56 @@ TEST(Http, FormatClientDN)
     "CN=Herve Rousseau,CN=660542,CN=hroussea,OU=Users,OU=Organic Units,DC=cern,DC=ch";
   ASSERT_TRUE(ref == http.ProcessClientDN(new_cnd));
 }
+
+//------------------------------------------------------------------------------
+// Test XML elements written directly into a buffer
+//------------------------------------------------------------------------------
+TEST(Http, XmlBuffer)
+{
+  eos::mgm::XmlBuffer xml(64);
+  xml.Open("d:response").Element("d:href", "/eos/a&b/<c>");
+  xml.Element("d:getetag", "\"0:1'2\"").Element("d:displayname", "");
+  xml.Open("d:resourcetype").Empty("d:collection").Close("d:resourcetype");
+  const size_t pos = xml.Size();
+  xml.Open("d:prop");
+  xml.Truncate(pos);
+  xml.Empty("d:prop").Close("d:response");
+  const std::string expected =
+    "<d:response><d:href>/eos/a&amp;b/&lt;c&gt;</d:href>"
+    "<d:getetag>&quot;0:1&apos;2&quot;</d:getetag><d:displayname/>"
+    "<d:resourcetype><d:collection/></d:resourcetype><d:prop/>"
+    "</d:response>";
+  ASSERT_EQ(expected, xml.GetString());
+  ASSERT_EQ(expected.size(), xml.Size());
+  ASSERT_EQ(expected, xml.Take());
+}
+
+//------------------------------------------------------------------------------
+// Test the S3 bucket listing entries built from the stat information match
+// the ones previously built from the namespace metadata
+//------------------------------------------------------------------------------
+TEST(Http, S3ListEntry)
+{
+  struct stat buf;
+  memset(&buf, 0, sizeof(buf));
+  buf.st_mode = S_IFREG | 0644;
+  buf.st_size = 1234;
+  buf.st_mtim.tv_sec = 1700000000;
+  eos::mgm::XmlBuffer xml(64);
+  eos::mgm::S3Store::AppendContents(xml, "dir/file.dat", buf, "a1b2c3d4");
+  ASSERT_EQ("<Contents><Key>dir/file.dat</Key>"
+            "<LastModified>2023-11-14T22:13:20Z</LastModified>"
+            "<ETag>\"a1b2c3d4\"</ETag><Size>1234</Size>"
+            "<StorageClass>STANDARD</StorageClass>"
+            "<Owner><ID>root</ID><DisplayName>root:root</DisplayName></Owner>"
+            "</Contents>", xml.Take());
+  buf.st_mode = S_IFDIR | 0755;
+  eos::mgm::XmlBuffer dir_xml(64);
+  eos::mgm::S3Store::AppendContents(dir_xml, "dir/a&b", buf, "ignored");
+  ASSERT_EQ("<Contents><Key>dir/a&amp;b/</Key>"
+            "<LastModified>2023-11-14T22:13:20Z</LastModified>"
+            "<ETag></ETag><Size>0</Size>"
+            "<StorageClass>STANDARD</StorageClass>"
+            "<Owner><ID>root</ID><DisplayName>root:root</DisplayName></Owner>"
+            "</Contents>", dir_xml.Take());
+}
@@ -261,3 +261,36 @@ TEST(IostatPeriods, GetStatStampZeroAdd)
   }
 }
 
+
+TEST_F(IostatTest, MergePartial)
+{
+  time_t now = time(nullptr);
+  Iostat::IostatPartial partial;
+  ASSERT_TRUE(partial.mEmpty);
+  partial.Add("bytes_read", 11, 12, 100, now - 1, now, now);
+  partial.Add("bytes_read", 11, 13, 50, now - 1, now, now);
+  partial.mAppIOrb["eoscp"].Add(150, now - 1, now, now);
+  ASSERT_FALSE(partial.mEmpty);
+  ASSERT_EQ(2u, partial.mQdb.size());
+  iostat.MergePartial(partial);
+  ASSERT_TRUE(partial.mEmpty);
+  ASSERT_TRUE(partial.mUid.empty());
+  partial.Add("bytes_read", 11, 12, 25, now - 1, now, now);
+  iostat.MergePartial(partial);
+  ASSERT_EQ(175, iostat.GetTotalStatForTag("bytes_read"));
+  ASSERT_EQ(175, iostat.IostatUid["bytes_read"][11]);
+  ASSERT_EQ(125, iostat.IostatGid["bytes_read"][12]);
+  ASSERT_EQ(175, iostat.GetPeriodStatForTag("bytes_read", LAST_1MIN));
+  ASSERT_EQ(150, iostat.IostatPeriodsAppIOrb["eoscp"].GetSumForPeriod(LAST_DAY));
+}
+
+TEST(IostatPeriods, Merge)
+{
+  time_t now = time(nullptr);
+  IostatPeriods first, second;
+  first.Add(10, now - 5, now, now);
+  second.Add(20, now - 120, now - 60, now);
+  first.Merge(second);
+  ASSERT_EQ(30, first.GetSumForPeriod(LAST_HOUR));
+  ASSERT_EQ(10, first.GetSumForPeriod(LAST_1MIN));
+}
@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+// File: NsCacheWarmUpTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/NsCacheWarmUp.hh"
+
+using eos::mgm::NsCacheWarmUp;
+
+//------------------------------------------------------------------------------
+// Hot ids survive the round trip in recency order
+//------------------------------------------------------------------------------
+TEST(NsCacheWarmUp, EncodeDecodeIds)
+{
+  std::vector<uint64_t> ids {1234567, 1234568, 12, 0, UINT64_MAX, 1, 99999999999};
+  const std::string data = NsCacheWarmUp::EncodeIds(ids);
+  std::vector<uint64_t> decoded;
+  ASSERT_TRUE(NsCacheWarmUp::DecodeIds(data, decoded));
+  ASSERT_EQ(ids, decoded);
+  // Close ids take a single byte
+  ASSERT_EQ(3u, NsCacheWarmUp::EncodeIds({10, 11, 9}).size());
+  ASSERT_TRUE(NsCacheWarmUp::DecodeIds("", decoded));
+  ASSERT_TRUE(decoded.empty());
+  // Truncated varint
+  ASSERT_FALSE(NsCacheWarmUp::DecodeIds(data.substr(0, 3), decoded));
+  ASSERT_FALSE(NsCacheWarmUp::DecodeIds(std::string(11, '\xff'), decoded));
+}
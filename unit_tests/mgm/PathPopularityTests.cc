@@ -0,0 +1,82 @@
+//------------------------------------------------------------------------------
+// File: PathPopularityTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/PathPopularity.hh"
+
+using eos::mgm::PathPopularity;
+
+TEST(PathPopularity, Prefixes)
+{
+  PathPopularity pop;
+  pop.Add("/eos/a/f1", 10);
+  pop.Add("/eos/a/f2", 20);
+  pop.Add("//eos/b/f3", 5);
+  auto top = pop.GetTopByCount(10);
+  ASSERT_EQ(4u, top.size());
+  ASSERT_EQ("/", top[0].path);
+  ASSERT_EQ(3u, top[0].nread);
+  ASSERT_EQ(35u, top[0].rb);
+  ASSERT_EQ("/eos/", top[1].path);
+  ASSERT_EQ(3u, top[1].nread);
+  ASSERT_EQ("/eos/a/", top[2].path);
+  ASSERT_EQ(2u, top[2].nread);
+  ASSERT_EQ(30u, top[2].rb);
+  ASSERT_EQ("/eos/b/", top[3].path);
+  top = pop.GetTopByBytes(3);
+  ASSERT_EQ(3u, top.size());
+  ASSERT_EQ("/", top[0].path);
+  ASSERT_EQ("/eos/", top[1].path);
+  ASSERT_EQ("/eos/a/", top[2].path);
+  pop.Clear();
+  ASSERT_TRUE(pop.GetTopByCount(10).empty());
+  ASSERT_EQ(0u, pop.GetNumNames());
+}
+
+TEST(PathPopularity, BoundedMemory)
+{
+  PathPopularity pop(8);
+
+  for (int i = 0; i < 100000; ++i) {
+    pop.Add("/eos/hot/file", 1);
+    pop.Add("/eos/cold/" + std::to_string(i) + "/file", 1);
+  }
+
+  ASSERT_LE(pop.GetNumNames(), 4 * 2 * PathPopularity::sMaxDepth * 8);
+  auto top = pop.GetTopByCount(3);
+  ASSERT_EQ(3u, top.size());
+  ASSERT_EQ("/", top[0].path);
+  ASSERT_EQ(200000u, top[0].nread);
+  ASSERT_EQ("/eos/", top[1].path);
+  ASSERT_EQ("/eos/cold/", top[2].path);
+  top = pop.GetTopByCount(10);
+  bool found = false;
+
+  for (const auto& entry : top) {
+    if (entry.path == "/eos/hot/") {
+      found = true;
+      ASSERT_GE(entry.nread, 100000u);
+    }
+  }
+
+  ASSERT_TRUE(found);
+}
@@ -0,0 +1,167 @@
+//------------------------------------------------------------------------------
+// File: PolicyIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/PolicyIndex.hh"
+#include <map>
+#include <set>
+
+using eos::mgm::PolicyIndex;
+
+//------------------------------------------------------------------------------
+// Only the policy attributes are indexed
+//------------------------------------------------------------------------------
+TEST(PolicyIndex, Prefixes)
+{
+  ASSERT_TRUE(PolicyIndex::IsIndexed("sys.lru.expire.match"));
+  ASSERT_TRUE(PolicyIndex::IsIndexed("sys.attr.link"));
+  ASSERT_FALSE(PolicyIndex::IsIndexed("sys.lru"));
+  ASSERT_FALSE(PolicyIndex::IsIndexed("sys.acl"));
+  ASSERT_FALSE(PolicyIndex::IsIndexed("user.lru.expire.match"));
+  ASSERT_EQ("eos-policy-index:sys.lru.", PolicyIndex::GetKey("sys.lru."));
+  eos::IContainerMD::XAttrMap attrs {
+    {"sys.acl", "u:1:rwx"}, {"sys.forced.space", "default"},
+    {"sys.lrw", "1"}, {"user.lru.expire.match", "*:1d"}
+  };
+  ASSERT_FALSE(PolicyIndex::HasPrefix(attrs, "sys.lru."));
+  attrs["sys.lru.lowwatermark"] = "70";
+  ASSERT_TRUE(PolicyIndex::HasPrefix(attrs, "sys.lru."));
+  ASSERT_FALSE(PolicyIndex::HasPrefix(attrs, "sys.attr.link"));
+  ASSERT_FALSE(PolicyIndex::HasPrefix({}, "sys.lru."));
+}
+
+//------------------------------------------------------------------------------
+//! In-memory replacement of the metadata flusher holding the index sets
+//------------------------------------------------------------------------------
+struct FakeIndexSink {
+  std::map<std::string, std::set<std::string>> mSets;
+  size_t mNumRequests {0};
+
+  void sadd(const std::string& key, const std::string& member)
+  {
+    ++mNumRequests;
+    mSets[key].insert(member);
+  }
+
+  void srem(const std::string& key, const std::string& member)
+  {
+    ++mNumRequests;
+    mSets[key].erase(member);
+  }
+
+  bool Contains(const std::string& prefix, const std::string& member)
+  {
+    return (mSets[PolicyIndex::GetKey(prefix)].count(member) != 0);
+  }
+};
+
+//------------------------------------------------------------------------------
+// Add only indexes the prefixes present and never removes anything
+//------------------------------------------------------------------------------
+TEST(PolicyIndex, Add)
+{
+  FakeIndexSink sink;
+  PolicyIndex::ApplyAdd(sink, 10, {{"sys.acl", "u:1:rwx"}});
+  ASSERT_EQ(sink.mNumRequests, 0u);
+  PolicyIndex::ApplyAdd(sink, 11, {{"sys.lru.expire.match", "*:1d"}});
+  PolicyIndex::ApplyAdd(sink, 12, {{"sys.attr.link", "/eos/policy/"}});
+  ASSERT_TRUE(sink.Contains("sys.lru.", "11"));
+  ASSERT_FALSE(sink.Contains("sys.attr.link", "11"));
+  ASSERT_TRUE(sink.Contains("sys.attr.link", "12"));
+  ASSERT_FALSE(sink.Contains("sys.lru.", "12"));
+}
+
+//------------------------------------------------------------------------------
+// Update follows the attributes of the container for the changed key only
+//------------------------------------------------------------------------------
+TEST(PolicyIndex, Update)
+{
+  FakeIndexSink sink;
+  eos::IContainerMD::XAttrMap attrs {{"sys.lru.lowwatermark", "70"}};
+  PolicyIndex::ApplyUpdate(sink, 20, attrs, "sys.lru.lowwatermark");
+  ASSERT_TRUE(sink.Contains("sys.lru.", "20"));
+  // Unrelated attributes do not cost any request
+  size_t num_requests = sink.mNumRequests;
+  PolicyIndex::ApplyUpdate(sink, 20, attrs, "sys.acl");
+  ASSERT_EQ(sink.mNumRequests, num_requests);
+  // A second lru attribute keeps the entry when the first one is removed
+  attrs["sys.lru.highwatermark"] = "90";
+  attrs.erase("sys.lru.lowwatermark");
+  PolicyIndex::ApplyUpdate(sink, 20, attrs, "sys.lru.lowwatermark");
+  ASSERT_TRUE(sink.Contains("sys.lru.", "20"));
+  attrs.clear();
+  PolicyIndex::ApplyUpdate(sink, 20, attrs, "sys.lru.highwatermark");
+  ASSERT_FALSE(sink.Contains("sys.lru.", "20"));
+  // Full refresh covers all the prefixes
+  attrs["sys.attr.link"] = "/eos/policy/";
+  PolicyIndex::ApplyUpdate(sink, 20, attrs);
+  ASSERT_TRUE(sink.Contains("sys.attr.link", "20"));
+  ASSERT_FALSE(sink.Contains("sys.lru.", "20"));
+}
+
+//------------------------------------------------------------------------------
+// Remove drops the entries of the given container only
+//------------------------------------------------------------------------------
+TEST(PolicyIndex, Remove)
+{
+  FakeIndexSink sink;
+  eos::IContainerMD::XAttrMap attrs {
+    {"sys.lru.expire.match", "*:1d"}, {"sys.attr.link", "/eos/policy/"}
+  };
+  PolicyIndex::ApplyAdd(sink, 30, attrs);
+  PolicyIndex::ApplyAdd(sink, 31, attrs);
+  // Only the prefixes present in the attributes are touched
+  size_t num_requests = sink.mNumRequests;
+  PolicyIndex::ApplyRemove(sink, 40, &attrs);
+  ASSERT_EQ(sink.mNumRequests, num_requests + PolicyIndex::sPrefixes.size());
+  PolicyIndex::ApplyRemove(sink, 30, &attrs);
+  ASSERT_FALSE(sink.Contains("sys.lru.", "30"));
+  ASSERT_FALSE(sink.Contains("sys.attr.link", "30"));
+  ASSERT_TRUE(sink.Contains("sys.lru.", "31"));
+  // Without attributes all the sets are cleaned
+  PolicyIndex::ApplyRemove(sink, 31);
+  ASSERT_FALSE(sink.Contains("sys.lru.", "31"));
+  ASSERT_FALSE(sink.Contains("sys.attr.link", "31"));
+}
+
+//------------------------------------------------------------------------------
+// The LRU drops the entries of containers which are gone or no longer carry
+// any policy attribute
+//------------------------------------------------------------------------------
+TEST(PolicyIndex, DropStaleEntry)
+{
+  FakeIndexSink sink;
+  eos::IContainerMD::XAttrMap attrs {{"sys.lru.expire.match", "*:1d"}};
+  PolicyIndex::ApplyAdd(sink, 50, attrs);
+  PolicyIndex::ApplyAdd(sink, 51, attrs);
+  PolicyIndex::ApplyAdd(sink, 52, {{"sys.attr.link", "/eos/policy/"}});
+  ASSERT_TRUE(PolicyIndex::ApplyCheckEntry(sink, 50, &attrs));
+  ASSERT_TRUE(sink.Contains("sys.lru.", "50"));
+  // Container removed without going through _remdir
+  ASSERT_FALSE(PolicyIndex::ApplyCheckEntry(sink, 51, nullptr));
+  ASSERT_FALSE(sink.Contains("sys.lru.", "51"));
+  // Attribute removed without updating the index
+  eos::IContainerMD::XAttrMap no_policy {{"sys.acl", "u:1:rwx"}};
+  ASSERT_FALSE(PolicyIndex::ApplyCheckEntry(sink, 52, &no_policy));
+  ASSERT_FALSE(sink.Contains("sys.attr.link", "52"));
+  ASSERT_TRUE(sink.Contains("sys.lru.", "50"));
+}
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+// File: ProcResponseStreamTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/proc/ProcResponseStream.hh"
+#include <ostream>
+#include <thread>
+
+using eos::mgm::ProcResponseStream;
+using eos::mgm::ProcResponseStreamBuf;
+
+namespace
+{
+const std::chrono::milliseconds sTimeout {std::chrono::seconds(10)};
+}
+
+TEST(ProcResponseStream, Backpressure)
+{
+  ProcResponseStream channel(16);
+  channel.Open();
+  const size_t total = 100000;
+  size_t max_buffered = 0;
+  std::thread producer([&]() {
+    std::string chunk(10, 'x');
+
+    for (size_t i = 0; i < total / chunk.size(); ++i) {
+      ASSERT_TRUE(channel.Write(chunk.c_str(), chunk.size()));
+    }
+
+    channel.Close();
+  });
+  char buff[7];
+  size_t nread = 0;
+
+  while (!channel.IsFinished()) {
+    nread += channel.Read(buff, sizeof(buff), sTimeout);
+    max_buffered = std::max(max_buffered, channel.GetBufferedSize());
+  }
+
+  producer.join();
+  ASSERT_EQ(total, nread);
+  ASSERT_LE(max_buffered, 16u);
+  // Reading after the end keeps returning 0
+  ASSERT_EQ(0u, channel.Read(buff, sizeof(buff), sTimeout));
+}
+
+TEST(ProcResponseStream, Cancel)
+{
+  ProcResponseStream channel(8);
+  channel.Open();
+  ASSERT_TRUE(channel.Write("01234567", 8));
+  std::thread producer([&]() {
+    // Blocks since the channel is full until cancelled
+    ASSERT_FALSE(channel.Write("89", 2));
+  });
+  channel.Cancel();
+  producer.join();
+  ASSERT_TRUE(channel.IsCancelled());
+  ASSERT_EQ(0u, channel.GetBufferedSize());
+  ASSERT_FALSE(channel.Write("x", 1));
+  char buff[8];
+  ASSERT_EQ(0u, channel.Read(buff, sizeof(buff), sTimeout));
+}
+
+TEST(ProcResponseStream, StreamBuf)
+{
+  ProcResponseStream channel(0);
+  ProcResponseStreamBuf buf(channel);
+  std::ostream out(&buf);
+  channel.Open();
+  const std::string line(1000, 'a');
+
+  for (int i = 0; i < 200; ++i) {
+    out << line << std::endl;
+  }
+
+  out << "end";
+  out.flush();
+  channel.Close();
+  std::string data;
+  char buff[4096];
+
+  while (!channel.IsFinished()) {
+    size_t len = channel.Read(buff, sizeof(buff), sTimeout);
+    data.append(buff, len);
+  }
+
+  ASSERT_EQ(200 * 1001u + 3, data.size());
+  ASSERT_EQ("end", data.substr(data.size() - 3));
+  // Writes fail once the consumer is gone
+  channel.Cancel();
+  out << line;
+  out.flush();
+  ASSERT_TRUE(out.bad());
+}
+
+TEST(ProcResponseStream, PartialRead)
+{
+  ProcResponseStream channel(0);
+  channel.Open();
+  char buff[8];
+  // Nothing produced yet, the read returns once the timeout expires
+  ASSERT_FALSE(channel.HasData());
+  ASSERT_EQ(0u, channel.Read(buff, sizeof(buff),
+                             std::chrono::milliseconds(10)));
+  ASSERT_FALSE(channel.IsFinished());
+  // Available data is returned without waiting to fill the buffer
+  ASSERT_TRUE(channel.Write("abc", 3));
+  ASSERT_TRUE(channel.HasData());
+  ASSERT_EQ(3u, channel.Read(buff, sizeof(buff), sTimeout));
+  ASSERT_EQ("abc", std::string(buff, 3));
+  channel.Close();
+  ASSERT_TRUE(channel.HasData());
+  ASSERT_TRUE(channel.IsFinished());
+  ASSERT_EQ(0u, channel.Read(buff, sizeof(buff), sTimeout));
+}
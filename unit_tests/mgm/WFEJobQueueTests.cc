@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+// File: WFEJobQueueTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mgm/wfe/WFEJobQueue.hh"
+#include <chrono>
+#include <thread>
+
+using eos::mgm::LocalWFEJobStore;
+using eos::mgm::WFEJobQueue;
+using eos::mgm::WFEJobRecord;
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Build job record
+//------------------------------------------------------------------------------
+WFEJobRecord
+MakeRecord(uint64_t fid, const std::string& workflow, time_t ctime = 1000)
+{
+  WFEJobRecord rec;
+  rec.mFid = fid;
+  rec.mEvent = "closew";
+  rec.mWorkflow = workflow;
+  rec.mAction = "bash:shell:" + workflow + " <eos::wfe::path>";
+  rec.mVid = "uid=1000,gid=1000";
+  rec.mCtime = ctime;
+  rec.mTime = ctime;
+  return rec;
+}
+
+//------------------------------------------------------------------------------
+// Wait until the predicate is true or the timeout expires
+//------------------------------------------------------------------------------
+template<typename Pred>
+bool
+WaitFor(Pred pred, std::chrono::milliseconds timeout =
+          std::chrono::milliseconds(5000))
+{
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+
+  while (!pred()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  return true;
+}
+}
+
+//------------------------------------------------------------------------------
+// Serialization round trip with separators in the fields
+//------------------------------------------------------------------------------
+TEST(WFEJobQueue, RecordSerialization)
+{
+  WFEJobRecord rec = MakeRecord(0x1234, "default");
+  rec.mErrorMessage = "msg with : and 12:colons";
+  rec.mLog = "";
+  rec.mRetry = 3;
+  rec.mRetc = -5;
+  WFEJobRecord out;
+  ASSERT_TRUE(out.Deserialize(rec.Serialize()));
+  ASSERT_EQ(rec.Serialize(), out.Serialize());
+  ASSERT_EQ(rec.GetKey(), out.GetKey());
+  ASSERT_EQ("1000:0000000000001234:closew:default", rec.GetKey());
+  ASSERT_EQ(3, out.mRetry);
+  ASSERT_EQ(-5, out.mRetc);
+  ASSERT_FALSE(out.Deserialize("garbage"));
+  ASSERT_FALSE(out.Deserialize(rec.Serialize().substr(0, 20)));
+  // Key does not change across retries
+  rec.mTime += 60;
+  ++rec.mRetry;
+  ASSERT_EQ(out.GetKey(), rec.GetKey());
+}
+
+//------------------------------------------------------------------------------
+// Jobs are run and removed from the store once done
+//------------------------------------------------------------------------------
+TEST(WFEJobQueue, DispatchAndDone)
+{
+  auto* store = new LocalWFEJobStore();
+  std::atomic<int> count {0};
+  WFEJobQueue* pqueue = nullptr;
+  WFEJobQueue queue(std::unique_ptr<LocalWFEJobStore>(store),
+  [&](const WFEJobRecord & rec) {
+    ++count;
+    pqueue->Done(rec.GetKey());
+  }, 4);
+  pqueue = &queue;
+
+  for (uint64_t fid = 1; fid <= 100; ++fid) {
+    ASSERT_TRUE(queue.Push(MakeRecord(fid, "default")));
+  }
+
+  // Duplicates are ignored
+  ASSERT_TRUE(queue.Push(MakeRecord(1, "default")));
+  std::map<std::string, std::string> pending;
+  ASSERT_TRUE(store->GetPending(pending));
+  ASSERT_EQ(100u, pending.size());
+  ASSERT_TRUE(queue.Activate());
+  ASSERT_TRUE(WaitFor([&]() {
+    return queue.GetNumPending() == 0;
+  }));
+  ASSERT_EQ(100, count.load());
+  ASSERT_TRUE(store->GetPending(pending));
+  ASSERT_TRUE(pending.empty());
+}
+
+//------------------------------------------------------------------------------
+// Retried jobs wait for their due time, failed ones are kept apart
+//------------------------------------------------------------------------------
+TEST(WFEJobQueue, RetryAndFail)
+{
+  auto* store = new LocalWFEJobStore();
+  std::atomic<int> count {0};
+  WFEJobQueue* pqueue = nullptr;
+  WFEJobQueue queue(std::unique_ptr<LocalWFEJobStore>(store),
+  [&](const WFEJobRecord & rec) {
+    ++count;
+    WFEJobRecord next = rec;
+
+    if (rec.mRetry < 1) {
+      ++next.mRetry;
+      next.mTime = time(nullptr) + 1;
+      pqueue->Retry(next);
+    } else {
+      next.mRetc = 5;
+      next.mLog = "failed";
+      pqueue->Fail(next);
+    }
+  }, 2);
+  pqueue = &queue;
+  ASSERT_TRUE(queue.Activate());
+  const time_t start = time(nullptr);
+  ASSERT_TRUE(queue.Push(MakeRecord(1, "default", start)));
+  ASSERT_TRUE(WaitFor([&]() {
+    return count.load() == 1;
+  }));
+  ASSERT_EQ(1u, queue.GetNumPending());
+  ASSERT_TRUE(WaitFor([&]() {
+    return queue.GetNumPending() == 0;
+  }));
+  ASSERT_EQ(2, count.load());
+  ASSERT_GE(time(nullptr), start + 1);
+  std::map<std::string, std::string> failed;
+  ASSERT_TRUE(store->GetFailed(failed));
+  ASSERT_EQ(1u, failed.size());
+  WFEJobRecord rec;
+  ASSERT_TRUE(rec.Deserialize(failed.begin()->second));
+  ASSERT_EQ(5, rec.mRetc);
+  ASSERT_EQ(1, rec.mRetry);
+  ASSERT_EQ(0u, queue.PurgeFailed(rec.mTime));
+  ASSERT_EQ(1u, queue.PurgeFailed(rec.mTime + 1));
+  ASSERT_TRUE(store->GetFailed(failed));
+  ASSERT_TRUE(failed.empty());
+}
+
+//------------------------------------------------------------------------------
+// Global and per workflow limits of the running jobs
+//------------------------------------------------------------------------------
+TEST(WFEJobQueue, Limits)
+{
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool release = false;
+  std::atomic<int> count {0};
+  WFEJobQueue* pqueue = nullptr;
+  WFEJobQueue queue(std::unique_ptr<LocalWFEJobStore>(new LocalWFEJobStore()),
+  [&](const WFEJobRecord & rec) {
+    ++count;
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&]() {
+      return release;
+    });
+    pqueue->Done(rec.GetKey());
+  }, 3);
+  pqueue = &queue;
+  queue.SetWorkflowLimit("slow", 1);
+
+  for (uint64_t fid = 1; fid <= 10; ++fid) {
+    ASSERT_TRUE(queue.Push(MakeRecord(fid, "slow")));
+    ASSERT_TRUE(queue.Push(MakeRecord(100 + fid, "fast")));
+  }
+
+  ASSERT_TRUE(queue.Activate());
+  ASSERT_TRUE(WaitFor([&]() {
+    return queue.GetNumRunning() == 3;
+  }));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  ASSERT_EQ(3u, queue.GetNumRunning());
+  ASSERT_EQ(1u, queue.GetNumRunning("slow"));
+  ASSERT_EQ(2u, queue.GetNumRunning("fast"));
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  ASSERT_TRUE(WaitFor([&]() {
+    return queue.GetNumPending() == 0;
+  }));
+  ASSERT_EQ(20, count.load());
+}
+
+//------------------------------------------------------------------------------
+// Unfinished jobs are run again after a backoff and survive a restart of the
+// queue
+//------------------------------------------------------------------------------
+TEST(WFEJobQueue, Recovery)
+{
+  auto* store = new LocalWFEJobStore();
+  std::unique_ptr<LocalWFEJobStore> owned(store);
+
+  for (uint64_t fid = 1; fid <= 5; ++fid) {
+    WFEJobRecord rec = MakeRecord(fid, "default");
+    ASSERT_TRUE(store->PutPending(rec.GetKey(), rec.Serialize()));
+  }
+
+  ASSERT_TRUE(store->PutPending("bad", "garbage"));
+  std::atomic<int> count {0};
+  WFEJobQueue* pqueue = nullptr;
+  WFEJobQueue queue(std::move(owned), [&](const WFEJobRecord & rec) {
+    // Only the first job is finished, the others are left pending
+    if (++count == 1) {
+      pqueue->Done(rec.GetKey());
+    }
+  });
+  pqueue = &queue;
+  queue.SetUnfinishedBackoff(std::chrono::seconds(1));
+  ASSERT_TRUE(queue.Activate());
+  ASSERT_TRUE(WaitFor([&]() {
+    return count.load() == 5;
+  }));
+  ASSERT_EQ(4u, queue.GetNumPending());
+  // Unfinished jobs run again once the backoff expired
+  ASSERT_TRUE(WaitFor([&]() {
+    return count.load() == 9;
+  }));
+  ASSERT_EQ(4u, queue.GetNumPending());
+  queue.Deactivate();
+  std::map<std::string, std::string> pending;
+  ASSERT_TRUE(store->GetPending(pending));
+  // Four unfinished jobs and the malformed entry
+  ASSERT_EQ(5u, pending.size());
+  // Unfinished jobs run again after re-activation
+  const int before = count.load();
+  ASSERT_TRUE(queue.Activate());
+  ASSERT_TRUE(WaitFor([&]() {
+    return count.load() >= before + 4;
+  }));
+}
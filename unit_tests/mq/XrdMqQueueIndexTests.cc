@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// File: XrdMqQueueIndexTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqMpscQueue.hh"
+#include "mq/XrdMqQueueIndex.hh"
+#include <algorithm>
+#include <thread>
+
+//------------------------------------------------------------------------------
+// Wildcard matching
+//------------------------------------------------------------------------------
+TEST(XrdMqQueueIndex, WildcardMatch)
+{
+  using Index = XrdMqQueueIndex<int>;
+  ASSERT_TRUE(Index::WildcardMatch("/eos/fst1:1095/fst", "/eos/*/fst"));
+  ASSERT_TRUE(Index::WildcardMatch("/eos/fst1:1095/fst", "/eos/*"));
+  ASSERT_TRUE(Index::WildcardMatch("/eos/fst1:1095/fst", "*"));
+  ASSERT_TRUE(Index::WildcardMatch("/eos/a/b/fst", "/eos/*/fst"));
+  ASSERT_TRUE(Index::WildcardMatch("/eos/fst/fst", "/eos/*fst*/fst"));
+  ASSERT_FALSE(Index::WildcardMatch("/eos/fst1:1095/fst", "/eos/*/mgm"));
+  ASSERT_FALSE(Index::WildcardMatch("/eos/fst1:1095/fst2", "/eos/*/fst"));
+  ASSERT_FALSE(Index::WildcardMatch("/eos/fst", "/eos/*/fst"));
+}
+
+//------------------------------------------------------------------------------
+// Exact and wildcard lookups, also after subscribers left
+//------------------------------------------------------------------------------
+TEST(XrdMqQueueIndex, Match)
+{
+  XrdMqQueueIndex<int> index;
+  std::vector<int> values {0, 1, 2, 3};
+  index.Insert("/eos/fst1.cern.ch:1095/fst", &values[0]);
+  index.Insert("/eos/fst2.cern.ch:1095/fst", &values[1]);
+  index.Insert("/eos/mgm.cern.ch:1094/mgm", &values[2]);
+  index.Insert("/eos/fst1.cern.ch:1095/fst/sub", &values[3]);
+  ASSERT_EQ(4u, index.Size());
+  std::vector<int*> out;
+  index.Match("/eos/mgm.cern.ch:1094/mgm", out);
+  ASSERT_EQ(std::vector<int*> {&values[2]}, out);
+  out.clear();
+  index.Match("/eos/mgm.cern.ch:1094", out);
+  ASSERT_TRUE(out.empty());
+
+  // The second call is answered from the cache
+  for (int i = 0; i < 2; ++i) {
+    out.clear();
+    index.Match("/eos/*/fst", out);
+    std::sort(out.begin(), out.end());
+    ASSERT_EQ((std::vector<int*> {&values[0], &values[1]}), out);
+  }
+
+  out.clear();
+  index.Match("/eos/fst1*", out);
+  ASSERT_EQ(2u, out.size());
+  out.clear();
+  index.Match("/eos/mgm*/fst", out);
+  ASSERT_TRUE(out.empty());
+  index.Erase("/eos/fst2.cern.ch:1095/fst");
+  index.Erase("/eos/fst1.cern.ch:1095/fst/sub");
+  index.Erase("/eos/unknown");
+  ASSERT_EQ(2u, index.Size());
+  out.clear();
+  index.Match("/eos/*/fst", out);
+  ASSERT_EQ(std::vector<int*> {&values[0]}, out);
+  out.clear();
+  index.Match("*", out);
+  ASSERT_EQ(2u, out.size());
+  ASSERT_EQ(nullptr, index.Find("/eos/fst2.cern.ch:1095/fst"));
+  ASSERT_EQ(&values[0], index.Find("/eos/fst1.cern.ch:1095/fst"));
+}
+
+//------------------------------------------------------------------------------
+// Concurrent producers with a single consumer
+//------------------------------------------------------------------------------
+TEST(XrdMqMpscQueue, ConcurrentPush)
+{
+  const int num_producers = 4;
+  const int num_values = 10000;
+  XrdMqMpscQueue<int> queue;
+  std::vector<std::thread> producers;
+
+  for (int p = 0; p < num_producers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < num_values; ++i) {
+        queue.Push(p * num_values + i);
+      }
+    });
+  }
+
+  // Values of every producer come out in the order they were pushed
+  std::vector<int> last(num_producers, -1);
+  int popped = 0;
+
+  while (popped < num_producers * num_values) {
+    int value;
+
+    if (queue.Pop(value)) {
+      const int p = value / num_values;
+      ASSERT_LT(last[p], value % num_values);
+      last[p] = value % num_values;
+      ++popped;
+    }
+  }
+
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  int value;
+  ASSERT_FALSE(queue.Pop(value));
+  ASSERT_EQ(0u, queue.Size());
+}
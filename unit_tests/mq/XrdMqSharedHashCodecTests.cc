@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+// File: XrdMqSharedHashCodecTests.cc
+//------------------------------------------------------------------------------
+
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2023 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+#include "gtest/gtest.h"
+#include "mq/XrdMqSharedHashCodec.hh"
+
+//------------------------------------------------------------------------------
+// Front coded records of several subjects survive the round trip
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, RoundTrip)
+{
+  XrdMqSharedHashCodec codec;
+  codec.NextSubject();
+  codec.AddPair("stat.disk.load", "0.25");
+  codec.AddPair("stat.disk.readratemb", "12");
+  codec.AddDeletion("stat.drainer");
+  codec.AddPair("stat.statfs.bavail", "");
+  codec.NextSubject();
+  codec.NextSubject();
+  codec.AddPair("a", "1");
+  ASSERT_EQ("|0stat.disk.load~0.25|Areadratemb~12|6rainer|5statfs.bavail~%%"
+            "|0a~1", codec.GetOutput());
+  ASSERT_EQ(5u, codec.GetNumRecords());
+  std::vector<std::vector<XrdMqSharedHashCodec::Record>> subjects;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode(codec.GetOutput(), subjects));
+  ASSERT_EQ(3u, subjects.size());
+  ASSERT_EQ(4u, subjects[0].size());
+  ASSERT_EQ("stat.disk.load", subjects[0][0].mKey);
+  ASSERT_EQ("0.25", subjects[0][0].mValue);
+  ASSERT_EQ("stat.disk.readratemb", subjects[0][1].mKey);
+  ASSERT_EQ("12", subjects[0][1].mValue);
+  ASSERT_EQ("stat.drainer", subjects[0][2].mKey);
+  ASSERT_TRUE(subjects[0][2].mDeleted);
+  ASSERT_EQ("stat.statfs.bavail", subjects[0][3].mKey);
+  ASSERT_EQ("", subjects[0][3].mValue);
+  ASSERT_FALSE(subjects[0][3].mDeleted);
+  ASSERT_TRUE(subjects[1].empty());
+  ASSERT_EQ(1u, subjects[2].size());
+  ASSERT_EQ("a", subjects[2][0].mKey);
+}
+
+//------------------------------------------------------------------------------
+// Prefixes longer than what one digit can encode
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, LongPrefix)
+{
+  const std::string prefix(100, 'k');
+  XrdMqSharedHashCodec codec;
+  codec.NextSubject();
+  codec.AddPair(prefix + "1", "v1");
+  codec.AddPair(prefix + "2", "v2");
+  std::vector<std::vector<XrdMqSharedHashCodec::Record>> subjects;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode(codec.GetOutput(), subjects));
+  ASSERT_EQ(1u, subjects.size());
+  ASSERT_EQ(2u, subjects[0].size());
+  ASSERT_EQ(prefix + "2", subjects[0][1].mKey);
+  ASSERT_EQ("v2", subjects[0][1].mValue);
+}
+
+//------------------------------------------------------------------------------
+// Malformed input is rejected
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, Malformed)
+{
+  std::vector<std::vector<XrdMqSharedHashCodec::Record>> subjects;
+  ASSERT_TRUE(XrdMqSharedHashCodec::Decode("", subjects));
+  ASSERT_EQ(1u, subjects.size());
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("key~value", subjects));
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("|", subjects));
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("|3key~value", subjects));
+  ASSERT_FALSE(XrdMqSharedHashCodec::Decode("|0key~v|!x~v", subjects));
+}
+
+//------------------------------------------------------------------------------
+// Sequence ranges and last seen changes
+//------------------------------------------------------------------------------
+TEST(XrdMqSharedHashCodec, Sequences)
+{
+  uint64_t epoch, base, seq;
+  const std::string range = XrdMqSharedHashCodec::EncodeRange(0xfeedbeef12ull,
+                            7, 42);
+  ASSERT_EQ("feedbeef12.7.42", range);
+  ASSERT_TRUE(XrdMqSharedHashCodec::DecodeRange(range, epoch, base, seq));
+  ASSERT_EQ(0xfeedbeef12ull, epoch);
+  ASSERT_EQ(7u, base);
+  ASSERT_EQ(42u, seq);
+  ASSERT_FALSE(XrdMqSharedHashCodec::DecodeRange("1.9.8", epoch, base, seq));
+  ASSERT_FALSE(XrdMqSharedHashCodec::DecodeRange("1.2.3x", epoch, base, seq));
+  ASSERT_FALSE(XrdMqSharedHashCodec::DecodeRange("1.2", epoch, base, seq));
+  ASSERT_TRUE(XrdMqSharedHashCodec::DecodeSince
+              (XrdMqSharedHashCodec::EncodeSince(3, 5), epoch, seq));
+  ASSERT_EQ(3u, epoch);
+  ASSERT_EQ(5u, seq);
+  ASSERT_FALSE(XrdMqSharedHashCodec::DecodeSince("", epoch, seq));
+}
@@ -61,6 +61,7 @@ UnitTestsWithQDBFixture::UnitTestsWithQDBFixture() {
     qdb_passwd = buff.str();
   }
 
+  mHostPort = qdb_hostport;
   mContactDetails = QdbContactDetails(qclient::Members::fromString(qdb_hostport),
     qdb_passwd);
   mFlushGuard.reset(new FlushAllOnConstruction(mContactDetails));
@@ -119,4 +120,18 @@ QdbContactDetails UnitTestsWithQDBFixture::getContactDetails() const {
   return mContactDetails;
 }
 
+//------------------------------------------------------------------------------
+// Configuration of a namespace group backed by the test instance
+//------------------------------------------------------------------------------
+std::map<std::string, std::string>
+UnitTestsWithQDBFixture::getNamespaceConfig() const {
+  return {
+    {"queue_path", "/tmp/eos-unit-tests-with-qdb/"},
+    {"qdb_cluster", mHostPort},
+    {"qdb_flusher_md", "tests_md"},
+    {"qdb_flusher_quota", "tests_quota"},
+    {"qdb_password", mContactDetails.password}
+  };
+}
+
 }
@@ -24,6 +24,7 @@
 
 #include "namespace/ns_quarkdb/QdbContactDetails.hh"
 #include <gtest/gtest.h>
+#include <map>
 #include <memory>
 #include <chrono>
 #include <thread>
@@ -106,9 +107,15 @@ public:
   //----------------------------------------------------------------------------
   QdbContactDetails getContactDetails() const;
 
+  //----------------------------------------------------------------------------
+  //! Configuration of a namespace group backed by the test instance
+  //----------------------------------------------------------------------------
+  std::map<std::string, std::string> getNamespaceConfig() const;
+
 
 private:
   QdbContactDetails mContactDetails;
+  std::string mHostPort;
   std::unique_ptr<FlushAllOnConstruction> mFlushGuard;
 
   std::map<int, std::unique_ptr<mq::MessagingRealm>> mMessagingRealms;
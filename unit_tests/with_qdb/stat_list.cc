@@ -0,0 +1,196 @@
+/************************************************************************
+ * EOS - the CERN Disk Storage System                                   *
+ * Copyright (C) 2024 CERN/Switzerland                                  *
+ *                                                                      *
+ * This program is free software: you can redistribute it and/or modify *
+ * it under the terms of the GNU General Public License as published by *
+ * the Free Software Foundation, either version 3 of the License, or    *
+ * (at your option) any later version.                                  *
+ *                                                                      *
+ * This program is distributed in the hope that it will be useful,      *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of       *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        *
+ * GNU General Public License for more details.                         *
+ *                                                                      *
+ * You should have received a copy of the GNU General Public License    *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.*
+ ************************************************************************/
+
+//------------------------------------------------------------------------------
+//! @brief Tests of the directory listing used by PROPFIND and S3 ListBucket
+//------------------------------------------------------------------------------
+
+#include "unit_tests/with_qdb/TestUtils.hh"
+#include "mgm/XrdMgmOfs.hh"
+#include "mgm/ZMQ.hh"
+#include "namespace/ns_quarkdb/NamespaceGroup.hh"
+#include "namespace/interface/IView.hh"
+#include "namespace/interface/IFileMDSvc.hh"
+#include "namespace/interface/IContainerMDSvc.hh"
+#include "common/LayoutId.hh"
+#include <cstring>
+
+//------------------------------------------------------------------------------
+//! XrdMgmOfs which does not start any of the services
+//------------------------------------------------------------------------------
+class FakeXrdMgmOfs: public XrdMgmOfs
+{
+public:
+  FakeXrdMgmOfs(XrdSysError* lp) : XrdMgmOfs(lp) {}
+
+  ~FakeXrdMgmOfs()
+  {
+    if (mZmqContext) {
+      mZmqContext->close();
+      delete mZmqContext;
+    }
+
+    mDoneOrderlyShutdown = true;
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Fixture providing a gOFS on top of a namespace stored in the test instance
+//------------------------------------------------------------------------------
+class StatListTests : public eos::UnitTestsWithQDBFixture
+{
+protected:
+  void SetUp() override
+  {
+    // Avoid the construction of the HTTP and gRPC services
+    setenv("EOS_MGM_HTTP_PORT", "0", 1);
+    setenv("EOS_MGM_GRPC_PORT", "0", 1);
+    mOfs.reset(new FakeXrdMgmOfs(&mSysError));
+    gOFS = mOfs.get();
+    mNsGroup.reset(new eos::QuarkNamespaceGroup());
+    std::string err;
+    auto config = getNamespaceConfig();
+    ASSERT_TRUE(mNsGroup->initialize(&gOFS->eosViewRWMutex, config, err)) << err;
+    gOFS->eosDirectoryService = mNsGroup->getContainerService();
+    gOFS->eosFileService = mNsGroup->getFileService();
+    gOFS->eosView = mNsGroup->getHierarchicalView();
+    gOFS->eosDirectoryService->configure(config);
+    gOFS->eosFileService->configure(config);
+    gOFS->eosView->configure(config);
+    gOFS->eosView->initialize();
+    mRoot = eos::common::VirtualIdentity::Root();
+  }
+
+  void TearDown() override
+  {
+    if (gOFS) {
+      gOFS->eosView = nullptr;
+      gOFS->eosFileService = nullptr;
+      gOFS->eosDirectoryService = nullptr;
+    }
+
+    mNsGroup.reset();
+    gOFS = nullptr;
+    mOfs.reset();
+  }
+
+  //----------------------------------------------------------------------------
+  //! Create a file with the given size, checksum and owner
+  //----------------------------------------------------------------------------
+  std::shared_ptr<eos::IFileMD> CreateFile(const std::string& path,
+      uint64_t size, uid_t uid, gid_t gid)
+  {
+    std::shared_ptr<eos::IFileMD> fmd = gOFS->eosView->createFile(path, uid,
+                                        gid);
+    fmd->setLayoutId(eos::common::LayoutId::GetId(eos::common::LayoutId::kPlain,
+                     eos::common::LayoutId::kAdler));
+    const char cks[4] = {0x0a, 0x1b, 0x2c, 0x3d};
+    fmd->setChecksum(cks, sizeof(cks));
+    fmd->setSize(size);
+    gOFS->eosView->updateFileStore(fmd.get());
+    return fmd;
+  }
+
+  XrdSysError mSysError {nullptr, "fake"};
+  std::unique_ptr<FakeXrdMgmOfs> mOfs;
+  std::unique_ptr<eos::QuarkNamespaceGroup> mNsGroup;
+  eos::common::VirtualIdentity mRoot;
+};
+
+//------------------------------------------------------------------------------
+// Every entry returned by _stat_list is the same as returned by _stat on the
+// full path, which is what PROPFIND and S3 used to do for each entry
+//------------------------------------------------------------------------------
+TEST_F(StatListTests, SameAsStat)
+{
+  std::shared_ptr<eos::IContainerMD> dir =
+    gOFS->eosView->createContainer("/eos/dir", true);
+  dir->setMode(S_IFDIR | 0755);
+  gOFS->eosView->updateContainerStore(dir.get());
+  CreateFile("/eos/dir/b.dat", 1234, 11, 22);
+  CreateFile("/eos/dir/a.dat", 0, 12, 23);
+  std::shared_ptr<eos::IContainerMD> sub =
+    gOFS->eosView->createContainer("/eos/dir/c", true);
+  sub->setMode(S_IFDIR | 0700);
+  gOFS->eosView->updateContainerStore(sub.get());
+  std::shared_ptr<eos::IFileMD> link =
+    gOFS->eosView->createFile("/eos/dir/d.lnk", 0, 0);
+  link->setLink("/eos/dir/b.dat");
+  gOFS->eosView->updateFileStore(link.get());
+  XrdOucErrInfo error;
+  std::vector<XrdMgmOfs::StatListEntry> entries;
+  ASSERT_EQ(SFS_OK, gOFS->_stat_list("/eos/dir", error, mRoot, entries));
+  ASSERT_EQ(4u, entries.size());
+  const std::vector<std::string> names {"a.dat", "b.dat", "c", "d.lnk"};
+
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const auto& entry = entries[i];
+    ASSERT_EQ(names[i], entry.name);
+    struct stat buf;
+    std::string etag;
+    std::string checksum;
+    ASSERT_EQ(SFS_OK, gOFS->_stat(("/eos/dir/" + entry.name).c_str(), &buf,
+                                  error, mRoot, nullptr, &etag, true, nullptr,
+                                  &checksum));
+    ASSERT_EQ(0, memcmp(&buf, &entry.buf, sizeof(buf))) << entry.name;
+    ASSERT_EQ(etag, entry.etag) << entry.name;
+    ASSERT_EQ(checksum, entry.checksum) << entry.name;
+  }
+
+  ASSERT_EQ("0a1b2c3d", entries[1].checksum);
+  ASSERT_EQ(1234, entries[1].buf.st_size);
+  ASSERT_TRUE(S_ISDIR(entries[2].buf.st_mode));
+  ASSERT_TRUE(entries[2].checksum.empty());
+  // The link is resolved to its target
+  ASSERT_EQ(entries[1].buf.st_ino, entries[3].buf.st_ino);
+}
+
+//------------------------------------------------------------------------------
+// _stat_list applies the same permission checks as opening the directory
+//------------------------------------------------------------------------------
+TEST_F(StatListTests, AccessCheck)
+{
+  std::shared_ptr<eos::IContainerMD> dir =
+    gOFS->eosView->createContainer("/eos/private", true);
+  dir->setMode(S_IFDIR | 0700);
+  dir->setCUid(11);
+  dir->setCGid(22);
+  gOFS->eosView->updateContainerStore(dir.get());
+  CreateFile("/eos/private/file", 1, 11, 22);
+  XrdOucErrInfo error;
+  std::vector<XrdMgmOfs::StatListEntry> entries;
+  eos::common::VirtualIdentity owner = eos::common::VirtualIdentity::Nobody();
+  owner.uid = 11;
+  owner.gid = 22;
+  ASSERT_EQ(SFS_OK, gOFS->_stat_list("/eos/private", error, owner, entries));
+  ASSERT_EQ(1u, entries.size());
+  eos::common::VirtualIdentity other = eos::common::VirtualIdentity::Nobody();
+  other.uid = 12;
+  other.gid = 23;
+  ASSERT_EQ(SFS_ERROR, gOFS->_stat_list("/eos/private", error, other, entries));
+  ASSERT_EQ(EPERM, error.getErrInfo());
+  ASSERT_TRUE(entries.empty());
+  // Granting browse permissions through an ACL
+  dir->setAttribute("sys.acl", "u:12:rx");
+  gOFS->eosView->updateContainerStore(dir.get());
+  ASSERT_EQ(SFS_OK, gOFS->_stat_list("/eos/private", error, other, entries));
+  ASSERT_EQ(1u, entries.size());
+  ASSERT_EQ(SFS_ERROR, gOFS->_stat_list("/eos/missing", error, mRoot,
+                                        entries));
+  ASSERT_EQ(ENOENT, error.getErrInfo());
+}